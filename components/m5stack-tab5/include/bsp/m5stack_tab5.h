@@ -268,6 +268,32 @@ esp_err_t bsp_spiffs_unmount(void);
  */
 esp_err_t bsp_sdcard_init(char *mount_point, size_t max_files);
 
+/**
+ * @brief SD card bus and mount settings for bsp_sdcard_init_with_config()
+ */
+typedef struct {
+    uint32_t max_freq_khz;          /*!< Bus clock, e.g. SDMMC_FREQ_HIGHSPEED */
+    uint8_t bus_width;              /*!< Data lines: 1 or 4 */
+    bool ddr;                       /*!< Double data rate (DDR50) */
+    bool uhs1;                      /*!< 1.8 V UHS-I signalling, where the SDMMC driver supports it */
+    size_t max_files;               /*!< Maximum number of files which can be open at the same time */
+    size_t allocation_unit_size;    /*!< Cluster size used if the card gets formatted */
+    bool format_if_mount_failed;    /*!< Format the card if no file system can be mounted */
+} bsp_sdcard_cfg_t;
+
+/**
+ * @brief Init SD card with explicit bus and mount settings
+ *
+ * @param mount_point Path where partition should be registered (e.g. "/sdcard")
+ * @param cfg Bus and mount settings
+ * @return
+ *    - ESP_OK                  Success
+ *    - ESP_ERR_INVALID_STATE   If the card is already mounted
+ *    - ESP_ERR_NOT_SUPPORTED   If the requested bus mode is not supported by this SDMMC driver
+ *    - Others                  Fail
+ */
+esp_err_t bsp_sdcard_init_with_config(char *mount_point, const bsp_sdcard_cfg_t *cfg);
+
 /**
  * @brief Deinit SD card
  *
@@ -278,6 +304,13 @@ esp_err_t bsp_sdcard_init(char *mount_point, size_t max_files);
  */
 esp_err_t bsp_sdcard_deinit(char *mount_point);
 
+/**
+ * @brief Get SD card handle
+ *
+ * @return Card handle of the mounted card or NULL when not mounted
+ */
+sdmmc_card_t *bsp_sdcard_get_handle(void);
+
 /**************************************************************************************************
  *
  * LCD interface
@@ -345,6 +378,15 @@ lv_display_t *bsp_display_start_with_config(const bsp_display_cfg_t *cfg);
  */
 lv_indev_t *bsp_display_get_input_dev(void);
 
+/**
+ * @brief Get LCD panel handle used by the LVGL display
+ *
+ * @note The panel is created in bsp_display_start() function.
+ *
+ * @return LCD panel handle or NULL when not initialized
+ */
+esp_lcd_panel_handle_t bsp_display_get_panel_handle(void);
+
 /**
  * @brief Take LVGL mutex
  *
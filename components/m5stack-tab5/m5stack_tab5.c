@@ -568,9 +568,23 @@ void bsp_set_touchpad_power_en(bool en)
 static sdmmc_card_t* card;
 
 esp_err_t bsp_sdcard_init(char* mount_point, size_t max_files)
+{
+    const bsp_sdcard_cfg_t cfg = {
+        .max_freq_khz         = SDMMC_FREQ_HIGHSPEED,
+        .bus_width            = SDMMC_BUS_WIDTH,
+        .max_files            = max_files,
+        .allocation_unit_size = 16 * 1024,
+    };
+    return bsp_sdcard_init_with_config(mount_point, &cfg);
+}
+
+esp_err_t bsp_sdcard_init_with_config(char* mount_point, const bsp_sdcard_cfg_t* cfg)
 {
     esp_err_t ret_val = ESP_OK;
 
+    if (NULL == cfg) {
+        return ESP_ERR_INVALID_ARG;
+    }
     if (NULL != card) {
         return ESP_ERR_INVALID_STATE;
     }
@@ -585,7 +599,10 @@ esp_err_t bsp_sdcard_init(char* mount_point, size_t max_files)
     sdmmc_host_t host = SDMMC_HOST_DEFAULT();
     host.slot         = SDMMC_HOST_SLOT_0;  //
     // host.slot = SDMMC_HOST_SLOT_1; //
-    host.max_freq_khz                   = SDMMC_FREQ_HIGHSPEED;
+    host.max_freq_khz                   = cfg->max_freq_khz;
+    if (cfg->ddr) {
+        host.flags |= SDMMC_HOST_FLAG_DDR;
+    }
     sd_pwr_ctrl_ldo_config_t ldo_config = {
         .ldo_chan_id = BSP_LDO_PROBE_SD_CHAN,  // `LDO_VO4` is used as the SDMMC IO power
     };
@@ -606,7 +623,7 @@ esp_err_t bsp_sdcard_init(char* mount_point, size_t max_files)
      *
      */
     sdmmc_slot_config_t slot_config = SDMMC_SLOT_CONFIG_DEFAULT();
-    slot_config.width               = SDMMC_BUS_WIDTH;
+    slot_config.width               = cfg->bus_width;
     slot_config.clk                 = GPIO_SDMMC_CLK;
     slot_config.cmd                 = GPIO_SDMMC_CMD;
     slot_config.d0                  = GPIO_SDMMC_D0;
@@ -615,6 +632,13 @@ esp_err_t bsp_sdcard_init(char* mount_point, size_t max_files)
     slot_config.d3                  = GPIO_SDMMC_D3;
     // slot_config.cd = GPIO_SDMMC_DET;
     // slot_config.flags |= SDMMC_SLOT_FLAG_INTERNAL_PULLUP;
+    if (cfg->uhs1) {
+#ifdef SDMMC_SLOT_FLAG_UHS1
+        slot_config.flags |= SDMMC_SLOT_FLAG_UHS1;
+#else
+        return ESP_ERR_NOT_SUPPORTED;
+#endif
+    }
 
     /**
      * @brief Options for mounting the filesystem.
@@ -622,7 +646,9 @@ esp_err_t bsp_sdcard_init(char* mount_point, size_t max_files)
      *   formatted in case when mounting fails.
      */
     esp_vfs_fat_sdmmc_mount_config_t mount_config = {
-        .format_if_mount_failed = false, .max_files = max_files, .allocation_unit_size = 16 * 1024};
+        .format_if_mount_failed = cfg->format_if_mount_failed,
+        .max_files              = cfg->max_files,
+        .allocation_unit_size   = cfg->allocation_unit_size};
 
     ret_val = esp_vfs_fat_sdmmc_mount(mount_point, &host, &slot_config, &mount_config, &card);
 
@@ -667,6 +693,11 @@ esp_err_t bsp_sdcard_deinit(char* mount_point)
     return ret_val;
 }
 
+sdmmc_card_t* bsp_sdcard_get_handle(void)
+{
+    return card;
+}
+
 //==================================================================================
 // spiffs
 //==================================================================================
@@ -1285,11 +1316,14 @@ esp_err_t bsp_touch_new(const bsp_touch_config_t* config, esp_lcd_touch_handle_t
 }
 
 #if (BSP_CONFIG_NO_GRAPHIC_LIB == 0)
+static esp_lcd_panel_handle_t _panel_handle;
+
 static lv_display_t* bsp_display_lcd_init(const bsp_display_cfg_t* cfg)
 {
     assert(cfg != NULL);
     bsp_lcd_handles_t lcd_panels;
     BSP_ERROR_CHECK_RETURN_NULL(bsp_display_new_with_handles(NULL, &lcd_panels));
+    _panel_handle = lcd_panels.panel;
 
     /* Add LCD screen */
     ESP_LOGD(TAG, "Add LCD screen");
@@ -1407,6 +1441,11 @@ lv_indev_t* bsp_display_get_input_dev(void)
     return disp_indev;
 }
 
+esp_lcd_panel_handle_t bsp_display_get_panel_handle(void)
+{
+    return _panel_handle;
+}
+
 void bsp_display_rotate(lv_display_t* disp, lv_disp_rotation_t rotation)
 {
     lv_disp_set_rotation(disp, rotation);
@@ -0,0 +1,197 @@
+#include "copy_engine.h"
+#include "sd_manager.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/*
+ * copy_engine_copy() against the loop file_ops_copy_file() used before it:
+ * stdio with a 512-byte buffer, one fread/fwrite pair per sector.
+ *
+ *   copy_bench [-s] [-n runs] [size_kb ...]
+ *
+ * Files are made under SD_MOUNT_POINT. Every copy is compared byte for
+ * byte with its source. -s adds an fsync() of the destination to both
+ * timings, which is closer to the card than the host page cache. The
+ * per-MB call counts are what the card pays for on the device, where each
+ * call is a FatFs round trip.
+ */
+
+#define BENCH_DIR        SD_MOUNT_POINT "/.copy_bench"
+#define NAIVE_BUFFER     512
+#define ENGINE_CHUNK     (64 * 1024)
+
+static const uint32_t default_sizes_kb[] = { 0, 1, 64, 100, 1024, 16 * 1024, 64 * 1024 };
+
+static esp_err_t naive_copy(const char *src_full, const char *dst_full) {
+    FILE *src = fopen(src_full, "rb");
+    if (!src) {
+        return ESP_FAIL;
+    }
+    FILE *dst = fopen(dst_full, "wb");
+    if (!dst) {
+        fclose(src);
+        return ESP_FAIL;
+    }
+    uint8_t buffer[NAIVE_BUFFER];
+    size_t bytes_read;
+    while ((bytes_read = fread(buffer, 1, sizeof(buffer), src)) > 0) {
+        if (fwrite(buffer, 1, bytes_read, dst) != bytes_read) {
+            fclose(src);
+            fclose(dst);
+            remove(dst_full);
+            return ESP_FAIL;
+        }
+    }
+    fclose(src);
+    fclose(dst);
+    return ESP_OK;
+}
+
+static bool make_source(const char *path, uint64_t size) {
+    FILE *f = fopen(path, "wb");
+    if (!f) {
+        return false;
+    }
+    uint8_t block[4096];
+    uint32_t seed = (uint32_t)size ^ 0x9E3779B9u;
+    bool ok = true;
+    for (uint64_t done = 0; done < size && ok; done += sizeof(block)) {
+        size_t len = size - done < sizeof(block) ? (size_t)(size - done) : sizeof(block);
+        for (size_t i = 0; i < len; i++) {
+            seed = seed * 1664525u + 1013904223u;
+            block[i] = (uint8_t)(seed >> 24);
+        }
+        ok = fwrite(block, 1, len, f) == len;
+    }
+    return fclose(f) == 0 && ok;
+}
+
+static bool same_contents(const char *a, const char *b) {
+    FILE *fa = fopen(a, "rb");
+    FILE *fb = fopen(b, "rb");
+    bool same = fa && fb;
+    uint8_t ba[8192], bb[8192];
+    while (same) {
+        size_t na = fread(ba, 1, sizeof(ba), fa);
+        size_t nb = fread(bb, 1, sizeof(bb), fb);
+        same = na == nb && memcmp(ba, bb, na) == 0;
+        if (na == 0) {
+            break;
+        }
+    }
+    if (fa) {
+        fclose(fa);
+    }
+    if (fb) {
+        fclose(fb);
+    }
+    return same;
+}
+
+static void sync_file(const char *path) {
+    int fd = open(path, O_RDONLY);
+    if (fd >= 0) {
+        fsync(fd);
+        close(fd);
+    }
+}
+
+typedef esp_err_t (*copy_fn_t)(const char *src_full, const char *dst_full);
+
+static esp_err_t engine_copy(const char *src_full, const char *dst_full) {
+    return copy_engine_copy(src_full, dst_full, 0, NULL, NULL, NULL);
+}
+
+// Best of runs, in microseconds; -1 if a copy failed or differed
+static int64_t time_copy(copy_fn_t fn, const char *src, const char *dst, int runs, bool sync) {
+    int64_t best = -1;
+    for (int i = 0; i < runs; i++) {
+        remove(dst);
+        int64_t start = esp_timer_get_time();
+        if (fn(src, dst) != ESP_OK) {
+            return -1;
+        }
+        if (sync) {
+            sync_file(dst);
+        }
+        int64_t us = esp_timer_get_time() - start;
+        if (!same_contents(src, dst)) {
+            return -1;
+        }
+        if (best < 0 || us < best) {
+            best = us;
+        }
+    }
+    remove(dst);
+    return best;
+}
+
+static double mb_per_s(uint64_t bytes, int64_t us) {
+    return us > 0 ? (double)bytes / (1024.0 * 1024.0) / (us / 1e6) : 0.0;
+}
+
+int main(int argc, char **argv) {
+    int runs = 3;
+    bool sync = false;
+    uint32_t sizes_kb[32];
+    int size_count = 0;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-s") == 0) {
+            sync = true;
+        } else if (strcmp(argv[i], "-n") == 0 && i + 1 < argc) {
+            runs = atoi(argv[++i]);
+        } else if (size_count < (int)(sizeof(sizes_kb) / sizeof(sizes_kb[0]))) {
+            sizes_kb[size_count++] = (uint32_t)strtoul(argv[i], NULL, 0);
+        }
+    }
+    if (size_count == 0) {
+        size_count = (int)(sizeof(default_sizes_kb) / sizeof(default_sizes_kb[0]));
+        memcpy(sizes_kb, default_sizes_kb, sizeof(default_sizes_kb));
+    }
+    if (runs < 1) {
+        runs = 1;
+    }
+
+    mkdir(SD_MOUNT_POINT, 0755);
+    if (mkdir(BENCH_DIR, 0755) != 0 && errno != EEXIST) {
+        fprintf(stderr, "Cannot create %s: %s\n", BENCH_DIR, strerror(errno));
+        return 2;
+    }
+    printf("%s, best of %d%s\n", BENCH_DIR, runs, sync ? ", with fsync" : "");
+    printf("%10s  %12s %8s  %12s %8s  %7s\n", "size", "512 B loop", "calls/MB",
+           "copy_engine", "calls/MB", "speedup");
+
+    int failures = 0;
+    const char *src = BENCH_DIR "/src.bin";
+    const char *dst = BENCH_DIR "/dst.bin";
+    for (int i = 0; i < size_count; i++) {
+        uint64_t size = (uint64_t)sizes_kb[i] * 1024u;
+        if (!make_source(src, size)) {
+            fprintf(stderr, "Cannot create %s\n", src);
+            return 2;
+        }
+        int64_t naive_us = time_copy(naive_copy, src, dst, runs, sync);
+        int64_t engine_us = time_copy(engine_copy, src, dst, runs, sync);
+        bool ok = naive_us >= 0 && engine_us >= 0;
+        failures += !ok;
+
+        // Read and write calls each, per MB moved
+        uint32_t naive_calls = 1024u * 1024u / NAIVE_BUFFER;
+        uint32_t engine_calls = 1024u * 1024u / ENGINE_CHUNK;
+        printf("%8" PRIu32 "KB  %7.1f MB/s %8" PRIu32 "  %7.1f MB/s %8" PRIu32 "  %6.2fx  %s\n",
+               sizes_kb[i], mb_per_s(size, naive_us), naive_calls, mb_per_s(size, engine_us), engine_calls,
+               engine_us > 0 && naive_us > 0 ? (double)naive_us / (double)engine_us : 0.0,
+               ok ? "ok" : "FAILED");
+    }
+    remove(src);
+    rmdir(BENCH_DIR);
+    return failures ? 1 : 0;
+}
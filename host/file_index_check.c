@@ -0,0 +1,175 @@
+#include "config_manager.h"
+#include "sd_manager.h"
+#include "file_index.h"
+#include "esp_log.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/*
+ * File index bookkeeping on the host card:
+ *
+ *   file_index_check
+ *
+ * Works under SD_MOUNT_POINT "/.index_check" and removes it afterwards.
+ * Prints "ok", or the first check that failed.
+ */
+
+#define CHECK_DIR   "/.index_check"
+#define WAIT_MS     10000
+#define BIG_FILE    (5ULL * 1024 * 1024 * 1024)
+
+#define CHECK(cond) do { \
+        if (!(cond)) { \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+            exit(1); \
+        } \
+    } while (0)
+
+static file_index_usage_list_t usage = {0};
+
+static void make_file(const char *path, uint64_t size) {
+    char full[512];
+    snprintf(full, sizeof(full), "%s%s", SD_MOUNT_POINT, path);
+    FILE *f = fopen(full, "w");
+    CHECK(f != NULL);
+    fclose(f);
+    // Sparse, so the 5 GiB file costs nothing on the host
+    CHECK(truncate(full, (off_t)size) == 0);
+}
+
+static void make_dir(const char *path) {
+    char full[512];
+    snprintf(full, sizeof(full), "%s%s", SD_MOUNT_POINT, path);
+    CHECK(mkdir(full, 0755) == 0);
+}
+
+static void wait_ready(void) {
+    file_index_status_t status;
+    for (int waited = 0; waited < WAIT_MS; waited += 10) {
+        file_index_get_status(&status);
+        if (status.state == FILE_INDEX_READY) {
+            return;
+        }
+        vTaskDelay(pdMS_TO_TICKS(10));
+    }
+    fprintf(stderr, "index not ready\n");
+    exit(1);
+}
+
+// Usage of the named child of dir
+static const file_index_usage_t *usage_of(const char *dir, const char *name) {
+    if (file_index_usage(dir, &usage) != ESP_OK) {
+        return NULL;
+    }
+    for (uint32_t i = 0; i < usage.entries.count; i++) {
+        if (strcmp(file_listing_name(&usage.entries, i), name) == 0) {
+            return &usage.usage[i];
+        }
+    }
+    return NULL;
+}
+
+// The worker applies changes in the background; wait until a child holds files
+static bool wait_files(const char *dir, const char *name, uint32_t files) {
+    for (int waited = 0; waited < WAIT_MS; waited += 10) {
+        const file_index_usage_t *u = usage_of(dir, name);
+        if (u && u->files == files) {
+            return true;
+        }
+        vTaskDelay(pdMS_TO_TICKS(10));
+    }
+    return false;
+}
+
+static uint32_t search_count(const char *query) {
+    file_listing_t results = {0};
+    uint32_t total = 0;
+    CHECK(file_index_search(query, &results, 16, &total) == ESP_OK);
+    file_listing_free(&results);
+    return total;
+}
+
+// Totals of each child cover exactly its own subtree
+static void check_totals(void) {
+    const file_index_usage_t *a = usage_of(CHECK_DIR, "a");
+    CHECK(a != NULL);
+    CHECK(a->bytes == 150 && a->files == 2 && a->folders == 1);
+    const file_index_usage_t *c = usage_of(CHECK_DIR, "c");
+    CHECK(c != NULL);
+    CHECK(c->bytes == 10 && c->files == 1 && c->folders == 0);
+    const file_index_usage_t *big = usage_of(CHECK_DIR, "ixq_big.bin");
+    CHECK(big != NULL);
+    CHECK(big->bytes == BIG_FILE);
+    CHECK(usage.total.bytes == BIG_FILE + 160);
+    CHECK(usage.total.files == 4 && usage.total.folders == 3);
+}
+
+// A folder removed through the file operations goes with everything below it
+static void check_removal(void) {
+    CHECK(search_count("ixq_deep") == 1);
+    CHECK(system("rm -rf '" SD_MOUNT_POINT CHECK_DIR "/a/b'") == 0);
+    file_index_note_change(CHECK_DIR "/a/b");
+    CHECK(wait_files(CHECK_DIR, "a", 1));
+    const file_index_usage_t *a = usage_of(CHECK_DIR, "a");
+    CHECK(a->bytes == 50 && a->folders == 0);
+    CHECK(search_count("ixq_deep") == 0);
+    CHECK(file_index_usage(CHECK_DIR "/a/b", &usage) == ESP_ERR_NOT_FOUND);
+}
+
+// After a remount the stored index comes back, and a folder changed
+// elsewhere is read again once it is opened
+static void check_reload(void) {
+    file_index_stop();
+    make_file(CHECK_DIR "/c/ixq_new.txt", 20);
+    CHECK(file_index_start() == ESP_OK);
+    wait_ready();
+
+    const file_index_usage_t *big = usage_of(CHECK_DIR, "ixq_big.bin");
+    CHECK(big != NULL && big->bytes == BIG_FILE);
+    const file_index_usage_t *a = usage_of(CHECK_DIR, "a");
+    CHECK(a != NULL && a->bytes == 50 && a->files == 1);
+
+    file_index_note_open(CHECK_DIR "/c");
+    CHECK(wait_files(CHECK_DIR, "c", 2));
+    CHECK(usage_of(CHECK_DIR, "c")->bytes == 30);
+}
+
+int main(void) {
+    host_log_level = ESP_LOG_ERROR;
+    mkdir(SD_MOUNT_POINT, 0755);
+    if (system("rm -rf '" SD_MOUNT_POINT CHECK_DIR "'") != 0) {
+        return 2;
+    }
+    make_dir(CHECK_DIR);
+    make_dir(CHECK_DIR "/a");
+    make_dir(CHECK_DIR "/a/b");
+    make_dir(CHECK_DIR "/c");
+    make_file(CHECK_DIR "/a/b/ixq_deep.txt", 100);
+    make_file(CHECK_DIR "/a/ixq_top.txt", 50);
+    make_file(CHECK_DIR "/c/ixq_other.txt", 10);
+    make_file(CHECK_DIR "/ixq_big.bin", BIG_FILE);
+
+    config_manager_init();
+    if (sd_manager_init() != ESP_OK) {
+        fprintf(stderr, "Could not mount %s\n", SD_MOUNT_POINT);
+        return 2;
+    }
+    wait_ready();
+
+    check_totals();
+    check_removal();
+    check_reload();
+
+    file_index_usage_free(&usage);
+    file_index_stop();
+    if (system("rm -rf '" SD_MOUNT_POINT CHECK_DIR "'") != 0) {
+        return 2;
+    }
+    printf("ok\n");
+    return 0;
+}
@@ -0,0 +1,147 @@
+#include "config_manager.h"
+#include "sd_manager.h"
+#include "file_jobs.h"
+#include "esp_log.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/*
+ * Conflict handling of copy and move jobs on the host card:
+ *
+ *   file_jobs_check
+ *
+ * Works under SD_MOUNT_POINT "/.jobs_check" and removes it afterwards.
+ * Prints "ok", or the first check that failed.
+ */
+
+#define CHECK_DIR   "/.jobs_check"
+#define WAIT_MS     10000
+
+#define CHECK(cond) do { \
+        if (!(cond)) { \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+            exit(1); \
+        } \
+    } while (0)
+
+static bool exists(const char *path) {
+    char full[512];
+    snprintf(full, sizeof(full), "%s%s", SD_MOUNT_POINT, path);
+    struct stat st;
+    return stat(full, &st) == 0;
+}
+
+static void make_file(const char *path) {
+    char full[512];
+    snprintf(full, sizeof(full), "%s%s", SD_MOUNT_POINT, path);
+    FILE *f = fopen(full, "w");
+    CHECK(f != NULL);
+    fputs(path, f);
+    fclose(f);
+}
+
+static void make_dir(const char *path) {
+    char full[512];
+    snprintf(full, sizeof(full), "%s%s", SD_MOUNT_POINT, path);
+    CHECK(mkdir(full, 0755) == 0);
+}
+
+// Run a one-item job to the end and return its final state
+static file_job_info_t run_job(file_job_type_t type, const char *src, const char *dst_dir,
+                               file_job_conflict_t conflict) {
+    file_job_t *job = file_job_create(type, dst_dir, conflict);
+    CHECK(job != NULL);
+    CHECK(file_job_add(job, src) == ESP_OK);
+    uint32_t id = file_jobs_submit(job);
+    CHECK(id != 0);
+
+    file_job_info_t jobs[FILE_JOBS_MAX];
+    for (int waited = 0; waited < WAIT_MS; waited += 10) {
+        uint32_t count = file_jobs_snapshot(jobs, FILE_JOBS_MAX);
+        for (uint32_t i = 0; i < count; i++) {
+            if (jobs[i].id == id && jobs[i].state != FILE_JOB_QUEUED && jobs[i].state != FILE_JOB_RUNNING) {
+                file_job_info_t info = jobs[i];
+                file_jobs_clear_finished();
+                return info;
+            }
+        }
+        vTaskDelay(pdMS_TO_TICKS(10));
+    }
+    fprintf(stderr, "job %u did not finish\n", (unsigned)id);
+    exit(1);
+}
+
+// Cut and paste into the folder the file is already in: nothing happens
+static void check_move_in_place(void) {
+    make_dir(CHECK_DIR "/a");
+    make_file(CHECK_DIR "/a/x.txt");
+
+    static const file_job_conflict_t policies[] = {
+        FILE_JOB_CONFLICT_RENAME, FILE_JOB_CONFLICT_OVERWRITE, FILE_JOB_CONFLICT_SKIP
+    };
+    for (size_t i = 0; i < sizeof(policies) / sizeof(policies[0]); i++) {
+        file_job_info_t info = run_job(FILE_JOB_MOVE, CHECK_DIR "/a/x.txt", CHECK_DIR "/a", policies[i]);
+        CHECK(info.state == FILE_JOB_DONE);
+        CHECK(info.items_skipped == 1);
+        CHECK(exists(CHECK_DIR "/a/x.txt"));
+        CHECK(!exists(CHECK_DIR "/a/x (2).txt"));
+    }
+
+    // A folder pasted where it already is stays put too
+    file_job_info_t info = run_job(FILE_JOB_MOVE, CHECK_DIR "/a", CHECK_DIR, FILE_JOB_CONFLICT_RENAME);
+    CHECK(info.state == FILE_JOB_DONE);
+    CHECK(info.items_skipped == 1);
+    CHECK(exists(CHECK_DIR "/a/x.txt"));
+    CHECK(!exists(CHECK_DIR "/a (2)"));
+}
+
+// A real conflict elsewhere still gets the policy
+static void check_move_conflict(void) {
+    make_dir(CHECK_DIR "/b");
+    make_file(CHECK_DIR "/b/x.txt");
+
+    file_job_info_t info = run_job(FILE_JOB_MOVE, CHECK_DIR "/a/x.txt", CHECK_DIR "/b", FILE_JOB_CONFLICT_RENAME);
+    CHECK(info.state == FILE_JOB_DONE);
+    CHECK(info.items_done == 1);
+    CHECK(!exists(CHECK_DIR "/a/x.txt"));
+    CHECK(exists(CHECK_DIR "/b/x.txt"));
+    CHECK(exists(CHECK_DIR "/b/x (2).txt"));
+}
+
+// Copy and paste into the same folder keeps both
+static void check_copy_in_place(void) {
+    file_job_info_t info = run_job(FILE_JOB_COPY, CHECK_DIR "/b/x.txt", CHECK_DIR "/b", FILE_JOB_CONFLICT_RENAME);
+    CHECK(info.state == FILE_JOB_DONE);
+    CHECK(info.items_done == 1);
+    CHECK(exists(CHECK_DIR "/b/x (3).txt"));
+}
+
+int main(void) {
+    host_log_level = ESP_LOG_ERROR;
+    mkdir(SD_MOUNT_POINT, 0755);
+    config_manager_init();
+    if (sd_manager_init() != ESP_OK) {
+        fprintf(stderr, "Could not mount %s\n", SD_MOUNT_POINT);
+        return 2;
+    }
+    if (system("rm -rf '" SD_MOUNT_POINT CHECK_DIR "'") != 0) {
+        return 2;
+    }
+    make_dir(CHECK_DIR);
+
+    check_move_in_place();
+    check_move_conflict();
+    check_copy_in_place();
+
+    file_jobs_stop();
+    if (system("rm -rf '" SD_MOUNT_POINT CHECK_DIR "'") != 0) {
+        return 2;
+    }
+    printf("ok\n");
+    return 0;
+}
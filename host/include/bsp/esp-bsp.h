@@ -0,0 +1,6 @@
+#ifndef HOST_BSP_ESP_BSP_H
+#define HOST_BSP_ESP_BSP_H
+
+#include "bsp/m5stack_tab5.h"
+
+#endif // HOST_BSP_ESP_BSP_H
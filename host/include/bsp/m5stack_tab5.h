@@ -0,0 +1,44 @@
+#ifndef HOST_BSP_M5STACK_TAB5_H
+#define HOST_BSP_M5STACK_TAB5_H
+
+#include "esp_err.h"
+#include "driver/sdmmc_host.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * SD card and display parts of the Tab5 BSP. The host "card" is the
+ * directory the build maps SD_MOUNT_POINT to; mounting checks that it
+ * exists and hands back a card whose capacity is that of the host
+ * filesystem. The display functions come with the headless display of
+ * the UI build (shims/host_display.c).
+ */
+#define BSP_SD_MOUNT_POINT SD_MOUNT_POINT
+
+typedef struct {
+    uint32_t max_freq_khz;
+    uint8_t bus_width;
+    bool ddr;
+    bool uhs1;
+    size_t max_files;
+    size_t allocation_unit_size;
+    bool format_if_mount_failed;
+} bsp_sdcard_cfg_t;
+
+esp_err_t bsp_sdcard_init(char *mount_point, size_t max_files);
+esp_err_t bsp_sdcard_init_with_config(char *mount_point, const bsp_sdcard_cfg_t *cfg);
+esp_err_t bsp_sdcard_deinit(char *mount_point);
+sdmmc_card_t *bsp_sdcard_get_handle(void);
+
+#define BSP_LCD_H_RES            (720)
+#define BSP_LCD_V_RES            (1280)
+#define BSP_LCD_DRAW_BUFF_SIZE   (BSP_LCD_H_RES * 50)  // Frame buffer size in pixels
+#define BSP_LCD_DRAW_BUFF_DOUBLE (0)
+
+bool bsp_display_lock(uint32_t timeout_ms);
+void bsp_display_unlock(void);
+esp_err_t bsp_display_brightness_set(int brightness_percent);
+esp_err_t bsp_display_backlight_on(void);
+
+#endif // HOST_BSP_M5STACK_TAB5_H
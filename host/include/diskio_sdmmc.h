@@ -0,0 +1,16 @@
+#ifndef HOST_DISKIO_SDMMC_H
+#define HOST_DISKIO_SDMMC_H
+
+#include "diskio_impl.h"
+#include "driver/sdmmc_host.h"
+
+// Always 0xFF on the host: no card is registered with FatFs
+BYTE ff_diskio_get_pdrv_card(const sdmmc_card_t *card);
+
+DSTATUS ff_sdmmc_initialize(BYTE pdrv);
+DSTATUS ff_sdmmc_status(BYTE pdrv);
+DRESULT ff_sdmmc_read(BYTE pdrv, BYTE *buff, DWORD sector, UINT count);
+DRESULT ff_sdmmc_write(BYTE pdrv, const BYTE *buff, DWORD sector, UINT count);
+DRESULT ff_sdmmc_ioctl(BYTE pdrv, BYTE cmd, void *buff);
+
+#endif // HOST_DISKIO_SDMMC_H
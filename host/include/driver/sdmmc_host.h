@@ -0,0 +1,42 @@
+#ifndef HOST_DRIVER_SDMMC_HOST_H
+#define HOST_DRIVER_SDMMC_HOST_H
+
+#include "esp_err.h"
+#include <stdint.h>
+
+// Only the card fields the launcher reads; filled in by the BSP shim
+typedef struct {
+    struct {
+        int slot;
+        int max_freq_khz;
+    } host;
+    struct {
+        int mfg_id;
+        int oem_id;
+        char name[8];
+        int revision;
+        int serial;
+    } cid;
+    struct {
+        int capacity;
+        int sector_size;
+    } csd;
+    uint32_t log_bus_width;
+    int real_freq_khz;
+    int max_freq_khz;
+    uint32_t is_ddr;
+} sdmmc_card_t;
+
+#define SDMMC_FREQ_DEFAULT      20000
+#define SDMMC_FREQ_HIGHSPEED    40000
+#define SDMMC_FREQ_26M          26000
+#define SDMMC_FREQ_52M          52000
+#define SDMMC_FREQ_SDR50        100000
+#define SDMMC_FREQ_DDR50        50000
+#define SDMMC_SLOT_FLAG_UHS1    (1 << 3)
+#define SDMMC_HOST_FLAG_DDR     (1 << 3)
+
+esp_err_t sdmmc_host_set_card_clk(int slot, uint32_t freq_khz);
+esp_err_t sdmmc_host_get_real_freq(int slot, int *real_freq_khz);
+
+#endif // HOST_DRIVER_SDMMC_HOST_H
@@ -0,0 +1,6 @@
+#ifndef HOST_DRIVER_SDSPI_HOST_H
+#define HOST_DRIVER_SDSPI_HOST_H
+
+#include "driver/sdmmc_host.h"
+
+#endif // HOST_DRIVER_SDSPI_HOST_H
@@ -0,0 +1,6 @@
+#ifndef HOST_ESP_EFUSE_H
+#define HOST_ESP_EFUSE_H
+
+// Nothing is burned on the host; the launcher only includes this header
+
+#endif // HOST_ESP_EFUSE_H
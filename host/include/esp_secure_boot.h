@@ -0,0 +1,10 @@
+#ifndef HOST_ESP_SECURE_BOOT_H
+#define HOST_ESP_SECURE_BOOT_H
+
+#include <stdbool.h>
+
+static inline bool esp_secure_boot_enabled(void) {
+    return false;
+}
+
+#endif // HOST_ESP_SECURE_BOOT_H
@@ -0,0 +1,12 @@
+#ifndef HOST_ESP_SLEEP_H
+#define HOST_ESP_SLEEP_H
+
+#include "esp_err.h"
+#include <stdint.h>
+
+esp_err_t esp_sleep_enable_timer_wakeup(uint64_t time_in_us);
+
+// Deep sleep resets the chip; the host process exits instead
+void esp_deep_sleep_start(void) __attribute__((noreturn));
+
+#endif // HOST_ESP_SLEEP_H
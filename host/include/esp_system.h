@@ -0,0 +1,9 @@
+#ifndef HOST_ESP_SYSTEM_H
+#define HOST_ESP_SYSTEM_H
+
+#include "esp_err.h"
+
+// A restart ends the host process
+void esp_restart(void) __attribute__((noreturn));
+
+#endif // HOST_ESP_SYSTEM_H
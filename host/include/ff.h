@@ -0,0 +1,118 @@
+#ifndef HOST_FF_H
+#define HOST_FF_H
+
+#include <stdint.h>
+
+/*
+ * FatFs types and entry points the storage code refers to. The host has
+ * no FatFs volume: the card is a plain directory reached through the
+ * POSIX calls, so every function here reports FR_NOT_READY and the
+ * callers take their VFS fallback paths.
+ */
+typedef uint8_t BYTE;
+typedef uint16_t WORD;
+typedef uint32_t DWORD;
+typedef uint64_t QWORD;
+typedef unsigned int UINT;
+typedef char TCHAR;
+typedef QWORD FSIZE_t;
+typedef DWORD LBA_t;
+
+#define FF_FS_EXFAT     1
+#define FF_MAX_SS       4096
+#define FF_MIN_SS       512
+
+#define FS_FAT12        1
+#define FS_FAT16        2
+#define FS_FAT32        3
+#define FS_EXFAT        4
+
+#define FA_READ             0x01
+#define FA_WRITE            0x02
+#define FA_OPEN_EXISTING    0x00
+#define FA_CREATE_NEW       0x04
+#define FA_CREATE_ALWAYS    0x08
+#define FA_OPEN_ALWAYS      0x10
+#define FA_OPEN_APPEND      0x30
+
+#define AM_RDO  0x01
+#define AM_HID  0x02
+#define AM_SYS  0x04
+#define AM_DIR  0x10
+#define AM_ARC  0x20
+
+typedef enum {
+    FR_OK = 0,
+    FR_DISK_ERR,
+    FR_INT_ERR,
+    FR_NOT_READY,
+    FR_NO_FILE,
+    FR_NO_PATH,
+    FR_INVALID_NAME,
+    FR_DENIED,
+    FR_EXIST,
+    FR_INVALID_OBJECT,
+    FR_WRITE_PROTECTED,
+    FR_INVALID_DRIVE,
+    FR_NOT_ENABLED,
+    FR_NO_FILESYSTEM,
+    FR_MKFS_ABORTED,
+    FR_TIMEOUT,
+    FR_LOCKED,
+    FR_NOT_ENOUGH_CORE,
+    FR_TOO_MANY_OPEN_FILES,
+    FR_INVALID_PARAMETER
+} FRESULT;
+
+typedef struct {
+    BYTE fs_type;
+    BYTE pdrv;
+    BYTE n_fats;
+    WORD csize;
+    WORD ssize;
+    DWORD n_fatent;
+    DWORD fsize;
+    DWORD free_clst;
+    LBA_t fatbase;
+    LBA_t dirbase;
+    LBA_t database;
+    LBA_t bitbase;
+    BYTE win[FF_MAX_SS];
+} FATFS;
+
+typedef struct {
+    FATFS *fs;
+} FFOBJID;
+
+typedef struct {
+    FFOBJID obj;
+} FIL;
+
+typedef struct {
+    FFOBJID obj;
+} FF_DIR;
+
+typedef struct {
+    FSIZE_t fsize;
+    WORD fdate;
+    WORD ftime;
+    BYTE fattrib;
+    TCHAR altname[13];
+    TCHAR fname[256];
+} FILINFO;
+
+FRESULT f_open(FIL *fp, const TCHAR *path, BYTE mode);
+FRESULT f_close(FIL *fp);
+FRESULT f_read(FIL *fp, void *buff, UINT btr, UINT *br);
+FRESULT f_write(FIL *fp, const void *buff, UINT btw, UINT *bw);
+FRESULT f_lseek(FIL *fp, FSIZE_t ofs);
+FRESULT f_sync(FIL *fp);
+FRESULT f_expand(FIL *fp, FSIZE_t fsz, BYTE opt);
+FRESULT f_opendir(FF_DIR *dp, const TCHAR *path);
+FRESULT f_closedir(FF_DIR *dp);
+FRESULT f_readdir(FF_DIR *dp, FILINFO *fno);
+FRESULT f_stat(const TCHAR *path, FILINFO *fno);
+FRESULT f_unlink(const TCHAR *path);
+FRESULT f_getfree(const TCHAR *path, DWORD *nclst, FATFS **fatfs);
+
+#endif // HOST_FF_H
@@ -0,0 +1,48 @@
+#ifndef HOST_FREERTOS_H
+#define HOST_FREERTOS_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * The slice of the FreeRTOS API the launcher uses, on top of pthreads.
+ * One tick is one millisecond. Task priorities and core affinity are
+ * accepted and ignored; the host scheduler decides.
+ */
+typedef int BaseType_t;
+typedef unsigned int UBaseType_t;
+typedef uint32_t TickType_t;
+typedef uint32_t StackType_t;
+
+#define pdFALSE                 ((BaseType_t)0)
+#define pdTRUE                  ((BaseType_t)1)
+#define pdFAIL                  pdFALSE
+#define pdPASS                  pdTRUE
+#define errQUEUE_EMPTY          pdFALSE
+#define errQUEUE_FULL           pdFALSE
+
+#define configTICK_RATE_HZ      1000
+#define portTICK_PERIOD_MS      ((TickType_t)1)
+#define portMAX_DELAY           ((TickType_t)0xffffffffUL)
+#define pdMS_TO_TICKS(ms)       ((TickType_t)(ms))
+#define pdTICKS_TO_MS(ticks)    ((uint32_t)(ticks))
+
+// Critical sections share one process-wide recursive lock
+typedef struct {
+    int unused;
+} portMUX_TYPE;
+
+#define portMUX_INITIALIZER_UNLOCKED {0}
+
+void host_enter_critical(portMUX_TYPE *mux);
+void host_exit_critical(portMUX_TYPE *mux);
+
+#define portENTER_CRITICAL(mux)       host_enter_critical(mux)
+#define portEXIT_CRITICAL(mux)        host_exit_critical(mux)
+#define portENTER_CRITICAL_ISR(mux)   host_enter_critical(mux)
+#define portEXIT_CRITICAL_ISR(mux)    host_exit_critical(mux)
+#define taskENTER_CRITICAL(mux)       host_enter_critical(mux)
+#define taskEXIT_CRITICAL(mux)        host_exit_critical(mux)
+
+#endif // HOST_FREERTOS_H
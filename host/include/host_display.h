@@ -0,0 +1,30 @@
+#ifndef HOST_DISPLAY_H
+#define HOST_DISPLAY_H
+
+#include "esp_err.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+/*
+ * Headless stand-in for the Tab5 panel and touch controller, behind the
+ * same hal.h as the device. Flushes go through the same rotation as
+ * hal.c into a panel-sized RGB565 frame buffer; the touch controller
+ * reports whatever the last host_display_touch() call set.
+ */
+
+/**
+ * @brief Set the pointer state read by the next touch poll
+ * @param x Screen x coordinate (rotated, as the user sees it)
+ * @param y Screen y coordinate
+ * @param pressed Whether the finger is down
+ */
+void host_display_touch(int32_t x, int32_t y, bool pressed);
+
+/**
+ * @brief Save what is on the panel as a binary PPM, rotated like the screen
+ * @param path Host file path
+ * @return ESP_OK on success
+ */
+esp_err_t host_display_save_ppm(const char *path);
+
+#endif // HOST_DISPLAY_H
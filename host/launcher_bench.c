@@ -0,0 +1,410 @@
+#include "config_manager.h"
+#include "sd_manager.h"
+#include "file_operations.h"
+#include "file_listing.h"
+#include "listing_cache.h"
+#include "dir_scanner.h"
+#include "file_index.h"
+#include "sd_stream.h"
+#include "sd_io.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include <errno.h>
+#include <inttypes.h>
+#include <malloc.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+/*
+ * Scripted benchmark for the storage layer on the Linux host.
+ *
+ *   launcher_bench [-v] [-c results.csv] script.txt
+ *
+ * The card is the directory SD_MOUNT_POINT was built with. Each script
+ * line is one step; paths are relative to the SD root, as in the UI:
+ *
+ *   populate <dir> <count> <bytes>  Create count files through write streams
+ *   mkdir <dir>                     file_ops_create_directory()
+ *   browse <dir>                    Open a directory like the file browser:
+ *                                   listing cache first, else the scanner
+ *                                   polled every DIR_SCANNER_POLL_MS, then
+ *                                   sorted
+ *   list <dir>                      sd_manager_enumerate() on the caller
+ *   read <file>                     Read a file through a stream
+ *   copy <src> <dst>                file_ops_copy_file() or _copy_directory()
+ *   delete <path>                   file_ops_delete_file() or _directory()
+ *   index                           Wait for the file index to be ready
+ *   search <query>                  file_index_search()
+ *   sleep <ms>                      Let background work run
+ *
+ * Every step reports its wall time and the heap in use after it, plus the
+ * peak seen while it ran. browse also reports the scanner side of the
+ * browser: time to the first entries, dir_scanner polls until done and
+ * the longest single poll. Nothing is rendered here; ui_bench measures
+ * the frames of the real screens.
+ */
+
+#define LINE_MAX_LEN     512
+#define STREAM_CHUNK     (32 * 1024)
+#define SEARCH_MAX       64
+
+typedef struct {
+    char step[96];
+    bool ok;
+    int64_t us;
+    uint32_t items;
+    uint64_t bytes;
+    int64_t first_us;       // browse: until the first entries were on screen
+    uint32_t polls;         // browse: dir_scanner polls until complete
+    int64_t max_poll_us;    // browse: longest single poll
+    size_t heap;
+    size_t heap_peak;
+} step_result_t;
+
+static size_t heap_peak;
+
+static size_t heap_in_use(void) {
+    struct mallinfo2 info = mallinfo2();
+    size_t used = info.uordblks + info.hblkhd;
+    if (used > heap_peak) {
+        heap_peak = used;
+    }
+    return used;
+}
+
+static void fill_pattern(uint8_t *buffer, size_t len, uint32_t seed) {
+    for (size_t i = 0; i < len; i++) {
+        seed = seed * 1664525u + 1013904223u;
+        buffer[i] = (uint8_t)(seed >> 24);
+    }
+}
+
+static bool is_directory(const char *path) {
+    char full_path[512];
+    snprintf(full_path, sizeof(full_path), "%s%s", SD_MOUNT_POINT, path);
+    struct stat st;
+    return stat(full_path, &st) == 0 && S_ISDIR(st.st_mode);
+}
+
+static bool write_file(const char *path, uint64_t size, uint32_t seed) {
+    static uint8_t chunk[STREAM_CHUNK];
+    sd_stream_t *stream = NULL;
+    if (sd_stream_open(path, SD_STREAM_WRITE, NULL, &stream) != ESP_OK) {
+        return false;
+    }
+    esp_err_t ret = ESP_OK;
+    for (uint64_t done = 0; done < size && ret == ESP_OK; done += sizeof(chunk)) {
+        size_t len = size - done < sizeof(chunk) ? (size_t)(size - done) : sizeof(chunk);
+        fill_pattern(chunk, len, seed + (uint32_t)(done / sizeof(chunk)));
+        ret = sd_stream_write(stream, chunk, len);
+    }
+    esp_err_t closed = sd_stream_close(stream);
+    return ret == ESP_OK && closed == ESP_OK;
+}
+
+static bool step_populate(const char *dir, uint32_t count, uint64_t size, step_result_t *r) {
+    if (!is_directory(dir) && file_ops_create_directory(dir) != ESP_OK) {
+        return false;
+    }
+    for (uint32_t i = 0; i < count; i++) {
+        char path[256];
+        snprintf(path, sizeof(path), "%s/file_%05" PRIu32 ".bin", strcmp(dir, "/") == 0 ? "" : dir, i);
+        if (!write_file(path, size, i)) {
+            return false;
+        }
+        r->items++;
+        r->bytes += size;
+        heap_in_use();
+    }
+    return true;
+}
+
+// The file browser's load path, with the browser's timer period between polls
+static bool step_browse(const char *dir, step_result_t *r) {
+    file_listing_t listing = {0};
+    int64_t start = esp_timer_get_time();
+    bool ok = true;
+
+    if (listing_cache_lookup(dir, true, &listing)) {
+        r->first_us = esp_timer_get_time() - start;
+        r->polls = 1;
+        r->max_poll_us = r->first_us;
+    } else {
+        uint32_t scan_id = dir_scanner_start(dir, true);
+        if (scan_id == 0) {
+            return false;
+        }
+        dir_scan_state_t state = DIR_SCAN_RUNNING;
+        while (state == DIR_SCAN_RUNNING) {
+            vTaskDelay(pdMS_TO_TICKS(DIR_SCANNER_POLL_MS));
+            int64_t poll_start = esp_timer_get_time();
+            uint32_t before = listing.count;
+            state = dir_scanner_poll(scan_id, &listing, DIR_SCANNER_POLL_BATCH);
+            int64_t poll_us = esp_timer_get_time() - poll_start;
+            r->polls++;
+            if (poll_us > r->max_poll_us) {
+                r->max_poll_us = poll_us;
+            }
+            if (before == 0 && listing.count > 0) {
+                r->first_us = esp_timer_get_time() - start;
+            }
+            heap_in_use();
+        }
+        ok = state == DIR_SCAN_DONE;
+        if (ok) {
+            listing_cache_store(dir, true, &listing);
+        }
+    }
+
+    uint32_t *order = malloc((listing.count ? listing.count : 1) * sizeof(uint32_t));
+    if (!order) {
+        file_listing_free(&listing);
+        return false;
+    }
+    for (uint32_t i = 0; i < listing.count; i++) {
+        order[i] = i;
+    }
+    if (file_listing_sort(&listing, order, listing.count, FILE_LISTING_SORT_NAME, true) != ESP_OK) {
+        ok = false;
+    }
+    heap_in_use();
+    r->items = listing.count;
+    free(order);
+    file_listing_free(&listing);
+    return ok;
+}
+
+static bool count_entry_cb(const sd_dir_entry_t *entry, void *user_data) {
+    step_result_t *r = user_data;
+    (void)entry;
+    r->items++;
+    return true;
+}
+
+static bool step_list(const char *dir, step_result_t *r) {
+    return sd_manager_enumerate(dir, true, count_entry_cb, r) >= 0;
+}
+
+static bool step_read(const char *path, step_result_t *r) {
+    sd_stream_t *stream = NULL;
+    if (sd_stream_open(path, SD_STREAM_READ, NULL, &stream) != ESP_OK) {
+        return false;
+    }
+    bool ok = true;
+    for (;;) {
+        const uint8_t *data;
+        size_t len;
+        if (sd_stream_borrow(stream, &data, &len) != ESP_OK) {
+            ok = false;
+            break;
+        }
+        sd_stream_release(stream);
+        if (len == 0) {
+            break;
+        }
+        r->bytes += len;
+    }
+    heap_in_use();
+    r->items = 1;
+    return sd_stream_close(stream) == ESP_OK && ok;
+}
+
+static bool step_copy(const char *src, const char *dst, step_result_t *r) {
+    r->items = 1;
+    if (is_directory(src)) {
+        return file_ops_copy_directory(src, dst) == ESP_OK;
+    }
+    r->bytes = sd_manager_get_file_size(src);
+    return file_ops_copy_file(src, dst) == ESP_OK;
+}
+
+static bool step_delete(const char *path, step_result_t *r) {
+    r->items = 1;
+    if (is_directory(path)) {
+        return file_ops_delete_directory(path) == ESP_OK;
+    }
+    return file_ops_delete_file(path) == ESP_OK;
+}
+
+#define INDEX_START_TIMEOUT_MS 2000
+
+static bool step_index(step_result_t *r) {
+    file_index_status_t status;
+    int64_t start = esp_timer_get_time();
+    for (;;) {
+        file_index_get_status(&status);
+        if (status.state == FILE_INDEX_READY) {
+            break;
+        }
+        // file_index_start() only queues the start, so the worker may not have left OFFLINE yet
+        if (status.state == FILE_INDEX_OFFLINE &&
+            (!sd_manager_is_mounted() || esp_timer_get_time() - start > INDEX_START_TIMEOUT_MS * 1000)) {
+            break;
+        }
+        vTaskDelay(pdMS_TO_TICKS(10));
+        heap_in_use();
+    }
+    r->items = status.entries;
+    return status.state == FILE_INDEX_READY;
+}
+
+static bool step_search(const char *query, step_result_t *r) {
+    file_listing_t results = {0};
+    uint32_t total = 0;
+    bool ok = file_index_search(query, &results, SEARCH_MAX, &total) == ESP_OK;
+    heap_in_use();
+    r->items = total;
+    file_listing_free(&results);
+    return ok;
+}
+
+static bool run_step(int argc, char **argv, step_result_t *r) {
+    const char *cmd = argv[0];
+    if (strcmp(cmd, "populate") == 0 && argc == 4) {
+        return step_populate(argv[1], (uint32_t)strtoul(argv[2], NULL, 0), strtoull(argv[3], NULL, 0), r);
+    } else if (strcmp(cmd, "mkdir") == 0 && argc == 2) {
+        return file_ops_create_directory(argv[1]) == ESP_OK;
+    } else if (strcmp(cmd, "browse") == 0 && argc == 2) {
+        return step_browse(argv[1], r);
+    } else if (strcmp(cmd, "list") == 0 && argc == 2) {
+        return step_list(argv[1], r);
+    } else if (strcmp(cmd, "read") == 0 && argc == 2) {
+        return step_read(argv[1], r);
+    } else if (strcmp(cmd, "copy") == 0 && argc == 3) {
+        return step_copy(argv[1], argv[2], r);
+    } else if (strcmp(cmd, "delete") == 0 && argc == 2) {
+        return step_delete(argv[1], r);
+    } else if (strcmp(cmd, "index") == 0 && argc == 1) {
+        return step_index(r);
+    } else if (strcmp(cmd, "search") == 0 && argc == 2) {
+        return step_search(argv[1], r);
+    } else if (strcmp(cmd, "sleep") == 0 && argc == 2) {
+        vTaskDelay(pdMS_TO_TICKS(strtoul(argv[1], NULL, 0)));
+        return true;
+    }
+    fprintf(stderr, "Unknown step or wrong arguments: %s\n", cmd);
+    return false;
+}
+
+static void print_result(const step_result_t *r, FILE *csv) {
+    char rate[24] = "";
+    if (r->bytes > 0 && r->us > 0) {
+        snprintf(rate, sizeof(rate), "%.1f MB/s", (double)r->bytes / (double)r->us);
+    }
+    char polls[48] = "";
+    if (r->polls > 0) {
+        snprintf(polls, sizeof(polls), "first %.1f ms, %" PRIu32 " polls, max %.2f ms",
+                 r->first_us / 1000.0, r->polls, r->max_poll_us / 1000.0);
+    }
+    printf("%-4s %-36.36s %9.1f ms %7" PRIu32 " items %12s  heap %7zu KB peak %7zu KB  %s\n",
+           r->ok ? "ok" : "FAIL", r->step, r->us / 1000.0, r->items, rate,
+           r->heap / 1024, r->heap_peak / 1024, polls);
+    if (csv) {
+        fprintf(csv, "\"%s\",%d,%" PRId64 ",%" PRIu32 ",%" PRIu64 ",%" PRId64 ",%" PRIu32 ",%" PRId64 ",%zu,%zu\n",
+                r->step, r->ok, r->us, r->items, r->bytes, r->first_us, r->polls, r->max_poll_us,
+                r->heap, r->heap_peak);
+    }
+}
+
+static void print_io_stats(void) {
+    sd_io_stats_t stats;
+    sd_io_get_stats(&stats);
+    for (int i = 0; i < SD_IO_CLASS_COUNT; i++) {
+        const sd_io_class_stats_t *s = &stats.classes[i];
+        printf("io %-11s %8" PRIu32 " requests %6" PRIu32 " deferred %4" PRIu32 " expired  max wait %.1f ms\n",
+               sd_io_class_name((sd_io_class_t)i), s->requests, s->deferred, s->expired, s->max_wait_us / 1000.0);
+    }
+    listing_cache_stats_t cache;
+    listing_cache_get_stats(&cache);
+    printf("listing cache %" PRIu32 " hits %" PRIu32 " misses %" PRIu32 " stale %" PRIu32 " invalidations\n",
+           cache.hits, cache.misses, cache.stale, cache.invalidations);
+}
+
+int main(int argc, char **argv) {
+    const char *script_path = NULL;
+    const char *csv_path = NULL;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-v") == 0) {
+            host_log_level = ESP_LOG_INFO;
+        } else if (strcmp(argv[i], "-c") == 0 && i + 1 < argc) {
+            csv_path = argv[++i];
+        } else {
+            script_path = argv[i];
+        }
+    }
+    if (!script_path) {
+        fprintf(stderr, "usage: %s [-v] [-c results.csv] script.txt\n", argv[0]);
+        return 2;
+    }
+
+    FILE *script = fopen(script_path, "r");
+    if (!script) {
+        fprintf(stderr, "Cannot open %s: %s\n", script_path, strerror(errno));
+        return 2;
+    }
+    FILE *csv = NULL;
+    if (csv_path) {
+        csv = fopen(csv_path, "w");
+        if (!csv) {
+            fprintf(stderr, "Cannot create %s: %s\n", csv_path, strerror(errno));
+            fclose(script);
+            return 2;
+        }
+        fprintf(csv, "step,ok,us,items,bytes,first_us,polls,max_poll_us,heap,heap_peak\n");
+    }
+
+    mkdir(SD_MOUNT_POINT, 0755);
+    config_manager_init();
+    if (sd_manager_init() != ESP_OK) {
+        fprintf(stderr, "Could not mount %s\n", SD_MOUNT_POINT);
+        fclose(script);
+        if (csv) {
+            fclose(csv);
+        }
+        return 1;
+    }
+    printf("card %s\n", SD_MOUNT_POINT);
+
+    int failures = 0;
+    char line[LINE_MAX_LEN];
+    while (fgets(line, sizeof(line), script)) {
+        line[strcspn(line, "#\r\n")] = '\0';
+        char *args[8];
+        int count = 0;
+        for (char *tok = strtok(line, " \t"); tok && count < 8; tok = strtok(NULL, " \t")) {
+            args[count++] = tok;
+        }
+        if (count == 0) {
+            continue;
+        }
+
+        step_result_t r = {0};
+        int used = 0;
+        for (int i = 0; i < count && used < (int)sizeof(r.step) - 1; i++) {
+            used += snprintf(r.step + used, sizeof(r.step) - used, "%s%s", i ? " " : "", args[i]);
+        }
+        heap_peak = 0;
+        heap_in_use();
+        int64_t start = esp_timer_get_time();
+        r.ok = run_step(count, args, &r);
+        r.us = esp_timer_get_time() - start;
+        r.heap = heap_in_use();
+        r.heap_peak = heap_peak;
+        print_result(&r, csv);
+        if (!r.ok) {
+            failures++;
+        }
+    }
+
+    print_io_stats();
+    sd_manager_deinit();
+    fclose(script);
+    if (csv) {
+        fclose(csv);
+    }
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,259 @@
+#include "bsp/m5stack_tab5.h"
+#include "esp_log.h"
+#include "esp_vfs_fat.h"
+#include "sdmmc_cmd.h"
+#include "diskio_sdmmc.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/statvfs.h>
+#include <unistd.h>
+
+static const char *TAG = "HOST_SD";
+
+/*
+ * The mount point is a host directory (SD_MOUNT_POINT, set by the host
+ * build). "Mounting" checks that it exists and fills in a card that
+ * reports the host filesystem's size; bus settings are recorded so the
+ * mount profile code sees the mode it asked for.
+ */
+static sdmmc_card_t card;
+static bool mounted = false;
+
+esp_err_t bsp_sdcard_init_with_config(char *mount_point, const bsp_sdcard_cfg_t *cfg) {
+    if (mounted) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    struct stat st;
+    if (stat(mount_point, &st) != 0 || !S_ISDIR(st.st_mode)) {
+        if (!cfg->format_if_mount_failed || mkdir(mount_point, 0755) != 0) {
+            ESP_LOGE(TAG, "%s is not a directory", mount_point);
+            return ESP_FAIL;
+        }
+    }
+
+    struct statvfs fs;
+    uint64_t bytes = 0;
+    if (statvfs(mount_point, &fs) == 0) {
+        bytes = (uint64_t)fs.f_blocks * fs.f_frsize;
+    }
+
+    memset(&card, 0, sizeof(card));
+    snprintf(card.cid.name, sizeof(card.cid.name), "HOST");
+    card.cid.mfg_id = 0;
+    card.cid.oem_id = 0x484F;   // "HO"
+    card.cid.serial = (int)(st.st_ino & 0x7FFFFFFF);
+    card.csd.sector_size = 512;
+    card.csd.capacity = (int)(bytes / 512 > 0x7FFFFFFF ? 0x7FFFFFFF : bytes / 512);
+    card.log_bus_width = cfg->bus_width == 4 ? 2 : 0;
+    card.max_freq_khz = (int)cfg->max_freq_khz;
+    card.real_freq_khz = (int)cfg->max_freq_khz;
+    card.is_ddr = cfg->ddr;
+    mounted = true;
+    return ESP_OK;
+}
+
+esp_err_t bsp_sdcard_init(char *mount_point, size_t max_files) {
+    const bsp_sdcard_cfg_t cfg = {
+        .max_freq_khz = SDMMC_FREQ_HIGHSPEED,
+        .bus_width = 4,
+        .max_files = max_files,
+    };
+    return bsp_sdcard_init_with_config(mount_point, &cfg);
+}
+
+esp_err_t bsp_sdcard_deinit(char *mount_point) {
+    (void)mount_point;
+    if (!mounted) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    mounted = false;
+    return ESP_OK;
+}
+
+sdmmc_card_t *bsp_sdcard_get_handle(void) {
+    return mounted ? &card : NULL;
+}
+
+/* SDMMC host: the clock is whatever was asked for */
+
+esp_err_t sdmmc_host_set_card_clk(int slot, uint32_t freq_khz) {
+    (void)slot;
+    card.max_freq_khz = (int)freq_khz;
+    return ESP_OK;
+}
+
+esp_err_t sdmmc_host_get_real_freq(int slot, int *real_freq_khz) {
+    (void)slot;
+    *real_freq_khz = card.max_freq_khz;
+    return ESP_OK;
+}
+
+esp_err_t sdmmc_read_sectors(sdmmc_card_t *c, void *dst, size_t start_sector, size_t sector_count) {
+    (void)c;
+    (void)dst;
+    (void)start_sector;
+    (void)sector_count;
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+esp_err_t sdmmc_write_sectors(sdmmc_card_t *c, const void *src, size_t start_sector, size_t sector_count) {
+    (void)c;
+    (void)src;
+    (void)start_sector;
+    (void)sector_count;
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+/* FatFs: no volume is registered, so callers fall back to the POSIX paths */
+
+BYTE ff_diskio_get_pdrv_card(const sdmmc_card_t *c) {
+    (void)c;
+    return 0xFF;
+}
+
+void ff_diskio_register(BYTE pdrv, const ff_diskio_impl_t *discio_impl) {
+    (void)pdrv;
+    (void)discio_impl;
+}
+
+DSTATUS ff_sdmmc_initialize(BYTE pdrv) {
+    (void)pdrv;
+    return STA_NOINIT;
+}
+
+DSTATUS ff_sdmmc_status(BYTE pdrv) {
+    (void)pdrv;
+    return STA_NOINIT;
+}
+
+DRESULT ff_sdmmc_read(BYTE pdrv, BYTE *buff, DWORD sector, UINT count) {
+    (void)pdrv;
+    (void)buff;
+    (void)sector;
+    (void)count;
+    return RES_NOTRDY;
+}
+
+DRESULT ff_sdmmc_write(BYTE pdrv, const BYTE *buff, DWORD sector, UINT count) {
+    (void)pdrv;
+    (void)buff;
+    (void)sector;
+    (void)count;
+    return RES_NOTRDY;
+}
+
+DRESULT ff_sdmmc_ioctl(BYTE pdrv, BYTE cmd, void *buff) {
+    (void)pdrv;
+    (void)cmd;
+    (void)buff;
+    return RES_NOTRDY;
+}
+
+FRESULT f_open(FIL *fp, const TCHAR *path, BYTE mode) {
+    (void)fp;
+    (void)path;
+    (void)mode;
+    return FR_NOT_READY;
+}
+
+FRESULT f_close(FIL *fp) {
+    (void)fp;
+    return FR_NOT_READY;
+}
+
+FRESULT f_read(FIL *fp, void *buff, UINT btr, UINT *br) {
+    (void)fp;
+    (void)buff;
+    (void)btr;
+    *br = 0;
+    return FR_NOT_READY;
+}
+
+FRESULT f_write(FIL *fp, const void *buff, UINT btw, UINT *bw) {
+    (void)fp;
+    (void)buff;
+    (void)btw;
+    *bw = 0;
+    return FR_NOT_READY;
+}
+
+FRESULT f_lseek(FIL *fp, FSIZE_t ofs) {
+    (void)fp;
+    (void)ofs;
+    return FR_NOT_READY;
+}
+
+FRESULT f_sync(FIL *fp) {
+    (void)fp;
+    return FR_NOT_READY;
+}
+
+FRESULT f_expand(FIL *fp, FSIZE_t fsz, BYTE opt) {
+    (void)fp;
+    (void)fsz;
+    (void)opt;
+    return FR_NOT_READY;
+}
+
+FRESULT f_opendir(FF_DIR *dp, const TCHAR *path) {
+    (void)path;
+    dp->obj.fs = NULL;
+    return FR_NOT_READY;
+}
+
+FRESULT f_closedir(FF_DIR *dp) {
+    (void)dp;
+    return FR_NOT_READY;
+}
+
+FRESULT f_readdir(FF_DIR *dp, FILINFO *fno) {
+    (void)dp;
+    fno->fname[0] = '\0';
+    return FR_NOT_READY;
+}
+
+FRESULT f_stat(const TCHAR *path, FILINFO *fno) {
+    (void)path;
+    (void)fno;
+    return FR_NOT_READY;
+}
+
+FRESULT f_unlink(const TCHAR *path) {
+    (void)path;
+    return FR_NOT_READY;
+}
+
+FRESULT f_getfree(const TCHAR *path, DWORD *nclst, FATFS **fatfs) {
+    (void)path;
+    *nclst = 0;
+    *fatfs = NULL;
+    return FR_NOT_READY;
+}
+
+/* VFS FAT helpers */
+
+esp_err_t esp_vfs_fat_create_contiguous_file(const char *base_path, const char *full_path,
+                                             uint64_t size, bool alloc_now) {
+    (void)base_path;
+    (void)alloc_now;
+    int fd = open(full_path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        return ESP_FAIL;
+    }
+    int err = posix_fallocate(fd, 0, (off_t)size);
+    close(fd);
+    return err == 0 ? ESP_OK : ESP_FAIL;
+}
+
+esp_err_t esp_vfs_fat_info(const char *base_path, uint64_t *out_total_bytes, uint64_t *out_free_bytes) {
+    struct statvfs fs;
+    if (statvfs(base_path, &fs) != 0) {
+        return ESP_FAIL;
+    }
+    *out_total_bytes = (uint64_t)fs.f_blocks * fs.f_frsize;
+    *out_free_bytes = (uint64_t)fs.f_bavail * fs.f_frsize;
+    return ESP_OK;
+}
@@ -0,0 +1,62 @@
+#include "config_manager.h"
+#include <string.h>
+
+/*
+ * Stand-in for config_manager.c when the host has no cJSON. The
+ * configuration lives in memory only and starts from the defaults the
+ * storage code depends on; saving always succeeds and keeps nothing.
+ */
+static launcher_config_t current_config;
+static bool ready = false;
+
+esp_err_t config_manager_reset_defaults(launcher_config_t *config) {
+    if (!config) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    memset(config, 0, sizeof(*config));
+    config->version = CONFIG_VERSION;
+    config->magic = 0x4C414E43;
+    config->file_browser.view_mode = VIEW_MODE_LIST;
+    config->file_browser.sort_by = SORT_BY_NAME;
+    config->file_browser.sort_ascending = true;
+    config->file_browser.show_file_extensions = true;
+    config->file_browser.show_file_sizes = true;
+    config->file_browser.confirm_delete = true;
+    config->file_browser.items_per_page = 10;
+    config->sd.max_freq_khz = 0;
+    config->sd.max_files = 5;
+    config->sd.allocation_unit = 16 * 1024;
+    config->sd.auto_probe = true;
+    return ESP_OK;
+}
+
+esp_err_t config_manager_init(void) {
+    config_manager_reset_defaults(&current_config);
+    ready = true;
+    return ESP_OK;
+}
+
+esp_err_t config_manager_deinit(void) {
+    ready = false;
+    return ESP_OK;
+}
+
+esp_err_t config_manager_load(launcher_config_t *config) {
+    (void)config;
+    return ESP_ERR_NOT_FOUND;
+}
+
+esp_err_t config_manager_save(const launcher_config_t *config) {
+    return config ? ESP_OK : ESP_ERR_INVALID_ARG;
+}
+
+launcher_config_t* config_manager_get_current(void) {
+    if (!ready) {
+        config_manager_init();
+    }
+    return &current_config;
+}
+
+bool config_manager_is_ready(void) {
+    return ready;
+}
@@ -0,0 +1,129 @@
+#include "esp_partition.h"
+#include "esp_ota_ops.h"
+#include "esp_app_format.h"
+#include "esp_log.h"
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+static const char *TAG = "host_flash";
+
+// The partitions the launcher touches, as laid out in partitions.csv
+static const esp_partition_t partitions[] = {
+    { ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_DATA_NVS, 0x9000, 0x6000, 0x1000, "nvs", false },
+    { ESP_PARTITION_TYPE_APP, ESP_PARTITION_SUBTYPE_APP_FACTORY, 0x20000, 0x1E0000, 0x1000, "app0", false },
+    { ESP_PARTITION_TYPE_APP, ESP_PARTITION_SUBTYPE_APP_OTA_0, 0x200000, 0x800000, 0x1000, "app1", false },
+};
+#define PARTITION_COUNT (sizeof(partitions) / sizeof(partitions[0]))
+
+static uint8_t *contents[PARTITION_COUNT];
+static pthread_mutex_t flash_lock = PTHREAD_MUTEX_INITIALIZER;
+static const esp_partition_t *boot_partition = NULL;
+
+const esp_partition_t *esp_partition_find_first(esp_partition_type_t type, esp_partition_subtype_t subtype,
+                                                const char *label) {
+    for (size_t i = 0; i < PARTITION_COUNT; i++) {
+        const esp_partition_t *p = &partitions[i];
+        if ((type == ESP_PARTITION_TYPE_ANY || p->type == type) &&
+            (subtype == ESP_PARTITION_SUBTYPE_ANY || p->subtype == subtype) &&
+            (label == NULL || strcmp(p->label, label) == 0)) {
+            return p;
+        }
+    }
+    return NULL;
+}
+
+// Flash contents of a partition, allocated erased on first use; call with flash_lock held
+static uint8_t *partition_data(const esp_partition_t *partition) {
+    size_t index = (size_t)(partition - partitions);
+    if (index >= PARTITION_COUNT) {
+        return NULL;
+    }
+    if (!contents[index]) {
+        contents[index] = malloc(partition->size);
+        if (contents[index]) {
+            memset(contents[index], 0xFF, partition->size);
+        }
+    }
+    return contents[index];
+}
+
+static bool range_ok(const esp_partition_t *partition, size_t offset, size_t size) {
+    return partition && offset <= partition->size && size <= partition->size - offset;
+}
+
+esp_err_t esp_partition_read(const esp_partition_t *partition, size_t src_offset, void *dst, size_t size) {
+    if (!dst || !range_ok(partition, src_offset, size)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    pthread_mutex_lock(&flash_lock);
+    uint8_t *data = partition_data(partition);
+    if (data) {
+        memcpy(dst, data + src_offset, size);
+    }
+    pthread_mutex_unlock(&flash_lock);
+    return data ? ESP_OK : ESP_ERR_NO_MEM;
+}
+
+esp_err_t esp_partition_write(const esp_partition_t *partition, size_t dst_offset, const void *src, size_t size) {
+    if (!src || !range_ok(partition, dst_offset, size)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    pthread_mutex_lock(&flash_lock);
+    uint8_t *data = partition_data(partition);
+    if (data) {
+        const uint8_t *bytes = src;
+        for (size_t i = 0; i < size; i++) {
+            data[dst_offset + i] &= bytes[i];
+        }
+    }
+    pthread_mutex_unlock(&flash_lock);
+    return data ? ESP_OK : ESP_ERR_NO_MEM;
+}
+
+esp_err_t esp_partition_erase_range(const esp_partition_t *partition, size_t offset, size_t size) {
+    if (!range_ok(partition, offset, size)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (offset % partition->erase_size != 0 || size % partition->erase_size != 0) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    pthread_mutex_lock(&flash_lock);
+    uint8_t *data = partition_data(partition);
+    if (data) {
+        memset(data + offset, 0xFF, size);
+    }
+    pthread_mutex_unlock(&flash_lock);
+    return data ? ESP_OK : ESP_ERR_NO_MEM;
+}
+
+/* OTA */
+
+esp_err_t esp_ota_set_boot_partition(const esp_partition_t *partition) {
+    if (!partition || partition->type != ESP_PARTITION_TYPE_APP) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    ESP_LOGI(TAG, "Boot partition set to %s", partition->label);
+    boot_partition = partition;
+    return ESP_OK;
+}
+
+const esp_partition_t *esp_ota_get_boot_partition(void) {
+    return boot_partition ? boot_partition : esp_ota_get_running_partition();
+}
+
+const esp_partition_t *esp_ota_get_running_partition(void) {
+    return esp_partition_find_first(ESP_PARTITION_TYPE_APP, ESP_PARTITION_SUBTYPE_APP_FACTORY, NULL);
+}
+
+esp_err_t esp_ota_get_partition_description(const esp_partition_t *partition, esp_app_desc_t *app_desc) {
+    if (!partition || !app_desc || partition->type != ESP_PARTITION_TYPE_APP) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    esp_err_t ret = esp_partition_read(partition, sizeof(esp_image_header_t) + sizeof(esp_image_segment_header_t),
+                                       app_desc, sizeof(*app_desc));
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    return app_desc->magic_word == ESP_APP_DESC_MAGIC_WORD ? ESP_OK : ESP_ERR_NOT_FOUND;
+}
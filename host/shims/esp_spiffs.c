@@ -0,0 +1,45 @@
+#include "esp_spiffs.h"
+#include <errno.h>
+#include <stdio.h>
+#include <sys/stat.h>
+#include <sys/statvfs.h>
+
+static char base[256];
+static bool mounted = false;
+
+esp_err_t esp_vfs_spiffs_register(const esp_vfs_spiffs_conf_t *conf) {
+    if (mounted) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (mkdir(conf->base_path, 0755) != 0 && errno != EEXIST) {
+        return ESP_FAIL;
+    }
+    snprintf(base, sizeof(base), "%s", conf->base_path);
+    mounted = true;
+    return ESP_OK;
+}
+
+esp_err_t esp_vfs_spiffs_unregister(const char *partition_label) {
+    (void)partition_label;
+    if (!mounted) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    mounted = false;
+    return ESP_OK;
+}
+
+bool esp_spiffs_mounted(const char *partition_label) {
+    (void)partition_label;
+    return mounted;
+}
+
+esp_err_t esp_spiffs_info(const char *partition_label, size_t *total_bytes, size_t *used_bytes) {
+    (void)partition_label;
+    struct statvfs fs;
+    if (!mounted || statvfs(base, &fs) != 0) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    *total_bytes = (size_t)fs.f_blocks * fs.f_frsize;
+    *used_bytes = (size_t)(fs.f_blocks - fs.f_bfree) * fs.f_frsize;
+    return ESP_OK;
+}
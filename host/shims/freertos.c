@@ -0,0 +1,446 @@
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+#include "freertos/event_groups.h"
+#include <errno.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/*
+ * Every blocking object is a mutex plus one condition variable on
+ * CLOCK_MONOTONIC. Waiters re-check their condition after each wakeup,
+ * so broadcasting on every state change keeps the code short without
+ * losing wakeups.
+ */
+
+typedef struct {
+    pthread_mutex_t lock;
+    pthread_cond_t changed;
+} host_sync_t;
+
+static void sync_init(host_sync_t *sync) {
+    pthread_condattr_t attr;
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(&sync->changed, &attr);
+    pthread_condattr_destroy(&attr);
+    pthread_mutex_init(&sync->lock, NULL);
+}
+
+static void sync_destroy(host_sync_t *sync) {
+    pthread_cond_destroy(&sync->changed);
+    pthread_mutex_destroy(&sync->lock);
+}
+
+static struct timespec deadline_after(TickType_t ticks) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    ts.tv_sec += ticks / 1000;
+    ts.tv_nsec += (long)(ticks % 1000) * 1000000L;
+    if (ts.tv_nsec >= 1000000000L) {
+        ts.tv_sec++;
+        ts.tv_nsec -= 1000000000L;
+    }
+    return ts;
+}
+
+// Called with sync->lock held; false once the deadline has passed
+static bool sync_wait(host_sync_t *sync, TickType_t ticks, const struct timespec *deadline) {
+    if (ticks == 0) {
+        return false;
+    }
+    if (ticks == portMAX_DELAY) {
+        pthread_cond_wait(&sync->changed, &sync->lock);
+        return true;
+    }
+    return pthread_cond_timedwait(&sync->changed, &sync->lock, deadline) != ETIMEDOUT;
+}
+
+/* Critical sections */
+
+static pthread_mutex_t critical_lock;
+static pthread_once_t critical_once = PTHREAD_ONCE_INIT;
+
+static void critical_init(void) {
+    pthread_mutexattr_t attr;
+    pthread_mutexattr_init(&attr);
+    pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE);
+    pthread_mutex_init(&critical_lock, &attr);
+    pthread_mutexattr_destroy(&attr);
+}
+
+void host_enter_critical(portMUX_TYPE *mux) {
+    (void)mux;
+    pthread_once(&critical_once, critical_init);
+    pthread_mutex_lock(&critical_lock);
+}
+
+void host_exit_critical(portMUX_TYPE *mux) {
+    (void)mux;
+    pthread_mutex_unlock(&critical_lock);
+}
+
+/* Tasks */
+
+struct host_task {
+    host_sync_t sync;
+    uint32_t notify;
+    TaskFunction_t fn;
+    void *arg;
+    char name[16];
+};
+
+static __thread struct host_task *current_task;
+
+static struct host_task *task_new(void) {
+    struct host_task *task = calloc(1, sizeof(*task));
+    if (task) {
+        sync_init(&task->sync);
+    }
+    return task;
+}
+
+static void *task_entry(void *arg) {
+    struct host_task *task = arg;
+    current_task = task;
+    task->fn(task->arg);
+    // Tasks must end with vTaskDelete(NULL); returning is a bug on the device too
+    fprintf(stderr, "Task %s returned without deleting itself\n", task->name);
+    abort();
+}
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t fn, const char *name, uint32_t stack_depth, void *arg,
+                                   UBaseType_t priority, TaskHandle_t *handle_out, BaseType_t core) {
+    (void)stack_depth;
+    (void)priority;
+    (void)core;
+    struct host_task *task = task_new();
+    if (!task) {
+        return pdFAIL;
+    }
+    task->fn = fn;
+    task->arg = arg;
+    snprintf(task->name, sizeof(task->name), "%s", name ? name : "");
+
+    pthread_attr_t attr;
+    pthread_attr_init(&attr);
+    pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+    pthread_t thread;
+    // The handle is published before the task runs, as xTaskCreate() does
+    if (handle_out) {
+        *handle_out = task;
+    }
+    int err = pthread_create(&thread, &attr, task_entry, task);
+    pthread_attr_destroy(&attr);
+    if (err != 0) {
+        if (handle_out) {
+            *handle_out = NULL;
+        }
+        sync_destroy(&task->sync);
+        free(task);
+        return pdFAIL;
+    }
+    return pdPASS;
+}
+
+void vTaskDelete(TaskHandle_t task) {
+    if (task && task != current_task) {
+        fprintf(stderr, "vTaskDelete of another task is not supported on the host\n");
+        abort();
+    }
+    // The handle stays allocated: other tasks may still notify it while this one exits
+    pthread_exit(NULL);
+}
+
+void vTaskDelay(TickType_t ticks) {
+    struct timespec ts = {
+        .tv_sec = ticks / 1000,
+        .tv_nsec = (long)(ticks % 1000) * 1000000L,
+    };
+    while (nanosleep(&ts, &ts) != 0 && errno == EINTR) {
+    }
+}
+
+TickType_t xTaskGetTickCount(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (TickType_t)((uint64_t)ts.tv_sec * 1000u + (uint64_t)ts.tv_nsec / 1000000u);
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle(void) {
+    // The main thread gets a handle the first time it asks, so it can be notified too
+    if (!current_task) {
+        current_task = task_new();
+        if (current_task) {
+            snprintf(current_task->name, sizeof(current_task->name), "main");
+        }
+    }
+    return current_task;
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t clear_on_exit, TickType_t ticks_to_wait) {
+    struct host_task *task = xTaskGetCurrentTaskHandle();
+    struct timespec deadline = deadline_after(ticks_to_wait);
+
+    pthread_mutex_lock(&task->sync.lock);
+    while (task->notify == 0 && sync_wait(&task->sync, ticks_to_wait, &deadline)) {
+    }
+    uint32_t value = task->notify;
+    if (value > 0) {
+        task->notify = clear_on_exit ? 0 : value - 1;
+    }
+    pthread_mutex_unlock(&task->sync.lock);
+    return value;
+}
+
+BaseType_t xTaskNotifyGive(TaskHandle_t task) {
+    pthread_mutex_lock(&task->sync.lock);
+    task->notify++;
+    pthread_cond_broadcast(&task->sync.changed);
+    pthread_mutex_unlock(&task->sync.lock);
+    return pdPASS;
+}
+
+/* Queues */
+
+struct host_queue {
+    host_sync_t sync;
+    UBaseType_t length;
+    UBaseType_t item_size;
+    UBaseType_t head;
+    UBaseType_t count;
+    uint8_t *items;
+};
+
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t item_size) {
+    struct host_queue *queue = calloc(1, sizeof(*queue));
+    if (!queue) {
+        return NULL;
+    }
+    queue->items = malloc((size_t)length * (item_size ? item_size : 1));
+    if (!queue->items) {
+        free(queue);
+        return NULL;
+    }
+    queue->length = length;
+    queue->item_size = item_size;
+    sync_init(&queue->sync);
+    return queue;
+}
+
+void vQueueDelete(QueueHandle_t queue) {
+    if (!queue) {
+        return;
+    }
+    sync_destroy(&queue->sync);
+    free(queue->items);
+    free(queue);
+}
+
+static BaseType_t queue_send(QueueHandle_t queue, const void *item, TickType_t ticks_to_wait, bool front) {
+    struct timespec deadline = deadline_after(ticks_to_wait);
+
+    pthread_mutex_lock(&queue->sync.lock);
+    while (queue->count == queue->length && sync_wait(&queue->sync, ticks_to_wait, &deadline)) {
+    }
+    BaseType_t ret = errQUEUE_FULL;
+    if (queue->count < queue->length) {
+        UBaseType_t slot;
+        if (front) {
+            queue->head = (queue->head + queue->length - 1) % queue->length;
+            slot = queue->head;
+        } else {
+            slot = (queue->head + queue->count) % queue->length;
+        }
+        memcpy(queue->items + (size_t)slot * queue->item_size, item, queue->item_size);
+        queue->count++;
+        pthread_cond_broadcast(&queue->sync.changed);
+        ret = pdPASS;
+    }
+    pthread_mutex_unlock(&queue->sync.lock);
+    return ret;
+}
+
+BaseType_t xQueueSendToBack(QueueHandle_t queue, const void *item, TickType_t ticks_to_wait) {
+    return queue_send(queue, item, ticks_to_wait, false);
+}
+
+BaseType_t xQueueSendToFront(QueueHandle_t queue, const void *item, TickType_t ticks_to_wait) {
+    return queue_send(queue, item, ticks_to_wait, true);
+}
+
+static BaseType_t queue_receive(QueueHandle_t queue, void *item, TickType_t ticks_to_wait, bool remove) {
+    struct timespec deadline = deadline_after(ticks_to_wait);
+
+    pthread_mutex_lock(&queue->sync.lock);
+    while (queue->count == 0 && sync_wait(&queue->sync, ticks_to_wait, &deadline)) {
+    }
+    BaseType_t ret = errQUEUE_EMPTY;
+    if (queue->count > 0) {
+        memcpy(item, queue->items + (size_t)queue->head * queue->item_size, queue->item_size);
+        if (remove) {
+            queue->head = (queue->head + 1) % queue->length;
+            queue->count--;
+            pthread_cond_broadcast(&queue->sync.changed);
+        }
+        ret = pdPASS;
+    }
+    pthread_mutex_unlock(&queue->sync.lock);
+    return ret;
+}
+
+BaseType_t xQueueReceive(QueueHandle_t queue, void *item, TickType_t ticks_to_wait) {
+    return queue_receive(queue, item, ticks_to_wait, true);
+}
+
+BaseType_t xQueuePeek(QueueHandle_t queue, void *item, TickType_t ticks_to_wait) {
+    return queue_receive(queue, item, ticks_to_wait, false);
+}
+
+BaseType_t xQueueReset(QueueHandle_t queue) {
+    pthread_mutex_lock(&queue->sync.lock);
+    queue->head = 0;
+    queue->count = 0;
+    pthread_cond_broadcast(&queue->sync.changed);
+    pthread_mutex_unlock(&queue->sync.lock);
+    return pdPASS;
+}
+
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t queue) {
+    pthread_mutex_lock(&queue->sync.lock);
+    UBaseType_t count = queue->count;
+    pthread_mutex_unlock(&queue->sync.lock);
+    return count;
+}
+
+/* Semaphores */
+
+struct host_semaphore {
+    host_sync_t sync;
+    UBaseType_t count;
+    UBaseType_t max_count;
+};
+
+SemaphoreHandle_t xSemaphoreCreateCounting(UBaseType_t max_count, UBaseType_t initial_count) {
+    struct host_semaphore *semaphore = calloc(1, sizeof(*semaphore));
+    if (!semaphore) {
+        return NULL;
+    }
+    semaphore->count = initial_count;
+    semaphore->max_count = max_count;
+    sync_init(&semaphore->sync);
+    return semaphore;
+}
+
+void vSemaphoreDelete(SemaphoreHandle_t semaphore) {
+    if (!semaphore) {
+        return;
+    }
+    sync_destroy(&semaphore->sync);
+    free(semaphore);
+}
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t semaphore, TickType_t ticks_to_wait) {
+    struct timespec deadline = deadline_after(ticks_to_wait);
+
+    pthread_mutex_lock(&semaphore->sync.lock);
+    while (semaphore->count == 0 && sync_wait(&semaphore->sync, ticks_to_wait, &deadline)) {
+    }
+    BaseType_t ret = pdFALSE;
+    if (semaphore->count > 0) {
+        semaphore->count--;
+        ret = pdTRUE;
+    }
+    pthread_mutex_unlock(&semaphore->sync.lock);
+    return ret;
+}
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t semaphore) {
+    pthread_mutex_lock(&semaphore->sync.lock);
+    BaseType_t ret = pdFALSE;
+    if (semaphore->count < semaphore->max_count) {
+        semaphore->count++;
+        pthread_cond_broadcast(&semaphore->sync.changed);
+        ret = pdTRUE;
+    }
+    pthread_mutex_unlock(&semaphore->sync.lock);
+    return ret;
+}
+
+UBaseType_t uxSemaphoreGetCount(SemaphoreHandle_t semaphore) {
+    pthread_mutex_lock(&semaphore->sync.lock);
+    UBaseType_t count = semaphore->count;
+    pthread_mutex_unlock(&semaphore->sync.lock);
+    return count;
+}
+
+/* Event groups */
+
+struct host_event_group {
+    host_sync_t sync;
+    EventBits_t bits;
+};
+
+EventGroupHandle_t xEventGroupCreate(void) {
+    struct host_event_group *group = calloc(1, sizeof(*group));
+    if (group) {
+        sync_init(&group->sync);
+    }
+    return group;
+}
+
+void vEventGroupDelete(EventGroupHandle_t group) {
+    if (!group) {
+        return;
+    }
+    sync_destroy(&group->sync);
+    free(group);
+}
+
+EventBits_t xEventGroupSetBits(EventGroupHandle_t group, EventBits_t bits) {
+    pthread_mutex_lock(&group->sync.lock);
+    group->bits |= bits;
+    EventBits_t now = group->bits;
+    pthread_cond_broadcast(&group->sync.changed);
+    pthread_mutex_unlock(&group->sync.lock);
+    return now;
+}
+
+EventBits_t xEventGroupClearBits(EventGroupHandle_t group, EventBits_t bits) {
+    pthread_mutex_lock(&group->sync.lock);
+    EventBits_t before = group->bits;
+    group->bits &= ~bits;
+    pthread_mutex_unlock(&group->sync.lock);
+    return before;
+}
+
+EventBits_t xEventGroupGetBits(EventGroupHandle_t group) {
+    pthread_mutex_lock(&group->sync.lock);
+    EventBits_t now = group->bits;
+    pthread_mutex_unlock(&group->sync.lock);
+    return now;
+}
+
+static bool bits_satisfied(EventBits_t have, EventBits_t want, BaseType_t wait_for_all) {
+    return wait_for_all ? (have & want) == want : (have & want) != 0;
+}
+
+EventBits_t xEventGroupWaitBits(EventGroupHandle_t group, EventBits_t bits, BaseType_t clear_on_exit,
+                                BaseType_t wait_for_all, TickType_t ticks_to_wait) {
+    struct timespec deadline = deadline_after(ticks_to_wait);
+
+    pthread_mutex_lock(&group->sync.lock);
+    while (!bits_satisfied(group->bits, bits, wait_for_all) &&
+           sync_wait(&group->sync, ticks_to_wait, &deadline)) {
+    }
+    EventBits_t now = group->bits;
+    if (clear_on_exit && bits_satisfied(now, bits, wait_for_all)) {
+        group->bits &= ~bits;
+    }
+    pthread_mutex_unlock(&group->sync.lock);
+    return now;
+}
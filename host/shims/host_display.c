@@ -0,0 +1,202 @@
+#include "hal.h"
+#include "hal_rotate.h"
+#include "host_display.h"
+#include "render_stats.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_heap_caps.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static const char *TAG = "HOST_DISPLAY";
+
+lv_display_t *lvDisp = NULL;
+lv_indev_t *lvTouchpad = NULL;
+
+// Same buffers as the device: one partial draw buffer, the rotation target and the panel memory
+static uint8_t *draw_buf = NULL;
+static uint8_t *rotate_buf = NULL;
+static uint16_t *panel_fb = NULL;
+
+static pthread_mutex_t lvgl_mutex;
+static int backlight_percent = 0;
+
+static struct {
+    int32_t x;
+    int32_t y;
+    bool pressed;
+} touch;
+
+static uint32_t tick_get_cb(void)
+{
+    return (uint32_t)(esp_timer_get_time() / 1000);
+}
+
+// Screen point to panel point, the inverse of what LVGL applies to pointer input
+static void screen_to_panel(int32_t sx, int32_t sy, int32_t *px, int32_t *py)
+{
+    switch (lv_display_get_rotation(lvDisp)) {
+        case LV_DISPLAY_ROTATION_90:
+            *px = sy;
+            *py = BSP_LCD_V_RES - 1 - sx;
+            break;
+        case LV_DISPLAY_ROTATION_180:
+            *px = BSP_LCD_H_RES - 1 - sx;
+            *py = BSP_LCD_V_RES - 1 - sy;
+            break;
+        case LV_DISPLAY_ROTATION_270:
+            *px = BSP_LCD_H_RES - 1 - sy;
+            *py = sx;
+            break;
+        default:
+            *px = sx;
+            *py = sy;
+            break;
+    }
+}
+
+static void touch_read_cb(lv_indev_t *indev, lv_indev_data_t *data)
+{
+    (void)indev;
+    if (!touch.pressed) {
+        data->state = LV_INDEV_STATE_REL;
+        return;
+    }
+    // The GT911 reports panel coordinates
+    int32_t px, py;
+    screen_to_panel(touch.x, touch.y, &px, &py);
+    data->state = LV_INDEV_STATE_PR;
+    data->point.x = px;
+    data->point.y = py;
+}
+
+// hal_flush_cb() with a memcpy into panel memory in place of the DSI transfer
+static void host_flush_cb(lv_display_t *disp, const lv_area_t *area, uint8_t *px_map)
+{
+    lv_display_rotation_t rotation = lv_display_get_rotation(disp);
+    lv_area_t panel_area = *area;
+    uint8_t *color_map = px_map;
+    lv_color_format_t cf = lv_display_get_color_format(disp);
+    int32_t w = lv_area_get_width(area);
+    int32_t h = lv_area_get_height(area);
+    int32_t row_bytes = w * lv_color_format_get_size(cf);
+
+    if (rotation != LV_DISPLAY_ROTATION_0) {
+        int32_t src_stride = lv_draw_buf_width_to_stride(w, cf);
+        int32_t dst_w = (rotation == LV_DISPLAY_ROTATION_180) ? w : h;
+        int32_t dst_stride = dst_w * lv_color_format_get_size(cf);
+
+        if (!hal_rotate(px_map, rotate_buf, w, h, src_stride, dst_stride, rotation, cf)) {
+            lv_draw_sw_rotate(px_map, rotate_buf, w, h, src_stride, dst_stride, rotation, cf);
+        }
+        color_map = rotate_buf;
+        row_bytes = dst_stride;
+        lv_display_rotate_area(disp, &panel_area);
+    }
+
+    int32_t panel_w = lv_area_get_width(&panel_area);
+    for (int32_t y = panel_area.y1; y <= panel_area.y2; y++) {
+        memcpy(&panel_fb[y * BSP_LCD_H_RES + panel_area.x1],
+               color_map + (size_t)(y - panel_area.y1) * row_bytes, panel_w * sizeof(uint16_t));
+    }
+    lv_display_flush_ready(disp);
+}
+
+void hal_init(void)
+{
+    pthread_mutexattr_t attr;
+    pthread_mutexattr_init(&attr);
+    pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE);
+    pthread_mutex_init(&lvgl_mutex, &attr);
+    pthread_mutexattr_destroy(&attr);
+
+    lv_init();
+    lv_tick_set_cb(tick_get_cb);
+
+    size_t buf_bytes = BSP_LCD_DRAW_BUFF_SIZE * sizeof(uint16_t);
+    draw_buf = heap_caps_aligned_alloc(HAL_ROTATE_CACHE_LINE, buf_bytes, MALLOC_CAP_SPIRAM);
+    rotate_buf = heap_caps_aligned_alloc(HAL_ROTATE_CACHE_LINE, buf_bytes, MALLOC_CAP_SPIRAM);
+    panel_fb = heap_caps_calloc(BSP_LCD_H_RES * BSP_LCD_V_RES, sizeof(uint16_t), MALLOC_CAP_SPIRAM);
+    if (!draw_buf || !rotate_buf || !panel_fb) {
+        ESP_LOGE(TAG, "Failed to allocate display buffers");
+        abort();
+    }
+
+    lvDisp = lv_display_create(BSP_LCD_H_RES, BSP_LCD_V_RES);
+    lv_display_set_color_format(lvDisp, LV_COLOR_FORMAT_RGB565);
+    lv_display_set_buffers(lvDisp, draw_buf, NULL, buf_bytes, LV_DISPLAY_RENDER_MODE_PARTIAL);
+    lv_display_set_flush_cb(lvDisp, host_flush_cb);
+    lv_display_set_rotation(lvDisp, LV_DISPLAY_ROTATION_90);
+    render_stats_attach(lvDisp);
+    bsp_display_backlight_on();
+}
+
+void hal_touchpad_init(void)
+{
+    lvTouchpad = lv_indev_create();
+    lv_indev_set_type(lvTouchpad, LV_INDEV_TYPE_POINTER);
+    lv_indev_set_read_cb(lvTouchpad, touch_read_cb);
+    lv_indev_set_display(lvTouchpad, lvDisp);
+}
+
+void host_display_touch(int32_t x, int32_t y, bool pressed)
+{
+    touch.x = x;
+    touch.y = y;
+    touch.pressed = pressed;
+}
+
+esp_err_t host_display_save_ppm(const char *path)
+{
+    FILE *f = fopen(path, "wb");
+    if (!f) {
+        return ESP_FAIL;
+    }
+    int32_t w = lv_display_get_horizontal_resolution(lvDisp);
+    int32_t h = lv_display_get_vertical_resolution(lvDisp);
+    fprintf(f, "P6\n%d %d\n255\n", (int)w, (int)h);
+    for (int32_t y = 0; y < h; y++) {
+        for (int32_t x = 0; x < w; x++) {
+            int32_t px, py;
+            screen_to_panel(x, y, &px, &py);
+            uint16_t c = panel_fb[py * BSP_LCD_H_RES + px];
+            uint8_t rgb[3] = {
+                (uint8_t)(((c >> 11) & 0x1F) * 255 / 31),
+                (uint8_t)(((c >> 5) & 0x3F) * 255 / 63),
+                (uint8_t)((c & 0x1F) * 255 / 31),
+            };
+            fwrite(rgb, 1, sizeof(rgb), f);
+        }
+    }
+    return fclose(f) == 0 ? ESP_OK : ESP_FAIL;
+}
+
+/* BSP display functions used by the screens */
+
+bool bsp_display_lock(uint32_t timeout_ms)
+{
+    (void)timeout_ms;
+    return pthread_mutex_lock(&lvgl_mutex) == 0;
+}
+
+void bsp_display_unlock(void)
+{
+    pthread_mutex_unlock(&lvgl_mutex);
+}
+
+esp_err_t bsp_display_brightness_set(int brightness_percent)
+{
+    if (brightness_percent < 0 || brightness_percent > 100) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    backlight_percent = brightness_percent;
+    ESP_LOGI(TAG, "Backlight %d%%", backlight_percent);
+    return ESP_OK;
+}
+
+esp_err_t bsp_display_backlight_on(void)
+{
+    return bsp_display_brightness_set(100);
+}
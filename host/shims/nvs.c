@@ -0,0 +1,235 @@
+#include "nvs.h"
+#include "nvs_flash.h"
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*
+ * Entries live in one list keyed on (namespace, key). A handle is the
+ * index of its namespace in the namespace table plus one, with the top
+ * bit set for read-only handles.
+ */
+#define NVS_MAX_NAMESPACES  16
+#define NVS_NAME_LEN        16
+#define NVS_READONLY_BIT    0x80000000u
+
+typedef enum {
+    NVS_ENTRY_STR,
+    NVS_ENTRY_BLOB,
+} nvs_entry_kind_t;
+
+typedef struct nvs_entry {
+    struct nvs_entry *next;
+    uint32_t ns;
+    nvs_entry_kind_t kind;
+    char key[NVS_NAME_LEN];
+    size_t length;
+    uint8_t value[];
+} nvs_entry_t;
+
+static pthread_mutex_t nvs_lock = PTHREAD_MUTEX_INITIALIZER;
+static bool nvs_ready = false;
+static char namespaces[NVS_MAX_NAMESPACES][NVS_NAME_LEN];
+static uint32_t namespace_count = 0;
+static nvs_entry_t *entries = NULL;
+
+esp_err_t nvs_flash_init(void) {
+    pthread_mutex_lock(&nvs_lock);
+    nvs_ready = true;
+    pthread_mutex_unlock(&nvs_lock);
+    return ESP_OK;
+}
+
+esp_err_t nvs_flash_erase(void) {
+    pthread_mutex_lock(&nvs_lock);
+    while (entries) {
+        nvs_entry_t *next = entries->next;
+        free(entries);
+        entries = next;
+    }
+    pthread_mutex_unlock(&nvs_lock);
+    return ESP_OK;
+}
+
+esp_err_t nvs_open(const char *namespace_name, nvs_open_mode_t open_mode, nvs_handle_t *out_handle) {
+    if (!namespace_name || !out_handle || strlen(namespace_name) >= NVS_NAME_LEN) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    esp_err_t ret = ESP_OK;
+    pthread_mutex_lock(&nvs_lock);
+    uint32_t ns = 0;
+    while (ns < namespace_count && strcmp(namespaces[ns], namespace_name) != 0) {
+        ns++;
+    }
+    if (!nvs_ready) {
+        ret = ESP_ERR_NVS_NOT_INITIALIZED;
+    } else if (ns == namespace_count) {
+        // Like the IDF, a read-only open does not create the namespace
+        if (open_mode == NVS_READONLY) {
+            ret = ESP_ERR_NVS_NOT_FOUND;
+        } else if (namespace_count == NVS_MAX_NAMESPACES) {
+            ret = ESP_ERR_NVS_NO_FREE_PAGES;
+        } else {
+            strcpy(namespaces[namespace_count++], namespace_name);
+        }
+    }
+    pthread_mutex_unlock(&nvs_lock);
+    if (ret == ESP_OK) {
+        *out_handle = (ns + 1) | (open_mode == NVS_READONLY ? NVS_READONLY_BIT : 0);
+    }
+    return ret;
+}
+
+void nvs_close(nvs_handle_t handle) {
+    (void)handle;
+}
+
+esp_err_t nvs_commit(nvs_handle_t handle) {
+    (void)handle;
+    return ESP_OK;
+}
+
+// Namespace index of a handle, or -1; call with nvs_lock held
+static int32_t handle_namespace(nvs_handle_t handle) {
+    uint32_t ns = (handle & ~NVS_READONLY_BIT);
+    return (ns == 0 || ns > namespace_count) ? -1 : (int32_t)(ns - 1);
+}
+
+static nvs_entry_t **find_entry(uint32_t ns, const char *key) {
+    nvs_entry_t **link = &entries;
+    while (*link && ((*link)->ns != ns || strcmp((*link)->key, key) != 0)) {
+        link = &(*link)->next;
+    }
+    return link;
+}
+
+static esp_err_t set_entry(nvs_handle_t handle, const char *key, nvs_entry_kind_t kind,
+                           const void *value, size_t length) {
+    if (!key || !value || strlen(key) >= NVS_NAME_LEN) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (handle & NVS_READONLY_BIT) {
+        return ESP_ERR_NVS_READ_ONLY;
+    }
+    nvs_entry_t *entry = malloc(sizeof(*entry) + length);
+    if (!entry) {
+        return ESP_ERR_NO_MEM;
+    }
+    entry->kind = kind;
+    strcpy(entry->key, key);
+    entry->length = length;
+    memcpy(entry->value, value, length);
+
+    esp_err_t ret = ESP_OK;
+    pthread_mutex_lock(&nvs_lock);
+    int32_t ns = handle_namespace(handle);
+    if (ns < 0) {
+        ret = ESP_ERR_NVS_INVALID_HANDLE;
+        free(entry);
+    } else {
+        entry->ns = (uint32_t)ns;
+        nvs_entry_t **link = find_entry((uint32_t)ns, key);
+        if (*link) {
+            entry->next = (*link)->next;
+            free(*link);
+        } else {
+            entry->next = NULL;
+        }
+        *link = entry;
+    }
+    pthread_mutex_unlock(&nvs_lock);
+    return ret;
+}
+
+// Same contract as the IDF getters: a NULL buffer asks for the length
+static esp_err_t get_entry(nvs_handle_t handle, const char *key, nvs_entry_kind_t kind,
+                           void *out_value, size_t *length) {
+    if (!key || !length) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    esp_err_t ret = ESP_OK;
+    pthread_mutex_lock(&nvs_lock);
+    int32_t ns = handle_namespace(handle);
+    nvs_entry_t *entry = ns < 0 ? NULL : *find_entry((uint32_t)ns, key);
+    if (ns < 0) {
+        ret = ESP_ERR_NVS_INVALID_HANDLE;
+    } else if (!entry || entry->kind != kind) {
+        ret = ESP_ERR_NVS_NOT_FOUND;
+    } else if (!out_value) {
+        *length = entry->length;
+    } else if (*length < entry->length) {
+        *length = entry->length;
+        ret = ESP_ERR_NVS_INVALID_LENGTH;
+    } else {
+        memcpy(out_value, entry->value, entry->length);
+        *length = entry->length;
+    }
+    pthread_mutex_unlock(&nvs_lock);
+    return ret;
+}
+
+esp_err_t nvs_set_str(nvs_handle_t handle, const char *key, const char *value) {
+    return set_entry(handle, key, NVS_ENTRY_STR, value, value ? strlen(value) + 1 : 0);
+}
+
+esp_err_t nvs_get_str(nvs_handle_t handle, const char *key, char *out_value, size_t *length) {
+    return get_entry(handle, key, NVS_ENTRY_STR, out_value, length);
+}
+
+esp_err_t nvs_set_blob(nvs_handle_t handle, const char *key, const void *value, size_t length) {
+    return set_entry(handle, key, NVS_ENTRY_BLOB, value, length);
+}
+
+esp_err_t nvs_get_blob(nvs_handle_t handle, const char *key, void *out_value, size_t *length) {
+    return get_entry(handle, key, NVS_ENTRY_BLOB, out_value, length);
+}
+
+esp_err_t nvs_erase_key(nvs_handle_t handle, const char *key) {
+    if (!key) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (handle & NVS_READONLY_BIT) {
+        return ESP_ERR_NVS_READ_ONLY;
+    }
+    esp_err_t ret = ESP_OK;
+    pthread_mutex_lock(&nvs_lock);
+    int32_t ns = handle_namespace(handle);
+    nvs_entry_t **link = ns < 0 ? NULL : find_entry((uint32_t)ns, key);
+    if (ns < 0) {
+        ret = ESP_ERR_NVS_INVALID_HANDLE;
+    } else if (!*link) {
+        ret = ESP_ERR_NVS_NOT_FOUND;
+    } else {
+        nvs_entry_t *entry = *link;
+        *link = entry->next;
+        free(entry);
+    }
+    pthread_mutex_unlock(&nvs_lock);
+    return ret;
+}
+
+esp_err_t nvs_erase_all(nvs_handle_t handle) {
+    if (handle & NVS_READONLY_BIT) {
+        return ESP_ERR_NVS_READ_ONLY;
+    }
+    esp_err_t ret = ESP_OK;
+    pthread_mutex_lock(&nvs_lock);
+    int32_t ns = handle_namespace(handle);
+    if (ns < 0) {
+        ret = ESP_ERR_NVS_INVALID_HANDLE;
+    } else {
+        nvs_entry_t **link = &entries;
+        while (*link) {
+            if ((*link)->ns == (uint32_t)ns) {
+                nvs_entry_t *entry = *link;
+                *link = entry->next;
+                free(entry);
+            } else {
+                link = &(*link)->next;
+            }
+        }
+    }
+    pthread_mutex_unlock(&nvs_lock);
+    return ret;
+}
@@ -0,0 +1,39 @@
+#include "thumbnail_decode.h"
+#include <string.h>
+#include <strings.h>
+
+/*
+ * The decoders need LVGL's TJpgDec and the ROM miniz, neither of which the
+ * host build links. Formats are still recognised so the indexer queues the
+ * same work as on the device; every decode reports ESP_ERR_NOT_SUPPORTED,
+ * which the thumbnail worker already handles as an image it cannot show.
+ */
+thumbnail_format_t thumbnail_decode_format(const char *name) {
+    const char *dot = name ? strrchr(name, '.') : NULL;
+    if (!dot) {
+        return THUMBNAIL_FORMAT_NONE;
+    }
+    if (strcasecmp(dot, ".jpg") == 0 || strcasecmp(dot, ".jpeg") == 0) {
+        return THUMBNAIL_FORMAT_JPEG;
+    }
+    if (strcasecmp(dot, ".png") == 0) {
+        return THUMBNAIL_FORMAT_PNG;
+    }
+    if (strcasecmp(dot, ".bmp") == 0) {
+        return THUMBNAIL_FORMAT_BMP;
+    }
+    return THUMBNAIL_FORMAT_NONE;
+}
+
+esp_err_t thumbnail_decode(const char *full_path, thumbnail_format_t format, uint16_t max_size,
+                           uint16_t *pixels, uint16_t *width, uint16_t *height,
+                           thumbnail_abort_cb_t abort_cb) {
+    (void)full_path;
+    (void)format;
+    (void)max_size;
+    (void)pixels;
+    (void)abort_cb;
+    *width = 0;
+    *height = 0;
+    return ESP_ERR_NOT_SUPPORTED;
+}
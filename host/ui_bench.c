@@ -0,0 +1,485 @@
+#include "hal.h"
+#include "host_display.h"
+#include "config_manager.h"
+#include "sd_manager.h"
+#include "firmware_loader.h"
+#include "power_monitor.h"
+#include "render_stats.h"
+#include "gui_manager.h"
+#include "gui_screens.h"
+#include "gui_state.h"
+#include "gui_screen_tools.h"
+#include "gui_screen_search.h"
+#include "gui_screen_disk_usage.h"
+#include "gui_screen_sd_bench.h"
+#include "gui_screen_diagnostics.h"
+#include "gui_screen_text_editor.h"
+#include "gui_screen_calculator.h"
+#include "gui_screen_python_launcher.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include <errno.h>
+#include <inttypes.h>
+#include <malloc.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+/*
+ * Scripted benchmark of the real LVGL screens on the Linux host.
+ *
+ *   ui_bench [-v] [-c results.csv] script.txt
+ *
+ * The launcher starts as in app_main() on a headless 1280x720 display
+ * (shims/host_display.c) and runs the same main loop. Each script line is
+ * one step; coordinates are screen coordinates:
+ *
+ *   tap <text>                      Press and release the first visible
+ *                                   label containing text, then settle;
+ *                                   LV_SYMBOL_LEFT and the other symbols in
+ *                                   symbol_names stand for their glyphs
+ *   tapxy <x> <y>                   Same at a screen point
+ *   drag <x1> <y1> <x2> <y2> <ms>   Press, move in a straight line, release,
+ *                                   then settle
+ *   wait <ms>                       Run the main loop
+ *   settle                          Run until no frame rendered for
+ *                                   SETTLE_QUIET_MS
+ *   mkfiles <dir> <count>           Create empty files for the browser
+ *   shot <file.ppm>                 Save the screen
+ *
+ * Every step reports the frames it rendered from render_stats (average and
+ * worst frame time, worst flush), the LVGL pool and host heap in use with
+ * their peaks, and the screen it ended on. At the end the frames are
+ * summed per screen: each lv_timer_handler() run renders at most one
+ * frame, which is booked to the screen active when it rendered.
+ */
+
+#define LINE_MAX_LEN        512
+#define LOOP_DELAY_MS       10      // As in the app_main() loop
+#define POWER_UPDATE_MS     1000
+#define PRESS_HOLD_MS       100     // Longer than three touch reads
+#define SETTLE_QUIET_MS     250
+#define SETTLE_MAX_MS       5000
+
+typedef struct {
+    uint32_t frames;
+    uint64_t total_frame_us;
+    uint32_t max_frame_us;
+    uint32_t max_flush_us;
+    size_t lvgl_peak;
+    size_t heap_peak;
+    uint32_t max_objects;
+} frame_totals_t;
+
+typedef struct {
+    char step[96];
+    bool ok;
+    int64_t us;
+    frame_totals_t frames;
+    size_t lvgl_used;
+    size_t heap;
+    uint32_t objects;
+    const char *screen;
+} step_result_t;
+
+static struct {
+    const char *name;
+    lv_obj_t **screen;
+    frame_totals_t totals;
+} screens[] = {
+    { "main", &main_screen },
+    { "file_manager", &file_manager_screen },
+    { "firmware", &firmware_loader_screen },
+    { "progress", &progress_screen },
+    { "splash", &splash_screen },
+    { "settings", &settings_screen },
+    { "tools", &tools_screen },
+    { "search", &search_screen },
+    { "disk_usage", &disk_usage_screen },
+    { "sd_bench", &sd_bench_screen },
+    { "diagnostics", &diagnostics_screen },
+    { "text_editor", &text_editor_screen },
+    { "calculator", &calculator_screen },
+    { "python", &python_launcher_screen },
+    { "other", NULL },
+};
+#define SCREEN_COUNT (sizeof(screens) / sizeof(screens[0]))
+
+// Symbols that label buttons on their own, for tap
+static const struct {
+    const char *name;
+    const char *text;
+} symbol_names[] = {
+    { "LV_SYMBOL_LEFT", LV_SYMBOL_LEFT },
+    { "LV_SYMBOL_RIGHT", LV_SYMBOL_RIGHT },
+    { "LV_SYMBOL_UP", LV_SYMBOL_UP },
+    { "LV_SYMBOL_CLOSE", LV_SYMBOL_CLOSE },
+    { "LV_SYMBOL_OK", LV_SYMBOL_OK },
+    { "LV_SYMBOL_HOME", LV_SYMBOL_HOME },
+    { "LV_SYMBOL_SETTINGS", LV_SYMBOL_SETTINGS },
+};
+
+static step_result_t *current_step;
+static uint32_t frames_seen;
+static int64_t last_power_update_us;
+
+static size_t heap_in_use(void) {
+    struct mallinfo2 info = mallinfo2();
+    return info.uordblks + info.hblkhd;
+}
+
+static size_t lvgl_in_use(void) {
+    lv_mem_monitor_t mon;
+    lv_mem_monitor(&mon);
+    return mon.total_size - mon.free_size;
+}
+
+static int screen_index(const lv_obj_t *screen) {
+    for (size_t i = 0; i < SCREEN_COUNT - 1; i++) {
+        if (*screens[i].screen && *screens[i].screen == screen) {
+            return (int)i;
+        }
+    }
+    return SCREEN_COUNT - 1;
+}
+
+static void add_frame(frame_totals_t *t, const render_frame_sample_t *frame, size_t lvgl_used, size_t heap) {
+    t->frames++;
+    t->total_frame_us += frame->frame_us;
+    if (frame->frame_us > t->max_frame_us) t->max_frame_us = frame->frame_us;
+    if (frame->flush_us > t->max_flush_us) t->max_flush_us = frame->flush_us;
+    if (lvgl_used > t->lvgl_peak) t->lvgl_peak = lvgl_used;
+    if (heap > t->heap_peak) t->heap_peak = heap;
+}
+
+// Books a frame rendered by the last lv_timer_handler() run, if there was one
+static bool sample_frame(void) {
+    render_frame_sample_t frame;
+    uint32_t frames = render_stats_get_last(&frame);
+    if (frames == frames_seen) {
+        return false;
+    }
+    frames_seen = frames;
+    size_t lvgl_used = lvgl_in_use();
+    size_t heap = heap_in_use();
+    add_frame(&screens[screen_index(lv_screen_active())].totals, &frame, lvgl_used, heap);
+    if (current_step) {
+        add_frame(&current_step->frames, &frame, lvgl_used, heap);
+    }
+    return true;
+}
+
+// One pass of the app_main() loop, without the boot screen countdown
+static bool loop_once(void) {
+    bsp_display_lock(0);
+    if (should_show_main) {
+        should_show_main = false;
+        update_main_screen();
+        lv_screen_load(main_screen);
+    }
+
+    int64_t now = esp_timer_get_time();
+    if (now - last_power_update_us >= POWER_UPDATE_MS * 1000) {
+        last_power_update_us = now;
+        float voltage = power_monitor_get_voltage();
+        float current_ma = power_monitor_get_current_ma();
+        bool charging = power_monitor_is_charging();
+        lv_obj_t *active_screen = lv_screen_active();
+        if (active_screen == main_screen) {
+            update_status_bar(voltage, current_ma, charging);
+        } else if (active_screen == file_manager_screen) {
+            update_file_manager_status_bar(voltage, current_ma, charging);
+        } else if (active_screen == firmware_loader_screen) {
+            update_firmware_status_bar(voltage, current_ma, charging);
+        } else if (active_screen == settings_screen) {
+            update_settings_status_bar(voltage, current_ma, charging);
+        }
+    }
+
+    gui_manager_update();
+    bool rendered = sample_frame();
+    bsp_display_unlock();
+    vTaskDelay(pdMS_TO_TICKS(LOOP_DELAY_MS));
+    return rendered;
+}
+
+static void run_for(uint32_t ms) {
+    int64_t end = esp_timer_get_time() + (int64_t)ms * 1000;
+    while (esp_timer_get_time() < end) {
+        loop_once();
+    }
+}
+
+static bool settle(void) {
+    int64_t start = esp_timer_get_time();
+    int64_t quiet_since = start;
+    for (;;) {
+        int64_t now = esp_timer_get_time();
+        if (loop_once()) {
+            quiet_since = now;
+        } else if (now - quiet_since >= SETTLE_QUIET_MS * 1000) {
+            return true;
+        }
+        if (now - start >= SETTLE_MAX_MS * 1000) {
+            return false;
+        }
+    }
+}
+
+static bool tap_at(int32_t x, int32_t y) {
+    host_display_touch(x, y, true);
+    run_for(PRESS_HOLD_MS);
+    host_display_touch(x, y, false);
+    return settle();
+}
+
+// First visible label containing text, top layer first so dialogs win
+static lv_obj_t *find_label(lv_obj_t *obj, const char *text) {
+    if (!obj || lv_obj_has_flag(obj, LV_OBJ_FLAG_HIDDEN)) {
+        return NULL;
+    }
+    if (lv_obj_check_type(obj, &lv_label_class) && lv_obj_is_visible(obj)) {
+        const char *label = lv_label_get_text(obj);
+        if (label && strstr(label, text)) {
+            return obj;
+        }
+    }
+    uint32_t child_count = lv_obj_get_child_count(obj);
+    for (uint32_t i = 0; i < child_count; i++) {
+        lv_obj_t *found = find_label(lv_obj_get_child(obj, i), text);
+        if (found) {
+            return found;
+        }
+    }
+    return NULL;
+}
+
+static bool step_tap(const char *text) {
+    bsp_display_lock(0);
+    lv_obj_t *label = find_label(lv_layer_top(), text);
+    if (!label) {
+        label = find_label(lv_screen_active(), text);
+    }
+    lv_area_t coords;
+    if (label) {
+        lv_obj_get_coords(label, &coords);
+    }
+    bsp_display_unlock();
+    if (!label) {
+        fprintf(stderr, "No visible label with \"%s\"\n", text);
+        return false;
+    }
+    return tap_at((coords.x1 + coords.x2) / 2, (coords.y1 + coords.y2) / 2);
+}
+
+static bool step_drag(int32_t x1, int32_t y1, int32_t x2, int32_t y2, uint32_t ms) {
+    host_display_touch(x1, y1, true);
+    run_for(PRESS_HOLD_MS);
+    int64_t start = esp_timer_get_time();
+    int64_t duration = (int64_t)(ms ? ms : 1) * 1000;
+    for (;;) {
+        int64_t t = esp_timer_get_time() - start;
+        if (t > duration) {
+            t = duration;
+        }
+        host_display_touch(x1 + (int32_t)((x2 - x1) * t / duration), y1 + (int32_t)((y2 - y1) * t / duration), true);
+        loop_once();
+        if (t == duration) {
+            break;
+        }
+    }
+    host_display_touch(x2, y2, false);
+    return settle();
+}
+
+static bool step_mkfiles(const char *dir, uint32_t count) {
+    char path[512];
+    snprintf(path, sizeof(path), "%s%s", SD_MOUNT_POINT, dir);
+    if (mkdir(path, 0755) != 0 && errno != EEXIST) {
+        return false;
+    }
+    for (uint32_t i = 0; i < count; i++) {
+        snprintf(path, sizeof(path), "%s%s/file_%05" PRIu32 ".txt", SD_MOUNT_POINT, dir, i);
+        FILE *f = fopen(path, "w");
+        if (!f) {
+            return false;
+        }
+        fclose(f);
+    }
+    return true;
+}
+
+static bool run_step(int argc, char **argv) {
+    const char *cmd = argv[0];
+    if (strcmp(cmd, "tap") == 0 && argc >= 2) {
+        // Labels may hold spaces; the rest of the line is the text
+        char text[LINE_MAX_LEN] = "";
+        for (int i = 1; i < argc; i++) {
+            const char *word = argv[i];
+            for (size_t k = 0; k < sizeof(symbol_names) / sizeof(symbol_names[0]); k++) {
+                if (strcmp(word, symbol_names[k].name) == 0) {
+                    word = symbol_names[k].text;
+                }
+            }
+            strncat(text, word, sizeof(text) - strlen(text) - 2);
+            if (i + 1 < argc) {
+                strcat(text, " ");
+            }
+        }
+        return step_tap(text);
+    } else if (strcmp(cmd, "tapxy") == 0 && argc == 3) {
+        return tap_at((int32_t)strtol(argv[1], NULL, 0), (int32_t)strtol(argv[2], NULL, 0));
+    } else if (strcmp(cmd, "drag") == 0 && argc == 6) {
+        return step_drag((int32_t)strtol(argv[1], NULL, 0), (int32_t)strtol(argv[2], NULL, 0),
+                         (int32_t)strtol(argv[3], NULL, 0), (int32_t)strtol(argv[4], NULL, 0),
+                         (uint32_t)strtoul(argv[5], NULL, 0));
+    } else if (strcmp(cmd, "wait") == 0 && argc == 2) {
+        run_for((uint32_t)strtoul(argv[1], NULL, 0));
+        return true;
+    } else if (strcmp(cmd, "settle") == 0 && argc == 1) {
+        return settle();
+    } else if (strcmp(cmd, "mkfiles") == 0 && argc == 3) {
+        return step_mkfiles(argv[1], (uint32_t)strtoul(argv[2], NULL, 0));
+    } else if (strcmp(cmd, "shot") == 0 && argc == 2) {
+        bsp_display_lock(0);
+        esp_err_t ret = host_display_save_ppm(argv[1]);
+        bsp_display_unlock();
+        return ret == ESP_OK;
+    }
+    fprintf(stderr, "Unknown step or wrong arguments: %s\n", cmd);
+    return false;
+}
+
+static void print_result(const step_result_t *r, FILE *csv) {
+    const frame_totals_t *f = &r->frames;
+    uint32_t avg_us = f->frames ? (uint32_t)(f->total_frame_us / f->frames) : 0;
+    printf("%-4s %-28.28s %8.1f ms %5" PRIu32 " frames avg %6.2f max %6.2f flush %5.2f ms"
+           "  lvgl %4zu KB peak %4zu KB  heap %6zu KB peak %6zu KB %5" PRIu32 " obj  %s\n",
+           r->ok ? "ok" : "FAIL", r->step, r->us / 1000.0, f->frames, avg_us / 1000.0,
+           f->max_frame_us / 1000.0, f->max_flush_us / 1000.0, r->lvgl_used / 1024, f->lvgl_peak / 1024,
+           r->heap / 1024, f->heap_peak / 1024, r->objects, r->screen);
+    if (csv) {
+        fprintf(csv, "\"%s\",%d,%" PRId64 ",%" PRIu32 ",%" PRIu32 ",%" PRIu32 ",%" PRIu32 ",%zu,%zu,%zu,%zu,%" PRIu32 ",%s\n",
+                r->step, r->ok, r->us, f->frames, avg_us, f->max_frame_us, f->max_flush_us,
+                r->lvgl_used, f->lvgl_peak, r->heap, f->heap_peak, r->objects, r->screen);
+    }
+}
+
+static void print_screen_totals(void) {
+    printf("%-14s %7s %8s %8s %10s %10s %10s %8s\n",
+           "screen", "frames", "avg ms", "max ms", "flush ms", "lvgl peak", "heap peak", "objects");
+    for (size_t i = 0; i < SCREEN_COUNT; i++) {
+        const frame_totals_t *t = &screens[i].totals;
+        if (t->frames == 0) {
+            continue;
+        }
+        printf("%-14s %7" PRIu32 " %8.2f %8.2f %10.2f %7zu KB %7zu KB %8" PRIu32 "\n",
+               screens[i].name, t->frames, (double)t->total_frame_us / t->frames / 1000.0,
+               t->max_frame_us / 1000.0, t->max_flush_us / 1000.0, t->lvgl_peak / 1024,
+               t->heap_peak / 1024, t->max_objects);
+    }
+}
+
+int main(int argc, char **argv) {
+    const char *script_path = NULL;
+    const char *csv_path = NULL;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-v") == 0) {
+            host_log_level = ESP_LOG_INFO;
+        } else if (strcmp(argv[i], "-c") == 0 && i + 1 < argc) {
+            csv_path = argv[++i];
+        } else {
+            script_path = argv[i];
+        }
+    }
+    if (!script_path) {
+        fprintf(stderr, "usage: %s [-v] [-c results.csv] script.txt\n", argv[0]);
+        return 2;
+    }
+
+    FILE *script = fopen(script_path, "r");
+    if (!script) {
+        fprintf(stderr, "Cannot open %s: %s\n", script_path, strerror(errno));
+        return 2;
+    }
+    FILE *csv = NULL;
+    if (csv_path) {
+        csv = fopen(csv_path, "w");
+        if (!csv) {
+            fprintf(stderr, "Cannot create %s: %s\n", csv_path, strerror(errno));
+            fclose(script);
+            return 2;
+        }
+        fprintf(csv, "step,ok,us,frames,avg_frame_us,max_frame_us,max_flush_us,lvgl_used,lvgl_peak,heap,heap_peak,objects,screen\n");
+    }
+
+    // Same order as app_main()
+    mkdir(SD_MOUNT_POINT, 0755);
+    hal_init();
+    hal_touchpad_init();
+    config_manager_init();
+    if (sd_manager_init() != ESP_OK) {
+        fprintf(stderr, "Could not mount %s\n", SD_MOUNT_POINT);
+    }
+    power_monitor_init();
+    firmware_loader_init();
+    firmware_loader_init_boot_manager();
+    bsp_display_lock(0);
+    gui_manager_init(lvDisp);
+    bsp_display_unlock();
+    settle();
+    printf("card %s, display %dx%d\n", SD_MOUNT_POINT,
+           (int)lv_display_get_horizontal_resolution(lvDisp), (int)lv_display_get_vertical_resolution(lvDisp));
+
+    int failures = 0;
+    char line[LINE_MAX_LEN];
+    while (fgets(line, sizeof(line), script)) {
+        line[strcspn(line, "#\r\n")] = '\0';
+        char *args[8];
+        int count = 0;
+        for (char *tok = strtok(line, " \t"); tok && count < 8; tok = strtok(NULL, " \t")) {
+            args[count++] = tok;
+        }
+        if (count == 0) {
+            continue;
+        }
+
+        step_result_t r = {0};
+        int used = 0;
+        for (int i = 0; i < count && used < (int)sizeof(r.step) - 1; i++) {
+            used += snprintf(r.step + used, sizeof(r.step) - used, "%s%s", i ? " " : "", args[i]);
+        }
+        current_step = &r;
+        int64_t start = esp_timer_get_time();
+        r.ok = run_step(count, args);
+        r.us = esp_timer_get_time() - start;
+        current_step = NULL;
+
+        bsp_display_lock(0);
+        render_stats_t stats;
+        render_stats_get(&stats);
+        int screen = screen_index(lv_screen_active());
+        r.lvgl_used = lvgl_in_use();
+        bsp_display_unlock();
+        r.heap = heap_in_use();
+        r.objects = stats.obj_count;
+        r.screen = screens[screen].name;
+        if (r.objects > screens[screen].totals.max_objects) {
+            screens[screen].totals.max_objects = r.objects;
+        }
+        print_result(&r, csv);
+        if (!r.ok) {
+            failures++;
+        }
+    }
+
+    print_screen_totals();
+    fclose(script);
+    if (csv) {
+        fclose(csv);
+    }
+    return failures ? 1 : 0;
+}
@@ -10,8 +10,13 @@
 #include <errno.h>
 
 static const char *TAG = "CONFIG_MGR";
-static const char *CONFIG_FILE = "/spiffs/launcher_config.json";
-static const char *CONFIG_BACKUP = "/spiffs/launcher_config.bak";
+// Overridable so an off-device build can keep the config in a host directory
+#ifndef LAUNCHER_CONFIG_DIR
+#define LAUNCHER_CONFIG_DIR "/spiffs"
+#endif
+
+static const char *CONFIG_FILE = LAUNCHER_CONFIG_DIR "/launcher_config.json";
+static const char *CONFIG_BACKUP = LAUNCHER_CONFIG_DIR "/launcher_config.bak";
 static const uint32_t CONFIG_MAGIC = 0x4C414E43; // "LANC" for LAuNCher
 
 static launcher_config_t current_config;
@@ -41,6 +46,7 @@ static void set_default_config(launcher_config_t *config) {
     config->file_browser.show_file_extensions = true;
     config->file_browser.show_file_sizes = true;
     config->file_browser.confirm_delete = true;
+    config->file_browser.verify_copies = false;
     config->file_browser.items_per_page = 10;
     
     // Network defaults (WiFi disabled for ESP32-P4)
@@ -67,13 +73,19 @@ static void set_default_config(launcher_config_t *config) {
     config->theme.background_color = 0xFF121212;  // Dark Background
     config->theme.text_color = 0xFFFFFFFF;        // White Text
     config->theme.accent_color = 0xFF4CAF50;      // Green Accent
+
+    // SD card defaults: probe each new card, no per-card modes known yet
+    config->sd.max_freq_khz = 0;
+    config->sd.max_files = 5;
+    config->sd.allocation_unit = 16 * 1024;
+    config->sd.auto_probe = true;
 }
 
 esp_err_t config_manager_init(void) {
     ESP_LOGI(TAG, "Initializing configuration manager with SPIFFS");
     
     esp_vfs_spiffs_conf_t conf = {
-        .base_path = "/spiffs",
+        .base_path = LAUNCHER_CONFIG_DIR,
         .partition_label = "spiffs",
         .max_files = 5,
         .format_if_mount_failed = true
@@ -344,7 +356,9 @@ bool config_manager_validate(const launcher_config_t *config) {
     if (config->system.brightness > 100 || 
         config->system.volume > 100 ||
         config->file_browser.items_per_page == 0 ||
-        config->file_browser.items_per_page > 50) {
+        config->file_browser.items_per_page > 50 ||
+        config->sd.max_files == 0 ||
+        config->sd.max_files > 32) {
         ESP_LOGE(TAG, "Configuration values out of range");
         return false;
     }
@@ -386,6 +400,7 @@ esp_err_t config_manager_export_json(const launcher_config_t *config, char *json
     cJSON_AddBoolToObject(browser, "show_file_extensions", config->file_browser.show_file_extensions);
     cJSON_AddBoolToObject(browser, "show_file_sizes", config->file_browser.show_file_sizes);
     cJSON_AddBoolToObject(browser, "confirm_delete", config->file_browser.confirm_delete);
+    cJSON_AddBoolToObject(browser, "verify_copies", config->file_browser.verify_copies);
     cJSON_AddNumberToObject(browser, "items_per_page", config->file_browser.items_per_page);
     cJSON_AddItemToObject(root, "file_browser", browser);
     
@@ -422,6 +437,26 @@ esp_err_t config_manager_export_json(const launcher_config_t *config, char *json
     cJSON_AddNumberToObject(theme, "accent_color", config->theme.accent_color);
     cJSON_AddItemToObject(root, "theme", theme);
     
+    // SD card mount profile
+    cJSON *sd = cJSON_CreateObject();
+    cJSON_AddNumberToObject(sd, "max_freq_khz", config->sd.max_freq_khz);
+    cJSON_AddNumberToObject(sd, "max_files", config->sd.max_files);
+    cJSON_AddNumberToObject(sd, "allocation_unit", config->sd.allocation_unit);
+    cJSON_AddBoolToObject(sd, "auto_probe", config->sd.auto_probe);
+    cJSON *cards = cJSON_CreateArray();
+    for (int i = 0; i < SD_PROFILE_MAX_CARDS && config->sd.cards[i].cid[0]; i++) {
+        const sd_card_profile_t *card = &config->sd.cards[i];
+        cJSON *entry = cJSON_CreateObject();
+        cJSON_AddStringToObject(entry, "cid", card->cid);
+        cJSON_AddNumberToObject(entry, "freq_khz", card->freq_khz);
+        cJSON_AddNumberToObject(entry, "bus_width", card->bus_width);
+        cJSON_AddBoolToObject(entry, "ddr", card->ddr);
+        cJSON_AddBoolToObject(entry, "uhs1", card->uhs1);
+        cJSON_AddItemToArray(cards, entry);
+    }
+    cJSON_AddItemToObject(sd, "cards", cards);
+    cJSON_AddItemToObject(root, "sd", sd);
+    
     // Print to buffer
     char *json_str = cJSON_PrintUnformatted(root);
     if (!json_str) {
@@ -518,6 +553,9 @@ esp_err_t config_manager_import_json(const char *json_string, launcher_config_t
         item = cJSON_GetObjectItem(browser, "confirm_delete");
         if (item && cJSON_IsBool(item)) config->file_browser.confirm_delete = cJSON_IsTrue(item);
         
+        item = cJSON_GetObjectItem(browser, "verify_copies");
+        if (item && cJSON_IsBool(item)) config->file_browser.verify_copies = cJSON_IsTrue(item);
+        
         item = cJSON_GetObjectItem(browser, "items_per_page");
         if (item && cJSON_IsNumber(item)) config->file_browser.items_per_page = item->valueint;
     }
@@ -609,6 +647,49 @@ esp_err_t config_manager_import_json(const char *json_string, launcher_config_t
         if (item && cJSON_IsNumber(item)) config->theme.accent_color = item->valueint;
     }
     
+    // Parse SD card mount profile
+    cJSON *sd = cJSON_GetObjectItem(root, "sd");
+    if (sd) {
+        item = cJSON_GetObjectItem(sd, "max_freq_khz");
+        if (item && cJSON_IsNumber(item)) config->sd.max_freq_khz = item->valueint;
+        
+        item = cJSON_GetObjectItem(sd, "max_files");
+        if (item && cJSON_IsNumber(item)) config->sd.max_files = item->valueint;
+        
+        item = cJSON_GetObjectItem(sd, "allocation_unit");
+        if (item && cJSON_IsNumber(item)) config->sd.allocation_unit = item->valueint;
+        
+        item = cJSON_GetObjectItem(sd, "auto_probe");
+        if (item && cJSON_IsBool(item)) config->sd.auto_probe = cJSON_IsTrue(item);
+        
+        cJSON *cards = cJSON_GetObjectItem(sd, "cards");
+        int count = 0;
+        cJSON *entry;
+        cJSON_ArrayForEach(entry, cards) {
+            if (count >= SD_PROFILE_MAX_CARDS) {
+                break;
+            }
+            item = cJSON_GetObjectItem(entry, "cid");
+            if (!item || !cJSON_IsString(item) || !item->valuestring[0]) {
+                continue;
+            }
+            sd_card_profile_t *card = &config->sd.cards[count++];
+            strncpy(card->cid, item->valuestring, sizeof(card->cid) - 1);
+            
+            item = cJSON_GetObjectItem(entry, "freq_khz");
+            if (item && cJSON_IsNumber(item)) card->freq_khz = item->valueint;
+            
+            item = cJSON_GetObjectItem(entry, "bus_width");
+            if (item && cJSON_IsNumber(item)) card->bus_width = item->valueint;
+            
+            item = cJSON_GetObjectItem(entry, "ddr");
+            if (item && cJSON_IsBool(item)) card->ddr = cJSON_IsTrue(item);
+            
+            item = cJSON_GetObjectItem(entry, "uhs1");
+            if (item && cJSON_IsBool(item)) card->uhs1 = cJSON_IsTrue(item);
+        }
+    }
+    
     cJSON_Delete(root);
     return ESP_OK;
 }
@@ -3,6 +3,7 @@
 
 #include "esp_err.h"
 #include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
 
 // Configuration version for migration/compatibility
@@ -48,6 +49,7 @@ typedef struct {
     bool show_file_extensions;
     bool show_file_sizes;
     bool confirm_delete;
+    bool verify_copies;         // Read back copied files and compare checksums
     uint8_t items_per_page;
 } file_browser_config_t;
 
@@ -85,6 +87,26 @@ typedef struct {
     char default_path[256];
 } python_config_t;
 
+// SD card mount profile
+#define SD_PROFILE_MAX_CARDS 8
+
+// Bus mode remembered for one card, see sd_profile.h
+typedef struct {
+    char cid[32];                // Manufacturer, OEM, product name and serial from the CID
+    uint32_t freq_khz;
+    uint8_t bus_width;
+    bool ddr;
+    bool uhs1;
+} sd_card_profile_t;
+
+typedef struct {
+    uint32_t max_freq_khz;       // Fastest bus clock to use, 0 = fastest the host supports
+    uint8_t max_files;           // Files open at once; each holds its own FatFs sector buffer
+    uint32_t allocation_unit;    // Cluster size in bytes when formatting
+    bool auto_probe;             // Probe new cards for their fastest stable bus mode
+    sd_card_profile_t cards[SD_PROFILE_MAX_CARDS];  // Most recently used first
+} sd_mount_config_t;
+
 // Main configuration structure
 typedef struct {
     uint32_t version;
@@ -94,6 +116,7 @@ typedef struct {
     network_config_t network;
     python_config_t python;
     theme_config_t theme;
+    sd_mount_config_t sd;
 } launcher_config_t;
 
 /**
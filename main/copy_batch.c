@@ -0,0 +1,317 @@
+#include "copy_batch.h"
+#include "copy_verify.h"
+#include "sd_space.h"
+#include "sd_io.h"
+#include "esp_log.h"
+#include "esp_heap_caps.h"
+#include "esp_rom_crc.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+#include <fcntl.h>
+#include <unistd.h>
+#include <stdio.h>
+#include <string.h>
+#include <inttypes.h>
+
+static const char *TAG = "COPY_BATCH";
+
+#define COPY_BATCH_BUFFER_SIZE     (256 * 1024)
+#define COPY_BATCH_MIN_BUFFER      (64 * 1024)     // Still holds the largest batched file
+#define COPY_BATCH_BUFFERS         2
+#define COPY_BATCH_MAX_FILES       256
+#define COPY_BATCH_PATHS_SIZE      (16 * 1024)
+#define COPY_BATCH_ALIGN           64              // Cache line; keeps the SDMMC driver from bouncing
+#define COPY_BATCH_TASK_STACK      3072
+#define COPY_BATCH_TASK_PRIORITY   4
+
+/*
+ * Each batch is one data buffer holding whole files back to back, plus the
+ * destination path of each. Batch indices circulate through free_queue and
+ * filled_queue the same way copy_engine's chunk buffers do: the caller fills
+ * one batch while the writer task drains the other.
+ */
+typedef struct {
+    uint32_t data;          // Offset in the data buffer
+    uint32_t len;
+    uint32_t path;          // Offset in paths
+    uint32_t crc;           // CRC32 of the source data (verified batches only)
+} batch_file_t;
+
+typedef struct {
+    uint8_t *data;
+    uint32_t data_used;
+    uint32_t file_count;
+    uint32_t paths_used;
+    batch_file_t files[COPY_BATCH_MAX_FILES];
+    char paths[COPY_BATCH_PATHS_SIZE];
+} batch_t;
+
+#define NO_BATCH UINT32_MAX
+
+static SemaphoreHandle_t batch_lock = NULL;
+static TaskHandle_t writer_task = NULL;
+static QueueHandle_t free_queue = NULL;
+static QueueHandle_t filled_queue = NULL;
+
+// Owned by the copy holding batch_lock
+static batch_t *batches[COPY_BATCH_BUFFERS];
+static size_t buffer_size = 0;
+static uint32_t filling = NO_BATCH;     // Batch the caller is adding to
+static uint32_t read_failed = 0;
+static bool verify = false;
+static volatile bool discard_queued = false;
+
+// Written by the writer only; read once every batch is back in free_queue
+static copy_batch_stats_t written;
+
+static bool write_all(int fd, const uint8_t *data, size_t len) {
+    while (len > 0) {
+        // A chunk per scheduler slot, so interactive reads get the card in between
+        size_t step = len < SD_IO_BULK_CHUNK_SIZE ? len : SD_IO_BULK_CHUNK_SIZE;
+        sd_io_begin(SD_IO_BULK);
+        ssize_t n = write(fd, data, step);
+        sd_io_end(SD_IO_BULK);
+        if (n <= 0) {
+            return false;
+        }
+        data += n;
+        len -= n;
+    }
+    return true;
+}
+
+static ssize_t read_full(int fd, uint8_t *data, size_t len) {
+    size_t total = 0;
+    while (total < len) {
+        size_t step = len - total < SD_IO_BULK_CHUNK_SIZE ? len - total : SD_IO_BULK_CHUNK_SIZE;
+        sd_io_begin(SD_IO_BULK);
+        ssize_t got = read(fd, data + total, step);
+        sd_io_end(SD_IO_BULK);
+        if (got < 0) {
+            return -1;
+        }
+        if (got == 0) {
+            break;
+        }
+        total += got;
+    }
+    return (ssize_t)total;
+}
+
+static void write_batch(batch_t *batch) {
+    for (uint32_t i = 0; i < batch->file_count && !discard_queued; i++) {
+        const batch_file_t *file = &batch->files[i];
+        const char *path = batch->paths + file->path;
+        int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        bool ok = fd >= 0 && write_all(fd, batch->data + file->data, file->len);
+        if (fd >= 0 && close(fd) != 0) {
+            ok = false;
+        }
+        if (ok) {
+            written.files++;
+            written.bytes += file->len;
+            // Counted as new even when it replaced a file, which errs towards less free space
+            sd_space_note_file(0, file->len);
+            if (verify) {
+                copy_verify_queue(path, file->len, file->crc);
+            }
+        } else {
+            ESP_LOGE(TAG, "Failed to write %s", path);
+            remove(path);
+            written.failed++;
+        }
+    }
+}
+
+static void copy_batch_writer_task(void *arg) {
+    (void)arg;
+    uint32_t index;
+
+    for (;;) {
+        xQueueReceive(filled_queue, &index, portMAX_DELAY);
+        write_batch(batches[index]);
+        xQueueSend(free_queue, &index, portMAX_DELAY);
+    }
+}
+
+static bool ensure_writer(void) {
+    if (!batch_lock) {
+        batch_lock = xSemaphoreCreateMutex();
+        if (!batch_lock) {
+            ESP_LOGE(TAG, "Failed to create batch lock");
+            return false;
+        }
+    }
+    if (!free_queue) {
+        free_queue = xQueueCreate(COPY_BATCH_BUFFERS, sizeof(uint32_t));
+        filled_queue = xQueueCreate(COPY_BATCH_BUFFERS, sizeof(uint32_t));
+        if (!free_queue || !filled_queue) {
+            ESP_LOGE(TAG, "Failed to create batch queues");
+            return false;
+        }
+    }
+    if (writer_task) {
+        return true;
+    }
+    // Pinned to CPU1 like the other long-running workers, away from LVGL
+    BaseType_t result = xTaskCreatePinnedToCore(copy_batch_writer_task, "copy_batch", COPY_BATCH_TASK_STACK,
+                                                NULL, COPY_BATCH_TASK_PRIORITY, &writer_task, 1);
+    if (result != pdPASS) {
+        ESP_LOGE(TAG, "Failed to create batch writer task");
+        writer_task = NULL;
+        return false;
+    }
+    return true;
+}
+
+static void free_batches(void) {
+    for (int i = 0; i < COPY_BATCH_BUFFERS; i++) {
+        if (batches[i]) {
+            heap_caps_free(batches[i]->data);
+            heap_caps_free(batches[i]);
+            batches[i] = NULL;
+        }
+    }
+}
+
+// PSRAM is fine here: the data is read and written in whole-file runs
+static bool alloc_batches(void) {
+    for (buffer_size = COPY_BATCH_BUFFER_SIZE; buffer_size >= COPY_BATCH_MIN_BUFFER; buffer_size /= 2) {
+        int i;
+        for (i = 0; i < COPY_BATCH_BUFFERS; i++) {
+            batches[i] = heap_caps_calloc(1, sizeof(batch_t), MALLOC_CAP_SPIRAM);
+            if (!batches[i]) {
+                break;
+            }
+            batches[i]->data = heap_caps_aligned_alloc(COPY_BATCH_ALIGN, buffer_size,
+                                                       MALLOC_CAP_DMA | MALLOC_CAP_SPIRAM);
+            if (!batches[i]->data) {
+                break;
+            }
+        }
+        if (i == COPY_BATCH_BUFFERS) {
+            return true;
+        }
+        free_batches();
+    }
+    return false;
+}
+
+esp_err_t copy_batch_begin(bool verify_copies) {
+    if (!ensure_writer()) {
+        return ESP_ERR_NO_MEM;
+    }
+    xSemaphoreTake(batch_lock, portMAX_DELAY);
+    if (!alloc_batches()) {
+        xSemaphoreGive(batch_lock);
+        ESP_LOGW(TAG, "No memory for batch buffers");
+        return ESP_ERR_NO_MEM;
+    }
+
+    xQueueReset(free_queue);
+    xQueueReset(filled_queue);
+    for (uint32_t i = 0; i < COPY_BATCH_BUFFERS; i++) {
+        xQueueSend(free_queue, &i, 0);
+    }
+    filling = NO_BATCH;
+    read_failed = 0;
+    verify = verify_copies;
+    discard_queued = false;
+    memset(&written, 0, sizeof(written));
+    return ESP_OK;
+}
+
+bool copy_batch_fits(uint64_t size) {
+    return size <= COPY_BATCH_SMALL_FILE;
+}
+
+// Pass the batch being filled to the writer
+static void hand_off(void) {
+    if (filling == NO_BATCH) {
+        return;
+    }
+    if (batches[filling]->file_count > 0) {
+        xQueueSend(filled_queue, &filling, portMAX_DELAY);
+    } else {
+        xQueueSend(free_queue, &filling, portMAX_DELAY);
+    }
+    filling = NO_BATCH;
+}
+
+esp_err_t copy_batch_add(const char *src_full, const char *dst_full, uint64_t size) {
+    if (!copy_batch_fits(size)) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    uint32_t path_len = (uint32_t)strlen(dst_full) + 1;
+
+    if (filling != NO_BATCH) {
+        batch_t *batch = batches[filling];
+        if (batch->data_used + size > buffer_size || batch->file_count == COPY_BATCH_MAX_FILES ||
+            batch->paths_used + path_len > COPY_BATCH_PATHS_SIZE) {
+            hand_off();
+        }
+    }
+    if (filling == NO_BATCH) {
+        // Waits here while the writer still has both batches
+        xQueueReceive(free_queue, &filling, portMAX_DELAY);
+        batch_t *batch = batches[filling];
+        batch->data_used = 0;
+        batch->file_count = 0;
+        batch->paths_used = 0;
+    }
+    batch_t *batch = batches[filling];
+
+    int fd = open(src_full, O_RDONLY);
+    if (fd < 0) {
+        ESP_LOGE(TAG, "Failed to open source file: %s", src_full);
+        read_failed++;
+        return ESP_FAIL;
+    }
+    ssize_t got = read_full(fd, batch->data + batch->data_used, (size_t)size);
+    close(fd);
+    if (got < 0) {
+        ESP_LOGE(TAG, "Failed to read source file: %s", src_full);
+        read_failed++;
+        return ESP_FAIL;
+    }
+
+    batch_file_t *file = &batch->files[batch->file_count++];
+    file->data = batch->data_used;
+    file->len = (uint32_t)got;
+    file->path = batch->paths_used;
+    file->crc = verify ? esp_rom_crc32_le(0, batch->data + batch->data_used, (uint32_t)got) : 0;
+    memcpy(batch->paths + batch->paths_used, dst_full, path_len);
+    batch->paths_used += path_len;
+    batch->data_used = (batch->data_used + (uint32_t)got + COPY_BATCH_ALIGN - 1) & ~(uint32_t)(COPY_BATCH_ALIGN - 1);
+    return ESP_OK;
+}
+
+esp_err_t copy_batch_end(bool discard, copy_batch_stats_t *stats) {
+    if (discard) {
+        discard_queued = true;
+        if (filling != NO_BATCH) {
+            xQueueSend(free_queue, &filling, portMAX_DELAY);
+            filling = NO_BATCH;
+        }
+    } else {
+        hand_off();
+    }
+
+    // Every batch back in free_queue means the writer is idle
+    for (uint32_t i = 0; i < COPY_BATCH_BUFFERS; i++) {
+        uint32_t index;
+        xQueueReceive(free_queue, &index, portMAX_DELAY);
+    }
+
+    copy_batch_stats_t result = written;
+    result.failed += read_failed;
+    free_batches();
+    xSemaphoreGive(batch_lock);
+
+    if (stats) {
+        *stats = result;
+    }
+    return result.failed ? ESP_FAIL : ESP_OK;
+}
@@ -0,0 +1,63 @@
+#ifndef COPY_BATCH_H
+#define COPY_BATCH_H
+
+#include "esp_err.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+// Files up to this size are gathered into a batch; larger ones go through copy_engine_copy()
+#define COPY_BATCH_SMALL_FILE  (32 * 1024)
+
+typedef struct {
+    uint32_t files;         // Files written
+    uint64_t bytes;         // Bytes written
+    uint32_t failed;        // Files that could not be read or written
+} copy_batch_stats_t;
+
+/**
+ * @brief Start a batched copy of many small files
+ *
+ * Sources are read whole, back to back, into one large buffer on the
+ * calling task while a writer task creates and fills the destinations from
+ * the previous buffer. A tree of small files then costs one open, read and
+ * close per file on each side with no per-file buffers or preallocation,
+ * and reading overlaps writing. Only one batched copy runs at a time;
+ * concurrent callers wait their turn.
+ *
+ * @param verify_copies Hash each source as it is read and queue every written
+ *        file on copy_verify; the caller owns the copy_verify session
+ * @return ESP_OK on success, ESP_ERR_NO_MEM if the batch buffers could not
+ *         be allocated (copy file by file instead)
+ */
+esp_err_t copy_batch_begin(bool verify_copies);
+
+/**
+ * @brief Check whether a file is small enough to batch
+ * @param size File size in bytes
+ * @return true if copy_batch_add() takes it
+ */
+bool copy_batch_fits(uint64_t size);
+
+/**
+ * @brief Queue one small file of the batched copy
+ *
+ * The destination directory must already exist. The file is written some
+ * time before copy_batch_end() returns; a failure shows up in its stats.
+ *
+ * @param src_full Absolute source path (including the mount point)
+ * @param dst_full Absolute destination path (including the mount point)
+ * @param size Source size from its directory entry, at most COPY_BATCH_SMALL_FILE
+ * @return ESP_OK if queued, ESP_FAIL if the source could not be read,
+ *         ESP_ERR_INVALID_SIZE if the file is too big to batch
+ */
+esp_err_t copy_batch_add(const char *src_full, const char *dst_full, uint64_t size);
+
+/**
+ * @brief Finish the batched copy started by copy_batch_begin()
+ * @param discard Drop files that are queued but not yet written (on cancel)
+ * @param stats Output counts (can be NULL)
+ * @return ESP_OK if every queued file was written (or discarded), ESP_FAIL otherwise
+ */
+esp_err_t copy_batch_end(bool discard, copy_batch_stats_t *stats);
+
+#endif // COPY_BATCH_H
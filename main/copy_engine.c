@@ -0,0 +1,443 @@
+#include "copy_engine.h"
+#include "sd_manager.h"
+#include "sd_space.h"
+#include "sd_io.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_heap_caps.h"
+#include "esp_vfs_fat.h"
+#include "esp_rom_crc.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+#include <fcntl.h>
+#include <unistd.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <inttypes.h>
+
+static const char *TAG = "COPY_ENGINE";
+
+// Whole multiples of the 512-byte sector, so FatFs moves full chunks straight
+// between the buffer and the card as multi-block transfers
+#define COPY_ENGINE_CHUNK_SIZE     (64 * 1024)
+#define COPY_ENGINE_MIN_CHUNK      (8 * 1024)
+#define COPY_ENGINE_BUFFERS        2
+#define COPY_ENGINE_ALIGN          64      // Cache line; keeps the SDMMC driver from bouncing
+#define COPY_ENGINE_TASK_STACK     3072
+#define COPY_ENGINE_TASK_PRIORITY  4
+#define COPY_ENGINE_KEEP_MS        2000    // Buffers outlive a copy by this long
+#define COPY_ENGINE_HOLDING        COPY_ENGINE_BUFFERS  // Queued once buffers are kept, not a buffer
+
+/*
+ * The caller reads into one buffer while the writer task drains the other.
+ * Buffer indices circulate through two queues: free_queue holds buffers the
+ * reader may fill, filled_queue holds buffers waiting to be written. The
+ * writer keeps draining after a failure so the reader never blocks on it.
+ *
+ * The buffers are kept from one copy to the next, so copying many files
+ * allocates them once. The copy that allocates them hands the writer
+ * COPY_ENGINE_HOLDING; from then on the writer wakes every
+ * COPY_ENGINE_KEEP_MS and frees them once that long has passed without a copy.
+ */
+typedef struct {
+    uint8_t *data;
+    size_t len;
+} copy_buffer_t;
+
+static SemaphoreHandle_t engine_lock = NULL;
+static TaskHandle_t writer_task = NULL;
+static QueueHandle_t free_queue = NULL;
+static QueueHandle_t filled_queue = NULL;
+
+// Owned by the copy holding engine_lock
+static copy_buffer_t buffers[COPY_ENGINE_BUFFERS];
+static int buffer_count = 0;
+static size_t buffer_chunk = 0;
+static int writer_fd = -1;
+static int64_t last_copy_us = 0;
+static volatile bool writer_failed = false;
+
+static bool write_all(int fd, const uint8_t *data, size_t len) {
+    while (len > 0) {
+        // A chunk per scheduler slot, so interactive reads get the card in between
+        size_t step = len < SD_IO_BULK_CHUNK_SIZE ? len : SD_IO_BULK_CHUNK_SIZE;
+        sd_io_begin(SD_IO_BULK);
+        ssize_t written = write(fd, data, step);
+        sd_io_end(SD_IO_BULK);
+        if (written <= 0) {
+            return false;
+        }
+        data += written;
+        len -= written;
+    }
+    return true;
+}
+
+// Fill the buffer unless the file ends first; returns bytes read or -1.
+// A regular file only reads short at its end, so that ends it without
+// another call to find out.
+static ssize_t read_full(int fd, uint8_t *data, size_t len) {
+    size_t total = 0;
+    while (total < len) {
+        size_t step = len - total < SD_IO_BULK_CHUNK_SIZE ? len - total : SD_IO_BULK_CHUNK_SIZE;
+        sd_io_begin(SD_IO_BULK);
+        ssize_t got = read(fd, data + total, step);
+        sd_io_end(SD_IO_BULK);
+        if (got < 0) {
+            return -1;
+        }
+        total += got;
+        if ((size_t)got < step) {
+            break;
+        }
+    }
+    return (ssize_t)total;
+}
+
+static void free_buffers(void) {
+    for (int i = 0; i < COPY_ENGINE_BUFFERS; i++) {
+        heap_caps_free(buffers[i].data);
+        buffers[i].data = NULL;
+    }
+    buffer_count = 0;
+    buffer_chunk = 0;
+}
+
+static void copy_writer_task(void *arg) {
+    (void)arg;
+    uint32_t index;
+    bool holding = false;   // Buffers are kept between copies
+
+    for (;;) {
+        TickType_t wait = holding ? pdMS_TO_TICKS(COPY_ENGINE_KEEP_MS) : portMAX_DELAY;
+        if (xQueueReceive(filled_queue, &index, wait) != pdTRUE) {
+            // A copy in progress, or one that just ended, keeps them
+            if (xSemaphoreTake(engine_lock, 0) == pdTRUE) {
+                if (esp_timer_get_time() - last_copy_us >= COPY_ENGINE_KEEP_MS * 1000LL) {
+                    free_buffers();
+                    holding = false;
+                }
+                xSemaphoreGive(engine_lock);
+            }
+            continue;
+        }
+        if (index == COPY_ENGINE_HOLDING) {
+            holding = true;
+            continue;
+        }
+
+        copy_buffer_t *buffer = &buffers[index];
+        if (!writer_failed && !write_all(writer_fd, buffer->data, buffer->len)) {
+            writer_failed = true;
+        }
+        xQueueSend(free_queue, &index, portMAX_DELAY);
+    }
+}
+
+static bool ensure_engine(void) {
+    if (!engine_lock) {
+        engine_lock = xSemaphoreCreateMutex();
+        if (!engine_lock) {
+            ESP_LOGE(TAG, "Failed to create engine lock");
+            return false;
+        }
+    }
+    if (!free_queue) {
+        free_queue = xQueueCreate(COPY_ENGINE_BUFFERS, sizeof(uint32_t));
+        filled_queue = xQueueCreate(COPY_ENGINE_BUFFERS, sizeof(uint32_t));
+        if (!free_queue || !filled_queue) {
+            ESP_LOGE(TAG, "Failed to create buffer queues");
+            return false;
+        }
+    }
+    return true;
+}
+
+// A missing writer is not fatal: copies fall back to read-then-write on the caller
+static bool ensure_writer(void) {
+    if (writer_task) {
+        return true;
+    }
+    // Pinned to CPU1 like the other long-running workers, away from LVGL
+    BaseType_t result = xTaskCreatePinnedToCore(copy_writer_task, "copy_write", COPY_ENGINE_TASK_STACK,
+                                                NULL, COPY_ENGINE_TASK_PRIORITY, &writer_task, 1);
+    if (result != pdPASS) {
+        ESP_LOGW(TAG, "Failed to create writer task, copying single-buffered");
+        writer_task = NULL;
+        return false;
+    }
+    return true;
+}
+
+// Internal DMA memory first, PSRAM second; shrinks the chunk rather than fail
+static size_t alloc_buffers(size_t wanted, int count) {
+    static const uint32_t caps[] = {
+        MALLOC_CAP_DMA | MALLOC_CAP_INTERNAL,
+        MALLOC_CAP_DMA | MALLOC_CAP_SPIRAM
+    };
+
+    for (size_t chunk = wanted; ; chunk /= 2) {
+        for (size_t c = 0; c < sizeof(caps) / sizeof(caps[0]); c++) {
+            int i;
+            for (i = 0; i < count; i++) {
+                buffers[i].data = heap_caps_aligned_alloc(COPY_ENGINE_ALIGN, chunk, caps[c]);
+                if (!buffers[i].data) {
+                    break;
+                }
+            }
+            if (i == count) {
+                buffer_count = count;
+                buffer_chunk = chunk;
+                return chunk;
+            }
+            free_buffers();
+        }
+        if (chunk <= COPY_ENGINE_MIN_CHUNK) {
+            return 0;
+        }
+    }
+}
+
+/*
+ * Reserve the destination's clusters before writing. A contiguous run
+ * (f_expand) means no FAT updates during the copy at all; otherwise seeking
+ * to the end allocates the whole cluster chain in one pass instead of one
+ * cluster per write. Either way a full card is detected before any data moves.
+ */
+static int open_destination(const char *dst_full, uint64_t size, bool *contiguous) {
+    *contiguous = false;
+
+    if (size > 0 && esp_vfs_fat_create_contiguous_file(SD_MOUNT_POINT, dst_full, size, true) == ESP_OK) {
+        int fd = open(dst_full, O_WRONLY);
+        if (fd >= 0) {
+            *contiguous = true;
+            return fd;
+        }
+    }
+
+    int fd = open(dst_full, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0 || size == 0) {
+        return fd;
+    }
+    static const uint8_t zero = 0;
+    if (lseek(fd, (off_t)(size - 1), SEEK_SET) < 0 || write(fd, &zero, 1) != 1) {
+        ESP_LOGW(TAG, "Could not preallocate %" PRIu64 " bytes for %s", size, dst_full);
+        close(fd);
+        return -1;
+    }
+    lseek(fd, 0, SEEK_SET);
+    return fd;
+}
+
+typedef struct {
+    copy_engine_progress_cb_t cb;
+    void *user_data;
+    bool hash;
+    uint32_t crc;
+} copy_progress_t;
+
+// Called on the reading side, so hashing overlaps the writer's card time
+static bool chunk_read(copy_progress_t *progress, const uint8_t *data, size_t len, uint64_t copied) {
+    if (progress->hash) {
+        progress->crc = esp_rom_crc32_le(progress->crc, data, len);
+    }
+    return !progress->cb || progress->cb(copied, progress->user_data);
+}
+
+static esp_err_t copy_single(int src, int dst, size_t chunk, copy_progress_t *progress,
+                             uint64_t *copied) {
+    for (;;) {
+        ssize_t got = read_full(src, buffers[0].data, chunk);
+        if (got < 0) {
+            ESP_LOGE(TAG, "Read error during copy");
+            return ESP_FAIL;
+        }
+        if (got == 0) {
+            return ESP_OK;
+        }
+        if (!write_all(dst, buffers[0].data, got)) {
+            ESP_LOGE(TAG, "Write error during copy");
+            return ESP_FAIL;
+        }
+        *copied += got;
+        if (!chunk_read(progress, buffers[0].data, got, *copied)) {
+            return ESP_ERR_INVALID_STATE;
+        }
+        if ((size_t)got < chunk) {
+            return ESP_OK;
+        }
+    }
+}
+
+static esp_err_t copy_pipelined(int src, int dst, size_t chunk, copy_progress_t *progress,
+                                uint64_t *copied) {
+    writer_fd = dst;
+    writer_failed = false;
+    // filled_queue is left alone: it may still carry COPY_ENGINE_HOLDING
+    xQueueReset(free_queue);
+    for (uint32_t i = 0; i < COPY_ENGINE_BUFFERS; i++) {
+        xQueueSend(free_queue, &i, 0);
+    }
+
+    esp_err_t ret = ESP_OK;
+    for (;;) {
+        uint32_t index;
+        xQueueReceive(free_queue, &index, portMAX_DELAY);
+        if (writer_failed) {
+            ESP_LOGE(TAG, "Write error during copy");
+            ret = ESP_FAIL;
+            xQueueSend(free_queue, &index, portMAX_DELAY);
+            break;
+        }
+
+        ssize_t got = read_full(src, buffers[index].data, chunk);
+        if (got <= 0) {
+            if (got < 0) {
+                ESP_LOGE(TAG, "Read error during copy");
+                ret = ESP_FAIL;
+            }
+            xQueueSend(free_queue, &index, portMAX_DELAY);
+            break;
+        }
+        buffers[index].len = got;
+        *copied += got;
+        xQueueSend(filled_queue, &index, portMAX_DELAY);
+        if (!chunk_read(progress, buffers[index].data, got, *copied)) {
+            ret = ESP_ERR_INVALID_STATE;
+            break;
+        }
+        if ((size_t)got < chunk) {
+            break;
+        }
+    }
+
+    // Every buffer back in free_queue means the writer is idle
+    for (uint32_t i = 0; i < COPY_ENGINE_BUFFERS; i++) {
+        uint32_t index;
+        xQueueReceive(free_queue, &index, portMAX_DELAY);
+    }
+    if (ret == ESP_OK && writer_failed) {
+        ESP_LOGE(TAG, "Write error during copy");
+        ret = ESP_FAIL;
+    }
+    writer_fd = -1;
+    return ret;
+}
+
+esp_err_t copy_engine_copy(const char *src_full, const char *dst_full, uint32_t flags,
+                           copy_engine_progress_cb_t progress_cb, void *user_data,
+                           copy_engine_stats_t *stats) {
+    if (!ensure_engine()) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    // fstat() of the open file, rather than looking the path up a second time
+    struct stat st;
+    int src = open(src_full, O_RDONLY);
+    if (src < 0 || fstat(src, &st) != 0) {
+        if (src >= 0) {
+            close(src);
+        }
+        ESP_LOGE(TAG, "Failed to open source file: %s", src_full);
+        return ESP_FAIL;
+    }
+    uint64_t size = (uint64_t)st.st_size;
+    // An existing destination is replaced, and its clusters given back
+    uint64_t replaced = stat(dst_full, &st) == 0 ? (uint64_t)st.st_size : 0;
+
+    xSemaphoreTake(engine_lock, portMAX_DELAY);
+    int64_t start = esp_timer_get_time();
+
+    // Without the writer nothing would free buffers kept after the copy
+    bool keep = ensure_writer();
+    int wanted = keep ? COPY_ENGINE_BUFFERS : 1;
+    if (buffer_count < wanted) {
+        free_buffers();
+        if (alloc_buffers(COPY_ENGINE_CHUNK_SIZE, wanted) == 0) {
+            close(src);
+            xSemaphoreGive(engine_lock);
+            ESP_LOGE(TAG, "No memory for copy buffers");
+            return ESP_ERR_NO_MEM;
+        }
+        if (keep) {
+            uint32_t holding = COPY_ENGINE_HOLDING;
+            xQueueSend(filled_queue, &holding, portMAX_DELAY);
+        }
+    }
+    size_t chunk = buffer_chunk;
+    // A file that fits in one chunk is one read and one write: no handoff,
+    // and nothing to gain from reserving its clusters first
+    bool single_chunk = size <= chunk;
+
+    bool contiguous = false;
+    int dst = single_chunk ? open(dst_full, O_WRONLY | O_CREAT | O_TRUNC, 0644)
+                           : open_destination(dst_full, size, &contiguous);
+    if (dst < 0) {
+        close(src);
+        if (!keep) {
+            free_buffers();
+        }
+        if (remove(dst_full) == 0) {
+            sd_space_note_file(replaced, 0);
+        }
+        xSemaphoreGive(engine_lock);
+        ESP_LOGE(TAG, "Failed to open destination file: %s", dst_full);
+        return ESP_FAIL;
+    }
+
+    uint64_t copied = 0;
+    copy_progress_t progress = {
+        .cb = progress_cb,
+        .user_data = user_data,
+        .hash = (flags & COPY_ENGINE_HASH) != 0,
+        .crc = 0
+    };
+    // An empty source only needs its destination created
+    esp_err_t ret = ESP_OK;
+    if (!single_chunk && buffer_count > 1) {
+        ret = copy_pipelined(src, dst, chunk, &progress, &copied);
+    } else if (size > 0) {
+        ret = copy_single(src, dst, chunk, &progress, &copied);
+    }
+
+    // The source may have shrunk since it was measured; drop the unused tail
+    if (ret == ESP_OK && copied < size && ftruncate(dst, (off_t)copied) != 0) {
+        ESP_LOGE(TAG, "Failed to trim destination file: %s", dst_full);
+        ret = ESP_FAIL;
+    }
+
+    close(src);
+    if (close(dst) != 0 && ret == ESP_OK) {
+        ret = ESP_FAIL;
+    }
+    if (keep) {
+        last_copy_us = esp_timer_get_time();
+    } else {
+        free_buffers();
+    }
+    if (ret == ESP_OK) {
+        sd_space_note_file(replaced, copied);
+    } else if (remove(dst_full) == 0) {
+        sd_space_note_file(replaced, 0);
+    }
+
+    if (stats) {
+        stats->bytes = copied;
+        stats->elapsed_ms = (uint32_t)((esp_timer_get_time() - start) / 1000);
+        stats->chunk_size = (uint32_t)chunk;
+        stats->contiguous = contiguous;
+        stats->crc = progress.crc;
+    }
+    xSemaphoreGive(engine_lock);
+    return ret;
+}
+
+float copy_engine_mb_per_s(const copy_engine_stats_t *stats) {
+    if (stats->elapsed_ms == 0) {
+        return 0.0f;
+    }
+    return (float)stats->bytes / (1024.0f * 1024.0f) / (stats->elapsed_ms / 1000.0f);
+}
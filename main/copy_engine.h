@@ -0,0 +1,59 @@
+#ifndef COPY_ENGINE_H
+#define COPY_ENGINE_H
+
+#include "esp_err.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+// Flags for copy_engine_copy()
+#define COPY_ENGINE_HASH   (1 << 0)    // CRC32 the data as it is read, for verifying the copy
+
+typedef struct {
+    uint64_t bytes;         // Bytes copied
+    uint32_t elapsed_ms;    // Wall time from open to close
+    uint32_t chunk_size;    // Transfer size used
+    bool contiguous;        // Destination was preallocated as one contiguous run
+    uint32_t crc;           // CRC32 of the bytes copied (COPY_ENGINE_HASH only)
+} copy_engine_stats_t;
+
+/**
+ * @brief Called after each chunk is read
+ * @param bytes_done Bytes of the file handed to the writer so far
+ * @param user_data User data passed to copy_engine_copy()
+ * @return true to continue, false to abandon the copy
+ */
+typedef bool (*copy_engine_progress_cb_t)(uint64_t bytes_done, void *user_data);
+
+/**
+ * @brief Copy one file at close to the card's sequential speed
+ *
+ * The destination is preallocated up front (contiguously when the free space
+ * allows), then filled through two large DMA-capable buffers: the calling
+ * task reads the next chunk while a worker writes the previous one. A file
+ * that fits in one chunk is simply read and written. The buffers are kept
+ * for a couple of seconds after a copy, so a run of copies allocates them
+ * once. Only one copy runs at a time; concurrent callers wait their turn.
+ * A failed copy removes the partial destination.
+ *
+ * @param src_full Absolute source path (including the mount point)
+ * @param dst_full Absolute destination path (including the mount point)
+ * @param flags COPY_ENGINE_* flags, 0 for a plain copy
+ * @param progress_cb Progress callback, can abandon the copy (can be NULL)
+ * @param user_data User data for the callback
+ * @param stats Output transfer statistics (can be NULL)
+ * @return ESP_OK on success, ESP_ERR_INVALID_STATE if abandoned by the
+ *         callback, ESP_ERR_NO_MEM if no transfer buffer could be allocated,
+ *         ESP_FAIL on I/O errors
+ */
+esp_err_t copy_engine_copy(const char *src_full, const char *dst_full, uint32_t flags,
+                           copy_engine_progress_cb_t progress_cb, void *user_data,
+                           copy_engine_stats_t *stats);
+
+/**
+ * @brief Throughput of a finished copy
+ * @param stats Statistics from copy_engine_copy()
+ * @return Megabytes (2^20 bytes) per second, 0 if too quick to measure
+ */
+float copy_engine_mb_per_s(const copy_engine_stats_t *stats);
+
+#endif // COPY_ENGINE_H
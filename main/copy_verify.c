@@ -0,0 +1,234 @@
+#include "copy_verify.h"
+#include "sd_manager.h"
+#include "sd_io.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_heap_caps.h"
+#include "esp_rom_crc.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+#include <fcntl.h>
+#include <unistd.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+
+static const char *TAG = "COPY_VERIFY";
+
+#define COPY_VERIFY_QUEUE_LEN      16
+#define COPY_VERIFY_PATH_LEN       (256 + sizeof(SD_MOUNT_POINT))
+#define COPY_VERIFY_BUFFER_SIZE    (32 * 1024)
+#define COPY_VERIFY_ALIGN          64      // Cache line; keeps the SDMMC driver from bouncing
+#define COPY_VERIFY_TASK_STACK     3072
+#define COPY_VERIFY_TASK_PRIORITY  3       // Below the copy writers: reads back in their gaps
+
+/*
+ * Requests carry their path by value, so the caller's buffers are free as
+ * soon as copy_verify_queue() returns. A request with an empty path is a
+ * barrier: the worker answers it on barrier_done once everything queued
+ * before it has been checked. The failure list and counts are written by
+ * the worker only and read by the session owner after a barrier.
+ */
+typedef struct {
+    char path[COPY_VERIFY_PATH_LEN];
+    uint64_t size;
+    uint32_t crc;
+} verify_request_t;
+
+static SemaphoreHandle_t verify_lock = NULL;
+static SemaphoreHandle_t barrier_done = NULL;
+static QueueHandle_t request_queue = NULL;
+static TaskHandle_t verify_task = NULL;
+
+// Owned by the session holding verify_lock
+static uint8_t *buffer = NULL;
+static copy_verify_stats_t session;
+static uint64_t busy_us = 0;
+static char *failures = NULL;          // Failed paths, back to back
+static uint32_t failures_used = 0;
+static uint32_t failures_size = 0;
+
+static bool grow_array(void **array, uint32_t *capacity, uint32_t needed, size_t elem_size) {
+    if (needed <= *capacity) {
+        return true;
+    }
+    uint32_t new_capacity = *capacity ? *capacity * 2 : 16;
+    while (new_capacity < needed) {
+        new_capacity *= 2;
+    }
+    void *grown = realloc(*array, (size_t)new_capacity * elem_size);
+    if (!grown) {
+        return false;
+    }
+    *array = grown;
+    *capacity = new_capacity;
+    return true;
+}
+
+static bool verify_file(const verify_request_t *request) {
+    int fd = open(request->path, O_RDONLY);
+    if (fd < 0) {
+        ESP_LOGE(TAG, "Cannot reopen %s to verify", request->path);
+        return false;
+    }
+    uint64_t total = 0;
+    uint32_t crc = 0;
+    ssize_t got;
+    for (;;) {
+        // Read-back is bulk work like the copy it checks
+        sd_io_begin(SD_IO_BULK);
+        got = read(fd, buffer, COPY_VERIFY_BUFFER_SIZE);
+        sd_io_end(SD_IO_BULK);
+        if (got <= 0) {
+            break;
+        }
+        crc = esp_rom_crc32_le(crc, buffer, (uint32_t)got);
+        total += (uint64_t)got;
+    }
+    close(fd);
+    session.bytes += total;
+
+    if (got < 0 || total != request->size || crc != request->crc) {
+        ESP_LOGE(TAG, "Verify failed: %s (%" PRIu64 "/%" PRIu64 " bytes, crc %08" PRIx32 "/%08" PRIx32 ")",
+                 request->path, total, request->size, crc, request->crc);
+        return false;
+    }
+    return true;
+}
+
+static void note_failure(const char *path) {
+    uint32_t len = (uint32_t)strlen(path) + 1;
+    // The count is what matters; a path that does not fit is only missing from the list
+    if (grow_array((void **)&failures, &failures_size, failures_used + len, 1)) {
+        memcpy(failures + failures_used, path, len);
+        failures_used += len;
+    }
+    session.failed++;
+}
+
+static void copy_verify_task(void *arg) {
+    (void)arg;
+    verify_request_t request;
+
+    for (;;) {
+        xQueueReceive(request_queue, &request, portMAX_DELAY);
+        if (request.path[0] == '\0') {
+            xSemaphoreGive(barrier_done);
+            continue;
+        }
+        int64_t start = esp_timer_get_time();
+        if (verify_file(&request)) {
+            session.files++;
+        } else {
+            note_failure(request.path);
+        }
+        busy_us += (uint64_t)(esp_timer_get_time() - start);
+    }
+}
+
+static bool ensure_verifier(void) {
+    if (!verify_lock) {
+        verify_lock = xSemaphoreCreateMutex();
+        barrier_done = xSemaphoreCreateBinary();
+        if (!verify_lock || !barrier_done) {
+            ESP_LOGE(TAG, "Failed to create verify locks");
+            return false;
+        }
+    }
+    if (!request_queue) {
+        request_queue = xQueueCreate(COPY_VERIFY_QUEUE_LEN, sizeof(verify_request_t));
+        if (!request_queue) {
+            ESP_LOGE(TAG, "Failed to create verify queue");
+            return false;
+        }
+    }
+    if (verify_task) {
+        return true;
+    }
+    // Pinned to CPU1 like the other long-running workers, away from LVGL
+    BaseType_t result = xTaskCreatePinnedToCore(copy_verify_task, "copy_verify", COPY_VERIFY_TASK_STACK,
+                                                NULL, COPY_VERIFY_TASK_PRIORITY, &verify_task, 1);
+    if (result != pdPASS) {
+        ESP_LOGE(TAG, "Failed to create verify task");
+        verify_task = NULL;
+        return false;
+    }
+    return true;
+}
+
+esp_err_t copy_verify_begin(void) {
+    if (!ensure_verifier()) {
+        return ESP_ERR_NO_MEM;
+    }
+    xSemaphoreTake(verify_lock, portMAX_DELAY);
+    buffer = heap_caps_aligned_alloc(COPY_VERIFY_ALIGN, COPY_VERIFY_BUFFER_SIZE,
+                                     MALLOC_CAP_DMA | MALLOC_CAP_INTERNAL);
+    if (!buffer) {
+        buffer = heap_caps_aligned_alloc(COPY_VERIFY_ALIGN, COPY_VERIFY_BUFFER_SIZE,
+                                         MALLOC_CAP_DMA | MALLOC_CAP_SPIRAM);
+    }
+    if (!buffer) {
+        xSemaphoreGive(verify_lock);
+        ESP_LOGW(TAG, "No memory for verify buffer");
+        return ESP_ERR_NO_MEM;
+    }
+    memset(&session, 0, sizeof(session));
+    busy_us = 0;
+    failures_used = 0;
+    return ESP_OK;
+}
+
+// Time blocked here is the part of verification the copy could not hide
+static void send_request(const verify_request_t *request) {
+    int64_t start = esp_timer_get_time();
+    if (xQueueSend(request_queue, request, 0) != pdTRUE) {
+        xQueueSend(request_queue, request, portMAX_DELAY);
+        session.wait_ms += (uint32_t)((esp_timer_get_time() - start) / 1000);
+    }
+}
+
+esp_err_t copy_verify_queue(const char *dst_full, uint64_t size, uint32_t crc) {
+    verify_request_t request = { .size = size, .crc = crc };
+    size_t len = strlen(dst_full);
+    if (len == 0 || len >= sizeof(request.path)) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    memcpy(request.path, dst_full, len + 1);
+    send_request(&request);
+    return ESP_OK;
+}
+
+uint32_t copy_verify_sync(void) {
+    static const verify_request_t barrier = { .path = "" };
+    int64_t start = esp_timer_get_time();
+    send_request(&barrier);
+    xSemaphoreTake(barrier_done, portMAX_DELAY);
+    session.wait_ms += (uint32_t)((esp_timer_get_time() - start) / 1000);
+    return session.failed;
+}
+
+esp_err_t copy_verify_end(copy_verify_fail_cb_t fail_cb, void *user_data, copy_verify_stats_t *stats) {
+    copy_verify_sync();
+    session.busy_ms = (uint32_t)(busy_us / 1000);
+
+    if (fail_cb) {
+        for (uint32_t offset = 0; offset < failures_used; offset += (uint32_t)strlen(failures + offset) + 1) {
+            fail_cb(failures + offset, user_data);
+        }
+    }
+    copy_verify_stats_t result = session;
+    free(failures);
+    failures = NULL;
+    failures_used = failures_size = 0;
+    heap_caps_free(buffer);
+    buffer = NULL;
+    xSemaphoreGive(verify_lock);
+
+    if (stats) {
+        *stats = result;
+    }
+    return result.failed ? ESP_FAIL : ESP_OK;
+}
@@ -0,0 +1,67 @@
+#ifndef COPY_VERIFY_H
+#define COPY_VERIFY_H
+
+#include "esp_err.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+typedef struct {
+    uint32_t files;         // Files read back and matched
+    uint32_t failed;        // Files whose size or CRC32 did not match, or could not be read
+    uint64_t bytes;         // Bytes read back
+    uint32_t busy_ms;       // Time the verifier spent reading and hashing
+    uint32_t wait_ms;       // Time the copier spent waiting on the verifier
+} copy_verify_stats_t;
+
+/**
+ * @brief Called once for every file that failed verification
+ * @param dst_full Absolute path of the bad copy
+ * @param user_data User data passed to copy_verify_end()
+ */
+typedef void (*copy_verify_fail_cb_t)(const char *dst_full, void *user_data);
+
+/**
+ * @brief Start a verified copy session
+ *
+ * Finished copies are queued with the CRC32 of their source, computed while
+ * the source was read. A verifier task reads each destination back from the
+ * card and compares, while the caller goes on copying the next file, so
+ * verification mostly hides behind the copy rather than adding to it. Only
+ * one session runs at a time; concurrent callers wait their turn.
+ *
+ * @return ESP_OK on success, ESP_ERR_NO_MEM if the verifier could not start
+ */
+esp_err_t copy_verify_begin(void);
+
+/**
+ * @brief Queue a finished copy for reading back
+ *
+ * Waits if the verifier has fallen too far behind.
+ *
+ * @param dst_full Absolute destination path (including the mount point); must be closed
+ * @param size Bytes copied
+ * @param crc CRC32 of the source data (esp_rom_crc32_le, seeded with 0)
+ * @return ESP_OK if queued, ESP_ERR_INVALID_SIZE if the path is too long
+ */
+esp_err_t copy_verify_queue(const char *dst_full, uint64_t size, uint32_t crc);
+
+/**
+ * @brief Wait until every queued copy has been checked
+ *
+ * For callers that must not go on until the copies so far are known good,
+ * e.g. before removing the originals of a move.
+ *
+ * @return Failures so far in this session
+ */
+uint32_t copy_verify_sync(void);
+
+/**
+ * @brief Check the remaining copies and finish the session
+ * @param fail_cb Called for each file that failed (can be NULL)
+ * @param user_data Passed through to fail_cb
+ * @param stats Output counts for the whole session (can be NULL)
+ * @return ESP_OK if every copy matched, ESP_FAIL otherwise
+ */
+esp_err_t copy_verify_end(copy_verify_fail_cb_t fail_cb, void *user_data, copy_verify_stats_t *stats);
+
+#endif // COPY_VERIFY_H
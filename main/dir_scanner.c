@@ -0,0 +1,188 @@
+#include "dir_scanner.h"
+#include "sd_manager.h"
+#include "sd_io.h"
+#include "esp_log.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include <string.h>
+#include <inttypes.h>
+
+static const char *TAG = "DIR_SCANNER";
+
+#define DIR_SCANNER_TASK_STACK    4096
+#define DIR_SCANNER_TASK_PRIORITY 3     // Below the LVGL task
+#define DIR_SCANNER_PATH_LEN      256
+
+/*
+ * One long-lived worker enumerates into its own listing under scan_lock; the
+ * UI copies new entries out in bounded batches. Every start bumps
+ * scan_generation, which the enumeration callback checks per entry, so a new
+ * navigation aborts the old scan within one directory entry.
+ */
+static SemaphoreHandle_t scan_lock = NULL;
+static TaskHandle_t scan_task = NULL;
+static volatile uint32_t scan_generation = 0;
+
+// Protected by scan_lock
+static char scan_path[DIR_SCANNER_PATH_LEN];
+static bool scan_show_hidden = false;
+static file_listing_t worker_listing = {0};
+static uint32_t worker_generation = 0;
+static dir_scan_state_t worker_state = DIR_SCAN_DONE;
+static bool worker_truncated = false;
+
+static bool scan_entry_cb(const sd_dir_entry_t *entry, void *user_data) {
+    uint32_t generation = (uint32_t)(uintptr_t)user_data;
+    if (scan_generation != generation) {
+        return false;
+    }
+
+    xSemaphoreTake(scan_lock, portMAX_DELAY);
+    esp_err_t ret = file_listing_add(&worker_listing, entry->name, entry->size,
+                                     (uint32_t)entry->mtime, entry->is_directory);
+    if (ret == ESP_OK && (entry->attributes & SD_ATTR_READONLY)) {
+        worker_listing.flags[worker_listing.count - 1] |= FILE_LISTING_FLAG_READONLY;
+    }
+    xSemaphoreGive(scan_lock);
+
+    if (ret != ESP_OK) {
+        worker_truncated = true;
+        ESP_LOGE(TAG, "Out of memory, scan truncated at %" PRIu32 " entries", worker_listing.count);
+        return false;
+    }
+    return true;
+}
+
+static void dir_scanner_task(void *arg) {
+    (void)arg;
+    char path[DIR_SCANNER_PATH_LEN];
+
+    for (;;) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+        xSemaphoreTake(scan_lock, portMAX_DELAY);
+        uint32_t generation = scan_generation;
+        strcpy(path, scan_path);
+        bool show_hidden = scan_show_hidden;
+        file_listing_clear(&worker_listing);
+        worker_generation = generation;
+        worker_state = DIR_SCAN_RUNNING;
+        worker_truncated = false;
+        xSemaphoreGive(scan_lock);
+
+        uint32_t start = esp_log_timestamp();
+        // The user is looking at this one: bulk and background work hold off until it is done
+        sd_io_begin(SD_IO_INTERACTIVE);
+        int result = sd_manager_enumerate(path, show_hidden, scan_entry_cb, (void *)(uintptr_t)generation);
+        sd_io_end(SD_IO_INTERACTIVE);
+
+        xSemaphoreTake(scan_lock, portMAX_DELAY);
+        if (scan_generation != generation) {
+            worker_state = DIR_SCAN_CANCELLED;
+        } else {
+            // A truncated (out of memory) scan still delivers what it has
+            worker_state = (result < 0 || worker_truncated) ? DIR_SCAN_FAILED : DIR_SCAN_DONE;
+        }
+        uint32_t count = worker_listing.count;
+        bool cancelled = worker_state == DIR_SCAN_CANCELLED;
+        xSemaphoreGive(scan_lock);
+
+        ESP_LOGI(TAG, "Scan of %s: %" PRIu32 " entries in %" PRIu32 " ms%s", path, count,
+                 esp_log_timestamp() - start, cancelled ? " (cancelled)" : "");
+    }
+}
+
+static bool ensure_worker(void) {
+    if (scan_task) {
+        return true;
+    }
+
+    if (!scan_lock) {
+        scan_lock = xSemaphoreCreateMutex();
+        if (!scan_lock) {
+            ESP_LOGE(TAG, "Failed to create scan lock");
+            return false;
+        }
+    }
+
+    // Pinned to CPU1 like the other long-running workers, away from LVGL
+    BaseType_t result = xTaskCreatePinnedToCore(dir_scanner_task, "dir_scan", DIR_SCANNER_TASK_STACK,
+                                                NULL, DIR_SCANNER_TASK_PRIORITY, &scan_task, 1);
+    if (result != pdPASS) {
+        ESP_LOGE(TAG, "Failed to create scanner task");
+        scan_task = NULL;
+        return false;
+    }
+    return true;
+}
+
+uint32_t dir_scanner_start(const char *path, bool show_hidden) {
+    if (!ensure_worker()) {
+        return 0;
+    }
+
+    xSemaphoreTake(scan_lock, portMAX_DELAY);
+    uint32_t generation = scan_generation + 1;
+    if (generation == 0) {
+        generation = 1; // 0 is reserved for "no scan"
+    }
+    scan_generation = generation;
+    strncpy(scan_path, path, sizeof(scan_path) - 1);
+    scan_path[sizeof(scan_path) - 1] = '\0';
+    scan_show_hidden = show_hidden;
+    xSemaphoreGive(scan_lock);
+
+    xTaskNotifyGive(scan_task);
+    return generation;
+}
+
+void dir_scanner_cancel(void) {
+    if (!scan_lock) {
+        return;
+    }
+    xSemaphoreTake(scan_lock, portMAX_DELAY);
+    scan_generation++;
+    xSemaphoreGive(scan_lock);
+}
+
+dir_scan_state_t dir_scanner_poll(uint32_t scan_id, file_listing_t *dest, uint32_t max_entries) {
+    if (scan_id == 0 || !scan_lock) {
+        return DIR_SCAN_CANCELLED;
+    }
+
+    xSemaphoreTake(scan_lock, portMAX_DELAY);
+    if (scan_generation != scan_id) {
+        xSemaphoreGive(scan_lock);
+        return DIR_SCAN_CANCELLED;
+    }
+    if (worker_generation != scan_id) {
+        // Worker has not picked this scan up yet
+        xSemaphoreGive(scan_lock);
+        return DIR_SCAN_RUNNING;
+    }
+
+    dir_scan_state_t state = worker_state;
+    uint32_t end = worker_listing.count;
+    if (end - dest->count > max_entries) {
+        end = dest->count + max_entries;
+    }
+    bool copy_failed = false;
+    while (dest->count < end) {
+        if (file_listing_copy_entry(dest, &worker_listing, dest->count) != ESP_OK) {
+            ESP_LOGE(TAG, "Out of memory copying scan results");
+            copy_failed = true;
+            break;
+        }
+    }
+    if (copy_failed) {
+        // Stop here and show what fits
+        state = DIR_SCAN_FAILED;
+    } else if (dest->count < worker_listing.count) {
+        // Done or failed, the caller still gets every entry found before it ends the scan
+        state = DIR_SCAN_RUNNING;
+    }
+    xSemaphoreGive(scan_lock);
+
+    return state;
+}
@@ -0,0 +1,51 @@
+#ifndef DIR_SCANNER_H
+#define DIR_SCANNER_H
+
+#include "esp_err.h"
+#include "file_listing.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+// Entries handed to the UI per poll; keeps each poll well inside one frame
+#define DIR_SCANNER_POLL_BATCH 256
+
+// UI poll period, matched to the LVGL refresh period
+#define DIR_SCANNER_POLL_MS 33
+
+typedef enum {
+    DIR_SCAN_RUNNING,     // More entries may follow
+    DIR_SCAN_DONE,        // All entries delivered
+    DIR_SCAN_FAILED,      // Directory could not be read completely (entries so far delivered)
+    DIR_SCAN_CANCELLED    // Superseded by a newer scan or cancelled
+} dir_scan_state_t;
+
+/**
+ * @brief Start scanning a directory on the background worker
+ *
+ * Any scan still in flight is cancelled; its id stops being valid.
+ *
+ * @param path Directory path (relative to SD root)
+ * @param show_hidden Include hidden files (starting with '.')
+ * @return Scan id to pass to dir_scanner_poll(), 0 if the worker could not start
+ */
+uint32_t dir_scanner_start(const char *path, bool show_hidden);
+
+/**
+ * @brief Cancel the scan in flight, if any
+ */
+void dir_scanner_cancel(void);
+
+/**
+ * @brief Move newly scanned entries into a UI-side listing
+ *
+ * Appends up to max_entries entries that dest does not have yet, in
+ * directory order. Call from the UI thread (e.g. an lv_timer).
+ *
+ * @param scan_id Id returned by dir_scanner_start()
+ * @param dest Listing being filled (must start empty for this scan)
+ * @param max_entries Maximum entries to append in this call
+ * @return Scan state; DIR_SCAN_DONE or DIR_SCAN_FAILED only once dest holds every entry
+ */
+dir_scan_state_t dir_scanner_poll(uint32_t scan_id, file_listing_t *dest, uint32_t max_entries);
+
+#endif // DIR_SCANNER_H
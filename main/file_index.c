@@ -0,0 +1,1071 @@
+#include "file_index.h"
+#include "thumbnail.h"
+#include "name_filter.h"
+#include "listing_cache.h"
+#include "sd_manager.h"
+#include "sd_space.h"
+#include "sd_io.h"
+#include "esp_log.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "freertos/queue.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <ctype.h>
+#include <inttypes.h>
+#include <sys/stat.h>
+
+static const char *TAG = "FILE_INDEX";
+
+#define FILE_INDEX_TASK_STACK    6144
+#define FILE_INDEX_TASK_PRIORITY 2      // Below the directory scanner
+#define FILE_INDEX_PATH_LEN      256
+#define FILE_INDEX_QUEUE_LEN     16
+#define FILE_INDEX_MAX_DEPTH     32
+#define FILE_INDEX_IO_BUFFER     (16 * 1024)
+#define FILE_INDEX_STOP_TIMEOUT_MS 10000
+
+#define FILE_INDEX_MAGIC   0x58493554   // "T5IX"
+#define FILE_INDEX_VERSION 2
+
+// Parent of top-level entries
+#define INDEX_ROOT UINT32_MAX
+
+// Per-entry state bits
+#define ENTRY_DELETED 0x01
+#define ENTRY_UNSEEN  0x02  // Scratch mark while the parent is rescanned
+#define ENTRY_CHECKED 0x04  // Directory compared with the card since mount
+
+/*
+ * The index is a flat table of entries, each pointing at its parent
+ * directory, so every path prefix is stored once. Names, sizes, times and
+ * types reuse file_listing_t; the parent links and tombstones sit alongside.
+ * Entries are only ever appended, which keeps every parent ahead of its
+ * children; removals are tombstoned and squeezed out before a save.
+ * Each directory also chains its children through first_child and
+ * next_sibling, so looking at one directory or one subtree only touches
+ * the entries in it. A tombstoned entry is unlinked from its parent's
+ * chain, which leaves the chains holding live entries only.
+ *
+ * Only the worker task changes the table. It takes index_lock for every
+ * change, and searches take it to read, so a search never waits for more
+ * than one entry or one directory's bookkeeping.
+ *
+ * Changes made through file_operations are queued explicitly. Changes made
+ * elsewhere (another computer) are found by reading the root on mount,
+ * descending into subdirectories whose stamp moved, and reading every other
+ * directory the first time it is opened after the mount. FAT does not
+ * always update a directory's stamp, so until a directory is opened this
+ * is best effort.
+ */
+typedef enum {
+    MSG_START,
+    MSG_RESCAN,
+    MSG_CHECK,
+    MSG_STOP
+} index_msg_type_t;
+
+typedef struct {
+    index_msg_type_t type;
+    uint32_t seq;
+    char path[FILE_INDEX_PATH_LEN];
+} index_msg_t;
+
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t count;
+} index_file_header_t;
+
+typedef struct __attribute__((packed)) {
+    uint32_t parent;
+    uint64_t size;
+    uint32_t mtime;
+    uint8_t flags;
+    uint8_t name_len;
+} index_file_record_t;
+
+static SemaphoreHandle_t index_lock = NULL;
+static SemaphoreHandle_t stop_done = NULL;
+static QueueHandle_t index_queue = NULL;
+static TaskHandle_t index_task = NULL;
+static volatile uint32_t index_generation = 0;
+static volatile bool queue_overflowed = false;
+
+// Protected by index_lock
+static file_listing_t entries = {0};
+static uint32_t *parents = NULL;
+static uint32_t *first_child = NULL;    // Newest child of each directory
+static uint32_t *next_sibling = NULL;   // Next older child of the same parent
+static uint32_t root_first_child = INDEX_ROOT;
+static uint8_t *entry_state = NULL;
+static uint32_t meta_capacity = 0;
+static uint32_t deleted_count = 0;
+static name_filter_t folded_names = {0};
+static uint32_t *match_bits = NULL;
+static uint32_t match_bits_words = 0;
+static file_index_state_t index_state = FILE_INDEX_OFFLINE;
+static char last_noted[FILE_INDEX_PATH_LEN] = "";
+static uint32_t last_noted_seq = 0;
+static volatile uint32_t consumed_seq = 0;
+
+// Worker only
+static uint32_t worker_generation = 0;
+static bool unsaved = false;
+static uint32_t *pending_dirs = NULL;
+static uint32_t pending_count = 0;
+static uint32_t pending_capacity = 0;
+
+static inline bool entry_live(uint32_t id) {
+    return !(entry_state[id] & ENTRY_DELETED);
+}
+
+// Head of a directory's chain of children
+static inline uint32_t *child_list(uint32_t dir_id) {
+    return dir_id == INDEX_ROOT ? &root_first_child : &first_child[dir_id];
+}
+
+// Next entry of a depth-first walk below top, INDEX_ROOT when done
+static uint32_t next_in_subtree(uint32_t id, uint32_t top) {
+    if (first_child[id] != INDEX_ROOT) {
+        return first_child[id];
+    }
+    for (; id != top; id = parents[id]) {
+        if (next_sibling[id] != INDEX_ROOT) {
+            return next_sibling[id];
+        }
+    }
+    return INDEX_ROOT;
+}
+
+static inline bool walk_cancelled(void) {
+    return index_generation != worker_generation;
+}
+
+static void set_state(file_index_state_t state) {
+    xSemaphoreTake(index_lock, portMAX_DELAY);
+    index_state = state;
+    xSemaphoreGive(index_lock);
+}
+
+// Call with index_lock held
+static void release_index(void) {
+    file_listing_free(&entries);
+    free(parents);
+    free(first_child);
+    free(next_sibling);
+    free(entry_state);
+    parents = NULL;
+    first_child = NULL;
+    next_sibling = NULL;
+    root_first_child = INDEX_ROOT;
+    entry_state = NULL;
+    meta_capacity = 0;
+    deleted_count = 0;
+    name_filter_free(&folded_names);
+    free(match_bits);
+    match_bits = NULL;
+    match_bits_words = 0;
+}
+
+static bool grow_links(uint32_t **links, uint32_t capacity) {
+    uint32_t *grown = realloc(*links, capacity * sizeof(uint32_t));
+    if (!grown) {
+        return false;
+    }
+    *links = grown;
+    return true;
+}
+
+// Put an entry at the head of its parent's chain; call with index_lock held
+static void link_child(uint32_t id) {
+    uint32_t *head = child_list(parents[id]);
+    first_child[id] = INDEX_ROOT;
+    next_sibling[id] = *head;
+    *head = id;
+}
+
+// Call with index_lock held
+static uint32_t add_entry(uint32_t parent, const char *name, uint64_t size, uint32_t mtime,
+                          uint8_t flags) {
+    if (entries.count >= meta_capacity) {
+        uint32_t capacity = meta_capacity ? meta_capacity * 2 : 256;
+        if (!grow_links(&parents, capacity) || !grow_links(&first_child, capacity) ||
+            !grow_links(&next_sibling, capacity)) {
+            return INDEX_ROOT;
+        }
+        uint8_t *new_state = realloc(entry_state, capacity);
+        if (!new_state) {
+            return INDEX_ROOT;
+        }
+        entry_state = new_state;
+        meta_capacity = capacity;
+    }
+
+    if (file_listing_add(&entries, name, size, mtime, flags & FILE_LISTING_FLAG_DIRECTORY) != ESP_OK) {
+        return INDEX_ROOT;
+    }
+    uint32_t id = entries.count - 1;
+    entries.flags[id] = flags;
+    parents[id] = parent;
+    entry_state[id] = 0;
+    link_child(id);
+    return id;
+}
+
+// Tombstone an unlinked entry and everything below it; call with index_lock held
+static uint32_t delete_subtree(uint32_t top) {
+    uint32_t removed = 0;
+    for (uint32_t id = top; id != INDEX_ROOT; id = next_in_subtree(id, top)) {
+        entry_state[id] |= ENTRY_DELETED;
+        removed++;
+    }
+    return removed;
+}
+
+// Paths are rebuilt from the parent links; returns false if it does not fit
+static bool build_path(uint32_t id, char *buf, size_t size) {
+    uint32_t chain[FILE_INDEX_MAX_DEPTH];
+    int depth = 0;
+    for (uint32_t cur = id; cur != INDEX_ROOT; cur = parents[cur]) {
+        if (depth == FILE_INDEX_MAX_DEPTH) {
+            return false;
+        }
+        chain[depth++] = cur;
+    }
+
+    size_t len = 0;
+    if (depth == 0) {
+        return snprintf(buf, size, "/") < (int)size;
+    }
+    while (depth > 0) {
+        int written = snprintf(buf + len, size - len, "/%s", file_listing_name(&entries, chain[--depth]));
+        if (written < 0 || (size_t)written >= size - len) {
+            return false;
+        }
+        len += written;
+    }
+    return true;
+}
+
+static bool push_pending(uint32_t dir_id) {
+    if (pending_count == pending_capacity) {
+        uint32_t capacity = pending_capacity ? pending_capacity * 2 : 64;
+        uint32_t *grown = realloc(pending_dirs, capacity * sizeof(uint32_t));
+        if (!grown) {
+            ESP_LOGE(TAG, "Failed to queue directory for indexing");
+            return false;
+        }
+        pending_dirs = grown;
+        pending_capacity = capacity;
+    }
+    pending_dirs[pending_count++] = dir_id;
+    return true;
+}
+
+static uint32_t name_hash(const char *name) {
+    // FNV-1a over the case-folded name, FAT names are case-insensitive
+    uint32_t hash = 2166136261u;
+    for (const char *p = name; *p; p++) {
+        hash = (hash ^ (uint8_t)tolower((unsigned char)*p)) * 16777619u;
+    }
+    return hash;
+}
+
+typedef struct {
+    uint32_t dir_id;
+    uint32_t *slots;        // Open-addressed table of the directory's children
+    uint32_t mask;
+    bool at_root;
+    bool saw_thumbs;        // Root holds the thumbnail cache
+    bool failed;
+} rescan_ctx_t;
+
+static bool rescan_entry_cb(const sd_dir_entry_t *entry, void *user_data) {
+    rescan_ctx_t *ctx = (rescan_ctx_t *)user_data;
+    // Between directory entries is the only place a big directory can make way for a listing
+    sd_io_yield(SD_IO_BACKGROUND);
+    if (walk_cancelled()) {
+        return false;
+    }
+    if (ctx->at_root && strcasecmp(entry->name, FILE_INDEX_FILE + 1) == 0) {
+        return true;
+    }
+    if (ctx->at_root && strcasecmp(entry->name, THUMBNAIL_CACHE_DIR + 1) == 0) {
+        ctx->saw_thumbs = entry->is_directory;
+        return true;
+    }
+
+    uint8_t flags = (uint8_t)file_ops_get_file_type(entry->name, entry->is_directory) & FILE_LISTING_TYPE_MASK;
+    if (entry->is_directory) {
+        flags |= FILE_LISTING_FLAG_DIRECTORY;
+    }
+    if (entry->name[0] == '.') {
+        flags |= FILE_LISTING_FLAG_HIDDEN;
+    }
+    if (entry->attributes & SD_ATTR_READONLY) {
+        flags |= FILE_LISTING_FLAG_READONLY;
+    }
+
+    xSemaphoreTake(index_lock, portMAX_DELAY);
+    uint32_t found = INDEX_ROOT;
+    for (uint32_t slot = name_hash(entry->name) & ctx->mask; ctx->slots[slot] != INDEX_ROOT;
+         slot = (slot + 1) & ctx->mask) {
+        uint32_t id = ctx->slots[slot];
+        if ((entry_state[id] & ENTRY_UNSEEN) &&
+            file_listing_is_dir(&entries, id) == entry->is_directory &&
+            strcasecmp(file_listing_name(&entries, id), entry->name) == 0) {
+            found = id;
+            break;
+        }
+    }
+
+    bool descend = false;
+    uint32_t id = found;
+    if (found != INDEX_ROOT) {
+        entry_state[found] &= ~ENTRY_UNSEEN;
+        bool changed = entries.size[found] != entry->size ||
+                       entries.mtime[found] != (uint32_t)entry->mtime ||
+                       entries.flags[found] != flags;
+        // A directory whose stamp moved may have changed inside
+        descend = changed && entry->is_directory;
+        entries.size[found] = entry->size;
+        entries.mtime[found] = (uint32_t)entry->mtime;
+        entries.flags[found] = flags;
+        unsaved |= changed;
+    } else {
+        id = add_entry(ctx->dir_id, entry->name, entry->size, (uint32_t)entry->mtime, flags);
+        descend = entry->is_directory;
+        unsaved = true;
+    }
+    xSemaphoreGive(index_lock);
+
+    if (id == INDEX_ROOT) {
+        ESP_LOGE(TAG, "Out of memory, index incomplete");
+        ctx->failed = true;
+        return false;
+    }
+    if (descend && !push_pending(id)) {
+        ctx->failed = true;
+        return false;
+    }
+    return true;
+}
+
+// Bring one directory's direct children in line with the card
+static bool rescan_directory(uint32_t dir_id) {
+    char path[FILE_INDEX_PATH_LEN];
+    if (!build_path(dir_id, path, sizeof(path))) {
+        ESP_LOGW(TAG, "Path too deep or long, not indexed below entry %" PRIu32, dir_id);
+        return true;
+    }
+
+    // Mark the current children and hash them by name
+    uint32_t children = 0;
+    for (uint32_t id = *child_list(dir_id); id != INDEX_ROOT; id = next_sibling[id]) {
+        children++;
+    }
+    uint32_t table_size = 16;
+    while (table_size < children * 2) {
+        table_size *= 2;
+    }
+    rescan_ctx_t ctx = {
+        .dir_id = dir_id,
+        .slots = malloc(table_size * sizeof(uint32_t)),
+        .mask = table_size - 1,
+        .at_root = dir_id == INDEX_ROOT,
+        .saw_thumbs = false,
+        .failed = false
+    };
+    if (!ctx.slots) {
+        ESP_LOGE(TAG, "Out of memory rescanning %s", path);
+        return false;
+    }
+    memset(ctx.slots, 0xFF, table_size * sizeof(uint32_t));
+
+    xSemaphoreTake(index_lock, portMAX_DELAY);
+    for (uint32_t id = *child_list(dir_id); id != INDEX_ROOT; id = next_sibling[id]) {
+        entry_state[id] |= ENTRY_UNSEEN;
+        uint32_t slot = name_hash(file_listing_name(&entries, id)) & ctx.mask;
+        while (ctx.slots[slot] != INDEX_ROOT) {
+            slot = (slot + 1) & ctx.mask;
+        }
+        ctx.slots[slot] = id;
+    }
+    xSemaphoreGive(index_lock);
+
+    sd_io_begin(SD_IO_BACKGROUND);
+    int result = sd_manager_enumerate(path, true, rescan_entry_cb, &ctx);
+    sd_io_end(SD_IO_BACKGROUND);
+    free(ctx.slots);
+    bool complete = result >= 0 && !ctx.failed && !walk_cancelled();
+
+    // Children not seen on the card are gone, and so is everything below them
+    xSemaphoreTake(index_lock, portMAX_DELAY);
+    uint32_t removed = 0;
+    for (uint32_t *link = child_list(dir_id); *link != INDEX_ROOT; ) {
+        uint32_t id = *link;
+        if (!(entry_state[id] & ENTRY_UNSEEN)) {
+            link = &next_sibling[id];
+            continue;
+        }
+        entry_state[id] &= ~ENTRY_UNSEEN;
+        if (!complete) {
+            link = &next_sibling[id];
+            continue;
+        }
+        *link = next_sibling[id];
+        removed += delete_subtree(id);
+    }
+    if (removed) {
+        deleted_count += removed;
+        unsaved = true;
+    }
+    if (complete && dir_id != INDEX_ROOT) {
+        entry_state[dir_id] |= ENTRY_CHECKED;
+    }
+    xSemaphoreGive(index_lock);
+
+    if (result < 0 && !walk_cancelled()) {
+        ESP_LOGW(TAG, "Could not read %s", path);
+    }
+    // The index never looks inside the thumbnail cache, but it is the one
+    // worker that visits the root on every mount, so it keeps the cache capped
+    if (ctx.saw_thumbs && !walk_cancelled()) {
+        thumbnail_prune_cache();
+    }
+    return !ctx.failed;
+}
+
+// Rescan queued directories until none are left; new and changed
+// subdirectories found on the way are queued as well
+static void drain_pending(void) {
+    while (pending_count > 0 && !walk_cancelled()) {
+        uint32_t dir_id = pending_dirs[--pending_count];
+        if (dir_id != INDEX_ROOT && !entry_live(dir_id)) {
+            continue;
+        }
+        if (!rescan_directory(dir_id)) {
+            break;
+        }
+    }
+    pending_count = 0;
+}
+
+static uint32_t find_child(uint32_t parent, const char *name, size_t name_len) {
+    for (uint32_t id = *child_list(parent); id != INDEX_ROOT; id = next_sibling[id]) {
+        if (file_listing_is_dir(&entries, id)) {
+            const char *candidate = file_listing_name(&entries, id);
+            if (strlen(candidate) == name_len && strncasecmp(candidate, name, name_len) == 0) {
+                return id;
+            }
+        }
+    }
+    return INDEX_ROOT;
+}
+
+// Rescan the deepest indexed directory on the way to path. An opened
+// directory is left alone if it was compared with the card since mount.
+static void rescan_path(const char *path, bool opened) {
+    uint32_t dir_id = INDEX_ROOT;
+    bool found = true;
+    const char *p = path;
+    while (*p) {
+        while (*p == '/') {
+            p++;
+        }
+        size_t len = strcspn(p, "/");
+        if (len == 0) {
+            break;
+        }
+        uint32_t child = find_child(dir_id, p, len);
+        if (child == INDEX_ROOT) {
+            // Not indexed yet: rescanning the parent picks it up
+            found = false;
+            break;
+        }
+        dir_id = child;
+        p += len;
+    }
+
+    // The root is read on every mount
+    if (opened && found && (dir_id == INDEX_ROOT || (entry_state[dir_id] & ENTRY_CHECKED))) {
+        return;
+    }
+    if (push_pending(dir_id)) {
+        drain_pending();
+    }
+}
+
+// Read the root again and forget which directories were compared with the
+// card, so each is read again when it is next opened
+static void recheck_card(void) {
+    xSemaphoreTake(index_lock, portMAX_DELAY);
+    for (uint32_t i = 0; i < entries.count; i++) {
+        entry_state[i] &= ~ENTRY_CHECKED;
+    }
+    xSemaphoreGive(index_lock);
+
+    push_pending(INDEX_ROOT);
+    drain_pending();
+}
+
+// Squeeze out tombstones; call with index_lock held
+static esp_err_t compact_index(void) {
+    if (deleted_count == 0) {
+        return ESP_OK;
+    }
+
+    uint32_t live = entries.count - deleted_count;
+    file_listing_t packed = {0};
+    uint32_t *packed_parents = malloc((live ? live : 1) * sizeof(uint32_t));
+    uint32_t *packed_first = malloc((live ? live : 1) * sizeof(uint32_t));
+    uint32_t *packed_next = malloc((live ? live : 1) * sizeof(uint32_t));
+    uint8_t *packed_state = calloc(live ? live : 1, 1);
+    uint32_t *remap = malloc(entries.count * sizeof(uint32_t));
+    esp_err_t ret = (packed_parents && packed_first && packed_next && packed_state && remap) ?
+                    ESP_OK : ESP_ERR_NO_MEM;
+
+    for (uint32_t i = 0; i < entries.count && ret == ESP_OK; i++) {
+        if (!entry_live(i)) {
+            remap[i] = INDEX_ROOT;
+            continue;
+        }
+        ret = file_listing_copy_entry(&packed, &entries, i);
+        remap[i] = packed.count - 1;
+        packed_parents[packed.count - 1] = parents[i] == INDEX_ROOT ? INDEX_ROOT : remap[parents[i]];
+        packed_state[packed.count - 1] = entry_state[i] & ENTRY_CHECKED;
+    }
+
+    free(remap);
+    if (ret != ESP_OK) {
+        file_listing_free(&packed);
+        free(packed_parents);
+        free(packed_first);
+        free(packed_next);
+        free(packed_state);
+        return ESP_ERR_NO_MEM;
+    }
+
+    file_listing_free(&entries);
+    free(parents);
+    free(first_child);
+    free(next_sibling);
+    free(entry_state);
+    entries = packed;
+    parents = packed_parents;
+    first_child = packed_first;
+    next_sibling = packed_next;
+    entry_state = packed_state;
+    meta_capacity = live ? live : 1;
+    deleted_count = 0;
+
+    // Parents still precede children, so each chain head is ready before it is used
+    root_first_child = INDEX_ROOT;
+    for (uint32_t i = 0; i < entries.count; i++) {
+        link_child(i);
+    }
+    name_filter_reset(&folded_names);
+    return ESP_OK;
+}
+
+static esp_err_t save_index(void) {
+    xSemaphoreTake(index_lock, portMAX_DELAY);
+    esp_err_t ret = compact_index();
+    xSemaphoreGive(index_lock);
+    if (ret != ESP_OK) {
+        ESP_LOGW(TAG, "Not enough memory to compact index, save postponed");
+        return ret;
+    }
+
+    // Only the worker changes the table, so it can be read without the lock here
+    const char *final_path = SD_MOUNT_POINT FILE_INDEX_FILE;
+    const char *temp_path = SD_MOUNT_POINT FILE_INDEX_FILE ".tmp";
+    uint32_t start = esp_log_timestamp();
+    FILE *f = fopen(temp_path, "wb");
+    if (!f) {
+        ESP_LOGE(TAG, "Failed to create %s", temp_path);
+        return ESP_FAIL;
+    }
+    setvbuf(f, NULL, _IOFBF, FILE_INDEX_IO_BUFFER);
+
+    index_file_header_t header = {
+        .magic = FILE_INDEX_MAGIC,
+        .version = FILE_INDEX_VERSION,
+        .count = entries.count
+    };
+    bool ok = fwrite(&header, sizeof(header), 1, f) == 1;
+    for (uint32_t i = 0; i < entries.count && ok; i++) {
+        const char *name = file_listing_name(&entries, i);
+        size_t name_len = strlen(name);
+        index_file_record_t record = {
+            .parent = parents[i],
+            .size = entries.size[i],
+            .mtime = entries.mtime[i],
+            .flags = entries.flags[i],
+            .name_len = (uint8_t)(name_len > UINT8_MAX ? UINT8_MAX : name_len)
+        };
+        ok = fwrite(&record, sizeof(record), 1, f) == 1 &&
+             fwrite(name, 1, record.name_len, f) == record.name_len;
+    }
+    long written = ok ? ftell(f) : 0;
+    ok = (fclose(f) == 0) && ok;
+
+    // FAT will not rename over an existing file
+    if (ok) {
+        struct stat st;
+        uint64_t replaced = stat(final_path, &st) == 0 ? (uint64_t)st.st_size : 0;
+        if (remove(final_path) == 0) {
+            sd_space_note_file(replaced, 0);
+        }
+        ok = rename(temp_path, final_path) == 0;
+        if (ok) {
+            sd_space_note_file(0, written > 0 ? (uint64_t)written : 0);
+        }
+    }
+    if (!ok) {
+        remove(temp_path);
+        ESP_LOGE(TAG, "Failed to write index");
+        return ESP_FAIL;
+    }
+
+    // The index file lives in the root directory
+    listing_cache_invalidate_parent(FILE_INDEX_FILE);
+    unsaved = false;
+    ESP_LOGI(TAG, "Saved %" PRIu32 " entries in %" PRIu32 " ms", entries.count, esp_log_timestamp() - start);
+    return ESP_OK;
+}
+
+static bool load_index(void) {
+    FILE *f = fopen(SD_MOUNT_POINT FILE_INDEX_FILE, "rb");
+    if (!f) {
+        return false;
+    }
+    setvbuf(f, NULL, _IOFBF, FILE_INDEX_IO_BUFFER);
+
+    uint32_t start = esp_log_timestamp();
+    index_file_header_t header;
+    bool ok = fread(&header, sizeof(header), 1, f) == 1 &&
+              header.magic == FILE_INDEX_MAGIC && header.version == FILE_INDEX_VERSION;
+
+    char name[UINT8_MAX + 1];
+    for (uint32_t i = 0; ok && i < header.count && !walk_cancelled(); i++) {
+        index_file_record_t record;
+        ok = fread(&record, sizeof(record), 1, f) == 1 && record.name_len > 0 &&
+             fread(name, 1, record.name_len, f) == record.name_len &&
+             (record.parent == INDEX_ROOT || record.parent < i);
+        if (!ok) {
+            break;
+        }
+        name[record.name_len] = '\0';
+
+        xSemaphoreTake(index_lock, portMAX_DELAY);
+        ok = add_entry(record.parent, name, record.size, record.mtime, record.flags) != INDEX_ROOT;
+        xSemaphoreGive(index_lock);
+    }
+    fclose(f);
+
+    if (!ok || walk_cancelled()) {
+        ESP_LOGW(TAG, "Stored index unusable, rebuilding");
+        xSemaphoreTake(index_lock, portMAX_DELAY);
+        release_index();
+        xSemaphoreGive(index_lock);
+        return false;
+    }
+    ESP_LOGI(TAG, "Loaded %" PRIu32 " entries in %" PRIu32 " ms", entries.count, esp_log_timestamp() - start);
+    return true;
+}
+
+static void start_index(void) {
+    xSemaphoreTake(index_lock, portMAX_DELAY);
+    release_index();
+    index_state = FILE_INDEX_LOADING;
+    xSemaphoreGive(index_lock);
+    unsaved = false;
+    pending_count = 0;
+
+    uint32_t start = esp_log_timestamp();
+    bool loaded = load_index();
+    set_state(loaded ? FILE_INDEX_VERIFYING : FILE_INDEX_BUILDING);
+    // A stored index only has its root read now; other directories are
+    // read when they are opened (file_index_note_open)
+    push_pending(INDEX_ROOT);
+    drain_pending();
+    if (!loaded) {
+        unsaved = true;
+    }
+    if (walk_cancelled()) {
+        return;
+    }
+
+    set_state(FILE_INDEX_READY);
+    ESP_LOGI(TAG, "Index ready: %" PRIu32 " entries in %" PRIu32 " ms",
+             entries.count - deleted_count, esp_log_timestamp() - start);
+    if (unsaved) {
+        save_index();
+    }
+}
+
+static void file_index_task(void *arg) {
+    (void)arg;
+    index_msg_t msg;
+
+    for (;;) {
+        bool idle_work = index_state == FILE_INDEX_READY && (unsaved || queue_overflowed);
+        TickType_t wait = idle_work ? pdMS_TO_TICKS(FILE_INDEX_SAVE_DELAY_MS) : portMAX_DELAY;
+
+        if (xQueueReceive(index_queue, &msg, wait) != pdTRUE) {
+            // Quiet for a while: catch up on lost notifications, then persist
+            if (queue_overflowed) {
+                queue_overflowed = false;
+                recheck_card();
+            }
+            if (unsaved && !walk_cancelled()) {
+                save_index();
+            }
+            continue;
+        }
+
+        switch (msg.type) {
+            case MSG_START:
+                worker_generation = index_generation;
+                start_index();
+                break;
+            case MSG_RESCAN:
+                consumed_seq = msg.seq;
+                if (index_state == FILE_INDEX_READY && !walk_cancelled()) {
+                    rescan_path(msg.path, false);
+                }
+                break;
+            case MSG_CHECK:
+                if (index_state == FILE_INDEX_READY && !walk_cancelled()) {
+                    rescan_path(msg.path, true);
+                }
+                break;
+            case MSG_STOP:
+                if (index_state == FILE_INDEX_READY && unsaved) {
+                    save_index();
+                }
+                xSemaphoreTake(index_lock, portMAX_DELAY);
+                release_index();
+                index_state = FILE_INDEX_OFFLINE;
+                xSemaphoreGive(index_lock);
+                unsaved = false;
+                xSemaphoreGive(stop_done);
+                break;
+        }
+    }
+}
+
+static bool ensure_worker(void) {
+    if (index_task) {
+        return true;
+    }
+
+    if (!index_lock) {
+        index_lock = xSemaphoreCreateMutex();
+        stop_done = xSemaphoreCreateBinary();
+        index_queue = xQueueCreate(FILE_INDEX_QUEUE_LEN, sizeof(index_msg_t));
+        if (!index_lock || !stop_done || !index_queue) {
+            ESP_LOGE(TAG, "Failed to create index worker state");
+            return false;
+        }
+    }
+
+    // Pinned to CPU1 like the other long-running workers, away from LVGL
+    BaseType_t result = xTaskCreatePinnedToCore(file_index_task, "file_index", FILE_INDEX_TASK_STACK,
+                                                NULL, FILE_INDEX_TASK_PRIORITY, &index_task, 1);
+    if (result != pdPASS) {
+        ESP_LOGE(TAG, "Failed to create index task");
+        index_task = NULL;
+        return false;
+    }
+    return true;
+}
+
+esp_err_t file_index_start(void) {
+    if (!ensure_worker()) {
+        return ESP_FAIL;
+    }
+
+    // Abandon any load or walk in progress
+    index_generation++;
+    queue_overflowed = false;
+    index_msg_t msg = { .type = MSG_START };
+    if (xQueueSend(index_queue, &msg, pdMS_TO_TICKS(100)) != pdTRUE) {
+        ESP_LOGE(TAG, "Index queue full, not started");
+        return ESP_ERR_TIMEOUT;
+    }
+    return ESP_OK;
+}
+
+void file_index_stop(void) {
+    if (!index_task) {
+        return;
+    }
+
+    // Cut any walk short, then have the worker flush before the card goes away
+    index_generation++;
+    index_msg_t msg = { .type = MSG_STOP };
+    xSemaphoreTake(stop_done, 0);
+    if (xQueueSendToFront(index_queue, &msg, pdMS_TO_TICKS(1000)) != pdTRUE ||
+        xSemaphoreTake(stop_done, pdMS_TO_TICKS(FILE_INDEX_STOP_TIMEOUT_MS)) != pdTRUE) {
+        ESP_LOGW(TAG, "Index worker did not stop in time");
+    }
+}
+
+void file_index_note_change(const char *path) {
+    if (!index_task || index_state == FILE_INDEX_OFFLINE) {
+        return;
+    }
+
+    index_msg_t msg = { .type = MSG_RESCAN };
+    snprintf(msg.path, sizeof(msg.path), "%s", path);
+    char *last_slash = strrchr(msg.path, '/');
+    if (last_slash) {
+        *last_slash = '\0';
+    }
+
+    // Copying a folder notes every file in it; one queued rescan covers them all
+    xSemaphoreTake(index_lock, portMAX_DELAY);
+    bool already_queued = consumed_seq != last_noted_seq && strcmp(last_noted, msg.path) == 0;
+    if (!already_queued) {
+        msg.seq = ++last_noted_seq;
+        strcpy(last_noted, msg.path);
+    }
+    xSemaphoreGive(index_lock);
+    if (already_queued) {
+        return;
+    }
+
+    if (xQueueSend(index_queue, &msg, 0) != pdTRUE) {
+        // Too many changes at once; compare the whole card once things settle
+        queue_overflowed = true;
+    }
+}
+
+void file_index_note_open(const char *dir) {
+    if (!index_task || index_state == FILE_INDEX_OFFLINE) {
+        return;
+    }
+
+    // A check dropped on a full queue happens the next time the directory is opened
+    index_msg_t msg = { .type = MSG_CHECK };
+    snprintf(msg.path, sizeof(msg.path), "%s", dir);
+    xQueueSend(index_queue, &msg, 0);
+}
+
+esp_err_t file_index_search(const char *query, file_listing_t *results, uint32_t max_results,
+                            uint32_t *total_matches) {
+    file_listing_clear(results);
+    if (total_matches) {
+        *total_matches = 0;
+    }
+    if (!index_lock) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    // "*.ext" looks for ".ext" and then checks it is the last extension
+    bool by_extension = query[0] == '*' && query[1] == '.';
+    const char *needle = by_extension ? query + 1 : query;
+    if (needle[0] == '\0' || (by_extension && needle[1] == '\0')) {
+        return ESP_OK;
+    }
+
+    xSemaphoreTake(index_lock, portMAX_DELAY);
+    if (index_state == FILE_INDEX_OFFLINE) {
+        xSemaphoreGive(index_lock);
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    esp_err_t ret = name_filter_update(&folded_names, &entries);
+    uint32_t words = (entries.count + 31) / 32;
+    if (ret == ESP_OK && words > match_bits_words) {
+        uint32_t *bits = realloc(match_bits, words * sizeof(uint32_t));
+        if (bits) {
+            match_bits = bits;
+            match_bits_words = words;
+        } else {
+            ret = ESP_ERR_NO_MEM;
+        }
+    }
+    if (ret != ESP_OK || entries.count == 0) {
+        xSemaphoreGive(index_lock);
+        return ret;
+    }
+
+    name_filter_match(&folded_names, &entries, needle, 0, match_bits);
+
+    uint32_t total = 0;
+    char path[FILE_INDEX_PATH_LEN];
+    for (uint32_t w = 0; w < words; w++) {
+        for (uint32_t bits = match_bits[w]; bits; bits &= bits - 1) {
+            uint32_t id = w * 32 + (uint32_t)__builtin_ctz(bits);
+            if (!entry_live(id)) {
+                continue;
+            }
+            if (by_extension) {
+                const char *ext = strrchr(file_listing_name(&entries, id), '.');
+                if (!ext || strcasecmp(ext, needle) != 0) {
+                    continue;
+                }
+            }
+            total++;
+            if (results->count < max_results && ret == ESP_OK && build_path(id, path, sizeof(path))) {
+                ret = file_listing_add(results, path, entries.size[id], entries.mtime[id],
+                                       file_listing_is_dir(&entries, id));
+            }
+        }
+    }
+    xSemaphoreGive(index_lock);
+
+    if (total_matches) {
+        *total_matches = total;
+    }
+    return ret;
+}
+
+typedef struct {
+    uint32_t id;
+    file_index_usage_t usage;
+} usage_slot_t;
+
+static int compare_usage(const void *a, const void *b) {
+    const file_index_usage_t *ua = &((const usage_slot_t *)a)->usage;
+    const file_index_usage_t *ub = &((const usage_slot_t *)b)->usage;
+    if (ua->bytes != ub->bytes) {
+        return ua->bytes < ub->bytes ? 1 : -1;
+    }
+    return ua->files < ub->files ? 1 : ua->files > ub->files ? -1 : 0;
+}
+
+// Call with index_lock held
+static bool find_directory(const char *path, uint32_t *dir_id) {
+    *dir_id = INDEX_ROOT;
+    for (const char *p = path; *p; ) {
+        while (*p == '/') {
+            p++;
+        }
+        size_t len = strcspn(p, "/");
+        if (len == 0) {
+            break;
+        }
+        *dir_id = find_child(*dir_id, p, len);
+        if (*dir_id == INDEX_ROOT) {
+            return false;
+        }
+        p += len;
+    }
+    return true;
+}
+
+// Call with index_lock held
+static esp_err_t collect_usage(uint32_t dir_id, file_index_usage_list_t *list) {
+    uint32_t children = 0;
+    for (uint32_t id = *child_list(dir_id); id != INDEX_ROOT; id = next_sibling[id]) {
+        children++;
+    }
+    if (children == 0) {
+        return ESP_OK;
+    }
+
+    if (children > list->usage_capacity) {
+        file_index_usage_t *grown = realloc(list->usage, children * sizeof(file_index_usage_t));
+        if (!grown) {
+            return ESP_ERR_NO_MEM;
+        }
+        list->usage = grown;
+        list->usage_capacity = children;
+    }
+
+    usage_slot_t *slots = calloc(children, sizeof(usage_slot_t));
+    if (!slots) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    // Each child's subtree is walked once; nothing outside dir is touched
+    uint32_t used = 0;
+    for (uint32_t child = *child_list(dir_id); child != INDEX_ROOT; child = next_sibling[child]) {
+        usage_slot_t *slot = &slots[used++];
+        slot->id = child;
+        for (uint32_t id = child; id != INDEX_ROOT; id = next_in_subtree(id, child)) {
+            if (!file_listing_is_dir(&entries, id)) {
+                slot->usage.bytes += entries.size[id];
+                slot->usage.files++;
+            } else if (id != child) {
+                slot->usage.folders++;
+            }
+        }
+    }
+
+    qsort(slots, used, sizeof(usage_slot_t), compare_usage);
+    esp_err_t ret = ESP_OK;
+    for (uint32_t i = 0; i < used && ret == ESP_OK; i++) {
+        ret = file_listing_copy_entry(&list->entries, &entries, slots[i].id);
+        list->usage[i] = slots[i].usage;
+        list->total.bytes += slots[i].usage.bytes;
+        list->total.files += slots[i].usage.files;
+        list->total.folders += slots[i].usage.folders + (file_listing_is_dir(&entries, slots[i].id) ? 1 : 0);
+    }
+    free(slots);
+    return ret;
+}
+
+esp_err_t file_index_usage(const char *dir, file_index_usage_list_t *list) {
+    file_listing_clear(&list->entries);
+    memset(&list->total, 0, sizeof(list->total));
+    if (!index_lock) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    xSemaphoreTake(index_lock, portMAX_DELAY);
+    esp_err_t ret;
+    uint32_t dir_id;
+    if (index_state == FILE_INDEX_OFFLINE) {
+        ret = ESP_ERR_INVALID_STATE;
+    } else if (!find_directory(dir, &dir_id)) {
+        ret = ESP_ERR_NOT_FOUND;
+    } else {
+        ret = collect_usage(dir_id, list);
+    }
+    xSemaphoreGive(index_lock);
+
+    if (ret == ESP_ERR_NO_MEM) {
+        file_listing_clear(&list->entries);
+        memset(&list->total, 0, sizeof(list->total));
+    }
+    return ret;
+}
+
+void file_index_usage_free(file_index_usage_list_t *list) {
+    file_listing_free(&list->entries);
+    free(list->usage);
+    list->usage = NULL;
+    list->usage_capacity = 0;
+    memset(&list->total, 0, sizeof(list->total));
+}
+
+void file_index_get_status(file_index_status_t *status) {
+    memset(status, 0, sizeof(*status));
+    if (!index_lock) {
+        return;
+    }
+
+    xSemaphoreTake(index_lock, portMAX_DELAY);
+    status->state = index_state;
+    status->entries = entries.count - deleted_count;
+    for (uint32_t i = 0; i < entries.count; i++) {
+        if (entry_live(i) && file_listing_is_dir(&entries, i)) {
+            status->directories++;
+        }
+    }
+    status->bytes = file_listing_memory(&entries) + (size_t)meta_capacity * (3 * sizeof(uint32_t) + 1) +
+                    folded_names.folded_size + (size_t)match_bits_words * sizeof(uint32_t);
+    xSemaphoreGive(index_lock);
+
+    status->pending = (uint32_t)uxQueueMessagesWaiting(index_queue);
+    status->unsaved = unsaved;
+}
@@ -0,0 +1,132 @@
+#ifndef FILE_INDEX_H
+#define FILE_INDEX_H
+
+#include "esp_err.h"
+#include "file_listing.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Index file on the card (relative to SD root); hidden, and never indexed itself
+#define FILE_INDEX_FILE "/.tab5_index.bin"
+
+// Quiet time after the last change before the index is written back
+#define FILE_INDEX_SAVE_DELAY_MS 5000
+
+typedef enum {
+    FILE_INDEX_OFFLINE,     // No card mounted
+    FILE_INDEX_LOADING,     // Reading the stored index
+    FILE_INDEX_BUILDING,    // Walking the card (no usable stored index)
+    FILE_INDEX_VERIFYING,   // Checking the stored root against the card
+    FILE_INDEX_READY
+} file_index_state_t;
+
+typedef struct {
+    file_index_state_t state;
+    uint32_t entries;       // Live entries
+    uint32_t directories;
+    uint32_t pending;       // Directories queued for rescan
+    bool unsaved;           // Changes not yet written to the card
+    size_t bytes;           // Memory held by the index
+} file_index_status_t;
+
+typedef struct {
+    uint64_t bytes;         // Size; for a folder, everything below it
+    uint32_t files;         // Files counted in bytes (1 for a file)
+    uint32_t folders;       // Folders below it (0 for a file)
+} file_index_usage_t;
+
+// What a directory holds, entry by entry
+typedef struct {
+    file_listing_t entries;         // Direct children, biggest first
+    file_index_usage_t *usage;      // Parallel to entries
+    uint32_t usage_capacity;
+    file_index_usage_t total;       // The directory as a whole
+} file_index_usage_list_t;
+
+/**
+ * @brief Load the card's index (or build it) on the background worker
+ *
+ * Call after the card is mounted. Searches work while it loads; they see
+ * whatever has been indexed so far.
+ *
+ * @return ESP_OK if the worker accepted the request
+ */
+esp_err_t file_index_start(void);
+
+/**
+ * @brief Write pending changes and drop the in-memory index
+ *
+ * Call before the card is unmounted. Blocks until the worker is done with
+ * the card.
+ */
+void file_index_stop(void);
+
+/**
+ * @brief Queue the directory containing path for a rescan
+ *
+ * Called by file_operations after it changes the card. Cheap and non-blocking;
+ * the rescan happens on the worker.
+ *
+ * @param path File or directory path (relative to SD root)
+ */
+void file_index_note_change(const char *path);
+
+/**
+ * @brief Have a directory the user opened checked against the card
+ *
+ * A stored index is only compared with the card at the root on mount;
+ * every other directory is read again the first time it is opened after
+ * that, which picks up changes made elsewhere. Cheap and non-blocking.
+ *
+ * @param dir Directory path (relative to SD root)
+ */
+void file_index_note_open(const char *dir);
+
+/**
+ * @brief Search the index
+ *
+ * "*.ext" matches by extension, anything else is a case-insensitive
+ * substring match on entry names. Results hold full paths (relative to the
+ * SD root) as names, in index order.
+ *
+ * @param query Search text
+ * @param results Listing to fill (cleared first)
+ * @param max_results Maximum entries copied into results
+ * @param total_matches Output: number of matches, including those not copied (can be NULL)
+ * @return ESP_OK on success, ESP_ERR_INVALID_STATE if no card is indexed,
+ *         ESP_ERR_NO_MEM on allocation failure
+ */
+esp_err_t file_index_search(const char *query, file_listing_t *results, uint32_t max_results,
+                            uint32_t *total_matches);
+
+/**
+ * @brief Add up the space used below each entry of a directory
+ *
+ * Totals come from the index, walking only the entries below dir and
+ * without touching the card, so they are as current as the index: folders
+ * of a card that was already indexed are read again when they are opened
+ * (see file_index_note_open()), not on mount. While the index is still
+ * being built the totals cover what it has seen.
+ *
+ * @param dir Directory (relative to SD root)
+ * @param list Output, replacing previous contents; free with file_index_usage_free()
+ * @return ESP_OK on success, ESP_ERR_INVALID_STATE if no card is indexed,
+ *         ESP_ERR_NOT_FOUND if the directory is not in the index,
+ *         ESP_ERR_NO_MEM on allocation failure
+ */
+esp_err_t file_index_usage(const char *dir, file_index_usage_list_t *list);
+
+/**
+ * @brief Release a list filled by file_index_usage()
+ * @param list List to free
+ */
+void file_index_usage_free(file_index_usage_list_t *list);
+
+/**
+ * @brief Get index state and counters
+ * @param status Output status
+ */
+void file_index_get_status(file_index_status_t *status);
+
+#endif // FILE_INDEX_H
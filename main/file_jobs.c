@@ -0,0 +1,993 @@
+#include "file_jobs.h"
+#include "copy_engine.h"
+#include "copy_batch.h"
+#include "copy_verify.h"
+#include "sd_manager.h"
+#include "listing_cache.h"
+#include "file_index.h"
+#include "sd_space.h"
+#include "tree_walk.h"
+#include "esp_timer.h"
+#include "esp_log.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <inttypes.h>
+
+static const char *TAG = "FILE_JOBS";
+
+#define FILE_JOBS_TASK_STACK       8192    // Fixed depth: folder walks keep pending paths on the heap
+#define FILE_JOBS_TASK_PRIORITY    3       // Below the LVGL task
+#define FILE_JOBS_STOP_TIMEOUT_MS  5000
+#define FILE_JOBS_FULL_PATH_LEN    (FILE_JOBS_PATH_LEN + sizeof(SD_MOUNT_POINT))
+#define FILE_JOBS_MAX_RENAME       999
+
+/*
+ * Jobs live in a small table, oldest first, guarded by jobs_lock. The worker
+ * runs the oldest queued job; its item list is read without the lock (it
+ * does not change after submit) while the progress fields in info are only
+ * written under it, so snapshots are always consistent. Finished jobs keep
+ * their info for the job list and drop their item list.
+ */
+struct file_job {
+    file_job_info_t info;
+    file_job_conflict_t conflict;
+    char dst_dir[FILE_JOBS_PATH_LEN];
+    char *arena;                // Item paths, back to back
+    uint32_t arena_used;
+    uint32_t arena_size;
+    uint32_t *items;            // Arena offsets
+    uint32_t item_capacity;
+    char *failures;             // Paths of failed files, back to back; kept after the job ends
+    uint32_t failures_used;
+    uint32_t failures_size;
+    uint32_t failures_listed;
+    int64_t started_us;
+    volatile bool cancel;
+};
+
+typedef enum {
+    ITEM_DONE,
+    ITEM_SKIPPED,
+    ITEM_FAILED,
+    ITEM_CANCELLED
+} item_result_t;
+
+static SemaphoreHandle_t jobs_lock = NULL;
+static TaskHandle_t jobs_task = NULL;
+
+// Protected by jobs_lock
+static file_job_t *jobs[FILE_JOBS_MAX];
+static uint32_t job_count = 0;
+static uint32_t next_job_id = 1;
+static uint32_t finished_count = 0;
+static file_job_t *running_job = NULL;
+
+static bool grow_array(void **array, uint32_t *capacity, uint32_t needed, size_t elem_size) {
+    if (needed <= *capacity) {
+        return true;
+    }
+    uint32_t new_capacity = *capacity ? *capacity * 2 : 16;
+    while (new_capacity < needed) {
+        new_capacity *= 2;
+    }
+    void *grown = realloc(*array, (size_t)new_capacity * elem_size);
+    if (!grown) {
+        return false;
+    }
+    *array = grown;
+    *capacity = new_capacity;
+    return true;
+}
+
+static const char *base_name(const char *path) {
+    const char *slash = strrchr(path, '/');
+    return slash ? slash + 1 : path;
+}
+
+static bool join_path(char *out, size_t size, const char *dir, const char *name) {
+    int len = snprintf(out, size, "%s/%s", strcmp(dir, "/") == 0 ? "" : dir, name);
+    return len >= 0 && (size_t)len < size;
+}
+
+static void full_path(char *out, size_t size, const char *path) {
+    snprintf(out, size, "%s%s", SD_MOUNT_POINT, path);
+}
+
+static bool path_exists(const char *path, bool *is_directory) {
+    char full[FILE_JOBS_FULL_PATH_LEN];
+    full_path(full, sizeof(full), path);
+    struct stat st;
+    if (stat(full, &st) != 0) {
+        return false;
+    }
+    if (is_directory) {
+        *is_directory = S_ISDIR(st.st_mode);
+    }
+    return true;
+}
+
+// True if path is dir itself or somewhere below it
+static bool path_within(const char *path, const char *dir) {
+    size_t len = strlen(dir);
+    return strncmp(path, dir, len) == 0 && (path[len] == '\0' || path[len] == '/');
+}
+
+static void release_items(file_job_t *job) {
+    free(job->arena);
+    free(job->items);
+    job->arena = NULL;
+    job->items = NULL;
+    job->arena_used = job->arena_size = job->item_capacity = 0;
+}
+
+static bool job_finished(const file_job_t *job) {
+    return job->info.state != FILE_JOB_QUEUED && job->info.state != FILE_JOB_RUNNING;
+}
+
+// ---- Progress, written by the worker under jobs_lock ----
+
+static void set_current(file_job_t *job, const char *path) {
+    xSemaphoreTake(jobs_lock, portMAX_DELAY);
+    snprintf(job->info.current, sizeof(job->info.current), "%s", base_name(path));
+    xSemaphoreGive(jobs_lock);
+}
+
+static void add_totals(file_job_t *job, uint64_t bytes, uint32_t files) {
+    xSemaphoreTake(jobs_lock, portMAX_DELAY);
+    job->info.bytes_total += bytes;
+    job->info.files_total += files;
+    xSemaphoreGive(jobs_lock);
+}
+
+static void update_elapsed(file_job_t *job) {
+    job->info.elapsed_ms = (uint32_t)((esp_timer_get_time() - job->started_us) / 1000);
+}
+
+static void set_bytes_done(file_job_t *job, uint64_t bytes) {
+    xSemaphoreTake(jobs_lock, portMAX_DELAY);
+    job->info.bytes_done = bytes;
+    update_elapsed(job);
+    xSemaphoreGive(jobs_lock);
+}
+
+// One file inside the job handled, whatever the outcome
+static void count_file(file_job_t *job, const char *path) {
+    xSemaphoreTake(jobs_lock, portMAX_DELAY);
+    job->info.files_done++;
+    snprintf(job->info.current, sizeof(job->info.current), "%s", base_name(path));
+    update_elapsed(job);
+    xSemaphoreGive(jobs_lock);
+}
+
+static void record_failure(file_job_t *job, const char *path) {
+    uint32_t len = (uint32_t)strlen(path) + 1;
+    xSemaphoreTake(jobs_lock, portMAX_DELAY);
+    job->info.files_failed++;
+    if (job->failures_listed < FILE_JOBS_MAX_FAILURES &&
+        grow_array((void **)&job->failures, &job->failures_size, job->failures_used + len, 1)) {
+        memcpy(job->failures + job->failures_used, path, len);
+        job->failures_used += len;
+        job->failures_listed++;
+    }
+    xSemaphoreGive(jobs_lock);
+}
+
+static void count_item(file_job_t *job, item_result_t result) {
+    xSemaphoreTake(jobs_lock, portMAX_DELAY);
+    if (result == ITEM_DONE) {
+        job->info.items_done++;
+    } else if (result == ITEM_SKIPPED) {
+        job->info.items_skipped++;
+    } else if (result == ITEM_FAILED) {
+        job->info.items_failed++;
+    }
+    xSemaphoreGive(jobs_lock);
+}
+
+// ---- Folder walks ----
+
+typedef struct {
+    file_job_t *job;
+    const char *dst;            // Destination of the walked folder (copies only)
+    bool batched;               // Small files go through copy_batch (copies only)
+    uint32_t batch_read_failed; // Small files copy_batch could not read
+    item_result_t result;
+} walk_ctx_t;
+
+static void walk_fail(walk_ctx_t *ctx, item_result_t result) {
+    if (result == ITEM_CANCELLED || (result == ITEM_FAILED && ctx->result == ITEM_DONE)) {
+        ctx->result = result;
+    }
+}
+
+static item_result_t walk_result(walk_ctx_t *ctx, esp_err_t ret) {
+    if (ret == ESP_ERR_INVALID_STATE) {
+        return ITEM_CANCELLED;
+    }
+    if (ret != ESP_OK) {
+        walk_fail(ctx, ITEM_FAILED);
+    }
+    return ctx->result;
+}
+
+// Count what the job will touch, so progress and time left have real denominators.
+// Returns the number of folders inside the items.
+static uint32_t measure_job(file_job_t *job) {
+    uint32_t folders = 0;
+    for (uint32_t i = 0; i < job->info.items_total && !job->cancel; i++) {
+        const char *path = job->arena + job->items[i];
+        char full[FILE_JOBS_FULL_PATH_LEN];
+        full_path(full, sizeof(full), path);
+        struct stat st;
+        if (stat(full, &st) != 0) {
+            continue;
+        }
+        if (!S_ISDIR(st.st_mode)) {
+            add_totals(job, (uint64_t)st.st_size, 1);
+            continue;
+        }
+        tree_walk_stats_t stats;
+        tree_walk_measure(path, &job->cancel, &stats);
+        add_totals(job, stats.bytes, stats.files);
+        folders += stats.dirs;
+    }
+    return folders;
+}
+
+typedef struct {
+    file_job_t *job;
+    uint64_t base;              // Job bytes done before this file
+} copy_progress_ctx_t;
+
+static bool copy_progress_cb(uint64_t bytes_done, void *user_data) {
+    copy_progress_ctx_t *ctx = (copy_progress_ctx_t *)user_data;
+    set_bytes_done(ctx->job, ctx->base + bytes_done);
+    return !ctx->job->cancel;
+}
+
+static item_result_t copy_one_file(file_job_t *job, const char *src, const char *dst, uint64_t size) {
+    char src_full[FILE_JOBS_FULL_PATH_LEN];
+    char dst_full[FILE_JOBS_FULL_PATH_LEN];
+    full_path(src_full, sizeof(src_full), src);
+    full_path(dst_full, sizeof(dst_full), dst);
+
+    copy_progress_ctx_t ctx = { .job = job, .base = job->info.bytes_done };
+    copy_engine_stats_t stats;
+    esp_err_t ret = copy_engine_copy(src_full, dst_full, job->info.verify ? COPY_ENGINE_HASH : 0,
+                                     copy_progress_cb, &ctx, &stats);
+    if (ret == ESP_ERR_INVALID_STATE) {
+        set_bytes_done(job, ctx.base);
+        return ITEM_CANCELLED;
+    }
+
+    // A failed file still counts as processed, so the bar keeps moving
+    set_bytes_done(job, ctx.base + (ret == ESP_OK ? stats.bytes : size));
+    count_file(job, src);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to copy %s -> %s", src, dst);
+        record_failure(job, src);
+        return ITEM_FAILED;
+    }
+    if (job->info.verify) {
+        copy_verify_queue(dst_full, stats.bytes, stats.crc);
+    }
+    ESP_LOGD(TAG, "Copied %s (%.1f MB/s)", src, copy_engine_mb_per_s(&stats));
+    return ITEM_DONE;
+}
+
+// Parents first: each folder is created before anything is copied into it
+static tree_walk_action_t copy_tree_cb(const tree_walk_entry_t *entry, void *user_data) {
+    walk_ctx_t *ctx = (walk_ctx_t *)user_data;
+    if (ctx->job->cancel) {
+        walk_fail(ctx, ITEM_CANCELLED);
+        return TREE_WALK_STOP;
+    }
+    if (entry->event == TREE_WALK_ERROR) {
+        walk_fail(ctx, ITEM_FAILED);
+        record_failure(ctx->job, entry->path);
+        return TREE_WALK_CONTINUE;
+    }
+    if (entry->event == TREE_WALK_LEAVE) {
+        return TREE_WALK_CONTINUE;
+    }
+
+    char dst[FILE_JOBS_PATH_LEN];
+    if (entry->relative[0] == '\0') {
+        snprintf(dst, sizeof(dst), "%s", ctx->dst);
+    } else if (!join_path(dst, sizeof(dst), ctx->dst, entry->relative)) {
+        ESP_LOGW(TAG, "Path too long, skipping %s", entry->path);
+        walk_fail(ctx, ITEM_FAILED);
+        return entry->event == TREE_WALK_ENTER ? TREE_WALK_SKIP : TREE_WALK_CONTINUE;
+    }
+
+    if (entry->event == TREE_WALK_ENTER) {
+        char dst_full[FILE_JOBS_FULL_PATH_LEN];
+        full_path(dst_full, sizeof(dst_full), dst);
+        if (mkdir(dst_full, 0755) == 0) {
+            sd_space_note_dir(true);
+        } else if (errno != EEXIST) {
+            ESP_LOGE(TAG, "Failed to create %s (errno: %d)", dst, errno);
+            walk_fail(ctx, ITEM_FAILED);
+            return TREE_WALK_SKIP;
+        }
+        return TREE_WALK_CONTINUE;
+    }
+
+    if (ctx->batched && copy_batch_fits(entry->size)) {
+        char src_full[FILE_JOBS_FULL_PATH_LEN];
+        char dst_full[FILE_JOBS_FULL_PATH_LEN];
+        full_path(src_full, sizeof(src_full), entry->path);
+        full_path(dst_full, sizeof(dst_full), dst);
+        if (copy_batch_add(src_full, dst_full, entry->size) != ESP_OK) {
+            walk_fail(ctx, ITEM_FAILED);
+            record_failure(ctx->job, entry->path);
+            ctx->batch_read_failed++;
+        }
+        set_bytes_done(ctx->job, ctx->job->info.bytes_done + entry->size);
+        count_file(ctx->job, entry->path);
+        return TREE_WALK_CONTINUE;
+    }
+
+    item_result_t result = copy_one_file(ctx->job, entry->path, dst, entry->size);
+    if (result != ITEM_DONE) {
+        walk_fail(ctx, result);
+    }
+    return result == ITEM_CANCELLED ? TREE_WALK_STOP : TREE_WALK_CONTINUE;
+}
+
+static item_result_t copy_tree(file_job_t *job, const char *src, const char *dst) {
+    walk_ctx_t ctx = { .job = job, .dst = dst, .result = ITEM_DONE };
+    // Small files are read ahead into batches while a second task writes them out
+    ctx.batched = copy_batch_begin(job->info.verify) == ESP_OK;
+    item_result_t result = walk_result(&ctx, tree_walk(src, copy_tree_cb, &ctx, NULL));
+    if (ctx.batched) {
+        copy_batch_stats_t stats;
+        if (copy_batch_end(result == ITEM_CANCELLED, &stats) != ESP_OK && result == ITEM_DONE) {
+            result = ITEM_FAILED;
+        }
+        // Read failures were recorded by name as they happened; write failures only by count
+        if (stats.failed > ctx.batch_read_failed) {
+            xSemaphoreTake(jobs_lock, portMAX_DELAY);
+            job->info.files_failed += stats.failed - ctx.batch_read_failed;
+            xSemaphoreGive(jobs_lock);
+        }
+        ESP_LOGD(TAG, "Batched %" PRIu32 " small files (%" PRIu64 " bytes, %" PRIu32 " failed) from %s",
+                 stats.files, stats.bytes, stats.failed, src);
+    }
+    return result;
+}
+
+static bool remove_file(const char *full, uint64_t size) {
+    if (remove(full) != 0) {
+        return false;
+    }
+    sd_space_note_file(size, 0);
+    return true;
+}
+
+// Children first: files as they are listed, each folder once it is empty
+static tree_walk_action_t delete_tree_cb(const tree_walk_entry_t *entry, void *user_data) {
+    walk_ctx_t *ctx = (walk_ctx_t *)user_data;
+    if (ctx->job->cancel) {
+        walk_fail(ctx, ITEM_CANCELLED);
+        return TREE_WALK_STOP;
+    }
+    if (entry->event == TREE_WALK_ERROR) {
+        walk_fail(ctx, ITEM_FAILED);
+        record_failure(ctx->job, entry->path);
+        return TREE_WALK_CONTINUE;
+    }
+    if (entry->event == TREE_WALK_ENTER) {
+        return TREE_WALK_CONTINUE;
+    }
+
+    char full[FILE_JOBS_FULL_PATH_LEN];
+    full_path(full, sizeof(full), entry->path);
+    if (entry->event == TREE_WALK_FILE) {
+        if (!remove_file(full, entry->size)) {
+            ESP_LOGW(TAG, "Failed to delete %s (errno: %d)", entry->path, errno);
+            walk_fail(ctx, ITEM_FAILED);
+            record_failure(ctx->job, entry->path);
+        }
+        count_file(ctx->job, entry->path);
+    } else if (rmdir(full) == 0) {
+        sd_space_note_dir(false);
+    } else {
+        ESP_LOGW(TAG, "Failed to delete %s (errno: %d)", entry->path, errno);
+        walk_fail(ctx, ITEM_FAILED);
+        record_failure(ctx->job, entry->path);
+    }
+    return TREE_WALK_CONTINUE;
+}
+
+static item_result_t delete_tree(file_job_t *job, const char *path) {
+    walk_ctx_t ctx = { .job = job, .result = ITEM_DONE };
+    return walk_result(&ctx, tree_walk(path, delete_tree_cb, &ctx, NULL));
+}
+
+// ---- Items ----
+
+/*
+ * Pick where an item lands in the job's destination. Returns ITEM_DONE with
+ * the path in dst, ITEM_SKIPPED if the policy leaves an existing entry
+ * alone, ITEM_FAILED if no name fits. 'exists' reports a name being reused.
+ */
+static item_result_t resolve_destination(const file_job_t *job, const char *name, bool is_directory,
+                                         char *dst, size_t size, bool *exists) {
+    *exists = false;
+    if (!join_path(dst, size, job->dst_dir, name)) {
+        ESP_LOGE(TAG, "Destination path too long for %s", name);
+        return ITEM_FAILED;
+    }
+    if (!path_exists(dst, NULL)) {
+        return ITEM_DONE;
+    }
+
+    switch (job->conflict) {
+        case FILE_JOB_CONFLICT_SKIP:
+            return ITEM_SKIPPED;
+        case FILE_JOB_CONFLICT_OVERWRITE:
+            *exists = true;
+            return ITEM_DONE;
+        case FILE_JOB_CONFLICT_RENAME:
+        default:
+            break;
+    }
+
+    // "name (2).ext"; folders and dotfiles keep the whole name as the stem
+    const char *ext = is_directory ? NULL : strrchr(name, '.');
+    if (ext == name) {
+        ext = NULL;
+    }
+    int stem_len = ext ? (int)(ext - name) : (int)strlen(name);
+    for (int n = 2; n <= FILE_JOBS_MAX_RENAME; n++) {
+        char renamed[FILE_JOBS_PATH_LEN];
+        int len = snprintf(renamed, sizeof(renamed), "%.*s (%d)%s", stem_len, name, n, ext ? ext : "");
+        if (len < 0 || (size_t)len >= sizeof(renamed) || !join_path(dst, size, job->dst_dir, renamed)) {
+            return ITEM_FAILED;
+        }
+        if (!path_exists(dst, NULL)) {
+            return ITEM_DONE;
+        }
+    }
+    ESP_LOGE(TAG, "No free name for %s in %s", name, job->dst_dir);
+    return ITEM_FAILED;
+}
+
+static item_result_t remove_entry(file_job_t *job, const char *path) {
+    char full[FILE_JOBS_FULL_PATH_LEN];
+    full_path(full, sizeof(full), path);
+    struct stat st;
+    if (stat(full, &st) != 0) {
+        return ITEM_DONE;
+    }
+    item_result_t result;
+    if (S_ISDIR(st.st_mode)) {
+        result = delete_tree(job, path);
+        listing_cache_invalidate_tree(path);
+    } else {
+        result = remove_file(full, (uint64_t)st.st_size) ? ITEM_DONE : ITEM_FAILED;
+        if (result == ITEM_FAILED) {
+            record_failure(job, path);
+        }
+        count_file(job, path);
+    }
+    listing_cache_invalidate_parent(path);
+    file_index_note_change(path);
+    return result;
+}
+
+static item_result_t copy_item(file_job_t *job, const char *src, bool is_directory, uint64_t size) {
+    char dst[FILE_JOBS_PATH_LEN];
+    bool exists;
+    item_result_t result = resolve_destination(job, base_name(src), is_directory, dst, sizeof(dst), &exists);
+    if (result != ITEM_DONE) {
+        return result;
+    }
+    if (exists && strcmp(src, dst) == 0) {
+        return ITEM_SKIPPED; // Overwriting a file with itself
+    }
+    if (is_directory && path_within(dst, src)) {
+        ESP_LOGE(TAG, "Cannot copy %s into itself", src);
+        return ITEM_FAILED;
+    }
+    if (exists && path_within(src, dst)) {
+        // Overwriting an ancestor would write over the source while it is being read
+        ESP_LOGE(TAG, "Cannot replace %s, it contains %s", dst, src);
+        return ITEM_FAILED;
+    }
+
+    if (is_directory) {
+        result = copy_tree(job, src, dst);
+    } else {
+        result = copy_one_file(job, src, dst, size);
+    }
+    // Only once the copy is done: a scan that ran meanwhile cached missing or partial entries
+    listing_cache_invalidate_parent(dst);
+    if (is_directory) {
+        listing_cache_invalidate_tree(dst);
+    }
+    file_index_note_change(dst);
+    return result;
+}
+
+static item_result_t move_item(file_job_t *job, const char *src, bool is_directory, uint64_t size) {
+    char dst[FILE_JOBS_PATH_LEN];
+    // Before resolving: under the rename policy the item itself is the conflict
+    if (join_path(dst, sizeof(dst), job->dst_dir, base_name(src)) && strcmp(src, dst) == 0) {
+        return ITEM_SKIPPED; // Already there
+    }
+    bool exists;
+    item_result_t result = resolve_destination(job, base_name(src), is_directory, dst, sizeof(dst), &exists);
+    if (result != ITEM_DONE) {
+        return result;
+    }
+    if (is_directory && path_within(dst, src)) {
+        ESP_LOGE(TAG, "Cannot move %s into itself", src);
+        return ITEM_FAILED;
+    }
+    if (exists && path_within(src, dst)) {
+        // Replacing an ancestor would delete the source before it moves
+        ESP_LOGE(TAG, "Cannot replace %s, it contains %s", dst, src);
+        return ITEM_FAILED;
+    }
+    if (exists) {
+        result = remove_entry(job, dst);
+        if (result != ITEM_DONE) {
+            return result;
+        }
+    }
+
+    // Same volume: only the directory entry moves, whatever the size
+    char src_full[FILE_JOBS_FULL_PATH_LEN];
+    char dst_full[FILE_JOBS_FULL_PATH_LEN];
+    full_path(src_full, sizeof(src_full), src);
+    full_path(dst_full, sizeof(dst_full), dst);
+    if (rename(src_full, dst_full) == 0) {
+        result = ITEM_DONE;
+    } else if (errno == EXDEV) {
+        // Another volume: copy, then remove the original only if every byte made it
+        uint32_t bad_before = job->info.verify ? copy_verify_sync() : 0;
+        result = is_directory ? copy_tree(job, src, dst) : copy_one_file(job, src, dst, size);
+        if (result == ITEM_DONE && job->info.verify && copy_verify_sync() != bad_before) {
+            ESP_LOGE(TAG, "Keeping %s, its copy did not verify", src);
+            result = ITEM_FAILED;
+        }
+        if (result == ITEM_DONE) {
+            result = is_directory ? delete_tree(job, src) : (remove_file(src_full, size) ? ITEM_DONE : ITEM_FAILED);
+        }
+    } else {
+        ESP_LOGE(TAG, "Failed to move %s -> %s (errno: %d)", src, dst, errno);
+        return ITEM_FAILED;
+    }
+
+    // After the move, like copy_item; a cross-volume move writes dst for a while
+    listing_cache_invalidate_tree(src);
+    listing_cache_invalidate_parent(src);
+    listing_cache_invalidate_parent(dst);
+    if (is_directory) {
+        listing_cache_invalidate_tree(dst);
+    }
+    file_index_note_change(src);
+    file_index_note_change(dst);
+    return result;
+}
+
+static item_result_t run_item(file_job_t *job, const char *path) {
+    char full[FILE_JOBS_FULL_PATH_LEN];
+    full_path(full, sizeof(full), path);
+    struct stat st;
+    if (stat(full, &st) != 0) {
+        ESP_LOGE(TAG, "Not found: %s", path);
+        return ITEM_FAILED;
+    }
+    bool is_directory = S_ISDIR(st.st_mode);
+
+    switch (job->info.type) {
+        case FILE_JOB_COPY:
+            return copy_item(job, path, is_directory, (uint64_t)st.st_size);
+        case FILE_JOB_MOVE:
+            return move_item(job, path, is_directory, (uint64_t)st.st_size);
+        case FILE_JOB_DELETE:
+        default:
+            return remove_entry(job, path);
+    }
+}
+
+static void verify_failed_cb(const char *dst_full, void *user_data) {
+    record_failure((file_job_t *)user_data, dst_full + strlen(SD_MOUNT_POINT));
+}
+
+static file_job_state_t finish_verify(file_job_t *job, file_job_state_t state) {
+    copy_verify_stats_t stats;
+    copy_verify_end(verify_failed_cb, job, &stats);
+
+    xSemaphoreTake(jobs_lock, portMAX_DELAY);
+    job->info.files_verified = stats.files;
+    job->info.verify_ms = stats.busy_ms;
+    job->info.verify_wait_ms = stats.wait_ms;
+    xSemaphoreGive(jobs_lock);
+
+    if (stats.files || stats.failed) {
+        ESP_LOGI(TAG, "Verified %" PRIu32 " files (%" PRIu64 " bytes) in %" PRIu32 " ms, %" PRIu32
+                 " failed; copying waited %" PRIu32 " ms for it",
+                 stats.files, stats.bytes, stats.busy_ms, stats.failed, stats.wait_ms);
+    }
+    return stats.failed && state == FILE_JOB_DONE ? FILE_JOB_FAILED : state;
+}
+
+static file_job_state_t run_items(file_job_t *job) {
+    for (uint32_t i = 0; i < job->info.items_total; i++) {
+        if (job->cancel) {
+            return FILE_JOB_CANCELLED;
+        }
+        const char *path = job->arena + job->items[i];
+        set_current(job, path);
+        item_result_t result = run_item(job, path);
+        if (result == ITEM_CANCELLED) {
+            return FILE_JOB_CANCELLED;
+        }
+        count_item(job, result);
+    }
+    return job->info.items_failed ? FILE_JOB_FAILED : FILE_JOB_DONE;
+}
+
+static file_job_state_t run_job(file_job_t *job) {
+    if (!sd_manager_is_mounted()) {
+        ESP_LOGE(TAG, "SD card not mounted");
+        return FILE_JOB_FAILED;
+    }
+    job->started_us = esp_timer_get_time();
+    // Moves are renames and take no time per file, so only copies and deletes are counted
+    uint32_t folders = job->info.type != FILE_JOB_MOVE ? measure_job(job) : 0;
+
+    // Refuse a copy that cannot fit before any of it is written. Overwrites
+    // give space back as they go, so those are left to run into a full card.
+    if (job->info.type == FILE_JOB_COPY && job->conflict != FILE_JOB_CONFLICT_OVERWRITE && !job->cancel &&
+        sd_space_check_fit(job->info.bytes_total, job->info.files_total, folders) == ESP_ERR_INVALID_SIZE) {
+        ESP_LOGE(TAG, "Job %" PRIu32 " needs %" PRIu64 " bytes, more than the card has free",
+                 job->info.id, job->info.bytes_total);
+        xSemaphoreTake(jobs_lock, portMAX_DELAY);
+        job->info.out_of_space = true;
+        job->info.items_failed = job->info.items_total;
+        xSemaphoreGive(jobs_lock);
+        return FILE_JOB_FAILED;
+    }
+
+    // Moves may still copy, when the destination is on another volume
+    if (job->info.verify && (job->info.type == FILE_JOB_DELETE || copy_verify_begin() != ESP_OK)) {
+        ESP_LOGW(TAG, "Job %" PRIu32 " runs without verification", job->info.id);
+        xSemaphoreTake(jobs_lock, portMAX_DELAY);
+        job->info.verify = false;
+        xSemaphoreGive(jobs_lock);
+    }
+    file_job_state_t state = run_items(job);
+    return job->info.verify ? finish_verify(job, state) : state;
+}
+
+// ---- Worker ----
+
+static file_job_t *take_next_job(void) {
+    xSemaphoreTake(jobs_lock, portMAX_DELAY);
+    file_job_t *next = NULL;
+    for (uint32_t i = 0; i < job_count; i++) {
+        if (jobs[i]->info.state == FILE_JOB_QUEUED) {
+            next = jobs[i];
+            next->info.state = FILE_JOB_RUNNING;
+            break;
+        }
+    }
+    running_job = next;
+    xSemaphoreGive(jobs_lock);
+    return next;
+}
+
+static void finish_job(file_job_t *job, file_job_state_t state) {
+    xSemaphoreTake(jobs_lock, portMAX_DELAY);
+    job->info.state = state;
+    job->info.current[0] = '\0';
+    if (job->started_us) {
+        update_elapsed(job);
+    }
+    release_items(job);
+    running_job = NULL;
+    finished_count++;
+    // The UI may forget the job as soon as the lock is released
+    file_job_info_t info = job->info;
+    xSemaphoreGive(jobs_lock);
+
+    ESP_LOGI(TAG, "Job %" PRIu32 " (%s) %s: %" PRIu32 " done, %" PRIu32 " skipped, %" PRIu32 " failed",
+             info.id, info.description,
+             state == FILE_JOB_DONE ? "finished" : state == FILE_JOB_CANCELLED ? "cancelled" : "failed",
+             info.items_done, info.items_skipped, info.items_failed);
+    if (info.bytes_done > 0 && info.elapsed_ms > 0) {
+        ESP_LOGI(TAG, "Job %" PRIu32 ": %" PRIu64 " bytes in %" PRIu32 " ms (%.1f MB/s), verify overhead %.1f%%",
+                 info.id, info.bytes_done, info.elapsed_ms,
+                 (double)info.bytes_done / 1048576.0 / (info.elapsed_ms / 1000.0),
+                 file_jobs_verify_overhead(&info));
+    }
+}
+
+static void file_jobs_task(void *arg) {
+    (void)arg;
+    for (;;) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        file_job_t *job;
+        while ((job = take_next_job()) != NULL) {
+            finish_job(job, run_job(job));
+        }
+    }
+}
+
+static bool ensure_worker(void) {
+    if (jobs_task) {
+        return true;
+    }
+
+    if (!jobs_lock) {
+        jobs_lock = xSemaphoreCreateMutex();
+        if (!jobs_lock) {
+            ESP_LOGE(TAG, "Failed to create jobs lock");
+            return false;
+        }
+    }
+
+    // Pinned to CPU1 like the other long-running workers, away from LVGL
+    BaseType_t result = xTaskCreatePinnedToCore(file_jobs_task, "file_jobs", FILE_JOBS_TASK_STACK,
+                                                NULL, FILE_JOBS_TASK_PRIORITY, &jobs_task, 1);
+    if (result != pdPASS) {
+        ESP_LOGE(TAG, "Failed to create jobs task");
+        jobs_task = NULL;
+        return false;
+    }
+    return true;
+}
+
+// ---- Public API ----
+
+file_job_t* file_job_create(file_job_type_t type, const char *dst_dir, file_job_conflict_t conflict) {
+    file_job_t *job = calloc(1, sizeof(file_job_t));
+    if (!job) {
+        ESP_LOGE(TAG, "Failed to allocate job");
+        return NULL;
+    }
+    job->info.type = type;
+    job->info.state = FILE_JOB_QUEUED;
+    job->conflict = conflict;
+    snprintf(job->dst_dir, sizeof(job->dst_dir), "%s", dst_dir ? dst_dir : "/");
+    return job;
+}
+
+esp_err_t file_job_add(file_job_t *job, const char *path) {
+    size_t len = strlen(path);
+    if (len >= FILE_JOBS_PATH_LEN) {
+        ESP_LOGE(TAG, "Path too long: %s", path);
+        return ESP_ERR_INVALID_SIZE;
+    }
+    if (!grow_array((void **)&job->items, &job->item_capacity, job->info.items_total + 1, sizeof(uint32_t)) ||
+        !grow_array((void **)&job->arena, &job->arena_size, job->arena_used + (uint32_t)len + 1, 1)) {
+        ESP_LOGE(TAG, "Out of memory adding %s to job", path);
+        return ESP_ERR_NO_MEM;
+    }
+    job->items[job->info.items_total++] = job->arena_used;
+    memcpy(job->arena + job->arena_used, path, len + 1);
+    job->arena_used += (uint32_t)len + 1;
+    return ESP_OK;
+}
+
+void file_job_set_verify(file_job_t *job, bool verify) {
+    job->info.verify = verify;
+}
+
+void file_job_discard(file_job_t *job) {
+    if (job) {
+        release_items(job);
+        free(job->failures);
+        free(job);
+    }
+}
+
+static void describe_job(file_job_t *job) {
+    static const char *const verbs[] = { "Copy", "Move", "Delete" };
+    const char *verb = verbs[job->info.type];
+    char what[40];
+    if (job->info.items_total == 1) {
+        snprintf(what, sizeof(what), "%s", base_name(job->arena + job->items[0]));
+    } else {
+        snprintf(what, sizeof(what), "%" PRIu32 " items", job->info.items_total);
+    }
+    if (job->info.type == FILE_JOB_DELETE) {
+        snprintf(job->info.description, sizeof(job->info.description), "%s %s", verb, what);
+    } else {
+        snprintf(job->info.description, sizeof(job->info.description), "%s %s to %s", verb, what, job->dst_dir);
+    }
+}
+
+uint32_t file_jobs_submit(file_job_t *job) {
+    if (!job) {
+        return 0;
+    }
+    if (job->info.items_total == 0 || !ensure_worker()) {
+        file_job_discard(job);
+        return 0;
+    }
+    describe_job(job);
+
+    xSemaphoreTake(jobs_lock, portMAX_DELAY);
+    if (job_count == FILE_JOBS_MAX) {
+        // Make room by forgetting the oldest finished job
+        for (uint32_t i = 0; i < job_count; i++) {
+            if (job_finished(jobs[i])) {
+                file_job_discard(jobs[i]);
+                memmove(&jobs[i], &jobs[i + 1], (job_count - i - 1) * sizeof(jobs[0]));
+                job_count--;
+                break;
+            }
+        }
+    }
+    if (job_count == FILE_JOBS_MAX) {
+        xSemaphoreGive(jobs_lock);
+        ESP_LOGE(TAG, "Too many unfinished jobs");
+        file_job_discard(job);
+        return 0;
+    }
+    uint32_t id = next_job_id++;
+    if (next_job_id == 0) {
+        next_job_id = 1; // 0 is reserved for "no job"
+    }
+    job->info.id = id;
+    jobs[job_count++] = job;
+    xSemaphoreGive(jobs_lock);
+
+    ESP_LOGI(TAG, "Queued job %" PRIu32 ": %s", id, job->info.description);
+    xTaskNotifyGive(jobs_task);
+    return id;
+}
+
+esp_err_t file_jobs_cancel(uint32_t id) {
+    if (!jobs_lock) {
+        return ESP_ERR_NOT_FOUND;
+    }
+    esp_err_t ret = ESP_ERR_NOT_FOUND;
+    xSemaphoreTake(jobs_lock, portMAX_DELAY);
+    for (uint32_t i = 0; i < job_count; i++) {
+        file_job_t *job = jobs[i];
+        if (job->info.id != id) {
+            continue;
+        }
+        if (job->info.state == FILE_JOB_QUEUED) {
+            job->info.state = FILE_JOB_CANCELLED;
+            release_items(job);
+            finished_count++;
+            ret = ESP_OK;
+        } else if (job->info.state == FILE_JOB_RUNNING) {
+            job->cancel = true;
+            ret = ESP_OK;
+        }
+        break;
+    }
+    xSemaphoreGive(jobs_lock);
+    return ret;
+}
+
+uint32_t file_jobs_snapshot(file_job_info_t *out, uint32_t max) {
+    if (!jobs_lock) {
+        return 0;
+    }
+    xSemaphoreTake(jobs_lock, portMAX_DELAY);
+    uint32_t count = job_count < max ? job_count : max;
+    for (uint32_t i = 0; i < count; i++) {
+        out[i] = jobs[i]->info;
+    }
+    xSemaphoreGive(jobs_lock);
+    return count;
+}
+
+esp_err_t file_jobs_get_failure(uint32_t id, uint32_t index, char *path, size_t size) {
+    if (!jobs_lock) {
+        return ESP_ERR_NOT_FOUND;
+    }
+    esp_err_t ret = ESP_ERR_NOT_FOUND;
+    xSemaphoreTake(jobs_lock, portMAX_DELAY);
+    for (uint32_t i = 0; i < job_count; i++) {
+        file_job_t *job = jobs[i];
+        if (job->info.id != id) {
+            continue;
+        }
+        if (index < job->failures_listed) {
+            const char *failure = job->failures;
+            for (uint32_t n = 0; n < index; n++) {
+                failure += strlen(failure) + 1;
+            }
+            snprintf(path, size, "%s", failure);
+            ret = ESP_OK;
+        }
+        break;
+    }
+    xSemaphoreGive(jobs_lock);
+    return ret;
+}
+
+float file_jobs_verify_overhead(const file_job_info_t *info) {
+    if (!info->verify || info->elapsed_ms <= info->verify_wait_ms) {
+        return 0.0f;
+    }
+    return 100.0f * (float)info->verify_wait_ms / (float)(info->elapsed_ms - info->verify_wait_ms);
+}
+
+bool file_jobs_busy(void) {
+    if (!jobs_lock) {
+        return false;
+    }
+    bool busy = false;
+    xSemaphoreTake(jobs_lock, portMAX_DELAY);
+    for (uint32_t i = 0; i < job_count && !busy; i++) {
+        busy = !job_finished(jobs[i]);
+    }
+    xSemaphoreGive(jobs_lock);
+    return busy;
+}
+
+uint32_t file_jobs_finished_count(void) {
+    return finished_count;
+}
+
+void file_jobs_clear_finished(void) {
+    if (!jobs_lock) {
+        return;
+    }
+    xSemaphoreTake(jobs_lock, portMAX_DELAY);
+    uint32_t kept = 0;
+    for (uint32_t i = 0; i < job_count; i++) {
+        if (job_finished(jobs[i])) {
+            file_job_discard(jobs[i]);
+        } else {
+            jobs[kept++] = jobs[i];
+        }
+    }
+    job_count = kept;
+    xSemaphoreGive(jobs_lock);
+}
+
+void file_jobs_stop(void) {
+    if (!jobs_lock) {
+        return;
+    }
+
+    xSemaphoreTake(jobs_lock, portMAX_DELAY);
+    for (uint32_t i = 0; i < job_count; i++) {
+        file_job_t *job = jobs[i];
+        if (job->info.state == FILE_JOB_QUEUED) {
+            job->info.state = FILE_JOB_CANCELLED;
+            release_items(job);
+            finished_count++;
+        } else if (job->info.state == FILE_JOB_RUNNING) {
+            job->cancel = true;
+        }
+    }
+    xSemaphoreGive(jobs_lock);
+
+    // Cancellation is checked per copy chunk and per directory entry
+    uint32_t waited = 0;
+    for (;;) {
+        xSemaphoreTake(jobs_lock, portMAX_DELAY);
+        bool busy = running_job != NULL;
+        xSemaphoreGive(jobs_lock);
+        if (!busy) {
+            break;
+        }
+        if (waited >= FILE_JOBS_STOP_TIMEOUT_MS) {
+            ESP_LOGW(TAG, "Job worker did not stop in time");
+            break;
+        }
+        vTaskDelay(pdMS_TO_TICKS(10));
+        waited += 10;
+    }
+}
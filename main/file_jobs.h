@@ -0,0 +1,181 @@
+#ifndef FILE_JOBS_H
+#define FILE_JOBS_H
+
+#include "esp_err.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Jobs remembered at once (queued, running and finished)
+#define FILE_JOBS_MAX 16
+
+// UI poll period for job progress
+#define FILE_JOBS_POLL_MS 100
+
+// Longest path (relative to SD root) a job accepts
+#define FILE_JOBS_PATH_LEN 256
+
+// Failed files a job remembers by name; files_failed keeps counting past it
+#define FILE_JOBS_MAX_FAILURES 32
+
+typedef enum {
+    FILE_JOB_COPY,
+    FILE_JOB_MOVE,
+    FILE_JOB_DELETE
+} file_job_type_t;
+
+typedef enum {
+    FILE_JOB_QUEUED,
+    FILE_JOB_RUNNING,
+    FILE_JOB_DONE,        // Every item handled (some may have been skipped)
+    FILE_JOB_FAILED,      // Finished, but at least one item failed
+    FILE_JOB_CANCELLED
+} file_job_state_t;
+
+// What to do when the destination name is already taken
+typedef enum {
+    FILE_JOB_CONFLICT_RENAME,     // Keep both, the new one becomes "name (2).ext"
+    FILE_JOB_CONFLICT_OVERWRITE,  // Replace files; folders are merged
+    FILE_JOB_CONFLICT_SKIP        // Leave the existing entry and skip the item
+} file_job_conflict_t;
+
+// Snapshot of a job for the UI
+typedef struct {
+    uint32_t id;
+    file_job_type_t type;
+    file_job_state_t state;
+    char description[64];       // e.g. "Copy 12 items to /photos"
+    char current[64];           // Name of the item being worked on
+    uint32_t items_total;       // Top-level items
+    uint32_t items_done;
+    uint32_t items_failed;
+    uint32_t items_skipped;
+    uint64_t bytes_total;       // Data to copy, counted before a copy starts
+    uint64_t bytes_done;
+    uint32_t files_total;       // Files inside the items, counted before a copy or delete starts
+    uint32_t files_done;
+    uint32_t files_failed;      // Files that could not be copied, deleted or verified
+    uint32_t elapsed_ms;        // Running time when progress last moved
+    bool verify;                // Copies are read back and checked
+    uint32_t files_verified;    // Copies that matched their source (when verify ends)
+    uint32_t verify_ms;         // Time spent reading copies back, mostly alongside copying
+    uint32_t verify_wait_ms;    // Part of elapsed_ms spent waiting on verification
+    bool out_of_space;          // Refused up front: the card has too little free space
+} file_job_info_t;
+
+// A job being put together; becomes owned by the queue on submit
+typedef struct file_job file_job_t;
+
+/**
+ * @brief Start putting a job together
+ * @param type Operation
+ * @param dst_dir Destination directory (relative to SD root), ignored for deletes
+ * @param conflict Conflict policy for copies and moves
+ * @return New job, NULL if out of memory
+ */
+file_job_t* file_job_create(file_job_type_t type, const char *dst_dir, file_job_conflict_t conflict);
+
+/**
+ * @brief Add a file or folder to a job
+ * @param job Job from file_job_create()
+ * @param path Entry path (relative to SD root)
+ * @return ESP_OK on success, ESP_ERR_INVALID_SIZE if the path is too long,
+ *         ESP_ERR_NO_MEM if out of memory
+ */
+esp_err_t file_job_add(file_job_t *job, const char *path);
+
+/**
+ * @brief Read back every copied file and compare it with its source
+ *
+ * Each source is hashed (CRC32) as it is read and each copy is read back
+ * from the card while the next file copies. A mismatch fails the job and
+ * names the file; the original of a move that fails verification is kept.
+ * Moves within the card are renames and have nothing to verify.
+ *
+ * @param job Job from file_job_create()
+ * @param verify true to verify
+ */
+void file_job_set_verify(file_job_t *job, bool verify);
+
+/**
+ * @brief Throw away a job that was not submitted
+ * @param job Job from file_job_create()
+ */
+void file_job_discard(file_job_t *job);
+
+/**
+ * @brief Queue a job on the background worker
+ *
+ * Jobs run one at a time in the order they were submitted. Moves within the
+ * card are renames, so they take the same time whatever the size.
+ *
+ * @param job Job from file_job_create(); owned by the queue afterwards, even on failure
+ * @return Job id, 0 if the job could not be queued
+ */
+uint32_t file_jobs_submit(file_job_t *job);
+
+/**
+ * @brief Cancel a queued or running job
+ *
+ * A running job stops within one copy chunk or one directory entry. Items
+ * already finished stay done; a partly copied file is removed.
+ *
+ * @param id Job id from file_jobs_submit()
+ * @return ESP_OK if the job was cancelled, ESP_ERR_NOT_FOUND if it already finished
+ */
+esp_err_t file_jobs_cancel(uint32_t id);
+
+/**
+ * @brief Copy out the current state of every remembered job, oldest first
+ * @param jobs Output array
+ * @param max Capacity of the array
+ * @return Number of jobs written
+ */
+uint32_t file_jobs_snapshot(file_job_info_t *jobs, uint32_t max);
+
+/**
+ * @brief Get the path of a file a job failed on
+ * @param id Job id from file_jobs_submit()
+ * @param index Failure number, from 0 up to min(files_failed, FILE_JOBS_MAX_FAILURES)
+ * @param path Output path (relative to SD root)
+ * @param size Size of the path buffer
+ * @return ESP_OK on success, ESP_ERR_NOT_FOUND if there is no such job or failure
+ */
+esp_err_t file_jobs_get_failure(uint32_t id, uint32_t index, char *path, size_t size);
+
+/**
+ * @brief Extra time verification added to a job
+ *
+ * Only the time the copy had to wait for read-back counts; reading back
+ * alongside copying is free.
+ *
+ * @param info Job snapshot
+ * @return Percentage over the time the job would have taken unverified, 0 if not verified
+ */
+float file_jobs_verify_overhead(const file_job_info_t *info);
+
+/**
+ * @brief Check whether any job is queued or running
+ * @return true while there is work left
+ */
+bool file_jobs_busy(void);
+
+/**
+ * @brief Count of jobs that have ended, for noticing changes to the card
+ * @return Increases every time a job finishes, fails or is cancelled
+ */
+uint32_t file_jobs_finished_count(void);
+
+/**
+ * @brief Forget finished, failed and cancelled jobs
+ */
+void file_jobs_clear_finished(void);
+
+/**
+ * @brief Cancel every job and wait for the worker to leave the card
+ *
+ * Call before the card is unmounted.
+ */
+void file_jobs_stop(void);
+
+#endif // FILE_JOBS_H
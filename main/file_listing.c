@@ -0,0 +1,321 @@
+#include "file_listing.h"
+#include "sd_manager.h"
+#include "sd_io.h"
+#include "esp_log.h"
+#include "esp_heap_caps.h"
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <ctype.h>
+#include <inttypes.h>
+
+static const char *TAG = "FILE_LISTING";
+
+#define LISTING_INITIAL_ENTRIES 64
+#define LISTING_INITIAL_ARENA   2048
+
+// Bytes of per-entry storage: name key, size, name offset, mtime, extension key and flags
+#define LISTING_ENTRY_BYTES (2 * sizeof(uint64_t) + 3 * sizeof(uint32_t) + sizeof(uint8_t))
+
+// Point the per-entry arrays into one block; the 64-bit keys go first to stay aligned
+static void carve_arrays(file_listing_t *listing, uint8_t *block, uint32_t capacity) {
+    listing->name_key = (uint64_t *)block;
+    listing->size = listing->name_key + capacity;
+    listing->name_offset = (uint32_t *)(listing->size + capacity);
+    listing->mtime = listing->name_offset + capacity;
+    listing->ext_key = listing->mtime + capacity;
+    listing->flags = (uint8_t *)(listing->ext_key + capacity);
+    listing->capacity = capacity;
+}
+
+static void copy_arrays(file_listing_t *dest, const file_listing_t *src, uint32_t count) {
+    memcpy(dest->name_key, src->name_key, count * sizeof(uint64_t));
+    memcpy(dest->size, src->size, count * sizeof(uint64_t));
+    memcpy(dest->name_offset, src->name_offset, count * sizeof(uint32_t));
+    memcpy(dest->mtime, src->mtime, count * sizeof(uint32_t));
+    memcpy(dest->ext_key, src->ext_key, count * sizeof(uint32_t));
+    memcpy(dest->flags, src->flags, count);
+}
+
+static esp_err_t grow_entries(file_listing_t *listing, uint32_t min_capacity) {
+    uint32_t new_capacity = listing->capacity ? listing->capacity * 2 : LISTING_INITIAL_ENTRIES;
+    while (new_capacity < min_capacity) {
+        new_capacity *= 2;
+    }
+    uint8_t *block = malloc((size_t)new_capacity * LISTING_ENTRY_BYTES);
+    if (!block) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    file_listing_t grown = *listing;
+    carve_arrays(&grown, block, new_capacity);
+    if (listing->count) {
+        copy_arrays(&grown, listing, listing->count);
+    }
+    free(listing->name_key);
+    *listing = grown;
+    return ESP_OK;
+}
+
+// Case-folded bytes packed big-endian, so integer order matches strcasecmp order
+static uint64_t fold_key(const char *s, int len, int width) {
+    uint64_t key = 0;
+    for (int i = 0; i < width; i++) {
+        key <<= 8;
+        if (i < len) {
+            key |= (uint8_t)tolower((unsigned char)s[i]);
+        }
+    }
+    return key;
+}
+
+static esp_err_t reserve_arena(file_listing_t *listing, uint32_t needed) {
+    if (listing->arena_used + needed <= listing->arena_size) {
+        return ESP_OK;
+    }
+
+    uint32_t new_size = listing->arena_size ? listing->arena_size : LISTING_INITIAL_ARENA;
+    while (new_size < listing->arena_used + needed) {
+        new_size *= 2;
+    }
+    char *arena = realloc(listing->arena, new_size);
+    if (!arena) {
+        return ESP_ERR_NO_MEM;
+    }
+    listing->arena = arena;
+    listing->arena_size = new_size;
+    return ESP_OK;
+}
+
+esp_err_t file_listing_add(file_listing_t *listing, const char *name, uint64_t size,
+                           uint32_t mtime, bool is_directory) {
+    if (listing->count == listing->capacity && grow_entries(listing, listing->count + 1) != ESP_OK) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    uint32_t name_len = strlen(name) + 1;
+    if (reserve_arena(listing, name_len) != ESP_OK) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    uint32_t index = listing->count;
+    memcpy(listing->arena + listing->arena_used, name, name_len);
+    listing->name_offset[index] = listing->arena_used;
+    listing->arena_used += name_len;
+
+    uint8_t flags = (uint8_t)file_ops_get_file_type(name, is_directory) & FILE_LISTING_TYPE_MASK;
+    if (is_directory) {
+        flags |= FILE_LISTING_FLAG_DIRECTORY;
+        listing->dir_count++;
+    }
+    if (name[0] == '.') {
+        flags |= FILE_LISTING_FLAG_HIDDEN;
+    }
+
+    const char *ext = strrchr(name, '.');
+    ext = ext ? ext + 1 : "";
+    listing->name_key[index] = fold_key(name, name_len - 1, 8);
+    listing->ext_key[index] = (uint32_t)fold_key(ext, strlen(ext), 4);
+
+    listing->size[index] = size;
+    listing->mtime[index] = mtime;
+    listing->flags[index] = flags;
+    listing->count++;
+    return ESP_OK;
+}
+
+esp_err_t file_listing_copy_entry(file_listing_t *dest, const file_listing_t *src, uint32_t index) {
+    // Keys are recomputed by file_listing_add, only the flags need carrying over
+    if (file_listing_add(dest, file_listing_name(src, index), src->size[index], src->mtime[index],
+                         file_listing_is_dir(src, index)) != ESP_OK) {
+        return ESP_ERR_NO_MEM;
+    }
+    dest->flags[dest->count - 1] = src->flags[index];
+    return ESP_OK;
+}
+
+static bool load_entry_cb(const sd_dir_entry_t *entry, void *user_data) {
+    file_listing_t *listing = (file_listing_t *)user_data;
+    if (file_listing_add(listing, entry->name, entry->size,
+                         (uint32_t)entry->mtime, entry->is_directory) != ESP_OK) {
+        return false;
+    }
+    if (entry->attributes & SD_ATTR_READONLY) {
+        listing->flags[listing->count - 1] |= FILE_LISTING_FLAG_READONLY;
+    }
+    return true;
+}
+
+esp_err_t file_listing_load(file_listing_t *listing, const char *path, bool show_hidden) {
+    file_listing_clear(listing);
+
+    sd_io_begin(SD_IO_INTERACTIVE);
+    int seen = sd_manager_enumerate(path, show_hidden, load_entry_cb, listing);
+    sd_io_end(SD_IO_INTERACTIVE);
+    if (seen < 0) {
+        return ESP_FAIL;
+    }
+    if ((uint32_t)seen != listing->count) {
+        ESP_LOGE(TAG, "Out of memory, listing of %s truncated at %" PRIu32 " entries", path, listing->count);
+        return ESP_ERR_NO_MEM;
+    }
+    return ESP_OK;
+}
+
+static void copy_contents(file_listing_t *dest, const file_listing_t *src) {
+    copy_arrays(dest, src, src->count);
+    memcpy(dest->arena, src->arena, src->arena_used);
+    dest->count = src->count;
+    dest->dir_count = src->dir_count;
+    dest->arena_used = src->arena_used;
+}
+
+esp_err_t file_listing_copy(file_listing_t *dest, const file_listing_t *src) {
+    file_listing_clear(dest);
+    if (src->count > dest->capacity && grow_entries(dest, src->count) != ESP_OK) {
+        return ESP_ERR_NO_MEM;
+    }
+    if (reserve_arena(dest, src->arena_used) != ESP_OK) {
+        return ESP_ERR_NO_MEM;
+    }
+    copy_contents(dest, src);
+    return ESP_OK;
+}
+
+esp_err_t file_listing_clone(file_listing_t *dest, const file_listing_t *src, uint32_t caps) {
+    memset(dest, 0, sizeof(*dest));
+
+    // Exact-size copy: a clone is read-only, so it never needs headroom
+    uint32_t capacity = src->count ? src->count : 1;
+    uint8_t *block = heap_caps_malloc((size_t)capacity * LISTING_ENTRY_BYTES, caps);
+    char *arena = heap_caps_malloc(src->arena_used ? src->arena_used : 1, caps);
+    if (!block || !arena) {
+        free(block);
+        free(arena);
+        return ESP_ERR_NO_MEM;
+    }
+
+    carve_arrays(dest, block, capacity);
+    dest->arena = arena;
+    dest->arena_size = src->arena_used ? src->arena_used : 1;
+    copy_contents(dest, src);
+    return ESP_OK;
+}
+
+size_t file_listing_memory(const file_listing_t *listing) {
+    return (size_t)listing->capacity * LISTING_ENTRY_BYTES + listing->arena_size;
+}
+
+void file_listing_clear(file_listing_t *listing) {
+    listing->count = 0;
+    listing->dir_count = 0;
+    listing->arena_used = 0;
+}
+
+void file_listing_free(file_listing_t *listing) {
+    free(listing->name_key);
+    free(listing->arena);
+    memset(listing, 0, sizeof(*listing));
+}
+
+typedef struct {
+    const file_listing_t *listing;
+    file_listing_sort_t by;
+    bool ascending;
+} sort_ctx_t;
+
+// Compare the rest of two names once their 8-byte keys are equal
+static int compare_name_tail(const file_listing_t *listing, uint32_t a, uint32_t b) {
+    // A zero low byte means both names ended inside the key, so they are equal
+    if ((listing->name_key[a] & 0xFF) == 0) {
+        return 0;
+    }
+    return strcasecmp(file_listing_name(listing, a) + 8, file_listing_name(listing, b) + 8);
+}
+
+static int compare_entries(const sort_ctx_t *ctx, uint32_t a, uint32_t b) {
+    const file_listing_t *l = ctx->listing;
+
+    // Directories first, regardless of direction
+    bool dir_a = file_listing_is_dir(l, a);
+    bool dir_b = file_listing_is_dir(l, b);
+    if (dir_a != dir_b) {
+        return dir_a ? -1 : 1;
+    }
+
+    int result = 0;
+    switch (ctx->by) {
+        case FILE_LISTING_SORT_SIZE:
+            result = (l->size[a] > l->size[b]) - (l->size[a] < l->size[b]);
+            break;
+        case FILE_LISTING_SORT_DATE:
+            result = (l->mtime[a] > l->mtime[b]) - (l->mtime[a] < l->mtime[b]);
+            break;
+        case FILE_LISTING_SORT_TYPE:
+            result = (l->ext_key[a] > l->ext_key[b]) - (l->ext_key[a] < l->ext_key[b]);
+            if (result == 0 && (l->ext_key[a] & 0xFF) != 0) {
+                // Extensions longer than the key: compare the remainder
+                result = strcasecmp(strrchr(file_listing_name(l, a), '.') + 5,
+                                    strrchr(file_listing_name(l, b), '.') + 5);
+            }
+            if (result != 0) {
+                break;
+            }
+            // Same extension: fall through to the name
+            /* fallthrough */
+        case FILE_LISTING_SORT_NAME:
+        default:
+            result = (l->name_key[a] > l->name_key[b]) - (l->name_key[a] < l->name_key[b]);
+            if (result == 0) {
+                result = compare_name_tail(l, a, b);
+            }
+            break;
+    }
+    return ctx->ascending ? result : -result;
+}
+
+esp_err_t file_listing_sort(const file_listing_t *listing, uint32_t *order, uint32_t count,
+                            file_listing_sort_t by, bool ascending) {
+    if (count < 2) {
+        return ESP_OK;
+    }
+    uint32_t *scratch = malloc(count * sizeof(uint32_t));
+    if (!scratch) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    sort_ctx_t ctx = {
+        .listing = listing,
+        .by = by,
+        .ascending = ascending
+    };
+
+    // Bottom-up merge sort: stable, O(n log n) worst case, no recursion
+    uint32_t *src = order;
+    uint32_t *dst = scratch;
+    for (uint32_t width = 1; width < count; width *= 2) {
+        for (uint32_t lo = 0; lo < count; lo += 2 * width) {
+            uint32_t mid = lo + width < count ? lo + width : count;
+            uint32_t hi = lo + 2 * width < count ? lo + 2 * width : count;
+            uint32_t i = lo, j = mid, k = lo;
+            while (i < mid && j < hi) {
+                dst[k++] = compare_entries(&ctx, src[j], src[i]) < 0 ? src[j++] : src[i++];
+            }
+            while (i < mid) {
+                dst[k++] = src[i++];
+            }
+            while (j < hi) {
+                dst[k++] = src[j++];
+            }
+        }
+        uint32_t *swap = src;
+        src = dst;
+        dst = swap;
+    }
+    if (src != order) {
+        memcpy(order, src, count * sizeof(uint32_t));
+    }
+
+    free(scratch);
+    return ESP_OK;
+}
@@ -0,0 +1,138 @@
+#ifndef FILE_LISTING_H
+#define FILE_LISTING_H
+
+#include "esp_err.h"
+#include "file_operations.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Packed per-entry flags: low nibble is the file_type_t, high bits are flags
+#define FILE_LISTING_TYPE_MASK      0x0F
+#define FILE_LISTING_FLAG_DIRECTORY 0x10
+#define FILE_LISTING_FLAG_HIDDEN    0x20
+#define FILE_LISTING_FLAG_READONLY  0x40
+
+typedef enum {
+    FILE_LISTING_SORT_NAME,
+    FILE_LISTING_SORT_SIZE,
+    FILE_LISTING_SORT_DATE,
+    FILE_LISTING_SORT_TYPE
+} file_listing_sort_t;
+
+/*
+ * Struct-of-arrays directory listing. Per-entry data lives in one block
+ * (name offsets, sizes, times, flags) and all names are interned back to back
+ * in a single string arena, so a listing is two allocations regardless of
+ * its size. Nothing is formatted up front; callers format only what they show.
+ */
+typedef struct {
+    uint32_t count;
+    uint32_t capacity;
+    uint32_t dir_count;
+    uint64_t *name_key;     // First 8 name bytes, case-folded, big-endian (sort key)
+    uint64_t *size;         // File size; exFAT files can pass 4 GiB
+    uint32_t *name_offset;  // Offset of each name in the arena
+    uint32_t *mtime;        // Modification time (Unix seconds)
+    uint32_t *ext_key;      // First 4 extension bytes, case-folded, big-endian (sort key)
+    uint8_t *flags;         // FILE_LISTING_* bits
+    char *arena;            // NUL-terminated names
+    uint32_t arena_used;
+    uint32_t arena_size;
+} file_listing_t;
+
+/**
+ * @brief Read a directory into a listing, replacing previous contents
+ * @param listing Listing to fill (zero-initialized or previously used)
+ * @param path Directory path (relative to SD root)
+ * @param show_hidden Include hidden files (starting with '.')
+ * @return ESP_OK on success, ESP_ERR_NO_MEM if the listing was truncated
+ */
+esp_err_t file_listing_load(file_listing_t *listing, const char *path, bool show_hidden);
+
+/**
+ * @brief Append one entry to a listing
+ * @param listing Listing to append to
+ * @param name Entry name (copied into the arena)
+ * @param size File size in bytes
+ * @param mtime Modification time
+ * @param is_directory true for directories
+ * @return ESP_OK on success, ESP_ERR_NO_MEM on allocation failure
+ */
+esp_err_t file_listing_add(file_listing_t *listing, const char *name, uint64_t size,
+                           uint32_t mtime, bool is_directory);
+
+/**
+ * @brief Append a copy of another listing's entry, flags included
+ * @param dest Listing to append to
+ * @param src Listing to copy from
+ * @param index Entry index in src
+ * @return ESP_OK on success, ESP_ERR_NO_MEM on allocation failure
+ */
+esp_err_t file_listing_copy_entry(file_listing_t *dest, const file_listing_t *src, uint32_t index);
+
+/**
+ * @brief Replace a listing's contents with a copy of another listing
+ * @param dest Listing to overwrite (storage is reused when large enough)
+ * @param src Listing to copy
+ * @return ESP_OK on success, ESP_ERR_NO_MEM on allocation failure
+ */
+esp_err_t file_listing_copy(file_listing_t *dest, const file_listing_t *src);
+
+/**
+ * @brief Make an exact-size copy of a listing in memory with the given caps
+ * @param dest Uninitialized listing to create (release with file_listing_free)
+ * @param src Listing to copy
+ * @param caps heap_caps flags for the new storage (e.g. MALLOC_CAP_SPIRAM)
+ * @return ESP_OK on success, ESP_ERR_NO_MEM on allocation failure
+ */
+esp_err_t file_listing_clone(file_listing_t *dest, const file_listing_t *src, uint32_t caps);
+
+/**
+ * @brief Get the heap memory held by a listing
+ * @param listing Listing to measure
+ * @return Bytes allocated for entries and names
+ */
+size_t file_listing_memory(const file_listing_t *listing);
+
+/**
+ * @brief Stable sort of listing indices, directories first
+ *
+ * Compares the precomputed name/extension keys and only falls back to the
+ * full strings when two keys are equal.
+ *
+ * @param listing Listing the indices refer to
+ * @param order Indices to sort in place
+ * @param count Number of indices
+ * @param by Sort criterion
+ * @param ascending Sort direction (directories stay first either way)
+ * @return ESP_OK on success, ESP_ERR_NO_MEM if the scratch buffer could not be allocated
+ */
+esp_err_t file_listing_sort(const file_listing_t *listing, uint32_t *order, uint32_t count,
+                            file_listing_sort_t by, bool ascending);
+
+/**
+ * @brief Drop all entries but keep the allocated storage
+ * @param listing Listing to clear
+ */
+void file_listing_clear(file_listing_t *listing);
+
+/**
+ * @brief Release all memory held by a listing
+ * @param listing Listing to free
+ */
+void file_listing_free(file_listing_t *listing);
+
+static inline const char* file_listing_name(const file_listing_t *listing, uint32_t index) {
+    return listing->arena + listing->name_offset[index];
+}
+
+static inline bool file_listing_is_dir(const file_listing_t *listing, uint32_t index) {
+    return (listing->flags[index] & FILE_LISTING_FLAG_DIRECTORY) != 0;
+}
+
+static inline file_type_t file_listing_type(const file_listing_t *listing, uint32_t index) {
+    return (file_type_t)(listing->flags[index] & FILE_LISTING_TYPE_MASK);
+}
+
+#endif // FILE_LISTING_H
@@ -1,24 +1,45 @@
 #include "file_operations.h"
 #include "sd_manager.h"
+#include "listing_cache.h"
+#include "file_index.h"
+#include "sd_space.h"
+#include "copy_engine.h"
+#include "tree_walk.h"
+#include "copy_batch.h"
 #include "esp_log.h"
 #include <string.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <sys/stat.h>
 #include <unistd.h>
-#include <dirent.h>
 #include <errno.h>
+#include <inttypes.h>
 
 static const char *TAG = "FILE_OPS";
 
-// Buffer size for copy operations (512 bytes like bmorcelli)
-#define COPY_BUFFER_SIZE 512
 #define MAX_PATH_LENGTH 512  // Increased to prevent truncation warnings
 
-// Static buffer for copy/paste operations
-static char clipboard_path[MAX_PATH_LENGTH] = {0};
+/*
+ * Clipboard: each item is a name plus the index of its parent directory in an
+ * interned path table, all strings sharing one arena. Items picked from the
+ * same directory store that directory once, so thousands of entries cost
+ * little more than their names.
+ */
+typedef struct {
+    uint32_t dir;   // Index into clipboard_dirs
+    uint32_t name;  // Offset in clipboard_arena
+} clipboard_item_t;
+
+static char *clipboard_arena = NULL;
+static uint32_t clipboard_arena_used = 0;
+static uint32_t clipboard_arena_size = 0;
+static uint32_t *clipboard_dirs = NULL;     // Arena offsets of interned directories
+static uint32_t clipboard_dir_count = 0;
+static uint32_t clipboard_dir_capacity = 0;
+static clipboard_item_t *clipboard_items = NULL;
+static uint32_t clipboard_item_count = 0;
+static uint32_t clipboard_item_capacity = 0;
 static bool clipboard_is_cut = false;
-static bool clipboard_has_content = false;
 
 esp_err_t file_ops_create_directory(const char *path) {
     if (!sd_manager_is_mounted()) {
@@ -30,6 +51,9 @@ esp_err_t file_ops_create_directory(const char *path) {
     snprintf(full_path, sizeof(full_path), "%s%s", SD_MOUNT_POINT, path);
     
     if (mkdir(full_path, 0755) == 0) {
+        sd_space_note_dir(true);
+        listing_cache_invalidate_parent(path);
+        file_index_note_change(path);
         ESP_LOGI(TAG, "Directory created: %s", full_path);
         return ESP_OK;
     } else {
@@ -47,7 +71,12 @@ esp_err_t file_ops_delete_file(const char *path) {
     char full_path[MAX_PATH_LENGTH];
     snprintf(full_path, sizeof(full_path), "%s%s", SD_MOUNT_POINT, path);
     
+    struct stat st;
+    uint64_t size = stat(full_path, &st) == 0 ? (uint64_t)st.st_size : 0;
     if (remove(full_path) == 0) {
+        sd_space_note_file(size, 0);
+        listing_cache_invalidate_parent(path);
+        file_index_note_change(path);
         ESP_LOGI(TAG, "File deleted: %s", full_path);
         return ESP_OK;
     } else {
@@ -56,34 +85,37 @@ esp_err_t file_ops_delete_file(const char *path) {
     }
 }
 
-static esp_err_t delete_directory_recursive(const char *path) {
-    DIR *dir = opendir(path);
-    if (!dir) {
-        return ESP_FAIL;
-    }
-    
-    struct dirent *entry;
-    char item_path[MAX_PATH_LENGTH];
-    
-    while ((entry = readdir(dir)) != NULL) {
-        if (strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0) {
-            continue;
-        }
-        
-        snprintf(item_path, sizeof(item_path), "%s/%s", path, entry->d_name);
-        
-        struct stat file_stat;
-        if (stat(item_path, &file_stat) == 0) {
-            if (S_ISDIR(file_stat.st_mode)) {
-                delete_directory_recursive(item_path);
-            } else {
-                remove(item_path);
-            }
+// Join a directory and an entry name without doubling the separator
+static bool join_path(char *out, size_t out_size, const char *dir, const char *name) {
+    size_t len = strlen(dir);
+    const char *sep = (len > 0 && dir[len - 1] == '/') ? "" : "/";
+    int written = snprintf(out, out_size, "%s%s%s", dir, sep, name);
+    if (written < 0 || (size_t)written >= out_size) {
+        ESP_LOGW(TAG, "Path too long, skipping: %s%s%s", dir, sep, name);
+        return false;
+    }
+    return true;
+}
+
+// Children first: files as they are listed, each directory once it is empty
+static tree_walk_action_t delete_tree_cb(const tree_walk_entry_t *entry, void *user_data) {
+    uint32_t *failed = (uint32_t *)user_data;
+    if (entry->event == TREE_WALK_ERROR) {
+        (*failed)++;
+    } else if (entry->event == TREE_WALK_FILE || entry->event == TREE_WALK_LEAVE) {
+        char full_path[MAX_PATH_LENGTH];
+        snprintf(full_path, sizeof(full_path), "%s%s", SD_MOUNT_POINT, entry->path);
+        int result = entry->event == TREE_WALK_FILE ? remove(full_path) : rmdir(full_path);
+        if (result != 0) {
+            ESP_LOGW(TAG, "Failed to delete %s (errno: %d)", entry->path, errno);
+            (*failed)++;
+        } else if (entry->event == TREE_WALK_FILE) {
+            sd_space_note_file(entry->size, 0);
+        } else {
+            sd_space_note_dir(false);
         }
     }
-    
-    closedir(dir);
-    return (rmdir(path) == 0) ? ESP_OK : ESP_FAIL;
+    return TREE_WALK_CONTINUE;
 }
 
 esp_err_t file_ops_delete_directory(const char *path) {
@@ -92,14 +124,22 @@ esp_err_t file_ops_delete_directory(const char *path) {
         return ESP_ERR_INVALID_STATE;
     }
     
-    char full_path[MAX_PATH_LENGTH];
-    snprintf(full_path, sizeof(full_path), "%s%s", SD_MOUNT_POINT, path);
+    uint32_t failed = 0;
+    tree_walk_stats_t stats;
+    esp_err_t ret = tree_walk(path, delete_tree_cb, &failed, &stats);
+    if (ret == ESP_OK && failed > 0) {
+        ret = ESP_FAIL;
+    }
     
-    esp_err_t ret = delete_directory_recursive(full_path);
+    // Even a partial delete changes the tree, so drop it either way
+    listing_cache_invalidate_tree(path);
+    listing_cache_invalidate_parent(path);
+    file_index_note_change(path);
     if (ret == ESP_OK) {
-        ESP_LOGI(TAG, "Directory deleted: %s", full_path);
+        ESP_LOGI(TAG, "Directory deleted: %s (%" PRIu32 " files, %" PRIu32 " folders)",
+                 path, stats.files, stats.dirs);
     } else {
-        ESP_LOGE(TAG, "Failed to delete directory: %s", full_path);
+        ESP_LOGE(TAG, "Failed to delete directory: %s (%" PRIu32 " entries left)", path, failed);
     }
     return ret;
 }
@@ -116,6 +156,11 @@ esp_err_t file_ops_rename(const char *old_path, const char *new_path) {
     snprintf(new_full, sizeof(new_full), "%s%s", SD_MOUNT_POINT, new_path);
     
     if (rename(old_full, new_full) == 0) {
+        listing_cache_invalidate_tree(old_path);
+        listing_cache_invalidate_parent(old_path);
+        listing_cache_invalidate_parent(new_path);
+        file_index_note_change(old_path);
+        file_index_note_change(new_path);
         ESP_LOGI(TAG, "Renamed: %s -> %s", old_full, new_full);
         return ESP_OK;
     } else {
@@ -135,81 +180,69 @@ esp_err_t file_ops_copy_file(const char *src_path, const char *dst_path) {
     snprintf(src_full, sizeof(src_full), "%s%s", SD_MOUNT_POINT, src_path);
     snprintf(dst_full, sizeof(dst_full), "%s%s", SD_MOUNT_POINT, dst_path);
     
-    FILE *src = fopen(src_full, "rb");
-    if (!src) {
-        ESP_LOGE(TAG, "Failed to open source file: %s", src_full);
-        return ESP_FAIL;
-    }
-    
-    FILE *dst = fopen(dst_full, "wb");
-    if (!dst) {
-        fclose(src);
-        ESP_LOGE(TAG, "Failed to open destination file: %s", dst_full);
-        return ESP_FAIL;
-    }
-    
-    // Copy file in 512-byte chunks (like bmorcelli)
-    uint8_t buffer[COPY_BUFFER_SIZE];
-    size_t bytes_read;
-    size_t total_copied = 0;
+    listing_cache_invalidate_parent(dst_path);
     
-    while ((bytes_read = fread(buffer, 1, sizeof(buffer), src)) > 0) {
-        size_t bytes_written = fwrite(buffer, 1, bytes_read, dst);
-        if (bytes_written != bytes_read) {
-            ESP_LOGE(TAG, "Write error during copy");
-            fclose(src);
-            fclose(dst);
-            remove(dst_full);
-            return ESP_FAIL;
-        }
-        total_copied += bytes_written;
+    copy_engine_stats_t stats;
+    esp_err_t ret = copy_engine_copy(src_full, dst_full, 0, NULL, NULL, &stats);
+    // Indexed once the size is final (or the partial file is gone)
+    file_index_note_change(dst_path);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to copy %s -> %s", src_path, dst_path);
+        return ret;
     }
     
-    fclose(src);
-    fclose(dst);
-    
-    ESP_LOGI(TAG, "Copied %zu bytes: %s -> %s", total_copied, src_path, dst_path);
+    ESP_LOGI(TAG, "Copied %" PRIu64 " bytes in %" PRIu32 " ms (%.1f MB/s%s): %s -> %s",
+             stats.bytes, stats.elapsed_ms, copy_engine_mb_per_s(&stats),
+             stats.contiguous ? ", contiguous" : "", src_path, dst_path);
     return ESP_OK;
 }
 
-static esp_err_t copy_directory_recursive(const char *src_path, const char *dst_path) {
-    // Create destination directory
-    if (mkdir(dst_path, 0755) != 0 && errno != EEXIST) {
-        return ESP_FAIL;
+typedef struct {
+    const char *dst_root;
+    bool batched;           // Small files go through copy_batch
+    uint32_t failed;
+} copy_tree_ctx_t;
+
+// Parents first: each directory is created before anything is copied into it
+static tree_walk_action_t copy_tree_cb(const tree_walk_entry_t *entry, void *user_data) {
+    copy_tree_ctx_t *ctx = (copy_tree_ctx_t *)user_data;
+    if (entry->event == TREE_WALK_ERROR) {
+        ctx->failed++;
+        return TREE_WALK_CONTINUE;
     }
-    
-    DIR *dir = opendir(src_path);
-    if (!dir) {
-        return ESP_FAIL;
+    if (entry->event == TREE_WALK_LEAVE) {
+        return TREE_WALK_CONTINUE;
     }
     
-    struct dirent *entry;
-    char src_item[MAX_PATH_LENGTH];
-    char dst_item[MAX_PATH_LENGTH];
-    
-    while ((entry = readdir(dir)) != NULL) {
-        if (strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0) {
-            continue;
-        }
-        
-        snprintf(src_item, sizeof(src_item), "%s/%s", src_path, entry->d_name);
-        snprintf(dst_item, sizeof(dst_item), "%s/%s", dst_path, entry->d_name);
-        
-        struct stat file_stat;
-        if (stat(src_item, &file_stat) == 0) {
-            if (S_ISDIR(file_stat.st_mode)) {
-                copy_directory_recursive(src_item, dst_item);
-            } else {
-                // Remove SD_MOUNT_POINT prefix for file_ops_copy_file
-                const char *src_rel = src_item + strlen(SD_MOUNT_POINT);
-                const char *dst_rel = dst_item + strlen(SD_MOUNT_POINT);
-                file_ops_copy_file(src_rel, dst_rel);
-            }
+    char dst_path[MAX_PATH_LENGTH];
+    if (entry->relative[0] == '\0') {
+        snprintf(dst_path, sizeof(dst_path), "%s", ctx->dst_root);
+    } else if (!join_path(dst_path, sizeof(dst_path), ctx->dst_root, entry->relative)) {
+        ctx->failed++;
+        return entry->event == TREE_WALK_ENTER ? TREE_WALK_SKIP : TREE_WALK_CONTINUE;
+    }
+    
+    if (entry->event == TREE_WALK_ENTER) {
+        char full_path[MAX_PATH_LENGTH];
+        snprintf(full_path, sizeof(full_path), "%s%s", SD_MOUNT_POINT, dst_path);
+        if (mkdir(full_path, 0755) == 0) {
+            sd_space_note_dir(true);
+        } else if (errno != EEXIST) {
+            ESP_LOGE(TAG, "Failed to create directory: %s (errno: %d)", dst_path, errno);
+            ctx->failed++;
+            return TREE_WALK_SKIP;
         }
-    }
-    
-    closedir(dir);
-    return ESP_OK;
+    } else if (ctx->batched && copy_batch_fits(entry->size)) {
+        char src_full[MAX_PATH_LENGTH];
+        char dst_full[MAX_PATH_LENGTH];
+        snprintf(src_full, sizeof(src_full), "%s%s", SD_MOUNT_POINT, entry->path);
+        snprintf(dst_full, sizeof(dst_full), "%s%s", SD_MOUNT_POINT, dst_path);
+        // Failures, read or write, are counted by copy_batch_end()
+        copy_batch_add(src_full, dst_full, entry->size);
+    } else if (file_ops_copy_file(entry->path, dst_path) != ESP_OK) {
+        ctx->failed++;
+    }
+    return TREE_WALK_CONTINUE;
 }
 
 esp_err_t file_ops_copy_directory(const char *src_path, const char *dst_path) {
@@ -218,55 +251,174 @@ esp_err_t file_ops_copy_directory(const char *src_path, const char *dst_path) {
         return ESP_ERR_INVALID_STATE;
     }
     
-    char src_full[MAX_PATH_LENGTH];
-    char dst_full[MAX_PATH_LENGTH];
-    snprintf(src_full, sizeof(src_full), "%s%s", SD_MOUNT_POINT, src_path);
-    snprintf(dst_full, sizeof(dst_full), "%s%s", SD_MOUNT_POINT, dst_path);
-    
-    esp_err_t ret = copy_directory_recursive(src_full, dst_full);
+    // Small files are read ahead into batches while a second task writes them out
+    copy_tree_ctx_t ctx = {
+        .dst_root = dst_path,
+        .batched = copy_batch_begin(false) == ESP_OK,
+        .failed = 0
+    };
+    tree_walk_stats_t stats;
+    esp_err_t ret = tree_walk(src_path, copy_tree_cb, &ctx, &stats);
+    if (ctx.batched) {
+        copy_batch_stats_t batch_stats;
+        copy_batch_end(false, &batch_stats);
+        ctx.failed += batch_stats.failed;
+    }
+    if (ret == ESP_OK && ctx.failed > 0) {
+        ret = ESP_FAIL;
+    }
+    listing_cache_invalidate_tree(dst_path);
+    listing_cache_invalidate_parent(dst_path);
+    file_index_note_change(dst_path);
     if (ret == ESP_OK) {
-        ESP_LOGI(TAG, "Directory copied: %s -> %s", src_path, dst_path);
+        ESP_LOGI(TAG, "Directory copied: %s -> %s (%" PRIu32 " files, %" PRIu64 " bytes)",
+                 src_path, dst_path, stats.files, stats.bytes);
     } else {
-        ESP_LOGE(TAG, "Failed to copy directory: %s -> %s", src_path, dst_path);
+        ESP_LOGE(TAG, "Failed to copy directory: %s -> %s (%" PRIu32 " entries failed)",
+                 src_path, dst_path, ctx.failed);
     }
     return ret;
 }
 
-esp_err_t file_ops_copy_to_clipboard(const char *path, bool cut) {
+static bool grow_array(void **array, uint32_t *capacity, uint32_t needed, size_t elem_size) {
+    if (needed <= *capacity) {
+        return true;
+    }
+    uint32_t new_capacity = *capacity ? *capacity * 2 : 16;
+    while (new_capacity < needed) {
+        new_capacity *= 2;
+    }
+    void *grown = realloc(*array, (size_t)new_capacity * elem_size);
+    if (!grown) {
+        return false;
+    }
+    *array = grown;
+    *capacity = new_capacity;
+    return true;
+}
+
+static bool clipboard_intern(const char *str, size_t len, uint32_t *offset) {
+    uint32_t needed = clipboard_arena_used + (uint32_t)len + 1;
+    if (needed > clipboard_arena_size) {
+        uint32_t new_size = clipboard_arena_size ? clipboard_arena_size * 2 : 1024;
+        while (new_size < needed) {
+            new_size *= 2;
+        }
+        char *grown = realloc(clipboard_arena, new_size);
+        if (!grown) {
+            return false;
+        }
+        clipboard_arena = grown;
+        clipboard_arena_size = new_size;
+    }
+    memcpy(clipboard_arena + clipboard_arena_used, str, len);
+    clipboard_arena[clipboard_arena_used + len] = '\0';
+    *offset = clipboard_arena_used;
+    clipboard_arena_used = needed;
+    return true;
+}
+
+// Index of dir in the path table, adding it if needed
+static bool clipboard_intern_dir(const char *dir, size_t len, uint32_t *index) {
+    // Newest first: items almost always arrive grouped by directory
+    for (uint32_t i = clipboard_dir_count; i-- > 0;) {
+        const char *known = clipboard_arena + clipboard_dirs[i];
+        if (strncmp(known, dir, len) == 0 && known[len] == '\0') {
+            *index = i;
+            return true;
+        }
+    }
+
+    uint32_t offset;
+    if (!grow_array((void **)&clipboard_dirs, &clipboard_dir_capacity, clipboard_dir_count + 1,
+                    sizeof(uint32_t)) ||
+        !clipboard_intern(dir, len, &offset)) {
+        return false;
+    }
+    clipboard_dirs[clipboard_dir_count] = offset;
+    *index = clipboard_dir_count++;
+    return true;
+}
+
+static void clipboard_clear(void) {
+    clipboard_arena_used = 0;
+    clipboard_dir_count = 0;
+    clipboard_item_count = 0;
+}
+
+// Writes "<dir>/<name>" for item index into path
+static bool clipboard_item_path(uint32_t index, char *path, size_t size) {
+    const clipboard_item_t *item = &clipboard_items[index];
+    const char *dir = clipboard_arena + clipboard_dirs[item->dir];
+    const char *name = clipboard_arena + item->name;
+    int len = snprintf(path, size, "%s/%s", strcmp(dir, "/") == 0 ? "" : dir, name);
+    return len >= 0 && (size_t)len < size;
+}
+
+esp_err_t file_ops_clipboard_begin(bool cut) {
     if (!sd_manager_is_mounted()) {
         ESP_LOGE(TAG, "SD card not mounted");
         return ESP_ERR_INVALID_STATE;
     }
-    
-    strncpy(clipboard_path, path, sizeof(clipboard_path) - 1);
-    clipboard_path[sizeof(clipboard_path) - 1] = '\0';
+    clipboard_clear();
     clipboard_is_cut = cut;
-    clipboard_has_content = true;
-    
-    ESP_LOGI(TAG, "%s copied to clipboard: %s", cut ? "Cut" : "Copy", path);
     return ESP_OK;
 }
 
-esp_err_t file_ops_paste_from_clipboard(const char *dst_dir) {
-    if (!clipboard_has_content) {
-        ESP_LOGE(TAG, "Clipboard is empty");
-        return ESP_ERR_INVALID_STATE;
+esp_err_t file_ops_clipboard_add(const char *dir, const char *name) {
+    uint32_t dir_index;
+    uint32_t name_offset;
+    if (!grow_array((void **)&clipboard_items, &clipboard_item_capacity, clipboard_item_count + 1,
+                    sizeof(clipboard_item_t)) ||
+        !clipboard_intern_dir(dir, strlen(dir), &dir_index) ||
+        !clipboard_intern(name, strlen(name), &name_offset)) {
+        ESP_LOGE(TAG, "Out of memory adding %s/%s to clipboard", dir, name);
+        return ESP_ERR_NO_MEM;
+    }
+    clipboard_items[clipboard_item_count].dir = dir_index;
+    clipboard_items[clipboard_item_count].name = name_offset;
+    clipboard_item_count++;
+    return ESP_OK;
+}
+
+esp_err_t file_ops_copy_to_clipboard(const char *path, bool cut) {
+    esp_err_t ret = file_ops_clipboard_begin(cut);
+    if (ret != ESP_OK) {
+        return ret;
     }
     
-    if (!sd_manager_is_mounted()) {
-        ESP_LOGE(TAG, "SD card not mounted");
-        return ESP_ERR_INVALID_STATE;
+    const char *slash = strrchr(path, '/');
+    if (!slash) {
+        ret = file_ops_clipboard_add("/", path);
+    } else if (slash == path) {
+        ret = file_ops_clipboard_add("/", slash + 1);
+    } else {
+        char dir[MAX_PATH_LENGTH];
+        size_t dir_len = slash - path;
+        if (dir_len >= sizeof(dir)) {
+            ESP_LOGE(TAG, "Path too long: %s", path);
+            return ESP_ERR_INVALID_ARG;
+        }
+        memcpy(dir, path, dir_len);
+        dir[dir_len] = '\0';
+        ret = file_ops_clipboard_add(dir, slash + 1);
     }
     
-    // Extract filename from clipboard path
-    const char *filename = strrchr(clipboard_path, '/');
-    if (!filename) {
-        filename = clipboard_path;
-    } else {
-        filename++; // Skip the '/'
+    if (ret == ESP_OK) {
+        ESP_LOGI(TAG, "%s copied to clipboard: %s", cut ? "Cut" : "Copy", path);
+    }
+    return ret;
+}
+
+static esp_err_t paste_item(uint32_t index, const char *dst_dir) {
+    char src_path[MAX_PATH_LENGTH];
+    if (!clipboard_item_path(index, src_path, sizeof(src_path))) {
+        ESP_LOGE(TAG, "Source path too long");
+        return ESP_FAIL;
     }
     
     // Create destination path - ensure no overflow
+    const char *filename = clipboard_arena + clipboard_items[index].name;
     char dst_path[MAX_PATH_LENGTH];
     size_t dst_dir_len = strlen(dst_dir);
     size_t filename_len = strlen(filename);
@@ -277,51 +429,95 @@ esp_err_t file_ops_paste_from_clipboard(const char *dst_dir) {
     // Suppress format-truncation warning as we've already checked the lengths
     #pragma GCC diagnostic push
     #pragma GCC diagnostic ignored "-Wformat-truncation"
-    snprintf(dst_path, sizeof(dst_path), "%s/%s", dst_dir, filename);
+    snprintf(dst_path, sizeof(dst_path), "%s/%s", strcmp(dst_dir, "/") == 0 ? "" : dst_dir, filename);
     #pragma GCC diagnostic pop
     
     // Check if source is a directory - ensure no overflow
     char src_full[MAX_PATH_LENGTH];
-    size_t mount_len = strlen(SD_MOUNT_POINT);
-    size_t clipboard_len = strlen(clipboard_path);
-    if (mount_len + clipboard_len + 1 >= MAX_PATH_LENGTH) {
+    if (strlen(SD_MOUNT_POINT) + strlen(src_path) + 1 >= MAX_PATH_LENGTH) {
         ESP_LOGE(TAG, "Source path too long");
         return ESP_FAIL;
     }
-    snprintf(src_full, sizeof(src_full), "%s%s", SD_MOUNT_POINT, clipboard_path);
+    snprintf(src_full, sizeof(src_full), "%s%s", SD_MOUNT_POINT, src_path);
     
     struct stat file_stat;
     if (stat(src_full, &file_stat) != 0) {
-        ESP_LOGE(TAG, "Source file/directory not found: %s", clipboard_path);
+        ESP_LOGE(TAG, "Source file/directory not found: %s", src_path);
         return ESP_FAIL;
     }
     
     esp_err_t ret;
     if (S_ISDIR(file_stat.st_mode)) {
-        ret = file_ops_copy_directory(clipboard_path, dst_path);
+        ret = file_ops_copy_directory(src_path, dst_path);
     } else {
-        ret = file_ops_copy_file(clipboard_path, dst_path);
+        ret = file_ops_copy_file(src_path, dst_path);
     }
     
     if (ret == ESP_OK && clipboard_is_cut) {
         // Delete source after successful copy
         if (S_ISDIR(file_stat.st_mode)) {
-            file_ops_delete_directory(clipboard_path);
+            file_ops_delete_directory(src_path);
         } else {
-            file_ops_delete_file(clipboard_path);
+            file_ops_delete_file(src_path);
         }
-        clipboard_has_content = false;
     }
-    
     return ret;
 }
 
+esp_err_t file_ops_paste_from_clipboard(const char *dst_dir) {
+    if (clipboard_item_count == 0) {
+        ESP_LOGE(TAG, "Clipboard is empty");
+        return ESP_ERR_INVALID_STATE;
+    }
+    
+    if (!sd_manager_is_mounted()) {
+        ESP_LOGE(TAG, "SD card not mounted");
+        return ESP_ERR_INVALID_STATE;
+    }
+    
+    // A cut keeps only the items that failed, so a retry does not redo the rest
+    uint32_t total = clipboard_item_count;
+    uint32_t kept = 0;
+    uint32_t failed = 0;
+    for (uint32_t i = 0; i < total; i++) {
+        if (paste_item(i, dst_dir) != ESP_OK) {
+            failed++;
+            if (clipboard_is_cut) {
+                clipboard_items[kept++] = clipboard_items[i];
+            }
+        }
+    }
+    if (clipboard_is_cut) {
+        clipboard_item_count = kept;
+        if (kept == 0) {
+            clipboard_clear();
+        }
+    }
+    
+    if (failed > 0) {
+        ESP_LOGE(TAG, "Paste into %s: %" PRIu32 " of %" PRIu32 " items failed", dst_dir, failed, total);
+        return ESP_FAIL;
+    }
+    return ESP_OK;
+}
+
 bool file_ops_clipboard_has_content(void) {
-    return clipboard_has_content;
+    return clipboard_item_count > 0;
+}
+
+bool file_ops_clipboard_is_cut(void) {
+    return clipboard_is_cut;
 }
 
-const char* file_ops_get_clipboard_path(void) {
-    return clipboard_has_content ? clipboard_path : NULL;
+uint32_t file_ops_clipboard_count(void) {
+    return clipboard_item_count;
+}
+
+esp_err_t file_ops_get_clipboard_path(uint32_t index, char *path, size_t size) {
+    if (index >= clipboard_item_count) {
+        return ESP_ERR_NOT_FOUND;
+    }
+    return clipboard_item_path(index, path, size) ? ESP_OK : ESP_ERR_INVALID_SIZE;
 }
 
 esp_err_t file_ops_get_file_info(const char *path, file_info_t *info) {
@@ -351,29 +547,36 @@ esp_err_t file_ops_get_file_info(const char *path, file_info_t *info) {
     info->is_directory = S_ISDIR(file_stat.st_mode);
     info->modified_time = file_stat.st_mtime;
     
-    // Determine file type by extension
-    const char *ext = strrchr(filename, '.');
-    if (!ext || info->is_directory) {
-        info->type = info->is_directory ? FILE_TYPE_DIRECTORY : FILE_TYPE_OTHER;
-    } else {
-        ext++; // Skip the dot
-        if (strcasecmp(ext, "bin") == 0) {
-            info->type = FILE_TYPE_BINARY;
-        } else if (strcasecmp(ext, "txt") == 0 || strcasecmp(ext, "cfg") == 0 || 
-                   strcasecmp(ext, "conf") == 0 || strcasecmp(ext, "json") == 0) {
-            info->type = FILE_TYPE_TEXT;
-        } else if (strcasecmp(ext, "py") == 0) {
-            info->type = FILE_TYPE_PYTHON;
-        } else if (strcasecmp(ext, "html") == 0 || strcasecmp(ext, "css") == 0 || 
-                   strcasecmp(ext, "js") == 0) {
-            info->type = FILE_TYPE_WEB;
-        } else if (strcasecmp(ext, "jpg") == 0 || strcasecmp(ext, "jpeg") == 0 || 
-                   strcasecmp(ext, "png") == 0 || strcasecmp(ext, "bmp") == 0) {
-            info->type = FILE_TYPE_IMAGE;
-        } else {
-            info->type = FILE_TYPE_OTHER;
-        }
-    }
+    info->type = file_ops_get_file_type(filename, info->is_directory);
     
     return ESP_OK;
+}
+
+file_type_t file_ops_get_file_type(const char *name, bool is_directory) {
+    if (is_directory) {
+        return FILE_TYPE_DIRECTORY;
+    }
+
+    // Determine file type by extension
+    const char *ext = strrchr(name, '.');
+    if (!ext) {
+        return FILE_TYPE_OTHER;
+    }
+    ext++; // Skip the dot
+
+    if (strcasecmp(ext, "bin") == 0) {
+        return FILE_TYPE_BINARY;
+    } else if (strcasecmp(ext, "txt") == 0 || strcasecmp(ext, "cfg") == 0 || 
+               strcasecmp(ext, "conf") == 0 || strcasecmp(ext, "json") == 0) {
+        return FILE_TYPE_TEXT;
+    } else if (strcasecmp(ext, "py") == 0) {
+        return FILE_TYPE_PYTHON;
+    } else if (strcasecmp(ext, "html") == 0 || strcasecmp(ext, "css") == 0 || 
+               strcasecmp(ext, "js") == 0) {
+        return FILE_TYPE_WEB;
+    } else if (strcasecmp(ext, "jpg") == 0 || strcasecmp(ext, "jpeg") == 0 || 
+               strcasecmp(ext, "png") == 0 || strcasecmp(ext, "bmp") == 0) {
+        return FILE_TYPE_IMAGE;
+    }
+    return FILE_TYPE_OTHER;
 }
\ No newline at end of file
@@ -4,6 +4,7 @@
 #include "esp_err.h"
 #include <stdbool.h>
 #include <stddef.h>
+#include <stdint.h>
 #include <time.h>
 
 // File type enumeration for icon display
@@ -71,6 +72,21 @@ esp_err_t file_ops_copy_file(const char *src_path, const char *dst_path);
  */
 esp_err_t file_ops_copy_directory(const char *src_path, const char *dst_path);
 
+/**
+ * @brief Empty the clipboard and start a new copy or cut
+ * @param cut If true, sources are deleted after a successful paste
+ * @return ESP_OK on success, ESP_ERR_INVALID_STATE if no card is mounted
+ */
+esp_err_t file_ops_clipboard_begin(bool cut);
+
+/**
+ * @brief Add an entry to the clipboard started by file_ops_clipboard_begin()
+ * @param dir Directory holding the entry (relative to SD root)
+ * @param name Entry name within dir
+ * @return ESP_OK on success, ESP_ERR_NO_MEM on allocation failure
+ */
+esp_err_t file_ops_clipboard_add(const char *dir, const char *name);
+
 /**
  * @brief Copy file/directory path to clipboard for later paste
  * @param path File/directory path (relative to SD root)
@@ -80,9 +96,12 @@ esp_err_t file_ops_copy_directory(const char *src_path, const char *dst_path);
 esp_err_t file_ops_copy_to_clipboard(const char *path, bool cut);
 
 /**
- * @brief Paste file/directory from clipboard to destination
+ * @brief Paste every clipboard entry into a directory
+ *
+ * After a cut, entries that were moved leave the clipboard and failed ones stay.
+ *
  * @param dst_dir Destination directory path (relative to SD root)
- * @return ESP_OK on success
+ * @return ESP_OK if every entry was pasted, ESP_FAIL if any failed
  */
 esp_err_t file_ops_paste_from_clipboard(const char *dst_dir);
 
@@ -93,10 +112,26 @@ esp_err_t file_ops_paste_from_clipboard(const char *dst_dir);
 bool file_ops_clipboard_has_content(void);
 
 /**
- * @brief Get current clipboard path
- * @return Path in clipboard or NULL if empty
+ * @brief Check whether the clipboard holds a cut rather than a copy
+ * @return true if pasting should move the entries
+ */
+bool file_ops_clipboard_is_cut(void);
+
+/**
+ * @brief Get the number of entries in the clipboard
+ * @return Entry count
+ */
+uint32_t file_ops_clipboard_count(void);
+
+/**
+ * @brief Get the full path of a clipboard entry
+ * @param index Entry index
+ * @param path Output buffer
+ * @param size Size of path
+ * @return ESP_OK on success, ESP_ERR_NOT_FOUND if index is out of range,
+ *         ESP_ERR_INVALID_SIZE if path is too small
  */
-const char* file_ops_get_clipboard_path(void);
+esp_err_t file_ops_get_clipboard_path(uint32_t index, char *path, size_t size);
 
 /**
  * @brief Get detailed file information
@@ -106,4 +141,12 @@ const char* file_ops_get_clipboard_path(void);
  */
 esp_err_t file_ops_get_file_info(const char *path, file_info_t *info);
 
+/**
+ * @brief Classify a file by its extension
+ * @param name File name
+ * @param is_directory true if the entry is a directory
+ * @return File type
+ */
+file_type_t file_ops_get_file_type(const char *name, bool is_directory);
+
 #endif // FILE_OPERATIONS_H
\ No newline at end of file
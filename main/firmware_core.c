@@ -1,5 +1,6 @@
 #include "firmware_loader.h"
 #include "sd_manager.h"
+#include "sd_stream.h"
 #include "esp_log.h"
 #include "esp_ota_ops.h"
 #include "esp_partition.h"
@@ -153,31 +154,43 @@ esp_err_t firmware_loader_flash_from_sd_with_progress(const char *firmware_path,
         return ret;
     }
 
-    // Position file pointer to start of actual firmware (skip padding)
-    fseek(file, firmware_offset, SEEK_SET);
+    fclose(file);
+
+    // Stream from the start of the actual firmware (skip padding); read-ahead overlaps the flash writes
+    sd_stream_config_t stream_config = SD_STREAM_CONFIG_DEFAULT();
+    stream_config.offset = firmware_offset;
+    sd_stream_t *stream;
+    ret = sd_stream_open(firmware_path, SD_STREAM_READ, &stream_config, &stream);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to reopen firmware file: %s", esp_err_to_name(ret));
+        return ret;
+    }
 
     if (progress_callback) progress_callback(0, actual_firmware_size, "Writing firmware (direct)...");
 
     // Write firmware directly to partition, bypassing OTA validation
-    uint8_t buffer[BUFFER_SIZE];
     size_t bytes_written = 0;
     size_t partition_offset = 0;
 
     while (bytes_written < actual_firmware_size) {
-        size_t bytes_to_read = (actual_firmware_size - bytes_written > BUFFER_SIZE) ? BUFFER_SIZE : (actual_firmware_size - bytes_written);
-        size_t bytes_read = fread(buffer, 1, bytes_to_read, file);
-
-        if (bytes_read == 0) {
+        const uint8_t *data;
+        size_t bytes_read;
+        ret = sd_stream_borrow(stream, &data, &bytes_read);
+        if (ret != ESP_OK || bytes_read == 0) {
             ESP_LOGE(TAG, "Failed to read from file at offset %zu", firmware_offset + bytes_written);
-            fclose(file);
+            sd_stream_close(stream);
             return ESP_ERR_INVALID_STATE;
         }
+        if (bytes_read > actual_firmware_size - bytes_written) {
+            bytes_read = actual_firmware_size - bytes_written;
+        }
 
         // Write directly to partition, bypassing OTA API validation
-        ret = esp_partition_write(update_partition, partition_offset, buffer, bytes_read);
+        ret = esp_partition_write(update_partition, partition_offset, data, bytes_read);
+        sd_stream_release(stream);
         if (ret != ESP_OK) {
             ESP_LOGE(TAG, "esp_partition_write failed at offset %zu: %s", partition_offset, esp_err_to_name(ret));
-            fclose(file);
+            sd_stream_close(stream);
             return ret;
         }
 
@@ -189,7 +202,7 @@ esp_err_t firmware_loader_flash_from_sd_with_progress(const char *firmware_path,
         }
     }
 
-    fclose(file);
+    sd_stream_close(stream);
 
     if (progress_callback) progress_callback(actual_firmware_size, actual_firmware_size, "Verifying...");
 
@@ -337,8 +350,8 @@ esp_err_t firmware_loader_export_to_sd(const char *output_path) {
     }
 
     // Open output file on SD card
-    FILE *output_file = sd_manager_open_file(output_path, "wb");
-    if (!output_file) {
+    sd_stream_t *output_stream;
+    if (sd_stream_open(output_path, SD_STREAM_WRITE, NULL, &output_stream) != ESP_OK) {
         ESP_LOGE(TAG, "Failed to create output file: %s", output_path);
         return ESP_ERR_INVALID_STATE;
     }
@@ -357,7 +370,7 @@ esp_err_t firmware_loader_export_to_sd(const char *output_path) {
         esp_err_t ret = esp_partition_read(ota_partition, partition_offset, buffer, bytes_to_read);
         if (ret != ESP_OK) {
             ESP_LOGE(TAG, "Failed to read from partition at offset %zu: %s", partition_offset, esp_err_to_name(ret));
-            fclose(output_file);
+            sd_stream_close(output_stream);
             return ret;
         }
 
@@ -376,19 +389,22 @@ esp_err_t firmware_loader_export_to_sd(const char *output_path) {
         }
 
         if (!is_empty) {
-            size_t bytes_written = fwrite(buffer, 1, bytes_to_read, output_file);
-            if (bytes_written != bytes_to_read) {
+            // Buffered write-behind: the card write overlaps the next partition read
+            if (sd_stream_write(output_stream, buffer, bytes_to_read) != ESP_OK) {
                 ESP_LOGE(TAG, "Failed to write to output file");
-                fclose(output_file);
+                sd_stream_close(output_stream);
                 return ESP_ERR_INVALID_STATE;
             }
-            bytes_exported += bytes_written;
+            bytes_exported += bytes_to_read;
         }
 
         partition_offset += bytes_to_read;
     }
 
-    fclose(output_file);
+    if (sd_stream_close(output_stream) != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to finish output file");
+        return ESP_ERR_INVALID_STATE;
+    }
 
     ESP_LOGI(TAG, "✓ Firmware exported successfully (%zu bytes)", bytes_exported);
     return ESP_OK;
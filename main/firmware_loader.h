@@ -93,4 +93,17 @@ esp_err_t firmware_loader_unload_firmware(void);
  */
 esp_err_t firmware_loader_get_firmware_info(esp_app_desc_t *app_desc);
 
+/**
+ * @brief Copy the firmware in the OTA partition to a file on the SD card
+ * @param output_path Path of the file to write (relative to SD root)
+ * @return ESP_OK on success, error code otherwise
+ */
+esp_err_t firmware_loader_export_to_sd(const char *output_path);
+
+/**
+ * @brief Erase the OTA partition and boot flags after a failed or corrupted flash
+ * @return ESP_OK on success, error code otherwise
+ */
+esp_err_t firmware_loader_clean_partition(void);
+
 #endif // FIRMWARE_LOADER_H
\ No newline at end of file
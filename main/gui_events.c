@@ -3,6 +3,7 @@
 #include "gui_progress.h"
 #include "gui_state.h"
 #include "gui_file_browser_v2.h"
+#include "gui_virtual_list.h"
 #include "gui_screen_settings.h"
 #include "gui_screen_tools.h"
 #include "gui_screen_text_editor.h"
@@ -11,10 +12,14 @@
 #include "firmware_loader.h"
 #include "sd_manager.h"
 #include "file_operations.h"
+#include "file_jobs.h"
+#include "config_manager.h"
+#include "gui_job_panel.h"
 #include "esp_log.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include <string.h>
+#include <inttypes.h>
 #include <stdlib.h>
 #include <sys/stat.h>
 #include <time.h>
@@ -41,9 +46,19 @@ static void file_open_choice_handler(lv_event_t *e);
 typedef struct {
     lv_obj_t *msgbox;
     lv_obj_t *textarea;
-    int file_index;
+    uint32_t file_index;
 } rename_context_t;
 
+// Entry last toggled by a checkbox; a long press on a row selects from here
+static uint32_t selection_anchor = 0;
+
+// Full path (relative to SD root) of a current_listing entry
+static bool current_entry_path(uint32_t index, char *path, size_t size) {
+    int len = snprintf(path, size, "%s/%s", strcmp(current_directory, "/") == 0 ? "" : current_directory,
+                       file_listing_name(&current_listing, index));
+    return len >= 0 && (size_t)len < size;
+}
+
 
 // Format functionality temporarily removed
 
@@ -198,27 +213,43 @@ void main_menu_event_handler(lv_event_t *e) {
 
 void file_list_event_handler(lv_event_t *e) {
     lv_event_code_t code = lv_event_get_code(e);
-    if (code == LV_EVENT_CLICKED) {
-        int index = (int)(uintptr_t)lv_event_get_user_data(e);
+    if (code == LV_EVENT_LONG_PRESSED) {
+        if (!file_selection_enabled) return;
+        
+        uint32_t index = gui_virtual_list_get_index(lv_event_get_current_target(e));
+        if (index < current_listing.count) {
+            // Select everything between the last toggled entry and this one
+            selection_set_set_range(&selected_files, selection_anchor, index, true);
+            selection_anchor = index;
+            ESP_LOGI(TAG, "Range selected up to %" PRIu32 ". Total selected: %" PRIu32,
+                     index, selection_set_count(&selected_files));
+            // The release that follows must not open the entry
+            lv_indev_wait_release(lv_indev_active());
+            refresh_file_list_rows();
+        }
+    } else if (code == LV_EVENT_CLICKED) {
+        // Rows are recycled, so the index comes from the row's current binding
+        uint32_t index = gui_virtual_list_get_index(lv_event_get_current_target(e));
 
-        if (index >= 0 && index < current_entry_count) {
-            if (current_entries[index].is_directory) {
+        if (index < current_listing.count) {
+            const char *entry_name = file_listing_name(&current_listing, index);
+            if (file_listing_is_dir(&current_listing, index)) {
                 // Navigate to directory
                 char temp_path[512];
                 size_t dir_len = strlen(current_directory);
-                size_t name_len = strlen(current_entries[index].name);
+                size_t name_len = strlen(entry_name);
 
                 // Check if the combined path would fit
                 if (dir_len + name_len + 2 < sizeof(temp_path)) {
                     if (strcmp(current_directory, "/") == 0) {  // Changed from "/sdcard" to "/"
                         // SD card root case: "/<dirname>"
                         strcpy(temp_path, current_directory);
-                        strcat(temp_path, current_entries[index].name);
+                        strcat(temp_path, entry_name);
                     } else {
                         // Non-root directory case: "<directory>/<dirname>"
                         strcpy(temp_path, current_directory);
                         strcat(temp_path, "/");
-                        strcat(temp_path, current_entries[index].name);
+                        strcat(temp_path, entry_name);
                     }
 
                     // Check if the path fits in current_directory
@@ -235,17 +266,17 @@ void file_list_event_handler(lv_event_t *e) {
                 }
             } else {
                 // Check if it's a supported file and determine available options
-                bool can_edit = text_editor_is_supported_file(current_entries[index].name);
-                bool can_run_python = python_launcher_is_supported_file(current_entries[index].name);
+                bool can_edit = text_editor_is_supported_file(entry_name);
+                bool can_run_python = python_launcher_is_supported_file(entry_name);
 
                 if (can_edit && can_run_python) {
                     // File can be opened in both text editor and Python launcher - show choice dialog
                     char full_path[1024];
                     if (strcmp(current_directory, "/") == 0) {
-                        snprintf(full_path, sizeof(full_path), "/%s", current_entries[index].name);
+                        snprintf(full_path, sizeof(full_path), "/%s", entry_name);
                     } else {
                         snprintf(full_path, sizeof(full_path), "%s/%s",
-                                current_directory, current_entries[index].name);
+                                current_directory, entry_name);
                     }
 
                     // Create choice dialog
@@ -260,7 +291,7 @@ void file_list_event_handler(lv_event_t *e) {
                     // Message
                     lv_obj_t *msg_text = lv_label_create(msgbox);
                     char msg[128];
-                    snprintf(msg, sizeof(msg), "How would you like to open\n%s?", current_entries[index].name);
+                    snprintf(msg, sizeof(msg), "How would you like to open\n%s?", entry_name);
                     lv_label_set_text(msg_text, msg);
                     lv_obj_set_style_text_align(msg_text, LV_TEXT_ALIGN_CENTER, 0);
                     lv_obj_align(msg_text, LV_ALIGN_CENTER, 0, -10);
@@ -303,10 +334,10 @@ void file_list_event_handler(lv_event_t *e) {
                     // Only text editor available
                     char full_path[1024];
                     if (strcmp(current_directory, "/") == 0) {
-                        snprintf(full_path, sizeof(full_path), "/%s", current_entries[index].name);
+                        snprintf(full_path, sizeof(full_path), "/%s", entry_name);
                     } else {
                         snprintf(full_path, sizeof(full_path), "%s/%s",
-                                current_directory, current_entries[index].name);
+                                current_directory, entry_name);
                     }
 
                     ESP_LOGI(TAG, "Opening text file in editor: %s", full_path);
@@ -319,10 +350,10 @@ void file_list_event_handler(lv_event_t *e) {
                     }
                 } else if (can_run_python) {
                     // Only Python launcher available
-                    ESP_LOGI(TAG, "Opening Python file in launcher: %s", current_entries[index].name);
+                    ESP_LOGI(TAG, "Opening Python file in launcher: %s", entry_name);
                     show_python_launcher_screen();
                 } else {
-                    ESP_LOGI(TAG, "File type not supported: %s", current_entries[index].name);
+                    ESP_LOGI(TAG, "File type not supported: %s", entry_name);
                 }
             }
         }
@@ -659,11 +690,9 @@ void file_browser_v2_item_click_handler(lv_event_t *e) {
     lv_event_code_t code = lv_event_get_code(e);
     if (code != LV_EVENT_CLICKED) return;
     
-    int file_index = (int)(intptr_t)lv_event_get_user_data(e);
+    int file_index = (int)gui_virtual_list_get_index(lv_event_get_current_target(e));
     ESP_LOGI(TAG, "File browser v2: Item %d clicked", file_index);
-    
-    // TODO: Handle file/directory selection and navigation
-    // This will be implemented when we integrate with the existing file navigation
+    gui_file_browser_v2_activate_item((uint32_t)file_index);
 }
 
 void file_browser_v2_multi_select_handler(lv_event_t *e) {
@@ -679,10 +708,8 @@ void file_browser_v2_multi_select_handler(lv_event_t *e) {
 
 // Helper function to clear file selections
 static void clear_file_selections(void) {
-    for (int i = 0; i < 32; i++) {
-        selected_files[i] = false;
-    }
-    selected_file_count = 0;
+    selection_set_clear(&selected_files);
+    selection_anchor = 0;
 }
 
 void directory_up_event_handler(lv_event_t *e) {
@@ -727,31 +754,47 @@ void file_selection_event_handler(lv_event_t *e) {
     lv_event_code_t code = lv_event_get_code(e);
     if (code != LV_EVENT_VALUE_CHANGED) return;
     
-    int file_index = (int)(uintptr_t)lv_event_get_user_data(e);
     lv_obj_t *checkbox = lv_event_get_target(e);
+    uint32_t file_index = gui_virtual_list_get_index(checkbox);
     bool is_checked = lv_obj_has_state(checkbox, LV_STATE_CHECKED);
     
-    if (file_index >= 0 && file_index < current_entry_count) {
+    if (file_index < current_listing.count) {
         // Update selection state
-        bool was_selected = selected_files[file_index];
-        selected_files[file_index] = is_checked;
+        selection_set_set(&selected_files, file_index, is_checked);
+        selection_anchor = file_index;
         
-        // Update selection count
-        if (is_checked && !was_selected) {
-            selected_file_count++;
-        } else if (!is_checked && was_selected) {
-            selected_file_count--;
-        }
-        
-        ESP_LOGI(TAG, "File %d (%s) %s. Total selected: %d", 
-                 file_index, current_entries[file_index].name,
-                 is_checked ? "selected" : "deselected", selected_file_count);
+        ESP_LOGI(TAG, "File %" PRIu32 " (%s) %s. Total selected: %" PRIu32,
+                 file_index, file_listing_name(&current_listing, file_index),
+                 is_checked ? "selected" : "deselected", selection_set_count(&selected_files));
         
-        // Refresh the file list to update visual highlighting
-        update_file_list();
+        // Rebind the visible rows to update highlighting
+        refresh_file_list_rows();
     }
 }
 
+void select_all_event_handler(lv_event_t *e) {
+    lv_event_code_t code = lv_event_get_code(e);
+    if (!file_selection_enabled) return;
+    
+    if (code == LV_EVENT_LONG_PRESSED) {
+        selection_set_invert(&selected_files);
+        // Do not follow the invert with a click
+        lv_indev_wait_release(lv_indev_active());
+    } else if (code == LV_EVENT_CLICKED) {
+        // Toggles between everything and nothing
+        if (selection_set_count(&selected_files) == selected_files.size) {
+            selection_set_clear(&selected_files);
+        } else {
+            selection_set_select_all(&selected_files);
+        }
+    } else {
+        return;
+    }
+    
+    ESP_LOGI(TAG, "Total selected: %" PRIu32, selection_set_count(&selected_files));
+    refresh_file_list_rows();
+}
+
 void toggle_selection_mode_event_handler(lv_event_t *e) {
     lv_event_code_t code = lv_event_get_code(e);
     if (code != LV_EVENT_CLICKED) return;
@@ -777,8 +820,8 @@ void toggle_selection_mode_event_handler(lv_event_t *e) {
         }
     }
     
-    // Refresh the file list to show/hide checkboxes
-    update_file_list();
+    // Rebind the visible rows to show/hide checkboxes
+    refresh_file_list_rows();
 }
 
 // File operation event handlers
@@ -786,7 +829,8 @@ void delete_files_event_handler(lv_event_t *e) {
     lv_event_code_t code = lv_event_get_code(e);
     if (code != LV_EVENT_CLICKED) return;
     
-    if (selected_file_count == 0) {
+    uint32_t selected_count = selection_set_count(&selected_files);
+    if (selected_count == 0) {
         ESP_LOGW(TAG, "No files selected for deletion");
         return;
     }
@@ -797,19 +841,11 @@ void delete_files_event_handler(lv_event_t *e) {
     // Create message text
     lv_obj_t *msg_text = lv_label_create(msgbox);
     char msg[256];
-    if (selected_file_count == 1) {
-        // Find the selected file
-        int selected_idx = -1;
-        for (int i = 0; i < current_entry_count; i++) {
-            if (selected_files[i]) {
-                selected_idx = i;
-                break;
-            }
-        }
-        snprintf(msg, sizeof(msg), "Delete '%s'?", 
-                 selected_idx >= 0 ? current_entries[selected_idx].name : "file");
+    if (selected_count == 1) {
+        uint32_t selected_idx = selection_set_next(&selected_files, 0);
+        snprintf(msg, sizeof(msg), "Delete '%s'?", file_listing_name(&current_listing, selected_idx));
     } else {
-        snprintf(msg, sizeof(msg), "Delete %d selected items?", selected_file_count);
+        snprintf(msg, sizeof(msg), "Delete %" PRIu32 " selected items?", selected_count);
     }
     lv_label_set_text(msg_text, msg);
     lv_obj_center(msg_text);
@@ -840,37 +876,27 @@ void delete_files_event_handler(lv_event_t *e) {
 static void delete_confirmation_handler(lv_event_t *e) {
     lv_obj_t *msgbox = (lv_obj_t*)lv_event_get_user_data(e);
     
-    ESP_LOGI(TAG, "Deleting %d selected files", selected_file_count);
-    
-    int deleted_count = 0;
-    int failed_count = 0;
-    
-    // Delete each selected file
-    for (int i = 0; i < current_entry_count; i++) {
-        if (selected_files[i]) {
-            char full_path[3072];  // Large buffer to satisfy compiler warnings
-            if (strcmp(current_directory, "/") == 0) {
-                snprintf(full_path, sizeof(full_path), "/%s", current_entries[i].name);
-            } else {
-                snprintf(full_path, sizeof(full_path), "%s/%s", 
-                        current_directory, current_entries[i].name);
-            }
-            
-            esp_err_t ret;
-            if (current_entries[i].is_directory) {
-                ret = file_ops_delete_directory(full_path);
-            } else {
-                ret = file_ops_delete_file(full_path);
-            }
-            
-            if (ret == ESP_OK) {
-                deleted_count++;
-                ESP_LOGI(TAG, "Deleted: %s", full_path);
-            } else {
-                failed_count++;
-                ESP_LOGE(TAG, "Failed to delete: %s", full_path);
-            }
+    ESP_LOGI(TAG, "Deleting %" PRIu32 " selected files", selection_set_count(&selected_files));
+    
+    // The deletion runs as a background job; the list refreshes when it ends
+    file_job_t *job = file_job_create(FILE_JOB_DELETE, NULL, FILE_JOB_CONFLICT_SKIP);
+    esp_err_t ret = job ? ESP_OK : ESP_ERR_NO_MEM;
+    for (uint32_t i = selection_set_next(&selected_files, 0); ret == ESP_OK && i != UINT32_MAX;
+         i = selection_set_next(&selected_files, i + 1)) {
+        char path[FILE_JOBS_PATH_LEN];
+        if (!current_entry_path(i, path, sizeof(path))) {
+            ESP_LOGE(TAG, "Path too long: %s", file_listing_name(&current_listing, i));
+            continue;
         }
+        ret = file_job_add(job, path);
+    }
+    
+    if (ret == ESP_OK) {
+        uint32_t id = file_jobs_submit(job);
+        ESP_LOGI(TAG, "Deletion queued as job %" PRIu32, id);
+    } else {
+        ESP_LOGE(TAG, "Failed to queue deletion: %s", esp_err_to_name(ret));
+        file_job_discard(job);
     }
     
     // Close dialog
@@ -880,10 +906,8 @@ static void delete_confirmation_handler(lv_event_t *e) {
     clear_file_selections();
     file_selection_enabled = false;
     
-    // Refresh file list
+    // Refresh to update button states
     update_file_list();
-    
-    ESP_LOGI(TAG, "Deletion complete. Deleted: %d, Failed: %d", deleted_count, failed_count);
 }
 
 static void delete_cancel_handler(lv_event_t *e) {
@@ -892,41 +916,25 @@ static void delete_cancel_handler(lv_event_t *e) {
     ESP_LOGI(TAG, "Deletion cancelled");
 }
 
-void copy_files_event_handler(lv_event_t *e) {
-    lv_event_code_t code = lv_event_get_code(e);
-    if (code != LV_EVENT_CLICKED) return;
-    
-    if (selected_file_count == 0) {
-        ESP_LOGW(TAG, "No files selected for copy");
+// Put every selected entry on the clipboard, then leave selection mode
+static void clipboard_selected_files(bool cut) {
+    if (selection_set_count(&selected_files) == 0) {
+        ESP_LOGW(TAG, "No files selected for %s", cut ? "move" : "copy");
         return;
     }
     
-    // For now, only support single file copy (file_operations module limitation)
-    // Find first selected file
-    int selected_idx = -1;
-    for (int i = 0; i < current_entry_count; i++) {
-        if (selected_files[i]) {
-            selected_idx = i;
-            break;
-        }
+    // Entries are stored as names against one interned copy of current_directory
+    esp_err_t ret = file_ops_clipboard_begin(cut);
+    for (uint32_t i = selection_set_next(&selected_files, 0); ret == ESP_OK && i != UINT32_MAX;
+         i = selection_set_next(&selected_files, i + 1)) {
+        ret = file_ops_clipboard_add(current_directory, file_listing_name(&current_listing, i));
     }
-    
-    if (selected_idx >= 0) {
-        char full_path[3072];  // Large buffer to satisfy compiler warnings
-        if (strcmp(current_directory, "/") == 0) {
-            snprintf(full_path, sizeof(full_path), "/%s", current_entries[selected_idx].name);
-        } else {
-            snprintf(full_path, sizeof(full_path), "%s/%s", 
-                    current_directory, current_entries[selected_idx].name);
-        }
-        
-        // Copy to clipboard
-        esp_err_t ret = file_ops_copy_to_clipboard(full_path, false);
-        if (ret == ESP_OK) {
-            ESP_LOGI(TAG, "Copied to clipboard: %s", full_path);
-        } else {
-            ESP_LOGE(TAG, "Failed to copy to clipboard: %s", full_path);
-        }
+    if (ret == ESP_OK) {
+        ESP_LOGI(TAG, "%s %" PRIu32 " items from %s", cut ? "Prepared for move:" : "Copied to clipboard:",
+                 file_ops_clipboard_count(), current_directory);
+    } else {
+        ESP_LOGE(TAG, "Failed to %s selection: %s", cut ? "cut" : "copy", esp_err_to_name(ret));
+        file_ops_clipboard_begin(cut);
     }
     
     // Clear selections and exit selection mode
@@ -937,94 +945,141 @@ void copy_files_event_handler(lv_event_t *e) {
     update_file_list();
 }
 
+void copy_files_event_handler(lv_event_t *e) {
+    lv_event_code_t code = lv_event_get_code(e);
+    if (code != LV_EVENT_CLICKED) return;
+    
+    clipboard_selected_files(false);
+}
+
 void move_files_event_handler(lv_event_t *e) {
     lv_event_code_t code = lv_event_get_code(e);
     if (code != LV_EVENT_CLICKED) return;
     
-    if (selected_file_count == 0) {
-        ESP_LOGW(TAG, "No files selected for move");
+    clipboard_selected_files(true);
+}
+
+// Queue the clipboard as a copy or move job into the current directory
+static void paste_clipboard(file_job_conflict_t conflict) {
+    if (!file_ops_clipboard_has_content()) {
+        ESP_LOGW(TAG, "No files in clipboard");
         return;
     }
     
-    // For now, only support single file move (file_operations module limitation)
-    // Find first selected file
-    int selected_idx = -1;
-    for (int i = 0; i < current_entry_count; i++) {
-        if (selected_files[i]) {
-            selected_idx = i;
-            break;
+    bool cut = file_ops_clipboard_is_cut();
+    file_job_t *job = file_job_create(cut ? FILE_JOB_MOVE : FILE_JOB_COPY, current_directory, conflict);
+    esp_err_t ret = job ? ESP_OK : ESP_ERR_NO_MEM;
+    launcher_config_t *config = config_manager_get_current();
+    if (job && config) {
+        file_job_set_verify(job, config->file_browser.verify_copies);
+    }
+    uint32_t count = file_ops_clipboard_count();
+    for (uint32_t i = 0; ret == ESP_OK && i < count; i++) {
+        char path[FILE_JOBS_PATH_LEN];
+        if (file_ops_get_clipboard_path(i, path, sizeof(path)) != ESP_OK) {
+            ESP_LOGE(TAG, "Clipboard entry %" PRIu32 " path too long", i);
+            continue;
         }
+        ret = file_job_add(job, path);
     }
     
-    if (selected_idx >= 0) {
-        char full_path[3072];  // Large buffer to satisfy compiler warnings
-        if (strcmp(current_directory, "/") == 0) {
-            snprintf(full_path, sizeof(full_path), "/%s", current_entries[selected_idx].name);
-        } else {
-            snprintf(full_path, sizeof(full_path), "%s/%s", 
-                    current_directory, current_entries[selected_idx].name);
-        }
-        
-        // Copy to clipboard for cut operation
-        esp_err_t ret = file_ops_copy_to_clipboard(full_path, true);
-        if (ret == ESP_OK) {
-            ESP_LOGI(TAG, "Prepared for move: %s", full_path);
-        } else {
-            ESP_LOGE(TAG, "Failed to prepare for move: %s", full_path);
-        }
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to queue paste: %s", esp_err_to_name(ret));
+        file_job_discard(job);
+        return;
     }
     
-    // Clear selections and exit selection mode
-    clear_file_selections();
-    file_selection_enabled = false;
+    uint32_t id = file_jobs_submit(job);
+    ESP_LOGI(TAG, "Pasting %" PRIu32 " items to %s as job %" PRIu32, count, current_directory, id);
+    
+    // Moved sources are gone once the job runs, so a cut can only be pasted once
+    if (id && cut) {
+        file_ops_clipboard_begin(false);
+    }
     
     // Refresh to update button states
     update_file_list();
 }
 
+static void paste_conflict_choice_handler(lv_event_t *e) {
+    lv_obj_t *btn = lv_event_get_target(e);
+    lv_obj_t *msgbox = (lv_obj_t*)lv_event_get_user_data(e);
+    file_job_conflict_t conflict = (file_job_conflict_t)(uintptr_t)lv_obj_get_user_data(btn);
+    
+    lv_obj_del(msgbox);
+    paste_clipboard(conflict);
+}
+
+static void paste_conflict_cancel_handler(lv_event_t *e) {
+    lv_obj_t *msgbox = (lv_obj_t*)lv_event_get_user_data(e);
+    lv_obj_del(msgbox);
+}
+
+static lv_obj_t* create_paste_choice_button(lv_obj_t *msgbox, const char *text, lv_align_t align, int32_t x) {
+    lv_obj_t *btn = lv_button_create(msgbox);
+    lv_obj_set_size(btn, 110, 40);
+    lv_obj_align(btn, align, x, -20);
+    apply_button_style(btn);
+    
+    lv_obj_t *label = lv_label_create(btn);
+    lv_label_set_text(label, text);
+    lv_obj_center(label);
+    return btn;
+}
+
 void paste_files_event_handler(lv_event_t *e) {
     lv_event_code_t code = lv_event_get_code(e);
-    if (code != LV_EVENT_CLICKED) return;
     
-    if (!file_ops_clipboard_has_content()) {
-        ESP_LOGW(TAG, "No files in clipboard");
+    if (code == LV_EVENT_CLICKED) {
+        // Plain paste keeps both when a name is taken
+        paste_clipboard(FILE_JOB_CONFLICT_RENAME);
         return;
     }
+    if (code != LV_EVENT_LONG_PRESSED || !file_ops_clipboard_has_content()) return;
     
-    ESP_LOGI(TAG, "Pasting to %s", current_directory);
+    // Long press asks what to do with names that already exist; do not follow it with a click
+    lv_indev_wait_release(lv_indev_active());
     
-    // Paste from clipboard to current directory
-    esp_err_t ret = file_ops_paste_from_clipboard(current_directory);
+    lv_obj_t *msgbox = lv_msgbox_create(lv_screen_active());
     
-    if (ret == ESP_OK) {
-        ESP_LOGI(TAG, "Paste operation completed successfully");
-    } else {
-        ESP_LOGE(TAG, "Paste operation failed");
-    }
+    lv_obj_t *msg_text = lv_label_create(msgbox);
+    lv_label_set_text(msg_text, "Paste: when a name\nalready exists...");
+    lv_obj_set_style_text_align(msg_text, LV_TEXT_ALIGN_CENTER, 0);
+    lv_obj_align(msg_text, LV_ALIGN_CENTER, 0, -30);
     
-    // Refresh file list
-    update_file_list();
+    lv_obj_t *replace_btn = create_paste_choice_button(msgbox, "Replace", LV_ALIGN_BOTTOM_LEFT, 15);
+    lv_obj_set_user_data(replace_btn, (void*)(uintptr_t)FILE_JOB_CONFLICT_OVERWRITE);
+    lv_obj_add_event_cb(replace_btn, paste_conflict_choice_handler, LV_EVENT_CLICKED, msgbox);
+    
+    lv_obj_t *skip_btn = create_paste_choice_button(msgbox, "Skip", LV_ALIGN_BOTTOM_MID, 0);
+    lv_obj_set_user_data(skip_btn, (void*)(uintptr_t)FILE_JOB_CONFLICT_SKIP);
+    lv_obj_add_event_cb(skip_btn, paste_conflict_choice_handler, LV_EVENT_CLICKED, msgbox);
+    
+    lv_obj_t *cancel_btn = create_paste_choice_button(msgbox, "Cancel", LV_ALIGN_BOTTOM_RIGHT, -15);
+    lv_obj_add_event_cb(cancel_btn, paste_conflict_cancel_handler, LV_EVENT_CLICKED, msgbox);
+    
+    lv_obj_set_size(msgbox, 400, 200);
+    lv_obj_center(msgbox);
+}
+
+void file_jobs_event_handler(lv_event_t *e) {
+    lv_event_code_t code = lv_event_get_code(e);
+    if (code != LV_EVENT_CLICKED) return;
+    
+    gui_job_panel_show();
 }
 
 void rename_file_event_handler(lv_event_t *e) {
     lv_event_code_t code = lv_event_get_code(e);
     if (code != LV_EVENT_CLICKED) return;
     
-    if (selected_file_count != 1) {
+    if (selection_set_count(&selected_files) != 1) {
         ESP_LOGW(TAG, "Rename requires exactly one file selected");
         return;
     }
     
     // Find the selected file
-    int selected_idx = -1;
-    for (int i = 0; i < current_entry_count; i++) {
-        if (selected_files[i]) {
-            selected_idx = i;
-            break;
-        }
-    }
-    
-    if (selected_idx < 0) return;
+    uint32_t selected_idx = selection_set_next(&selected_files, 0);
     
     // Create rename dialog
     lv_obj_t *msgbox = lv_msgbox_create(lv_screen_active());
@@ -1035,7 +1090,7 @@ void rename_file_event_handler(lv_event_t *e) {
     
     // Create text area for new name
     lv_obj_t *ta = lv_textarea_create(msgbox);
-    lv_textarea_set_text(ta, current_entries[selected_idx].name);
+    lv_textarea_set_text(ta, file_listing_name(&current_listing, selected_idx));
     lv_textarea_set_one_line(ta, true);
     lv_obj_set_width(ta, 250);
     lv_obj_align(ta, LV_ALIGN_CENTER, 0, -10);
@@ -1083,12 +1138,16 @@ static void rename_confirm_handler(lv_event_t *e) {
     char old_path[3072];  // Large buffer to satisfy compiler warnings
     char new_path[3072];  // Large buffer to satisfy compiler warnings
     
+    if (ctx->file_index >= current_listing.count ||
+        !current_entry_path(ctx->file_index, old_path, sizeof(old_path))) {
+        ESP_LOGW(TAG, "Entry to rename is no longer listed");
+        lv_obj_del(ctx->msgbox);
+        free(ctx);
+        return;
+    }
     if (strcmp(current_directory, "/") == 0) {
-        snprintf(old_path, sizeof(old_path), "/%s", current_entries[ctx->file_index].name);
         snprintf(new_path, sizeof(new_path), "/%s", new_name);
     } else {
-        snprintf(old_path, sizeof(old_path), "%s/%s", 
-                current_directory, current_entries[ctx->file_index].name);
         snprintf(new_path, sizeof(new_path), "%s/%s", 
                 current_directory, new_name);
     }
@@ -53,6 +53,11 @@ void directory_up_event_handler(lv_event_t *e);
  */
 void file_selection_event_handler(lv_event_t *e);
 
+/**
+ * @brief Select all / none on click, invert the selection on long press
+ */
+void select_all_event_handler(lv_event_t *e);
+
 /**
  * @brief Toggle file selection mode event handler
  */
@@ -67,6 +72,11 @@ void move_files_event_handler(lv_event_t *e);
 void paste_files_event_handler(lv_event_t *e);
 void rename_file_event_handler(lv_event_t *e);
 
+/**
+ * @brief Open the background file job list
+ */
+void file_jobs_event_handler(lv_event_t *e);
+
 /**
  * @brief File browser v2 navigation event handlers
  */
@@ -3,14 +3,21 @@
 #include "gui_events.h"
 #include "sd_manager.h"
 #include "file_operations.h"
+#include "file_listing.h"
+#include "gui_virtual_list.h"
+#include "dir_scanner.h"
+#include "listing_cache.h"
+#include "file_index.h"
+#include "name_filter.h"
 #include "config_manager.h"
+#include "thumbnail.h"
 #include "esp_log.h"
+#include "esp_heap_caps.h"
 #include <string.h>
 #include <stdlib.h>
 #include <time.h>
-#include <dirent.h>
-#include <sys/stat.h>
 #include <errno.h>
+#include <inttypes.h>
 
 static const char *TAG = "FILE_BROWSER_V2";
 
@@ -30,17 +37,46 @@ static file_browser_state_t browser_state = {
 static lv_obj_t *file_browser_screen = NULL;
 static lv_obj_t *path_label = NULL;
 static lv_obj_t *file_container = NULL;
+static lv_obj_t *grid_container = NULL;
+static lv_obj_t *empty_label = NULL;
+static lv_obj_t *scan_spinner = NULL;
 static lv_obj_t *page_label = NULL;
 static lv_obj_t *info_label = NULL;
 static lv_obj_t *prev_btn = NULL;
 static lv_obj_t *next_btn = NULL;
 static lv_obj_t *multi_select_btn = NULL;
+static lv_obj_t *search_box = NULL;
+static lv_obj_t *search_keyboard = NULL;
 // Context menu support - implementation pending
 // static lv_obj_t *context_menu = NULL;
 
-// Static file list cache
-static file_entry_enhanced_t *file_cache = NULL;
-static int file_cache_size = 0;
+// Current directory listing and its sorted view (indices into the listing)
+static file_listing_t listing = {0};
+static uint32_t *view_order = NULL;
+static uint32_t view_order_capacity = 0;
+static uint32_t view_count = 0;
+static uint32_t view_dir_count = 0;
+
+// browser_state.selected_items has one slot per listing entry, so marks
+// survive filtering and re-sorting; only a directory change clears them
+static uint32_t selection_slots = 0;
+
+// Filter-as-you-type over the current listing
+static name_filter_t name_index = {0};
+static char filter_text[NAME_FILTER_MAX_LEN + 1] = "";
+static uint32_t *match_bits = NULL;
+static uint32_t match_bits_words = 0;
+
+// Background scan feeding the listing
+static uint32_t scan_id = 0;
+static char scan_path[MAX_PATH_LENGTH];
+static bool scan_show_hidden = false;
+static bool scan_in_progress = false;
+static lv_timer_t *scan_timer = NULL;
+
+// Thumbnails for the grid view; bumping the generation makes every tile reload
+static lv_timer_t *thumb_timer = NULL;
+static uint32_t grid_generation = 0;
 
 // Settings integration variables
 static int current_view_mode = 0;  // 0=list, 1=grid, 2=detailed
@@ -48,14 +84,56 @@ static int current_sort_mode = 0;  // 0=name, 1=size, 2=date, 3=type
 static bool sort_ascending = true;
 static bool show_hidden = false;
 
+// Row geometry for the recycled list
+#define FILE_ROW_HEIGHT 60
+#define FILE_ROW_GAP    6
+
+// Child order inside a pooled row
+enum {
+    ROW_CHILD_CHECKBOX,
+    ROW_CHILD_ICON,
+    ROW_CHILD_NAME,
+    ROW_CHILD_SIZE,
+    ROW_CHILD_DATE
+};
+
+// Tile geometry for the grid view; each recycled row holds a strip of tiles
+#define GRID_COLUMNS     8
+#define GRID_TILE_WIDTH  140
+#define GRID_TILE_HEIGHT 150
+#define GRID_TILE_GAP    8
+
+// Child order inside a grid tile
+enum {
+    TILE_CHILD_IMAGE,
+    TILE_CHILD_ICON,
+    TILE_CHILD_NAME,
+    TILE_CHILD_CHECKBOX
+};
+
+// Per-tile state, kept in the tile's user data
+typedef struct {
+    uint32_t item;              // View index shown
+    uint32_t entry;             // Listing entry shown, UINT32_MAX if none
+    uint32_t generation;        // grid_generation the entry was bound in
+    uint32_t request;           // Outstanding thumbnail request, 0 if none
+    uint16_t *pixels;           // Copy of the thumbnail, allocated on first use
+    lv_image_dsc_t image;
+} grid_tile_t;
+
 // Forward declarations
 static void create_file_list_items(void);
 static void update_pagination_buttons(void);
+static void file_row_create_cb(lv_obj_t *row, void *user_data);
+static void file_row_bind_cb(lv_obj_t *row, uint32_t index, void *user_data);
+static void grid_row_create_cb(lv_obj_t *row, void *user_data);
+static void grid_row_bind_cb(lv_obj_t *row, uint32_t index, void *user_data);
+static void thumb_timer_cb(lv_timer_t *timer);
+static void file_list_scroll_event_cb(lv_event_t *e);
+static void scan_timer_cb(lv_timer_t *timer);
 static void scan_directory_enhanced(const char *path);
-static int compare_files_by_name(const void *a, const void *b);
-static int compare_files_by_size(const void *a, const void *b);
-static int compare_files_by_date(const void *a, const void *b);
-static int compare_files_by_type(const void *a, const void *b);
+static void search_box_event_cb(lv_event_t *e);
+static void search_keyboard_event_cb(lv_event_t *e);
 
 lv_obj_t* gui_file_browser_v2_create(void) {
     // Create screen
@@ -65,6 +143,7 @@ lv_obj_t* gui_file_browser_v2_create(void) {
     // Get configuration
     launcher_config_t *config = config_manager_get_current();
     browser_state.items_per_page = config->file_browser.items_per_page;
+    current_view_mode = config->file_browser.view_mode;
     
     // Create top bar container
     lv_obj_t *top_bar = lv_obj_create(file_browser_screen);
@@ -103,7 +182,7 @@ lv_obj_t* gui_file_browser_v2_create(void) {
     lv_obj_set_style_text_font(path_label, THEME_FONT_NORMAL, 0);
     lv_obj_align_to(path_label, up_btn, LV_ALIGN_OUT_RIGHT_MID, 20, 0);
     lv_label_set_long_mode(path_label, LV_LABEL_LONG_SCROLL_CIRCULAR);
-    lv_obj_set_width(path_label, 400);
+    lv_obj_set_width(path_label, 280);
     
     // Multi-select toggle button
     multi_select_btn = lv_button_create(top_bar);
@@ -117,8 +196,18 @@ lv_obj_t* gui_file_browser_v2_create(void) {
     lv_label_set_text(multi_label, LV_SYMBOL_LIST " Multi");
     lv_obj_center(multi_label);
     
-    // File container (scrollable)
-    file_container = lv_obj_create(file_browser_screen);
+    // Filter box, narrows the current directory on every keystroke
+    search_box = lv_textarea_create(top_bar);
+    lv_obj_set_size(search_box, 240, 50);
+    lv_obj_align_to(search_box, multi_select_btn, LV_ALIGN_OUT_LEFT_MID, -10, 0);
+    lv_textarea_set_one_line(search_box, true);
+    lv_textarea_set_max_length(search_box, NAME_FILTER_MAX_LEN);
+    lv_textarea_set_placeholder_text(search_box, "Filter...");
+    lv_obj_add_event_cb(search_box, search_box_event_cb, LV_EVENT_ALL, NULL);
+    
+    // File container (scrollable, rows are recycled as it scrolls)
+    file_container = gui_virtual_list_create(file_browser_screen, FILE_ROW_HEIGHT, FILE_ROW_GAP,
+                                             file_row_create_cb, file_row_bind_cb, NULL);
     lv_obj_set_size(file_container, lv_pct(95), lv_pct(65));
     lv_obj_align(file_container, LV_ALIGN_CENTER, 0, 20);
     lv_obj_set_style_bg_color(file_container, lv_color_hex(0x1a1a1a), 0);
@@ -126,8 +215,52 @@ lv_obj_t* gui_file_browser_v2_create(void) {
     lv_obj_set_style_border_width(file_container, 2, 0);
     lv_obj_set_style_radius(file_container, 10, 0);
     lv_obj_set_style_pad_all(file_container, 10, 0);
-    lv_obj_set_flex_flow(file_container, LV_FLEX_FLOW_COLUMN);
-    lv_obj_set_flex_align(file_container, LV_FLEX_ALIGN_START, LV_FLEX_ALIGN_START, LV_FLEX_ALIGN_START);
+    lv_obj_add_event_cb(file_container, file_list_scroll_event_cb, LV_EVENT_SCROLL_END, NULL);
+    
+    // Grid view over the same area; rows of tiles are recycled the same way
+    grid_container = gui_virtual_list_create(file_browser_screen, GRID_TILE_HEIGHT, GRID_TILE_GAP,
+                                             grid_row_create_cb, grid_row_bind_cb, NULL);
+    lv_obj_set_size(grid_container, lv_pct(95), lv_pct(65));
+    lv_obj_align(grid_container, LV_ALIGN_CENTER, 0, 20);
+    lv_obj_set_style_bg_color(grid_container, lv_color_hex(0x1a1a1a), 0);
+    lv_obj_set_style_border_color(grid_container, THEME_PRIMARY_COLOR, 0);
+    lv_obj_set_style_border_width(grid_container, 2, 0);
+    lv_obj_set_style_radius(grid_container, 10, 0);
+    lv_obj_set_style_pad_all(grid_container, 10, 0);
+    lv_obj_add_event_cb(grid_container, file_list_scroll_event_cb, LV_EVENT_SCROLL_END, NULL);
+    if (current_view_mode == VIEW_MODE_GRID) {
+        lv_obj_add_flag(file_container, LV_OBJ_FLAG_HIDDEN);
+    } else {
+        lv_obj_add_flag(grid_container, LV_OBJ_FLAG_HIDDEN);
+    }
+    
+    empty_label = lv_label_create(file_browser_screen);
+    lv_label_set_text(empty_label, "No files found");
+    lv_obj_set_style_text_color(empty_label, THEME_WARNING_COLOR, 0);
+    lv_obj_align_to(empty_label, file_container, LV_ALIGN_CENTER, 0, 0);
+    lv_obj_add_flag(empty_label, LV_OBJ_FLAG_HIDDEN);
+    
+    // Shown while a directory is being scanned
+    scan_spinner = lv_spinner_create(file_browser_screen);
+    lv_obj_set_size(scan_spinner, 48, 48);
+    lv_obj_align_to(scan_spinner, file_container, LV_ALIGN_TOP_RIGHT, -20, 20);
+    lv_obj_add_flag(scan_spinner, LV_OBJ_FLAG_HIDDEN);
+    
+    // On-screen keyboard for the filter box (initially hidden)
+    search_keyboard = lv_keyboard_create(file_browser_screen);
+    lv_obj_set_size(search_keyboard, lv_pct(100), lv_pct(40));
+    lv_obj_align(search_keyboard, LV_ALIGN_BOTTOM_MID, 0, 0);
+    lv_keyboard_set_textarea(search_keyboard, search_box);
+    lv_obj_add_event_cb(search_keyboard, search_keyboard_event_cb, LV_EVENT_ALL, NULL);
+    lv_obj_add_flag(search_keyboard, LV_OBJ_FLAG_HIDDEN);
+    
+    if (!scan_timer) {
+        scan_timer = lv_timer_create(scan_timer_cb, DIR_SCANNER_POLL_MS, NULL);
+        lv_timer_pause(scan_timer);
+    }
+    if (!thumb_timer) {
+        thumb_timer = lv_timer_create(thumb_timer_cb, DIR_SCANNER_POLL_MS, NULL);
+    }
     
     // Bottom bar for pagination and info
     lv_obj_t *bottom_bar = lv_obj_create(file_browser_screen);
@@ -172,6 +305,9 @@ lv_obj_t* gui_file_browser_v2_create(void) {
     lv_label_set_text(next_label, LV_SYMBOL_RIGHT);
     lv_obj_center(next_label);
     
+    // Keep the keyboard above the bottom bar
+    lv_obj_move_foreground(search_keyboard);
+    
     // Initial directory scan
     scan_directory_enhanced(browser_state.current_path);
     create_file_list_items();
@@ -180,353 +316,714 @@ lv_obj_t* gui_file_browser_v2_create(void) {
     return file_browser_screen;
 }
 
-static void scan_directory_enhanced(const char *path) {
-    // Free previous cache
-    if (file_cache) {
-        free(file_cache);
-        file_cache = NULL;
-        file_cache_size = 0;
-    }
-    
-    // Free selection array
-    if (browser_state.selected_items) {
-        free(browser_state.selected_items);
-        browser_state.selected_items = NULL;
+static bool hidden_files_visible(void) {
+    launcher_config_t *config = config_manager_get_current();
+    return config->file_browser.show_hidden_files || show_hidden;
+}
+
+static bool grid_view_active(void) {
+    return current_view_mode == VIEW_MODE_GRID;
+}
+
+// Lay the view out in whichever list is showing; grid rows hold GRID_COLUMNS items
+static void set_list_count(void) {
+    if (grid_view_active()) {
+        gui_virtual_list_set_count(grid_container, (view_count + GRID_COLUMNS - 1) / GRID_COLUMNS);
+    } else {
+        gui_virtual_list_set_count(file_container, view_count);
     }
-    
-    if (!sd_manager_is_mounted()) {
-        ESP_LOGW(TAG, "SD card not mounted");
-        browser_state.total_files = 0;
-        browser_state.total_pages = 1;
-        return;
+}
+
+static void scroll_to_item(uint32_t item) {
+    if (grid_view_active()) {
+        gui_virtual_list_scroll_to(grid_container, item / GRID_COLUMNS);
+    } else {
+        gui_virtual_list_scroll_to(file_container, item);
     }
-    
-    // Build full path
-    char full_path[512];
-    snprintf(full_path, sizeof(full_path), "%s%s", SD_MOUNT_POINT, path);
-    
-    // Count files first
-    DIR *dir = opendir(full_path);
-    if (!dir) {
-        ESP_LOGE(TAG, "Failed to open directory: %s", full_path);
-        browser_state.total_files = 0;
-        browser_state.total_pages = 1;
-        return;
+}
+
+static uint32_t first_visible_item(void) {
+    if (grid_view_active()) {
+        return gui_virtual_list_get_first_visible(grid_container) * GRID_COLUMNS;
     }
-    
-    int count = 0;
-    struct dirent *entry;
-    launcher_config_t *config = config_manager_get_current();
-    
-    while ((entry = readdir(dir)) != NULL) {
-        // Skip . and ..
-        if (strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0) {
-            continue;
-        }
-        
-        // Skip hidden files if configured (check both config and local override)
-        bool should_show_hidden = config->file_browser.show_hidden_files || show_hidden;
-        if (!should_show_hidden && entry->d_name[0] == '.') {
-            continue;
+    return gui_virtual_list_get_first_visible(file_container);
+}
+
+static void refresh_list(void) {
+    gui_virtual_list_refresh(grid_view_active() ? grid_container : file_container);
+}
+
+// Drop every outstanding thumbnail; tiles request again when next bound
+static void reset_grid_thumbnails(void) {
+    thumbnail_cancel_all();
+    grid_generation++;
+}
+
+// Recompute filter matches for listing entries from 'first' on
+static bool update_matches(uint32_t first) {
+    uint32_t words = (listing.count + 31) / 32;
+    if (words > match_bits_words) {
+        uint32_t *bits = realloc(match_bits, words * sizeof(uint32_t));
+        if (!bits) {
+            ESP_LOGE(TAG, "Failed to allocate filter matches");
+            return false;
         }
-        
-        count++;
+        match_bits = bits;
+        match_bits_words = words;
     }
-    closedir(dir);
-    
-    if (count == 0) {
-        browser_state.total_files = 0;
-        browser_state.total_pages = 1;
-        return;
+    if (name_filter_update(&name_index, &listing) != ESP_OK) {
+        return false;
     }
-    
-    // Allocate cache
-    file_cache = calloc(count, sizeof(file_entry_enhanced_t));
-    if (!file_cache) {
-        ESP_LOGE(TAG, "Failed to allocate file cache");
-        browser_state.total_files = 0;
-        browser_state.total_pages = 1;
-        return;
+    name_filter_match(&name_index, &listing, filter_text, first, match_bits);
+    return true;
+}
+
+// Extend the view with the visible listing entries from 'first' on, in listing order
+static bool append_view_order(uint32_t first) {
+    if (listing.count > view_order_capacity) {
+        uint32_t capacity = view_order_capacity ? view_order_capacity : 64;
+        while (capacity < listing.count) {
+            capacity *= 2;
+        }
+        uint32_t *order = realloc(view_order, capacity * sizeof(uint32_t));
+        if (!order) {
+            ESP_LOGE(TAG, "Failed to allocate view order");
+            return false;
+        }
+        view_order = order;
+        view_order_capacity = capacity;
     }
-    
-    // Allocate selection array
-    browser_state.selected_items = calloc(count, sizeof(bool));
-    
-    // Scan again to fill cache
-    dir = opendir(full_path);
-    if (!dir) {
-        free(file_cache);
-        file_cache = NULL;
-        return;
+    bool filtered = filter_text[0] != '\0';
+    if (filtered && !update_matches(first)) {
+        return false;
     }
-    
-    int index = 0;
-    while ((entry = readdir(dir)) != NULL && index < count) {
-        if (strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0) {
+    bool with_hidden = hidden_files_visible();
+    for (uint32_t i = first; i < listing.count; i++) {
+        if (!with_hidden && (listing.flags[i] & FILE_LISTING_FLAG_HIDDEN)) {
             continue;
         }
-        
-        bool should_show_hidden = config->file_browser.show_hidden_files || show_hidden;
-        if (!should_show_hidden && entry->d_name[0] == '.') {
+        if (filtered && !name_filter_matched(match_bits, i)) {
             continue;
         }
-        
-        // Get file info
-        char item_path[768];
-        snprintf(item_path, sizeof(item_path), "%s/%s", full_path, entry->d_name);
-        
-        struct stat file_stat;
-        if (stat(item_path, &file_stat) == 0) {
-            // Fill enhanced entry - use snprintf to avoid truncation warnings
-            snprintf(file_cache[index].name, sizeof(file_cache[index].name), "%s", entry->d_name);
-            
-            // Create display name (truncate if needed)
-            if (strlen(entry->d_name) > MAX_FILENAME_DISPLAY) {
-                snprintf(file_cache[index].display_name, sizeof(file_cache[index].display_name), "%.*s...", MAX_FILENAME_DISPLAY - 3, entry->d_name);
-            } else {
-                snprintf(file_cache[index].display_name, sizeof(file_cache[index].display_name), "%s", entry->d_name);
-            }
-            
-            file_cache[index].is_directory = S_ISDIR(file_stat.st_mode);
-            file_cache[index].size = file_stat.st_size;
-            file_cache[index].modified_time = file_stat.st_mtime;
-            
-            // Get icon and color
-            file_cache[index].icon = gui_file_browser_v2_get_icon(entry->d_name, file_cache[index].is_directory);
-            file_cache[index].color = gui_file_browser_v2_get_color(entry->d_name, file_cache[index].is_directory);
-            
-            // Format size and date
-            gui_file_browser_v2_format_size(file_cache[index].size, file_cache[index].size_str, sizeof(file_cache[index].size_str));
-            gui_file_browser_v2_format_date(file_cache[index].modified_time, file_cache[index].date_str, sizeof(file_cache[index].date_str));
-            
-            index++;
+        if (file_listing_is_dir(&listing, i)) {
+            view_dir_count++;
         }
+        view_order[view_count++] = i;
     }
-    closedir(dir);
-    
-    file_cache_size = index;
-    browser_state.total_files = index;
+    return true;
+}
+
+static void reset_view(void) {
+    view_count = 0;
+    view_dir_count = 0;
+}
+
+static void sort_view(void) {
+    launcher_config_t *config = config_manager_get_current();
     
     // Sort files based on configuration or local override
-    void *compare_func = compare_files_by_name; // Default
     int sort_mode_to_use = current_sort_mode > 0 ? current_sort_mode : config->file_browser.sort_by;
+    file_listing_sort_t by;
     
     switch (sort_mode_to_use) {
         case 1: // SORT_BY_SIZE
-            compare_func = compare_files_by_size;
+            by = FILE_LISTING_SORT_SIZE;
             break;
         case 2: // SORT_BY_DATE
-            compare_func = compare_files_by_date;
+            by = FILE_LISTING_SORT_DATE;
             break;
         case 3: // SORT_BY_TYPE
-            compare_func = compare_files_by_type;
+            by = FILE_LISTING_SORT_TYPE;
             break;
         case 0: // SORT_BY_NAME
         default:
-            compare_func = compare_files_by_name;
+            by = FILE_LISTING_SORT_NAME;
             break;
     }
     
-    qsort(file_cache, file_cache_size, sizeof(file_entry_enhanced_t), compare_func);
+    if (file_listing_sort(&listing, view_order, view_count, by, config->file_browser.sort_ascending) != ESP_OK) {
+        ESP_LOGW(TAG, "Not enough memory to sort %u entries", (unsigned)view_count);
+    }
+}
+
+static void stop_scan_ui(void) {
+    scan_in_progress = false;
+    lv_timer_pause(scan_timer);
+    lv_obj_add_flag(scan_spinner, LV_OBJ_FLAG_HIDDEN);
+}
+
+static bool entry_selected(uint32_t idx) {
+    return idx < selection_slots && browser_state.selected_items[idx];
+}
+
+// Make room for a mark on every entry read so far; new slots start unmarked
+static bool grow_selection(void) {
+    if (selection_slots >= listing.count) {
+        return true;
+    }
+    bool *slots = realloc(browser_state.selected_items, listing.count * sizeof(bool));
+    if (!slots) {
+        ESP_LOGE(TAG, "Failed to allocate selection");
+        return false;
+    }
+    memset(slots + selection_slots, 0, (listing.count - selection_slots) * sizeof(bool));
+    browser_state.selected_items = slots;
+    selection_slots = listing.count;
+    return true;
+}
+
+// Sort the view and lay it out; the listing itself is left untouched
+static void show_view(void) {
+    sort_view();
+    
+    browser_state.total_files = view_count;
     
     // Calculate pages
     browser_state.total_pages = (browser_state.total_files + browser_state.items_per_page - 1) / browser_state.items_per_page;
     if (browser_state.total_pages == 0) {
         browser_state.total_pages = 1;
     }
+    if (browser_state.current_page >= browser_state.total_pages) {
+        browser_state.current_page = browser_state.total_pages - 1;
+    }
     
-    // Reset to first page
-    browser_state.current_page = 0;
+    create_file_list_items();
+    update_pagination_buttons();
 }
 
-static void create_file_list_items(void) {
-    // Clear existing items
-    lv_obj_clean(file_container);
-    
-    if (file_cache_size == 0) {
-        lv_obj_t *empty_label = lv_label_create(file_container);
-        lv_label_set_text(empty_label, "No files found");
-        lv_obj_set_style_text_color(empty_label, THEME_WARNING_COLOR, 0);
-        lv_obj_center(empty_label);
+static void finish_scan(bool complete) {
+    stop_scan_ui();
+    
+    // Only complete listings are cached; partial ones would hide entries later
+    if (complete) {
+        listing_cache_store(scan_path, scan_show_hidden, &listing);
+    }
+    
+    // Entries were shown in directory order while streaming; sort once complete
+    show_view();
+}
+
+// Re-filter and re-sort the listing in memory after a view setting changed
+static void rebuild_view(void) {
+    reset_view();
+    if (!append_view_order(0)) {
         return;
     }
+    if (scan_in_progress) {
+        // The scan keeps streaming into the new view and sorts it when done
+        set_list_count();
+        return;
+    }
+    show_view();
+}
+
+static void scan_timer_cb(lv_timer_t *timer) {
+    (void)timer;
+    uint32_t previous = listing.count;
+    uint32_t previous_view = view_count;
+    dir_scan_state_t state = dir_scanner_poll(scan_id, &listing, DIR_SCANNER_POLL_BATCH);
     
-    launcher_config_t *config = config_manager_get_current();
+    if (state == DIR_SCAN_CANCELLED) {
+        stop_scan_ui();
+        return;
+    }
     
-    // Calculate range for current page
-    int start_index = browser_state.current_page * browser_state.items_per_page;
-    int end_index = start_index + browser_state.items_per_page;
-    if (end_index > file_cache_size) {
-        end_index = file_cache_size;
-    }
-    
-    // Create items for current page
-    for (int i = start_index; i < end_index; i++) {
-        lv_obj_t *item = lv_obj_create(file_container);
-        lv_obj_set_size(item, lv_pct(100), 60);
-        lv_obj_set_style_bg_color(item, lv_color_hex(0x2a2a2a), 0);
-        lv_obj_set_style_border_width(item, 1, 0);
-        lv_obj_set_style_border_color(item, lv_color_hex(0x404040), 0);
-        lv_obj_set_style_radius(item, 5, 0);
-        lv_obj_set_style_pad_all(item, 8, 0);
-        lv_obj_add_flag(item, LV_OBJ_FLAG_CLICKABLE);
-        
-        // Add checkbox if in multi-select mode
-        if (browser_state.multi_select_mode) {
-            lv_obj_t *checkbox = lv_checkbox_create(item);
-            lv_obj_align(checkbox, LV_ALIGN_LEFT_MID, 0, 0);
-            if (browser_state.selected_items && browser_state.selected_items[i]) {
-                lv_obj_add_state(checkbox, LV_STATE_CHECKED);
-            } else {
-                lv_obj_clear_state(checkbox, LV_STATE_CHECKED);
+    if (listing.count > previous) {
+        if (!append_view_order(previous)) {
+            // Drop the batch that has no view slots and show what we have
+            dir_scanner_cancel();
+            while (listing.count > previous) {
+                if (file_listing_is_dir(&listing, --listing.count)) {
+                    listing.dir_count--;
+                }
             }
+            finish_scan(false);
+            return;
         }
-        
-        // Icon
-        lv_obj_t *icon = lv_label_create(item);
-        lv_label_set_text(icon, file_cache[i].icon);
-        lv_obj_set_style_text_color(icon, file_cache[i].color, 0);
-        lv_obj_set_style_text_font(icon, THEME_FONT_LARGE, 0);
-        if (browser_state.multi_select_mode) {
-            lv_obj_align(icon, LV_ALIGN_LEFT_MID, 40, 0);
-        } else {
-            lv_obj_align(icon, LV_ALIGN_LEFT_MID, 10, 0);
-        }
-        
-        // File name
-        lv_obj_t *name = lv_label_create(item);
-        lv_label_set_text(name, file_cache[i].display_name);
-        lv_obj_set_style_text_color(name, THEME_TEXT_COLOR, 0);
-        lv_obj_set_style_text_font(name, THEME_FONT_NORMAL, 0);
-        if (browser_state.multi_select_mode) {
-            lv_obj_align_to(name, icon, LV_ALIGN_OUT_RIGHT_MID, 15, -10);
-        } else {
-            lv_obj_align_to(name, icon, LV_ALIGN_OUT_RIGHT_MID, 15, -10);
+        if (view_count > previous_view) {
+            set_list_count();
+            lv_obj_add_flag(empty_label, LV_OBJ_FLAG_HIDDEN);
         }
-        
-        // Size/Info
-        if (config->file_browser.show_file_sizes || config->file_browser.view_mode == VIEW_MODE_DETAILED) {
-            lv_obj_t *size = lv_label_create(item);
-            if (file_cache[i].is_directory) {
-                lv_label_set_text(size, "Folder");
-            } else {
-                lv_label_set_text(size, file_cache[i].size_str);
-            }
-            lv_obj_set_style_text_color(size, THEME_SECONDARY_COLOR, 0);
-            lv_obj_set_style_text_font(size, THEME_FONT_SMALL, 0);
-            lv_obj_align_to(size, name, LV_ALIGN_OUT_BOTTOM_LEFT, 0, 2);
+    }
+    
+    if (state == DIR_SCAN_FAILED) {
+        ESP_LOGE(TAG, "Failed to scan %s", browser_state.current_path);
+    }
+    if (state != DIR_SCAN_RUNNING) {
+        finish_scan(state == DIR_SCAN_DONE);
+        return;
+    }
+    
+    lv_label_set_text_fmt(info_label, "Scanning... %u entries", (unsigned)listing.count);
+}
+
+static void scan_directory_enhanced(const char *path) {
+    // Listing storage is reused between scans, only the contents are reset
+    file_listing_clear(&listing);
+    name_filter_reset(&name_index);
+    reset_view();
+    reset_grid_thumbnails();
+    
+    // The filter applies to one directory; clear it before the box echoes it back
+    filter_text[0] = '\0';
+    if (search_box) {
+        lv_textarea_set_text(search_box, "");
+    }
+    
+    // Marks belong to entries of the old listing; keep the slots for reuse
+    if (selection_slots) {
+        memset(browser_state.selected_items, 0, selection_slots * sizeof(bool));
+    }
+    
+    browser_state.total_files = 0;
+    browser_state.total_pages = 1;
+    browser_state.current_page = 0;
+
+    if (!sd_manager_is_mounted()) {
+        ESP_LOGW(TAG, "SD card not mounted");
+        dir_scanner_cancel();
+        stop_scan_ui();
+        return;
+    }
+    
+    // Hidden entries are always read and filtered by the view, so toggling
+    // them later does not need another pass over the card
+    snprintf(scan_path, sizeof(scan_path), "%s", path);
+    scan_show_hidden = true;
+    file_index_note_open(path);
+
+    // Directories seen before come straight from the cache, without touching the card
+    if (listing_cache_lookup(path, scan_show_hidden, &listing)) {
+        dir_scanner_cancel();
+        if (append_view_order(0)) {
+            finish_scan(false);
+            return;
         }
-        
-        // Date (if detailed view)
-        if (config->file_browser.view_mode == VIEW_MODE_DETAILED) {
-            lv_obj_t *date = lv_label_create(item);
-            lv_label_set_text(date, file_cache[i].date_str);
-            lv_obj_set_style_text_color(date, THEME_SECONDARY_COLOR, 0);
-            lv_obj_set_style_text_font(date, THEME_FONT_SMALL, 0);
-            lv_obj_align(date, LV_ALIGN_RIGHT_MID, -10, 0);
+        file_listing_clear(&listing);
+        name_filter_reset(&name_index);
+        reset_view();
+    }
+
+    // Runs on the scanner task; any scan still in flight is superseded
+    scan_id = dir_scanner_start(path, scan_show_hidden);
+    if (scan_id == 0) {
+        stop_scan_ui();
+        return;
+    }
+    scan_in_progress = true;
+    lv_obj_remove_flag(scan_spinner, LV_OBJ_FLAG_HIDDEN);
+    lv_timer_resume(scan_timer);
+}
+
+static void set_search_keyboard_visible(bool visible) {
+    if (visible) {
+        lv_obj_remove_flag(search_keyboard, LV_OBJ_FLAG_HIDDEN);
+    } else {
+        lv_obj_add_flag(search_keyboard, LV_OBJ_FLAG_HIDDEN);
+    }
+}
+
+static void search_box_event_cb(lv_event_t *e) {
+    lv_event_code_t code = lv_event_get_code(e);
+    
+    if (code == LV_EVENT_FOCUSED) {
+        set_search_keyboard_visible(true);
+    } else if (code == LV_EVENT_DEFOCUSED) {
+        set_search_keyboard_visible(false);
+    } else if (code == LV_EVENT_VALUE_CHANGED) {
+        const char *text = lv_textarea_get_text(search_box);
+        if (strcmp(text, filter_text) == 0) {
+            return;
         }
+        snprintf(filter_text, sizeof(filter_text), "%s", text);
         
-        // Add click event
-        lv_obj_add_event_cb(item, NULL, LV_EVENT_CLICKED, (void*)(intptr_t)i);
+        // Matches start at the top of the list
+        browser_state.current_page = 0;
+        rebuild_view();
     }
+}
+
+static void search_keyboard_event_cb(lv_event_t *e) {
+    lv_event_code_t code = lv_event_get_code(e);
     
-    // Update info label
-    int dir_count = 0, file_count = 0;
-    for (int i = 0; i < file_cache_size; i++) {
-        if (file_cache[i].is_directory) {
-            dir_count++;
-        } else {
-            file_count++;
-        }
+    if (code == LV_EVENT_READY || code == LV_EVENT_CANCEL) {
+        lv_obj_remove_state(search_box, LV_STATE_FOCUSED);
+        set_search_keyboard_visible(false);
     }
+}
+
+static void file_row_create_cb(lv_obj_t *row, void *user_data) {
+    (void)user_data;
+    lv_obj_set_style_bg_color(row, lv_color_hex(0x2a2a2a), 0);
+    lv_obj_set_style_border_width(row, 1, 0);
+    lv_obj_set_style_border_color(row, lv_color_hex(0x404040), 0);
+    lv_obj_set_style_radius(row, 5, 0);
+    lv_obj_set_style_pad_all(row, 8, 0);
+    lv_obj_add_flag(row, LV_OBJ_FLAG_CLICKABLE);
+    lv_obj_add_event_cb(row, file_browser_v2_item_click_handler, LV_EVENT_CLICKED, NULL);
     
-    char info_text[64];
-    snprintf(info_text, sizeof(info_text), "%d files, %d folders", file_count, dir_count);
-    lv_label_set_text(info_label, info_text);
+    // Checkbox (only shown in multi-select mode)
+    lv_obj_t *checkbox = lv_checkbox_create(row);
+    lv_checkbox_set_text(checkbox, "");
+    lv_obj_align(checkbox, LV_ALIGN_LEFT_MID, 0, 0);
+    lv_obj_add_flag(checkbox, LV_OBJ_FLAG_HIDDEN);
     
-    // Update page label
-    char page_text[32];
-    snprintf(page_text, sizeof(page_text), "Page %d / %d", 
-             browser_state.current_page + 1, browser_state.total_pages);
-    lv_label_set_text(page_label, page_text);
+    // Icon
+    lv_obj_t *icon = lv_label_create(row);
+    lv_obj_set_style_text_font(icon, THEME_FONT_LARGE, 0);
+    
+    // File name
+    lv_obj_t *name = lv_label_create(row);
+    lv_obj_set_style_text_color(name, THEME_TEXT_COLOR, 0);
+    lv_obj_set_style_text_font(name, THEME_FONT_NORMAL, 0);
+    
+    // Size/Info
+    lv_obj_t *size = lv_label_create(row);
+    lv_obj_set_style_text_color(size, THEME_SECONDARY_COLOR, 0);
+    lv_obj_set_style_text_font(size, THEME_FONT_SMALL, 0);
+    
+    // Date (detailed view)
+    lv_obj_t *date = lv_label_create(row);
+    lv_obj_set_style_text_color(date, THEME_SECONDARY_COLOR, 0);
+    lv_obj_set_style_text_font(date, THEME_FONT_SMALL, 0);
+    lv_obj_align(date, LV_ALIGN_RIGHT_MID, -10, 0);
 }
 
-static void update_pagination_buttons(void) {
-    // Enable/disable pagination buttons
-    if (browser_state.current_page == 0) {
-        lv_obj_add_state(prev_btn, LV_STATE_DISABLED);
+static void file_row_bind_cb(lv_obj_t *row, uint32_t index, void *user_data) {
+    (void)user_data;
+    launcher_config_t *config = config_manager_get_current();
+    uint32_t idx = view_order[index];
+    const char *file_name = file_listing_name(&listing, idx);
+    bool is_directory = file_listing_is_dir(&listing, idx);
+    bool detailed = config->file_browser.view_mode == VIEW_MODE_DETAILED;
+    
+    lv_obj_t *checkbox = lv_obj_get_child(row, ROW_CHILD_CHECKBOX);
+    lv_obj_t *icon = lv_obj_get_child(row, ROW_CHILD_ICON);
+    lv_obj_t *name = lv_obj_get_child(row, ROW_CHILD_NAME);
+    lv_obj_t *size = lv_obj_get_child(row, ROW_CHILD_SIZE);
+    lv_obj_t *date = lv_obj_get_child(row, ROW_CHILD_DATE);
+    
+    if (browser_state.multi_select_mode) {
+        lv_obj_remove_flag(checkbox, LV_OBJ_FLAG_HIDDEN);
+        if (entry_selected(idx)) {
+            lv_obj_add_state(checkbox, LV_STATE_CHECKED);
+        } else {
+            lv_obj_clear_state(checkbox, LV_STATE_CHECKED);
+        }
     } else {
-        lv_obj_clear_state(prev_btn, LV_STATE_DISABLED);
+        lv_obj_add_flag(checkbox, LV_OBJ_FLAG_HIDDEN);
     }
     
-    if (browser_state.current_page >= browser_state.total_pages - 1) {
-        lv_obj_add_state(next_btn, LV_STATE_DISABLED);
+    int32_t text_x = browser_state.multi_select_mode ? 40 : 10;
+    lv_label_set_text(icon, gui_file_browser_v2_get_icon(file_name, is_directory));
+    lv_obj_set_style_text_color(icon, gui_file_browser_v2_get_color(file_name, is_directory), 0);
+    lv_obj_align(icon, LV_ALIGN_LEFT_MID, text_x, 0);
+    
+    if (strlen(file_name) > MAX_FILENAME_DISPLAY) {
+        lv_label_set_text_fmt(name, "%.*s...", MAX_FILENAME_DISPLAY - 3, file_name);
     } else {
-        lv_obj_clear_state(next_btn, LV_STATE_DISABLED);
+        lv_label_set_text(name, file_name);
+    }
+    lv_obj_align(name, LV_ALIGN_LEFT_MID, text_x + 45, -10);
+    
+    if (config->file_browser.show_file_sizes || detailed) {
+        if (is_directory) {
+            lv_label_set_text(size, "Folder");
+        } else {
+            char size_str[32];
+            gui_file_browser_v2_format_size(listing.size[idx], size_str, sizeof(size_str));
+            lv_label_set_text(size, size_str);
+        }
+        lv_obj_align(size, LV_ALIGN_LEFT_MID, text_x + 45, 14);
+        lv_obj_remove_flag(size, LV_OBJ_FLAG_HIDDEN);
+    } else {
+        lv_obj_add_flag(size, LV_OBJ_FLAG_HIDDEN);
+    }
+    
+    if (detailed) {
+        char date_str[32];
+        gui_file_browser_v2_format_date(listing.mtime[idx], date_str, sizeof(date_str));
+        lv_label_set_text(date, date_str);
+        lv_obj_remove_flag(date, LV_OBJ_FLAG_HIDDEN);
+    } else {
+        lv_obj_add_flag(date, LV_OBJ_FLAG_HIDDEN);
+    }
+}
+
+static void grid_tile_release(grid_tile_t *state) {
+    if (state->request) {
+        thumbnail_cancel(state->request);
+        state->request = 0;
     }
+    state->entry = UINT32_MAX;
 }
 
-// Comparison functions for sorting
-static int compare_files_by_name(const void *a, const void *b) {
-    file_entry_enhanced_t *fa = (file_entry_enhanced_t *)a;
-    file_entry_enhanced_t *fb = (file_entry_enhanced_t *)b;
+static void grid_tile_event_cb(lv_event_t *e) {
+    lv_event_code_t code = lv_event_get_code(e);
+    lv_obj_t *tile = lv_event_get_current_target(e);
+    grid_tile_t *state = lv_obj_get_user_data(tile);
+    if (!state) {
+        return;
+    }
     
-    // Directories first
-    if (fa->is_directory && !fb->is_directory) return -1;
-    if (!fa->is_directory && fb->is_directory) return 1;
+    if (code == LV_EVENT_CLICKED) {
+        gui_file_browser_v2_activate_item(state->item);
+    } else if (code == LV_EVENT_DELETE) {
+        grid_tile_release(state);
+        lv_image_set_src(lv_obj_get_child(tile, TILE_CHILD_IMAGE), NULL);
+        lv_obj_set_user_data(tile, NULL);
+        heap_caps_free(state->pixels);
+        free(state);
+    }
+}
+
+static void grid_row_create_cb(lv_obj_t *row, void *user_data) {
+    (void)user_data;
+    lv_obj_set_style_bg_opa(row, LV_OPA_TRANSP, 0);
+    lv_obj_set_style_border_width(row, 0, 0);
+    lv_obj_set_style_pad_all(row, 0, 0);
     
-    launcher_config_t *config = config_manager_get_current();
-    int result = strcasecmp(fa->name, fb->name);
-    return config->file_browser.sort_ascending ? result : -result;
+    for (uint32_t c = 0; c < GRID_COLUMNS; c++) {
+        grid_tile_t *state = calloc(1, sizeof(grid_tile_t));
+        if (!state) {
+            ESP_LOGE(TAG, "Failed to allocate grid tile");
+            return;
+        }
+        state->entry = UINT32_MAX;
+        
+        lv_obj_t *tile = lv_obj_create(row);
+        lv_obj_set_size(tile, GRID_TILE_WIDTH, GRID_TILE_HEIGHT);
+        lv_obj_set_pos(tile, (int32_t)c * (GRID_TILE_WIDTH + GRID_TILE_GAP), 0);
+        lv_obj_set_style_bg_color(tile, lv_color_hex(0x2a2a2a), 0);
+        lv_obj_set_style_border_width(tile, 1, 0);
+        lv_obj_set_style_border_color(tile, lv_color_hex(0x404040), 0);
+        lv_obj_set_style_radius(tile, 5, 0);
+        lv_obj_set_style_pad_all(tile, 6, 0);
+        lv_obj_remove_flag(tile, LV_OBJ_FLAG_SCROLLABLE);
+        lv_obj_add_flag(tile, LV_OBJ_FLAG_CLICKABLE);
+        lv_obj_set_user_data(tile, state);
+        lv_obj_add_event_cb(tile, grid_tile_event_cb, LV_EVENT_ALL, NULL);
+        
+        // Thumbnail (hidden until one arrives)
+        lv_obj_t *image = lv_image_create(tile);
+        lv_obj_align(image, LV_ALIGN_TOP_MID, 0, 0);
+        lv_obj_add_flag(image, LV_OBJ_FLAG_HIDDEN);
+        
+        // Type icon, shown in place of a thumbnail
+        lv_obj_t *icon = lv_label_create(tile);
+        lv_obj_set_style_text_font(icon, THEME_FONT_LARGE, 0);
+        lv_obj_align(icon, LV_ALIGN_TOP_MID, 0, THUMBNAIL_SIZE / 2 - 16);
+        
+        // File name
+        lv_obj_t *name = lv_label_create(tile);
+        lv_obj_set_width(name, lv_pct(100));
+        lv_label_set_long_mode(name, LV_LABEL_LONG_DOT);
+        lv_obj_set_style_text_align(name, LV_TEXT_ALIGN_CENTER, 0);
+        lv_obj_set_style_text_color(name, THEME_TEXT_COLOR, 0);
+        lv_obj_set_style_text_font(name, THEME_FONT_SMALL, 0);
+        lv_obj_align(name, LV_ALIGN_BOTTOM_MID, 0, 0);
+        
+        // Checkbox (only shown in multi-select mode)
+        lv_obj_t *checkbox = lv_checkbox_create(tile);
+        lv_checkbox_set_text(checkbox, "");
+        lv_obj_align(checkbox, LV_ALIGN_TOP_LEFT, 0, 0);
+        lv_obj_add_flag(checkbox, LV_OBJ_FLAG_HIDDEN);
+    }
 }
 
-static int compare_files_by_size(const void *a, const void *b) {
-    file_entry_enhanced_t *fa = (file_entry_enhanced_t *)a;
-    file_entry_enhanced_t *fb = (file_entry_enhanced_t *)b;
+static void grid_tile_bind(lv_obj_t *tile, uint32_t item) {
+    grid_tile_t *state = lv_obj_get_user_data(tile);
+    uint32_t idx = view_order[item];
+    const char *file_name = file_listing_name(&listing, idx);
+    bool is_directory = file_listing_is_dir(&listing, idx);
     
-    // Directories first
-    if (fa->is_directory && !fb->is_directory) return -1;
-    if (!fa->is_directory && fb->is_directory) return 1;
+    lv_obj_t *image = lv_obj_get_child(tile, TILE_CHILD_IMAGE);
+    lv_obj_t *icon = lv_obj_get_child(tile, TILE_CHILD_ICON);
+    lv_obj_t *name = lv_obj_get_child(tile, TILE_CHILD_NAME);
+    lv_obj_t *checkbox = lv_obj_get_child(tile, TILE_CHILD_CHECKBOX);
     
-    launcher_config_t *config = config_manager_get_current();
-    int result = (fa->size > fb->size) - (fa->size < fb->size);
-    return config->file_browser.sort_ascending ? result : -result;
+    state->item = item;
+    lv_obj_remove_flag(tile, LV_OBJ_FLAG_HIDDEN);
+    
+    if (browser_state.multi_select_mode) {
+        lv_obj_remove_flag(checkbox, LV_OBJ_FLAG_HIDDEN);
+        if (entry_selected(idx)) {
+            lv_obj_add_state(checkbox, LV_STATE_CHECKED);
+        } else {
+            lv_obj_clear_state(checkbox, LV_STATE_CHECKED);
+        }
+    } else {
+        lv_obj_add_flag(checkbox, LV_OBJ_FLAG_HIDDEN);
+    }
+    
+    // Same entry as before: keep the thumbnail it has or is waiting for
+    if (state->entry == idx && state->generation == grid_generation) {
+        return;
+    }
+    
+    // The tile moved on; whatever it was waiting for is no longer wanted
+    grid_tile_release(state);
+    state->entry = idx;
+    state->generation = grid_generation;
+    
+    lv_label_set_text(name, file_name);
+    lv_label_set_text(icon, gui_file_browser_v2_get_icon(file_name, is_directory));
+    lv_obj_set_style_text_color(icon, gui_file_browser_v2_get_color(file_name, is_directory), 0);
+    lv_obj_remove_flag(icon, LV_OBJ_FLAG_HIDDEN);
+    lv_obj_add_flag(image, LV_OBJ_FLAG_HIDDEN);
+    
+    if (!is_directory && thumbnail_is_supported(file_name)) {
+        char path[MAX_PATH_LENGTH];
+        int len = snprintf(path, sizeof(path), "%s/%s",
+                           strcmp(browser_state.current_path, "/") == 0 ? "" : browser_state.current_path,
+                           file_name);
+        if (len > 0 && len < (int)sizeof(path)) {
+            state->request = thumbnail_request(path, listing.size[idx], listing.mtime[idx]);
+        }
+    }
 }
 
-static int compare_files_by_date(const void *a, const void *b) {
-    file_entry_enhanced_t *fa = (file_entry_enhanced_t *)a;
-    file_entry_enhanced_t *fb = (file_entry_enhanced_t *)b;
+static void grid_row_bind_cb(lv_obj_t *row, uint32_t index, void *user_data) {
+    (void)user_data;
+    for (uint32_t c = 0; c < GRID_COLUMNS; c++) {
+        lv_obj_t *tile = lv_obj_get_child(row, c);
+        if (!tile || !lv_obj_get_user_data(tile)) {
+            continue;
+        }
+        uint32_t item = index * GRID_COLUMNS + c;
+        if (item < view_count) {
+            grid_tile_bind(tile, item);
+        } else {
+            // Past the end of the last row
+            grid_tile_release(lv_obj_get_user_data(tile));
+            lv_obj_add_flag(tile, LV_OBJ_FLAG_HIDDEN);
+        }
+    }
+}
+
+static lv_obj_t *find_grid_tile(uint32_t request_id) {
+    // Only the pooled rows exist, so this is a few dozen tiles at most
+    uint32_t rows = lv_obj_get_child_count(grid_container);
+    for (uint32_t r = 0; r < rows; r++) {
+        lv_obj_t *row = lv_obj_get_child(grid_container, r);
+        uint32_t tiles = lv_obj_get_child_count(row);
+        for (uint32_t c = 0; c < tiles; c++) {
+            lv_obj_t *tile = lv_obj_get_child(row, c);
+            grid_tile_t *state = lv_obj_get_user_data(tile);
+            if (state && state->request == request_id) {
+                return tile;
+            }
+        }
+    }
+    return NULL;
+}
+
+static void show_grid_thumbnail(lv_obj_t *tile, const thumbnail_t *thumb) {
+    grid_tile_t *state = lv_obj_get_user_data(tile);
+    state->request = 0;
+    if (thumb->width == 0) {
+        return; // Not decodable, the type icon stays
+    }
+    if (!state->pixels) {
+        state->pixels = heap_caps_malloc(THUMBNAIL_SIZE * THUMBNAIL_SIZE * sizeof(uint16_t), MALLOC_CAP_SPIRAM);
+        if (!state->pixels) {
+            return;
+        }
+    }
     
-    // Directories first
-    if (fa->is_directory && !fb->is_directory) return -1;
-    if (!fa->is_directory && fb->is_directory) return 1;
+    size_t bytes = (size_t)thumb->width * thumb->height * sizeof(uint16_t);
+    memcpy(state->pixels, thumb->pixels, bytes);
     
-    launcher_config_t *config = config_manager_get_current();
-    int result = (fa->modified_time > fb->modified_time) - (fa->modified_time < fb->modified_time);
-    return config->file_browser.sort_ascending ? result : -result;
+    // The descriptor is reused for every thumbnail the tile shows
+    lv_obj_t *image = lv_obj_get_child(tile, TILE_CHILD_IMAGE);
+    lv_image_cache_drop(&state->image);
+    memset(&state->image, 0, sizeof(state->image));
+    state->image.header.magic = LV_IMAGE_HEADER_MAGIC;
+    state->image.header.cf = LV_COLOR_FORMAT_RGB565;
+    state->image.header.w = thumb->width;
+    state->image.header.h = thumb->height;
+    state->image.header.stride = thumb->width * sizeof(uint16_t);
+    state->image.data_size = bytes;
+    state->image.data = (const uint8_t *)state->pixels;
+    lv_image_set_src(image, &state->image);
+    lv_obj_align(image, LV_ALIGN_TOP_MID, 0, (THUMBNAIL_SIZE - thumb->height) / 2);
+    lv_obj_remove_flag(image, LV_OBJ_FLAG_HIDDEN);
+    lv_obj_add_flag(lv_obj_get_child(tile, TILE_CHILD_ICON), LV_OBJ_FLAG_HIDDEN);
+}
+
+static void thumb_timer_cb(lv_timer_t *timer) {
+    (void)timer;
+    thumbnail_t thumb;
+    while (thumbnail_poll(&thumb)) {
+        // Results for tiles that have since moved on simply find no tile
+        lv_obj_t *tile = grid_container ? find_grid_tile(thumb.request_id) : NULL;
+        if (tile) {
+            show_grid_thumbnail(tile, &thumb);
+        }
+    }
 }
 
-static int compare_files_by_type(const void *a, const void *b) {
-    file_entry_enhanced_t *fa = (file_entry_enhanced_t *)a;
-    file_entry_enhanced_t *fb = (file_entry_enhanced_t *)b;
+static void update_page_label(void) {
+    char page_text[32];
+    snprintf(page_text, sizeof(page_text), "Page %d / %d", 
+             browser_state.current_page + 1, browser_state.total_pages);
+    lv_label_set_text(page_label, page_text);
+}
+
+static void file_list_scroll_event_cb(lv_event_t *e) {
+    (void)e;
+    int page = first_visible_item() / browser_state.items_per_page;
+    if (page != browser_state.current_page) {
+        browser_state.current_page = page;
+        update_page_label();
+        update_pagination_buttons();
+    }
+}
+
+static void create_file_list_items(void) {
+    // Rows are pooled by the virtual list; only the visible ones are rebound
+    set_list_count();
+    scroll_to_item(browser_state.current_page * browser_state.items_per_page);
     
-    // Directories first
-    if (fa->is_directory && !fb->is_directory) return -1;
-    if (!fa->is_directory && fb->is_directory) return 1;
+    lv_label_set_text(empty_label, filter_text[0] ? "No matching files" : "No files found");
+    if (view_count == 0 && !scan_in_progress) {
+        lv_obj_remove_flag(empty_label, LV_OBJ_FLAG_HIDDEN);
+    } else {
+        lv_obj_add_flag(empty_label, LV_OBJ_FLAG_HIDDEN);
+    }
     
-    // Get extensions
-    const char *ext_a = strrchr(fa->name, '.');
-    const char *ext_b = strrchr(fb->name, '.');
+    // Update info label
+    if (scan_in_progress) {
+        lv_label_set_text(info_label, "Scanning...");
+    } else {
+        int dir_count = view_dir_count;
+        int file_count = view_count - view_dir_count;
+        
+        char info_text[64];
+        if (filter_text[0]) {
+            snprintf(info_text, sizeof(info_text), "%d files, %d folders match", file_count, dir_count);
+        } else {
+            snprintf(info_text, sizeof(info_text), "%d files, %d folders", file_count, dir_count);
+        }
+        lv_label_set_text(info_label, info_text);
+    }
     
-    if (!ext_a) ext_a = "";
-    if (!ext_b) ext_b = "";
+    update_page_label();
+}
+
+static void update_pagination_buttons(void) {
+    // Enable/disable pagination buttons
+    if (browser_state.current_page == 0) {
+        lv_obj_add_state(prev_btn, LV_STATE_DISABLED);
+    } else {
+        lv_obj_clear_state(prev_btn, LV_STATE_DISABLED);
+    }
     
-    launcher_config_t *config = config_manager_get_current();
-    int result = strcasecmp(ext_a, ext_b);
-    if (result == 0) {
-        result = strcasecmp(fa->name, fb->name);
+    if (browser_state.current_page >= browser_state.total_pages - 1) {
+        lv_obj_add_state(next_btn, LV_STATE_DISABLED);
+    } else {
+        lv_obj_clear_state(next_btn, LV_STATE_DISABLED);
     }
-    return config->file_browser.sort_ascending ? result : -result;
 }
 
 const char* gui_file_browser_v2_get_icon(const char *filename, bool is_directory) {
@@ -594,9 +1091,9 @@ lv_color_t gui_file_browser_v2_get_color(const char *filename, bool is_directory
     return THEME_TEXT_COLOR;
 }
 
-void gui_file_browser_v2_format_size(size_t size, char *buffer, size_t buffer_size) {
+void gui_file_browser_v2_format_size(uint64_t size, char *buffer, size_t buffer_size) {
     if (size < 1024) {
-        snprintf(buffer, buffer_size, "%zu B", size);
+        snprintf(buffer, buffer_size, "%" PRIu64 " B", size);
     } else if (size < 1024 * 1024) {
         snprintf(buffer, buffer_size, "%.1f KB", size / 1024.0);
     } else if (size < 1024 * 1024 * 1024) {
@@ -643,7 +1140,8 @@ void gui_file_browser_v2_go_up(void) {
 void gui_file_browser_v2_next_page(void) {
     if (browser_state.current_page < browser_state.total_pages - 1) {
         browser_state.current_page++;
-        create_file_list_items();
+        scroll_to_item(browser_state.current_page * browser_state.items_per_page);
+        update_page_label();
         update_pagination_buttons();
     }
 }
@@ -651,17 +1149,48 @@ void gui_file_browser_v2_next_page(void) {
 void gui_file_browser_v2_prev_page(void) {
     if (browser_state.current_page > 0) {
         browser_state.current_page--;
-        create_file_list_items();
+        scroll_to_item(browser_state.current_page * browser_state.items_per_page);
+        update_page_label();
         update_pagination_buttons();
     }
 }
 
 void gui_file_browser_v2_set_multi_select(bool enable) {
     browser_state.multi_select_mode = enable;
-    if (enable && !browser_state.selected_items && file_cache_size > 0) {
-        browser_state.selected_items = calloc(file_cache_size, sizeof(bool));
+    refresh_list();
+}
+
+void gui_file_browser_v2_activate_item(uint32_t item) {
+    if (item >= view_count) {
+        return;
     }
-    create_file_list_items();
+    uint32_t idx = view_order[item];
+    const char *file_name = file_listing_name(&listing, idx);
+    
+    if (browser_state.multi_select_mode) {
+        if (grow_selection()) {
+            browser_state.selected_items[idx] = !browser_state.selected_items[idx];
+            // Rebinding updates the checkbox of whichever row or tile shows it
+            refresh_list();
+        }
+        return;
+    }
+    
+    if (file_listing_is_dir(&listing, idx)) {
+        char path[MAX_PATH_LENGTH];
+        int len = snprintf(path, sizeof(path), "%s/%s",
+                           strcmp(browser_state.current_path, "/") == 0 ? "" : browser_state.current_path,
+                           file_name);
+        if (len > 0 && len < (int)sizeof(path)) {
+            gui_file_browser_v2_navigate(path);
+        } else {
+            ESP_LOGW(TAG, "Path too long to open: %s", file_name);
+        }
+        return;
+    }
+    
+    browser_state.selected_index = (int)item;
+    ESP_LOGI(TAG, "Selected %s", file_name);
 }
 
 file_browser_state_t* gui_file_browser_v2_get_state(void) {
@@ -671,29 +1200,44 @@ file_browser_state_t* gui_file_browser_v2_get_state(void) {
 // Settings integration functions
 
 void gui_file_browser_v2_set_view_mode(int mode) {
+    bool was_grid = grid_view_active();
     current_view_mode = mode;
-    // For now, we only support list view, but store the setting
-    // Future implementation could switch between different layouts
-    if (file_browser_screen) {
-        create_file_list_items();
+    if (!file_browser_screen) {
+        return;
+    }
+    
+    if (was_grid == grid_view_active()) {
+        // List and detailed views share the rows, only their contents change
+        refresh_list();
+        return;
     }
+    
+    if (was_grid) {
+        reset_grid_thumbnails();
+        gui_virtual_list_set_count(grid_container, 0);
+        lv_obj_add_flag(grid_container, LV_OBJ_FLAG_HIDDEN);
+        lv_obj_remove_flag(file_container, LV_OBJ_FLAG_HIDDEN);
+    } else {
+        gui_virtual_list_set_count(file_container, 0);
+        lv_obj_add_flag(file_container, LV_OBJ_FLAG_HIDDEN);
+        lv_obj_remove_flag(grid_container, LV_OBJ_FLAG_HIDDEN);
+    }
+    create_file_list_items();
 }
 
 void gui_file_browser_v2_set_sort_mode(int mode, bool ascending) {
     current_sort_mode = mode;
     sort_ascending = ascending;
-    // Re-scan and sort the current directory
+    // Re-sort the entries already in memory
     if (file_browser_screen) {
-        scan_directory_enhanced(browser_state.current_path);
-        create_file_list_items();
+        rebuild_view();
     }
 }
 
 void gui_file_browser_v2_show_hidden_files(bool show) {
     show_hidden = show;
-    // Re-scan directory with new hidden file setting
+    // Hidden entries are already in the listing, only the view changes
     if (file_browser_screen) {
-        scan_directory_enhanced(browser_state.current_path);
-        create_file_list_items();
+        rebuild_view();
     }
 }
\ No newline at end of file
@@ -18,23 +18,10 @@ typedef struct {
     int total_files;
     int selected_index;
     bool multi_select_mode;
-    bool *selected_items;  // Array for multi-selection
+    bool *selected_items;  // Multi-selection marks, indexed by listing entry
     int items_per_page;
 } file_browser_state_t;
 
-// Enhanced file entry with more metadata
-typedef struct {
-    char name[256];
-    char display_name[MAX_FILENAME_DISPLAY + 4]; // +4 for "..."
-    bool is_directory;
-    size_t size;
-    uint32_t modified_time;
-    const char *icon;
-    lv_color_t color;
-    char size_str[32];  // Human readable size
-    char date_str[32];  // Human readable date
-} file_entry_enhanced_t;
-
 /**
  * @brief Create enhanced file browser screen
  * @return Pointer to the created screen object
@@ -74,6 +61,15 @@ void gui_file_browser_v2_prev_page(void);
  */
 void gui_file_browser_v2_set_multi_select(bool enable);
 
+/**
+ * @brief Act on a clicked item, from either the list or the grid view
+ * @param item View index of the item
+ *
+ * Toggles the item in multi-select mode, otherwise opens a directory or
+ * makes a file the selected one.
+ */
+void gui_file_browser_v2_activate_item(uint32_t item);
+
 /**
  * @brief Get selected files in multi-select mode
  * @param indices Array to store selected indices
@@ -134,7 +130,7 @@ lv_color_t gui_file_browser_v2_get_color(const char *filename, bool is_directory
  * @param buffer Buffer to store formatted string
  * @param buffer_size Size of buffer
  */
-void gui_file_browser_v2_format_size(size_t size, char *buffer, size_t buffer_size);
+void gui_file_browser_v2_format_size(uint64_t size, char *buffer, size_t buffer_size);
 
 /**
  * @brief Format timestamp to human readable string
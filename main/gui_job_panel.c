@@ -0,0 +1,355 @@
+#include "gui_job_panel.h"
+#include "gui_styles.h"
+#include "gui_file_browser_v2.h"
+#include "esp_log.h"
+#include <stdio.h>
+#include <string.h>
+#include <inttypes.h>
+
+static const char *TAG = "GUI_JOB_PANEL";
+
+#define JOB_ROW_HEIGHT 72
+#define JOB_ETA_MIN_MS 2000     // Rate is too noisy for an estimate before this
+
+// Child order inside a job row
+enum {
+    JOB_ROW_TITLE,
+    JOB_ROW_STATUS,
+    JOB_ROW_BAR,
+    JOB_ROW_CANCEL
+};
+
+static lv_obj_t *backdrop = NULL;
+static lv_obj_t *summary_label = NULL;
+static lv_obj_t *summary_bar = NULL;
+static lv_obj_t *job_rows[FILE_JOBS_MAX];
+static uint32_t row_job_ids[FILE_JOBS_MAX];
+static lv_timer_t *panel_timer = NULL;
+
+static bool job_active(const file_job_info_t *job) {
+    return job->state == FILE_JOB_QUEUED || job->state == FILE_JOB_RUNNING;
+}
+
+// Work done and total in the finest unit the job counts: bytes, then files, then items
+static void job_progress(const file_job_info_t *job, uint64_t *done, uint64_t *total) {
+    if (job->type == FILE_JOB_COPY && job->bytes_total > 0) {
+        *done = job->bytes_done;
+        *total = job->bytes_total;
+    } else if (job->files_total > 0) {
+        *done = job->files_done;
+        *total = job->files_total;
+    } else {
+        *done = job->items_done + job->items_failed + job->items_skipped;
+        *total = job->items_total;
+    }
+    if (*done > *total) {
+        *done = *total;
+    }
+}
+
+uint32_t gui_job_panel_percent(const file_job_info_t *job) {
+    if (!job_active(job)) {
+        return 100;
+    }
+    uint64_t done;
+    uint64_t total;
+    job_progress(job, &done, &total);
+    return total ? (uint32_t)(done * 100 / total) : 0;
+}
+
+static uint32_t aggregate_of(const file_job_info_t *jobs, uint32_t count, uint32_t *percent) {
+    uint32_t active = 0;
+    uint32_t sum = 0;
+    for (uint32_t i = 0; i < count; i++) {
+        if (job_active(&jobs[i])) {
+            sum += gui_job_panel_percent(&jobs[i]);
+            active++;
+        }
+    }
+    *percent = active ? sum / active : 100;
+    return active;
+}
+
+uint32_t gui_job_panel_aggregate(uint32_t *percent) {
+    file_job_info_t jobs[FILE_JOBS_MAX];
+    uint32_t count = file_jobs_snapshot(jobs, FILE_JOBS_MAX);
+    return aggregate_of(jobs, count, percent);
+}
+
+// Rate and cost of verification once a job has moved data, e.g. "  12.3 MB/s, verified +4%"
+static void format_result(const file_job_info_t *job, char *buffer, size_t size) {
+    int len = 0;
+    buffer[0] = '\0';
+    if (job->bytes_done > 0 && job->elapsed_ms > 0) {
+        len = snprintf(buffer, size, "  %.1f MB/s",
+                       (double)job->bytes_done / (1024.0 * 1024.0) / (job->elapsed_ms / 1000.0));
+    }
+    if (job->verify && len >= 0 && (size_t)len < size) {
+        snprintf(buffer + len, size - len, "%s%" PRIu32 " verified +%.0f%%", len ? ", " : "  ",
+                 job->files_verified, file_jobs_verify_overhead(job));
+    }
+}
+
+static void format_status(const file_job_info_t *job, char *buffer, size_t size) {
+    char result[48];
+    switch (job->state) {
+        case FILE_JOB_QUEUED:
+            snprintf(buffer, size, "Queued");
+            break;
+        case FILE_JOB_RUNNING: {
+            char amount[40];
+            if (job->type == FILE_JOB_COPY && job->bytes_total > 0) {
+                char done[16];
+                char total[16];
+                gui_file_browser_v2_format_size(job->bytes_done, done, sizeof(done));
+                gui_file_browser_v2_format_size(job->bytes_total, total, sizeof(total));
+                snprintf(amount, sizeof(amount), "%s / %s", done, total);
+            } else if (job->files_total > 0) {
+                snprintf(amount, sizeof(amount), "%" PRIu32 " / %" PRIu32 " files", job->files_done, job->files_total);
+            } else {
+                snprintf(amount, sizeof(amount), "%" PRIu32 " / %" PRIu32,
+                         job->items_done + job->items_failed + job->items_skipped, job->items_total);
+            }
+
+            // Time left at the average rate so far, once there is enough to go on
+            uint64_t done;
+            uint64_t total;
+            job_progress(job, &done, &total);
+            if (done > 0 && done < total && job->elapsed_ms >= JOB_ETA_MIN_MS) {
+                uint32_t left_s = (uint32_t)((uint64_t)job->elapsed_ms * (total - done) / done / 1000);
+                snprintf(buffer, size, "%s  (%s, %" PRIu32 ":%02" PRIu32 " left)", job->current, amount,
+                         left_s / 60, left_s % 60);
+            } else {
+                snprintf(buffer, size, "%s  (%s)", job->current, amount);
+            }
+            break;
+        }
+        case FILE_JOB_DONE:
+            format_result(job, result, sizeof(result));
+            if (job->items_skipped) {
+                snprintf(buffer, size, "Done: %" PRIu32 " items, %" PRIu32 " skipped%s",
+                         job->items_done, job->items_skipped, result);
+            } else {
+                snprintf(buffer, size, "Done: %" PRIu32 " items%s", job->items_done, result);
+            }
+            break;
+        case FILE_JOB_FAILED: {
+            if (job->out_of_space) {
+                char needed[16];
+                gui_file_browser_v2_format_size(job->bytes_total, needed, sizeof(needed));
+                snprintf(buffer, size, "Not enough free space (%s needed)", needed);
+                break;
+            }
+            // Name the first bad file; the rest are in the log
+            char first[FILE_JOBS_PATH_LEN];
+            format_result(job, result, sizeof(result));
+            if (job->files_failed > 0 && file_jobs_get_failure(job->id, 0, first, sizeof(first)) == ESP_OK) {
+                const char *name = strrchr(first, '/');
+                snprintf(buffer, size, "%" PRIu32 " files failed (%s)%s", job->files_failed,
+                         name ? name + 1 : first, result);
+            } else {
+                snprintf(buffer, size, "%" PRIu32 " failed, %" PRIu32 " done%s",
+                         job->items_failed, job->items_done, result);
+            }
+            break;
+        }
+        case FILE_JOB_CANCELLED:
+        default:
+            snprintf(buffer, size, "Cancelled after %" PRIu32 " items", job->items_done);
+            break;
+    }
+}
+
+static void refresh_panel(void) {
+    file_job_info_t jobs[FILE_JOBS_MAX];
+    uint32_t count = file_jobs_snapshot(jobs, FILE_JOBS_MAX);
+
+    uint32_t percent;
+    uint32_t active = aggregate_of(jobs, count, &percent);
+    if (active) {
+        lv_label_set_text_fmt(summary_label, "%" PRIu32 " active, %" PRIu32 "%%", active, percent);
+    } else {
+        lv_label_set_text(summary_label, count ? "All jobs finished" : "No jobs");
+    }
+    lv_bar_set_value(summary_bar, (int32_t)percent, LV_ANIM_OFF);
+
+    for (uint32_t i = 0; i < FILE_JOBS_MAX; i++) {
+        lv_obj_t *row = job_rows[i];
+        if (i >= count) {
+            row_job_ids[i] = 0;
+            lv_obj_add_flag(row, LV_OBJ_FLAG_HIDDEN);
+            continue;
+        }
+        const file_job_info_t *job = &jobs[i];
+        row_job_ids[i] = job->id;
+        lv_obj_remove_flag(row, LV_OBJ_FLAG_HIDDEN);
+
+        char status[128];
+        format_status(job, status, sizeof(status));
+        lv_label_set_text(lv_obj_get_child(row, JOB_ROW_TITLE), job->description);
+        lv_label_set_text(lv_obj_get_child(row, JOB_ROW_STATUS), status);
+        lv_obj_set_style_text_color(lv_obj_get_child(row, JOB_ROW_STATUS),
+                                    job->state == FILE_JOB_FAILED ? THEME_ERROR_COLOR : THEME_TEXT_MUTED, 0);
+        lv_bar_set_value(lv_obj_get_child(row, JOB_ROW_BAR), (int32_t)gui_job_panel_percent(job), LV_ANIM_OFF);
+
+        lv_obj_t *cancel_btn = lv_obj_get_child(row, JOB_ROW_CANCEL);
+        if (job_active(job)) {
+            lv_obj_remove_flag(cancel_btn, LV_OBJ_FLAG_HIDDEN);
+        } else {
+            lv_obj_add_flag(cancel_btn, LV_OBJ_FLAG_HIDDEN);
+        }
+    }
+}
+
+static void panel_timer_cb(lv_timer_t *timer) {
+    (void)timer;
+    refresh_panel();
+}
+
+static void cancel_button_event_handler(lv_event_t *e) {
+    uint32_t row = (uint32_t)(uintptr_t)lv_event_get_user_data(e);
+    if (row_job_ids[row] && file_jobs_cancel(row_job_ids[row]) == ESP_OK) {
+        ESP_LOGI(TAG, "Cancelling job %" PRIu32, row_job_ids[row]);
+    }
+    refresh_panel();
+}
+
+static void clear_button_event_handler(lv_event_t *e) {
+    (void)e;
+    file_jobs_clear_finished();
+    refresh_panel();
+}
+
+static void close_button_event_handler(lv_event_t *e) {
+    (void)e;
+    gui_job_panel_close();
+}
+
+static lv_obj_t* create_button(lv_obj_t *parent, const char *text) {
+    lv_obj_t *btn = lv_button_create(parent);
+    lv_obj_set_size(btn, 140, 45);
+    apply_button_style(btn);
+    lv_obj_t *label = lv_label_create(btn);
+    lv_label_set_text(label, text);
+    lv_obj_center(label);
+    return btn;
+}
+
+static lv_obj_t* create_job_row(lv_obj_t *parent, uint32_t index) {
+    lv_obj_t *row = lv_obj_create(parent);
+    lv_obj_set_size(row, lv_pct(100), JOB_ROW_HEIGHT);
+    apply_list_item_style(row);
+    lv_obj_remove_flag(row, LV_OBJ_FLAG_SCROLLABLE);
+
+    lv_obj_t *title = lv_label_create(row);
+    lv_label_set_long_mode(title, LV_LABEL_LONG_DOT);
+    lv_obj_set_width(title, lv_pct(60));
+    lv_obj_set_style_text_color(title, THEME_TEXT_COLOR, 0);
+    lv_obj_set_style_text_font(title, THEME_FONT_SMALL, 0);
+    lv_obj_align(title, LV_ALIGN_TOP_LEFT, 0, 0);
+
+    lv_obj_t *status = lv_label_create(row);
+    lv_label_set_long_mode(status, LV_LABEL_LONG_DOT);
+    lv_obj_set_width(status, lv_pct(60));
+    lv_obj_set_style_text_font(status, &lv_font_montserrat_14, 0);
+    lv_obj_align(status, LV_ALIGN_BOTTOM_LEFT, 0, 0);
+
+    lv_obj_t *bar = lv_bar_create(row);
+    lv_obj_set_size(bar, lv_pct(25), 14);
+    lv_obj_align(bar, LV_ALIGN_RIGHT_MID, -60, 0);
+    lv_bar_set_range(bar, 0, 100);
+    lv_obj_set_style_bg_color(bar, lv_color_hex(0x333333), LV_PART_MAIN);
+    lv_obj_set_style_bg_color(bar, THEME_PRIMARY_COLOR, LV_PART_INDICATOR);
+
+    lv_obj_t *cancel_btn = lv_button_create(row);
+    lv_obj_set_size(cancel_btn, 45, 45);
+    lv_obj_align(cancel_btn, LV_ALIGN_RIGHT_MID, 0, 0);
+    apply_button_style(cancel_btn);
+    lv_obj_add_event_cb(cancel_btn, cancel_button_event_handler, LV_EVENT_CLICKED, (void *)(uintptr_t)index);
+    lv_obj_t *cancel_label = lv_label_create(cancel_btn);
+    lv_label_set_text(cancel_label, LV_SYMBOL_CLOSE);
+    lv_obj_center(cancel_label);
+
+    return row;
+}
+
+void gui_job_panel_show(void) {
+    if (backdrop) {
+        refresh_panel();
+        return;
+    }
+
+    // Dims and blocks the screen underneath while the list is open
+    backdrop = lv_obj_create(lv_layer_top());
+    lv_obj_remove_style_all(backdrop);
+    lv_obj_set_size(backdrop, lv_pct(100), lv_pct(100));
+    lv_obj_set_style_bg_color(backdrop, THEME_BG_COLOR, 0);
+    lv_obj_set_style_bg_opa(backdrop, LV_OPA_60, 0);
+    lv_obj_add_flag(backdrop, LV_OBJ_FLAG_CLICKABLE);
+
+    lv_obj_t *box = lv_obj_create(backdrop);
+    lv_obj_set_size(box, lv_pct(80), lv_pct(80));
+    lv_obj_center(box);
+    lv_obj_set_style_bg_color(box, lv_color_hex(0x1a1a1a), 0);
+    lv_obj_set_style_border_color(box, THEME_PRIMARY_COLOR, 0);
+    lv_obj_set_style_border_width(box, 2, 0);
+    lv_obj_set_style_radius(box, 10, 0);
+    lv_obj_set_style_pad_all(box, 15, 0);
+    lv_obj_remove_flag(box, LV_OBJ_FLAG_SCROLLABLE);
+
+    lv_obj_t *title = lv_label_create(box);
+    lv_label_set_text(title, "File Jobs");
+    apply_title_style(title);
+    lv_obj_align(title, LV_ALIGN_TOP_LEFT, 0, 0);
+
+    lv_obj_t *close_btn = create_button(box, LV_SYMBOL_CLOSE " Close");
+    lv_obj_align(close_btn, LV_ALIGN_TOP_RIGHT, 0, 0);
+    lv_obj_add_event_cb(close_btn, close_button_event_handler, LV_EVENT_CLICKED, NULL);
+
+    lv_obj_t *clear_btn = create_button(box, LV_SYMBOL_TRASH " Clear");
+    lv_obj_align_to(clear_btn, close_btn, LV_ALIGN_OUT_LEFT_MID, -10, 0);
+    lv_obj_add_event_cb(clear_btn, clear_button_event_handler, LV_EVENT_CLICKED, NULL);
+
+    // Combined progress of everything still queued or running
+    summary_label = lv_label_create(box);
+    lv_obj_set_style_text_color(summary_label, THEME_TEXT_COLOR, 0);
+    lv_obj_set_style_text_font(summary_label, THEME_FONT_SMALL, 0);
+    lv_obj_align(summary_label, LV_ALIGN_TOP_LEFT, 0, 60);
+
+    summary_bar = lv_bar_create(box);
+    lv_obj_set_size(summary_bar, lv_pct(100), 16);
+    lv_obj_align(summary_bar, LV_ALIGN_TOP_LEFT, 0, 90);
+    lv_bar_set_range(summary_bar, 0, 100);
+    lv_obj_set_style_bg_color(summary_bar, lv_color_hex(0x333333), LV_PART_MAIN);
+    lv_obj_set_style_bg_color(summary_bar, THEME_PRIMARY_COLOR, LV_PART_INDICATOR);
+
+    lv_obj_t *list = lv_obj_create(box);
+    lv_obj_set_size(list, lv_pct(100), lv_pct(70));
+    lv_obj_align(list, LV_ALIGN_BOTTOM_MID, 0, 0);
+    apply_list_style(list);
+    lv_obj_set_flex_flow(list, LV_FLEX_FLOW_COLUMN);
+    lv_obj_set_style_pad_row(list, 6, 0);
+
+    for (uint32_t i = 0; i < FILE_JOBS_MAX; i++) {
+        job_rows[i] = create_job_row(list, i);
+    }
+
+    panel_timer = lv_timer_create(panel_timer_cb, FILE_JOBS_POLL_MS, NULL);
+    refresh_panel();
+}
+
+void gui_job_panel_close(void) {
+    if (!backdrop) {
+        return;
+    }
+    lv_timer_delete(panel_timer);
+    panel_timer = NULL;
+    lv_obj_delete(backdrop);
+    backdrop = NULL;
+    summary_label = NULL;
+    summary_bar = NULL;
+    for (uint32_t i = 0; i < FILE_JOBS_MAX; i++) {
+        job_rows[i] = NULL;
+        row_job_ids[i] = 0;
+    }
+}
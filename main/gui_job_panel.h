@@ -0,0 +1,37 @@
+#ifndef GUI_JOB_PANEL_H
+#define GUI_JOB_PANEL_H
+
+#include "lvgl.h"
+#include "file_jobs.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * @brief Open the job list over the active screen
+ *
+ * Shows every remembered file job with its progress and a cancel button,
+ * plus the combined progress of the unfinished ones. Updates itself until
+ * closed.
+ */
+void gui_job_panel_show(void);
+
+/**
+ * @brief Close the job list if it is open
+ */
+void gui_job_panel_close(void);
+
+/**
+ * @brief Progress of one job
+ * @param job Job snapshot
+ * @return 0-100; bytes for copies, items for moves and deletes
+ */
+uint32_t gui_job_panel_percent(const file_job_info_t *job);
+
+/**
+ * @brief Combined progress of the unfinished jobs
+ * @param percent Output average progress of queued and running jobs
+ * @return Number of unfinished jobs (0 means nothing is running)
+ */
+uint32_t gui_job_panel_aggregate(uint32_t *percent);
+
+#endif // GUI_JOB_PANEL_H
@@ -0,0 +1,279 @@
+#include "gui_screen_diagnostics.h"
+#include "gui_screen_tools.h"
+#include "gui_styles.h"
+#include "render_stats.h"
+#include "sd_manager.h"
+#include "listing_cache.h"
+#include "sd_diskio.h"
+#include "sd_io.h"
+#include "esp_log.h"
+#include <stdio.h>
+#include <inttypes.h>
+
+static const char *TAG = "GUI_DIAGNOSTICS";
+
+#define DIAG_REFRESH_MS 500
+
+lv_obj_t *diagnostics_screen = NULL;
+static lv_obj_t *summary_label = NULL;
+static lv_obj_t *status_label = NULL;
+static lv_obj_t *frame_bars[RENDER_STATS_HIST_BUCKETS];
+static lv_obj_t *flush_bars[RENDER_STATS_HIST_BUCKETS];
+static lv_obj_t *area_bars[RENDER_STATS_HIST_BUCKETS];
+static lv_timer_t *refresh_timer = NULL;
+
+// Forward declarations
+static void diag_back_button_event_handler(lv_event_t *e);
+static void diag_reset_button_event_handler(lv_event_t *e);
+static void diag_save_button_event_handler(lv_event_t *e);
+static void refresh_timer_cb(lv_timer_t *timer);
+
+static lv_obj_t* create_histogram(lv_obj_t *parent, const char *title, lv_obj_t **bars, bool area_labels) {
+    lv_obj_t *panel = lv_obj_create(parent);
+    lv_obj_set_size(panel, lv_pct(32), lv_pct(100));
+    lv_obj_set_style_bg_color(panel, lv_color_hex(0x1a1a1a), 0);
+    lv_obj_set_style_border_color(panel, THEME_PRIMARY_COLOR, 0);
+    lv_obj_set_style_border_width(panel, 1, 0);
+    lv_obj_set_style_pad_all(panel, 8, 0);
+    lv_obj_set_style_pad_row(panel, 4, 0);
+    lv_obj_set_flex_flow(panel, LV_FLEX_FLOW_COLUMN);
+    lv_obj_remove_flag(panel, LV_OBJ_FLAG_SCROLLABLE);
+
+    lv_obj_t *title_label = lv_label_create(panel);
+    lv_label_set_text(title_label, title);
+    lv_obj_set_style_text_color(title_label, THEME_TEXT_COLOR, 0);
+    lv_obj_set_style_text_font(title_label, THEME_FONT_SMALL, 0);
+
+    for (int i = 0; i < RENDER_STATS_HIST_BUCKETS; i++) {
+        lv_obj_t *row = lv_obj_create(panel);
+        lv_obj_set_size(row, lv_pct(100), 26);
+        lv_obj_set_style_bg_opa(row, LV_OPA_TRANSP, 0);
+        lv_obj_set_style_border_opa(row, LV_OPA_TRANSP, 0);
+        lv_obj_set_style_pad_all(row, 0, 0);
+        lv_obj_remove_flag(row, LV_OBJ_FLAG_SCROLLABLE);
+
+        lv_obj_t *bucket_label = lv_label_create(row);
+        lv_label_set_text(bucket_label, area_labels ? render_stats_area_bucket_label(i)
+                                                    : render_stats_time_bucket_label(i));
+        lv_obj_set_style_text_color(bucket_label, THEME_TEXT_MUTED, 0);
+        lv_obj_set_style_text_font(bucket_label, &lv_font_montserrat_14, 0);
+        lv_obj_align(bucket_label, LV_ALIGN_LEFT_MID, 0, 0);
+
+        bars[i] = lv_bar_create(row);
+        lv_obj_set_size(bars[i], lv_pct(65), 14);
+        lv_obj_align(bars[i], LV_ALIGN_RIGHT_MID, 0, 0);
+        lv_bar_set_range(bars[i], 0, 100);
+        lv_obj_set_style_bg_color(bars[i], lv_color_hex(0x333333), LV_PART_MAIN);
+        lv_obj_set_style_bg_color(bars[i], THEME_PRIMARY_COLOR, LV_PART_INDICATOR);
+    }
+
+    return panel;
+}
+
+static void update_histogram(lv_obj_t **bars, const uint32_t *hist, uint32_t total) {
+    for (int i = 0; i < RENDER_STATS_HIST_BUCKETS; i++) {
+        int32_t pct = total ? (int32_t)(((uint64_t)hist[i] * 100) / total) : 0;
+        lv_bar_set_value(bars[i], pct, LV_ANIM_OFF);
+    }
+}
+
+// Queue depth and wait of one class of card work, e.g. "bulk 1/4 queued, wait 3/120 ms"
+static int format_io_class(char *buf, size_t size, const sd_io_stats_t *io, sd_io_class_t io_class) {
+    const sd_io_class_stats_t *c = &io->classes[io_class];
+    uint32_t avg_ms = c->deferred ? (uint32_t)(c->wait_us / c->deferred / 1000) : 0;
+    return snprintf(buf, size, "%s %" PRIu32 "/%" PRIu32 " queued, wait %" PRIu32 "/%" PRIu32 " ms",
+                    sd_io_class_name(io_class), c->queued, c->max_queued, avg_ms, c->max_wait_us / 1000);
+}
+
+static void refresh_diagnostics(void) {
+    render_stats_t stats;
+    render_stats_get(&stats);
+
+    uint32_t avg_area_pct = stats.screen_area_px ?
+        (uint32_t)(((uint64_t)stats.avg_area_px * 100) / stats.screen_area_px) : 0;
+
+    listing_cache_stats_t cache;
+    listing_cache_get_stats(&cache);
+
+    char sectors[128] = "Sector cache: off";
+    sd_cache_stats_t sector_cache;
+    if (sd_diskio_get_cache_stats(&sector_cache) == ESP_OK) {
+        snprintf(sectors, sizeof(sectors),
+                 "Sector cache: FAT %" PRIu32 "%%, dir %" PRIu32 "%%, data %" PRIu32 "%% hits, "
+                 "%" PRIu32 " dirty, %" PRIu32 " written back",
+                 sd_cache_hit_percent(&sector_cache, SD_CACHE_POOL_FAT),
+                 sd_cache_hit_percent(&sector_cache, SD_CACHE_POOL_DIR),
+                 sd_cache_hit_percent(&sector_cache, SD_CACHE_POOL_DATA),
+                 sector_cache.dirty, sector_cache.writebacks);
+    }
+
+    sd_io_stats_t io;
+    sd_io_get_stats(&io);
+    char io_bulk[64];
+    char io_background[64];
+    format_io_class(io_bulk, sizeof(io_bulk), &io, SD_IO_BULK);
+    format_io_class(io_background, sizeof(io_background), &io, SD_IO_BACKGROUND);
+
+    char summary[768];
+    snprintf(summary, sizeof(summary),
+             "Frames: %" PRIu32 "\n"
+             "Frame time: last %" PRIu32 " us, avg %" PRIu32 " us, max %" PRIu32 " us\n"
+             "Flush time: last %" PRIu32 " us, avg %" PRIu32 " us, max %" PRIu32 " us\n"
+             "Area: last %" PRIu32 " px, avg %" PRIu32 " px (%" PRIu32 "%%), max %" PRIu32 " px\n"
+             "Objects: %" PRIu32 "\n"
+             "Listing cache: %" PRIu32 " hits, %" PRIu32 " misses (%" PRIu32 " stale), "
+             "%" PRIu32 " invalidated, %" PRIu32 " evicted, %" PRIu32 " dirs / %u KB\n%s\n"
+             "SD I/O: %" PRIu32 " interactive (%" PRIu32 " active), %s, %s",
+             stats.frame_count,
+             stats.last.frame_us, stats.avg_frame_us, stats.max_frame_us,
+             stats.last.flush_us, stats.avg_flush_us, stats.max_flush_us,
+             stats.last.area_px, stats.avg_area_px, avg_area_pct, stats.max_area_px,
+             stats.obj_count,
+             cache.hits, cache.misses, cache.stale, cache.invalidations, cache.evictions,
+             cache.entries, (unsigned)(cache.bytes / 1024), sectors,
+             io.classes[SD_IO_INTERACTIVE].requests, io.classes[SD_IO_INTERACTIVE].active,
+             io_bulk, io_background);
+    lv_label_set_text(summary_label, summary);
+
+    update_histogram(frame_bars, stats.frame_hist, stats.frame_count);
+    update_histogram(flush_bars, stats.flush_hist, stats.frame_count);
+    update_histogram(area_bars, stats.area_hist, stats.frame_count);
+}
+
+static void refresh_timer_cb(lv_timer_t *timer) {
+    (void)timer;
+    if (lv_screen_active() != diagnostics_screen) {
+        return;
+    }
+    refresh_diagnostics();
+}
+
+void create_diagnostics_screen(void) {
+    if (diagnostics_screen) {
+        return; // Already created
+    }
+
+    diagnostics_screen = lv_obj_create(NULL);
+    lv_obj_add_style(diagnostics_screen, &style_screen, LV_PART_MAIN | LV_STATE_DEFAULT);
+
+    // Create title bar
+    lv_obj_t *title_bar = lv_obj_create(diagnostics_screen);
+    lv_obj_set_size(title_bar, lv_pct(100), 60);
+    lv_obj_align(title_bar, LV_ALIGN_TOP_MID, 0, 0);
+    lv_obj_set_style_bg_color(title_bar, lv_color_hex(0x333333), 0);
+    lv_obj_set_style_border_opa(title_bar, LV_OPA_TRANSP, 0);
+    lv_obj_set_style_pad_all(title_bar, 10, 0);
+
+    // Back button
+    lv_obj_t *back_btn = lv_button_create(title_bar);
+    lv_obj_set_size(back_btn, 60, 40);
+    lv_obj_align(back_btn, LV_ALIGN_LEFT_MID, 0, 0);
+    apply_button_style(back_btn);
+    lv_obj_add_event_cb(back_btn, diag_back_button_event_handler, LV_EVENT_CLICKED, NULL);
+
+    lv_obj_t *back_label = lv_label_create(back_btn);
+    lv_label_set_text(back_label, LV_SYMBOL_LEFT);
+    lv_obj_center(back_label);
+
+    // Title
+    lv_obj_t *title_label = lv_label_create(title_bar);
+    lv_label_set_text(title_label, "Render Stats");
+    lv_obj_set_style_text_color(title_label, lv_color_hex(0xFFFFFF), 0);
+    lv_obj_set_style_text_font(title_label, &lv_font_montserrat_20, 0);
+    lv_obj_align(title_label, LV_ALIGN_CENTER, 0, 0);
+
+    // Save CSV button
+    lv_obj_t *save_btn = lv_button_create(title_bar);
+    lv_obj_set_size(save_btn, 100, 40);
+    lv_obj_align(save_btn, LV_ALIGN_RIGHT_MID, 0, 0);
+    apply_button_style(save_btn);
+    lv_obj_add_event_cb(save_btn, diag_save_button_event_handler, LV_EVENT_CLICKED, NULL);
+
+    lv_obj_t *save_label = lv_label_create(save_btn);
+    lv_label_set_text(save_label, LV_SYMBOL_SAVE " CSV");
+    lv_obj_center(save_label);
+
+    // Reset button
+    lv_obj_t *reset_btn = lv_button_create(title_bar);
+    lv_obj_set_size(reset_btn, 100, 40);
+    lv_obj_align(reset_btn, LV_ALIGN_RIGHT_MID, -110, 0);
+    apply_button_style(reset_btn);
+    lv_obj_add_event_cb(reset_btn, diag_reset_button_event_handler, LV_EVENT_CLICKED, NULL);
+
+    lv_obj_t *reset_label = lv_label_create(reset_btn);
+    lv_label_set_text(reset_label, LV_SYMBOL_REFRESH " Reset");
+    lv_obj_center(reset_label);
+
+    // Summary text
+    summary_label = lv_label_create(diagnostics_screen);
+    lv_obj_set_width(summary_label, lv_pct(95));
+    lv_obj_set_style_text_color(summary_label, THEME_TEXT_COLOR, 0);
+    lv_obj_set_style_text_font(summary_label, THEME_FONT_SMALL, 0);
+    lv_obj_align(summary_label, LV_ALIGN_TOP_MID, 0, 70);
+
+    // Histograms
+    lv_obj_t *hist_container = lv_obj_create(diagnostics_screen);
+    lv_obj_set_size(hist_container, lv_pct(95), lv_pct(55));
+    lv_obj_align(hist_container, LV_ALIGN_BOTTOM_MID, 0, -40);
+    lv_obj_set_style_bg_opa(hist_container, LV_OPA_TRANSP, 0);
+    lv_obj_set_style_border_opa(hist_container, LV_OPA_TRANSP, 0);
+    lv_obj_set_style_pad_all(hist_container, 0, 0);
+    lv_obj_set_flex_flow(hist_container, LV_FLEX_FLOW_ROW);
+    lv_obj_set_flex_align(hist_container, LV_FLEX_ALIGN_SPACE_BETWEEN, LV_FLEX_ALIGN_START, LV_FLEX_ALIGN_START);
+
+    create_histogram(hist_container, "Frame time", frame_bars, false);
+    create_histogram(hist_container, "Flush time", flush_bars, false);
+    create_histogram(hist_container, "Invalidated area", area_bars, true);
+
+    // Status line for CSV dump results
+    status_label = lv_label_create(diagnostics_screen);
+    lv_label_set_text(status_label, "");
+    lv_obj_set_style_text_color(status_label, THEME_TEXT_MUTED, 0);
+    lv_obj_set_style_text_font(status_label, &lv_font_montserrat_14, 0);
+    lv_obj_align(status_label, LV_ALIGN_BOTTOM_MID, 0, -10);
+
+    refresh_timer = lv_timer_create(refresh_timer_cb, DIAG_REFRESH_MS, NULL);
+    refresh_diagnostics();
+}
+
+void show_diagnostics_screen(void) {
+    if (!diagnostics_screen) {
+        create_diagnostics_screen();
+    }
+    refresh_diagnostics();
+    lv_screen_load(diagnostics_screen);
+}
+
+void diagnostics_screen_back(void) {
+    ESP_LOGI(TAG, "Returning to tools screen");
+    lv_screen_load(tools_screen);
+}
+
+// Event handlers
+static void diag_back_button_event_handler(lv_event_t *e) {
+    lv_event_code_t code = lv_event_get_code(e);
+    if (code == LV_EVENT_CLICKED) {
+        diagnostics_screen_back();
+    }
+}
+
+static void diag_reset_button_event_handler(lv_event_t *e) {
+    lv_event_code_t code = lv_event_get_code(e);
+    if (code == LV_EVENT_CLICKED) {
+        render_stats_reset();
+        lv_label_set_text(status_label, "Statistics reset");
+        refresh_diagnostics();
+    }
+}
+
+static void diag_save_button_event_handler(lv_event_t *e) {
+    lv_event_code_t code = lv_event_get_code(e);
+    if (code == LV_EVENT_CLICKED) {
+        esp_err_t ret = render_stats_dump_csv(RENDER_STATS_CSV_PATH);
+        if (ret == ESP_OK) {
+            lv_label_set_text(status_label, "Saved to " SD_MOUNT_POINT RENDER_STATS_CSV_PATH);
+        } else {
+            lv_label_set_text_fmt(status_label, "CSV dump failed: %s", esp_err_to_name(ret));
+        }
+    }
+}
@@ -0,0 +1,24 @@
+#ifndef GUI_SCREEN_DIAGNOSTICS_H
+#define GUI_SCREEN_DIAGNOSTICS_H
+
+#include "lvgl.h"
+
+// Diagnostics screen object
+extern lv_obj_t *diagnostics_screen;
+
+/**
+ * @brief Create render diagnostics screen
+ */
+void create_diagnostics_screen(void);
+
+/**
+ * @brief Show render diagnostics screen
+ */
+void show_diagnostics_screen(void);
+
+/**
+ * @brief Handle back navigation from diagnostics screen
+ */
+void diagnostics_screen_back(void);
+
+#endif // GUI_SCREEN_DIAGNOSTICS_H
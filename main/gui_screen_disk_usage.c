@@ -0,0 +1,306 @@
+#include "gui_screen_disk_usage.h"
+#include "gui_screen_tools.h"
+#include "gui_screens.h"
+#include "gui_state.h"
+#include "gui_styles.h"
+#include "gui_virtual_list.h"
+#include "gui_file_browser_v2.h"
+#include "file_index.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include <stdio.h>
+#include <string.h>
+#include <inttypes.h>
+
+static const char *TAG = "GUI_DISK_USAGE";
+
+#define USAGE_STATUS_MS    1000
+#define USAGE_ROW_HEIGHT   64
+#define USAGE_ROW_GAP      4
+#define USAGE_PATH_LEN     256
+
+// Child order inside a pooled usage row
+enum {
+    USAGE_CHILD_ICON,
+    USAGE_CHILD_NAME,
+    USAGE_CHILD_DETAIL,
+    USAGE_CHILD_BAR,
+    USAGE_CHILD_PERCENT
+};
+
+lv_obj_t *disk_usage_screen = NULL;
+static lv_obj_t *usage_path_label = NULL;
+static lv_obj_t *usage_status_label = NULL;
+static lv_obj_t *usage_list = NULL;
+static lv_timer_t *status_timer = NULL;
+
+// Directory being shown and what each of its entries holds
+static char usage_dir[USAGE_PATH_LEN] = "/";
+static file_index_usage_list_t usage = {0};
+static uint32_t last_usage_ms = 0;
+static file_index_state_t last_state = FILE_INDEX_OFFLINE;
+static uint32_t last_entries = 0;
+
+// Forward declarations
+static void usage_back_button_event_handler(lv_event_t *e);
+static void usage_row_event_handler(lv_event_t *e);
+static void status_timer_cb(lv_timer_t *timer);
+
+static const char* index_state_text(file_index_state_t state) {
+    switch (state) {
+        case FILE_INDEX_LOADING:   return "Loading index, totals are partial";
+        case FILE_INDEX_BUILDING:  return "Indexing card, totals are partial";
+        case FILE_INDEX_VERIFYING: return "Checking for changes";
+        case FILE_INDEX_READY:     return "Up to date";
+        case FILE_INDEX_OFFLINE:
+        default:                   return "No SD card";
+    }
+}
+
+static void update_header(void) {
+    char total[16];
+    gui_file_browser_v2_format_size(usage.total.bytes, total, sizeof(total));
+    lv_label_set_text_fmt(usage_path_label, "%s  -  %s in %" PRIu32 " files, %" PRIu32 " folders",
+                          usage_dir, total, usage.total.files, usage.total.folders);
+
+    file_index_status_t status;
+    file_index_get_status(&status);
+    last_state = status.state;
+    last_entries = status.entries;
+    lv_label_set_text_fmt(usage_status_label, "%s | %" PRIu32 " entries indexed | added up in %" PRIu32 " ms",
+                          index_state_text(status.state), status.entries, last_usage_ms);
+}
+
+static void load_usage(bool keep_scroll) {
+    file_index_note_open(usage_dir);
+    int64_t start = esp_timer_get_time();
+    esp_err_t ret = file_index_usage(usage_dir, &usage);
+    last_usage_ms = (uint32_t)((esp_timer_get_time() - start) / 1000);
+
+    if (ret == ESP_ERR_NOT_FOUND && strcmp(usage_dir, "/") != 0) {
+        // Gone since the last look: start again from the top
+        ESP_LOGW(TAG, "%s no longer indexed", usage_dir);
+        strcpy(usage_dir, "/");
+        ret = file_index_usage(usage_dir, &usage);
+    }
+    if (ret != ESP_OK && ret != ESP_ERR_INVALID_STATE) {
+        ESP_LOGE(TAG, "Failed to add up %s: %s", usage_dir, esp_err_to_name(ret));
+    }
+
+    gui_virtual_list_set_count(usage_list, usage.entries.count);
+    if (keep_scroll) {
+        gui_virtual_list_refresh(usage_list);
+    } else {
+        gui_virtual_list_scroll_to(usage_list, 0);
+    }
+    update_header();
+}
+
+static void usage_row_create_cb(lv_obj_t *row, void *user_data) {
+    (void)user_data;
+    lv_obj_set_style_bg_color(row, lv_color_hex(0x2a2a2a), 0);
+    lv_obj_set_style_border_opa(row, LV_OPA_TRANSP, 0);
+    lv_obj_set_style_radius(row, 6, 0);
+    lv_obj_set_style_pad_all(row, 6, 0);
+    lv_obj_add_flag(row, LV_OBJ_FLAG_CLICKABLE);
+    // Short click drills down; CLICKED would also follow a long press
+    lv_obj_add_event_cb(row, usage_row_event_handler, LV_EVENT_SHORT_CLICKED, NULL);
+    lv_obj_add_event_cb(row, usage_row_event_handler, LV_EVENT_LONG_PRESSED, NULL);
+
+    lv_obj_t *icon = lv_label_create(row);
+    lv_obj_set_style_text_font(icon, &lv_font_montserrat_20, 0);
+    lv_obj_align(icon, LV_ALIGN_LEFT_MID, 4, 0);
+
+    lv_obj_t *name = lv_label_create(row);
+    lv_label_set_long_mode(name, LV_LABEL_LONG_DOT);
+    lv_obj_set_width(name, lv_pct(55));
+    lv_obj_set_style_text_color(name, THEME_TEXT_COLOR, 0);
+    lv_obj_align(name, LV_ALIGN_TOP_LEFT, 40, 0);
+
+    lv_obj_t *detail = lv_label_create(row);
+    lv_label_set_long_mode(detail, LV_LABEL_LONG_DOT);
+    lv_obj_set_width(detail, lv_pct(55));
+    lv_obj_set_style_text_color(detail, THEME_TEXT_MUTED, 0);
+    lv_obj_set_style_text_font(detail, &lv_font_montserrat_14, 0);
+    lv_obj_align(detail, LV_ALIGN_BOTTOM_LEFT, 40, 0);
+
+    // Share of the folder being shown
+    lv_obj_t *bar = lv_bar_create(row);
+    lv_obj_set_size(bar, lv_pct(25), 12);
+    lv_bar_set_range(bar, 0, 1000);
+    lv_obj_align(bar, LV_ALIGN_RIGHT_MID, -70, 0);
+
+    lv_obj_t *percent = lv_label_create(row);
+    lv_obj_set_width(percent, 60);
+    lv_obj_set_style_text_color(percent, THEME_TEXT_COLOR, 0);
+    lv_obj_set_style_text_align(percent, LV_TEXT_ALIGN_RIGHT, 0);
+    lv_obj_align(percent, LV_ALIGN_RIGHT_MID, 0, 0);
+}
+
+static void usage_row_bind_cb(lv_obj_t *row, uint32_t index, void *user_data) {
+    (void)user_data;
+    const file_index_usage_t *entry = &usage.usage[index];
+    bool is_directory = file_listing_is_dir(&usage.entries, index);
+
+    char size[16];
+    char detail[64];
+    gui_file_browser_v2_format_size(entry->bytes, size, sizeof(size));
+    if (is_directory) {
+        snprintf(detail, sizeof(detail), "%s  -  %" PRIu32 " files, %" PRIu32 " folders",
+                 size, entry->files, entry->folders);
+    } else {
+        snprintf(detail, sizeof(detail), "%s", size);
+    }
+    uint32_t permille = usage.total.bytes ? (uint32_t)(entry->bytes * 1000 / usage.total.bytes) : 0;
+
+    lv_label_set_text(lv_obj_get_child(row, USAGE_CHILD_ICON), is_directory ? LV_SYMBOL_DIRECTORY : LV_SYMBOL_FILE);
+    lv_label_set_text(lv_obj_get_child(row, USAGE_CHILD_NAME), file_listing_name(&usage.entries, index));
+    lv_label_set_text(lv_obj_get_child(row, USAGE_CHILD_DETAIL), detail);
+    lv_bar_set_value(lv_obj_get_child(row, USAGE_CHILD_BAR), (int32_t)permille, LV_ANIM_OFF);
+    lv_label_set_text_fmt(lv_obj_get_child(row, USAGE_CHILD_PERCENT), "%" PRIu32 ".%" PRIu32 "%%",
+                          permille / 10, permille % 10);
+}
+
+static void status_timer_cb(lv_timer_t *timer) {
+    (void)timer;
+    if (lv_screen_active() != disk_usage_screen) {
+        return;
+    }
+    // Totals grow while the index fills in; once it settles they only change with it
+    file_index_status_t status;
+    file_index_get_status(&status);
+    if (status.state != FILE_INDEX_READY || status.state != last_state || status.entries != last_entries) {
+        load_usage(true);
+    }
+}
+
+void create_disk_usage_screen(void) {
+    if (disk_usage_screen) {
+        return; // Already created
+    }
+
+    disk_usage_screen = lv_obj_create(NULL);
+    lv_obj_add_style(disk_usage_screen, &style_screen, LV_PART_MAIN | LV_STATE_DEFAULT);
+
+    // Create title bar
+    lv_obj_t *title_bar = lv_obj_create(disk_usage_screen);
+    lv_obj_set_size(title_bar, lv_pct(100), 60);
+    lv_obj_align(title_bar, LV_ALIGN_TOP_MID, 0, 0);
+    lv_obj_set_style_bg_color(title_bar, lv_color_hex(0x333333), 0);
+    lv_obj_set_style_border_opa(title_bar, LV_OPA_TRANSP, 0);
+    lv_obj_set_style_pad_all(title_bar, 10, 0);
+
+    // Back button: up one folder, then out to the tools screen
+    lv_obj_t *back_btn = lv_button_create(title_bar);
+    lv_obj_set_size(back_btn, 60, 40);
+    lv_obj_align(back_btn, LV_ALIGN_LEFT_MID, 0, 0);
+    apply_button_style(back_btn);
+    lv_obj_add_event_cb(back_btn, usage_back_button_event_handler, LV_EVENT_CLICKED, NULL);
+
+    lv_obj_t *back_label = lv_label_create(back_btn);
+    lv_label_set_text(back_label, LV_SYMBOL_LEFT);
+    lv_obj_center(back_label);
+
+    // Title
+    lv_obj_t *title_label = lv_label_create(title_bar);
+    lv_label_set_text(title_label, "Disk Usage");
+    lv_obj_set_style_text_color(title_label, lv_color_hex(0xFFFFFF), 0);
+    lv_obj_set_style_text_font(title_label, &lv_font_montserrat_20, 0);
+    lv_obj_align(title_label, LV_ALIGN_LEFT_MID, 80, 0);
+
+    // Folder being shown and its totals
+    usage_path_label = lv_label_create(disk_usage_screen);
+    lv_obj_set_width(usage_path_label, lv_pct(95));
+    lv_label_set_long_mode(usage_path_label, LV_LABEL_LONG_DOT);
+    lv_obj_set_style_text_color(usage_path_label, THEME_TEXT_COLOR, 0);
+    lv_obj_align(usage_path_label, LV_ALIGN_TOP_MID, 0, 68);
+
+    // Index state and how long the totals took
+    usage_status_label = lv_label_create(disk_usage_screen);
+    lv_obj_set_width(usage_status_label, lv_pct(95));
+    lv_label_set_long_mode(usage_status_label, LV_LABEL_LONG_DOT);
+    lv_obj_set_style_text_color(usage_status_label, THEME_TEXT_MUTED, 0);
+    lv_obj_set_style_text_font(usage_status_label, &lv_font_montserrat_14, 0);
+    lv_obj_align(usage_status_label, LV_ALIGN_TOP_MID, 0, 94);
+
+    // Entries, biggest first, rows recycled as the list scrolls
+    usage_list = gui_virtual_list_create(disk_usage_screen, USAGE_ROW_HEIGHT, USAGE_ROW_GAP,
+                                         usage_row_create_cb, usage_row_bind_cb, NULL);
+    lv_obj_set_size(usage_list, lv_pct(95), lv_pct(78));
+    lv_obj_align(usage_list, LV_ALIGN_BOTTOM_MID, 0, -10);
+    lv_obj_set_style_bg_color(usage_list, lv_color_hex(0x1a1a1a), 0);
+    lv_obj_set_style_border_color(usage_list, THEME_PRIMARY_COLOR, 0);
+    lv_obj_set_style_border_width(usage_list, 1, 0);
+    lv_obj_set_style_pad_all(usage_list, 8, 0);
+
+    status_timer = lv_timer_create(status_timer_cb, USAGE_STATUS_MS, NULL);
+}
+
+void show_disk_usage_screen(void) {
+    if (!disk_usage_screen) {
+        create_disk_usage_screen();
+    }
+    strcpy(usage_dir, "/");
+    load_usage(false);
+    lv_screen_load(disk_usage_screen);
+}
+
+void disk_usage_screen_back(void) {
+    if (strcmp(usage_dir, "/") != 0) {
+        char *last_slash = strrchr(usage_dir, '/');
+        if (last_slash == usage_dir) {
+            usage_dir[1] = '\0';
+        } else if (last_slash) {
+            *last_slash = '\0';
+        }
+        load_usage(false);
+        return;
+    }
+
+    ESP_LOGI(TAG, "Returning to tools screen");
+    // Totals for a whole card can be large; they are rebuilt on the next visit
+    file_index_usage_free(&usage);
+    lv_screen_load(tools_screen);
+}
+
+// Event handlers
+static void usage_back_button_event_handler(lv_event_t *e) {
+    lv_event_code_t code = lv_event_get_code(e);
+    if (code == LV_EVENT_CLICKED) {
+        disk_usage_screen_back();
+    }
+}
+
+static void usage_row_event_handler(lv_event_t *e) {
+    lv_event_code_t code = lv_event_get_code(e);
+    uint32_t index = gui_virtual_list_get_index(lv_event_get_current_target(e));
+    if (index >= usage.entries.count) {
+        return;
+    }
+    bool is_directory = file_listing_is_dir(&usage.entries, index);
+
+    char target[USAGE_PATH_LEN];
+    int len = snprintf(target, sizeof(target), "%s/%s", strcmp(usage_dir, "/") == 0 ? "" : usage_dir,
+                       file_listing_name(&usage.entries, index));
+    if (len < 0 || (size_t)len >= sizeof(target)) {
+        ESP_LOGW(TAG, "Path too long under %s", usage_dir);
+        return;
+    }
+
+    if (code == LV_EVENT_SHORT_CLICKED && is_directory) {
+        // Drill down
+        strcpy(usage_dir, target);
+        load_usage(false);
+    } else if (code == LV_EVENT_LONG_PRESSED) {
+        // Open the folder itself, or the folder holding the file
+        const char *open_dir = is_directory ? target : usage_dir;
+        if (strlen(open_dir) >= sizeof(current_directory)) {
+            return;
+        }
+        ESP_LOGI(TAG, "Opening %s in file manager", open_dir);
+        strcpy(current_directory, open_dir);
+        update_file_manager_screen();
+        update_file_list();
+        lv_screen_load(file_manager_screen);
+    }
+}
@@ -0,0 +1,24 @@
+#ifndef GUI_SCREEN_DISK_USAGE_H
+#define GUI_SCREEN_DISK_USAGE_H
+
+#include "lvgl.h"
+
+// Disk usage screen object
+extern lv_obj_t *disk_usage_screen;
+
+/**
+ * @brief Create disk usage screen
+ */
+void create_disk_usage_screen(void);
+
+/**
+ * @brief Show disk usage screen at the card root
+ */
+void show_disk_usage_screen(void);
+
+/**
+ * @brief Handle back navigation from disk usage screen (up one folder, then tools)
+ */
+void disk_usage_screen_back(void);
+
+#endif // GUI_SCREEN_DISK_USAGE_H
@@ -5,8 +5,17 @@
 #include "gui_status_bar.h"
 #include "sd_manager.h"
 #include "file_operations.h"
+#include "file_jobs.h"
+#include "gui_job_panel.h"
+#include "gui_virtual_list.h"
+#include "dir_scanner.h"
+#include "listing_cache.h"
+#include "file_index.h"
+#include "sd_space.h"
 #include "esp_log.h"
+#include <stdio.h>
 #include <string.h>
+#include <inttypes.h>
 
 static const char *TAG = "GUI_FILE_MGR";
 
@@ -14,15 +23,106 @@ lv_obj_t *file_manager_screen = NULL;
 lv_obj_t *file_list = NULL;
 lv_obj_t *current_path_label = NULL;
 static lv_obj_t *mount_button_label = NULL;
+static lv_obj_t *file_list_message = NULL;
+static lv_obj_t *scan_spinner = NULL;
+static lv_obj_t *free_space_label = NULL;
+
+// Background scan feeding current_listing
+static uint32_t scan_id = 0;
+static lv_timer_t *scan_timer = NULL;
 static gui_status_bar_t *status_bar = NULL;
 
 // Toolbar button references
 static lv_obj_t *select_btn = NULL;
+static lv_obj_t *select_all_btn = NULL;
 static lv_obj_t *delete_btn = NULL;
 static lv_obj_t *copy_btn = NULL;
 static lv_obj_t *move_btn = NULL;
 static lv_obj_t *rename_btn = NULL;
 static lv_obj_t *paste_btn = NULL;
+static lv_obj_t *jobs_btn_label = NULL;
+
+// Background file jobs: progress on the Jobs button, reload when one ends
+static lv_timer_t *jobs_timer = NULL;
+static uint32_t jobs_seen_finished = 0;
+static int32_t jobs_shown_percent = -1;
+
+// Row geometry for the recycled file list
+#define FILE_LIST_ROW_HEIGHT 50
+#define FILE_LIST_ROW_GAP    4
+
+// Child order inside a pooled row
+enum {
+    FILE_ROW_ICON,
+    FILE_ROW_NAME,
+    FILE_ROW_CHECKBOX
+};
+
+static void file_list_row_create_cb(lv_obj_t *row, void *user_data) {
+    (void)user_data;
+    apply_list_item_style(row);
+    lv_obj_add_flag(row, LV_OBJ_FLAG_CLICKABLE);
+    lv_obj_add_event_cb(row, file_list_event_handler, LV_EVENT_CLICKED, NULL);
+    lv_obj_add_event_cb(row, file_list_event_handler, LV_EVENT_LONG_PRESSED, NULL);
+    
+    lv_obj_t *icon = lv_label_create(row);
+    lv_obj_align(icon, LV_ALIGN_LEFT_MID, 0, 0);
+    
+    lv_obj_t *name = lv_label_create(row);
+    lv_label_set_long_mode(name, LV_LABEL_LONG_DOT);
+    lv_obj_set_width(name, lv_pct(80));
+    lv_obj_align(name, LV_ALIGN_LEFT_MID, 35, 0);
+    
+    lv_obj_t *checkbox = lv_checkbox_create(row);
+    lv_checkbox_set_text(checkbox, "");
+    lv_obj_align(checkbox, LV_ALIGN_RIGHT_MID, -10, 0);
+    lv_obj_set_size(checkbox, 30, 30);
+    lv_obj_add_flag(checkbox, LV_OBJ_FLAG_HIDDEN);
+    lv_obj_add_event_cb(checkbox, file_selection_event_handler, LV_EVENT_VALUE_CHANGED, NULL);
+}
+
+static void file_list_row_bind_cb(lv_obj_t *row, uint32_t index, void *user_data) {
+    (void)user_data;
+    bool is_directory = file_listing_is_dir(&current_listing, index);
+    bool selected = file_selection_enabled && selection_set_test(&selected_files, index);
+    
+    lv_obj_t *icon = lv_obj_get_child(row, FILE_ROW_ICON);
+    lv_obj_t *name = lv_obj_get_child(row, FILE_ROW_NAME);
+    lv_obj_t *checkbox = lv_obj_get_child(row, FILE_ROW_CHECKBOX);
+    
+    lv_label_set_text(icon, is_directory ? LV_SYMBOL_DIRECTORY : LV_SYMBOL_FILE);
+    lv_label_set_text(name, file_listing_name(&current_listing, index));
+    
+    // If selection mode is enabled, show the checkbox
+    if (file_selection_enabled) {
+        lv_obj_remove_flag(checkbox, LV_OBJ_FLAG_HIDDEN);
+        if (selected) {
+            lv_obj_add_state(checkbox, LV_STATE_CHECKED);
+        } else {
+            lv_obj_remove_state(checkbox, LV_STATE_CHECKED);
+        }
+    } else {
+        lv_obj_add_flag(checkbox, LV_OBJ_FLAG_HIDDEN);
+    }
+    
+    // Highlight selected items
+    if (selected) {
+        lv_obj_set_style_bg_color(row, lv_color_hex(0x333333), 0);
+        lv_obj_set_style_bg_opa(row, LV_OPA_50, 0);
+    } else {
+        lv_obj_remove_local_style_prop(row, LV_STYLE_BG_COLOR, 0);
+        lv_obj_remove_local_style_prop(row, LV_STYLE_BG_OPA, 0);
+    }
+    
+    if (is_directory) {
+        lv_obj_set_style_text_color(row, lv_color_hex(0x00ffff), 0);
+    } else {
+        lv_obj_set_style_text_color(row, THEME_TEXT_COLOR, 0);
+    }
+}
+
+static void scan_timer_cb(lv_timer_t *timer);
+static void jobs_timer_cb(lv_timer_t *timer);
 
 void create_file_manager_screen(void) {
     file_manager_screen = lv_obj_create(NULL);
@@ -63,6 +163,13 @@ void create_file_manager_screen(void) {
     lv_label_set_text(up_label, LV_SYMBOL_UP " Up");
     lv_obj_center(up_label);
     
+    // Free space, filled in by the jobs timer once it is known
+    free_space_label = lv_label_create(center_container);
+    lv_label_set_text(free_space_label, "");
+    lv_obj_set_style_text_color(free_space_label, THEME_TEXT_MUTED, 0);
+    lv_obj_set_style_text_font(free_space_label, THEME_FONT_NORMAL, 0);
+    lv_obj_align(free_space_label, LV_ALIGN_TOP_LEFT, 445, 65);
+    
     // Back button
     lv_obj_t *back_btn = lv_button_create(center_container);
     lv_obj_set_size(back_btn, 100, 50);
@@ -120,6 +227,16 @@ void create_file_manager_screen(void) {
     lv_obj_center(select_btn_label);
     lv_obj_add_event_cb(select_btn, toggle_selection_mode_event_handler, LV_EVENT_CLICKED, NULL);
     
+    // Select all button (long press inverts the selection)
+    select_all_btn = lv_button_create(toolbar);
+    lv_obj_set_size(select_all_btn, 80, 35);
+    apply_button_style(select_all_btn);
+    lv_obj_t *select_all_btn_label = lv_label_create(select_all_btn);
+    lv_label_set_text(select_all_btn_label, LV_SYMBOL_LIST " All");
+    lv_obj_center(select_all_btn_label);
+    lv_obj_add_event_cb(select_all_btn, select_all_event_handler, LV_EVENT_CLICKED, NULL);
+    lv_obj_add_event_cb(select_all_btn, select_all_event_handler, LV_EVENT_LONG_PRESSED, NULL);
+    
     // Create file button
     lv_obj_t *new_file_btn = lv_button_create(toolbar);
     lv_obj_set_size(new_file_btn, 80, 35);
@@ -180,13 +297,46 @@ void create_file_manager_screen(void) {
     lv_label_set_text(paste_btn_label, LV_SYMBOL_PASTE " Paste");
     lv_obj_center(paste_btn_label);
     lv_obj_add_event_cb(paste_btn, paste_files_event_handler, LV_EVENT_CLICKED, NULL);
-    
-    // Native LVGL list for files (adjusted position)
-    file_list = lv_list_create(center_container);
+    lv_obj_add_event_cb(paste_btn, paste_files_event_handler, LV_EVENT_LONG_PRESSED, NULL);
+    
+    // Jobs button (shows overall progress while copies, moves or deletes run)
+    lv_obj_t *jobs_btn = lv_button_create(toolbar);
+    lv_obj_set_size(jobs_btn, 80, 35);
+    apply_button_style(jobs_btn);
+    jobs_btn_label = lv_label_create(jobs_btn);
+    lv_label_set_text(jobs_btn_label, LV_SYMBOL_LOOP " Jobs");
+    lv_obj_center(jobs_btn_label);
+    lv_obj_add_event_cb(jobs_btn, file_jobs_event_handler, LV_EVENT_CLICKED, NULL);
+    jobs_shown_percent = -1;
+    
+    // Recycled-row list for files (adjusted position)
+    file_list = gui_virtual_list_create(center_container, FILE_LIST_ROW_HEIGHT, FILE_LIST_ROW_GAP,
+                                        file_list_row_create_cb, file_list_row_bind_cb, NULL);
     lv_obj_set_size(file_list, lv_pct(95), lv_pct(60));
     lv_obj_align(file_list, LV_ALIGN_BOTTOM_MID, 0, -10);
     apply_list_style(file_list);
     
+    // Shown instead of rows when there is nothing to list
+    file_list_message = lv_label_create(center_container);
+    lv_label_set_text(file_list_message, "");
+    lv_obj_align_to(file_list_message, file_list, LV_ALIGN_TOP_MID, 0, 20);
+    lv_obj_add_flag(file_list_message, LV_OBJ_FLAG_HIDDEN);
+    
+    // Shown while the directory is being scanned
+    scan_spinner = lv_spinner_create(center_container);
+    lv_obj_set_size(scan_spinner, 40, 40);
+    lv_obj_align_to(scan_spinner, file_list, LV_ALIGN_TOP_RIGHT, -15, 15);
+    lv_obj_add_flag(scan_spinner, LV_OBJ_FLAG_HIDDEN);
+    
+    if (!scan_timer) {
+        scan_timer = lv_timer_create(scan_timer_cb, DIR_SCANNER_POLL_MS, NULL);
+        lv_timer_pause(scan_timer);
+    }
+    if (!jobs_timer) {
+        jobs_seen_finished = file_jobs_finished_count();
+        jobs_timer = lv_timer_create(jobs_timer_cb, FILE_JOBS_POLL_MS, NULL);
+    }
+    
     // Initialize toolbar button states (disabled by default)
     update_toolbar_button_states();
 }
@@ -200,10 +350,110 @@ void update_file_manager_status_bar(float voltage, float current_ma, bool chargi
     }
 }
 
-void update_file_list(void) {
-    // Clear existing items
-    lv_obj_clean(file_list);
+static void show_file_list_message(const char *text, lv_color_t color) {
+    gui_virtual_list_set_count(file_list, 0);
+    lv_label_set_text_fmt(file_list_message, LV_SYMBOL_WARNING " %s", text);
+    lv_obj_set_style_text_color(file_list_message, color, 0);
+    lv_obj_remove_flag(file_list_message, LV_OBJ_FLAG_HIDDEN);
+}
+
+static void stop_scan(void) {
+    lv_timer_pause(scan_timer);
+    lv_obj_add_flag(scan_spinner, LV_OBJ_FLAG_HIDDEN);
+}
+
+// Show every entry current_listing holds so far; false if the selection could not cover them all
+static bool show_current_entries(void) {
+    bool covered = selection_set_resize(&selected_files, current_listing.count) == ESP_OK;
+    if (!covered) {
+        // Out of memory: only list the entries that can be selected
+        ESP_LOGE(TAG, "Out of memory, listing truncated at %" PRIu32 " entries", selected_files.size);
+    }
+    if (selected_files.size > 0) {
+        lv_obj_add_flag(file_list_message, LV_OBJ_FLAG_HIDDEN);
+    }
+    gui_virtual_list_set_count(file_list, selected_files.size);
+    return covered;
+}
+
+static void finish_file_list(bool failed) {
+    stop_scan();
+    lv_label_set_text(current_path_label, current_directory);
+    if (failed && current_listing.count == 0) {
+        show_file_list_message("Failed to read directory", THEME_ERROR_COLOR);
+    } else if (current_listing.count == 0) {
+        show_file_list_message("No files found", THEME_WARNING_COLOR);
+    }
+    
+    // Update toolbar button states after refreshing file list
+    update_toolbar_button_states();
+}
+
+static void scan_timer_cb(lv_timer_t *timer) {
+    (void)timer;
+    dir_scan_state_t state = dir_scanner_poll(scan_id, &current_listing, DIR_SCANNER_POLL_BATCH);
+    if (state == DIR_SCAN_CANCELLED) {
+        stop_scan();
+        return;
+    }
     
+    if (!show_current_entries()) {
+        dir_scanner_cancel();
+        finish_file_list(true);
+        return;
+    }
+    if (state == DIR_SCAN_RUNNING) {
+        lv_label_set_text_fmt(current_path_label, "%s  (%" PRIu32 "...)", current_directory, current_listing.count);
+        return;
+    }
+    
+    if (state == DIR_SCAN_DONE) {
+        listing_cache_store(current_directory, true, &current_listing);
+    }
+    finish_file_list(state == DIR_SCAN_FAILED);
+}
+
+// Reads the cached count, cheap enough to poll; the label is only touched when its text
+// changes, compared against the label itself so a recreated label is filled in again
+static void update_free_space_label(void) {
+    char text[48];
+    uint64_t free_bytes;
+    uint64_t total_bytes;
+    if (sd_space_get(&free_bytes, &total_bytes) == ESP_OK) {
+        const double gb = 1024.0 * 1024.0 * 1024.0;
+        snprintf(text, sizeof(text), "%.1f GB free of %.1f GB", (double)free_bytes / gb, (double)total_bytes / gb);
+    } else {
+        snprintf(text, sizeof(text), "%s", sd_manager_is_mounted() ? "Counting free space..." : "");
+    }
+    if (strcmp(text, lv_label_get_text(free_space_label)) != 0) {
+        lv_label_set_text(free_space_label, text);
+    }
+}
+
+static void jobs_timer_cb(lv_timer_t *timer) {
+    (void)timer;
+    update_free_space_label();
+    uint32_t percent;
+    int32_t shown = gui_job_panel_aggregate(&percent) ? (int32_t)percent : -1;
+    if (shown != jobs_shown_percent) {
+        jobs_shown_percent = shown;
+        if (shown >= 0) {
+            lv_label_set_text_fmt(jobs_btn_label, LV_SYMBOL_LOOP " %" PRId32 "%%", shown);
+        } else {
+            lv_label_set_text(jobs_btn_label, LV_SYMBOL_LOOP " Jobs");
+        }
+    }
+    
+    // A finished job changed the card; reload once the user is not picking entries
+    uint32_t finished = file_jobs_finished_count();
+    if (finished != jobs_seen_finished && !file_selection_enabled &&
+        lv_screen_active() == file_manager_screen) {
+        jobs_seen_finished = finished;
+        update_file_list();
+    }
+}
+
+void update_file_list(void) {
     // Update path label
     lv_label_set_text(current_path_label, current_directory);
     
@@ -217,83 +467,50 @@ void update_file_list(void) {
         }
     }
     
+    file_listing_clear(&current_listing);
+    selection_set_resize(&selected_files, 0);
+    gui_virtual_list_set_count(file_list, 0);
+    
     if (!sd_manager_is_mounted()) {
-        lv_obj_t *item = lv_list_add_button(file_list, LV_SYMBOL_WARNING, "SD Card not mounted");
-        lv_obj_set_style_text_color(item, THEME_ERROR_COLOR, 0);
+        dir_scanner_cancel();
+        stop_scan();
+        show_file_list_message("SD Card not mounted", THEME_ERROR_COLOR);
         return;
     }
+    file_index_note_open(current_directory);
     
-    file_entry_t entries[32];
-    int count = sd_manager_scan_directory(current_directory, entries, 32, true); // Show hidden files by default
-    
-    // Update global current_entries for navigation
-    current_entry_count = count;
-    if (count > 0) {
-        memcpy(current_entries, entries, count * sizeof(file_entry_t));
-    }
-    
-    if (count <= 0) {
-        lv_obj_t *item = lv_list_add_button(file_list, LV_SYMBOL_WARNING, "No files found");
-        lv_obj_set_style_text_color(item, THEME_WARNING_COLOR, 0);
+    // Directories seen before come straight from the cache, without touching the card
+    if (listing_cache_lookup(current_directory, true, &current_listing)) {
+        dir_scanner_cancel();
+        bool shown = show_current_entries();
+        finish_file_list(!shown);
         return;
     }
     
-    for (int i = 0; i < count; i++) {
-        const char *icon = entries[i].is_directory ? LV_SYMBOL_DIRECTORY : LV_SYMBOL_FILE;
-        
-        // Truncate filename if too long
-        char truncated_name[200];
-        if (strlen(entries[i].name) > 190) {
-            strncpy(truncated_name, entries[i].name, 187);
-            truncated_name[187] = '\0';
-            strcat(truncated_name, "...");
-        } else {
-            strcpy(truncated_name, entries[i].name);
-        }
-        
-        // Create the list item
-        lv_obj_t *item = lv_list_add_button(file_list, icon, truncated_name);
-        apply_list_item_style(item);
-        
-        // If selection mode is enabled, add a checkbox
-        if (file_selection_enabled) {
-            lv_obj_t *checkbox = lv_checkbox_create(item);
-            lv_checkbox_set_text(checkbox, "");
-            lv_obj_align(checkbox, LV_ALIGN_RIGHT_MID, -10, 0);
-            lv_obj_set_size(checkbox, 30, 30);
-            
-            // Set checkbox state based on selection
-            if (selected_files[i]) {
-                lv_obj_add_state(checkbox, LV_STATE_CHECKED);
-            }
-            
-            // Add event handler for checkbox toggle
-            lv_obj_add_event_cb(checkbox, file_selection_event_handler, LV_EVENT_VALUE_CHANGED, (void*)(uintptr_t)i);
-        }
-        
-        lv_obj_add_event_cb(item, file_list_event_handler, LV_EVENT_CLICKED, (void*)(uintptr_t)i);
-        
-        // Highlight selected items
-        if (file_selection_enabled && selected_files[i]) {
-            lv_obj_set_style_bg_color(item, lv_color_hex(0x333333), 0);
-            lv_obj_set_style_bg_opa(item, LV_OPA_50, 0);
-        }
-        
-        if (entries[i].is_directory) {
-            lv_obj_set_style_text_color(item, lv_color_hex(0x00ffff), 0);
-        } else {
-            lv_obj_set_style_text_color(item, THEME_TEXT_COLOR, 0);
-        }
+    // Scanned on the worker task and streamed in by scan_timer_cb
+    scan_id = dir_scanner_start(current_directory, true); // Show hidden files by default
+    if (scan_id == 0) {
+        stop_scan();
+        show_file_list_message("Failed to read directory", THEME_ERROR_COLOR);
+        return;
     }
-    
-    // Update toolbar button states after refreshing file list
+    lv_obj_add_flag(file_list_message, LV_OBJ_FLAG_HIDDEN);
+    lv_obj_remove_flag(scan_spinner, LV_OBJ_FLAG_HIDDEN);
+    lv_timer_resume(scan_timer);
+    update_toolbar_button_states();
+}
+
+void refresh_file_list_rows(void) {
+    gui_virtual_list_refresh(file_list);
     update_toolbar_button_states();
 }
 
 void update_toolbar_button_states(void) {
+    uint32_t selected_count = selection_set_count(&selected_files);
+    
     // Update button states based on selection
     if (rename_btn) {
-        if (selected_file_count > 1) {
+        if (selected_count > 1) {
             // Disable rename button when multiple files are selected
             lv_obj_add_state(rename_btn, LV_STATE_DISABLED);
             lv_obj_set_style_bg_color(rename_btn, lv_color_hex(0x666666), LV_STATE_DISABLED);
@@ -304,7 +521,16 @@ void update_toolbar_button_states(void) {
     }
     
     // Enable/disable other operation buttons based on selection
-    bool has_selection = selected_file_count > 0;
+    bool has_selection = selected_count > 0;
+    
+    if (select_all_btn) {
+        if (file_selection_enabled && selected_files.size > 0) {
+            lv_obj_remove_state(select_all_btn, LV_STATE_DISABLED);
+        } else {
+            lv_obj_add_state(select_all_btn, LV_STATE_DISABLED);
+            lv_obj_set_style_bg_color(select_all_btn, lv_color_hex(0x666666), LV_STATE_DISABLED);
+        }
+    }
     
     if (delete_btn) {
         if (has_selection) {
@@ -335,7 +561,7 @@ void update_toolbar_button_states(void) {
     
     // Enable/disable paste button based on clipboard content
     if (paste_btn) {
-        if (clipboard_has_content) {
+        if (file_ops_clipboard_has_content()) {
             lv_obj_remove_state(paste_btn, LV_STATE_DISABLED);
         } else {
             lv_obj_add_state(paste_btn, LV_STATE_DISABLED);
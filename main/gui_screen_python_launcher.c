@@ -1,5 +1,6 @@
 #include "gui_screen_python_launcher.h"
 #include "gui_screens.h"
+#include "gui_screen_tools.h"
 #include "gui_events.h"
 #include "gui_styles.h"
 #include "sd_manager.h"
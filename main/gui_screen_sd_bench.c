@@ -0,0 +1,375 @@
+#include "gui_screen_sd_bench.h"
+#include "gui_screen_tools.h"
+#include "gui_styles.h"
+#include "sd_bench.h"
+#include "sd_manager.h"
+#include "listing_cache.h"
+#include "file_jobs.h"
+#include "esp_log.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include <stdio.h>
+#include <string.h>
+#include <inttypes.h>
+
+static const char *TAG = "GUI_SD_BENCH";
+
+#define SD_BENCH_REFRESH_MS     250
+#define SD_BENCH_TASK_STACK     4096
+#define SD_BENCH_TASK_PRIORITY  5
+
+lv_obj_t *sd_bench_screen = NULL;
+static lv_obj_t *mount_label = NULL;
+static lv_obj_t *results_table = NULL;
+static lv_obj_t *progress_bar = NULL;
+static lv_obj_t *status_label = NULL;
+static lv_obj_t *run_label = NULL;
+static lv_timer_t *refresh_timer = NULL;
+
+/*
+ * The benchmark runs on a one-shot task on CPU1. Finished results are copied
+ * into the shared array under bench_mutex and picked up by the refresh timer,
+ * so LVGL is only ever touched from the UI task.
+ */
+static portMUX_TYPE bench_mutex = portMUX_INITIALIZER_UNLOCKED;
+static sd_bench_result_t shared_results[SD_BENCH_MAX_RESULTS];
+static uint32_t shared_done = 0;
+static uint32_t shared_total = 0;
+static bool bench_running = false;
+static esp_err_t bench_ret = ESP_OK;
+static volatile bool bench_cancel = false;
+
+// Owned by the UI task
+static sd_bench_result_t results[SD_BENCH_MAX_RESULTS];
+static uint32_t results_shown = 0;
+static bool result_reported = true;
+static sd_bench_mount_t mount;
+static bool mount_valid = false;
+
+// Forward declarations
+static void sd_bench_back_button_event_handler(lv_event_t *e);
+static void sd_bench_run_button_event_handler(lv_event_t *e);
+static void sd_bench_save_button_event_handler(lv_event_t *e);
+static void refresh_timer_cb(lv_timer_t *timer);
+
+static void bench_progress_cb(const sd_bench_result_t *result, uint32_t index, uint32_t total, void *user_data) {
+    (void)user_data;
+    portENTER_CRITICAL(&bench_mutex);
+    shared_results[index - 1] = *result;
+    shared_done = index;
+    shared_total = total;
+    portEXIT_CRITICAL(&bench_mutex);
+}
+
+static void sd_bench_task(void *arg) {
+    sd_bench_config_t *config = (sd_bench_config_t *)arg;
+    static sd_bench_result_t task_results[SD_BENCH_MAX_RESULTS];
+    uint32_t count = 0;
+
+    esp_err_t ret = sd_bench_run(config, task_results, &count, bench_progress_cb, NULL);
+    // The scratch file came and went behind sd_manager's back
+    listing_cache_invalidate_parent("/" SD_BENCH_FILE_NAME);
+
+    portENTER_CRITICAL(&bench_mutex);
+    bench_ret = ret;
+    bench_running = false;
+    portEXIT_CRITICAL(&bench_mutex);
+    vTaskDelete(NULL);
+}
+
+static void update_mount_label(void) {
+    mount_valid = sd_bench_get_mount(SD_MOUNT_POINT, &mount) == ESP_OK;
+    if (!mount_valid) {
+        lv_label_set_text(mount_label, "No SD card mounted");
+        return;
+    }
+    lv_label_set_text_fmt(mount_label,
+                          "Card %s, %" PRIu32 "-bit @ %" PRIu32 " kHz, %s, %" PRIu32 " KB clusters, %" PRIu32 " MB",
+                          mount.card[0] ? mount.card : "?", mount.bus_width, mount.freq_khz,
+                          mount.fs[0] ? mount.fs : "?", mount.cluster_size / 1024,
+                          (uint32_t)(mount.capacity / (1024 * 1024)));
+}
+
+static void clear_results(void) {
+    lv_table_set_row_count(results_table, 1);
+    results_shown = 0;
+}
+
+static void add_result_row(const sd_bench_result_t *r) {
+    uint32_t row = results_shown + 1;
+    uint32_t avg_us = r->ops ? (uint32_t)(r->elapsed_us / r->ops) : 0;
+    lv_table_set_row_count(results_table, row + 1);
+    lv_table_set_cell_value(results_table, row, 0, sd_bench_api_name(r->api));
+    lv_table_set_cell_value(results_table, row, 1, sd_bench_test_name(r->test));
+    lv_table_set_cell_value_fmt(results_table, row, 2, "%" PRIu32 "K", r->block_size / 1024);
+    lv_table_set_cell_value_fmt(results_table, row, 3, "%.2f", sd_bench_mb_per_s(r));
+    lv_table_set_cell_value_fmt(results_table, row, 4, "%" PRIu32, sd_bench_iops(r));
+    lv_table_set_cell_value_fmt(results_table, row, 5, "%" PRIu32, avg_us);
+    lv_table_set_cell_value_fmt(results_table, row, 6, "%" PRIu32 "%s", r->max_op_us, r->err == ESP_OK ? "" : " !");
+    results_shown++;
+}
+
+static void refresh_timer_cb(lv_timer_t *timer) {
+    (void)timer;
+    if (lv_screen_active() != sd_bench_screen) {
+        return;
+    }
+
+    uint32_t done, total;
+    bool running;
+    esp_err_t ret;
+    portENTER_CRITICAL(&bench_mutex);
+    done = shared_done;
+    total = shared_total;
+    running = bench_running;
+    ret = bench_ret;
+    if (done > results_shown) {
+        memcpy(&results[results_shown], &shared_results[results_shown],
+               (done - results_shown) * sizeof(sd_bench_result_t));
+    }
+    portEXIT_CRITICAL(&bench_mutex);
+
+    while (results_shown < done) {
+        add_result_row(&results[results_shown]);
+    }
+    if (total) {
+        lv_bar_set_value(progress_bar, (int32_t)(done * 100 / total), LV_ANIM_OFF);
+    }
+
+    if (running) {
+        lv_label_set_text_fmt(status_label, "%s: test %" PRIu32 " of %" PRIu32,
+                              bench_cancel ? "Stopping" : "Running", done < total ? done + 1 : total, total);
+    } else if (!result_reported) {
+        result_reported = true;
+        lv_label_set_text(run_label, LV_SYMBOL_PLAY " Run");
+        if (ret == ESP_OK) {
+            lv_label_set_text_fmt(status_label, "Finished %" PRIu32 " tests", done);
+        } else if (ret == ESP_ERR_INVALID_STATE) {
+            lv_label_set_text_fmt(status_label, "Stopped after %" PRIu32 " tests", done);
+        } else {
+            lv_label_set_text_fmt(status_label, "Benchmark failed: %s", esp_err_to_name(ret));
+        }
+    }
+}
+
+static void start_benchmark(void) {
+    if (!sd_manager_is_mounted()) {
+        lv_label_set_text(status_label, "No SD card mounted");
+        return;
+    }
+    if (file_jobs_busy()) {
+        lv_label_set_text(status_label, "Wait for file jobs to finish first");
+        return;
+    }
+
+    // Must outlive this call; only one run at a time uses it
+    static sd_bench_config_t config = SD_BENCH_CONFIG_DEFAULT();
+    static char fatfs_dir[4];
+    snprintf(fatfs_dir, sizeof(fatfs_dir), "%s", sd_manager_get_fatfs_drive());
+    config.dir = SD_MOUNT_POINT;
+    config.fatfs_dir = fatfs_dir[0] ? fatfs_dir : NULL;
+    config.cancel = &bench_cancel;
+
+    portENTER_CRITICAL(&bench_mutex);
+    shared_done = 0;
+    shared_total = sd_bench_test_count(&config);
+    bench_ret = ESP_OK;
+    bench_running = true;
+    portEXIT_CRITICAL(&bench_mutex);
+    bench_cancel = false;
+
+    // Pinned to CPU1 like the other long-running workers, away from LVGL
+    BaseType_t result = xTaskCreatePinnedToCore(sd_bench_task, "sd_bench", SD_BENCH_TASK_STACK,
+                                                &config, SD_BENCH_TASK_PRIORITY, NULL, 1);
+    if (result != pdPASS) {
+        ESP_LOGE(TAG, "Failed to create benchmark task");
+        portENTER_CRITICAL(&bench_mutex);
+        bench_running = false;
+        portEXIT_CRITICAL(&bench_mutex);
+        lv_label_set_text(status_label, "Could not start benchmark");
+        return;
+    }
+
+    ESP_LOGI(TAG, "Benchmark started");
+    update_mount_label();
+    clear_results();
+    lv_bar_set_value(progress_bar, 0, LV_ANIM_OFF);
+    lv_label_set_text(run_label, LV_SYMBOL_STOP " Stop");
+    result_reported = false;
+}
+
+static bool benchmark_running(void) {
+    portENTER_CRITICAL(&bench_mutex);
+    bool running = bench_running;
+    portEXIT_CRITICAL(&bench_mutex);
+    return running;
+}
+
+void create_sd_bench_screen(void) {
+    if (sd_bench_screen) {
+        return; // Already created
+    }
+
+    sd_bench_screen = lv_obj_create(NULL);
+    lv_obj_add_style(sd_bench_screen, &style_screen, LV_PART_MAIN | LV_STATE_DEFAULT);
+
+    // Create title bar
+    lv_obj_t *title_bar = lv_obj_create(sd_bench_screen);
+    lv_obj_set_size(title_bar, lv_pct(100), 60);
+    lv_obj_align(title_bar, LV_ALIGN_TOP_MID, 0, 0);
+    lv_obj_set_style_bg_color(title_bar, lv_color_hex(0x333333), 0);
+    lv_obj_set_style_border_opa(title_bar, LV_OPA_TRANSP, 0);
+    lv_obj_set_style_pad_all(title_bar, 10, 0);
+
+    // Back button
+    lv_obj_t *back_btn = lv_button_create(title_bar);
+    lv_obj_set_size(back_btn, 60, 40);
+    lv_obj_align(back_btn, LV_ALIGN_LEFT_MID, 0, 0);
+    apply_button_style(back_btn);
+    lv_obj_add_event_cb(back_btn, sd_bench_back_button_event_handler, LV_EVENT_CLICKED, NULL);
+
+    lv_obj_t *back_label = lv_label_create(back_btn);
+    lv_label_set_text(back_label, LV_SYMBOL_LEFT);
+    lv_obj_center(back_label);
+
+    // Title
+    lv_obj_t *title_label = lv_label_create(title_bar);
+    lv_label_set_text(title_label, "SD Benchmark");
+    lv_obj_set_style_text_color(title_label, lv_color_hex(0xFFFFFF), 0);
+    lv_obj_set_style_text_font(title_label, &lv_font_montserrat_20, 0);
+    lv_obj_align(title_label, LV_ALIGN_CENTER, 0, 0);
+
+    // Save CSV button
+    lv_obj_t *save_btn = lv_button_create(title_bar);
+    lv_obj_set_size(save_btn, 100, 40);
+    lv_obj_align(save_btn, LV_ALIGN_RIGHT_MID, 0, 0);
+    apply_button_style(save_btn);
+    lv_obj_add_event_cb(save_btn, sd_bench_save_button_event_handler, LV_EVENT_CLICKED, NULL);
+
+    lv_obj_t *save_label = lv_label_create(save_btn);
+    lv_label_set_text(save_label, LV_SYMBOL_SAVE " CSV");
+    lv_obj_center(save_label);
+
+    // Run / stop button
+    lv_obj_t *run_btn = lv_button_create(title_bar);
+    lv_obj_set_size(run_btn, 100, 40);
+    lv_obj_align(run_btn, LV_ALIGN_RIGHT_MID, -110, 0);
+    apply_button_style(run_btn);
+    lv_obj_add_event_cb(run_btn, sd_bench_run_button_event_handler, LV_EVENT_CLICKED, NULL);
+
+    run_label = lv_label_create(run_btn);
+    lv_label_set_text(run_label, LV_SYMBOL_PLAY " Run");
+    lv_obj_center(run_label);
+
+    // Mount parameters
+    mount_label = lv_label_create(sd_bench_screen);
+    lv_obj_set_width(mount_label, lv_pct(95));
+    lv_obj_set_style_text_color(mount_label, THEME_TEXT_COLOR, 0);
+    lv_obj_set_style_text_font(mount_label, THEME_FONT_SMALL, 0);
+    lv_obj_align(mount_label, LV_ALIGN_TOP_MID, 0, 70);
+
+    // Results, one row per test; scrolls once the run outgrows the screen
+    static const char *headers[] = { "API", "Test", "Block", "MB/s", "IOPS", "Avg us", "Max us" };
+    static const int32_t widths[] = { 120, 160, 100, 120, 120, 120, 120 };
+    results_table = lv_table_create(sd_bench_screen);
+    lv_obj_set_size(results_table, lv_pct(95), lv_pct(65));
+    lv_obj_align(results_table, LV_ALIGN_TOP_MID, 0, 105);
+    lv_obj_set_style_bg_color(results_table, lv_color_hex(0x1a1a1a), LV_PART_MAIN);
+    lv_obj_set_style_bg_color(results_table, lv_color_hex(0x1a1a1a), LV_PART_ITEMS);
+    lv_obj_set_style_text_color(results_table, THEME_TEXT_COLOR, LV_PART_ITEMS);
+    lv_obj_set_style_text_font(results_table, &lv_font_montserrat_14, LV_PART_ITEMS);
+    lv_table_set_column_count(results_table, sizeof(headers) / sizeof(headers[0]));
+    for (uint32_t i = 0; i < sizeof(headers) / sizeof(headers[0]); i++) {
+        lv_table_set_column_width(results_table, i, widths[i]);
+        lv_table_set_cell_value(results_table, 0, i, headers[i]);
+    }
+    clear_results();
+
+    // Progress over the whole run
+    progress_bar = lv_bar_create(sd_bench_screen);
+    lv_obj_set_size(progress_bar, lv_pct(95), 14);
+    lv_obj_align(progress_bar, LV_ALIGN_BOTTOM_MID, 0, -40);
+    lv_bar_set_range(progress_bar, 0, 100);
+    lv_obj_set_style_bg_color(progress_bar, lv_color_hex(0x333333), LV_PART_MAIN);
+    lv_obj_set_style_bg_color(progress_bar, THEME_PRIMARY_COLOR, LV_PART_INDICATOR);
+
+    // Status line for run and CSV results
+    status_label = lv_label_create(sd_bench_screen);
+    lv_label_set_text(status_label, "Writes and reads " SD_MOUNT_POINT "/" SD_BENCH_FILE_NAME ", then removes it");
+    lv_obj_set_style_text_color(status_label, THEME_TEXT_MUTED, 0);
+    lv_obj_set_style_text_font(status_label, &lv_font_montserrat_14, 0);
+    lv_obj_align(status_label, LV_ALIGN_BOTTOM_MID, 0, -10);
+
+    refresh_timer = lv_timer_create(refresh_timer_cb, SD_BENCH_REFRESH_MS, NULL);
+    update_mount_label();
+}
+
+void show_sd_bench_screen(void) {
+    if (!sd_bench_screen) {
+        create_sd_bench_screen();
+    }
+    if (!benchmark_running()) {
+        update_mount_label();
+    }
+    lv_screen_load(sd_bench_screen);
+}
+
+void sd_bench_screen_back(void) {
+    if (benchmark_running()) {
+        ESP_LOGI(TAG, "Cancelling benchmark");
+        bench_cancel = true;
+    }
+    ESP_LOGI(TAG, "Returning to tools screen");
+    lv_screen_load(tools_screen);
+}
+
+// Event handlers
+static void sd_bench_back_button_event_handler(lv_event_t *e) {
+    lv_event_code_t code = lv_event_get_code(e);
+    if (code == LV_EVENT_CLICKED) {
+        sd_bench_screen_back();
+    }
+}
+
+static void sd_bench_run_button_event_handler(lv_event_t *e) {
+    lv_event_code_t code = lv_event_get_code(e);
+    if (code != LV_EVENT_CLICKED) {
+        return;
+    }
+    if (benchmark_running()) {
+        bench_cancel = true;
+        lv_label_set_text(status_label, "Stopping...");
+    } else {
+        start_benchmark();
+    }
+}
+
+static void sd_bench_save_button_event_handler(lv_event_t *e) {
+    lv_event_code_t code = lv_event_get_code(e);
+    if (code != LV_EVENT_CLICKED) {
+        return;
+    }
+    if (benchmark_running()) {
+        lv_label_set_text(status_label, "Benchmark still running");
+        return;
+    }
+    if (results_shown == 0) {
+        lv_label_set_text(status_label, "Run the benchmark first");
+        return;
+    }
+
+    FILE *f = sd_manager_open_file(SD_BENCH_CSV_PATH, "w");
+    if (!f) {
+        lv_label_set_text(status_label, "CSV save failed: cannot create file");
+        return;
+    }
+    esp_err_t ret = sd_bench_write_csv(f, mount_valid ? &mount : NULL, results, results_shown);
+    if (fclose(f) != 0 && ret == ESP_OK) {
+        ret = ESP_FAIL;
+    }
+    if (ret == ESP_OK) {
+        lv_label_set_text(status_label, "Saved to " SD_MOUNT_POINT SD_BENCH_CSV_PATH);
+    } else {
+        lv_label_set_text_fmt(status_label, "CSV save failed: %s", esp_err_to_name(ret));
+    }
+}
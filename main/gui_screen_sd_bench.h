@@ -0,0 +1,26 @@
+#ifndef GUI_SCREEN_SD_BENCH_H
+#define GUI_SCREEN_SD_BENCH_H
+
+#include "lvgl.h"
+
+// SD benchmark screen object
+extern lv_obj_t *sd_bench_screen;
+
+/**
+ * @brief Create SD card benchmark screen
+ */
+void create_sd_bench_screen(void);
+
+/**
+ * @brief Show SD card benchmark screen
+ */
+void show_sd_bench_screen(void);
+
+/**
+ * @brief Handle back navigation from SD benchmark screen
+ *
+ * A running benchmark is cancelled.
+ */
+void sd_bench_screen_back(void);
+
+#endif // GUI_SCREEN_SD_BENCH_H
@@ -0,0 +1,285 @@
+#include "gui_screen_search.h"
+#include "gui_screen_tools.h"
+#include "gui_screens.h"
+#include "gui_state.h"
+#include "gui_styles.h"
+#include "gui_virtual_list.h"
+#include "file_index.h"
+#include "file_listing.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include <stdio.h>
+#include <string.h>
+#include <inttypes.h>
+
+static const char *TAG = "GUI_SEARCH";
+
+#define SEARCH_MAX_RESULTS  500
+#define SEARCH_STATUS_MS    500
+#define SEARCH_ROW_HEIGHT   56
+#define SEARCH_ROW_GAP      4
+
+// Child order inside a pooled result row
+enum {
+    RESULT_CHILD_ICON,
+    RESULT_CHILD_NAME,
+    RESULT_CHILD_PATH
+};
+
+lv_obj_t *search_screen = NULL;
+static lv_obj_t *query_box = NULL;
+static lv_obj_t *search_keyboard = NULL;
+static lv_obj_t *result_list = NULL;
+static lv_obj_t *search_status_label = NULL;
+static lv_timer_t *status_timer = NULL;
+
+// Result names are full paths relative to the SD root
+static file_listing_t results = {0};
+static uint32_t total_matches = 0;
+static uint32_t last_search_ms = 0;
+
+// Forward declarations
+static void search_back_button_event_handler(lv_event_t *e);
+static void query_box_event_handler(lv_event_t *e);
+static void search_keyboard_event_handler(lv_event_t *e);
+static void result_click_event_handler(lv_event_t *e);
+static void status_timer_cb(lv_timer_t *timer);
+
+static const char* index_state_text(file_index_state_t state) {
+    switch (state) {
+        case FILE_INDEX_LOADING:   return "Loading index";
+        case FILE_INDEX_BUILDING:  return "Indexing card";
+        case FILE_INDEX_VERIFYING: return "Checking for changes";
+        case FILE_INDEX_READY:     return "Index ready";
+        case FILE_INDEX_OFFLINE:
+        default:                   return "No SD card";
+    }
+}
+
+static void update_status(void) {
+    file_index_status_t status;
+    file_index_get_status(&status);
+
+    char index_text[96];
+    snprintf(index_text, sizeof(index_text), "%s: %" PRIu32 " files and folders",
+             index_state_text(status.state), status.entries);
+
+    if (lv_textarea_get_text(query_box)[0] == '\0') {
+        lv_label_set_text(search_status_label, index_text);
+    } else if (total_matches > results.count) {
+        lv_label_set_text_fmt(search_status_label, "%" PRIu32 " matches (first %" PRIu32 " shown) in %" PRIu32 " ms | %s",
+                              total_matches, results.count, last_search_ms, index_text);
+    } else {
+        lv_label_set_text_fmt(search_status_label, "%" PRIu32 " matches in %" PRIu32 " ms | %s",
+                              total_matches, last_search_ms, index_text);
+    }
+}
+
+static void run_search(void) {
+    const char *query = lv_textarea_get_text(query_box);
+
+    int64_t start = esp_timer_get_time();
+    esp_err_t ret = file_index_search(query, &results, SEARCH_MAX_RESULTS, &total_matches);
+    last_search_ms = (uint32_t)((esp_timer_get_time() - start) / 1000);
+    if (ret != ESP_OK && ret != ESP_ERR_INVALID_STATE) {
+        ESP_LOGE(TAG, "Search failed: %s", esp_err_to_name(ret));
+    }
+
+    gui_virtual_list_set_count(result_list, results.count);
+    gui_virtual_list_scroll_to(result_list, 0);
+    update_status();
+}
+
+static void result_row_create_cb(lv_obj_t *row, void *user_data) {
+    (void)user_data;
+    lv_obj_set_style_bg_color(row, lv_color_hex(0x2a2a2a), 0);
+    lv_obj_set_style_border_opa(row, LV_OPA_TRANSP, 0);
+    lv_obj_set_style_radius(row, 6, 0);
+    lv_obj_set_style_pad_all(row, 6, 0);
+    lv_obj_add_flag(row, LV_OBJ_FLAG_CLICKABLE);
+    lv_obj_add_event_cb(row, result_click_event_handler, LV_EVENT_CLICKED, NULL);
+
+    lv_obj_t *icon = lv_label_create(row);
+    lv_obj_set_style_text_font(icon, &lv_font_montserrat_20, 0);
+    lv_obj_align(icon, LV_ALIGN_LEFT_MID, 4, 0);
+
+    lv_obj_t *name = lv_label_create(row);
+    lv_label_set_long_mode(name, LV_LABEL_LONG_DOT);
+    lv_obj_set_width(name, lv_pct(85));
+    lv_obj_set_style_text_color(name, THEME_TEXT_COLOR, 0);
+    lv_obj_align(name, LV_ALIGN_TOP_LEFT, 40, 0);
+
+    lv_obj_t *path = lv_label_create(row);
+    lv_label_set_long_mode(path, LV_LABEL_LONG_DOT);
+    lv_obj_set_width(path, lv_pct(85));
+    lv_obj_set_style_text_color(path, THEME_TEXT_MUTED, 0);
+    lv_obj_set_style_text_font(path, &lv_font_montserrat_14, 0);
+    lv_obj_align(path, LV_ALIGN_BOTTOM_LEFT, 40, 0);
+}
+
+static void result_row_bind_cb(lv_obj_t *row, uint32_t index, void *user_data) {
+    (void)user_data;
+    const char *full_path = file_listing_name(&results, index);
+    const char *base_name = strrchr(full_path, '/');
+    base_name = base_name ? base_name + 1 : full_path;
+
+    lv_label_set_text(lv_obj_get_child(row, RESULT_CHILD_ICON),
+                      file_listing_is_dir(&results, index) ? LV_SYMBOL_DIRECTORY : LV_SYMBOL_FILE);
+    lv_label_set_text(lv_obj_get_child(row, RESULT_CHILD_NAME), base_name);
+    lv_label_set_text(lv_obj_get_child(row, RESULT_CHILD_PATH), full_path);
+}
+
+static void status_timer_cb(lv_timer_t *timer) {
+    (void)timer;
+    if (lv_screen_active() != search_screen) {
+        return;
+    }
+    update_status();
+}
+
+void create_search_screen(void) {
+    if (search_screen) {
+        return; // Already created
+    }
+
+    search_screen = lv_obj_create(NULL);
+    lv_obj_add_style(search_screen, &style_screen, LV_PART_MAIN | LV_STATE_DEFAULT);
+
+    // Create title bar
+    lv_obj_t *title_bar = lv_obj_create(search_screen);
+    lv_obj_set_size(title_bar, lv_pct(100), 60);
+    lv_obj_align(title_bar, LV_ALIGN_TOP_MID, 0, 0);
+    lv_obj_set_style_bg_color(title_bar, lv_color_hex(0x333333), 0);
+    lv_obj_set_style_border_opa(title_bar, LV_OPA_TRANSP, 0);
+    lv_obj_set_style_pad_all(title_bar, 10, 0);
+
+    // Back button
+    lv_obj_t *back_btn = lv_button_create(title_bar);
+    lv_obj_set_size(back_btn, 60, 40);
+    lv_obj_align(back_btn, LV_ALIGN_LEFT_MID, 0, 0);
+    apply_button_style(back_btn);
+    lv_obj_add_event_cb(back_btn, search_back_button_event_handler, LV_EVENT_CLICKED, NULL);
+
+    lv_obj_t *back_label = lv_label_create(back_btn);
+    lv_label_set_text(back_label, LV_SYMBOL_LEFT);
+    lv_obj_center(back_label);
+
+    // Title
+    lv_obj_t *title_label = lv_label_create(title_bar);
+    lv_label_set_text(title_label, "Find Files");
+    lv_obj_set_style_text_color(title_label, lv_color_hex(0xFFFFFF), 0);
+    lv_obj_set_style_text_font(title_label, &lv_font_montserrat_20, 0);
+    lv_obj_align(title_label, LV_ALIGN_LEFT_MID, 80, 0);
+
+    // Query box: substring, or "*.ext" for an extension
+    query_box = lv_textarea_create(title_bar);
+    lv_obj_set_size(query_box, lv_pct(60), 40);
+    lv_obj_align(query_box, LV_ALIGN_RIGHT_MID, 0, 0);
+    lv_textarea_set_one_line(query_box, true);
+    lv_textarea_set_placeholder_text(query_box, "Name contains... or *.ext");
+    lv_obj_add_event_cb(query_box, query_box_event_handler, LV_EVENT_ALL, NULL);
+
+    // Status line: match count, search time and index state
+    search_status_label = lv_label_create(search_screen);
+    lv_obj_set_width(search_status_label, lv_pct(95));
+    lv_label_set_long_mode(search_status_label, LV_LABEL_LONG_DOT);
+    lv_obj_set_style_text_color(search_status_label, THEME_TEXT_MUTED, 0);
+    lv_obj_set_style_text_font(search_status_label, &lv_font_montserrat_14, 0);
+    lv_obj_align(search_status_label, LV_ALIGN_TOP_MID, 0, 68);
+
+    // Results, rows recycled as the list scrolls
+    result_list = gui_virtual_list_create(search_screen, SEARCH_ROW_HEIGHT, SEARCH_ROW_GAP,
+                                          result_row_create_cb, result_row_bind_cb, NULL);
+    lv_obj_set_size(result_list, lv_pct(95), lv_pct(80));
+    lv_obj_align(result_list, LV_ALIGN_BOTTOM_MID, 0, -10);
+    lv_obj_set_style_bg_color(result_list, lv_color_hex(0x1a1a1a), 0);
+    lv_obj_set_style_border_color(result_list, THEME_PRIMARY_COLOR, 0);
+    lv_obj_set_style_border_width(result_list, 1, 0);
+    lv_obj_set_style_pad_all(result_list, 8, 0);
+
+    // On-screen keyboard (initially hidden)
+    search_keyboard = lv_keyboard_create(search_screen);
+    lv_obj_set_size(search_keyboard, lv_pct(100), lv_pct(40));
+    lv_obj_align(search_keyboard, LV_ALIGN_BOTTOM_MID, 0, 0);
+    lv_keyboard_set_textarea(search_keyboard, query_box);
+    lv_obj_add_event_cb(search_keyboard, search_keyboard_event_handler, LV_EVENT_ALL, NULL);
+    lv_obj_add_flag(search_keyboard, LV_OBJ_FLAG_HIDDEN);
+
+    status_timer = lv_timer_create(status_timer_cb, SEARCH_STATUS_MS, NULL);
+    update_status();
+}
+
+void show_search_screen(void) {
+    if (!search_screen) {
+        create_search_screen();
+    }
+    // The index may have changed since the last visit
+    run_search();
+    lv_screen_load(search_screen);
+}
+
+void search_screen_back(void) {
+    ESP_LOGI(TAG, "Returning to tools screen");
+    lv_obj_add_flag(search_keyboard, LV_OBJ_FLAG_HIDDEN);
+    lv_screen_load(tools_screen);
+}
+
+// Event handlers
+static void search_back_button_event_handler(lv_event_t *e) {
+    lv_event_code_t code = lv_event_get_code(e);
+    if (code == LV_EVENT_CLICKED) {
+        search_screen_back();
+    }
+}
+
+static void query_box_event_handler(lv_event_t *e) {
+    lv_event_code_t code = lv_event_get_code(e);
+
+    if (code == LV_EVENT_FOCUSED) {
+        lv_obj_remove_flag(search_keyboard, LV_OBJ_FLAG_HIDDEN);
+    } else if (code == LV_EVENT_DEFOCUSED) {
+        lv_obj_add_flag(search_keyboard, LV_OBJ_FLAG_HIDDEN);
+    } else if (code == LV_EVENT_VALUE_CHANGED) {
+        run_search();
+    }
+}
+
+static void search_keyboard_event_handler(lv_event_t *e) {
+    lv_event_code_t code = lv_event_get_code(e);
+
+    if (code == LV_EVENT_READY || code == LV_EVENT_CANCEL) {
+        lv_obj_remove_state(query_box, LV_STATE_FOCUSED);
+        lv_obj_add_flag(search_keyboard, LV_OBJ_FLAG_HIDDEN);
+    }
+}
+
+static void result_click_event_handler(lv_event_t *e) {
+    lv_event_code_t code = lv_event_get_code(e);
+    if (code != LV_EVENT_CLICKED) {
+        return;
+    }
+
+    uint32_t index = gui_virtual_list_get_index(lv_event_get_current_target(e));
+    if (index >= results.count) {
+        return;
+    }
+
+    // Open the folder itself, or the folder holding the file
+    char target[sizeof(current_directory)];
+    snprintf(target, sizeof(target), "%s", file_listing_name(&results, index));
+    if (!file_listing_is_dir(&results, index)) {
+        char *last_slash = strrchr(target, '/');
+        if (last_slash == target) {
+            target[1] = '\0';
+        } else if (last_slash) {
+            *last_slash = '\0';
+        }
+    }
+
+    ESP_LOGI(TAG, "Opening %s in file manager", target);
+    lv_obj_add_flag(search_keyboard, LV_OBJ_FLAG_HIDDEN);
+    strcpy(current_directory, target);
+    update_file_manager_screen();
+    update_file_list();
+    lv_screen_load(file_manager_screen);
+}
@@ -0,0 +1,24 @@
+#ifndef GUI_SCREEN_SEARCH_H
+#define GUI_SCREEN_SEARCH_H
+
+#include "lvgl.h"
+
+// Card-wide search screen object
+extern lv_obj_t *search_screen;
+
+/**
+ * @brief Create card-wide file search screen
+ */
+void create_search_screen(void);
+
+/**
+ * @brief Show file search screen
+ */
+void show_search_screen(void);
+
+/**
+ * @brief Handle back navigation from search screen
+ */
+void search_screen_back(void);
+
+#endif // GUI_SCREEN_SEARCH_H
@@ -30,6 +30,7 @@ static lv_obj_t *sort_by_dropdown = NULL;
 static lv_obj_t *sort_order_switch = NULL;
 static lv_obj_t *show_hidden_switch = NULL;
 static lv_obj_t *show_extensions_switch = NULL;
+static lv_obj_t *verify_copies_switch = NULL;
 static lv_obj_t *items_per_page_slider = NULL;
 
 // Theme settings controls
@@ -48,6 +49,7 @@ typedef enum {
     SETTINGS_SORT_ORDER,
     SETTINGS_SHOW_HIDDEN,
     SETTINGS_SHOW_EXTENSIONS,
+    SETTINGS_VERIFY_COPIES,
     SETTINGS_ITEMS_PER_PAGE,
     SETTINGS_THEME,
     SETTINGS_PRIMARY_COLOR,
@@ -266,6 +268,18 @@ static void create_file_browser_tab(lv_obj_t *parent) {
                         (void*)SETTINGS_SHOW_EXTENSIONS);
     y_offset += 50;
     
+    // Verify copies setting
+    lv_obj_t *verify_label = lv_label_create(cont);
+    lv_label_set_text(verify_label, "Verify Copies");
+    lv_obj_set_style_text_font(verify_label, THEME_FONT_MEDIUM, 0);
+    lv_obj_align(verify_label, LV_ALIGN_TOP_LEFT, 0, y_offset);
+    
+    verify_copies_switch = lv_switch_create(cont);
+    lv_obj_align(verify_copies_switch, LV_ALIGN_TOP_RIGHT, -20, y_offset);
+    lv_obj_add_event_cb(verify_copies_switch, settings_event_handler, LV_EVENT_VALUE_CHANGED,
+                        (void*)SETTINGS_VERIFY_COPIES);
+    y_offset += 50;
+    
     // Items per page setting
     lv_obj_t *items_label = lv_label_create(cont);
     lv_label_set_text(items_label, "Items Per Page");
@@ -427,6 +441,11 @@ static void settings_event_handler(lv_event_t *e) {
                 // Note: Extension display is handled automatically in file browser based on config
                 break;
                 
+            case SETTINGS_VERIFY_COPIES:
+                config->file_browser.verify_copies = lv_obj_has_state(verify_copies_switch, LV_STATE_CHECKED);
+                ESP_LOGI(TAG, "Copy verification %s", config->file_browser.verify_copies ? "enabled" : "disabled");
+                break;
+                
             case SETTINGS_ITEMS_PER_PAGE:
                 config->file_browser.items_per_page = (uint8_t)lv_slider_get_value(items_per_page_slider);
                 ESP_LOGI(TAG, "Items per page set to %d", config->file_browser.items_per_page);
@@ -548,6 +567,14 @@ static void apply_current_config_to_ui(void) {
         }
     }
     
+    if (verify_copies_switch) {
+        if (config->file_browser.verify_copies) {
+            lv_obj_add_state(verify_copies_switch, LV_STATE_CHECKED);
+        } else {
+            lv_obj_clear_state(verify_copies_switch, LV_STATE_CHECKED);
+        }
+    }
+    
     if (items_per_page_slider) {
         lv_slider_set_value(items_per_page_slider, config->file_browser.items_per_page, LV_ANIM_OFF);
     }
@@ -4,6 +4,7 @@
 #include "gui_styles.h"
 #include "gui_screen_python_launcher.h"
 #include "sd_manager.h"
+#include "sd_io.h"
 #include "esp_log.h"
 #include <string.h>
 #include <stdio.h>
@@ -203,9 +204,11 @@ esp_err_t text_editor_open_file(const char *file_path) {
         return ESP_ERR_NO_MEM;
     }
 
+    sd_io_begin(SD_IO_INTERACTIVE);
     size_t read_size = fread(content, 1, file_size, file);
-    content[read_size] = '\0';
     fclose(file);
+    sd_io_end(SD_IO_INTERACTIVE);
+    content[read_size] = '\0';
 
     // Set content in text area
     lv_textarea_set_text(text_area, content);
@@ -257,8 +260,10 @@ esp_err_t text_editor_save_file(void) {
     }
 
     size_t content_len = strlen(content);
+    sd_io_begin(SD_IO_INTERACTIVE);
     size_t written = fwrite(content, 1, content_len, file);
     fclose(file);
+    sd_io_end(SD_IO_INTERACTIVE);
 
     if (written != content_len) {
         update_status("Write error");
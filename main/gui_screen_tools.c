@@ -5,6 +5,10 @@
 #include "gui_screen_text_editor.h"
 #include "gui_screen_python_launcher.h"
 #include "gui_screen_calculator.h"
+#include "gui_screen_diagnostics.h"
+#include "gui_screen_search.h"
+#include "gui_screen_disk_usage.h"
+#include "gui_screen_sd_bench.h"
 #include "esp_log.h"
 
 static const char *TAG = "GUI_TOOLS";
@@ -47,6 +51,26 @@ static void tools_menu_event_handler(lv_event_t *e) {
                 lv_obj_set_size(info_mbox, 300, 180);
                 lv_obj_center(info_mbox);
                 break;
+
+            case 4: // Render Stats
+                ESP_LOGI(TAG, "Render Stats selected");
+                show_diagnostics_screen();
+                break;
+
+            case 5: // Find Files
+                ESP_LOGI(TAG, "Find Files selected");
+                show_search_screen();
+                break;
+
+            case 6: // Disk Usage
+                ESP_LOGI(TAG, "Disk Usage selected");
+                show_disk_usage_screen();
+                break;
+
+            case 7: // SD Benchmark
+                ESP_LOGI(TAG, "SD Benchmark selected");
+                show_sd_bench_screen();
+                break;
         }
     }
 }
@@ -113,10 +137,14 @@ void create_tools_screen(void) {
         {LV_SYMBOL_EDIT, "Text\nEditor", lv_color_hex(0x4ecdc4), 0},
         {LV_SYMBOL_KEYBOARD, "Calculator", lv_color_hex(0x44a08d), 1},
         {LV_SYMBOL_FILE, "Python\nLauncher", lv_color_hex(0x3d5a80), 2},
-        {LV_SYMBOL_SETTINGS, "System\nInfo", lv_color_hex(0x6c5ce7), 3}
+        {LV_SYMBOL_SETTINGS, "System\nInfo", lv_color_hex(0x6c5ce7), 3},
+        {LV_SYMBOL_IMAGE, "Render\nStats", lv_color_hex(0xe17055), 4},
+        {LV_SYMBOL_DIRECTORY, "Find\nFiles", lv_color_hex(0x0984e3), 5},
+        {LV_SYMBOL_SD_CARD, "Disk\nUsage", lv_color_hex(0xd63031), 6},
+        {LV_SYMBOL_CHARGE, "SD\nBenchmark", lv_color_hex(0xfdcb6e), 7}
     };
-    // Create tool buttons in 2x2 grid
-    for (int i = 0; i < 4; i++) {
+    // Create tool buttons in a wrapping grid
+    for (int i = 0; i < (int)(sizeof(tools) / sizeof(tools[0])); i++) {
         lv_obj_t *tool_btn = lv_button_create(tools_container);
         lv_obj_set_size(tool_btn, 140, 100);
         apply_button_style(tool_btn);
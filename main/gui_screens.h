@@ -56,11 +56,21 @@ void create_splash_screen(void);
  */
 void create_reboot_dialog_screen(void);
 
+/**
+ * @brief Rebuild file manager screen (path and toolbar)
+ */
+void update_file_manager_screen(void);
+
 /**
  * @brief Update file list display
  */
 void update_file_list(void);
 
+/**
+ * @brief Rebind visible file rows without rescanning (selection changes)
+ */
+void refresh_file_list_rows(void);
+
 /**
  * @brief Update firmware list display
  */
@@ -3,26 +3,20 @@
 
 #include "sd_manager.h"
 #include "firmware_loader.h"
+#include "file_listing.h"
+#include "selection_set.h"
 #include <stdbool.h>
 
 // State variables
 extern char current_directory[512];
-extern file_entry_t current_entries[32];
-extern int current_entry_count;
+extern file_listing_t current_listing;  // Entries of current_directory, grown as it is scanned
 extern firmware_info_t firmware_files[16];
 extern int firmware_count;
 extern int selected_firmware;
 
 // File selection state
 extern bool file_selection_enabled;
-extern bool selected_files[32];  // Parallel array to current_entries
-extern int selected_file_count;
-
-// Clipboard state
-extern bool clipboard_has_content;
-extern bool clipboard_is_cut;  // true for cut/move, false for copy
-extern char clipboard_files[32][256];  // Full paths of copied/cut files
-extern int clipboard_file_count;
+extern selection_set_t selected_files;  // One bit per current_listing entry
 
 // Progress state
 extern volatile bool progress_update_pending;
@@ -1,10 +1,12 @@
 #include "gui_status_bar.h"
 #include "gui_styles.h"
 #include "sd_manager.h"
+#include "sd_space.h"
 // #include "wifi_manager.h"  // Temporarily disabled for flicker testing
 #include "esp_log.h"
 #include <stdlib.h>
 #include <stdio.h>
+#include <inttypes.h>
 
 static const char *TAG = "GUI_STATUS_BAR";
 
@@ -61,6 +63,12 @@ gui_status_bar_t* gui_status_bar_create(lv_obj_t *parent) {
     lv_obj_set_style_text_color(status_bar->sdcard_label, lv_color_hex(0x666666), 0); // Gray when not detected
     lv_obj_set_style_text_font(status_bar->sdcard_label, &lv_font_montserrat_18, 0);
     
+    // Free space next to the SD card symbol
+    status_bar->space_label = lv_label_create(status_container);
+    lv_label_set_text(status_bar->space_label, "");
+    lv_obj_set_style_text_color(status_bar->space_label, lv_color_hex(0xFFFFFF), 0);
+    lv_obj_set_style_text_font(status_bar->space_label, &lv_font_montserrat_14, 0);
+    
     // Middle pipe symbol
     lv_obj_t *middle_pipe = lv_label_create(status_container);
     lv_label_set_text(middle_pipe, "|");
@@ -199,6 +207,20 @@ void gui_status_bar_update_sdcard(gui_status_bar_t *status_bar) {
         // No card detected - show gray SD card symbol
         lv_obj_set_style_text_color(status_bar->sdcard_label, lv_color_hex(0x666666), 0);
     }
+    
+    // Cached count, so this is cheap enough for every status update
+    uint64_t free_bytes;
+    if (card_mounted && sd_space_get(&free_bytes, NULL) == ESP_OK) {
+        char text[16];
+        if (free_bytes >= 1024ULL * 1024 * 1024) {
+            snprintf(text, sizeof(text), "%.1fG", (double)free_bytes / (1024.0 * 1024.0 * 1024.0));
+        } else {
+            snprintf(text, sizeof(text), "%" PRIu32 "M", (uint32_t)(free_bytes >> 20));
+        }
+        lv_label_set_text(status_bar->space_label, text);
+    } else {
+        lv_label_set_text(status_bar->space_label, "");
+    }
 }
 
 void gui_status_bar_set_visible(gui_status_bar_t *status_bar, bool visible) {
@@ -15,6 +15,7 @@ typedef struct {
     lv_obj_t *current_unit_label;
     lv_obj_t *charging_label;
     lv_obj_t *sdcard_label;
+    lv_obj_t *space_label;      // Free space on the card, empty until known
     lv_obj_t *wifi_label;
 } gui_status_bar_t;
 
@@ -0,0 +1,227 @@
+#include "gui_virtual_list.h"
+#include "esp_log.h"
+#include <stdlib.h>
+
+static const char *TAG = "GUI_VLIST";
+
+// Rows are tagged so an event target can be walked back to its row
+#define VLIST_ROW_FLAG LV_OBJ_FLAG_USER_1
+#define VLIST_UNBOUND  UINT32_MAX
+
+/*
+ * Item i always lives in pool slot i % pool_size at y = i * pitch. Scrolling by
+ * one row therefore moves and rebinds exactly one row object; everything else
+ * stays where it is. A spacer child gives the list its full scrollable height.
+ */
+typedef struct {
+    lv_obj_t *spacer;
+    lv_obj_t **rows;
+    uint32_t *bound;          // Item index bound to each slot
+    uint32_t pool_size;
+    uint32_t count;
+    int32_t row_height;
+    int32_t pitch;            // Row height plus gap
+    gui_virtual_list_create_cb_t create_cb;
+    gui_virtual_list_bind_cb_t bind_cb;
+    void *user_data;
+} virtual_list_t;
+
+static uint32_t rows_in_viewport(lv_obj_t *list, const virtual_list_t *vl) {
+    int32_t height = lv_obj_get_content_height(list);
+    uint32_t rows = height > 0 ? (uint32_t)((height + vl->pitch - 1) / vl->pitch) : 1;
+    return rows ? rows : 1;
+}
+
+static uint32_t first_visible(lv_obj_t *list, const virtual_list_t *vl) {
+    int32_t scroll_y = lv_obj_get_scroll_y(list);
+    return scroll_y > 0 ? (uint32_t)(scroll_y / vl->pitch) : 0;
+}
+
+static void ensure_pool(lv_obj_t *list, virtual_list_t *vl) {
+    // One extra row for the partially visible row at each edge
+    uint32_t needed = rows_in_viewport(list, vl) + 2;
+    if (needed <= vl->pool_size) {
+        return;
+    }
+
+    lv_obj_t **rows = realloc(vl->rows, needed * sizeof(lv_obj_t *));
+    if (!rows) {
+        ESP_LOGE(TAG, "Failed to grow row pool to %u", (unsigned)needed);
+        return;
+    }
+    vl->rows = rows;
+
+    uint32_t *bound = realloc(vl->bound, needed * sizeof(uint32_t));
+    if (!bound) {
+        ESP_LOGE(TAG, "Failed to grow row pool to %u", (unsigned)needed);
+        return;
+    }
+    vl->bound = bound;
+
+    for (uint32_t slot = vl->pool_size; slot < needed; slot++) {
+        lv_obj_t *row = lv_obj_create(list);
+        lv_obj_set_size(row, lv_pct(100), vl->row_height);
+        lv_obj_remove_flag(row, LV_OBJ_FLAG_SCROLLABLE);
+        lv_obj_add_flag(row, VLIST_ROW_FLAG | LV_OBJ_FLAG_HIDDEN);
+        if (vl->create_cb) {
+            vl->create_cb(row, vl->user_data);
+        }
+        vl->rows[slot] = row;
+    }
+    vl->pool_size = needed;
+
+    // Slot assignment depends on the pool size, so every row is rebound
+    for (uint32_t slot = 0; slot < vl->pool_size; slot++) {
+        vl->bound[slot] = VLIST_UNBOUND;
+    }
+}
+
+static void update_rows(lv_obj_t *list, virtual_list_t *vl, bool force) {
+    if (vl->pool_size == 0) {
+        return;
+    }
+
+    uint32_t first = first_visible(list, vl);
+    for (uint32_t j = 0; j < vl->pool_size; j++) {
+        uint32_t index = first + j;
+        uint32_t slot = index % vl->pool_size;
+        lv_obj_t *row = vl->rows[slot];
+
+        if (index >= vl->count) {
+            lv_obj_add_flag(row, LV_OBJ_FLAG_HIDDEN);
+            vl->bound[slot] = VLIST_UNBOUND;
+            continue;
+        }
+
+        if (force || vl->bound[slot] != index) {
+            lv_obj_set_y(row, (int32_t)index * vl->pitch);
+            lv_obj_set_user_data(row, (void *)(uintptr_t)index);
+            if (vl->bind_cb) {
+                vl->bind_cb(row, index, vl->user_data);
+            }
+            vl->bound[slot] = index;
+        }
+        lv_obj_remove_flag(row, LV_OBJ_FLAG_HIDDEN);
+    }
+}
+
+static void virtual_list_event_cb(lv_event_t *e) {
+    lv_event_code_t code = lv_event_get_code(e);
+    lv_obj_t *list = lv_event_get_current_target(e);
+    virtual_list_t *vl = lv_obj_get_user_data(list);
+    if (!vl) {
+        return;
+    }
+
+    switch (code) {
+        case LV_EVENT_SCROLL:
+            update_rows(list, vl, false);
+            break;
+        case LV_EVENT_SIZE_CHANGED:
+            ensure_pool(list, vl);
+            update_rows(list, vl, false);
+            break;
+        case LV_EVENT_DELETE:
+            lv_obj_set_user_data(list, NULL);
+            free(vl->rows);
+            free(vl->bound);
+            free(vl);
+            break;
+        default:
+            break;
+    }
+}
+
+lv_obj_t* gui_virtual_list_create(lv_obj_t *parent, int32_t row_height, int32_t row_gap,
+                                  gui_virtual_list_create_cb_t create_cb,
+                                  gui_virtual_list_bind_cb_t bind_cb, void *user_data) {
+    virtual_list_t *vl = calloc(1, sizeof(virtual_list_t));
+    if (!vl) {
+        ESP_LOGE(TAG, "Failed to allocate virtual list");
+        return NULL;
+    }
+    vl->row_height = row_height;
+    vl->pitch = row_height + row_gap;
+    vl->create_cb = create_cb;
+    vl->bind_cb = bind_cb;
+    vl->user_data = user_data;
+
+    lv_obj_t *list = lv_obj_create(parent);
+    lv_obj_set_scroll_dir(list, LV_DIR_VER);
+    lv_obj_set_user_data(list, vl);
+
+    vl->spacer = lv_obj_create(list);
+    lv_obj_remove_style_all(vl->spacer);
+    lv_obj_set_size(vl->spacer, 1, 0);
+    lv_obj_remove_flag(vl->spacer, LV_OBJ_FLAG_CLICKABLE | LV_OBJ_FLAG_SCROLLABLE);
+
+    lv_obj_add_event_cb(list, virtual_list_event_cb, LV_EVENT_ALL, NULL);
+    return list;
+}
+
+void gui_virtual_list_set_count(lv_obj_t *list, uint32_t count) {
+    virtual_list_t *vl = lv_obj_get_user_data(list);
+    if (!vl) {
+        return;
+    }
+
+    vl->count = count;
+    lv_obj_set_height(vl->spacer, count ? (int32_t)count * vl->pitch - (vl->pitch - vl->row_height) : 0);
+    lv_obj_update_layout(list);
+
+    // Pull the view back if the list shrank below the current scroll position
+    int32_t overshoot = lv_obj_get_scroll_bottom(list);
+    if (overshoot < 0) {
+        int32_t scroll_y = lv_obj_get_scroll_y(list) + overshoot;
+        lv_obj_scroll_to_y(list, scroll_y > 0 ? scroll_y : 0, LV_ANIM_OFF);
+    }
+
+    ensure_pool(list, vl);
+    update_rows(list, vl, true);
+}
+
+uint32_t gui_virtual_list_get_count(lv_obj_t *list) {
+    virtual_list_t *vl = lv_obj_get_user_data(list);
+    return vl ? vl->count : 0;
+}
+
+void gui_virtual_list_refresh(lv_obj_t *list) {
+    virtual_list_t *vl = lv_obj_get_user_data(list);
+    if (vl) {
+        update_rows(list, vl, true);
+    }
+}
+
+void gui_virtual_list_scroll_to(lv_obj_t *list, uint32_t index) {
+    virtual_list_t *vl = lv_obj_get_user_data(list);
+    if (!vl) {
+        return;
+    }
+    lv_obj_scroll_to_y(list, (int32_t)index * vl->pitch, LV_ANIM_OFF);
+    update_rows(list, vl, false);
+}
+
+uint32_t gui_virtual_list_get_first_visible(lv_obj_t *list) {
+    virtual_list_t *vl = lv_obj_get_user_data(list);
+    return vl ? first_visible(list, vl) : 0;
+}
+
+uint32_t gui_virtual_list_get_visible_rows(lv_obj_t *list) {
+    virtual_list_t *vl = lv_obj_get_user_data(list);
+    if (!vl) {
+        return 1;
+    }
+    // Whole rows only, so paging by this amount never skips an item
+    int32_t rows = lv_obj_get_content_height(list) / vl->pitch;
+    return rows > 0 ? (uint32_t)rows : 1;
+}
+
+uint32_t gui_virtual_list_get_index(lv_obj_t *obj) {
+    while (obj && !lv_obj_has_flag(obj, VLIST_ROW_FLAG)) {
+        obj = lv_obj_get_parent(obj);
+    }
+    if (!obj || lv_obj_has_flag(obj, LV_OBJ_FLAG_HIDDEN)) {
+        return UINT32_MAX;
+    }
+    return (uint32_t)(uintptr_t)lv_obj_get_user_data(obj);
+}
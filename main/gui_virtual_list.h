@@ -0,0 +1,90 @@
+#ifndef GUI_VIRTUAL_LIST_H
+#define GUI_VIRTUAL_LIST_H
+
+#include "lvgl.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * @brief Called once per pooled row to build its child objects and styles
+ * @param row Row object (fixed height, full list width)
+ * @param user_data User data passed to gui_virtual_list_create()
+ */
+typedef void (*gui_virtual_list_create_cb_t)(lv_obj_t *row, void *user_data);
+
+/**
+ * @brief Called whenever a pooled row is (re)bound to a data index
+ * @param row Row object previously built by the create callback
+ * @param index Data index the row now shows
+ * @param user_data User data passed to gui_virtual_list_create()
+ */
+typedef void (*gui_virtual_list_bind_cb_t)(lv_obj_t *row, uint32_t index, void *user_data);
+
+/**
+ * @brief Create a virtualized list with a fixed pool of recycled rows
+ *
+ * Only enough rows to cover the viewport (plus one spare on each side) are
+ * ever created. Scrolling moves rows and rebinds the ones whose index changed,
+ * so cost per frame is independent of the item count.
+ *
+ * @param parent Parent object
+ * @param row_height Height of every row in pixels
+ * @param row_gap Vertical gap between rows in pixels
+ * @param create_cb Row construction callback
+ * @param bind_cb Row data binding callback
+ * @param user_data Passed to both callbacks
+ * @return The scrollable list object (state is freed when it is deleted)
+ */
+lv_obj_t* gui_virtual_list_create(lv_obj_t *parent, int32_t row_height, int32_t row_gap,
+                                  gui_virtual_list_create_cb_t create_cb,
+                                  gui_virtual_list_bind_cb_t bind_cb, void *user_data);
+
+/**
+ * @brief Set the number of items and rebind the visible rows
+ * @param list Virtual list object
+ * @param count Number of items
+ */
+void gui_virtual_list_set_count(lv_obj_t *list, uint32_t count);
+
+/**
+ * @brief Get the number of items
+ * @param list Virtual list object
+ * @return Number of items
+ */
+uint32_t gui_virtual_list_get_count(lv_obj_t *list);
+
+/**
+ * @brief Rebind all visible rows (e.g. after selection or mode changes)
+ * @param list Virtual list object
+ */
+void gui_virtual_list_refresh(lv_obj_t *list);
+
+/**
+ * @brief Scroll so that an item is the first visible row
+ * @param list Virtual list object
+ * @param index Item index (clamped to the scrollable range)
+ */
+void gui_virtual_list_scroll_to(lv_obj_t *list, uint32_t index);
+
+/**
+ * @brief Get the index of the first visible item
+ * @param list Virtual list object
+ * @return First visible item index
+ */
+uint32_t gui_virtual_list_get_first_visible(lv_obj_t *list);
+
+/**
+ * @brief Get the number of rows that fit in the viewport
+ * @param list Virtual list object
+ * @return Rows per viewport (at least 1)
+ */
+uint32_t gui_virtual_list_get_visible_rows(lv_obj_t *list);
+
+/**
+ * @brief Get the item index currently bound to a row or one of its children
+ * @param obj Row object or any descendant of it
+ * @return Item index, or UINT32_MAX if obj is not part of a bound row
+ */
+uint32_t gui_virtual_list_get_index(lv_obj_t *obj);
+
+#endif // GUI_VIRTUAL_LIST_H
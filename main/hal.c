@@ -1,11 +1,21 @@
 #include "hal.h"
+#include "hal_rotate.h"
+#include "render_stats.h"
 #include "bsp/m5stack_tab5.h"
 #include "esp_log.h"
 #include "esp_lcd_touch.h"
+#include "esp_lcd_panel_ops.h"
+#include "esp_heap_caps.h"
+
+static const char *TAG = "HAL";
 
 lv_display_t *lvDisp = NULL;
 lv_indev_t *lvTouchpad = NULL;
 
+// Destination of the software rotation, handed to the DSI panel
+static esp_lcd_panel_handle_t lcd_panel = NULL;
+static uint8_t *rotate_buf = NULL;
+
 extern esp_lcd_touch_handle_t _lcd_touch_handle;
 
 static void lvgl_read_cb(lv_indev_t *indev, lv_indev_data_t *data)
@@ -33,6 +43,78 @@ static void lvgl_read_cb(lv_indev_t *indev, lv_indev_data_t *data)
     }
 }
 
+static void hal_flush_cb(lv_display_t *disp, const lv_area_t *area, uint8_t *px_map)
+{
+    lv_display_rotation_t rotation = lv_display_get_rotation(disp);
+    lv_area_t panel_area = *area;
+    uint8_t *color_map = px_map;
+
+    if (rotation != LV_DISPLAY_ROTATION_0) {
+        lv_color_format_t cf = lv_display_get_color_format(disp);
+        int32_t w = lv_area_get_width(area);
+        int32_t h = lv_area_get_height(area);
+        int32_t src_stride = lv_draw_buf_width_to_stride(w, cf);
+        // The DPI panel copies tightly packed rows
+        int32_t dst_w = (rotation == LV_DISPLAY_ROTATION_180) ? w : h;
+        int32_t dst_stride = dst_w * lv_color_format_get_size(cf);
+
+        if (!hal_rotate(px_map, rotate_buf, w, h, src_stride, dst_stride, rotation, cf)) {
+            lv_draw_sw_rotate(px_map, rotate_buf, w, h, src_stride, dst_stride, rotation, cf);
+        }
+        color_map = rotate_buf;
+        lv_display_rotate_area(disp, &panel_area);
+    }
+
+    // lv_display_flush_ready() is signalled by the port's DSI transfer-done callback
+    esp_lcd_panel_draw_bitmap(lcd_panel, panel_area.x1, panel_area.y1,
+                              panel_area.x2 + 1, panel_area.y2 + 1, color_map);
+}
+
+// Allocated before the display starts so the port is only asked for its own
+// rotation buffer when this one is unavailable
+static bool hal_rotation_alloc(uint32_t buffer_size)
+{
+#if CONFIG_BSP_DISPLAY_LVGL_AVOID_TEAR || BSP_LCD_BIGENDIAN
+    // Keep the port's flush path, it handles these modes itself
+    (void)buffer_size;
+    return false;
+#else
+#if CONFIG_BSP_LCD_COLOR_FORMAT_RGB888
+    size_t size = buffer_size * lv_color_format_get_size(LV_COLOR_FORMAT_RGB888);
+#else
+    size_t size = buffer_size * lv_color_format_get_size(LV_COLOR_FORMAT_RGB565);
+#endif
+    size = (size + HAL_ROTATE_CACHE_LINE - 1) & ~((size_t)HAL_ROTATE_CACHE_LINE - 1);
+    rotate_buf = heap_caps_aligned_alloc(HAL_ROTATE_CACHE_LINE, size, MALLOC_CAP_SPIRAM);
+    if (!rotate_buf) {
+        ESP_LOGE(TAG, "Failed to allocate rotation buffer, keeping default rotation path");
+        return false;
+    }
+    return true;
+#endif
+}
+
+static void hal_rotation_install(void)
+{
+    lcd_panel = bsp_display_get_panel_handle();
+    if (!lcd_panel) {
+        ESP_LOGE(TAG, "No panel handle, rotation flush not installed");
+        heap_caps_free(rotate_buf);
+        rotate_buf = NULL;
+        return;
+    }
+
+    bsp_display_lock(0);
+    lv_display_set_flush_cb(lvDisp, hal_flush_cb);
+    bsp_display_unlock();
+
+    // Without sw_rotate the port treats a rotation as a panel swap/mirror;
+    // the pixels are already rotated here, so put the panel back upright
+    esp_lcd_panel_swap_xy(lcd_panel, false);
+    esp_lcd_panel_mirror(lcd_panel, false, false);
+    ESP_LOGI(TAG, "Blocked rotation flush installed (%d px tiles)", HAL_ROTATE_TILE_RGB565);
+}
+
 void hal_init(void)
 {
     // Initialize I2C bus
@@ -58,12 +140,18 @@ void hal_init(void)
             .buff_dma = true,
 #endif
             .buff_spiram = true,  // Enable PSRAM for buffers
-            .sw_rotate   = true,
         }
     };
+    // The port only needs its own rotation buffer when hal_flush_cb is not used
+    bool own_rotation = hal_rotation_alloc(cfg.buffer_size);
+    cfg.flags.sw_rotate = !own_rotation;
     
     lvDisp = bsp_display_start_with_config(&cfg);
     lv_display_set_rotation(lvDisp, LV_DISPLAY_ROTATION_90);
+    if (own_rotation) {
+        hal_rotation_install();
+    }
+    render_stats_attach(lvDisp);
     bsp_display_backlight_on();
 }
 
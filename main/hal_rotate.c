@@ -0,0 +1,384 @@
+#include "hal_rotate.h"
+#include <string.h>
+
+/*
+ * Pixel mapping matches lv_draw_sw_rotate() so the rotated area returned by
+ * lv_display_rotate_area() lines up:
+ *   90:  dst[r][c] = src[c][w - 1 - r]
+ *   180: dst[r][c] = src[h - 1 - r][w - 1 - c]
+ *   270: dst[r][c] = src[h - 1 - c][r]
+ *
+ * The naive loop walks one whole source column per destination row, touching a
+ * new cache line for every pixel. Here the source is processed in square
+ * tiles: while a tile is transposed its source lines stay resident, and every
+ * destination row segment written is one contiguous cache line.
+ *
+ * Only RGB565 90/270 of flush-sized areas gain from this, so hal_rotate()
+ * takes just those. 180 already runs row by row in lv_draw_sw_rotate(),
+ * blocking 3-byte RGB888 pixels, unrolled or not, did no better than it,
+ * and whole frames spill out of the cache either way.
+ */
+
+#define MIN_I32(a, b) ((a) < (b) ? (a) : (b))
+
+static void rotate90_rgb565(const uint16_t *src, uint16_t *dst, int32_t w, int32_t h,
+                            int32_t src_stride, int32_t dst_stride) {
+    const int32_t tile = HAL_ROTATE_TILE_RGB565;
+    for (int32_t ty = 0; ty < h; ty += tile) {
+        int32_t th = MIN_I32(tile, h - ty);
+        for (int32_t tx = 0; tx < w; tx += tile) {
+            int32_t tx_end = tx + MIN_I32(tile, w - tx);
+            int32_t x = tx;
+            // Four source columns per pass: one 8 byte read per source line
+            for (; x + 3 < tx_end; x += 4) {
+                const uint16_t *s = src + ty * src_stride + x;
+                uint16_t *d0 = dst + (w - 1 - x) * dst_stride + ty;
+                uint16_t *d1 = d0 - dst_stride;
+                uint16_t *d2 = d1 - dst_stride;
+                uint16_t *d3 = d2 - dst_stride;
+                for (int32_t y = 0; y < th; y++) {
+                    d0[y] = s[0];
+                    d1[y] = s[1];
+                    d2[y] = s[2];
+                    d3[y] = s[3];
+                    s += src_stride;
+                }
+            }
+            for (; x < tx_end; x++) {
+                const uint16_t *s = src + ty * src_stride + x;
+                uint16_t *d = dst + (w - 1 - x) * dst_stride + ty;
+                for (int32_t y = 0; y < th; y++) {
+                    d[y] = *s;
+                    s += src_stride;
+                }
+            }
+        }
+    }
+}
+
+static void rotate270_rgb565(const uint16_t *src, uint16_t *dst, int32_t w, int32_t h,
+                             int32_t src_stride, int32_t dst_stride) {
+    const int32_t tile = HAL_ROTATE_TILE_RGB565;
+    for (int32_t ty = 0; ty < h; ty += tile) {
+        int32_t th = MIN_I32(tile, h - ty);
+        for (int32_t tx = 0; tx < w; tx += tile) {
+            int32_t tx_end = tx + MIN_I32(tile, w - tx);
+            int32_t x = tx;
+            // Walk the tile bottom-up so destination writes stay sequential
+            for (; x + 3 < tx_end; x += 4) {
+                const uint16_t *s = src + (ty + th - 1) * src_stride + x;
+                uint16_t *d0 = dst + x * dst_stride + (h - ty - th);
+                uint16_t *d1 = d0 + dst_stride;
+                uint16_t *d2 = d1 + dst_stride;
+                uint16_t *d3 = d2 + dst_stride;
+                for (int32_t y = 0; y < th; y++) {
+                    d0[y] = s[0];
+                    d1[y] = s[1];
+                    d2[y] = s[2];
+                    d3[y] = s[3];
+                    s -= src_stride;
+                }
+            }
+            for (; x < tx_end; x++) {
+                const uint16_t *s = src + (ty + th - 1) * src_stride + x;
+                uint16_t *d = dst + x * dst_stride + (h - ty - th);
+                for (int32_t y = 0; y < th; y++) {
+                    d[y] = *s;
+                    s -= src_stride;
+                }
+            }
+        }
+    }
+}
+
+static void rotate180_rgb565(const uint16_t *src, uint16_t *dst, int32_t w, int32_t h,
+                             int32_t src_stride, int32_t dst_stride) {
+    // Already row by row; reading forwards lets the compiler vectorize it
+    for (int32_t y = 0; y < h; y++) {
+        const uint16_t *s = src + y * src_stride;
+        uint16_t *d = dst + (h - 1 - y) * dst_stride + (w - 1);
+        for (int32_t x = 0; x < w; x++) {
+            d[-x] = s[x];
+        }
+    }
+}
+
+void hal_rotate_rgb565(const uint16_t *src, uint16_t *dst, int32_t w, int32_t h,
+                       int32_t src_stride, int32_t dst_stride, lv_display_rotation_t rotation) {
+    // Kernels index in pixels
+    src_stride /= (int32_t)sizeof(uint16_t);
+    dst_stride /= (int32_t)sizeof(uint16_t);
+
+    switch (rotation) {
+        case LV_DISPLAY_ROTATION_90:
+            rotate90_rgb565(src, dst, w, h, src_stride, dst_stride);
+            break;
+        case LV_DISPLAY_ROTATION_180:
+            rotate180_rgb565(src, dst, w, h, src_stride, dst_stride);
+            break;
+        case LV_DISPLAY_ROTATION_270:
+            rotate270_rgb565(src, dst, w, h, src_stride, dst_stride);
+            break;
+        default:
+            for (int32_t y = 0; y < h; y++) {
+                memcpy(dst + y * dst_stride, src + y * src_stride, w * sizeof(uint16_t));
+            }
+            break;
+    }
+}
+
+bool hal_rotate(const void *src, void *dst, int32_t w, int32_t h,
+                int32_t src_stride, int32_t dst_stride,
+                lv_display_rotation_t rotation, lv_color_format_t cf) {
+    if (cf != LV_COLOR_FORMAT_RGB565 || (int64_t)w * h > HAL_ROTATE_MAX_PX ||
+        (rotation != LV_DISPLAY_ROTATION_90 && rotation != LV_DISPLAY_ROTATION_270)) {
+        return false;
+    }
+    hal_rotate_rgb565((const uint16_t *)src, (uint16_t *)dst, w, h, src_stride, dst_stride, rotation);
+    return true;
+}
+
+#if defined(HAL_ROTATE_HOST_MAIN) && !defined(ESP_PLATFORM)
+/*
+ * Host check of the blocked kernels against the per-pixel loop:
+ *   gcc -O2 -Wall -Wextra -DHAL_ROTATE_HOST_MAIN -o hal_rotate main/hal_rotate.c
+ *   ./hal_rotate [iterations]
+ *
+ * Every rotation is compared with the reference mapping above over sizes
+ * around the tile edge and the 4-column unroll, with tight and padded
+ * strides; row padding in the destination must stay untouched. Then
+ * flush bands, the largest area hal_rotate() takes and a full frame are
+ * timed against lv_draw_sw_rotate()'s loops.
+ * Add -DHAL_ROTATE_TILE_RGB565=<px> to time another tile edge.
+ */
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#define GUARD_BYTE 0xA5
+
+static const lv_display_rotation_t rotations[] = {
+    LV_DISPLAY_ROTATION_0, LV_DISPLAY_ROTATION_90, LV_DISPLAY_ROTATION_180, LV_DISPLAY_ROTATION_270,
+};
+static const int rotation_degrees[] = { 0, 90, 180, 270 };
+
+// The per-pixel loop the kernels replace, with the mapping written out
+static void reference_rotate(const uint8_t *src, uint8_t *dst, int32_t w, int32_t h,
+                             int32_t src_stride, int32_t dst_stride,
+                             lv_display_rotation_t rotation, int32_t px) {
+    bool swap = rotation == LV_DISPLAY_ROTATION_90 || rotation == LV_DISPLAY_ROTATION_270;
+    int32_t dw = swap ? h : w;
+    int32_t dh = swap ? w : h;
+    for (int32_t r = 0; r < dh; r++) {
+        for (int32_t c = 0; c < dw; c++) {
+            int32_t sy, sx;
+            switch (rotation) {
+                case LV_DISPLAY_ROTATION_90:  sy = c;         sx = w - 1 - r; break;
+                case LV_DISPLAY_ROTATION_180: sy = h - 1 - r; sx = w - 1 - c; break;
+                case LV_DISPLAY_ROTATION_270: sy = h - 1 - c; sx = r;         break;
+                default:                      sy = r;         sx = c;         break;
+            }
+            memcpy(dst + r * dst_stride + c * px, src + sy * src_stride + sx * px, (size_t)px);
+        }
+    }
+}
+
+/*
+ * What the flush did before: lv_draw_sw_rotate()'s RGB565 loops, one
+ * destination row (a whole source column) at a time. The kernels are
+ * timed against this, not the reference above, whose per-pixel switch and
+ * memcpy would flatter them.
+ */
+static void lvgl_rotate_rgb565(const uint16_t *src, uint16_t *dst, int32_t w, int32_t h,
+                               int32_t src_stride, int32_t dst_stride, lv_display_rotation_t rotation) {
+    src_stride /= (int32_t)sizeof(uint16_t);
+    dst_stride /= (int32_t)sizeof(uint16_t);
+    if (rotation == LV_DISPLAY_ROTATION_180) {
+        for (int32_t y = 0; y < h; y++) {
+            int32_t d = (h - y - 1) * dst_stride;
+            int32_t s = y * src_stride;
+            for (int32_t x = 0; x < w; x++) {
+                dst[d + w - x - 1] = src[s + x];
+            }
+        }
+        return;
+    }
+    for (int32_t x = 0; x < w; x++) {
+        if (rotation == LV_DISPLAY_ROTATION_90) {
+            const uint16_t *s = src + x;
+            uint16_t *d = dst + (w - 1 - x) * dst_stride;
+            for (int32_t y = 0; y < h; y++, s += src_stride) {
+                d[y] = *s;
+            }
+        } else {
+            const uint16_t *s = src + (h - 1) * src_stride + x;
+            uint16_t *d = dst + x * dst_stride;
+            for (int32_t y = 0; y < h; y++, s -= src_stride) {
+                d[y] = *s;
+            }
+        }
+    }
+}
+
+static void fill_random(uint8_t *buffer, size_t len, uint32_t seed) {
+    for (size_t i = 0; i < len; i++) {
+        seed = seed * 1664525u + 1013904223u;
+        buffer[i] = (uint8_t)(seed >> 24);
+    }
+}
+
+// The draw buffer (BSP_LCD_DRAW_BUFF_SIZE, 720 x 50 px) as full-width rows
+#define BAND_ROWS (720 * 50 / 1280)
+
+// Returns the number of mismatching bytes, including overwritten padding
+static size_t check_case(int32_t w, int32_t h, int32_t src_pad, int32_t dst_pad,
+                         lv_display_rotation_t rotation) {
+    bool swap = rotation == LV_DISPLAY_ROTATION_90 || rotation == LV_DISPLAY_ROTATION_270;
+    int32_t dw = swap ? h : w;
+    int32_t dh = swap ? w : h;
+    int32_t src_stride = w * 2 + src_pad;
+    int32_t dst_stride = dw * 2 + dst_pad;
+    size_t src_size = (size_t)src_stride * (size_t)h;
+    size_t dst_size = (size_t)dst_stride * (size_t)dh;
+
+    // 16-bit kernels need 2-byte aligned rows, as on the device
+    uint8_t *src = aligned_alloc(16, (src_size + 15) & ~(size_t)15);
+    uint8_t *got = aligned_alloc(16, (dst_size + 15) & ~(size_t)15);
+    uint8_t *want = malloc(dst_size);
+    if (!src || !got || !want) {
+        fprintf(stderr, "Out of memory\n");
+        exit(1);
+    }
+    fill_random(src, src_size, (uint32_t)(w * 7919 + h * 104729 + rotation));
+    memset(got, GUARD_BYTE, dst_size);
+    memset(want, GUARD_BYTE, dst_size);
+
+    reference_rotate(src, want, w, h, src_stride, dst_stride, rotation, 2);
+    hal_rotate_rgb565((const uint16_t *)src, (uint16_t *)got, w, h, src_stride, dst_stride, rotation);
+
+    size_t bad = 0;
+    for (size_t i = 0; i < dst_size; i++) {
+        bad += got[i] != want[i];
+    }
+    free(src);
+    free(got);
+    free(want);
+    return bad;
+}
+
+static double now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1e6;
+}
+
+static void time_case(const char *label, int32_t w, int32_t h, lv_display_rotation_t rotation, int iterations) {
+    bool swap = rotation == LV_DISPLAY_ROTATION_90 || rotation == LV_DISPLAY_ROTATION_270;
+    int32_t src_stride = w * 2;
+    int32_t dst_stride = (swap ? h : w) * 2;
+    size_t size = (size_t)src_stride * (size_t)h;
+    uint16_t *src = aligned_alloc(64, (size + 63) & ~(size_t)63);
+    uint16_t *dst = aligned_alloc(64, (size + 63) & ~(size_t)63);
+    if (!src || !dst) {
+        fprintf(stderr, "Out of memory\n");
+        exit(1);
+    }
+    fill_random((uint8_t *)src, size, 1);
+    memset(dst, 0, size);
+
+    // Best of five rounds each, alternating, so a noisy host hurts both alike
+    double lvgl = 0;
+    double blocked = 0;
+    for (int round = 0; round < 5; round++) {
+        double start = now_ms();
+        for (int i = 0; i < iterations; i++) {
+            lvgl_rotate_rgb565(src, dst, w, h, src_stride, dst_stride, rotation);
+        }
+        double ms = (now_ms() - start) / iterations;
+        lvgl = round == 0 || ms < lvgl ? ms : lvgl;
+
+        start = now_ms();
+        for (int i = 0; i < iterations; i++) {
+            hal_rotate_rgb565(src, dst, w, h, src_stride, dst_stride, rotation);
+        }
+        ms = (now_ms() - start) / iterations;
+        blocked = round == 0 || ms < blocked ? ms : blocked;
+    }
+
+    printf("%-5s %4dx%-4d %3d deg  lv_draw_sw_rotate %7.3f ms  blocked %7.3f ms  %5.2fx\n",
+           label, (int)w, (int)h, rotation_degrees[rotation], lvgl, blocked, blocked > 0 ? lvgl / blocked : 0.0);
+    free(src);
+    free(dst);
+}
+
+int main(int argc, char **argv) {
+    int iterations = argc > 1 ? atoi(argv[1]) : 20;
+    if (iterations < 1) {
+        iterations = 1;
+    }
+
+    // Around the tile edge, the 4-column unroll and odd sizes
+    static const int32_t sizes[] = { 1, 2, 3, 4, 5, 7, 31, 32, 33, 63, 64, 65, 67, 100, 129 };
+    static const int32_t pads[] = { 0, 2, 6, 64 };
+    const int size_count = (int)(sizeof(sizes) / sizeof(sizes[0]));
+    const int pad_count = (int)(sizeof(pads) / sizeof(pads[0]));
+
+    uint32_t cases = 0;
+    uint32_t failures = 0;
+    for (int r = 0; r < 4; r++) {
+        for (int wi = 0; wi < size_count; wi++) {
+            for (int hi = 0; hi < size_count; hi++) {
+                for (int sp = 0; sp < pad_count; sp++) {
+                    for (int dp = 0; dp < pad_count; dp++) {
+                        size_t bad = check_case(sizes[wi], sizes[hi], pads[sp], pads[dp], rotations[r]);
+                        cases++;
+                        if (bad) {
+                            failures++;
+                            if (failures <= 10) {
+                                printf("FAIL %3d deg %dx%d src pad %d dst pad %d: %zu bytes differ\n",
+                                       rotation_degrees[r], (int)sizes[wi], (int)sizes[hi],
+                                       (int)pads[sp], (int)pads[dp], bad);
+                            }
+                        }
+                    }
+                }
+            }
+        }
+    }
+    // The panel itself, 720x1280 rendered as 1280x720
+    for (int r = 0; r < 4; r++) {
+        cases++;
+        if (check_case(1280, 720, 0, 0, rotations[r])) {
+            failures++;
+            printf("FAIL full frame %d deg\n", rotation_degrees[r]);
+        }
+    }
+    // What hal_rotate() leaves to lv_draw_sw_rotate(); it must not touch the buffers
+    static const struct {
+        const char *label;
+        int32_t w, h;
+        lv_display_rotation_t rotation;
+        lv_color_format_t cf;
+    } refused[] = {
+        { "RGB888",     1,    1,   LV_DISPLAY_ROTATION_90,  LV_COLOR_FORMAT_RGB888 },
+        { "180 deg",    1,    1,   LV_DISPLAY_ROTATION_180, LV_COLOR_FORMAT_RGB565 },
+        { "full frame", 1280, 720, LV_DISPLAY_ROTATION_90,  LV_COLOR_FORMAT_RGB565 },
+    };
+    for (size_t i = 0; i < sizeof(refused) / sizeof(refused[0]); i++) {
+        cases++;
+        if (hal_rotate(NULL, NULL, refused[i].w, refused[i].h, 0, 0, refused[i].rotation, refused[i].cf)) {
+            failures++;
+            printf("FAIL %s was not refused\n", refused[i].label);
+        }
+    }
+    printf("%" PRIu32 " cases, %" PRIu32 " failures, %d px tiles\n", cases, failures, HAL_ROTATE_TILE_RGB565);
+
+    for (int r = 1; r < 4; r += 2) {
+        time_case("band", 1280, BAND_ROWS, rotations[r], iterations * 20);
+        time_case("limit", 1280, HAL_ROTATE_MAX_PX / 1280, rotations[r], iterations);
+        time_case("frame", 1280, 720, rotations[r], iterations);
+    }
+    return failures ? 1 : 0;
+}
+#endif
@@ -0,0 +1,246 @@
+#include "listing_cache.h"
+#include "sd_manager.h"
+#include "esp_log.h"
+#include "esp_heap_caps.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include <string.h>
+#include <stdio.h>
+#include <sys/stat.h>
+
+static const char *TAG = "LISTING_CACHE";
+
+#define CACHE_PATH_LEN 256
+
+/*
+ * Small LRU of complete directory listings, stored in PSRAM. Entries are
+ * dropped precisely by file_operations when it changes a directory, and a
+ * directory's modification stamp is checked on every hit as a second guard.
+ * FAT only updates that stamp for some changes, so the explicit invalidation
+ * is what keeps the cache correct; the stamp catches the rest when it can.
+ */
+typedef struct {
+    bool used;
+    bool show_hidden;
+    char path[CACHE_PATH_LEN];
+    time_t stamp;
+    uint32_t last_used;
+    file_listing_t listing;
+} cache_slot_t;
+
+static cache_slot_t slots[LISTING_CACHE_SLOTS];
+static listing_cache_stats_t stats = {0};
+static uint32_t use_clock = 0;
+static SemaphoreHandle_t cache_lock = NULL;
+
+// Canonical form: leading '/', no repeated or trailing '/' (except root)
+static bool normalize_path(const char *in, char *out, size_t out_size) {
+    size_t len = 0;
+    out[len++] = '/';
+    for (const char *p = in; *p; p++) {
+        if (*p == '/' && out[len - 1] == '/') {
+            continue;
+        }
+        if (len + 1 >= out_size) {
+            return false;
+        }
+        out[len++] = *p;
+    }
+    if (len > 1 && out[len - 1] == '/') {
+        len--;
+    }
+    out[len] = '\0';
+    return true;
+}
+
+static time_t dir_stamp(const char *path) {
+    char full_path[CACHE_PATH_LEN + 16];
+    snprintf(full_path, sizeof(full_path), "%s%s", SD_MOUNT_POINT, strcmp(path, "/") == 0 ? "" : path);
+
+    // The root directory has no entry of its own and therefore no stamp
+    struct stat st;
+    return stat(full_path, &st) == 0 ? st.st_mtime : 0;
+}
+
+static void drop_slot(cache_slot_t *slot) {
+    stats.bytes -= file_listing_memory(&slot->listing);
+    stats.entries--;
+    file_listing_free(&slot->listing);
+    slot->used = false;
+}
+
+static cache_slot_t* find_slot(const char *path, bool show_hidden) {
+    for (int i = 0; i < LISTING_CACHE_SLOTS; i++) {
+        if (slots[i].used && slots[i].show_hidden == show_hidden && strcmp(slots[i].path, path) == 0) {
+            return &slots[i];
+        }
+    }
+    return NULL;
+}
+
+static cache_slot_t* least_recently_used(void) {
+    cache_slot_t *lru = NULL;
+    for (int i = 0; i < LISTING_CACHE_SLOTS; i++) {
+        if (slots[i].used && (!lru || slots[i].last_used < lru->last_used)) {
+            lru = &slots[i];
+        }
+    }
+    return lru;
+}
+
+esp_err_t listing_cache_init(void) {
+    if (cache_lock) {
+        return ESP_OK;
+    }
+    cache_lock = xSemaphoreCreateMutex();
+    if (!cache_lock) {
+        ESP_LOGE(TAG, "Failed to create cache lock");
+        return ESP_ERR_NO_MEM;
+    }
+    return ESP_OK;
+}
+
+bool listing_cache_lookup(const char *path, bool show_hidden, file_listing_t *dest) {
+    char key[CACHE_PATH_LEN];
+    if (!cache_lock || !normalize_path(path, key, sizeof(key))) {
+        return false;
+    }
+
+    xSemaphoreTake(cache_lock, portMAX_DELAY);
+    cache_slot_t *slot = find_slot(key, show_hidden);
+    if (slot && dir_stamp(key) != slot->stamp) {
+        ESP_LOGD(TAG, "Stale listing for %s", key);
+        drop_slot(slot);
+        stats.stale++;
+        slot = NULL;
+    }
+
+    bool hit = slot && file_listing_copy(dest, &slot->listing) == ESP_OK;
+    if (hit) {
+        slot->last_used = ++use_clock;
+        stats.hits++;
+    } else {
+        stats.misses++;
+    }
+    xSemaphoreGive(cache_lock);
+
+    return hit;
+}
+
+void listing_cache_store(const char *path, bool show_hidden, const file_listing_t *listing) {
+    char key[CACHE_PATH_LEN];
+    if (!cache_lock || !normalize_path(path, key, sizeof(key))) {
+        return;
+    }
+
+    // Cached copies are exact size, so this is what the clone will take
+    size_t needed = file_listing_memory(&(file_listing_t){
+        .capacity = listing->count ? listing->count : 1,
+        .arena_size = listing->arena_used ? listing->arena_used : 1
+    });
+    if (needed > LISTING_CACHE_MAX_BYTES) {
+        ESP_LOGD(TAG, "Listing of %s too large to cache (%u bytes)", key, (unsigned)needed);
+        return;
+    }
+
+    xSemaphoreTake(cache_lock, portMAX_DELAY);
+    cache_slot_t *slot = find_slot(key, show_hidden);
+    if (slot) {
+        drop_slot(slot);
+    }
+
+    slot = NULL;
+    for (int i = 0; i < LISTING_CACHE_SLOTS && !slot; i++) {
+        if (!slots[i].used) {
+            slot = &slots[i];
+        }
+    }
+    while (!slot || stats.bytes + needed > LISTING_CACHE_MAX_BYTES) {
+        cache_slot_t *victim = least_recently_used();
+        if (!victim) {
+            break;
+        }
+        drop_slot(victim);
+        stats.evictions++;
+        if (!slot) {
+            slot = victim;
+        }
+    }
+
+    if (slot && file_listing_clone(&slot->listing, listing, MALLOC_CAP_SPIRAM) == ESP_OK) {
+        strcpy(slot->path, key);
+        slot->show_hidden = show_hidden;
+        slot->stamp = dir_stamp(key);
+        slot->last_used = ++use_clock;
+        slot->used = true;
+        stats.entries++;
+        stats.bytes += file_listing_memory(&slot->listing);
+    }
+    xSemaphoreGive(cache_lock);
+}
+
+void listing_cache_invalidate_parent(const char *path) {
+    char key[CACHE_PATH_LEN];
+    if (!cache_lock || !normalize_path(path, key, sizeof(key))) {
+        return;
+    }
+
+    char *last_slash = strrchr(key, '/');
+    if (last_slash == key) {
+        key[1] = '\0';
+    } else if (last_slash) {
+        *last_slash = '\0';
+    }
+
+    xSemaphoreTake(cache_lock, portMAX_DELAY);
+    for (int i = 0; i < LISTING_CACHE_SLOTS; i++) {
+        if (slots[i].used && strcmp(slots[i].path, key) == 0) {
+            drop_slot(&slots[i]);
+            stats.invalidations++;
+        }
+    }
+    xSemaphoreGive(cache_lock);
+}
+
+void listing_cache_invalidate_tree(const char *path) {
+    char key[CACHE_PATH_LEN];
+    if (!cache_lock || !normalize_path(path, key, sizeof(key))) {
+        return;
+    }
+    size_t key_len = strcmp(key, "/") == 0 ? 0 : strlen(key);
+
+    xSemaphoreTake(cache_lock, portMAX_DELAY);
+    for (int i = 0; i < LISTING_CACHE_SLOTS; i++) {
+        const char *slot_path = slots[i].path;
+        if (slots[i].used && strncmp(slot_path, key, key_len) == 0 &&
+            (slot_path[key_len] == '\0' || slot_path[key_len] == '/')) {
+            drop_slot(&slots[i]);
+            stats.invalidations++;
+        }
+    }
+    xSemaphoreGive(cache_lock);
+}
+
+void listing_cache_clear(void) {
+    if (!cache_lock) {
+        return;
+    }
+    xSemaphoreTake(cache_lock, portMAX_DELAY);
+    for (int i = 0; i < LISTING_CACHE_SLOTS; i++) {
+        if (slots[i].used) {
+            drop_slot(&slots[i]);
+            stats.invalidations++;
+        }
+    }
+    xSemaphoreGive(cache_lock);
+}
+
+void listing_cache_get_stats(listing_cache_stats_t *out) {
+    if (!cache_lock) {
+        memset(out, 0, sizeof(*out));
+        return;
+    }
+    xSemaphoreTake(cache_lock, portMAX_DELAY);
+    *out = stats;
+    xSemaphoreGive(cache_lock);
+}
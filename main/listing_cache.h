@@ -0,0 +1,70 @@
+#ifndef LISTING_CACHE_H
+#define LISTING_CACHE_H
+
+#include "esp_err.h"
+#include "file_listing.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Number of directories kept and total PSRAM they may use
+#define LISTING_CACHE_SLOTS     8
+#define LISTING_CACHE_MAX_BYTES (1024 * 1024)
+
+typedef struct {
+    uint32_t hits;
+    uint32_t misses;
+    uint32_t stale;           // Lookups rejected by the directory stamp
+    uint32_t invalidations;
+    uint32_t evictions;
+    uint32_t entries;
+    size_t bytes;
+} listing_cache_stats_t;
+
+/**
+ * @brief Initialize the listing cache
+ * @return ESP_OK on success
+ */
+esp_err_t listing_cache_init(void);
+
+/**
+ * @brief Look up a cached directory listing
+ * @param path Directory path (relative to SD root)
+ * @param show_hidden Hidden-file setting the listing was made with
+ * @param dest Listing to copy the cached entries into
+ * @return true on a hit; dest is untouched on a miss
+ */
+bool listing_cache_lookup(const char *path, bool show_hidden, file_listing_t *dest);
+
+/**
+ * @brief Store a complete directory listing, evicting least recently used ones
+ * @param path Directory path (relative to SD root)
+ * @param show_hidden Hidden-file setting the listing was made with
+ * @param listing Complete listing to copy into the cache
+ */
+void listing_cache_store(const char *path, bool show_hidden, const file_listing_t *listing);
+
+/**
+ * @brief Drop the cached listing of the directory containing path
+ * @param path File or directory path (relative to SD root)
+ */
+void listing_cache_invalidate_parent(const char *path);
+
+/**
+ * @brief Drop cached listings of a directory and everything below it
+ * @param path Directory path (relative to SD root)
+ */
+void listing_cache_invalidate_tree(const char *path);
+
+/**
+ * @brief Drop every cached listing (card mounted, unmounted or formatted)
+ */
+void listing_cache_clear(void);
+
+/**
+ * @brief Get cache counters
+ * @param stats Output statistics
+ */
+void listing_cache_get_stats(listing_cache_stats_t *stats);
+
+#endif // LISTING_CACHE_H
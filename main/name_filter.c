@@ -0,0 +1,101 @@
+#include "name_filter.h"
+#include "esp_log.h"
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+
+static const char *TAG = "NAME_FILTER";
+
+esp_err_t name_filter_update(name_filter_t *filter, const file_listing_t *listing) {
+    if (listing->arena_used < filter->folded_used) {
+        // The listing was cleared and refilled behind our back
+        filter->folded_used = 0;
+    }
+
+    if (listing->arena_used > filter->folded_size) {
+        char *folded = realloc(filter->folded, listing->arena_size);
+        if (!folded) {
+            ESP_LOGE(TAG, "Failed to grow filter index to %u bytes", (unsigned)listing->arena_size);
+            return ESP_ERR_NO_MEM;
+        }
+        filter->folded = folded;
+        filter->folded_size = listing->arena_size;
+    }
+
+    for (uint32_t i = filter->folded_used; i < listing->arena_used; i++) {
+        filter->folded[i] = (char)tolower((unsigned char)listing->arena[i]);
+    }
+    filter->folded_used = listing->arena_used;
+    return ESP_OK;
+}
+
+uint32_t name_filter_match(const name_filter_t *filter, const file_listing_t *listing,
+                           const char *needle, uint32_t first, uint32_t *match_bits) {
+    if (first >= listing->count) {
+        return 0;
+    }
+
+    // Clear the bits being rewritten: the tail of first's word, then whole words
+    uint32_t word = first >> 5;
+    match_bits[word] &= (1u << (first & 31)) - 1;
+    uint32_t words = (listing->count + 31) >> 5;
+    if (words > word + 1) {
+        memset(&match_bits[word + 1], 0, (words - word - 1) * sizeof(uint32_t));
+    }
+
+    char folded_needle[NAME_FILTER_MAX_LEN + 1];
+    size_t needle_len = 0;
+    while (needle[needle_len] && needle_len < NAME_FILTER_MAX_LEN) {
+        folded_needle[needle_len] = (char)tolower((unsigned char)needle[needle_len]);
+        needle_len++;
+    }
+    if (needle_len == 0) {
+        return 0;
+    }
+
+    /*
+     * One pass over the whole folded arena instead of one search per name:
+     * memchr finds candidate first bytes a word at a time, and since the
+     * needle holds no NUL a match can never straddle two names. The entry
+     * cursor only moves forward, so mapping hits back to entries is linear.
+     */
+    const char *base = filter->folded;
+    const char *p = base + listing->name_offset[first];
+    const char *end = base + filter->folded_used;
+    uint32_t entry = first;
+    uint32_t matches = 0;
+
+    while (p + needle_len <= end) {
+        p = memchr(p, folded_needle[0], (size_t)(end - p) - needle_len + 1);
+        if (!p) {
+            break;
+        }
+        if (memcmp(p + 1, folded_needle + 1, needle_len - 1) != 0) {
+            p++;
+            continue;
+        }
+
+        uint32_t offset = (uint32_t)(p - base);
+        while (entry + 1 < listing->count && listing->name_offset[entry + 1] <= offset) {
+            entry++;
+        }
+        match_bits[entry >> 5] |= 1u << (entry & 31);
+        matches++;
+
+        // Rest of this name cannot add anything
+        if (++entry >= listing->count) {
+            break;
+        }
+        p = base + listing->name_offset[entry];
+    }
+    return matches;
+}
+
+void name_filter_reset(name_filter_t *filter) {
+    filter->folded_used = 0;
+}
+
+void name_filter_free(name_filter_t *filter) {
+    free(filter->folded);
+    memset(filter, 0, sizeof(*filter));
+}
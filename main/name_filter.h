@@ -0,0 +1,69 @@
+#ifndef NAME_FILTER_H
+#define NAME_FILTER_H
+
+#include "esp_err.h"
+#include "file_listing.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+// Longest filter string accepted, excluding the terminator
+#define NAME_FILTER_MAX_LEN 63
+
+/*
+ * Lowercase copy of a listing's name arena, laid out at the same offsets so a
+ * match position maps straight back to an entry. It is extended as the
+ * listing grows and has to be reset whenever the listing is cleared.
+ */
+typedef struct {
+    char *folded;
+    uint32_t folded_used;
+    uint32_t folded_size;
+} name_filter_t;
+
+/**
+ * @brief Bring the lowercase index up to date with a listing
+ *
+ * Only names added since the last call are folded.
+ *
+ * @param filter Filter index
+ * @param listing Listing the index mirrors
+ * @return ESP_OK on success, ESP_ERR_NO_MEM on allocation failure
+ */
+esp_err_t name_filter_update(name_filter_t *filter, const file_listing_t *listing);
+
+/**
+ * @brief Mark the entries whose name contains a substring (case-insensitive)
+ *
+ * Bits for entries before 'first' are left as they are; bits from 'first' on
+ * are rewritten. The index must be up to date (see name_filter_update()).
+ *
+ * @param filter Filter index
+ * @param listing Listing the index mirrors
+ * @param needle Substring to look for (non-empty)
+ * @param first First entry to test
+ * @param match_bits Bitset with at least listing->count bits
+ * @return Number of matching entries from 'first' on
+ */
+uint32_t name_filter_match(const name_filter_t *filter, const file_listing_t *listing,
+                           const char *needle, uint32_t first, uint32_t *match_bits);
+
+/**
+ * @brief Forget all indexed names, keeping the storage
+ * @param filter Filter index
+ */
+void name_filter_reset(name_filter_t *filter);
+
+/**
+ * @brief Release the index storage
+ * @param filter Filter index
+ */
+void name_filter_free(name_filter_t *filter);
+
+/**
+ * @brief Test one entry's bit in a match bitset
+ */
+static inline bool name_filter_matched(const uint32_t *match_bits, uint32_t index) {
+    return (match_bits[index >> 5] >> (index & 31)) & 1;
+}
+
+#endif // NAME_FILTER_H
@@ -0,0 +1,283 @@
+#include "render_stats.h"
+#include "sd_manager.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include <stdio.h>
+#include <string.h>
+#include <inttypes.h>
+
+static const char *TAG = "RENDER_STATS";
+
+// Upper bucket edges in microseconds; the last bucket catches everything above
+static const uint32_t time_bucket_edges_us[RENDER_STATS_HIST_BUCKETS - 1] = {
+    1000, 2000, 4000, 8000, 16000, 33000, 66000
+};
+static const char *time_bucket_labels[RENDER_STATS_HIST_BUCKETS] = {
+    "<1ms", "<2ms", "<4ms", "<8ms", "<16ms", "<33ms", "<66ms", ">=66ms"
+};
+
+// Upper bucket edges in percent of the screen area
+static const uint32_t area_bucket_edges_pct[RENDER_STATS_HIST_BUCKETS - 1] = {
+    1, 5, 10, 25, 50, 75, 100
+};
+static const char *area_bucket_labels[RENDER_STATS_HIST_BUCKETS] = {
+    "<1%", "<5%", "<10%", "<25%", "<50%", "<75%", "<100%", "100%"
+};
+
+static lv_display_t *stats_disp = NULL;
+static portMUX_TYPE stats_mutex = portMUX_INITIALIZER_UNLOCKED;
+
+// Aggregates (guarded by stats_mutex)
+static render_stats_t stats;
+static uint64_t total_frame_us = 0;
+static uint64_t total_flush_us = 0;
+static uint64_t total_area_px = 0;
+static render_frame_sample_t samples[RENDER_STATS_SAMPLE_COUNT];
+static uint32_t sample_head = 0;
+
+// In-flight frame (only touched from the LVGL task)
+static int64_t frame_start_us = 0;
+static int64_t flush_start_us = 0;
+static uint32_t pending_area_px = 0;
+static uint32_t screen_area_px = 0;
+static render_frame_sample_t frame;
+
+static int bucket_for(uint32_t value, const uint32_t *edges) {
+    for (int i = 0; i < RENDER_STATS_HIST_BUCKETS - 1; i++) {
+        if (value < edges[i]) {
+            return i;
+        }
+    }
+    return RENDER_STATS_HIST_BUCKETS - 1;
+}
+
+// Walks the whole tree, so only done when a snapshot is taken, not per frame
+static uint32_t count_objects(const lv_obj_t *obj) {
+    if (!obj) {
+        return 0;
+    }
+    uint32_t count = 1;
+    uint32_t child_count = lv_obj_get_child_count(obj);
+    for (uint32_t i = 0; i < child_count; i++) {
+        count += count_objects(lv_obj_get_child(obj, i));
+    }
+    return count;
+}
+
+static void commit_frame(void) {
+    uint32_t area_pct = stats.screen_area_px ?
+        (uint32_t)(((uint64_t)frame.area_px * 100) / stats.screen_area_px) : 0;
+
+    portENTER_CRITICAL(&stats_mutex);
+    stats.frame_count++;
+    stats.last = frame;
+
+    total_frame_us += frame.frame_us;
+    total_flush_us += frame.flush_us;
+    total_area_px += frame.area_px;
+    stats.avg_frame_us = (uint32_t)(total_frame_us / stats.frame_count);
+    stats.avg_flush_us = (uint32_t)(total_flush_us / stats.frame_count);
+    stats.avg_area_px = (uint32_t)(total_area_px / stats.frame_count);
+    if (frame.frame_us > stats.max_frame_us) stats.max_frame_us = frame.frame_us;
+    if (frame.flush_us > stats.max_flush_us) stats.max_flush_us = frame.flush_us;
+    if (frame.area_px > stats.max_area_px) stats.max_area_px = frame.area_px;
+
+    stats.frame_hist[bucket_for(frame.frame_us, time_bucket_edges_us)]++;
+    stats.flush_hist[bucket_for(frame.flush_us, time_bucket_edges_us)]++;
+    stats.area_hist[bucket_for(area_pct, area_bucket_edges_pct)]++;
+
+    samples[sample_head] = frame;
+    sample_head = (sample_head + 1) % RENDER_STATS_SAMPLE_COUNT;
+    portEXIT_CRITICAL(&stats_mutex);
+}
+
+static void display_event_cb(lv_event_t *e) {
+    lv_event_code_t code = lv_event_get_code(e);
+
+    switch (code) {
+        case LV_EVENT_INVALIDATE_AREA: {
+            // Areas are already clipped to the screen; overlaps are counted twice,
+            // which is what we want to see when widgets invalidate too eagerly, but
+            // a frame never renders more than the whole screen
+            const lv_area_t *area = (const lv_area_t *)lv_event_get_param(e);
+            if (area) {
+                uint64_t sum = (uint64_t)pending_area_px + lv_area_get_size(area);
+                pending_area_px = sum > screen_area_px ? screen_area_px : (uint32_t)sum;
+            }
+            break;
+        }
+        case LV_EVENT_RENDER_START:
+            memset(&frame, 0, sizeof(frame));
+            frame.area_px = pending_area_px;
+            pending_area_px = 0;
+            frame_start_us = esp_timer_get_time();
+            break;
+        case LV_EVENT_FLUSH_START:
+            flush_start_us = esp_timer_get_time();
+            break;
+        case LV_EVENT_FLUSH_FINISH:
+            if (flush_start_us) {
+                frame.flush_us += (uint32_t)(esp_timer_get_time() - flush_start_us);
+                frame.flush_count++;
+                flush_start_us = 0;
+            }
+            break;
+        case LV_EVENT_RENDER_READY:
+            if (frame_start_us) {
+                frame.frame_us = (uint32_t)(esp_timer_get_time() - frame_start_us);
+                frame_start_us = 0;
+                commit_frame();
+            }
+            break;
+        default:
+            break;
+    }
+}
+
+esp_err_t render_stats_attach(lv_display_t *disp) {
+    if (!disp) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (stats_disp) {
+        ESP_LOGW(TAG, "Render statistics already attached");
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    stats_disp = disp;
+    render_stats_reset();
+
+    lv_display_add_event_cb(disp, display_event_cb, LV_EVENT_INVALIDATE_AREA, NULL);
+    lv_display_add_event_cb(disp, display_event_cb, LV_EVENT_RENDER_START, NULL);
+    lv_display_add_event_cb(disp, display_event_cb, LV_EVENT_RENDER_READY, NULL);
+    lv_display_add_event_cb(disp, display_event_cb, LV_EVENT_FLUSH_START, NULL);
+    lv_display_add_event_cb(disp, display_event_cb, LV_EVENT_FLUSH_FINISH, NULL);
+
+    ESP_LOGI(TAG, "Render statistics attached (%" PRIu32 " px screen)", stats.screen_area_px);
+    return ESP_OK;
+}
+
+static uint32_t count_display_objects(void) {
+    if (!stats_disp) {
+        return 0;
+    }
+    return count_objects(lv_display_get_screen_active(stats_disp)) +
+           count_objects(lv_display_get_layer_top(stats_disp));
+}
+
+void render_stats_get(render_stats_t *out) {
+    if (!out) {
+        return;
+    }
+    uint32_t objects = count_display_objects();
+    portENTER_CRITICAL(&stats_mutex);
+    *out = stats;
+    portEXIT_CRITICAL(&stats_mutex);
+    out->obj_count = objects;
+}
+
+uint32_t render_stats_get_last(render_frame_sample_t *out) {
+    portENTER_CRITICAL(&stats_mutex);
+    uint32_t frames = stats.frame_count;
+    if (out) {
+        *out = stats.last;
+    }
+    portEXIT_CRITICAL(&stats_mutex);
+    return frames;
+}
+
+void render_stats_reset(void) {
+    uint32_t screen_area = 0;
+    if (stats_disp) {
+        screen_area = (uint32_t)lv_display_get_horizontal_resolution(stats_disp) *
+                      (uint32_t)lv_display_get_vertical_resolution(stats_disp);
+    }
+
+    screen_area_px = screen_area;
+    portENTER_CRITICAL(&stats_mutex);
+    memset(&stats, 0, sizeof(stats));
+    memset(samples, 0, sizeof(samples));
+    stats.screen_area_px = screen_area;
+    total_frame_us = 0;
+    total_flush_us = 0;
+    total_area_px = 0;
+    sample_head = 0;
+    portEXIT_CRITICAL(&stats_mutex);
+}
+
+const char* render_stats_time_bucket_label(int bucket) {
+    if (bucket < 0 || bucket >= RENDER_STATS_HIST_BUCKETS) {
+        return "";
+    }
+    return time_bucket_labels[bucket];
+}
+
+const char* render_stats_area_bucket_label(int bucket) {
+    if (bucket < 0 || bucket >= RENDER_STATS_HIST_BUCKETS) {
+        return "";
+    }
+    return area_bucket_labels[bucket];
+}
+
+esp_err_t render_stats_dump_csv(const char *path) {
+    if (!path) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (!sd_manager_is_mounted()) {
+        ESP_LOGE(TAG, "SD card not mounted");
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    // Snapshot first so the LVGL task is never blocked on SD writes
+    render_stats_t snapshot;
+    static render_frame_sample_t sample_copy[RENDER_STATS_SAMPLE_COUNT];
+    uint32_t head;
+    portENTER_CRITICAL(&stats_mutex);
+    snapshot = stats;
+    memcpy(sample_copy, samples, sizeof(samples));
+    head = sample_head;
+    portEXIT_CRITICAL(&stats_mutex);
+    snapshot.obj_count = count_display_objects();
+
+    FILE *f = sd_manager_open_file(path, "w");
+    if (!f) {
+        ESP_LOGE(TAG, "Failed to create %s", path);
+        return ESP_FAIL;
+    }
+
+    fprintf(f, "frame,frame_us,flush_us,flush_count,area_px\n");
+    uint32_t available = snapshot.frame_count < RENDER_STATS_SAMPLE_COUNT ?
+                         snapshot.frame_count : RENDER_STATS_SAMPLE_COUNT;
+    uint32_t first_frame = snapshot.frame_count - available;
+    for (uint32_t i = 0; i < available; i++) {
+        uint32_t slot = (head + RENDER_STATS_SAMPLE_COUNT - available + i) % RENDER_STATS_SAMPLE_COUNT;
+        const render_frame_sample_t *s = &sample_copy[slot];
+        fprintf(f, "%" PRIu32 ",%" PRIu32 ",%" PRIu32 ",%u,%" PRIu32 "\n",
+                first_frame + i, s->frame_us, s->flush_us, s->flush_count, s->area_px);
+    }
+
+    fprintf(f, "\nbucket,frame_time,flush_time,area_bucket,area\n");
+    for (int i = 0; i < RENDER_STATS_HIST_BUCKETS; i++) {
+        fprintf(f, "%s,%" PRIu32 ",%" PRIu32 ",%s,%" PRIu32 "\n",
+                time_bucket_labels[i], snapshot.frame_hist[i], snapshot.flush_hist[i],
+                area_bucket_labels[i], snapshot.area_hist[i]);
+    }
+
+    fprintf(f, "\nframes,avg_frame_us,max_frame_us,avg_flush_us,max_flush_us,avg_area_px,max_area_px,screen_area_px,objects\n");
+    fprintf(f, "%" PRIu32 ",%" PRIu32 ",%" PRIu32 ",%" PRIu32 ",%" PRIu32 ",%" PRIu32 ",%" PRIu32 ",%" PRIu32
+            ",%" PRIu32 "\n",
+            snapshot.frame_count, snapshot.avg_frame_us, snapshot.max_frame_us,
+            snapshot.avg_flush_us, snapshot.max_flush_us,
+            snapshot.avg_area_px, snapshot.max_area_px, snapshot.screen_area_px, snapshot.obj_count);
+
+    bool write_ok = !ferror(f);
+    fclose(f);
+
+    if (!write_ok) {
+        ESP_LOGE(TAG, "Write error while dumping render statistics");
+        return ESP_FAIL;
+    }
+
+    ESP_LOGI(TAG, "Render statistics (%" PRIu32 " frames) written to %s", available, path);
+    return ESP_OK;
+}
@@ -0,0 +1,96 @@
+#ifndef RENDER_STATS_H
+#define RENDER_STATS_H
+
+#include "esp_err.h"
+#include "lvgl.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+// Number of buckets kept per histogram
+#define RENDER_STATS_HIST_BUCKETS 8
+
+// Number of per-frame samples kept for the CSV dump
+#define RENDER_STATS_SAMPLE_COUNT 256
+
+// Default CSV dump location (relative to SD root)
+#define RENDER_STATS_CSV_PATH "/render_stats.csv"
+
+// Single rendered frame
+typedef struct {
+    uint32_t frame_us;      // Render start to render ready, includes flushing
+    uint32_t flush_us;      // Time spent inside the flush callback (incl. SW rotation)
+    uint32_t area_px;       // Invalidated pixel area rendered in this frame
+    uint16_t flush_count;   // Number of flush callbacks for this frame
+} render_frame_sample_t;
+
+// Aggregated render statistics
+typedef struct {
+    uint32_t frame_count;
+    render_frame_sample_t last;
+    uint32_t avg_frame_us;
+    uint32_t max_frame_us;
+    uint32_t avg_flush_us;
+    uint32_t max_flush_us;
+    uint32_t avg_area_px;
+    uint32_t max_area_px;
+    uint32_t screen_area_px;
+    uint32_t obj_count;     // Objects on the active screen and top layer, counted at snapshot time
+    uint32_t frame_hist[RENDER_STATS_HIST_BUCKETS];
+    uint32_t flush_hist[RENDER_STATS_HIST_BUCKETS];
+    uint32_t area_hist[RENDER_STATS_HIST_BUCKETS];
+} render_stats_t;
+
+/**
+ * @brief Hook render statistics into a display's refresh and flush events
+ * @param disp Display to instrument
+ * @return ESP_OK on success
+ */
+esp_err_t render_stats_attach(lv_display_t *disp);
+
+/**
+ * @brief Take a consistent snapshot of the current statistics
+ *
+ * Walks the object tree for obj_count; call from the LVGL task.
+ *
+ * @param out Structure to fill
+ */
+void render_stats_get(render_stats_t *out);
+
+/**
+ * @brief Get the most recent frame without walking the object tree
+ *
+ * Cheap enough to call after every lv_timer_handler() run, to attribute
+ * frames to the screen that was active when they rendered.
+ *
+ * @param out Filled with the last frame sample (may be NULL)
+ * @return Number of frames committed since the last reset
+ */
+uint32_t render_stats_get_last(render_frame_sample_t *out);
+
+/**
+ * @brief Clear all counters, histograms and samples
+ */
+void render_stats_reset(void);
+
+/**
+ * @brief Get the label of a time histogram bucket (frame and flush time)
+ * @param bucket Bucket index
+ * @return Static label such as "<4ms"
+ */
+const char* render_stats_time_bucket_label(int bucket);
+
+/**
+ * @brief Get the label of an area histogram bucket (percentage of the screen)
+ * @param bucket Bucket index
+ * @return Static label such as "<10%"
+ */
+const char* render_stats_area_bucket_label(int bucket);
+
+/**
+ * @brief Write per-frame samples and histograms as CSV to the SD card
+ * @param path File path (relative to SD root)
+ * @return ESP_OK on success
+ */
+esp_err_t render_stats_dump_csv(const char *path);
+
+#endif // RENDER_STATS_H
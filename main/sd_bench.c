@@ -0,0 +1,482 @@
+#include "sd_bench.h"
+#include <fcntl.h>
+#include <unistd.h>
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+
+#ifdef ESP_PLATFORM
+#include "sd_manager.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_heap_caps.h"
+#include "ff.h"
+#else
+#include <time.h>
+#include <sys/statvfs.h>
+#define ESP_LOGI(tag, fmt, ...) printf("I (%s) " fmt "\n", tag, ##__VA_ARGS__)
+#define ESP_LOGW(tag, fmt, ...) printf("W (%s) " fmt "\n", tag, ##__VA_ARGS__)
+#define ESP_LOGE(tag, fmt, ...) fprintf(stderr, "E (%s) " fmt "\n", tag, ##__VA_ARGS__)
+#endif
+
+static const char *TAG = "SD_BENCH";
+
+#define SD_BENCH_ALIGN       64      // Cache line; keeps the SDMMC driver from bouncing
+#define SD_BENCH_PATH_LEN    288
+#define SD_BENCH_SEED        0x2545F491u
+
+static const uint32_t seq_blocks[SD_BENCH_SEQ_BLOCKS] = { 4 * 1024, 32 * 1024, 128 * 1024 };
+
+typedef enum {
+    OPEN_READ,
+    OPEN_CREATE,     // Truncate and write
+    OPEN_UPDATE      // Write in place
+} open_mode_t;
+
+// One scratch file open at a time; static because FIL carries a sector buffer
+typedef struct {
+    sd_bench_api_t api;
+    FILE *fp;
+    int fd;
+#ifdef ESP_PLATFORM
+    FIL fil;
+#endif
+} bench_file_t;
+
+static bench_file_t bench_file;
+
+static uint64_t now_us(void) {
+#ifdef ESP_PLATFORM
+    return (uint64_t)esp_timer_get_time();
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000u + (uint64_t)ts.tv_nsec / 1000u;
+#endif
+}
+
+static uint8_t *alloc_buffer(size_t size) {
+#ifdef ESP_PLATFORM
+    uint8_t *buffer = heap_caps_aligned_alloc(SD_BENCH_ALIGN, size, MALLOC_CAP_DMA | MALLOC_CAP_INTERNAL);
+    if (!buffer) {
+        buffer = heap_caps_aligned_alloc(SD_BENCH_ALIGN, size, MALLOC_CAP_DMA | MALLOC_CAP_SPIRAM);
+    }
+    return buffer;
+#else
+    return aligned_alloc(SD_BENCH_ALIGN, size);
+#endif
+}
+
+static void free_buffer(uint8_t *buffer) {
+#ifdef ESP_PLATFORM
+    heap_caps_free(buffer);
+#else
+    free(buffer);
+#endif
+}
+
+static uint32_t next_random(uint32_t *state) {
+    uint32_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *state = x;
+    return x;
+}
+
+static bool cancelled(const sd_bench_config_t *config) {
+    return config->cancel && *config->cancel;
+}
+
+static void scratch_path(const sd_bench_config_t *config, sd_bench_api_t api, char *path) {
+    const char *dir = api == SD_BENCH_API_FATFS ? config->fatfs_dir : config->dir;
+    snprintf(path, SD_BENCH_PATH_LEN, "%s/%s", dir, SD_BENCH_FILE_NAME);
+}
+
+static bool bench_open(const sd_bench_config_t *config, sd_bench_api_t api, open_mode_t mode) {
+    char path[SD_BENCH_PATH_LEN];
+    scratch_path(config, api, path);
+    bench_file.api = api;
+
+    switch (api) {
+        case SD_BENCH_API_STDIO: {
+            static const char *modes[] = { "rb", "wb", "r+b" };
+            bench_file.fp = fopen(path, modes[mode]);
+            return bench_file.fp != NULL;
+        }
+        case SD_BENCH_API_POSIX: {
+            static const int flags[] = { O_RDONLY, O_WRONLY | O_CREAT | O_TRUNC, O_RDWR };
+            bench_file.fd = open(path, flags[mode], 0644);
+            return bench_file.fd >= 0;
+        }
+#ifdef ESP_PLATFORM
+        case SD_BENCH_API_FATFS: {
+            static const BYTE flags[] = { FA_READ, FA_WRITE | FA_CREATE_ALWAYS, FA_READ | FA_WRITE };
+            return f_open(&bench_file.fil, path, flags[mode]) == FR_OK;
+        }
+#endif
+        default:
+            return false;
+    }
+}
+
+static bool bench_io(bool writing, uint8_t *buffer, uint32_t len) {
+    switch (bench_file.api) {
+        case SD_BENCH_API_STDIO:
+            return (writing ? fwrite(buffer, 1, len, bench_file.fp)
+                            : fread(buffer, 1, len, bench_file.fp)) == len;
+        case SD_BENCH_API_POSIX:
+            return (writing ? write(bench_file.fd, buffer, len)
+                            : read(bench_file.fd, buffer, len)) == (ssize_t)len;
+#ifdef ESP_PLATFORM
+        case SD_BENCH_API_FATFS: {
+            UINT done = 0;
+            FRESULT res = writing ? f_write(&bench_file.fil, buffer, len, &done)
+                                  : f_read(&bench_file.fil, buffer, len, &done);
+            return res == FR_OK && done == len;
+        }
+#endif
+        default:
+            return false;
+    }
+}
+
+static bool bench_seek(uint32_t offset) {
+    switch (bench_file.api) {
+        case SD_BENCH_API_STDIO:
+            return fseek(bench_file.fp, (long)offset, SEEK_SET) == 0;
+        case SD_BENCH_API_POSIX:
+            return lseek(bench_file.fd, (off_t)offset, SEEK_SET) == (off_t)offset;
+#ifdef ESP_PLATFORM
+        case SD_BENCH_API_FATFS:
+            return f_lseek(&bench_file.fil, offset) == FR_OK;
+#endif
+        default:
+            return false;
+    }
+}
+
+// Write tests end with their data on the card, not in a buffer
+static bool bench_sync(void) {
+    switch (bench_file.api) {
+        case SD_BENCH_API_STDIO:
+            return fflush(bench_file.fp) == 0 && fsync(fileno(bench_file.fp)) == 0;
+        case SD_BENCH_API_POSIX:
+            return fsync(bench_file.fd) == 0;
+#ifdef ESP_PLATFORM
+        case SD_BENCH_API_FATFS:
+            return f_sync(&bench_file.fil) == FR_OK;
+#endif
+        default:
+            return false;
+    }
+}
+
+static void bench_close(void) {
+    switch (bench_file.api) {
+        case SD_BENCH_API_STDIO:
+            fclose(bench_file.fp);
+            bench_file.fp = NULL;
+            break;
+        case SD_BENCH_API_POSIX:
+            close(bench_file.fd);
+            bench_file.fd = -1;
+            break;
+#ifdef ESP_PLATFORM
+        case SD_BENCH_API_FATFS:
+            f_close(&bench_file.fil);
+            break;
+#endif
+        default:
+            break;
+    }
+}
+
+/*
+ * Reads must come from the medium. FatFs keeps at most one sector per file
+ * on the device, but a Linux host would serve the whole file from the page
+ * cache, so drop it there before every read pass.
+ */
+static void drop_cache(const sd_bench_config_t *config) {
+#ifndef ESP_PLATFORM
+    char path[SD_BENCH_PATH_LEN];
+    scratch_path(config, SD_BENCH_API_POSIX, path);
+    int fd = open(path, O_RDONLY);
+    if (fd >= 0) {
+        fdatasync(fd);
+        posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+        close(fd);
+    }
+#else
+    (void)config;
+#endif
+}
+
+static void record_op(sd_bench_result_t *result, uint64_t start, uint32_t len) {
+    uint32_t op_us = (uint32_t)(now_us() - start);
+    if (op_us > result->max_op_us) {
+        result->max_op_us = op_us;
+    }
+    result->ops++;
+    result->bytes += len;
+}
+
+static esp_err_t run_sequential(const sd_bench_config_t *config, uint8_t *buffer, sd_bench_result_t *result) {
+    bool writing = result->test == SD_BENCH_SEQ_WRITE;
+    if (!writing) {
+        drop_cache(config);
+    }
+    uint64_t begin = now_us();
+    if (!bench_open(config, result->api, writing ? OPEN_CREATE : OPEN_READ)) {
+        return ESP_FAIL;
+    }
+
+    esp_err_t ret = ESP_OK;
+    uint32_t blocks = config->file_size / result->block_size;
+    for (uint32_t i = 0; i < blocks; i++) {
+        if (cancelled(config)) {
+            ret = ESP_ERR_INVALID_STATE;
+            break;
+        }
+        uint64_t start = now_us();
+        if (!bench_io(writing, buffer, result->block_size)) {
+            ret = ESP_FAIL;
+            break;
+        }
+        record_op(result, start, result->block_size);
+    }
+    if (ret == ESP_OK && writing && !bench_sync()) {
+        ret = ESP_FAIL;
+    }
+    bench_close();
+    result->elapsed_us = now_us() - begin;
+    return ret;
+}
+
+static esp_err_t run_random(const sd_bench_config_t *config, uint8_t *buffer, sd_bench_result_t *result) {
+    bool writing = result->test == SD_BENCH_RAND_WRITE;
+    if (!writing) {
+        drop_cache(config);
+    }
+    if (!bench_open(config, result->api, writing ? OPEN_UPDATE : OPEN_READ)) {
+        return ESP_FAIL;
+    }
+
+    esp_err_t ret = ESP_OK;
+    uint32_t slots = config->file_size / SD_BENCH_RANDOM_BLOCK;
+    uint32_t state = SD_BENCH_SEED;
+    uint64_t begin = now_us();
+    uint64_t deadline = begin + (uint64_t)config->random_ms * 1000u;
+    while (now_us() < deadline) {
+        if (cancelled(config)) {
+            ret = ESP_ERR_INVALID_STATE;
+            break;
+        }
+        uint32_t offset = (next_random(&state) % slots) * SD_BENCH_RANDOM_BLOCK;
+        uint64_t start = now_us();
+        if (!bench_seek(offset) || !bench_io(writing, buffer, SD_BENCH_RANDOM_BLOCK)) {
+            ret = ESP_FAIL;
+            break;
+        }
+        record_op(result, start, SD_BENCH_RANDOM_BLOCK);
+    }
+    if (ret == ESP_OK && writing && !bench_sync()) {
+        ret = ESP_FAIL;
+    }
+    bench_close();
+    result->elapsed_us = now_us() - begin;
+    return ret;
+}
+
+static bool api_selected(const sd_bench_config_t *config, sd_bench_api_t api) {
+    if (!(config->apis & SD_BENCH_API_BIT(api))) {
+        return false;
+    }
+#ifdef ESP_PLATFORM
+    return api != SD_BENCH_API_FATFS || (config->fatfs_dir && config->fatfs_dir[0]);
+#else
+    return api != SD_BENCH_API_FATFS;
+#endif
+}
+
+uint32_t sd_bench_test_count(const sd_bench_config_t *config) {
+    uint32_t count = 0;
+    for (int api = 0; api < SD_BENCH_API_COUNT; api++) {
+        if (api_selected(config, (sd_bench_api_t)api)) {
+            count += 2 * SD_BENCH_SEQ_BLOCKS + 2;
+        }
+    }
+    return count;
+}
+
+esp_err_t sd_bench_run(const sd_bench_config_t *config, sd_bench_result_t *results, uint32_t *count,
+                       sd_bench_progress_cb_t progress_cb, void *user_data) {
+    if (!config || !config->dir || !results || !count ||
+        config->file_size < seq_blocks[SD_BENCH_SEQ_BLOCKS - 1]) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    *count = 0;
+
+    uint32_t buffer_size = seq_blocks[SD_BENCH_SEQ_BLOCKS - 1];
+    uint8_t *buffer = alloc_buffer(buffer_size);
+    if (!buffer) {
+        ESP_LOGE(TAG, "No memory for %" PRIu32 " byte buffer", buffer_size);
+        return ESP_ERR_NO_MEM;
+    }
+    // Incompressible, in case the medium or an image file compresses
+    uint32_t state = SD_BENCH_SEED;
+    for (uint32_t i = 0; i < buffer_size; i += sizeof(uint32_t)) {
+        uint32_t word = next_random(&state);
+        memcpy(buffer + i, &word, sizeof(word));
+    }
+
+    uint32_t total = sd_bench_test_count(config);
+    esp_err_t ret = ESP_OK;
+    for (int api = 0; api < SD_BENCH_API_COUNT && ret == ESP_OK; api++) {
+        if (!api_selected(config, (sd_bench_api_t)api)) {
+            continue;
+        }
+        for (uint32_t step = 0; step < 2 * SD_BENCH_SEQ_BLOCKS + 2 && ret == ESP_OK; step++) {
+            sd_bench_result_t *result = &results[*count];
+            memset(result, 0, sizeof(*result));
+            result->api = (sd_bench_api_t)api;
+            if (step < 2 * SD_BENCH_SEQ_BLOCKS) {
+                // Each block size writes the file, then reads it back
+                result->test = (step & 1) ? SD_BENCH_SEQ_READ : SD_BENCH_SEQ_WRITE;
+                result->block_size = seq_blocks[step / 2];
+                result->err = run_sequential(config, buffer, result);
+            } else {
+                // Random passes run over the file the last sequential write left behind
+                result->test = step == 2 * SD_BENCH_SEQ_BLOCKS ? SD_BENCH_RAND_WRITE : SD_BENCH_RAND_READ;
+                result->block_size = SD_BENCH_RANDOM_BLOCK;
+                result->err = run_random(config, buffer, result);
+            }
+            ret = result->err;
+            (*count)++;
+
+            ESP_LOGI(TAG, "%s %s %" PRIu32 "K: %.2f MB/s, %" PRIu32 " IOPS, max %" PRIu32 " us%s",
+                     sd_bench_api_name(result->api), sd_bench_test_name(result->test),
+                     result->block_size / 1024, sd_bench_mb_per_s(result), sd_bench_iops(result),
+                     result->max_op_us, result->err == ESP_OK ? "" : " (incomplete)");
+            if (progress_cb) {
+                progress_cb(result, *count, total, user_data);
+            }
+        }
+    }
+
+    char path[SD_BENCH_PATH_LEN];
+    scratch_path(config, SD_BENCH_API_POSIX, path);
+    unlink(path);
+    free_buffer(buffer);
+    return ret;
+}
+
+esp_err_t sd_bench_get_mount(const char *dir, sd_bench_mount_t *mount) {
+    if (!dir || !mount) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    memset(mount, 0, sizeof(*mount));
+#ifdef ESP_PLATFORM
+    sd_card_info_t info;
+    esp_err_t ret = sd_manager_get_card_info(&info);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    snprintf(mount->card, sizeof(mount->card), "%s", info.name);
+    static const char *fs_names[] = { "", "FAT12", "FAT16", "FAT32", "exFAT" };
+    snprintf(mount->fs, sizeof(mount->fs), "%s", info.fs_type <= FS_EXFAT ? fs_names[info.fs_type] : "?");
+    mount->bus_width = info.bus_width;
+    mount->freq_khz = info.freq_khz;
+    mount->sector_size = info.sector_size;
+    mount->cluster_size = info.cluster_size;
+    mount->capacity = info.capacity;
+    return ESP_OK;
+#else
+    struct statvfs vfs;
+    if (statvfs(dir, &vfs) != 0) {
+        return ESP_FAIL;
+    }
+    snprintf(mount->card, sizeof(mount->card), "host");
+    mount->sector_size = (uint32_t)vfs.f_frsize;
+    mount->cluster_size = (uint32_t)vfs.f_bsize;
+    mount->capacity = (uint64_t)vfs.f_blocks * vfs.f_frsize;
+    return ESP_OK;
+#endif
+}
+
+esp_err_t sd_bench_write_csv(FILE *f, const sd_bench_mount_t *mount,
+                             const sd_bench_result_t *results, uint32_t count) {
+    if (!f || (!results && count)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (mount) {
+        fprintf(f, "card,fs,bus_width,freq_khz,sector_size,cluster_size,capacity\n");
+        fprintf(f, "%s,%s,%" PRIu32 ",%" PRIu32 ",%" PRIu32 ",%" PRIu32 ",%" PRIu64 "\n\n",
+                mount->card, mount->fs, mount->bus_width, mount->freq_khz,
+                mount->sector_size, mount->cluster_size, mount->capacity);
+    }
+    fprintf(f, "api,test,block,bytes,ops,elapsed_us,mb_per_s,iops,avg_op_us,max_op_us,error\n");
+    for (uint32_t i = 0; i < count; i++) {
+        const sd_bench_result_t *r = &results[i];
+        fprintf(f, "%s,%s,%" PRIu32 ",%" PRIu64 ",%" PRIu32 ",%" PRIu64 ",%.2f,%" PRIu32 ",%" PRIu64 ",%" PRIu32 ",%d\n",
+                sd_bench_api_name(r->api), sd_bench_test_name(r->test), r->block_size, r->bytes, r->ops,
+                r->elapsed_us, sd_bench_mb_per_s(r), sd_bench_iops(r),
+                r->ops ? r->elapsed_us / r->ops : 0, r->max_op_us, r->err);
+    }
+    return ferror(f) ? ESP_FAIL : ESP_OK;
+}
+
+float sd_bench_mb_per_s(const sd_bench_result_t *result) {
+    if (result->elapsed_us == 0) {
+        return 0.0f;
+    }
+    return (float)result->bytes / (1024.0f * 1024.0f) / (result->elapsed_us / 1000000.0f);
+}
+
+uint32_t sd_bench_iops(const sd_bench_result_t *result) {
+    if (result->elapsed_us == 0) {
+        return 0;
+    }
+    return (uint32_t)(((uint64_t)result->ops * 1000000u) / result->elapsed_us);
+}
+
+const char* sd_bench_api_name(sd_bench_api_t api) {
+    static const char *names[] = { "stdio", "posix", "fatfs" };
+    return api < SD_BENCH_API_COUNT ? names[api] : "?";
+}
+
+const char* sd_bench_test_name(sd_bench_test_t test) {
+    static const char *names[] = { "seq write", "seq read", "rand write", "rand read" };
+    return test <= SD_BENCH_RAND_READ ? names[test] : "?";
+}
+
+#if defined(SD_BENCH_HOST_MAIN) && !defined(ESP_PLATFORM)
+/*
+ * Host build, e.g. against a loop-mounted image of a card:
+ *   gcc -O2 -DSD_BENCH_HOST_MAIN -o sd_bench main/sd_bench.c
+ *   ./sd_bench /mnt/card [file_mb] [random_ms] > host.csv
+ */
+int main(int argc, char **argv) {
+    if (argc < 2) {
+        fprintf(stderr, "usage: %s <dir> [file_mb] [random_ms]\n", argv[0]);
+        return 2;
+    }
+    sd_bench_config_t config = SD_BENCH_CONFIG_DEFAULT();
+    config.dir = argv[1];
+    if (argc > 2) {
+        config.file_size = (uint32_t)strtoul(argv[2], NULL, 0) * 1024u * 1024u;
+    }
+    if (argc > 3) {
+        config.random_ms = (uint32_t)strtoul(argv[3], NULL, 0);
+    }
+
+    static sd_bench_result_t results[SD_BENCH_MAX_RESULTS];
+    uint32_t count = 0;
+    esp_err_t ret = sd_bench_run(&config, results, &count, NULL, NULL);
+
+    sd_bench_mount_t mount;
+    bool have_mount = sd_bench_get_mount(config.dir, &mount) == ESP_OK;
+    sd_bench_write_csv(stdout, have_mount ? &mount : NULL, results, count);
+    return ret == ESP_OK ? 0 : 1;
+}
+#endif
@@ -0,0 +1,163 @@
+#ifndef SD_BENCH_H
+#define SD_BENCH_H
+
+#include <stdio.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+/*
+ * The benchmark core has no LVGL or sd_manager dependency so the same file
+ * builds on the Linux host (see SD_BENCH_HOST_MAIN in sd_bench.c) and the
+ * numbers can be compared against a disk image of the card.
+ */
+#ifdef ESP_PLATFORM
+#include "esp_err.h"
+#else
+typedef int esp_err_t;
+#define ESP_OK                 0
+#define ESP_FAIL              -1
+#define ESP_ERR_NO_MEM         0x101
+#define ESP_ERR_INVALID_ARG    0x102
+#define ESP_ERR_INVALID_STATE  0x103
+#endif
+
+#define SD_BENCH_CSV_PATH      "/sd_bench.csv"    // Relative to SD root
+#define SD_BENCH_FILE_NAME     ".sd_bench.tmp"    // Scratch file, removed afterwards
+#define SD_BENCH_SEQ_BLOCKS    3                  // 4 KB, 32 KB, 128 KB
+#define SD_BENCH_RANDOM_BLOCK  4096
+#define SD_BENCH_MAX_RESULTS   (SD_BENCH_API_COUNT * (2 * SD_BENCH_SEQ_BLOCKS + 2))
+
+typedef enum {
+    SD_BENCH_API_STDIO = 0,    // fopen/fread/fwrite through newlib and the VFS
+    SD_BENCH_API_POSIX,        // open/read/write straight to the VFS
+    SD_BENCH_API_FATFS,        // f_open/f_read/f_write, bypassing the VFS (device only)
+    SD_BENCH_API_COUNT
+} sd_bench_api_t;
+
+#define SD_BENCH_API_BIT(api)  (1u << (api))
+#define SD_BENCH_API_ALL       ((1u << SD_BENCH_API_COUNT) - 1)
+
+typedef enum {
+    SD_BENCH_SEQ_WRITE = 0,
+    SD_BENCH_SEQ_READ,
+    SD_BENCH_RAND_WRITE,
+    SD_BENCH_RAND_READ
+} sd_bench_test_t;
+
+typedef struct {
+    const char *dir;              // Scratch directory as a VFS path, e.g. SD_MOUNT_POINT
+    const char *fatfs_dir;        // Same directory as a FatFs path, e.g. "0:"; NULL skips raw FatFs
+    uint32_t file_size;           // Bytes per sequential pass, also the random test span
+    uint32_t random_ms;           // Time budget per random pass
+    uint32_t apis;                // SD_BENCH_API_BIT() mask
+    const volatile bool *cancel;  // Polled between operations (can be NULL)
+} sd_bench_config_t;
+
+#define SD_BENCH_CONFIG_DEFAULT() { \
+    .dir = NULL,                    \
+    .fatfs_dir = NULL,              \
+    .file_size = 8 * 1024 * 1024,   \
+    .random_ms = 3000,              \
+    .apis = SD_BENCH_API_ALL,       \
+    .cancel = NULL                  \
+}
+
+typedef struct {
+    sd_bench_api_t api;
+    sd_bench_test_t test;
+    uint32_t block_size;
+    uint64_t bytes;           // Bytes transferred
+    uint32_t ops;             // Reads or writes issued
+    uint64_t elapsed_us;      // Including the closing sync for write tests
+    uint32_t max_op_us;       // Slowest single read or write
+    esp_err_t err;            // ESP_OK, or why the test stopped early
+} sd_bench_result_t;
+
+// Mount parameters recorded alongside the results
+typedef struct {
+    char card[16];            // Card product name, "host" off-device
+    char fs[8];               // "FAT32", "exFAT", ...
+    uint32_t bus_width;       // Data lines, 0 off-device
+    uint32_t freq_khz;        // Bus clock, 0 off-device
+    uint32_t sector_size;
+    uint32_t cluster_size;    // Allocation unit in bytes, 0 if unknown
+    uint64_t capacity;        // Bytes
+} sd_bench_mount_t;
+
+/**
+ * @brief Called after each finished test
+ * @param result Result of the test just run
+ * @param index Tests finished so far, including this one
+ * @param total Tests in the whole run
+ * @param user_data User data passed to sd_bench_run()
+ */
+typedef void (*sd_bench_progress_cb_t)(const sd_bench_result_t *result, uint32_t index,
+                                       uint32_t total, void *user_data);
+
+/**
+ * @brief Run the benchmark
+ *
+ * For each selected API: sequential write then read of config->file_size
+ * bytes at every block size, then random 4 KB writes and reads over the
+ * same file for config->random_ms each. Offsets come from a fixed-seed
+ * generator so runs are repeatable. Blocks until done; run it off the UI
+ * task. The scratch file is removed at the end.
+ *
+ * @param config Benchmark parameters
+ * @param results Output array of at least SD_BENCH_MAX_RESULTS entries
+ * @param count Output number of results filled in
+ * @param progress_cb Called after each test (can be NULL)
+ * @param user_data Passed through to progress_cb
+ * @return ESP_OK if all tests ran, ESP_ERR_INVALID_STATE if cancelled,
+ *         ESP_ERR_NO_MEM, or the error of the first failed test
+ */
+esp_err_t sd_bench_run(const sd_bench_config_t *config, sd_bench_result_t *results, uint32_t *count,
+                       sd_bench_progress_cb_t progress_cb, void *user_data);
+
+/**
+ * @brief Number of tests a run with this configuration performs
+ * @param config Benchmark parameters
+ * @return Test count
+ */
+uint32_t sd_bench_test_count(const sd_bench_config_t *config);
+
+/**
+ * @brief Describe the volume holding a directory
+ * @param dir VFS path of the directory
+ * @param mount Output parameters
+ * @return ESP_OK on success, error code otherwise
+ */
+esp_err_t sd_bench_get_mount(const char *dir, sd_bench_mount_t *mount);
+
+/**
+ * @brief Write mount parameters and results as CSV
+ * @param f Open output stream
+ * @param mount Mount parameters (can be NULL)
+ * @param results Results from sd_bench_run()
+ * @param count Number of results
+ * @return ESP_OK on success, ESP_FAIL on write error
+ */
+esp_err_t sd_bench_write_csv(FILE *f, const sd_bench_mount_t *mount,
+                             const sd_bench_result_t *results, uint32_t count);
+
+/**
+ * @brief Throughput of a result in MB/s
+ */
+float sd_bench_mb_per_s(const sd_bench_result_t *result);
+
+/**
+ * @brief Operations per second of a result
+ */
+uint32_t sd_bench_iops(const sd_bench_result_t *result);
+
+/**
+ * @brief Short name of an API ("stdio", "posix", "fatfs")
+ */
+const char* sd_bench_api_name(sd_bench_api_t api);
+
+/**
+ * @brief Short name of a test ("seq write", ...)
+ */
+const char* sd_bench_test_name(sd_bench_test_t test);
+
+#endif // SD_BENCH_H
@@ -0,0 +1,663 @@
+#include "sd_cache.h"
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+
+#ifdef ESP_PLATFORM
+#include "esp_log.h"
+#include "esp_heap_caps.h"
+// Sectors and bookkeeping live in PSRAM; the staging buffer is handed to the SDMMC DMA
+#define CACHE_ALLOC_STORE(size)  heap_caps_malloc((size), MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT)
+#define CACHE_ALLOC_DMA(size)    heap_caps_malloc((size), MALLOC_CAP_DMA)
+#define CACHE_FREE(ptr)          heap_caps_free(ptr)
+#else
+#include <stdio.h>
+#define ESP_LOGI(tag, fmt, ...) printf("I (%s) " fmt "\n", tag, ##__VA_ARGS__)
+#define ESP_LOGW(tag, fmt, ...) printf("W (%s) " fmt "\n", tag, ##__VA_ARGS__)
+#define ESP_LOGE(tag, fmt, ...) fprintf(stderr, "E (%s) " fmt "\n", tag, ##__VA_ARGS__)
+#define CACHE_ALLOC_STORE(size)  malloc(size)
+#define CACHE_ALLOC_DMA(size)    malloc(size)
+#define CACHE_FREE(ptr)          free(ptr)
+#endif
+
+static const char *TAG = "SD_CACHE";
+
+#define NO_ENTRY         UINT32_MAX
+#define ENTRY_VALID      0x01
+#define ENTRY_DIRTY      0x02
+#define FLUSH_RUN_MAX    16      // Sectors per write when flushing contiguous dirty runs
+
+/*
+ * Every pool owns a fixed set of entries kept in its own LRU list; a
+ * single hash table finds a sector whichever pool holds it, so a sector
+ * that changes role (a freed directory cluster reused for file data) is
+ * never cached twice.
+ */
+typedef struct {
+    uint32_t sector;
+    uint32_t prev;           // Towards the most recently used end
+    uint32_t next;
+    uint32_t hash_next;
+    uint8_t pool;
+    uint8_t flags;
+} cache_entry_t;
+
+typedef struct {
+    uint32_t sector;
+    uint32_t entry;
+} flush_item_t;
+
+struct sd_cache {
+    sd_cache_dev_t dev;
+    sd_cache_config_t config;
+    uint32_t entry_count;
+    cache_entry_t *entries;
+    uint8_t *store;                          // entry_count sectors
+    uint32_t *buckets;
+    uint32_t bucket_mask;
+    uint32_t lru_head[SD_CACHE_POOL_COUNT];  // Most recently used
+    uint32_t lru_tail[SD_CACHE_POOL_COUNT];  // Next to go
+    uint8_t *staging;                        // Read-ahead and flush runs
+    uint32_t staging_sectors;
+    flush_item_t *flush_items;
+    sd_cache_stats_t stats;
+};
+
+static inline uint8_t *entry_data(sd_cache_t *cache, uint32_t index) {
+    return cache->store + (size_t)index * cache->dev.sector_size;
+}
+
+static inline uint32_t bucket_of(const sd_cache_t *cache, uint32_t sector) {
+    return (sector * 2654435761u >> 7) & cache->bucket_mask;
+}
+
+static uint32_t find_entry(const sd_cache_t *cache, uint32_t sector) {
+    for (uint32_t i = cache->buckets[bucket_of(cache, sector)]; i != NO_ENTRY; i = cache->entries[i].hash_next) {
+        if (cache->entries[i].sector == sector) {
+            return i;
+        }
+    }
+    return NO_ENTRY;
+}
+
+static void hash_insert(sd_cache_t *cache, uint32_t index) {
+    uint32_t bucket = bucket_of(cache, cache->entries[index].sector);
+    cache->entries[index].hash_next = cache->buckets[bucket];
+    cache->buckets[bucket] = index;
+}
+
+static void hash_remove(sd_cache_t *cache, uint32_t index) {
+    uint32_t *link = &cache->buckets[bucket_of(cache, cache->entries[index].sector)];
+    while (*link != NO_ENTRY) {
+        if (*link == index) {
+            *link = cache->entries[index].hash_next;
+            return;
+        }
+        link = &cache->entries[*link].hash_next;
+    }
+}
+
+static void lru_unlink(sd_cache_t *cache, uint32_t index) {
+    cache_entry_t *entry = &cache->entries[index];
+    if (entry->prev != NO_ENTRY) {
+        cache->entries[entry->prev].next = entry->next;
+    } else {
+        cache->lru_head[entry->pool] = entry->next;
+    }
+    if (entry->next != NO_ENTRY) {
+        cache->entries[entry->next].prev = entry->prev;
+    } else {
+        cache->lru_tail[entry->pool] = entry->prev;
+    }
+}
+
+static void lru_push_front(sd_cache_t *cache, uint32_t index) {
+    cache_entry_t *entry = &cache->entries[index];
+    entry->prev = NO_ENTRY;
+    entry->next = cache->lru_head[entry->pool];
+    if (entry->next != NO_ENTRY) {
+        cache->entries[entry->next].prev = index;
+    } else {
+        cache->lru_tail[entry->pool] = index;
+    }
+    cache->lru_head[entry->pool] = index;
+}
+
+static void touch(sd_cache_t *cache, uint32_t index) {
+    if (cache->lru_head[cache->entries[index].pool] != index) {
+        lru_unlink(cache, index);
+        lru_push_front(cache, index);
+    }
+}
+
+static void set_clean(sd_cache_t *cache, uint32_t index) {
+    if (cache->entries[index].flags & ENTRY_DIRTY) {
+        cache->entries[index].flags &= ~ENTRY_DIRTY;
+        cache->stats.dirty--;
+    }
+}
+
+static void set_dirty(sd_cache_t *cache, uint32_t index) {
+    if (!(cache->entries[index].flags & ENTRY_DIRTY)) {
+        cache->entries[index].flags |= ENTRY_DIRTY;
+        cache->stats.dirty++;
+    }
+}
+
+// Empty every pool; entries are handed out from the tail of their pool's list
+static void reset_entries(sd_cache_t *cache) {
+    for (uint32_t b = 0; b <= cache->bucket_mask; b++) {
+        cache->buckets[b] = NO_ENTRY;
+    }
+    uint32_t index = 0;
+    for (int pool = 0; pool < SD_CACHE_POOL_COUNT; pool++) {
+        cache->lru_head[pool] = NO_ENTRY;
+        cache->lru_tail[pool] = NO_ENTRY;
+        for (uint32_t i = 0; i < cache->config.sectors[pool]; i++, index++) {
+            cache->entries[index].pool = (uint8_t)pool;
+            cache->entries[index].flags = 0;
+            cache->entries[index].sector = 0;
+            cache->entries[index].hash_next = NO_ENTRY;
+            lru_push_front(cache, index);
+        }
+    }
+    cache->stats.dirty = 0;
+}
+
+/*
+ * Free the least recently used entry of a pool, writing it back first if
+ * it is dirty. NO_ENTRY if the pool is empty or the write failed (*err).
+ */
+static uint32_t take_entry(sd_cache_t *cache, sd_cache_pool_t pool, esp_err_t *err) {
+    uint32_t index = cache->lru_tail[pool];
+    *err = ESP_OK;
+    if (index == NO_ENTRY) {
+        return NO_ENTRY;
+    }
+    cache_entry_t *entry = &cache->entries[index];
+    if (entry->flags & ENTRY_VALID) {
+        if (entry->flags & ENTRY_DIRTY) {
+            *err = cache->dev.write(cache->dev.ctx, entry->sector, 1, entry_data(cache, index));
+            if (*err != ESP_OK) {
+                return NO_ENTRY;
+            }
+            set_clean(cache, index);
+            cache->stats.writebacks++;
+        }
+        hash_remove(cache, index);
+        entry->flags = 0;
+        cache->stats.evictions[pool]++;
+    }
+    return index;
+}
+
+static esp_err_t insert_entry(sd_cache_t *cache, sd_cache_pool_t pool, uint32_t sector, const uint8_t *data,
+                              bool dirty) {
+    esp_err_t err;
+    uint32_t index = take_entry(cache, pool, &err);
+    if (index == NO_ENTRY) {
+        return err;
+    }
+    cache_entry_t *entry = &cache->entries[index];
+    memcpy(entry_data(cache, index), data, cache->dev.sector_size);
+    entry->sector = sector;
+    entry->flags = ENTRY_VALID;
+    if (dirty) {
+        set_dirty(cache, index);
+    }
+    hash_insert(cache, index);
+    touch(cache, index);
+    return ESP_OK;
+}
+
+// Cached data is at least as new as the device; dirty sectors are newer
+static void overlay_dirty(sd_cache_t *cache, uint32_t sector, uint32_t count, uint8_t *out) {
+    if (cache->stats.dirty == 0) {
+        return;
+    }
+    for (uint32_t i = 0; i < count; i++) {
+        uint32_t index = find_entry(cache, sector + i);
+        if (index != NO_ENTRY && (cache->entries[index].flags & ENTRY_DIRTY)) {
+            memcpy(out + (size_t)i * cache->dev.sector_size, entry_data(cache, index), cache->dev.sector_size);
+        }
+    }
+}
+
+/*
+ * Read a run of sectors none of which is cached, plus read-ahead when the
+ * run ends the request, and keep them all. Read-ahead stops at the first
+ * sector already cached: that copy may be dirty, and evicting it while the
+ * run is stored would write it back under the older data just read.
+ */
+static esp_err_t fill_run(sd_cache_t *cache, sd_cache_pool_t pool, uint32_t first, uint32_t run, uint8_t *out,
+                          bool ends_request) {
+    uint32_t ss = cache->dev.sector_size;
+    uint32_t extra = ends_request ? cache->config.readahead[pool] : 0;
+    if (first + run >= cache->dev.sector_count) {
+        extra = 0;
+    } else if (extra > cache->dev.sector_count - (first + run)) {
+        extra = cache->dev.sector_count - (first + run);
+    }
+    if (run + extra > cache->staging_sectors) {
+        extra = run < cache->staging_sectors ? cache->staging_sectors - run : 0;
+    }
+    for (uint32_t i = 0; i < extra; i++) {
+        if (find_entry(cache, first + run + i) != NO_ENTRY) {
+            extra = i;
+            break;
+        }
+    }
+    cache->stats.readahead += extra;
+
+    const uint8_t *source = out;
+    esp_err_t err;
+    if (extra > 0) {
+        err = cache->dev.read(cache->dev.ctx, first, run + extra, cache->staging);
+        if (err != ESP_OK) {
+            return err;
+        }
+        memcpy(out, cache->staging, (size_t)run * ss);
+        source = cache->staging;
+    } else {
+        err = cache->dev.read(cache->dev.ctx, first, run, out);
+        if (err != ESP_OK) {
+            return err;
+        }
+    }
+
+    for (uint32_t i = 0; i < run + extra; i++) {
+        err = insert_entry(cache, pool, first + i, source + (size_t)i * ss, false);
+        if (err != ESP_OK) {
+            return err;
+        }
+    }
+    return ESP_OK;
+}
+
+static bool bypasses(const sd_cache_t *cache, sd_cache_pool_t pool, uint32_t count) {
+    return pool == SD_CACHE_POOL_DATA && count >= cache->config.bypass_sectors;
+}
+
+esp_err_t sd_cache_read(sd_cache_t *cache, sd_cache_pool_t pool, uint32_t sector, uint32_t count, void *buffer) {
+    uint8_t *out = (uint8_t *)buffer;
+    uint32_t ss = cache->dev.sector_size;
+
+    if (bypasses(cache, pool, count)) {
+        esp_err_t err = cache->dev.read(cache->dev.ctx, sector, count, out);
+        if (err != ESP_OK) {
+            return err;
+        }
+        overlay_dirty(cache, sector, count, out);
+        cache->stats.bypassed++;
+        return ESP_OK;
+    }
+
+    uint32_t i = 0;
+    while (i < count) {
+        uint32_t index = find_entry(cache, sector + i);
+        if (index != NO_ENTRY) {
+            memcpy(out + (size_t)i * ss, entry_data(cache, index), ss);
+            touch(cache, index);
+            cache->stats.hits[pool]++;
+            i++;
+            continue;
+        }
+
+        // Fetch consecutive misses in one transfer
+        uint32_t run = 1;
+        while (i + run < count && find_entry(cache, sector + i + run) == NO_ENTRY) {
+            run++;
+        }
+        cache->stats.misses[pool] += run;
+        esp_err_t err = fill_run(cache, pool, sector + i, run, out + (size_t)i * ss, i + run == count);
+        if (err != ESP_OK) {
+            return err;
+        }
+        i += run;
+    }
+    return ESP_OK;
+}
+
+esp_err_t sd_cache_write(sd_cache_t *cache, sd_cache_pool_t pool, uint32_t sector, uint32_t count,
+                         const void *buffer) {
+    const uint8_t *in = (const uint8_t *)buffer;
+    uint32_t ss = cache->dev.sector_size;
+    bool bypass = bypasses(cache, pool, count);
+
+    if (bypass || !cache->config.write_back) {
+        esp_err_t err = cache->dev.write(cache->dev.ctx, sector, count, in);
+        if (err != ESP_OK) {
+            return err;
+        }
+        // The device now has the newest data; cached copies follow it
+        for (uint32_t i = 0; i < count; i++) {
+            uint32_t index = find_entry(cache, sector + i);
+            if (index != NO_ENTRY) {
+                memcpy(entry_data(cache, index), in + (size_t)i * ss, ss);
+                set_clean(cache, index);
+            } else if (!bypass) {
+                err = insert_entry(cache, pool, sector + i, in + (size_t)i * ss, false);
+                if (err != ESP_OK) {
+                    return err;
+                }
+            }
+        }
+        if (bypass) {
+            cache->stats.bypassed++;
+        }
+        return ESP_OK;
+    }
+
+    for (uint32_t i = 0; i < count; i++) {
+        uint32_t index = find_entry(cache, sector + i);
+        if (index != NO_ENTRY) {
+            memcpy(entry_data(cache, index), in + (size_t)i * ss, ss);
+            set_dirty(cache, index);
+            touch(cache, index);
+        } else {
+            esp_err_t err = insert_entry(cache, pool, sector + i, in + (size_t)i * ss, true);
+            if (err != ESP_OK) {
+                return err;
+            }
+        }
+        cache->stats.writes_absorbed++;
+    }
+    return ESP_OK;
+}
+
+static int compare_flush_items(const void *a, const void *b) {
+    uint32_t sa = ((const flush_item_t *)a)->sector;
+    uint32_t sb = ((const flush_item_t *)b)->sector;
+    return sa < sb ? -1 : sa > sb;
+}
+
+/*
+ * Sector order turns neighbouring dirty sectors into one multi-block
+ * write. It also puts the FAT ahead of the directory entries in the data
+ * area, so a flush cut short leaves lost clusters rather than entries
+ * pointing at unallocated ones.
+ */
+esp_err_t sd_cache_flush(sd_cache_t *cache) {
+    if (cache->stats.dirty == 0) {
+        return ESP_OK;
+    }
+
+    uint32_t count = 0;
+    for (uint32_t i = 0; i < cache->entry_count; i++) {
+        if (cache->entries[i].flags & ENTRY_DIRTY) {
+            cache->flush_items[count].sector = cache->entries[i].sector;
+            cache->flush_items[count].entry = i;
+            count++;
+        }
+    }
+    qsort(cache->flush_items, count, sizeof(flush_item_t), compare_flush_items);
+
+    uint32_t ss = cache->dev.sector_size;
+    uint32_t limit = cache->staging_sectors < FLUSH_RUN_MAX ? cache->staging_sectors : FLUSH_RUN_MAX;
+    for (uint32_t start = 0; start < count; ) {
+        uint32_t run = 1;
+        while (start + run < count && run < limit &&
+               cache->flush_items[start + run].sector == cache->flush_items[start].sector + run) {
+            run++;
+        }
+        for (uint32_t i = 0; i < run; i++) {
+            memcpy(cache->staging + (size_t)i * ss, entry_data(cache, cache->flush_items[start + i].entry), ss);
+        }
+        esp_err_t err = cache->dev.write(cache->dev.ctx, cache->flush_items[start].sector, run, cache->staging);
+        if (err != ESP_OK) {
+            ESP_LOGE(TAG, "Flush of %" PRIu32 " sectors at %" PRIu32 " failed, %" PRIu32 " still dirty",
+                     run, cache->flush_items[start].sector, cache->stats.dirty);
+            return err;
+        }
+        for (uint32_t i = 0; i < run; i++) {
+            set_clean(cache, cache->flush_items[start + i].entry);
+        }
+        cache->stats.writebacks += run;
+        start += run;
+    }
+    return ESP_OK;
+}
+
+void sd_cache_invalidate(sd_cache_t *cache) {
+    if (cache->stats.dirty) {
+        ESP_LOGW(TAG, "Dropping %" PRIu32 " dirty sectors", cache->stats.dirty);
+    }
+    reset_entries(cache);
+}
+
+esp_err_t sd_cache_create(const sd_cache_config_t *config, const sd_cache_dev_t *dev, sd_cache_t **cache_out) {
+    if (!config || !dev || !cache_out || !dev->read || !dev->write || dev->sector_size == 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    uint32_t entry_count = 0;
+    uint32_t staging_sectors = FLUSH_RUN_MAX;
+    for (int pool = 0; pool < SD_CACHE_POOL_COUNT; pool++) {
+        if (config->sectors[pool] == 0) {
+            return ESP_ERR_INVALID_ARG;
+        }
+        entry_count += config->sectors[pool];
+        if (config->readahead[pool] + 1 > staging_sectors) {
+            staging_sectors = config->readahead[pool] + 1;
+        }
+    }
+
+    uint32_t buckets = 1;
+    while (buckets < entry_count) {
+        buckets <<= 1;
+    }
+
+    sd_cache_t *cache = calloc(1, sizeof(sd_cache_t));
+    if (!cache) {
+        return ESP_ERR_NO_MEM;
+    }
+    cache->dev = *dev;
+    cache->config = *config;
+    cache->entry_count = entry_count;
+    cache->bucket_mask = buckets - 1;
+    cache->staging_sectors = staging_sectors;
+    cache->entries = CACHE_ALLOC_STORE(entry_count * sizeof(cache_entry_t));
+    cache->store = CACHE_ALLOC_STORE((size_t)entry_count * dev->sector_size);
+    cache->buckets = CACHE_ALLOC_STORE(buckets * sizeof(uint32_t));
+    cache->flush_items = CACHE_ALLOC_STORE(entry_count * sizeof(flush_item_t));
+    cache->staging = CACHE_ALLOC_DMA((size_t)staging_sectors * dev->sector_size);
+    if (!cache->entries || !cache->store || !cache->buckets || !cache->flush_items || !cache->staging) {
+        sd_cache_destroy(cache);
+        return ESP_ERR_NO_MEM;
+    }
+    reset_entries(cache);
+
+    ESP_LOGI(TAG, "%" PRIu32 " sectors cached (%" PRIu32 " FAT, %" PRIu32 " directory, %" PRIu32 " data), %s",
+             entry_count, config->sectors[SD_CACHE_POOL_FAT], config->sectors[SD_CACHE_POOL_DIR],
+             config->sectors[SD_CACHE_POOL_DATA], config->write_back ? "write-back" : "write-through");
+    *cache_out = cache;
+    return ESP_OK;
+}
+
+void sd_cache_destroy(sd_cache_t *cache) {
+    if (!cache) {
+        return;
+    }
+    CACHE_FREE(cache->entries);
+    CACHE_FREE(cache->store);
+    CACHE_FREE(cache->buckets);
+    CACHE_FREE(cache->flush_items);
+    CACHE_FREE(cache->staging);
+    free(cache);
+}
+
+void sd_cache_get_stats(const sd_cache_t *cache, sd_cache_stats_t *stats_out) {
+    *stats_out = cache->stats;
+}
+
+uint32_t sd_cache_hit_percent(const sd_cache_stats_t *stats, sd_cache_pool_t pool) {
+    uint64_t total = (uint64_t)stats->hits[pool] + stats->misses[pool];
+    return total ? (uint32_t)((uint64_t)stats->hits[pool] * 100 / total) : 0;
+}
+
+const char* sd_cache_pool_name(sd_cache_pool_t pool) {
+    switch (pool) {
+        case SD_CACHE_POOL_FAT:  return "fat";
+        case SD_CACHE_POOL_DIR:  return "dir";
+        case SD_CACHE_POOL_DATA: return "data";
+        default:                 return "?";
+    }
+}
+
+#if defined(SD_CACHE_HOST_MAIN) && !defined(ESP_PLATFORM)
+/*
+ * Host check against a file-backed block device, e.g. a card image:
+ *   gcc -O2 -DSD_CACHE_HOST_MAIN -o sd_cache main/sd_cache.c
+ *   truncate -s 64M disk.img && ./sd_cache disk.img [operations]
+ *
+ * Replays a metadata-heavy mix (FAT chain walks, directory scans, small
+ * and large data transfers, FAT and directory updates) through the cache
+ * while mirroring every write in memory. Each read is checked against the
+ * mirror, and after the final flush so is the whole file. The image is
+ * overwritten.
+ */
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#define HOST_SECTOR 512
+
+typedef struct {
+    int fd;
+    uint32_t reads;
+    uint32_t writes;
+} host_dev_t;
+
+static esp_err_t host_read(void *ctx, uint32_t sector, uint32_t count, void *buffer) {
+    host_dev_t *dev = (host_dev_t *)ctx;
+    dev->reads++;
+    size_t len = (size_t)count * HOST_SECTOR;
+    return pread(dev->fd, buffer, len, (off_t)sector * HOST_SECTOR) == (ssize_t)len ? ESP_OK : ESP_FAIL;
+}
+
+static esp_err_t host_write(void *ctx, uint32_t sector, uint32_t count, const void *buffer) {
+    host_dev_t *dev = (host_dev_t *)ctx;
+    dev->writes++;
+    size_t len = (size_t)count * HOST_SECTOR;
+    return pwrite(dev->fd, buffer, len, (off_t)sector * HOST_SECTOR) == (ssize_t)len ? ESP_OK : ESP_FAIL;
+}
+
+static uint32_t host_rand(uint32_t *state) {
+    *state ^= *state << 13;
+    *state ^= *state >> 17;
+    *state ^= *state << 5;
+    return *state;
+}
+
+int main(int argc, char **argv) {
+    if (argc < 2) {
+        fprintf(stderr, "usage: %s <image> [operations]\n", argv[0]);
+        return 2;
+    }
+    uint32_t operations = argc > 2 ? (uint32_t)strtoul(argv[2], NULL, 0) : 200000;
+
+    host_dev_t host = { .fd = open(argv[1], O_RDWR) };
+    struct stat st;
+    if (host.fd < 0 || fstat(host.fd, &st) != 0 || st.st_size < 16 * 1024 * 1024) {
+        fprintf(stderr, "%s: need an existing image of at least 16 MB\n", argv[1]);
+        return 2;
+    }
+    uint32_t sectors = (uint32_t)(st.st_size / HOST_SECTOR);
+    uint8_t *mirror = malloc((size_t)sectors * HOST_SECTOR);
+    if (!mirror || pread(host.fd, mirror, (size_t)sectors * HOST_SECTOR, 0) != (ssize_t)sectors * HOST_SECTOR) {
+        fprintf(stderr, "cannot load %s\n", argv[1]);
+        return 2;
+    }
+
+    // Layout of a small FAT32 volume: FAT at 32, directories in a few clusters
+    const uint32_t fat_start = 32, fat_sectors = sectors / 128;
+    const uint32_t dir_start = fat_start + 2 * fat_sectors, dir_sectors = 2048;
+    const uint32_t data_start = dir_start + dir_sectors;
+
+    sd_cache_dev_t dev = { host_read, host_write, &host, HOST_SECTOR, sectors };
+    sd_cache_config_t config = SD_CACHE_CONFIG_DEFAULT();
+    sd_cache_t *cache;
+    if (sd_cache_create(&config, &dev, &cache) != ESP_OK) {
+        return 1;
+    }
+
+    static uint8_t buffer[64 * HOST_SECTOR];
+    uint32_t seed = 0x2545F491u, requests = 0, mismatches = 0;
+    uint32_t fat_cursor = fat_start, dir_cursor = dir_start;
+    for (uint32_t op = 0; op < operations; op++) {
+        uint32_t kind = host_rand(&seed) % 100;
+        sd_cache_pool_t pool;
+        uint32_t sector, count = 1;
+        bool writing = false;
+        if (kind < 40) {
+            // Chain walk: mostly the next FAT sector, sometimes a jump
+            pool = SD_CACHE_POOL_FAT;
+            fat_cursor = host_rand(&seed) % 8 ? fat_cursor + (host_rand(&seed) % 3 == 0) :
+                         fat_start + host_rand(&seed) % fat_sectors;
+            if (fat_cursor >= fat_start + fat_sectors) {
+                fat_cursor = fat_start;
+            }
+            sector = fat_cursor;
+            writing = host_rand(&seed) % 10 == 0;
+        } else if (kind < 75) {
+            // Directory scan: sequential within a directory, directories revisited
+            pool = SD_CACHE_POOL_DIR;
+            dir_cursor = host_rand(&seed) % 16 ? dir_cursor + 1 : dir_start + (host_rand(&seed) % 64) * 32;
+            if (dir_cursor >= dir_start + dir_sectors) {
+                dir_cursor = dir_start;
+            }
+            sector = dir_cursor;
+            writing = host_rand(&seed) % 20 == 0;
+        } else {
+            pool = SD_CACHE_POOL_DATA;
+            count = kind < 90 ? 1 + host_rand(&seed) % 4 : 8 + host_rand(&seed) % 56;
+            sector = data_start + host_rand(&seed) % (sectors - data_start - count);
+            writing = host_rand(&seed) % 3 == 0;
+        }
+
+        size_t len = (size_t)count * HOST_SECTOR;
+        uint8_t *expect = mirror + (size_t)sector * HOST_SECTOR;
+        requests++;
+        if (writing) {
+            for (size_t i = 0; i < len; i++) {
+                buffer[i] = (uint8_t)host_rand(&seed);
+            }
+            memcpy(expect, buffer, len);
+            if (sd_cache_write(cache, pool, sector, count, buffer) != ESP_OK) {
+                return 1;
+            }
+        } else {
+            if (sd_cache_read(cache, pool, sector, count, buffer) != ESP_OK) {
+                return 1;
+            }
+            mismatches += memcmp(buffer, expect, len) != 0;
+        }
+        if (op % 5000 == 4999 && sd_cache_flush(cache) != ESP_OK) {
+            return 1;
+        }
+    }
+    if (sd_cache_flush(cache) != ESP_OK) {
+        return 1;
+    }
+
+    sd_cache_stats_t stats;
+    sd_cache_get_stats(cache, &stats);
+    for (int pool = 0; pool < SD_CACHE_POOL_COUNT; pool++) {
+        printf("%-5s %3" PRIu32 "%% hits (%" PRIu32 " hits, %" PRIu32 " misses, %" PRIu32 " evicted)\n",
+               sd_cache_pool_name(pool), sd_cache_hit_percent(&stats, pool),
+               stats.hits[pool], stats.misses[pool], stats.evictions[pool]);
+    }
+    printf("%" PRIu32 " requests -> %" PRIu32 " device reads, %" PRIu32 " device writes; "
+           "%" PRIu32 " writes absorbed, %" PRIu32 " written back, %" PRIu32 " read ahead, %" PRIu32 " bypassed\n",
+           requests, host.reads, host.writes, stats.writes_absorbed, stats.writebacks, stats.readahead, stats.bypassed);
+
+    uint8_t *check = malloc((size_t)sectors * HOST_SECTOR);
+    bool image_ok = check && pread(host.fd, check, (size_t)sectors * HOST_SECTOR, 0) == (ssize_t)sectors * HOST_SECTOR &&
+                    memcmp(check, mirror, (size_t)sectors * HOST_SECTOR) == 0;
+    printf("%" PRIu32 " read mismatches, image %s\n", mismatches, image_ok ? "matches" : "DIFFERS");
+    sd_cache_destroy(cache);
+    free(check);
+    free(mirror);
+    close(host.fd);
+    return mismatches == 0 && image_ok ? 0 : 1;
+}
+#endif
@@ -0,0 +1,151 @@
+#ifndef SD_CACHE_H
+#define SD_CACHE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/*
+ * Write-back sector cache between FatFs and the card. It only talks to
+ * the card through sd_cache_dev_t and has no FatFs or SDMMC dependency,
+ * so the same file builds on the Linux host against a file-backed block
+ * device (see SD_CACHE_HOST_MAIN in sd_cache.c).
+ */
+#ifdef ESP_PLATFORM
+#include "esp_err.h"
+#else
+typedef int esp_err_t;
+#define ESP_OK                 0
+#define ESP_FAIL              -1
+#define ESP_ERR_NO_MEM         0x101
+#define ESP_ERR_INVALID_ARG    0x102
+#define ESP_ERR_INVALID_STATE  0x103
+#endif
+
+// Sectors are kept in separate pools so a long data transfer cannot push
+// out the FAT and directory sectors every listing and walk goes back to
+typedef enum {
+    SD_CACHE_POOL_FAT = 0,    // File allocation table (both copies)
+    SD_CACHE_POOL_DIR,        // Directory entries and other volume metadata
+    SD_CACHE_POOL_DATA,       // File contents
+    SD_CACHE_POOL_COUNT
+} sd_cache_pool_t;
+
+// Block device underneath the cache
+typedef struct {
+    esp_err_t (*read)(void *ctx, uint32_t sector, uint32_t count, void *buffer);
+    esp_err_t (*write)(void *ctx, uint32_t sector, uint32_t count, const void *buffer);
+    void *ctx;
+    uint32_t sector_size;
+    uint32_t sector_count;
+} sd_cache_dev_t;
+
+typedef struct {
+    uint32_t sectors[SD_CACHE_POOL_COUNT];     // Capacity of each pool
+    uint32_t readahead[SD_CACHE_POOL_COUNT];   // Extra sectors fetched with a miss
+    uint32_t bypass_sectors;                   // Data transfers this long or longer skip the cache
+    bool write_back;                           // false: writes go straight through
+} sd_cache_config_t;
+
+// 512 KB of sectors in all. FAT and directory misses fetch the rest of a
+// 4 KB run in the same transfer; data pays for one sector at a time.
+#define SD_CACHE_CONFIG_DEFAULT() {     \
+    .sectors = { 256, 512, 256 },       \
+    .readahead = { 7, 7, 0 },           \
+    .bypass_sectors = 8,                \
+    .write_back = true                  \
+}
+
+typedef struct {
+    uint32_t hits[SD_CACHE_POOL_COUNT];        // Sectors read from the cache
+    uint32_t misses[SD_CACHE_POOL_COUNT];      // Sectors read from the card
+    uint32_t evictions[SD_CACHE_POOL_COUNT];
+    uint32_t readahead;                        // Sectors fetched ahead of a miss
+    uint32_t writes_absorbed;                  // Sector writes held back in the cache
+    uint32_t writebacks;                       // Dirty sectors written to the card
+    uint32_t bypassed;                         // Transfers that skipped the cache
+    uint32_t dirty;                            // Sectors waiting to be written
+} sd_cache_stats_t;
+
+typedef struct sd_cache sd_cache_t;
+
+/**
+ * @brief Create a cache in front of a block device
+ *
+ * Sector storage comes from PSRAM on the device.
+ *
+ * @param config Pool sizes and policy
+ * @param dev Block device
+ * @param cache_out Output cache handle
+ * @return ESP_OK on success, ESP_ERR_INVALID_ARG, or ESP_ERR_NO_MEM
+ */
+esp_err_t sd_cache_create(const sd_cache_config_t *config, const sd_cache_dev_t *dev, sd_cache_t **cache_out);
+
+/**
+ * @brief Free a cache; dirty sectors are lost, flush first
+ * @param cache Cache to free (can be NULL)
+ */
+void sd_cache_destroy(sd_cache_t *cache);
+
+/**
+ * @brief Read sectors through the cache
+ *
+ * Not thread-safe; the caller serializes access to a cache.
+ *
+ * @param cache Cache
+ * @param pool Pool the sectors belong to
+ * @param sector First sector
+ * @param count Number of sectors
+ * @param buffer Output buffer of count sectors
+ * @return ESP_OK on success, or the error of the failed device transfer
+ */
+esp_err_t sd_cache_read(sd_cache_t *cache, sd_cache_pool_t pool, uint32_t sector, uint32_t count, void *buffer);
+
+/**
+ * @brief Write sectors through the cache
+ *
+ * With write-back the sectors stay dirty in the cache until they are
+ * evicted or sd_cache_flush() is called; long data transfers always go
+ * straight to the device.
+ *
+ * @param cache Cache
+ * @param pool Pool the sectors belong to
+ * @param sector First sector
+ * @param count Number of sectors
+ * @param buffer Data of count sectors
+ * @return ESP_OK on success, or the error of the failed device transfer
+ */
+esp_err_t sd_cache_write(sd_cache_t *cache, sd_cache_pool_t pool, uint32_t sector, uint32_t count,
+                         const void *buffer);
+
+/**
+ * @brief Write every dirty sector to the device, in sector order
+ * @param cache Cache
+ * @return ESP_OK on success; sectors that failed stay dirty
+ */
+esp_err_t sd_cache_flush(sd_cache_t *cache);
+
+/**
+ * @brief Forget every cached sector, dirty ones included
+ * @param cache Cache
+ */
+void sd_cache_invalidate(sd_cache_t *cache);
+
+/**
+ * @brief Get counters since the cache was created
+ * @param cache Cache
+ * @param stats_out Output counters
+ */
+void sd_cache_get_stats(const sd_cache_t *cache, sd_cache_stats_t *stats_out);
+
+/**
+ * @brief Share of a pool's sector reads served from the cache
+ * @return Percentage, 0 if the pool has not been read
+ */
+uint32_t sd_cache_hit_percent(const sd_cache_stats_t *stats, sd_cache_pool_t pool);
+
+/**
+ * @brief Short name of a pool ("fat", "dir", "data")
+ */
+const char* sd_cache_pool_name(sd_cache_pool_t pool);
+
+#endif // SD_CACHE_H
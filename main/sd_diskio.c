@@ -0,0 +1,230 @@
+#include "sd_diskio.h"
+#include "esp_log.h"
+#include "sdmmc_cmd.h"
+#include "diskio_impl.h"
+#include "diskio_sdmmc.h"
+#include "ff.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include <stdio.h>
+#include <string.h>
+#include <inttypes.h>
+
+static const char *TAG = "SD_DISKIO";
+
+#define SD_DISKIO_MAX_RETRIES 3
+
+/*
+ * Only the launcher's own card is attached, so a single set of state is
+ * enough. FatFs serializes access per volume, but sd_diskio_read() comes
+ * from other tasks, so every transfer and the sector cache are guarded by
+ * io_lock.
+ */
+static SemaphoreHandle_t io_lock = NULL;
+static sdmmc_card_t *attached_card = NULL;
+static BYTE attached_pdrv = 0xFF;
+static FATFS *attached_fs = NULL;       // Tells FAT and directory sectors from file data
+static sd_cache_t *cache = NULL;        // NULL runs uncached
+static sd_diskio_error_cb_t error_callback = NULL;
+static void *error_user_data = NULL;
+static sd_diskio_stats_t stats;
+
+// Card transfer with the bus error fallback; also the block device under the cache
+static esp_err_t card_transfer(bool writing, void *buff, uint32_t sector, uint32_t count) {
+    sdmmc_card_t *card = attached_card;
+    if (!card) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    for (int attempt = 0; ; attempt++) {
+        esp_err_t err = writing ? sdmmc_write_sectors(card, buff, sector, count)
+                                : sdmmc_read_sectors(card, buff, sector, count);
+        if (err == ESP_OK) {
+            return ESP_OK;
+        }
+
+        bool bus_error = err == ESP_ERR_INVALID_CRC || err == ESP_ERR_TIMEOUT;
+        if (err == ESP_ERR_INVALID_CRC) {
+            stats.crc_errors++;
+        } else if (err == ESP_ERR_TIMEOUT) {
+            stats.timeouts++;
+        }
+        if (!bus_error || attempt >= SD_DISKIO_MAX_RETRIES ||
+            !error_callback || !error_callback(card, err, error_user_data)) {
+            ESP_LOGE(TAG, "%s of %" PRIu32 " sectors at %" PRIu32 " failed: %s",
+                     writing ? "Write" : "Read", count, sector, esp_err_to_name(err));
+            stats.failures++;
+            return err;
+        }
+        stats.retries++;
+    }
+}
+
+static esp_err_t cache_dev_read(void *ctx, uint32_t sector, uint32_t count, void *buffer) {
+    (void)ctx;
+    return card_transfer(false, buffer, sector, count);
+}
+
+static esp_err_t cache_dev_write(void *ctx, uint32_t sector, uint32_t count, const void *buffer) {
+    (void)ctx;
+    return card_transfer(true, (void *)buffer, sector, count);
+}
+
+/*
+ * FatFs moves FAT and directory sectors only through its one-sector window,
+ * so a transfer into or out of fs->win is metadata; anything else is file
+ * data.
+ */
+static sd_cache_pool_t classify(const BYTE *buff, uint32_t sector) {
+    const FATFS *fs = attached_fs;
+    if (!fs || buff != fs->win) {
+        return SD_CACHE_POOL_DATA;
+    }
+    LBA_t fat_end = fs->fatbase + (LBA_t)fs->fsize * fs->n_fats;
+    return sector >= fs->fatbase && sector < fat_end ? SD_CACHE_POOL_FAT : SD_CACHE_POOL_DIR;
+}
+
+static esp_err_t transfer(bool writing, sd_cache_pool_t pool, void *buff, uint32_t sector, uint32_t count) {
+    xSemaphoreTake(io_lock, portMAX_DELAY);
+    esp_err_t err;
+    if (!cache) {
+        err = card_transfer(writing, buff, sector, count);
+    } else if (writing) {
+        err = sd_cache_write(cache, pool, sector, count, buff);
+    } else {
+        err = sd_cache_read(cache, pool, sector, count, buff);
+    }
+    xSemaphoreGive(io_lock);
+    return err;
+}
+
+static DRESULT diskio_read(BYTE pdrv, BYTE *buff, uint32_t sector, unsigned count) {
+    if (pdrv != attached_pdrv || !attached_card) {
+        return RES_PARERR;
+    }
+    return transfer(false, classify(buff, sector), buff, sector, count) == ESP_OK ? RES_OK : RES_ERROR;
+}
+
+static DRESULT diskio_write(BYTE pdrv, const BYTE *buff, uint32_t sector, unsigned count) {
+    if (pdrv != attached_pdrv || !attached_card) {
+        return RES_PARERR;
+    }
+    return transfer(true, classify(buff, sector), (void *)buff, sector, count) == ESP_OK ? RES_OK : RES_ERROR;
+}
+
+static esp_err_t flush_cache(void) {
+    xSemaphoreTake(io_lock, portMAX_DELAY);
+    esp_err_t err = cache ? sd_cache_flush(cache) : ESP_OK;
+    xSemaphoreGive(io_lock);
+    return err;
+}
+
+// FatFs syncs after every change it considers complete; dirty sectors reach the card there
+static DRESULT diskio_ioctl(BYTE pdrv, BYTE cmd, void *buff) {
+    if (cmd == CTRL_SYNC && pdrv == attached_pdrv && flush_cache() != ESP_OK) {
+        return RES_ERROR;
+    }
+    return ff_sdmmc_ioctl(pdrv, cmd, buff);
+}
+
+static FATFS *volume_of(BYTE pdrv) {
+    char root[4];
+    snprintf(root, sizeof(root), "%u:/", (unsigned)pdrv);
+    FF_DIR dir;
+    if (f_opendir(&dir, root) != FR_OK) {
+        return NULL;
+    }
+    FATFS *fs = dir.obj.fs;
+    f_closedir(&dir);
+    return fs;
+}
+
+esp_err_t sd_diskio_attach(sdmmc_card_t *card, sd_diskio_error_cb_t error_cb, void *user_data) {
+    BYTE pdrv = card ? ff_diskio_get_pdrv_card(card) : 0xFF;
+    if (pdrv == 0xFF) {
+        return ESP_ERR_NOT_FOUND;
+    }
+    if (!io_lock) {
+        io_lock = xSemaphoreCreateMutex();
+        if (!io_lock) {
+            return ESP_ERR_NO_MEM;
+        }
+    }
+
+    // Init and status stay with the stock driver; transfers and sync are wrapped
+    static const ff_diskio_impl_t impl = {
+        .init = &ff_sdmmc_initialize,
+        .status = &ff_sdmmc_status,
+        .read = &diskio_read,
+        .write = &diskio_write,
+        .ioctl = &diskio_ioctl,
+    };
+    memset(&stats, 0, sizeof(stats));
+    error_callback = error_cb;
+    error_user_data = user_data;
+    attached_card = card;
+    attached_pdrv = pdrv;
+    attached_fs = volume_of(pdrv);
+
+    // The volume is already mounted through the stock driver, so the cache starts cold and clean
+    const sd_cache_dev_t dev = {
+        .read = cache_dev_read,
+        .write = cache_dev_write,
+        .ctx = NULL,
+        .sector_size = (uint32_t)card->csd.sector_size,
+        .sector_count = (uint32_t)card->csd.capacity,
+    };
+    const sd_cache_config_t config = SD_CACHE_CONFIG_DEFAULT();
+    if (!attached_fs || sd_cache_create(&config, &dev, &cache) != ESP_OK) {
+        cache = NULL;
+        ESP_LOGW(TAG, "Sector cache unavailable, card runs uncached");
+    }
+    ff_diskio_register(pdrv, &impl);
+    return ESP_OK;
+}
+
+esp_err_t sd_diskio_detach(void) {
+    esp_err_t err = ESP_OK;
+    if (io_lock) {
+        xSemaphoreTake(io_lock, portMAX_DELAY);
+        if (cache) {
+            err = sd_cache_flush(cache);
+            if (err != ESP_OK) {
+                ESP_LOGE(TAG, "Sector cache flush failed, recent changes may be lost: %s", esp_err_to_name(err));
+            }
+            sd_cache_destroy(cache);
+            cache = NULL;
+        }
+        xSemaphoreGive(io_lock);
+    }
+    attached_card = NULL;
+    attached_pdrv = 0xFF;
+    attached_fs = NULL;
+    error_callback = NULL;
+    error_user_data = NULL;
+    return err;
+}
+
+esp_err_t sd_diskio_read(uint32_t sector, uint32_t count, void *buffer) {
+    if (!attached_card) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    return transfer(false, SD_CACHE_POOL_DATA, buffer, sector, count) == ESP_OK ? ESP_OK : ESP_FAIL;
+}
+
+void sd_diskio_get_stats(sd_diskio_stats_t *stats_out) {
+    *stats_out = stats;
+}
+
+esp_err_t sd_diskio_get_cache_stats(sd_cache_stats_t *stats_out) {
+    if (!io_lock) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    xSemaphoreTake(io_lock, portMAX_DELAY);
+    esp_err_t ret = cache ? ESP_OK : ESP_ERR_INVALID_STATE;
+    if (cache) {
+        sd_cache_get_stats(cache, stats_out);
+    }
+    xSemaphoreGive(io_lock);
+    return ret;
+}
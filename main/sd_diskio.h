@@ -0,0 +1,79 @@
+#ifndef SD_DISKIO_H
+#define SD_DISKIO_H
+
+#include "esp_err.h"
+#include "sd_cache.h"
+#include "driver/sdmmc_host.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+typedef struct {
+    uint32_t crc_errors;    // Transfers that failed with a CRC error
+    uint32_t timeouts;      // Transfers that timed out
+    uint32_t retries;       // Transfers retried after a bus error
+    uint32_t failures;      // Transfers handed back to FatFs as failed
+} sd_diskio_stats_t;
+
+/**
+ * @brief Called when a sector transfer fails with a bus error
+ *
+ * Runs on the task doing the I/O, with the FatFs volume locked; it may lower
+ * the card clock but must not touch the file system.
+ *
+ * @param card Card the transfer was for
+ * @param err ESP_ERR_INVALID_CRC or ESP_ERR_TIMEOUT
+ * @param user_data User data passed to sd_diskio_attach()
+ * @return true to retry the transfer, false to fail it
+ */
+typedef bool (*sd_diskio_error_cb_t)(sdmmc_card_t *card, esp_err_t err, void *user_data);
+
+/**
+ * @brief Route the FatFs sector I/O of a mounted card through the launcher
+ *
+ * Replaces the stock SDMMC disk I/O driver for the card's drive with one
+ * that reports bus errors to error_cb and retries them when asked, and
+ * keeps FAT, directory and small data transfers in a PSRAM sector cache
+ * (see sd_cache.h). Dirty sectors are written when FatFs syncs.
+ *
+ * @param card Mounted card
+ * @param error_cb Called on CRC errors and timeouts (can be NULL)
+ * @param user_data Passed through to error_cb
+ * @return ESP_OK on success, ESP_ERR_NOT_FOUND if the card has no FatFs drive
+ */
+esp_err_t sd_diskio_attach(sdmmc_card_t *card, sd_diskio_error_cb_t error_cb, void *user_data);
+
+/**
+ * @brief Flush the sector cache and stop tracking the card; call before unmounting it
+ * @return ESP_OK on success, or the error of the failed flush
+ */
+esp_err_t sd_diskio_detach(void);
+
+/**
+ * @brief Read sectors of the attached card outside FatFs
+ *
+ * Goes through the sector cache, so it sees what FatFs has written even
+ * before it reaches the card. The volume is not locked: data FatFs is
+ * changing at the same time may be stale.
+ *
+ * @param sector First sector
+ * @param count Number of sectors
+ * @param buffer Output buffer of count sectors, preferably DMA-capable
+ * @return ESP_OK on success, ESP_ERR_INVALID_STATE if no card is attached,
+ *         ESP_FAIL on a read error
+ */
+esp_err_t sd_diskio_read(uint32_t sector, uint32_t count, void *buffer);
+
+/**
+ * @brief Get bus error counts since the card was attached
+ * @param stats_out Output counts
+ */
+void sd_diskio_get_stats(sd_diskio_stats_t *stats_out);
+
+/**
+ * @brief Get sector cache counters since the card was attached
+ * @param stats_out Output counters
+ * @return ESP_OK on success, ESP_ERR_INVALID_STATE if the card runs uncached
+ */
+esp_err_t sd_diskio_get_cache_stats(sd_cache_stats_t *stats_out);
+
+#endif // SD_DISKIO_H
@@ -0,0 +1,148 @@
+#include "sd_io.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "freertos/event_groups.h"
+
+static const char *TAG = "SD_IO";
+
+// A waiting chunk goes ahead anyway after this long, so a long listing
+// slows a copy down instead of stopping it
+#define SD_IO_BULK_MAX_WAIT_MS       250
+#define SD_IO_BACKGROUND_MAX_WAIT_MS 1000
+
+// Set while no work of that class is in flight
+#define IDLE_BIT(io_class) (1u << (io_class))
+
+static SemaphoreHandle_t io_lock = NULL;
+static EventGroupHandle_t idle_events = NULL;
+static sd_io_stats_t stats;     // Protected by io_lock
+
+// Classes a request waits for, and for how long at most
+static const EventBits_t wait_bits[SD_IO_CLASS_COUNT] = {
+    [SD_IO_INTERACTIVE] = 0,
+    [SD_IO_BULK] = IDLE_BIT(SD_IO_INTERACTIVE),
+    [SD_IO_BACKGROUND] = IDLE_BIT(SD_IO_INTERACTIVE) | IDLE_BIT(SD_IO_BULK),
+};
+static const uint32_t max_wait_ms[SD_IO_CLASS_COUNT] = {
+    [SD_IO_INTERACTIVE] = 0,
+    [SD_IO_BULK] = SD_IO_BULK_MAX_WAIT_MS,
+    [SD_IO_BACKGROUND] = SD_IO_BACKGROUND_MAX_WAIT_MS,
+};
+
+static bool blocked(sd_io_class_t io_class) {
+    for (int higher = 0; higher < (int)io_class; higher++) {
+        if (stats.classes[higher].active > 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+esp_err_t sd_io_init(void) {
+    if (io_lock) {
+        return ESP_OK;
+    }
+    idle_events = xEventGroupCreate();
+    io_lock = xSemaphoreCreateMutex();
+    if (!idle_events || !io_lock) {
+        ESP_LOGE(TAG, "Failed to create scheduler state");
+        if (idle_events) {
+            vEventGroupDelete(idle_events);
+            idle_events = NULL;
+        }
+        if (io_lock) {
+            vSemaphoreDelete(io_lock);
+            io_lock = NULL;
+        }
+        return ESP_ERR_NO_MEM;
+    }
+    xEventGroupSetBits(idle_events, IDLE_BIT(SD_IO_INTERACTIVE) | IDLE_BIT(SD_IO_BULK));
+    return ESP_OK;
+}
+
+void sd_io_begin(sd_io_class_t io_class) {
+    if (!io_lock || io_class >= SD_IO_CLASS_COUNT) {
+        return;
+    }
+    sd_io_class_stats_t *s = &stats.classes[io_class];
+
+    xSemaphoreTake(io_lock, portMAX_DELAY);
+    s->requests++;
+    bool wait = blocked(io_class);
+    if (wait) {
+        s->queued++;
+        if (s->queued > s->max_queued) {
+            s->max_queued = s->queued;
+        }
+    }
+    xSemaphoreGive(io_lock);
+
+    if (wait) {
+        int64_t start = esp_timer_get_time();
+        EventBits_t need = wait_bits[io_class];
+        EventBits_t bits = xEventGroupWaitBits(idle_events, need, pdFALSE, pdTRUE,
+                                               pdMS_TO_TICKS(max_wait_ms[io_class]));
+        uint32_t waited = (uint32_t)(esp_timer_get_time() - start);
+
+        xSemaphoreTake(io_lock, portMAX_DELAY);
+        s->queued--;
+        s->deferred++;
+        if ((bits & need) != need) {
+            s->expired++;
+        }
+        s->wait_us += waited;
+        if (waited > s->max_wait_us) {
+            s->max_wait_us = waited;
+        }
+        xSemaphoreGive(io_lock);
+    }
+
+    xSemaphoreTake(io_lock, portMAX_DELAY);
+    if (s->active++ == 0 && io_class != SD_IO_BACKGROUND) {
+        xEventGroupClearBits(idle_events, IDLE_BIT(io_class));
+    }
+    xSemaphoreGive(io_lock);
+}
+
+void sd_io_end(sd_io_class_t io_class) {
+    if (!io_lock || io_class >= SD_IO_CLASS_COUNT) {
+        return;
+    }
+    sd_io_class_stats_t *s = &stats.classes[io_class];
+
+    xSemaphoreTake(io_lock, portMAX_DELAY);
+    if (s->active > 0 && --s->active == 0 && io_class != SD_IO_BACKGROUND) {
+        xEventGroupSetBits(idle_events, IDLE_BIT(io_class));
+    }
+    xSemaphoreGive(io_lock);
+}
+
+void sd_io_yield(sd_io_class_t io_class) {
+    // Unlocked peek; a stale answer costs one extra or one missed yield
+    if (!io_lock || io_class >= SD_IO_CLASS_COUNT || !blocked(io_class)) {
+        return;
+    }
+    sd_io_end(io_class);
+    sd_io_begin(io_class);
+}
+
+void sd_io_get_stats(sd_io_stats_t *stats_out) {
+    if (!io_lock) {
+        *stats_out = (sd_io_stats_t){0};
+        return;
+    }
+    xSemaphoreTake(io_lock, portMAX_DELAY);
+    *stats_out = stats;
+    xSemaphoreGive(io_lock);
+}
+
+const char* sd_io_class_name(sd_io_class_t io_class) {
+    switch (io_class) {
+        case SD_IO_INTERACTIVE: return "interactive";
+        case SD_IO_BULK: return "bulk";
+        case SD_IO_BACKGROUND: return "background";
+        default: return "?";
+    }
+}
@@ -0,0 +1,88 @@
+#ifndef SD_IO_H
+#define SD_IO_H
+
+#include "esp_err.h"
+#include <stdint.h>
+
+/*
+ * Priority gate in front of the card. Everything shares one SD bus and
+ * one FatFs volume lock, so a directory listing would otherwise queue
+ * behind whatever chunk a copy or the indexer happens to be moving.
+ *
+ * Callers bracket each unit of card work with sd_io_begin()/sd_io_end().
+ * Interactive work starts at once. Bulk work does not start a new chunk
+ * while interactive work is in flight, and background work additionally
+ * waits for bulk chunks, so an interactive request waits behind at most
+ * the one chunk already on the card. Lower classes stop waiting after a
+ * bounded time so they cannot starve.
+ */
+
+typedef enum {
+    SD_IO_INTERACTIVE = 0,  // The user is waiting on it: listings, opening and saving files
+    SD_IO_BULK,             // Long transfers the user started: copy jobs, flashing, export
+    SD_IO_BACKGROUND,       // Nobody waits on it: indexing, thumbnails, free space counting
+    SD_IO_CLASS_COUNT
+} sd_io_class_t;
+
+// Bulk transfers are split into chunks of at most this size
+#define SD_IO_BULK_CHUNK_SIZE (64 * 1024)
+
+typedef struct {
+    uint32_t requests;      // Units of work started
+    uint32_t active;        // In flight now
+    uint32_t queued;        // Waiting for a higher class now
+    uint32_t max_queued;    // Most ever waiting at once
+    uint32_t deferred;      // Requests that had to wait
+    uint32_t expired;       // Requests that stopped waiting at the time limit
+    uint64_t wait_us;       // Total time spent waiting
+    uint32_t max_wait_us;   // Longest single wait
+} sd_io_class_stats_t;
+
+typedef struct {
+    sd_io_class_stats_t classes[SD_IO_CLASS_COUNT];
+} sd_io_stats_t;
+
+/**
+ * @brief Create the scheduler state; called once from sd_manager_init()
+ * @return ESP_OK on success, ESP_ERR_NO_MEM otherwise
+ */
+esp_err_t sd_io_init(void);
+
+/**
+ * @brief Start a unit of card work
+ *
+ * Blocks bulk and background callers while higher-priority work is in
+ * flight, up to a per-class time limit. Does nothing before sd_io_init().
+ *
+ * @param io_class Class of the work
+ */
+void sd_io_begin(sd_io_class_t io_class);
+
+/**
+ * @brief Finish a unit of card work started with sd_io_begin()
+ * @param io_class Class passed to sd_io_begin()
+ */
+void sd_io_end(sd_io_class_t io_class);
+
+/**
+ * @brief Step aside for higher-priority work in the middle of a long unit
+ *
+ * For loops that cannot be split into separate begin/end units, such as
+ * an enumeration callback. Cheap when nothing is waiting.
+ *
+ * @param io_class Class passed to sd_io_begin()
+ */
+void sd_io_yield(sd_io_class_t io_class);
+
+/**
+ * @brief Get queue depth and wait counters
+ * @param stats_out Output counters
+ */
+void sd_io_get_stats(sd_io_stats_t *stats_out);
+
+/**
+ * @brief Short name of a class ("interactive", "bulk", "background")
+ */
+const char* sd_io_class_name(sd_io_class_t io_class);
+
+#endif // SD_IO_H
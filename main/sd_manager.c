@@ -1,13 +1,27 @@
 #include "sd_manager.h"
+#include "listing_cache.h"
+#include "file_index.h"
+#include "thumbnail.h"
+#include "file_jobs.h"
+#include "config_manager.h"
+#include "sd_profile.h"
+#include "sd_diskio.h"
+#include "sd_space.h"
+#include "sd_io.h"
 #include "esp_log.h"
 #include "esp_vfs_fat.h"
 #include "driver/sdmmc_host.h"
 #include "driver/sdspi_host.h"
 #include "sdmmc_cmd.h"
+#include "ff.h"
+#include "diskio_sdmmc.h"
 #include "bsp/m5stack_tab5.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
+#include <fcntl.h>
 #include <dirent.h>
+#include <errno.h>
+#include <stdlib.h>
 #include <string.h>
 #include <sys/stat.h>
 #include <stdio.h>
@@ -17,11 +31,270 @@ static const char *TAG = "SD_MANAGER";
 static bool sd_mounted = false;
 static bool sd_card_present = false;
 
+// FatFs logical drive of the mounted card ("0:"), empty when unknown
+static char sd_drive[3] = "";
+
+static void update_drive(sdmmc_card_t *card) {
+    BYTE pdrv = card ? ff_diskio_get_pdrv_card(card) : 0xFF;
+    if (pdrv == 0xFF) {
+        sd_drive[0] = '\0';
+        ESP_LOGW(TAG, "FatFs drive not found, directory listing falls back to stat()");
+        return;
+    }
+    sd_drive[0] = (char)('0' + pdrv);
+    sd_drive[1] = ':';
+    sd_drive[2] = '\0';
+}
+
+/*
+ * Bus modes, fastest first. UHS-I modes are only listed where the SDMMC
+ * driver supports them. The probe walks this list down from the configured
+ * ceiling; after bus errors the clock steps down within the same signalling.
+ */
+static const sd_bus_mode_t bus_modes[] = {
+#if defined(SDMMC_FREQ_SDR50) && defined(SDMMC_SLOT_FLAG_UHS1)
+    { "SDR50 4-bit", SDMMC_FREQ_SDR50, 4, false, true },
+#endif
+#if defined(SDMMC_FREQ_DDR50) && defined(SDMMC_SLOT_FLAG_UHS1)
+    { "DDR50 4-bit", SDMMC_FREQ_DDR50, 4, true, true },
+#endif
+    { "HS 4-bit", SDMMC_FREQ_HIGHSPEED, 4, false, false },
+    { "26 MHz 4-bit", SDMMC_FREQ_26M, 4, false, false },
+    { "DS 4-bit", SDMMC_FREQ_DEFAULT, 4, false, false },
+    { "DS 1-bit", SDMMC_FREQ_DEFAULT, 1, false, false },
+};
+#define BUS_MODE_COUNT    (sizeof(bus_modes) / sizeof(bus_modes[0]))
+#define BUS_MODE_DEFAULT  (BUS_MODE_COUNT - 4)   // HS 4-bit, what the BSP always used
+
+#define SD_DEFAULT_MAX_FILES        5
+#define SD_DEFAULT_ALLOCATION_UNIT  (16 * 1024)
+#define SD_PROBE_FILE               SD_MOUNT_POINT "/.sd_probe.tmp"
+#define SD_PROBE_SIZE               (64 * 1024)
+#define SD_PROBE_CHECKS             2
+#define SD_BUS_ERROR_LIMIT          2       // Bus errors tolerated per mode before stepping down
+
+static uint32_t active_mode = BUS_MODE_DEFAULT;
+static uint32_t active_errors = 0;
+static char active_cid[sizeof(((sd_card_profile_t *)0)->cid)] = "";
+static volatile bool profile_save_pending = false;
+
+static uint32_t first_allowed_mode(const sd_mount_config_t *sd) {
+    for (uint32_t i = 0; i < BUS_MODE_COUNT; i++) {
+        if (!sd->max_freq_khz || bus_modes[i].freq_khz <= sd->max_freq_khz) {
+            return i;
+        }
+    }
+    return BUS_MODE_COUNT - 1;
+}
+
+static esp_err_t mount_in_mode(uint32_t index, bool format) {
+    const sd_mount_config_t *sd = &config_manager_get_current()->sd;
+    const sd_bus_mode_t *mode = &bus_modes[index];
+    const bsp_sdcard_cfg_t cfg = {
+        .max_freq_khz = mode->freq_khz,
+        .bus_width = mode->bus_width,
+        .ddr = mode->ddr,
+        .uhs1 = mode->uhs1,
+        .max_files = sd->max_files ? sd->max_files : SD_DEFAULT_MAX_FILES,
+        .allocation_unit_size = sd->allocation_unit ? sd->allocation_unit : SD_DEFAULT_ALLOCATION_UNIT,
+        .format_if_mount_failed = format,
+    };
+    esp_err_t ret = bsp_sdcard_init_with_config(SD_MOUNT_POINT, &cfg);
+    if (ret == ESP_OK) {
+        active_mode = index;
+        active_errors = 0;
+    }
+    return ret;
+}
+
+static void save_profile_task(void *arg) {
+    (void)arg;
+    profile_save_pending = false;
+    config_manager_save(config_manager_get_current());
+    vTaskDelete(NULL);
+}
+
+// Saving touches SPIFFS, so it never runs on the task that hit the error
+static void schedule_profile_save(void) {
+    if (profile_save_pending) {
+        return;
+    }
+    profile_save_pending = true;
+    if (xTaskCreatePinnedToCore(save_profile_task, "sd_profile", 4096, NULL, 2, NULL, 1) != pdPASS) {
+        profile_save_pending = false;
+        ESP_LOGW(TAG, "Could not save SD bus mode");
+    }
+}
+
+static bool handle_bus_error(sdmmc_card_t *card, esp_err_t err, void *user_data) {
+    (void)user_data;
+    if (++active_errors < SD_BUS_ERROR_LIMIT) {
+        return true;
+    }
+
+    // Lower the clock on the spot if the signalling allows it, else from the next mount
+    sd_mount_config_t *sd = &config_manager_get_current()->sd;
+    int slower = sd_profile_slower_mode(bus_modes, BUS_MODE_COUNT, active_mode, true);
+    if (slower >= 0 && sdmmc_host_set_card_clk(card->host.slot, bus_modes[slower].freq_khz) == ESP_OK) {
+        ESP_LOGW(TAG, "%s on %s, falling back to %s", esp_err_to_name(err),
+                 bus_modes[active_mode].name, bus_modes[slower].name);
+        int real_khz = 0;
+        if (sdmmc_host_get_real_freq(card->host.slot, &real_khz) == ESP_OK) {
+            card->real_freq_khz = real_khz;
+        }
+        active_mode = (uint32_t)slower;
+        active_errors = 0;
+    } else {
+        slower = sd_profile_slower_mode(bus_modes, BUS_MODE_COUNT, active_mode, false);
+        if (slower < 0) {
+            return true;    // Already in the slowest mode; retry as is
+        }
+        ESP_LOGW(TAG, "%s on %s, using %s from the next mount", esp_err_to_name(err),
+                 bus_modes[active_mode].name, bus_modes[slower].name);
+        active_errors = 0;
+    }
+    if (active_cid[0]) {
+        sd_profile_remember(sd, active_cid, &bus_modes[slower]);
+        schedule_profile_save();
+    }
+    return true;
+}
+
+static esp_err_t probe_mount(const sd_bus_mode_t *mode, void *ctx) {
+    (void)ctx;
+    return mount_in_mode((uint32_t)(mode - bus_modes), false);
+}
+
+static void probe_unmount(void *ctx) {
+    (void)ctx;
+    bsp_sdcard_deinit(SD_MOUNT_POINT);
+}
+
+// Write a pattern, read it back from the card and compare
+static esp_err_t probe_check(void *ctx) {
+    (void)ctx;
+    uint8_t *buffer = malloc(SD_PROBE_SIZE);
+    if (!buffer) {
+        return ESP_ERR_NO_MEM;
+    }
+    uint32_t state = 0x9E3779B9u;
+    for (uint32_t i = 0; i < SD_PROBE_SIZE; i++) {
+        state = state * 1664525u + 1013904223u;
+        buffer[i] = (uint8_t)(state >> 24);
+    }
+
+    esp_err_t ret = ESP_FAIL;
+    int fd = open(SD_PROBE_FILE, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd >= 0) {
+        bool written = write(fd, buffer, SD_PROBE_SIZE) == SD_PROBE_SIZE && fsync(fd) == 0;
+        close(fd);
+        fd = written ? open(SD_PROBE_FILE, O_RDONLY) : -1;
+    }
+    if (fd >= 0) {
+        uint8_t chunk[512];
+        ret = ESP_OK;
+        for (uint32_t offset = 0; offset < SD_PROBE_SIZE && ret == ESP_OK; offset += sizeof(chunk)) {
+            if (read(fd, chunk, sizeof(chunk)) != (ssize_t)sizeof(chunk)) {
+                ret = ESP_FAIL;
+            } else if (memcmp(chunk, buffer + offset, sizeof(chunk)) != 0) {
+                ret = ESP_ERR_INVALID_CRC;
+            }
+        }
+        close(fd);
+    }
+    unlink(SD_PROBE_FILE);
+    free(buffer);
+    return ret;
+}
+
+static void card_cid_key(const sdmmc_card_t *card, char *key, size_t size) {
+    sd_profile_cid_key((uint32_t)card->cid.mfg_id, (uint32_t)card->cid.oem_id, card->cid.name,
+                       (uint32_t)card->cid.serial, key, size);
+}
+
+/*
+ * Mount in the mode remembered for the card, probing cards seen for the
+ * first time. The card has to come up before its CID can be read, so it
+ * is first mounted in the default mode and remounted if that is not the
+ * one to use.
+ */
+static esp_err_t mount_card(bool format) {
+    sd_mount_config_t *sd = &config_manager_get_current()->sd;
+    uint32_t first = first_allowed_mode(sd);
+    uint32_t fallback = first > BUS_MODE_DEFAULT ? first : BUS_MODE_DEFAULT;
+
+    active_cid[0] = '\0';
+    esp_err_t ret = mount_in_mode(fallback, format);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+
+    char cid[sizeof(active_cid)];
+    card_cid_key(bsp_sdcard_get_handle(), cid, sizeof(cid));
+    const sd_card_profile_t *known = sd_profile_lookup(sd, cid);
+    int known_mode = known ? sd_profile_find_mode(bus_modes, BUS_MODE_COUNT, known) : -1;
+    if (known_mode >= 0) {
+        uint32_t target = (uint32_t)known_mode > first ? (uint32_t)known_mode : first;
+        if (target != active_mode) {
+            bsp_sdcard_deinit(SD_MOUNT_POINT);
+            ret = mount_in_mode(target, false);
+            if (ret != ESP_OK) {
+                ESP_LOGW(TAG, "Card %s did not come up in %s, using %s", cid,
+                         bus_modes[target].name, bus_modes[fallback].name);
+                ret = mount_in_mode(fallback, false);
+            }
+        }
+    } else if (sd->auto_probe && !format) {
+        ESP_LOGI(TAG, "New card %s, probing bus modes", cid);
+        bsp_sdcard_deinit(SD_MOUNT_POINT);
+        const sd_probe_ops_t ops = {
+            .mount = probe_mount,
+            .check = probe_check,
+            .unmount = probe_unmount,
+        };
+        uint32_t chosen = 0;
+        if (sd_profile_probe(&ops, &bus_modes[first], BUS_MODE_COUNT - first, SD_PROBE_CHECKS, &chosen) == ESP_OK) {
+            sd_profile_remember(sd, cid, &bus_modes[first + chosen]);
+            config_manager_save(config_manager_get_current());
+        } else {
+            ret = mount_in_mode(fallback, false);
+        }
+    }
+    if (ret != ESP_OK) {
+        return ret;
+    }
+
+    sdmmc_card_t *card = bsp_sdcard_get_handle();
+    snprintf(active_cid, sizeof(active_cid), "%s", cid);
+    ESP_LOGI(TAG, "Card %s mounted in %s (%d kHz)", cid, bus_modes[active_mode].name, card->real_freq_khz);
+    update_drive(card);
+    if (sd_diskio_attach(card, handle_bus_error, NULL) != ESP_OK) {
+        ESP_LOGW(TAG, "Bus error fallback unavailable for this card");
+    }
+    if (sd_space_start(sd_drive) != ESP_OK) {
+        ESP_LOGW(TAG, "Free space will not be shown for this card");
+    }
+    return ESP_OK;
+}
+
+static esp_err_t unmount_card(void) {
+    sd_space_stop();
+    // Writes back the sector cache; a failure is logged, the card is unmounted regardless
+    sd_diskio_detach();
+    active_cid[0] = '\0';
+    return bsp_sdcard_deinit(SD_MOUNT_POINT);
+}
+
 esp_err_t sd_manager_init(void) {
-    esp_err_t ret = bsp_sdcard_init(SD_MOUNT_POINT, 5);
+    listing_cache_init();
+    // Before any worker touches the card; without it every request runs unscheduled
+    sd_io_init();
+    
+    esp_err_t ret = mount_card(false);
     if (ret == ESP_OK) {
         sd_mounted = true;
         sd_card_present = true;
+        file_index_start();
         ESP_LOGI(TAG, "SD card mounted successfully at %s", SD_MOUNT_POINT);
     } else {
         ESP_LOGE(TAG, "Failed to mount SD card: %s", esp_err_to_name(ret));
@@ -41,63 +314,179 @@ esp_err_t sd_manager_deinit(void) {
         return ESP_ERR_INVALID_STATE;
     }
     
-    esp_err_t ret = bsp_sdcard_deinit(SD_MOUNT_POINT);
+    // Jobs are cancelled and pending index changes written while the card is still there
+    file_jobs_stop();
+    file_index_stop();
+    thumbnail_stop();
+    esp_err_t ret = unmount_card();
     if (ret == ESP_OK) {
         sd_mounted = false;
+        sd_drive[0] = '\0';
+        listing_cache_clear();
         // Keep card_present true - card is still there, just unmounted
         ESP_LOGI(TAG, "SD card unmounted successfully");
     }
     return ret;
 }
 
-int sd_manager_scan_directory(const char *path, file_entry_t *entries, int max_entries, bool show_hidden) {
-    if (!sd_mounted) {
-        ESP_LOGE(TAG, "SD card not mounted");
-        return -1;
-    }
-    
+static time_t fat_time_to_unix(WORD fdate, WORD ftime) {
+    // Same conversion as the VFS stat() implementation
+    struct tm tm = {
+        .tm_year = ((fdate >> 9) & 0x7F) + 80,
+        .tm_mon = ((fdate >> 5) & 0x0F) - 1,
+        .tm_mday = fdate & 0x1F,
+        .tm_hour = (ftime >> 11) & 0x1F,
+        .tm_min = (ftime >> 5) & 0x3F,
+        .tm_sec = (ftime & 0x1F) * 2,
+        .tm_isdst = -1,
+    };
+    return mktime(&tm);
+}
+
+static bool is_dot_entry(const char *name) {
+    return name[0] == '.' && (name[1] == '\0' || (name[1] == '.' && name[2] == '\0'));
+}
+
+// Fallback when the FatFs drive is unknown: readdir() plus stat() per entry
+static int enumerate_vfs(const char *path, bool show_hidden, sd_enum_cb_t callback, void *user_data) {
     char full_path[256];
     snprintf(full_path, sizeof(full_path), "%s%s", SD_MOUNT_POINT, path);
-    
+
     DIR *dir = opendir(full_path);
     if (!dir) {
         ESP_LOGE(TAG, "Failed to open directory: %s", full_path);
         return -1;
     }
-    
-    struct dirent *entry;
+
     int count = 0;
-    
-    while ((entry = readdir(dir)) != NULL && count < max_entries) {
-        // Always skip current/parent directory entries
-        if (strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0) {
-            continue;
+    for (;;) {
+        errno = 0;
+        struct dirent *de = readdir(dir);
+        if (!de) {
+            if (errno != 0) {
+                ESP_LOGE(TAG, "Failed to read directory: %s (errno %d)", full_path, errno);
+                count = -1;
+            }
+            break;
         }
-        
-        // Skip hidden files if show_hidden is false
-        if (!show_hidden && entry->d_name[0] == '.') {
+        if (is_dot_entry(de->d_name) || (!show_hidden && de->d_name[0] == '.')) {
             continue;
         }
-        
-        // Get full path for stat
+
         char item_path[512];
-        snprintf(item_path, sizeof(item_path), "%s/%s", full_path, entry->d_name);
-        
+        snprintf(item_path, sizeof(item_path), "%s/%s", full_path, de->d_name);
         struct stat file_stat;
-        if (stat(item_path, &file_stat) == 0) {
-            strncpy(entries[count].name, entry->d_name, sizeof(entries[count].name) - 1);
-            entries[count].name[sizeof(entries[count].name) - 1] = '\0';
-            entries[count].is_directory = S_ISDIR(file_stat.st_mode);
-            entries[count].size = file_stat.st_size;
-            count++;
+        if (stat(item_path, &file_stat) != 0) {
+            continue;
+        }
+
+        sd_dir_entry_t entry = {
+            .name = de->d_name,
+            .is_directory = S_ISDIR(file_stat.st_mode),
+            .attributes = S_ISDIR(file_stat.st_mode) ? SD_ATTR_DIRECTORY : 0,
+            .size = file_stat.st_size,
+            .mtime = file_stat.st_mtime,
+        };
+        count++;
+        if (!callback(&entry, user_data)) {
+            break;
         }
     }
-    
+
     closedir(dir);
-    ESP_LOGI(TAG, "Found %d entries in %s", count, path);
     return count;
 }
 
+int sd_manager_enumerate(const char *path, bool show_hidden, sd_enum_cb_t callback, void *user_data) {
+    if (!sd_mounted) {
+        ESP_LOGE(TAG, "SD card not mounted");
+        return -1;
+    }
+    if (!path || !callback) {
+        return -1;
+    }
+    if (sd_drive[0] == '\0') {
+        return enumerate_vfs(path, show_hidden, callback, user_data);
+    }
+
+    char fat_path[256];
+    snprintf(fat_path, sizeof(fat_path), "%s%s", sd_drive, path);
+
+    FF_DIR dir;
+    FRESULT res = f_opendir(&dir, fat_path);
+    if (res != FR_OK) {
+        ESP_LOGE(TAG, "Failed to open directory: %s (FatFs error %d)", path, res);
+        return -1;
+    }
+
+    FILINFO fno;
+    int count = 0;
+    while (true) {
+        res = f_readdir(&dir, &fno);
+        if (res != FR_OK) {
+            ESP_LOGE(TAG, "Failed to read directory: %s (FatFs error %d)", path, res);
+            // A partial listing must not pass for the whole directory
+            count = -1;
+            break;
+        }
+        if (fno.fname[0] == '\0') {
+            break; // End of directory
+        }
+        if (is_dot_entry(fno.fname) || (!show_hidden && fno.fname[0] == '.')) {
+            continue;
+        }
+
+        sd_dir_entry_t entry = {
+            .name = fno.fname,
+            .is_directory = (fno.fattrib & AM_DIR) != 0,
+            .attributes = fno.fattrib,
+            .size = (uint64_t)fno.fsize,
+            .mtime = fat_time_to_unix(fno.fdate, fno.ftime),
+        };
+        count++;
+        if (!callback(&entry, user_data)) {
+            break;
+        }
+    }
+
+    f_closedir(&dir);
+    return count;
+}
+
+typedef struct {
+    file_entry_t *entries;
+    int max_entries;
+    int count;
+} scan_ctx_t;
+
+static bool scan_directory_cb(const sd_dir_entry_t *entry, void *user_data) {
+    scan_ctx_t *ctx = (scan_ctx_t *)user_data;
+    file_entry_t *out = &ctx->entries[ctx->count++];
+    strncpy(out->name, entry->name, sizeof(out->name) - 1);
+    out->name[sizeof(out->name) - 1] = '\0';
+    out->is_directory = entry->is_directory;
+    out->size = entry->size;
+    return ctx->count < ctx->max_entries;
+}
+
+int sd_manager_scan_directory(const char *path, file_entry_t *entries, int max_entries, bool show_hidden) {
+    if (max_entries <= 0) {
+        return 0;
+    }
+
+    scan_ctx_t ctx = {
+        .entries = entries,
+        .max_entries = max_entries,
+        .count = 0
+    };
+    if (sd_manager_enumerate(path, show_hidden, scan_directory_cb, &ctx) < 0) {
+        return -1;
+    }
+
+    ESP_LOGI(TAG, "Found %d entries in %s", ctx.count, path);
+    return ctx.count;
+}
+
 bool sd_manager_file_exists(const char *path) {
     if (!sd_mounted) {
         return false;
@@ -133,6 +522,11 @@ FILE* sd_manager_open_file(const char *path, const char *mode) {
     char full_path[256];
     snprintf(full_path, sizeof(full_path), "%s%s", SD_MOUNT_POINT, path);
     
+    // Writing creates the file or changes its size, so the cached listing is stale
+    if (strpbrk(mode, "wa+")) {
+        listing_cache_invalidate_parent(path);
+        file_index_note_change(path);
+    }
     return fopen(full_path, mode);
 }
 
@@ -149,24 +543,14 @@ esp_err_t sd_manager_format(void) {
     // Wait a moment for unmount to complete
     vTaskDelay(pdMS_TO_TICKS(500));
     
-    // Reinitialize SD card for formatting
-    // This will format the card if mount fails
-    esp_vfs_fat_sdmmc_mount_config_t mount_config = {
-        .format_if_mount_failed = true,  // This is the key - format if mount fails
-        .max_files = 5,
-        .allocation_unit_size = 16 * 1024  // 16KB clusters for better performance
-    };
-    
-    sdmmc_card_t *card = NULL;
-    sdmmc_host_t host = SDMMC_HOST_DEFAULT();
-    sdmmc_slot_config_t slot_config = SDMMC_SLOT_CONFIG_DEFAULT();
-    slot_config.width = 4;  // Use 4-bit mode
-    
-    // First, try to mount - if it fails, it will auto-format
-    ret = esp_vfs_fat_sdmmc_mount(SD_MOUNT_POINT, &host, &slot_config, &mount_config, &card);
+    // Reinitialize SD card for formatting, through the same BSP path and
+    // mount profile as a normal mount. This will format the card if mount fails
+    ret = mount_card(true);
     if (ret == ESP_OK) {
         // Successfully mounted (or formatted and mounted)
         sd_mounted = true;
+        listing_cache_clear();
+        file_index_start();
         ESP_LOGI(TAG, "SD card format completed successfully");
         
         // Create a test file to verify format worked
@@ -193,10 +577,12 @@ esp_err_t sd_manager_mount(void) {
     }
     
     ESP_LOGI(TAG, "Attempting to mount SD card");
-    esp_err_t ret = bsp_sdcard_init(SD_MOUNT_POINT, 5);
+    esp_err_t ret = mount_card(false);
     if (ret == ESP_OK) {
         sd_mounted = true;
         sd_card_present = true;
+        listing_cache_clear();
+        file_index_start();
         ESP_LOGI(TAG, "SD card mounted successfully at %s", SD_MOUNT_POINT);
     } else {
         ESP_LOGE(TAG, "Failed to mount SD card: %s", esp_err_to_name(ret));
@@ -215,9 +601,15 @@ esp_err_t sd_manager_unmount(void) {
     }
     
     ESP_LOGI(TAG, "Unmounting SD card");
-    esp_err_t ret = bsp_sdcard_deinit(SD_MOUNT_POINT);
+    // Jobs are cancelled and pending index changes written while the card is still there
+    file_jobs_stop();
+    file_index_stop();
+    thumbnail_stop();
+    esp_err_t ret = unmount_card();
     if (ret == ESP_OK) {
         sd_mounted = false;
+        sd_drive[0] = '\0';
+        listing_cache_clear();
         // Keep card_present true - card is still physically there
         ESP_LOGI(TAG, "SD card unmounted successfully");
     } else {
@@ -226,6 +618,45 @@ esp_err_t sd_manager_unmount(void) {
     return ret;
 }
 
+esp_err_t sd_manager_get_card_info(sd_card_info_t *info) {
+    if (!info) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    sdmmc_card_t *card = bsp_sdcard_get_handle();
+    if (!sd_mounted || !card) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    memset(info, 0, sizeof(*info));
+    memcpy(info->name, card->cid.name, sizeof(info->name) - 1);
+    info->bus_width = 1u << card->log_bus_width;
+    info->freq_khz = (uint32_t)card->real_freq_khz;
+    info->sector_size = (uint32_t)card->csd.sector_size;
+    info->capacity = (uint64_t)card->csd.capacity * (uint64_t)card->csd.sector_size;
+
+    // Opening the root hands back the volume object without f_getfree() scanning the FAT
+    if (sd_drive[0] != '\0') {
+        char root[4];
+        snprintf(root, sizeof(root), "%s/", sd_drive);
+        FF_DIR dir;
+        if (f_opendir(&dir, root) == FR_OK) {
+            FATFS *fs = dir.obj.fs;
+#if FF_MAX_SS != FF_MIN_SS
+            info->cluster_size = (uint32_t)fs->csize * fs->ssize;
+#else
+            info->cluster_size = (uint32_t)fs->csize * FF_MAX_SS;
+#endif
+            info->fs_type = fs->fs_type;
+            f_closedir(&dir);
+        }
+    }
+    return ESP_OK;
+}
+
+const char* sd_manager_get_fatfs_drive(void) {
+    return sd_drive;
+}
+
 bool sd_manager_card_detected(void) {
     // Return whether card is present (could be mounted or just detected)
     return sd_card_present;
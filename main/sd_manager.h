@@ -4,8 +4,13 @@
 #include "esp_err.h"
 #include <stdio.h>
 #include <stdbool.h>
+#include <stdint.h>
+#include <time.h>
 
+// Overridable so an off-device build can map the card to a host directory
+#ifndef SD_MOUNT_POINT
 #define SD_MOUNT_POINT "/sdcard"
+#endif
 #define MAX_FILENAME_LEN 64
 
 typedef struct {
@@ -14,6 +19,41 @@ typedef struct {
     size_t size;
 } file_entry_t;
 
+// Entry attributes (same bits as FatFs AM_*)
+#define SD_ATTR_READONLY  0x01
+#define SD_ATTR_HIDDEN    0x02
+#define SD_ATTR_SYSTEM    0x04
+#define SD_ATTR_DIRECTORY 0x10
+#define SD_ATTR_ARCHIVE   0x20
+
+// Directory entry reported by sd_manager_enumerate()
+typedef struct {
+    const char *name;   // Only valid during the callback
+    bool is_directory;
+    uint8_t attributes; // SD_ATTR_* bits
+    uint64_t size;      // exFAT files can pass 4 GiB
+    time_t mtime;
+} sd_dir_entry_t;
+
+/**
+ * @brief Directory enumeration callback
+ * @param entry Current entry
+ * @param user_data User data passed to sd_manager_enumerate()
+ * @return true to continue, false to stop enumerating
+ */
+typedef bool (*sd_enum_cb_t)(const sd_dir_entry_t *entry, void *user_data);
+
+// Card and mount parameters reported by sd_manager_get_card_info()
+typedef struct {
+    char name[8];           // Product name from the CID
+    uint32_t bus_width;     // Data lines in use (1, 4 or 8)
+    uint32_t freq_khz;      // Bus clock actually negotiated
+    uint32_t sector_size;   // Card sector size in bytes
+    uint64_t capacity;      // Card size in bytes
+    uint32_t cluster_size;  // FAT allocation unit in bytes, 0 if unknown
+    uint8_t fs_type;        // FatFs FS_FAT12/FS_FAT16/FS_FAT32/FS_EXFAT, 0 if unknown
+} sd_card_info_t;
+
 /**
  * @brief Initialize SD card manager
  * @return ESP_OK on success, error code otherwise
@@ -42,6 +82,21 @@ esp_err_t sd_manager_deinit(void);
  */
 int sd_manager_scan_directory(const char *path, file_entry_t *entries, int max_entries, bool show_hidden);
 
+/**
+ * @brief Enumerate a directory in a single pass
+ *
+ * Name, size, modification time and attributes come straight from the FAT
+ * directory entry, so no per-entry stat() is needed. "." and ".." are skipped.
+ *
+ * @param path Directory path to enumerate (relative to SD root)
+ * @param show_hidden Include hidden files (starting with '.')
+ * @param callback Called for every entry, return false to stop
+ * @param user_data Passed through to the callback
+ * @return Number of entries passed to the callback, -1 if the directory could
+ *         not be opened or a read failed part way
+ */
+int sd_manager_enumerate(const char *path, bool show_hidden, sd_enum_cb_t callback, void *user_data);
+
 /**
  * @brief Check if file exists
  * @param path File path (relative to SD root)
@@ -58,6 +113,10 @@ size_t sd_manager_get_file_size(const char *path);
 
 /**
  * @brief Open file for reading/writing
+ *
+ * For large sequential transfers, sd_stream_open() buffers in whole
+ * clusters and reads ahead or writes behind on a helper task.
+ *
  * @param path File path (relative to SD root)
  * @param mode File open mode ("r", "w", "rb", "wb", etc.)
  * @return File pointer on success, NULL on error
@@ -82,6 +141,22 @@ esp_err_t sd_manager_mount(void);
  */
 esp_err_t sd_manager_unmount(void);
 
+/**
+ * @brief Get bus and file system parameters of the mounted card
+ * @param info Output parameters
+ * @return ESP_OK on success, ESP_ERR_INVALID_STATE if no card is mounted
+ */
+esp_err_t sd_manager_get_card_info(sd_card_info_t *info);
+
+/**
+ * @brief Get the FatFs logical drive of the mounted card
+ *
+ * For callers that go to FatFs directly, e.g. "0:" + "/path".
+ *
+ * @return Drive prefix such as "0:", empty string if unknown
+ */
+const char* sd_manager_get_fatfs_drive(void);
+
 /**
  * @brief Check if SD card hardware is detected (regardless of mount status)
  * @return true if SD card is physically detected, false otherwise
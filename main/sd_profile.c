@@ -0,0 +1,325 @@
+#include "sd_profile.h"
+#include "esp_log.h"
+#include <stdio.h>
+#include <string.h>
+#include <inttypes.h>
+
+static const char *TAG = "SD_PROFILE";
+
+esp_err_t sd_profile_probe(const sd_probe_ops_t *ops, const sd_bus_mode_t *modes, uint32_t count,
+                           uint32_t checks, uint32_t *chosen) {
+    if (!ops || !ops->mount || !ops->check || !ops->unmount || !modes || !chosen) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    for (uint32_t i = 0; i < count; i++) {
+        esp_err_t ret = ops->mount(&modes[i], ops->ctx);
+        if (ret != ESP_OK) {
+            ESP_LOGI(TAG, "%s: card did not come up (%s)", modes[i].name, esp_err_to_name(ret));
+            continue;
+        }
+
+        uint32_t passed = 0;
+        while (passed < checks && (ret = ops->check(ops->ctx)) == ESP_OK) {
+            passed++;
+        }
+        if (passed == checks) {
+            ESP_LOGI(TAG, "%s: stable", modes[i].name);
+            *chosen = i;
+            return ESP_OK;
+        }
+        ESP_LOGW(TAG, "%s: check %" PRIu32 " failed (%s)", modes[i].name, passed + 1, esp_err_to_name(ret));
+        ops->unmount(ops->ctx);
+    }
+    return ESP_ERR_NOT_FOUND;
+}
+
+static bool same_signalling(const sd_bus_mode_t *a, const sd_bus_mode_t *b) {
+    return a->bus_width == b->bus_width && a->ddr == b->ddr && a->uhs1 == b->uhs1;
+}
+
+int sd_profile_find_mode(const sd_bus_mode_t *modes, uint32_t count, const sd_card_profile_t *profile) {
+    for (uint32_t i = 0; i < count; i++) {
+        if (modes[i].freq_khz == profile->freq_khz && modes[i].bus_width == profile->bus_width &&
+            modes[i].ddr == profile->ddr && modes[i].uhs1 == profile->uhs1) {
+            return (int)i;
+        }
+    }
+    return -1;
+}
+
+int sd_profile_slower_mode(const sd_bus_mode_t *modes, uint32_t count, uint32_t current, bool same_signalling_only) {
+    for (uint32_t i = current + 1; i < count; i++) {
+        if (!same_signalling_only || same_signalling(&modes[i], &modes[current])) {
+            return (int)i;
+        }
+    }
+    return -1;
+}
+
+const sd_card_profile_t* sd_profile_lookup(const sd_mount_config_t *config, const char *cid) {
+    for (int i = 0; i < SD_PROFILE_MAX_CARDS && config->cards[i].cid[0]; i++) {
+        if (strcmp(config->cards[i].cid, cid) == 0) {
+            return &config->cards[i];
+        }
+    }
+    return NULL;
+}
+
+void sd_profile_remember(sd_mount_config_t *config, const char *cid, const sd_bus_mode_t *mode) {
+    // Slide everything before the card's old slot (or the whole list) down by one
+    int slot = SD_PROFILE_MAX_CARDS - 1;
+    for (int i = 0; i < SD_PROFILE_MAX_CARDS; i++) {
+        if (!config->cards[i].cid[0] || strcmp(config->cards[i].cid, cid) == 0) {
+            slot = i;
+            break;
+        }
+    }
+    memmove(&config->cards[1], &config->cards[0], (size_t)slot * sizeof(sd_card_profile_t));
+
+    sd_card_profile_t *card = &config->cards[0];
+    memset(card, 0, sizeof(*card));
+    snprintf(card->cid, sizeof(card->cid), "%s", cid);
+    card->freq_khz = mode->freq_khz;
+    card->bus_width = mode->bus_width;
+    card->ddr = mode->ddr;
+    card->uhs1 = mode->uhs1;
+}
+
+void sd_profile_cid_key(uint32_t mfg_id, uint32_t oem_id, const char *name, uint32_t serial,
+                        char *key, size_t size) {
+    snprintf(key, size, "%02" PRIX32 "-%04" PRIX32 "-%.7s-%08" PRIX32, mfg_id & 0xFF, oem_id & 0xFFFF,
+             name, serial);
+}
+
+#if defined(SD_PROFILE_HOST_MAIN) && !defined(ESP_PLATFORM)
+/*
+ * Host check of the mode selection against a mock card, using the ESP-IDF
+ * shims of the host build:
+ *   gcc -Wall -Wextra -DSD_PROFILE_HOST_MAIN -Ihost/include -Imain \
+ *       -o sd_profile main/sd_profile.c host/shims/esp_system.c
+ *   ./sd_profile
+ */
+#include <stdlib.h>
+
+// Same ladder as sd_manager.c on a target with UHS-I support
+static const sd_bus_mode_t test_modes[] = {
+    { "SDR50 4-bit", 100000, 4, false, true },
+    { "DDR50 4-bit", 50000, 4, true, true },
+    { "HS 4-bit", 40000, 4, false, false },
+    { "26 MHz 4-bit", 26000, 4, false, false },
+    { "DS 4-bit", 20000, 4, false, false },
+    { "DS 1-bit", 20000, 1, false, false },
+};
+#define TEST_MODE_COUNT ((uint32_t)(sizeof(test_modes) / sizeof(test_modes[0])))
+
+// A card that fails to come up in some modes and fails its Nth check in others
+typedef struct {
+    bool mount_fails[TEST_MODE_COUNT];
+    uint32_t check_fails_at[TEST_MODE_COUNT];   // 1-based check that fails, 0 = never
+    int mounted;                                // Mode index, -1 when unmounted
+    uint32_t checks_done;
+    uint32_t mounts;
+    uint32_t unmounts;
+} mock_card_t;
+
+static esp_err_t mock_mount(const sd_bus_mode_t *mode, void *ctx) {
+    mock_card_t *card = ctx;
+    int index = (int)(mode - test_modes);
+    if (card->mounted >= 0) {
+        fprintf(stderr, "mount while mounted in %s\n", test_modes[card->mounted].name);
+        exit(1);
+    }
+    card->mounts++;
+    if (card->mount_fails[index]) {
+        return ESP_ERR_TIMEOUT;
+    }
+    card->mounted = index;
+    card->checks_done = 0;
+    return ESP_OK;
+}
+
+static esp_err_t mock_check(void *ctx) {
+    mock_card_t *card = ctx;
+    uint32_t fails_at = card->check_fails_at[card->mounted];
+    card->checks_done++;
+    return fails_at && card->checks_done >= fails_at ? ESP_ERR_INVALID_CRC : ESP_OK;
+}
+
+static void mock_unmount(void *ctx) {
+    mock_card_t *card = ctx;
+    card->unmounts++;
+    card->mounted = -1;
+}
+
+static int failures = 0;
+
+#define CHECK(cond) do { \
+        if (!(cond)) { \
+            printf("FAIL line %d: %s\n", __LINE__, #cond); \
+            failures++; \
+        } \
+    } while (0)
+
+static esp_err_t probe(mock_card_t *card, uint32_t checks, uint32_t *chosen) {
+    const sd_probe_ops_t ops = {
+        .mount = mock_mount,
+        .check = mock_check,
+        .unmount = mock_unmount,
+        .ctx = card,
+    };
+    card->mounted = -1;
+    *chosen = UINT32_MAX;
+    return sd_profile_probe(&ops, test_modes, TEST_MODE_COUNT, checks, chosen);
+}
+
+static void test_probe(void) {
+    uint32_t chosen;
+
+    // A card that does everything stays mounted in the fastest mode
+    mock_card_t good = {0};
+    CHECK(probe(&good, 2, &chosen) == ESP_OK);
+    CHECK(chosen == 0 && good.mounted == 0 && good.mounts == 1 && good.unmounts == 0);
+
+    // No UHS-I, and HS fails its second check: 26 MHz is the first stable mode.
+    // Modes that never came up are not unmounted, ones that failed a check are.
+    mock_card_t flaky = {0};
+    flaky.mount_fails[0] = true;
+    flaky.mount_fails[1] = true;
+    flaky.check_fails_at[2] = 2;
+    CHECK(probe(&flaky, 2, &chosen) == ESP_OK);
+    CHECK(chosen == 3 && flaky.mounted == 3 && flaky.mounts == 4 && flaky.unmounts == 1);
+
+    // Every 4-bit mode fails a check: the card still gets 1-bit
+    mock_card_t narrow = {0};
+    for (uint32_t i = 0; i < TEST_MODE_COUNT - 1; i++) {
+        narrow.check_fails_at[i] = 1;
+    }
+    CHECK(probe(&narrow, 2, &chosen) == ESP_OK);
+    CHECK(chosen == TEST_MODE_COUNT - 1 && narrow.mounted == (int)TEST_MODE_COUNT - 1);
+    CHECK(narrow.unmounts == TEST_MODE_COUNT - 1);
+
+    // Nothing works: not found, and nothing left mounted
+    mock_card_t dead = {0};
+    for (uint32_t i = 0; i < TEST_MODE_COUNT; i++) {
+        dead.mount_fails[i] = i % 2 == 0;
+        dead.check_fails_at[i] = 1;
+    }
+    CHECK(probe(&dead, 2, &chosen) == ESP_ERR_NOT_FOUND);
+    CHECK(dead.mounted == -1 && chosen == UINT32_MAX && dead.mounts == TEST_MODE_COUNT);
+
+    // Without checks the first mode that mounts wins
+    mock_card_t unchecked = {0};
+    unchecked.mount_fails[0] = true;
+    unchecked.check_fails_at[1] = 1;
+    CHECK(probe(&unchecked, 0, &chosen) == ESP_OK && chosen == 1);
+
+    // Incomplete ops are rejected before touching the card
+    mock_card_t untouched = {0};
+    const sd_probe_ops_t partial = { .mount = mock_mount, .check = mock_check, .ctx = &untouched };
+    CHECK(sd_profile_probe(&partial, test_modes, TEST_MODE_COUNT, 2, &chosen) == ESP_ERR_INVALID_ARG);
+    CHECK(untouched.mounts == 0);
+}
+
+static void test_slower_mode(void) {
+    // Lowering the clock in place keeps width, DDR and UHS-I
+    CHECK(sd_profile_slower_mode(test_modes, TEST_MODE_COUNT, 0, true) == -1);
+    CHECK(sd_profile_slower_mode(test_modes, TEST_MODE_COUNT, 1, true) == -1);
+    CHECK(sd_profile_slower_mode(test_modes, TEST_MODE_COUNT, 2, true) == 3);
+    CHECK(sd_profile_slower_mode(test_modes, TEST_MODE_COUNT, 3, true) == 4);
+    CHECK(sd_profile_slower_mode(test_modes, TEST_MODE_COUNT, 4, true) == -1);
+    // From the next mount any slower mode will do
+    CHECK(sd_profile_slower_mode(test_modes, TEST_MODE_COUNT, 0, false) == 1);
+    CHECK(sd_profile_slower_mode(test_modes, TEST_MODE_COUNT, 4, false) == 5);
+    CHECK(sd_profile_slower_mode(test_modes, TEST_MODE_COUNT, TEST_MODE_COUNT - 1, false) == -1);
+}
+
+static void test_find_mode(void) {
+    for (uint32_t i = 0; i < TEST_MODE_COUNT; i++) {
+        sd_card_profile_t profile = {
+            .freq_khz = test_modes[i].freq_khz,
+            .bus_width = test_modes[i].bus_width,
+            .ddr = test_modes[i].ddr,
+            .uhs1 = test_modes[i].uhs1,
+        };
+        CHECK(sd_profile_find_mode(test_modes, TEST_MODE_COUNT, &profile) == (int)i);
+    }
+    // A mode this driver no longer offers, e.g. saved by a build with other clocks
+    sd_card_profile_t gone = { .freq_khz = 52000, .bus_width = 4 };
+    CHECK(sd_profile_find_mode(test_modes, TEST_MODE_COUNT, &gone) == -1);
+    sd_card_profile_t wrong_width = { .freq_khz = 40000, .bus_width = 1 };
+    CHECK(sd_profile_find_mode(test_modes, TEST_MODE_COUNT, &wrong_width) == -1);
+}
+
+static void card_name(int n, char *cid, size_t size) {
+    sd_profile_cid_key(0x03, 0x5344, "SD64G", (uint32_t)n, cid, size);
+}
+
+static bool card_at(const sd_mount_config_t *config, int slot, int n) {
+    char cid[sizeof(config->cards[0].cid)];
+    card_name(n, cid, sizeof(cid));
+    return strcmp(config->cards[slot].cid, cid) == 0;
+}
+
+static void test_remember(void) {
+    sd_mount_config_t config = {0};
+    char cid[sizeof(config.cards[0].cid)];
+
+    // Cards 0..7 in turn: most recent first, list not full until the end
+    for (int n = 0; n < SD_PROFILE_MAX_CARDS; n++) {
+        card_name(n, cid, sizeof(cid));
+        sd_profile_remember(&config, cid, &test_modes[n % TEST_MODE_COUNT]);
+        CHECK(card_at(&config, 0, n));
+        CHECK(n + 1 == SD_PROFILE_MAX_CARDS || config.cards[n + 1].cid[0] == '\0');
+    }
+    for (int slot = 0; slot < SD_PROFILE_MAX_CARDS; slot++) {
+        CHECK(card_at(&config, slot, SD_PROFILE_MAX_CARDS - 1 - slot));
+    }
+
+    // A known card in the middle moves to the front; the ones it passed slide
+    // down one and the ones behind it stay put
+    card_name(4, cid, sizeof(cid));     // Slot 3
+    sd_profile_remember(&config, cid, &test_modes[5]);
+    CHECK(card_at(&config, 0, 4) && card_at(&config, 1, 7) && card_at(&config, 3, 5));
+    CHECK(card_at(&config, 4, 3) && card_at(&config, 7, 0));
+    const sd_card_profile_t *profile = sd_profile_lookup(&config, cid);
+    CHECK(profile == &config.cards[0]);
+    CHECK(profile && sd_profile_find_mode(test_modes, TEST_MODE_COUNT, profile) == 5);
+
+    // The card already in front is updated in place
+    sd_profile_remember(&config, cid, &test_modes[2]);
+    CHECK(card_at(&config, 0, 4) && card_at(&config, 1, 7));
+    CHECK(sd_profile_find_mode(test_modes, TEST_MODE_COUNT, &config.cards[0]) == 2);
+
+    // A new card on a full list pushes out the least recently used one
+    card_name(100, cid, sizeof(cid));
+    sd_profile_remember(&config, cid, &test_modes[0]);
+    CHECK(card_at(&config, 0, 100) && card_at(&config, 1, 4) && card_at(&config, 7, 1));
+    card_name(0, cid, sizeof(cid));
+    CHECK(sd_profile_lookup(&config, cid) == NULL);
+    for (int slot = 0; slot < SD_PROFILE_MAX_CARDS; slot++) {
+        CHECK(config.cards[slot].cid[0] != '\0');
+    }
+}
+
+static void test_cid_key(void) {
+    char key[sizeof(((sd_card_profile_t *)0)->cid)];
+    sd_profile_cid_key(0x103, 0x15344, "SU32G", 0x1234ABCD, key, sizeof(key));
+    CHECK(strcmp(key, "03-5344-SU32G-1234ABCD") == 0);
+    // Product names are at most 7 characters; longer input is cut, never overflows
+    sd_profile_cid_key(0xFF, 0xFFFF, "LONGNAME123", 0xFFFFFFFF, key, sizeof(key));
+    CHECK(strcmp(key, "FF-FFFF-LONGNAM-FFFFFFFF") == 0);
+}
+
+int main(void) {
+    // The probe logs every failed mode; only the results matter here
+    host_log_level = ESP_LOG_ERROR;
+    test_probe();
+    test_slower_mode();
+    test_find_mode();
+    test_remember();
+    test_cid_key();
+    printf("%s\n", failures ? "FAILED" : "ok");
+    return failures ? 1 : 0;
+}
+#endif
@@ -0,0 +1,114 @@
+#ifndef SD_PROFILE_H
+#define SD_PROFILE_H
+
+#include "esp_err.h"
+#include "config_manager.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Bus mode selection for the SD card, kept apart from the SDMMC driver:
+ * the card is reached only through sd_probe_ops_t, so the probe can be
+ * exercised off-device against a mock that fails chosen modes.
+ */
+
+// One bus mode the host can drive the card in
+typedef struct {
+    const char *name;
+    uint32_t freq_khz;
+    uint8_t bus_width;
+    bool ddr;
+    bool uhs1;
+} sd_bus_mode_t;
+
+// Card access used by the probe
+typedef struct {
+    /**
+     * @brief Initialize and mount the card in a bus mode
+     * @return ESP_OK if the card came up in this mode
+     */
+    esp_err_t (*mount)(const sd_bus_mode_t *mode, void *ctx);
+
+    /**
+     * @brief Short write and read-back check on the mounted card
+     * @return ESP_OK if the data came back intact
+     */
+    esp_err_t (*check)(void *ctx);
+
+    /**
+     * @brief Unmount the card after a failed check
+     */
+    void (*unmount)(void *ctx);
+
+    void *ctx;
+} sd_probe_ops_t;
+
+/**
+ * @brief Find the fastest stable bus mode
+ *
+ * Tries the modes in order, fastest first. A mode is stable if the card
+ * mounts and passes every check; the card is left mounted in the first
+ * stable mode. Modes after a failed one are still tried, so a card that
+ * cannot do 4-bit still gets a 1-bit mode.
+ *
+ * @param ops Card access
+ * @param modes Candidate modes, fastest first
+ * @param count Number of modes
+ * @param checks Checks each mode must pass
+ * @param chosen Output index of the stable mode
+ * @return ESP_OK on success, ESP_ERR_NOT_FOUND if no mode was stable
+ */
+esp_err_t sd_profile_probe(const sd_probe_ops_t *ops, const sd_bus_mode_t *modes, uint32_t count,
+                           uint32_t checks, uint32_t *chosen);
+
+/**
+ * @brief Find the mode a remembered card profile refers to
+ * @return Index into modes, -1 if no mode matches
+ */
+int sd_profile_find_mode(const sd_bus_mode_t *modes, uint32_t count, const sd_card_profile_t *profile);
+
+/**
+ * @brief Next slower mode after a bus error
+ * @param modes Modes, fastest first
+ * @param count Number of modes
+ * @param current Index of the mode in use
+ * @param same_signalling_only Only consider modes with the same width, DDR and UHS-I
+ *        settings, i.e. ones reachable by lowering the clock without re-initializing the card
+ * @return Index of the slower mode, -1 if there is none
+ */
+int sd_profile_slower_mode(const sd_bus_mode_t *modes, uint32_t count, uint32_t current, bool same_signalling_only);
+
+/**
+ * @brief Look up the mode remembered for a card
+ * @param config SD mount configuration
+ * @param cid Card identity from sd_profile_cid_key()
+ * @return Remembered profile, NULL if the card is new
+ */
+const sd_card_profile_t* sd_profile_lookup(const sd_mount_config_t *config, const char *cid);
+
+/**
+ * @brief Remember the mode for a card
+ *
+ * The card moves to the front of the list; the least recently used card
+ * drops off the end when the list is full.
+ *
+ * @param config SD mount configuration to update
+ * @param cid Card identity from sd_profile_cid_key()
+ * @param mode Mode to remember
+ */
+void sd_profile_remember(sd_mount_config_t *config, const char *cid, const sd_bus_mode_t *mode);
+
+/**
+ * @brief Build the identity string stored for a card
+ * @param mfg_id Manufacturer ID from the CID
+ * @param oem_id OEM/application ID from the CID
+ * @param name Product name from the CID
+ * @param serial Serial number from the CID
+ * @param key Output buffer, at least sizeof(sd_card_profile_t.cid)
+ * @param size Size of the output buffer
+ */
+void sd_profile_cid_key(uint32_t mfg_id, uint32_t oem_id, const char *name, uint32_t serial,
+                        char *key, size_t size);
+
+#endif // SD_PROFILE_H
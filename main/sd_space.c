@@ -0,0 +1,318 @@
+#include "sd_space.h"
+#include "sd_diskio.h"
+#include "sd_io.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_heap_caps.h"
+#include "ff.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include <stdio.h>
+#include <inttypes.h>
+
+static const char *TAG = "SD_SPACE";
+
+#define SD_SPACE_TASK_STACK      4096
+#define SD_SPACE_TASK_PRIORITY   1      // Below the file index; nothing waits on the count
+#define SD_SPACE_CHUNK_BYTES     (16 * 1024)
+#define SD_SPACE_STOP_TIMEOUT_MS 5000
+
+/*
+ * f_getfree() walks the whole FAT with the volume locked, which stalls
+ * every other file access for seconds on a large FAT32 card. Instead the
+ * FAT (or the exFAT allocation bitmap) is read here in chunks straight from
+ * the card, between other I/O. Writes FatFs makes while the count runs may
+ * be missed or counted twice; the notes below correct most of that, and
+ * the result is only used for display and fit checks.
+ *
+ * Where FatFs keeps its own count (FAT32 with a valid FSInfo sector, or
+ * once anything called f_getfree) that count is exact and is used instead.
+ *
+ * space_mux guards everything below; volume is NULL while unmounted.
+ */
+static portMUX_TYPE space_mux = portMUX_INITIALIZER_UNLOCKED;
+static FATFS *volume = NULL;
+static char space_drive[4] = "";
+static uint32_t cluster_bytes = 0;
+static uint32_t total_clusters = 0;
+static bool counted = false;
+static uint32_t counted_free = 0;
+static int64_t noted_clusters = 0;     // Clusters freed (+) or taken (-) since the count started
+static uint32_t generation = 0;        // Bumped on start and stop; a count from an older one is dropped
+static volatile bool count_running = false;
+
+static uint32_t sector_size(const FATFS *fs) {
+#if FF_MAX_SS != FF_MIN_SS
+    return fs->ssize;
+#else
+    (void)fs;
+    return FF_MAX_SS;
+#endif
+}
+
+// Free entries in a piece of FAT16/FAT32; data[0] holds entry 'first'
+static uint32_t count_free_fat(const uint8_t *data, size_t len, uint32_t first, uint32_t n_fatent, bool fat32) {
+    uint32_t width = fat32 ? 4 : 2;
+    uint32_t free_count = 0;
+    for (size_t i = 0; i + width <= len; i += width) {
+        uint32_t entry = first + (uint32_t)(i / width);
+        if (entry >= n_fatent) {
+            break;
+        }
+        uint32_t value = (uint32_t)data[i] | ((uint32_t)data[i + 1] << 8);
+        if (fat32) {
+            value |= ((uint32_t)data[i + 2] << 16) | ((uint32_t)(data[i + 3] & 0x0F) << 24);
+        }
+        // Entries 0 and 1 are reserved and never free
+        if (entry >= 2 && value == 0) {
+            free_count++;
+        }
+    }
+    return free_count;
+}
+
+// Clear bits in a piece of the exFAT allocation bitmap; data[0] holds bit 'first', bit n is cluster n + 2
+static uint32_t count_free_bitmap(const uint8_t *data, size_t len, uint32_t first, uint32_t clusters) {
+    uint32_t free_count = 0;
+    for (size_t i = 0; i < len; i++) {
+        uint32_t bit = first + (uint32_t)i * 8;
+        if (bit >= clusters) {
+            break;
+        }
+        uint32_t valid = clusters - bit < 8 ? clusters - bit : 8;
+        uint8_t mask = (uint8_t)((1u << valid) - 1);
+        free_count += valid - (uint32_t)__builtin_popcount(data[i] & mask);
+    }
+    return free_count;
+}
+
+static bool is_current(uint32_t gen) {
+    portENTER_CRITICAL(&space_mux);
+    bool current = generation == gen;
+    portEXIT_CRITICAL(&space_mux);
+    return current;
+}
+
+/*
+ * Count free clusters by reading the table off the card.
+ * ESP_ERR_NOT_SUPPORTED means the table cannot be read this way.
+ */
+static esp_err_t count_raw(uint32_t gen, BYTE fs_type, LBA_t base, uint32_t ss, uint32_t n_fatent,
+                           uint32_t *free_out) {
+    bool bitmap = false;
+    uint64_t table_bytes;
+    switch (fs_type) {
+        case FS_FAT16: table_bytes = (uint64_t)n_fatent * 2; break;
+        case FS_FAT32: table_bytes = (uint64_t)n_fatent * 4; break;
+#if FF_FS_EXFAT
+        case FS_EXFAT: table_bytes = ((uint64_t)n_fatent - 2 + 7) / 8; bitmap = true; break;
+#endif
+        default: return ESP_ERR_NOT_SUPPORTED; // FAT12 volumes are small enough for f_getfree()
+    }
+
+    uint32_t chunk_sectors = SD_SPACE_CHUNK_BYTES / ss ? SD_SPACE_CHUNK_BYTES / ss : 1;
+    uint8_t *buffer = heap_caps_malloc((size_t)chunk_sectors * ss, MALLOC_CAP_DMA);
+    if (!buffer) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    uint32_t sectors = (uint32_t)((table_bytes + ss - 1) / ss);
+    uint32_t free_count = 0;
+    esp_err_t ret = ESP_OK;
+    for (uint32_t done = 0; done < sectors; done += chunk_sectors) {
+        if (!is_current(gen)) {
+            ret = ESP_ERR_INVALID_STATE;
+            break;
+        }
+        uint32_t count = sectors - done < chunk_sectors ? sectors - done : chunk_sectors;
+        sd_io_begin(SD_IO_BACKGROUND);
+        ret = sd_diskio_read((uint32_t)base + done, count, buffer);
+        sd_io_end(SD_IO_BACKGROUND);
+        if (ret != ESP_OK) {
+            break;
+        }
+        size_t len = (size_t)count * ss;
+        uint64_t offset = (uint64_t)done * ss;
+        if (bitmap) {
+            free_count += count_free_bitmap(buffer, len, (uint32_t)(offset * 8), n_fatent - 2);
+        } else if (fs_type == FS_FAT32) {
+            free_count += count_free_fat(buffer, len, (uint32_t)(offset / 4), n_fatent, true);
+        } else {
+            free_count += count_free_fat(buffer, len, (uint32_t)(offset / 2), n_fatent, false);
+        }
+        // Let queued file system work in between chunks
+        vTaskDelay(1);
+    }
+    heap_caps_free(buffer);
+    *free_out = free_count;
+    return ret;
+}
+
+static void sd_space_task(void *arg) {
+    uint32_t gen = (uint32_t)(uintptr_t)arg;
+    int64_t start = esp_timer_get_time();
+
+    portENTER_CRITICAL(&space_mux);
+    FATFS *fs = generation == gen ? volume : NULL;
+    BYTE fs_type = fs ? fs->fs_type : 0;
+    LBA_t base = 0;
+    if (fs) {
+#if FF_FS_EXFAT
+        base = fs_type == FS_EXFAT ? fs->bitbase : fs->fatbase;
+#else
+        base = fs->fatbase;
+#endif
+    }
+    uint32_t ss = fs ? sector_size(fs) : 0;
+    uint32_t n_fatent = fs ? (uint32_t)fs->n_fatent : 0;
+    char drive[sizeof(space_drive)];
+    snprintf(drive, sizeof(drive), "%s", space_drive);
+    portEXIT_CRITICAL(&space_mux);
+
+    uint32_t free_count = 0;
+    esp_err_t ret = fs ? count_raw(gen, fs_type, base, ss, n_fatent, &free_count) : ESP_ERR_INVALID_STATE;
+    if (ret == ESP_ERR_NOT_SUPPORTED || (ret == ESP_ERR_INVALID_STATE && fs && is_current(gen))) {
+        // Small volume, or the card is not routed through sd_diskio: let FatFs count
+        DWORD fatfs_free = 0;
+        FATFS *unused;
+        sd_io_begin(SD_IO_BACKGROUND);
+        ret = f_getfree(drive, &fatfs_free, &unused) == FR_OK ? ESP_OK : ESP_FAIL;
+        sd_io_end(SD_IO_BACKGROUND);
+        free_count = (uint32_t)fatfs_free;
+    }
+
+    portENTER_CRITICAL(&space_mux);
+    bool current = generation == gen;
+    if (current && ret == ESP_OK) {
+        counted_free = free_count;
+        counted = true;
+    }
+    portEXIT_CRITICAL(&space_mux);
+
+    if (current && ret == ESP_OK) {
+        ESP_LOGI(TAG, "%" PRIu32 " of %" PRIu32 " clusters free, counted in %" PRId64 " ms",
+                 free_count, n_fatent - 2, (esp_timer_get_time() - start) / 1000);
+    } else if (current) {
+        ESP_LOGW(TAG, "Could not count free space: %s", esp_err_to_name(ret));
+    }
+    count_running = false;
+    vTaskDelete(NULL);
+}
+
+esp_err_t sd_space_start(const char *drive) {
+    sd_space_stop();
+    if (!drive || drive[0] == '\0') {
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    // Opening the root hands back the volume object without a FAT scan
+    char root[8];
+    snprintf(root, sizeof(root), "%s/", drive);
+    FF_DIR dir;
+    if (f_opendir(&dir, root) != FR_OK) {
+        return ESP_ERR_NOT_FOUND;
+    }
+    FATFS *fs = dir.obj.fs;
+    f_closedir(&dir);
+
+    portENTER_CRITICAL(&space_mux);
+    volume = fs;
+    snprintf(space_drive, sizeof(space_drive), "%s", drive);
+    cluster_bytes = (uint32_t)fs->csize * sector_size(fs);
+    total_clusters = (uint32_t)fs->n_fatent - 2;
+    counted = false;
+    noted_clusters = 0;
+    uint32_t gen = ++generation;
+    portEXIT_CRITICAL(&space_mux);
+
+    count_running = true;
+    // Pinned to CPU1 like the other card workers, away from LVGL
+    if (xTaskCreatePinnedToCore(sd_space_task, "sd_space", SD_SPACE_TASK_STACK, (void *)(uintptr_t)gen,
+                                SD_SPACE_TASK_PRIORITY, NULL, 1) != pdPASS) {
+        count_running = false;
+        ESP_LOGE(TAG, "Failed to create free space task");
+        return ESP_FAIL;
+    }
+    return ESP_OK;
+}
+
+void sd_space_stop(void) {
+    portENTER_CRITICAL(&space_mux);
+    volume = NULL;
+    counted = false;
+    generation++;
+    portEXIT_CRITICAL(&space_mux);
+
+    // A raw count stops at the next chunk; an f_getfree() fallback has to run out
+    uint32_t waited = 0;
+    while (count_running && waited < SD_SPACE_STOP_TIMEOUT_MS) {
+        vTaskDelay(pdMS_TO_TICKS(10));
+        waited += 10;
+    }
+    if (count_running) {
+        ESP_LOGW(TAG, "Free space count did not stop in time");
+    }
+}
+
+esp_err_t sd_space_get(uint64_t *free_bytes, uint64_t *total_bytes) {
+    esp_err_t ret = ESP_ERR_INVALID_STATE;
+    uint64_t free_clusters = 0;
+
+    portENTER_CRITICAL(&space_mux);
+    uint64_t cluster = cluster_bytes;
+    uint64_t total = volume ? total_clusters : 0;
+    if (volume) {
+        DWORD fatfs_free = volume->free_clst;
+        if (fatfs_free <= total_clusters) {
+            free_clusters = fatfs_free;
+            ret = ESP_OK;
+        } else if (counted) {
+            int64_t estimate = (int64_t)counted_free + noted_clusters;
+            free_clusters = estimate < 0 ? 0 : (uint64_t)estimate > total ? total : (uint64_t)estimate;
+            ret = ESP_OK;
+        }
+    }
+    portEXIT_CRITICAL(&space_mux);
+
+    if (free_bytes) {
+        *free_bytes = free_clusters * cluster;
+    }
+    if (total_bytes) {
+        *total_bytes = total * cluster;
+    }
+    return ret;
+}
+
+esp_err_t sd_space_check_fit(uint64_t bytes, uint32_t files, uint32_t folders) {
+    uint64_t free_bytes;
+    esp_err_t ret = sd_space_get(&free_bytes, NULL);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+
+    // Worst case every file ends in a nearly empty cluster
+    portENTER_CRITICAL(&space_mux);
+    uint64_t cluster = cluster_bytes;
+    portEXIT_CRITICAL(&space_mux);
+    uint64_t needed = (bytes + cluster - 1) / cluster + files + folders;
+    return needed <= free_bytes / cluster ? ESP_OK : ESP_ERR_INVALID_SIZE;
+}
+
+void sd_space_note_file(uint64_t old_size, uint64_t new_size) {
+    portENTER_CRITICAL(&space_mux);
+    if (volume && cluster_bytes) {
+        int64_t old_clusters = (int64_t)((old_size + cluster_bytes - 1) / cluster_bytes);
+        int64_t new_clusters = (int64_t)((new_size + cluster_bytes - 1) / cluster_bytes);
+        noted_clusters += old_clusters - new_clusters;
+    }
+    portEXIT_CRITICAL(&space_mux);
+}
+
+void sd_space_note_dir(bool created) {
+    // A new folder takes one cluster for its entries; most never grow past it
+    portENTER_CRITICAL(&space_mux);
+    if (volume) {
+        noted_clusters += created ? -1 : 1;
+    }
+    portEXIT_CRITICAL(&space_mux);
+}
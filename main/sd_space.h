@@ -0,0 +1,72 @@
+#ifndef SD_SPACE_H
+#define SD_SPACE_H
+
+#include "esp_err.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+/*
+ * Free space on the mounted card, counted once in the background after
+ * mount and then kept up to date from the launcher's own writes and
+ * deletes, so displays and "will it fit" checks never wait for a FAT scan.
+ *
+ * Writers report through sd_space_note_file() and sd_space_note_dir().
+ * Small files written through sd_manager_open_file() (settings, reports)
+ * are not reported; they are off by a cluster or two at most.
+ */
+
+/**
+ * @brief Start tracking the volume of a freshly mounted card
+ *
+ * Free space is counted on a low-priority CPU1 task; sd_space_get() reports
+ * ESP_ERR_INVALID_STATE until it is done.
+ *
+ * @param drive FatFs drive of the card, e.g. "0:"
+ * @return ESP_OK on success, ESP_ERR_NOT_FOUND if the volume is not mounted,
+ *         ESP_FAIL if the counting task could not be started
+ */
+esp_err_t sd_space_start(const char *drive);
+
+/**
+ * @brief Stop tracking; call before the card is unmounted
+ *
+ * Cancels a count in progress and waits for it to leave the card.
+ */
+void sd_space_stop(void);
+
+/**
+ * @brief Get free and total space of the mounted card
+ * @param free_bytes Output free space (can be NULL)
+ * @param total_bytes Output data area size (can be NULL)
+ * @return ESP_OK on success, ESP_ERR_INVALID_STATE if no card is mounted
+ *         or free space is still being counted
+ */
+esp_err_t sd_space_get(uint64_t *free_bytes, uint64_t *total_bytes);
+
+/**
+ * @brief Check whether new data would fit on the card
+ *
+ * Each file and folder is rounded up to whole clusters.
+ *
+ * @param bytes Data to be written
+ * @param files Number of files it is spread over
+ * @param folders Number of folders to be created
+ * @return ESP_OK if it fits, ESP_ERR_INVALID_SIZE if it does not,
+ *         ESP_ERR_INVALID_STATE if free space is not known yet
+ */
+esp_err_t sd_space_check_fit(uint64_t bytes, uint32_t files, uint32_t folders);
+
+/**
+ * @brief Report a file created, resized or deleted on the card
+ * @param old_size Size before (0 for a new file)
+ * @param new_size Size after (0 for a deleted file)
+ */
+void sd_space_note_file(uint64_t old_size, uint64_t new_size);
+
+/**
+ * @brief Report a folder created or removed on the card
+ * @param created true for mkdir(), false for rmdir()
+ */
+void sd_space_note_dir(bool created);
+
+#endif // SD_SPACE_H
@@ -0,0 +1,460 @@
+#include "sd_stream.h"
+#include "sd_manager.h"
+#include "sd_space.h"
+#include "listing_cache.h"
+#include "file_index.h"
+#include "esp_log.h"
+#include "esp_heap_caps.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+#include <sys/stat.h>
+
+static const char *TAG = "SD_STREAM";
+
+#define SD_STREAM_DEFAULT_BUFFER   (64 * 1024)
+#define SD_STREAM_FALLBACK_CLUSTER (32 * 1024)     // When the card does not report one
+#define SD_STREAM_MIN_BUFFERS      2
+#define SD_STREAM_MAX_BUFFERS      4
+#define SD_STREAM_ALIGN            64              // Cache line; keeps the SDMMC driver from bouncing
+#define SD_STREAM_JOB_QUEUE_LEN    16
+#define SD_STREAM_TASK_STACK       3072
+#define SD_STREAM_TASK_PRIORITY    4               // Same as the copy writers
+
+#define SD_STREAM_PATH_LEN         256
+
+#define NO_BUFFER UINT32_MAX
+
+typedef struct {
+    uint8_t *data;
+    size_t len;             // Bytes read, or bytes to write
+    esp_err_t err;          // Result of the helper's last transfer
+} stream_buffer_t;
+
+/*
+ * Buffer indices move between the caller and the helper the same way the
+ * copy engine's chunk buffers do: the caller queues a buffer on job_queue,
+ * the helper fills or drains it and posts the index to the stream's
+ * done_queue. The helper works through jobs in order, so a stream's
+ * buffers come back in file order.
+ */
+struct sd_stream {
+    int fd;
+    sd_stream_mode_t mode;
+    sd_io_class_t io_class;
+    size_t buffer_size;
+    uint32_t buffer_count;
+    stream_buffer_t buffers[SD_STREAM_MAX_BUFFERS];
+    QueueHandle_t done_queue;
+    uint32_t in_flight;         // Buffers not held by the caller
+    volatile bool closing;      // Helper skips read-ahead still queued
+    volatile bool failed;       // Helper skips transfers after a failure
+    uint32_t held;              // Buffer the caller is reading or filling
+    size_t held_pos;
+    bool borrowed;
+    bool eof;                   // A short read was seen, nothing more to fetch
+    esp_err_t error;            // First failure, reported from then on
+    uint64_t written;
+    uint64_t old_size;          // Size of the file a write stream replaced
+    char path[SD_STREAM_PATH_LEN];
+};
+
+typedef struct {
+    sd_stream_t *stream;
+    uint32_t index;
+} stream_job_t;
+
+static QueueHandle_t job_queue = NULL;
+static TaskHandle_t helper_task = NULL;
+
+// Card transfers go in scheduler-sized chunks, so a listing can get in between
+static esp_err_t fill_buffer(sd_stream_t *s, stream_buffer_t *b) {
+    size_t total = 0;
+    while (total < s->buffer_size) {
+        size_t step = s->buffer_size - total < SD_IO_BULK_CHUNK_SIZE ? s->buffer_size - total
+                                                                     : SD_IO_BULK_CHUNK_SIZE;
+        sd_io_begin(s->io_class);
+        ssize_t got = read(s->fd, b->data + total, step);
+        sd_io_end(s->io_class);
+        if (got < 0) {
+            b->len = total;
+            return ESP_FAIL;
+        }
+        if (got == 0) {
+            break;
+        }
+        total += got;
+    }
+    b->len = total;
+    return ESP_OK;
+}
+
+static esp_err_t drain_buffer(sd_stream_t *s, const stream_buffer_t *b) {
+    size_t done = 0;
+    while (done < b->len) {
+        size_t step = b->len - done < SD_IO_BULK_CHUNK_SIZE ? b->len - done : SD_IO_BULK_CHUNK_SIZE;
+        errno = 0;
+        sd_io_begin(s->io_class);
+        ssize_t n = write(s->fd, b->data + done, step);
+        sd_io_end(s->io_class);
+        if (n <= 0) {
+            // Nothing written at all means nothing fit
+            return (n == 0 || errno == ENOSPC) ? ESP_ERR_INVALID_SIZE : ESP_FAIL;
+        }
+        done += n;
+    }
+    return ESP_OK;
+}
+
+static void stream_helper_task(void *arg) {
+    (void)arg;
+    stream_job_t job;
+
+    for (;;) {
+        xQueueReceive(job_queue, &job, portMAX_DELAY);
+        sd_stream_t *s = job.stream;
+        stream_buffer_t *b = &s->buffers[job.index];
+        if (s->failed) {
+            // The file position is unknown after a failure, so nothing after it is trusted
+            b->len = 0;
+            b->err = ESP_FAIL;
+        } else if (s->mode == SD_STREAM_WRITE) {
+            b->err = drain_buffer(s, b);
+        } else if (s->closing) {
+            b->len = 0;
+            b->err = ESP_OK;
+        } else {
+            b->err = fill_buffer(s, b);
+        }
+        if (b->err != ESP_OK) {
+            s->failed = true;
+        }
+        xQueueSend(s->done_queue, &job.index, portMAX_DELAY);
+    }
+}
+
+static bool ensure_helper(void) {
+    if (!job_queue) {
+        job_queue = xQueueCreate(SD_STREAM_JOB_QUEUE_LEN, sizeof(stream_job_t));
+        if (!job_queue) {
+            ESP_LOGE(TAG, "Failed to create job queue");
+            return false;
+        }
+    }
+    if (helper_task) {
+        return true;
+    }
+    // Pinned to CPU1 like the other long-running workers, away from LVGL
+    BaseType_t result = xTaskCreatePinnedToCore(stream_helper_task, "sd_stream", SD_STREAM_TASK_STACK,
+                                                NULL, SD_STREAM_TASK_PRIORITY, &helper_task, 1);
+    if (result != pdPASS) {
+        ESP_LOGE(TAG, "Failed to create helper task");
+        helper_task = NULL;
+        return false;
+    }
+    return true;
+}
+
+static void submit(sd_stream_t *s, uint32_t index) {
+    stream_job_t job = { .stream = s, .index = index };
+    s->in_flight++;
+    xQueueSend(job_queue, &job, portMAX_DELAY);
+}
+
+static esp_err_t take_buffer(sd_stream_t *s, uint32_t *index) {
+    xQueueReceive(s->done_queue, index, portMAX_DELAY);
+    s->in_flight--;
+    return s->buffers[*index].err;
+}
+
+static void fail(sd_stream_t *s, esp_err_t err) {
+    if (s->error == ESP_OK) {
+        ESP_LOGE(TAG, "%s failed: %s", s->mode == SD_STREAM_WRITE ? "Write" : "Read", esp_err_to_name(err));
+        s->error = err;
+    }
+}
+
+static void free_stream(sd_stream_t *s) {
+    for (uint32_t i = 0; i < s->buffer_count; i++) {
+        heap_caps_free(s->buffers[i].data);
+    }
+    if (s->done_queue) {
+        vQueueDelete(s->done_queue);
+    }
+    free(s);
+}
+
+// Whole clusters, so read-ahead and write-behind never split one
+static size_t cluster_buffer_size(size_t wanted) {
+    sd_card_info_t info;
+    size_t cluster = SD_STREAM_FALLBACK_CLUSTER;
+    if (sd_manager_get_card_info(&info) == ESP_OK && info.cluster_size > 0) {
+        cluster = info.cluster_size;
+    }
+    if (wanted == 0) {
+        wanted = SD_STREAM_DEFAULT_BUFFER;
+    }
+    return (wanted + cluster - 1) / cluster * cluster;
+}
+
+static uint8_t *alloc_buffer(size_t size) {
+    // DMA-capable PSRAM lets the SDMMC driver transfer in place; plain PSRAM still works, bounced
+    uint8_t *data = heap_caps_aligned_alloc(SD_STREAM_ALIGN, size, MALLOC_CAP_SPIRAM | MALLOC_CAP_DMA);
+    if (!data) {
+        data = heap_caps_aligned_alloc(SD_STREAM_ALIGN, size, MALLOC_CAP_SPIRAM);
+    }
+    return data;
+}
+
+esp_err_t sd_stream_open(const char *path, sd_stream_mode_t mode, const sd_stream_config_t *config,
+                         sd_stream_t **stream_out) {
+    const sd_stream_config_t defaults = SD_STREAM_CONFIG_DEFAULT();
+    if (!config) {
+        config = &defaults;
+    }
+    if (!path || !stream_out || (mode != SD_STREAM_READ && mode != SD_STREAM_WRITE) ||
+        config->buffers < SD_STREAM_MIN_BUFFERS || config->buffers > SD_STREAM_MAX_BUFFERS ||
+        config->io_class >= SD_IO_CLASS_COUNT) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (!sd_manager_is_mounted()) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (!ensure_helper()) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    sd_stream_t *s = calloc(1, sizeof(sd_stream_t));
+    if (!s) {
+        return ESP_ERR_NO_MEM;
+    }
+    s->fd = -1;
+    s->mode = mode;
+    s->io_class = config->io_class;
+    s->held = NO_BUFFER;
+    s->buffer_size = cluster_buffer_size(config->buffer_size);
+    s->buffer_count = config->buffers;
+    s->done_queue = xQueueCreate(s->buffer_count, sizeof(uint32_t));
+    bool allocated = s->done_queue != NULL;
+    for (uint32_t i = 0; i < s->buffer_count && allocated; i++) {
+        s->buffers[i].data = alloc_buffer(s->buffer_size);
+        allocated = s->buffers[i].data != NULL;
+    }
+    if (!allocated) {
+        ESP_LOGE(TAG, "Out of memory for %" PRIu32 " x %u byte buffers", s->buffer_count,
+                 (unsigned)s->buffer_size);
+        free_stream(s);
+        return ESP_ERR_NO_MEM;
+    }
+
+    char full_path[SD_STREAM_PATH_LEN + 16];
+    snprintf(full_path, sizeof(full_path), "%s%s", SD_MOUNT_POINT, path);
+    if (mode == SD_STREAM_WRITE) {
+        struct stat st;
+        s->old_size = stat(full_path, &st) == 0 ? (uint64_t)st.st_size : 0;
+        // Writing creates the file or changes its size, so the cached listing is stale;
+        // sd_stream_close() invalidates again once the data is on the card
+        snprintf(s->path, sizeof(s->path), "%s", path);
+        listing_cache_invalidate_parent(path);
+        file_index_note_change(path);
+        s->fd = open(full_path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    } else {
+        s->fd = open(full_path, O_RDONLY);
+        if (s->fd >= 0 && config->offset > 0 && lseek(s->fd, (off_t)config->offset, SEEK_SET) < 0) {
+            close(s->fd);
+            s->fd = -1;
+        }
+    }
+    if (s->fd < 0) {
+        ESP_LOGE(TAG, "Failed to open %s", full_path);
+        free_stream(s);
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    for (uint32_t i = 0; i < s->buffer_count; i++) {
+        if (mode == SD_STREAM_READ) {
+            submit(s, i);
+        } else {
+            // Empty buffers wait on done_queue for the first writes
+            s->in_flight++;
+            xQueueSend(s->done_queue, &i, 0);
+        }
+    }
+    *stream_out = s;
+    return ESP_OK;
+}
+
+static void recycle_held(sd_stream_t *s) {
+    uint32_t index = s->held;
+    s->held = NO_BUFFER;
+    if (!s->eof) {
+        submit(s, index);
+    }
+}
+
+// Leave the next unread data in the held buffer; nothing held means end of file
+static esp_err_t next_filled(sd_stream_t *s) {
+    if (s->error != ESP_OK) {
+        return s->error;
+    }
+    if (s->held != NO_BUFFER) {
+        if (s->held_pos < s->buffers[s->held].len) {
+            return ESP_OK;
+        }
+        recycle_held(s);
+    }
+    if (s->in_flight == 0) {
+        return ESP_OK;
+    }
+
+    uint32_t index;
+    esp_err_t err = take_buffer(s, &index);
+    if (err != ESP_OK) {
+        fail(s, err);
+        return err;
+    }
+    const stream_buffer_t *b = &s->buffers[index];
+    if (b->len < s->buffer_size) {
+        s->eof = true;
+    }
+    if (b->len > 0) {
+        s->held = index;
+        s->held_pos = 0;
+    }
+    return ESP_OK;
+}
+
+esp_err_t sd_stream_borrow(sd_stream_t *stream, const uint8_t **data, size_t *len) {
+    if (stream->mode != SD_STREAM_READ || stream->borrowed) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    *data = NULL;
+    *len = 0;
+    esp_err_t ret = next_filled(stream);
+    if (ret != ESP_OK || stream->held == NO_BUFFER) {
+        return ret;
+    }
+    const stream_buffer_t *b = &stream->buffers[stream->held];
+    *data = b->data + stream->held_pos;
+    *len = b->len - stream->held_pos;
+    stream->borrowed = true;
+    return ESP_OK;
+}
+
+esp_err_t sd_stream_release(sd_stream_t *stream) {
+    if (!stream->borrowed) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    stream->borrowed = false;
+    recycle_held(stream);
+    return ESP_OK;
+}
+
+esp_err_t sd_stream_read(sd_stream_t *stream, void *data, size_t len, size_t *got) {
+    *got = 0;
+    if (stream->mode != SD_STREAM_READ || stream->borrowed) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    uint8_t *out = data;
+    while (*got < len) {
+        esp_err_t ret = next_filled(stream);
+        if (ret != ESP_OK) {
+            return ret;
+        }
+        if (stream->held == NO_BUFFER) {
+            break;
+        }
+        const stream_buffer_t *b = &stream->buffers[stream->held];
+        size_t n = b->len - stream->held_pos;
+        if (n > len - *got) {
+            n = len - *got;
+        }
+        memcpy(out + *got, b->data + stream->held_pos, n);
+        stream->held_pos += n;
+        *got += n;
+    }
+    return ESP_OK;
+}
+
+static void write_held(sd_stream_t *s) {
+    s->buffers[s->held].len = s->held_pos;
+    s->written += s->held_pos;
+    submit(s, s->held);
+    s->held = NO_BUFFER;
+}
+
+esp_err_t sd_stream_write(sd_stream_t *stream, const void *data, size_t len) {
+    if (stream->mode != SD_STREAM_WRITE) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    const uint8_t *in = data;
+    while (len > 0) {
+        if (stream->error != ESP_OK) {
+            return stream->error;
+        }
+        if (stream->held == NO_BUFFER) {
+            // Waits only when every buffer is still on its way to the card
+            uint32_t index;
+            esp_err_t err = take_buffer(stream, &index);
+            if (err != ESP_OK) {
+                fail(stream, err);
+                return err;
+            }
+            stream->held = index;
+            stream->held_pos = 0;
+        }
+        stream_buffer_t *b = &stream->buffers[stream->held];
+        size_t n = stream->buffer_size - stream->held_pos;
+        if (n > len) {
+            n = len;
+        }
+        memcpy(b->data + stream->held_pos, in, n);
+        stream->held_pos += n;
+        in += n;
+        len -= n;
+        if (stream->held_pos == stream->buffer_size) {
+            write_held(stream);
+        }
+    }
+    return stream->error;
+}
+
+esp_err_t sd_stream_close(sd_stream_t *stream) {
+    if (!stream) {
+        return ESP_OK;
+    }
+    bool writing = stream->mode == SD_STREAM_WRITE;
+    if (writing && stream->held != NO_BUFFER && stream->held_pos > 0 && stream->error == ESP_OK) {
+        write_held(stream);
+    }
+
+    // Read-ahead nobody will consume is skipped; buffered writes still go out
+    stream->closing = true;
+    while (stream->in_flight > 0) {
+        uint32_t index;
+        esp_err_t err = take_buffer(stream, &index);
+        if (err != ESP_OK && writing) {
+            fail(stream, err);
+        }
+    }
+    if (close(stream->fd) != 0 && writing) {
+        fail(stream, ESP_FAIL);
+    }
+    if (writing) {
+        sd_space_note_file(stream->old_size, stream->written);
+        // A scan during the write saw the file missing or short
+        listing_cache_invalidate_parent(stream->path);
+        file_index_note_change(stream->path);
+    }
+
+    esp_err_t ret = stream->error;
+    free_stream(stream);
+    return ret;
+}
@@ -0,0 +1,114 @@
+#ifndef SD_STREAM_H
+#define SD_STREAM_H
+
+#include "esp_err.h"
+#include "sd_io.h"
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Sequential file streams for large transfers. Each stream owns a ring of
+ * PSRAM buffers sized in whole clusters, so every card transfer covers
+ * complete clusters and FatFs moves them as multi-block reads and writes.
+ *
+ * Read streams keep every buffer not held by the caller filling ahead on
+ * a shared CPU1 helper task. Write streams hand full buffers to the same
+ * task and carry on filling the next one. sd_stream_borrow() gives the
+ * caller the next filled buffer in place, without a copy.
+ *
+ * A stream is used by one task at a time.
+ */
+
+typedef enum {
+    SD_STREAM_READ = 0,
+    SD_STREAM_WRITE,        // Creates the file or truncates an existing one
+} sd_stream_mode_t;
+
+typedef struct {
+    size_t buffer_size;     // Bytes per buffer, rounded up to whole clusters; 0 for 64 KB
+    uint32_t buffers;       // Buffers in the ring, 2 to 4
+    sd_io_class_t io_class; // Scheduler class of the helper's card transfers
+    uint64_t offset;        // Read streams: start this far into the file
+} sd_stream_config_t;
+
+#define SD_STREAM_CONFIG_DEFAULT() {    \
+    .buffer_size = 0,                   \
+    .buffers = 2,                       \
+    .io_class = SD_IO_BULK,             \
+    .offset = 0                         \
+}
+
+typedef struct sd_stream sd_stream_t;
+
+/**
+ * @brief Open a file on the card as a stream
+ *
+ * Read streams start reading ahead before this returns.
+ *
+ * @param path File path (relative to SD root)
+ * @param mode SD_STREAM_READ or SD_STREAM_WRITE
+ * @param config Buffering, or NULL for SD_STREAM_CONFIG_DEFAULT()
+ * @param stream_out Output stream handle
+ * @return ESP_OK on success, ESP_ERR_INVALID_STATE if no card is mounted,
+ *         ESP_ERR_NOT_FOUND if the file cannot be opened, ESP_ERR_NO_MEM
+ */
+esp_err_t sd_stream_open(const char *path, sd_stream_mode_t mode, const sd_stream_config_t *config,
+                         sd_stream_t **stream_out);
+
+/**
+ * @brief Borrow the next filled buffer of a read stream
+ *
+ * Waits for read-ahead if it has not caught up. The data stays valid until
+ * sd_stream_release(). At the end of the file len is 0.
+ *
+ * @param stream Read stream
+ * @param data Output pointer to the data
+ * @param len Output number of bytes
+ * @return ESP_OK on success, ESP_ERR_INVALID_STATE if a buffer is already
+ *         borrowed, ESP_FAIL on a read error
+ */
+esp_err_t sd_stream_borrow(sd_stream_t *stream, const uint8_t **data, size_t *len);
+
+/**
+ * @brief Give a borrowed buffer back so it can be filled again
+ * @param stream Read stream
+ * @return ESP_OK on success, ESP_ERR_INVALID_STATE if nothing is borrowed
+ */
+esp_err_t sd_stream_release(sd_stream_t *stream);
+
+/**
+ * @brief Copy data out of a read stream
+ * @param stream Read stream
+ * @param data Output buffer
+ * @param len Bytes wanted
+ * @param got Output bytes copied, less than len only at the end of the file
+ * @return ESP_OK on success, ESP_ERR_INVALID_STATE while a buffer is
+ *         borrowed, ESP_FAIL on a read error
+ */
+esp_err_t sd_stream_read(sd_stream_t *stream, void *data, size_t len, size_t *got);
+
+/**
+ * @brief Append data to a write stream
+ *
+ * Returns once the data is buffered; an error writing an earlier buffer is
+ * reported by the next call.
+ *
+ * @param stream Write stream
+ * @param data Data to append
+ * @param len Number of bytes
+ * @return ESP_OK on success, ESP_ERR_INVALID_SIZE if the card is full,
+ *         ESP_FAIL on a write error
+ */
+esp_err_t sd_stream_write(sd_stream_t *stream, const void *data, size_t len);
+
+/**
+ * @brief Close a stream and free its buffers
+ *
+ * Write streams wait for buffered data to reach the card first.
+ *
+ * @param stream Stream to close (can be NULL)
+ * @return ESP_OK on success, or the first error the stream ran into
+ */
+esp_err_t sd_stream_close(sd_stream_t *stream);
+
+#endif // SD_STREAM_H
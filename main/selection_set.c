@@ -0,0 +1,139 @@
+#include "selection_set.h"
+#include <stdlib.h>
+#include <string.h>
+
+// Bits past 'size' in the last word are always kept clear, so whole-word
+// popcounts never see stray bits
+#define WORDS_FOR(n) (((n) + 31) >> 5)
+
+static inline uint32_t tail_mask(uint32_t size) {
+    return (size & 31) ? (1u << (size & 31)) - 1 : UINT32_MAX;
+}
+
+esp_err_t selection_set_resize(selection_set_t *set, uint32_t size) {
+    uint32_t words = WORDS_FOR(size);
+    if (words > set->word_capacity) {
+        uint32_t new_capacity = set->word_capacity ? set->word_capacity : 8;
+        while (new_capacity < words) {
+            new_capacity *= 2;
+        }
+        uint32_t *grown = realloc(set->words, new_capacity * sizeof(uint32_t));
+        if (!grown) {
+            return ESP_ERR_NO_MEM;
+        }
+        memset(grown + set->word_capacity, 0, (new_capacity - set->word_capacity) * sizeof(uint32_t));
+        set->words = grown;
+        set->word_capacity = new_capacity;
+    }
+
+    if (size < set->size) {
+        // Drop the bits that are no longer covered
+        uint32_t old_words = WORDS_FOR(set->size);
+        for (uint32_t w = words; w < old_words; w++) {
+            set->count -= __builtin_popcount(set->words[w]);
+            set->words[w] = 0;
+        }
+        if (words > 0) {
+            uint32_t kept = set->words[words - 1] & tail_mask(size);
+            set->count -= __builtin_popcount(set->words[words - 1] ^ kept);
+            set->words[words - 1] = kept;
+        }
+    }
+    set->size = size;
+    return ESP_OK;
+}
+
+void selection_set_set(selection_set_t *set, uint32_t index, bool selected) {
+    if (index >= set->size) {
+        return;
+    }
+    uint32_t *word = &set->words[index >> 5];
+    uint32_t bit = 1u << (index & 31);
+    if (selected && !(*word & bit)) {
+        *word |= bit;
+        set->count++;
+    } else if (!selected && (*word & bit)) {
+        *word &= ~bit;
+        set->count--;
+    }
+}
+
+void selection_set_set_range(selection_set_t *set, uint32_t first, uint32_t last, bool selected) {
+    if (first > last) {
+        uint32_t swap = first;
+        first = last;
+        last = swap;
+    }
+    if (first >= set->size) {
+        return;
+    }
+    if (last >= set->size) {
+        last = set->size - 1;
+    }
+
+    uint32_t first_word = first >> 5;
+    uint32_t last_word = last >> 5;
+    for (uint32_t w = first_word; w <= last_word; w++) {
+        uint32_t mask = UINT32_MAX;
+        if (w == first_word) {
+            mask &= UINT32_MAX << (first & 31);
+        }
+        if (w == last_word) {
+            mask &= UINT32_MAX >> (31 - (last & 31));
+        }
+        uint32_t before = set->words[w];
+        uint32_t after = selected ? (before | mask) : (before & ~mask);
+        set->count += __builtin_popcount(after) - __builtin_popcount(before);
+        set->words[w] = after;
+    }
+}
+
+void selection_set_select_all(selection_set_t *set) {
+    if (set->size == 0) {
+        return;
+    }
+    uint32_t words = WORDS_FOR(set->size);
+    memset(set->words, 0xFF, words * sizeof(uint32_t));
+    set->words[words - 1] = tail_mask(set->size);
+    set->count = set->size;
+}
+
+void selection_set_clear(selection_set_t *set) {
+    if (set->words) {
+        memset(set->words, 0, WORDS_FOR(set->size) * sizeof(uint32_t));
+    }
+    set->count = 0;
+}
+
+void selection_set_invert(selection_set_t *set) {
+    if (set->size == 0) {
+        return;
+    }
+    uint32_t words = WORDS_FOR(set->size);
+    for (uint32_t w = 0; w < words; w++) {
+        set->words[w] = ~set->words[w];
+    }
+    set->words[words - 1] &= tail_mask(set->size);
+    set->count = set->size - set->count;
+}
+
+uint32_t selection_set_next(const selection_set_t *set, uint32_t from) {
+    if (from >= set->size) {
+        return UINT32_MAX;
+    }
+    uint32_t words = WORDS_FOR(set->size);
+    uint32_t w = from >> 5;
+    uint32_t bits = set->words[w] & (UINT32_MAX << (from & 31));
+    while (!bits) {
+        if (++w >= words) {
+            return UINT32_MAX;
+        }
+        bits = set->words[w];
+    }
+    return (w << 5) + __builtin_ctz(bits);
+}
+
+void selection_set_free(selection_set_t *set) {
+    free(set->words);
+    memset(set, 0, sizeof(*set));
+}
@@ -0,0 +1,86 @@
+#ifndef SELECTION_SET_H
+#define SELECTION_SET_H
+
+#include "esp_err.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+/*
+ * Selection over a listing, one bit per entry. Bulk operations work a
+ * 32-bit word at a time and the selected count is kept up to date, so
+ * selecting, inverting or counting thousands of entries costs a few hundred
+ * word operations and 1 bit of memory per entry.
+ */
+typedef struct {
+    uint32_t *words;
+    uint32_t size;          // Entries covered
+    uint32_t word_capacity;
+    uint32_t count;         // Selected entries
+} selection_set_t;
+
+/**
+ * @brief Cover size entries, keeping the bits of entries that remain covered
+ * @param set Selection set
+ * @param size New number of entries
+ * @return ESP_OK on success, ESP_ERR_NO_MEM on allocation failure (set unchanged)
+ */
+esp_err_t selection_set_resize(selection_set_t *set, uint32_t size);
+
+/**
+ * @brief Select or deselect one entry (ignored past the end)
+ * @param set Selection set
+ * @param index Entry index
+ * @param selected New state
+ */
+void selection_set_set(selection_set_t *set, uint32_t index, bool selected);
+
+/**
+ * @brief Select or deselect entries first..last (inclusive, either order)
+ * @param set Selection set
+ * @param first One end of the range
+ * @param last Other end of the range
+ * @param selected New state
+ */
+void selection_set_set_range(selection_set_t *set, uint32_t first, uint32_t last, bool selected);
+
+/**
+ * @brief Select every entry
+ * @param set Selection set
+ */
+void selection_set_select_all(selection_set_t *set);
+
+/**
+ * @brief Deselect every entry
+ * @param set Selection set
+ */
+void selection_set_clear(selection_set_t *set);
+
+/**
+ * @brief Flip the state of every entry
+ * @param set Selection set
+ */
+void selection_set_invert(selection_set_t *set);
+
+/**
+ * @brief Find the next selected entry
+ * @param set Selection set
+ * @param from First index to look at
+ * @return Index of the next selected entry at or after from, UINT32_MAX if none
+ */
+uint32_t selection_set_next(const selection_set_t *set, uint32_t from);
+
+/**
+ * @brief Release the set's storage
+ * @param set Selection set (left empty and reusable)
+ */
+void selection_set_free(selection_set_t *set);
+
+static inline bool selection_set_test(const selection_set_t *set, uint32_t index) {
+    return index < set->size && (set->words[index >> 5] >> (index & 31)) & 1;
+}
+
+static inline uint32_t selection_set_count(const selection_set_t *set) {
+    return set->count;
+}
+
+#endif // SELECTION_SET_H
@@ -0,0 +1,576 @@
+#include "thumbnail.h"
+#include "thumbnail_decode.h"
+#include "listing_cache.h"
+#include "sd_manager.h"
+#include "sd_space.h"
+#include "sd_io.h"
+#include "esp_log.h"
+#include "esp_heap_caps.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <inttypes.h>
+#include <sys/stat.h>
+
+static const char *TAG = "THUMBNAIL";
+
+#define THUMBNAIL_TASK_STACK      8192
+#define THUMBNAIL_TASK_PRIORITY   2     // Below the directory scanner
+#define THUMBNAIL_PATH_LEN        256
+#define THUMBNAIL_QUEUE_LEN       64    // Pending requests; about a screenful of tiles and spares
+#define THUMBNAIL_DONE_LEN        16    // Results waiting for the UI
+#define THUMBNAIL_MEMORY_SLOTS    48    // Thumbnails kept in PSRAM (18 KB each)
+#define THUMBNAIL_STOP_TIMEOUT_MS 3000
+#define THUMBNAIL_CACHE_MAX_BYTES (32u * 1024 * 1024)  // About 1800 thumbnails
+#define THUMBNAIL_CACHE_KEEP_BYTES (THUMBNAIL_CACHE_MAX_BYTES / 4 * 3)
+
+#define THUMBNAIL_PIXELS (THUMBNAIL_SIZE * THUMBNAIL_SIZE)
+#define THUMBNAIL_MAGIC  0x31425454     // "TTB1"
+
+/*
+ * One worker serves requests in the order the grid binds its tiles, so the
+ * visible tiles come first; tiles that scroll away cancel theirs, which also
+ * abandons a decode in progress. Results land in a PSRAM LRU of pinned-able
+ * slots: a slot is pinned while it is being filled and until the UI has
+ * copied it, and only unpinned slots are ever evicted.
+ *
+ * Every generated thumbnail is also written under THUMBNAIL_CACHE_DIR as a
+ * raw RGB565 blob, named by a hash of the image path and checked against the
+ * path, size and mtime stored in its header. Images that cannot be decoded
+ * get an empty blob, so they are not retried on every visit. The directory
+ * is capped by thumbnail_prune_cache(), which drops the oldest blobs first.
+ */
+typedef struct {
+    uint32_t magic;
+    uint32_t size;
+    uint32_t mtime;
+    uint16_t width;
+    uint16_t height;
+    uint16_t path_len;
+    uint16_t reserved;
+} thumb_file_header_t;
+
+typedef struct {
+    uint32_t id;
+    uint32_t size;
+    uint32_t mtime;
+    char path[THUMBNAIL_PATH_LEN];
+} thumb_request_t;
+
+typedef struct {
+    bool valid;
+    uint8_t pins;
+    uint16_t width;
+    uint16_t height;
+    uint64_t path_hash;
+    uint32_t size;
+    uint32_t mtime;
+    uint32_t last_used;
+    uint16_t *pixels;
+} thumb_slot_t;
+
+typedef struct {
+    uint32_t id;
+    int slot;           // -1 for "no thumbnail"
+} thumb_done_t;
+
+// A blob found by thumbnail_prune_cache()
+typedef struct {
+    uint32_t mtime;
+    uint32_t size;
+    char name[24];      // 16 hex digits and ".565"
+} thumb_blob_t;
+
+typedef struct {
+    thumb_blob_t *blobs;
+    uint32_t count;
+    uint32_t capacity;
+    uint64_t total;
+    bool failed;
+} prune_ctx_t;
+
+static SemaphoreHandle_t thumb_lock = NULL;
+static TaskHandle_t thumb_task = NULL;
+
+// Protected by thumb_lock
+static thumb_request_t *pending = NULL;
+static uint32_t pending_count = 0;
+static uint32_t next_id = 0;
+static uint32_t active_id = 0;          // Request being worked on, 0 if idle
+static volatile bool active_cancelled = false;
+static thumb_slot_t slots[THUMBNAIL_MEMORY_SLOTS];
+static uint32_t use_clock = 0;
+static thumb_done_t done[THUMBNAIL_DONE_LEN];
+static uint32_t done_head = 0;
+static uint32_t done_count = 0;
+static int polled_slot = -1;            // Slot handed out by the last poll
+
+static uint64_t hash_path(const char *path) {
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    for (const char *p = path; *p; p++) {
+        hash ^= (uint8_t)*p;
+        hash *= 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+static void cache_file_path(uint64_t path_hash, char *out, size_t out_size) {
+    snprintf(out, out_size, "%s%s/%016" PRIx64 ".565", SD_MOUNT_POINT, THUMBNAIL_CACHE_DIR, path_hash);
+}
+
+// Polled between decoder input reads, which is also where a listing can cut in
+static bool worker_abort_cb(void) {
+    sd_io_yield(SD_IO_BACKGROUND);
+    return active_cancelled;
+}
+
+static void unpin(int slot) {
+    if (slot >= 0 && slots[slot].pins > 0) {
+        slots[slot].pins--;
+    }
+}
+
+// Caller holds thumb_lock
+static int find_slot(uint64_t path_hash, uint32_t size, uint32_t mtime) {
+    for (int i = 0; i < THUMBNAIL_MEMORY_SLOTS; i++) {
+        if (slots[i].valid && slots[i].path_hash == path_hash && slots[i].size == size &&
+            slots[i].mtime == mtime) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+// Least recently used unpinned slot, pinned and emptied for refilling; caller holds thumb_lock
+static int claim_slot(void) {
+    int victim = -1;
+    for (int i = 0; i < THUMBNAIL_MEMORY_SLOTS; i++) {
+        if (slots[i].pins == 0 && (victim < 0 || !slots[i].valid ||
+                                   (slots[victim].valid && slots[i].last_used < slots[victim].last_used))) {
+            victim = i;
+        }
+    }
+    if (victim < 0) {
+        return -1;
+    }
+    if (!slots[victim].pixels) {
+        slots[victim].pixels = heap_caps_malloc(THUMBNAIL_PIXELS * sizeof(uint16_t), MALLOC_CAP_SPIRAM);
+        if (!slots[victim].pixels) {
+            return -1;
+        }
+    }
+    slots[victim].valid = false;
+    slots[victim].pins = 1;
+    return victim;
+}
+
+// Queue a result for the UI; the slot (if any) stays pinned until polled. Caller holds thumb_lock
+static void deliver(uint32_t id, int slot) {
+    if (done_count == THUMBNAIL_DONE_LEN) {
+        // The UI is not keeping up; the oldest result is the least likely to still be wanted
+        unpin(done[done_head].slot);
+        done_head = (done_head + 1) % THUMBNAIL_DONE_LEN;
+        done_count--;
+    }
+    done[(done_head + done_count) % THUMBNAIL_DONE_LEN] = (thumb_done_t){ .id = id, .slot = slot };
+    done_count++;
+}
+
+static bool load_cached(const thumb_request_t *req, uint64_t path_hash, thumb_slot_t *slot) {
+    char file_path[THUMBNAIL_PATH_LEN + 64];
+    cache_file_path(path_hash, file_path, sizeof(file_path));
+    FILE *f = fopen(file_path, "rb");
+    if (!f) {
+        return false;
+    }
+
+    thumb_file_header_t header;
+    char stored_path[THUMBNAIL_PATH_LEN];
+    size_t path_len = strlen(req->path);
+    bool ok = fread(&header, sizeof(header), 1, f) == 1 &&
+              header.magic == THUMBNAIL_MAGIC && header.size == req->size && header.mtime == req->mtime &&
+              header.path_len == path_len && header.width <= THUMBNAIL_SIZE && header.height <= THUMBNAIL_SIZE &&
+              fread(stored_path, 1, path_len, f) == path_len && memcmp(stored_path, req->path, path_len) == 0;
+    if (ok) {
+        size_t pixels = (size_t)header.width * header.height;
+        ok = fread(slot->pixels, sizeof(uint16_t), pixels, f) == pixels;
+        slot->width = header.width;
+        slot->height = header.height;
+    }
+    fclose(f);
+    return ok;
+}
+
+static void store_cached(const thumb_request_t *req, uint64_t path_hash, const thumb_slot_t *slot) {
+    char file_path[THUMBNAIL_PATH_LEN + 64];
+    snprintf(file_path, sizeof(file_path), "%s%s", SD_MOUNT_POINT, THUMBNAIL_CACHE_DIR);
+    if (mkdir(file_path, 0755) == 0) {
+        sd_space_note_dir(true);
+        listing_cache_invalidate_parent(THUMBNAIL_CACHE_DIR);
+    } else if (errno != EEXIST) {
+        ESP_LOGW(TAG, "Cannot create %s (errno %d)", file_path, errno);
+        return;
+    }
+
+    cache_file_path(path_hash, file_path, sizeof(file_path));
+    FILE *f = fopen(file_path, "wb");
+    if (!f) {
+        return;
+    }
+    thumb_file_header_t header = {
+        .magic = THUMBNAIL_MAGIC,
+        .size = req->size,
+        .mtime = req->mtime,
+        .width = slot->width,
+        .height = slot->height,
+        .path_len = (uint16_t)strlen(req->path),
+    };
+    size_t pixels = (size_t)slot->width * slot->height;
+    bool ok = fwrite(&header, sizeof(header), 1, f) == 1 &&
+              fwrite(req->path, 1, header.path_len, f) == header.path_len &&
+              fwrite(slot->pixels, sizeof(uint16_t), pixels, f) == pixels;
+    fclose(f);
+    if (ok) {
+        sd_space_note_file(0, sizeof(header) + header.path_len + pixels * sizeof(uint16_t));
+    } else {
+        // A short blob would fail validation anyway; do not leave it behind
+        remove(file_path);
+    }
+}
+
+static void process_request(const thumb_request_t *req) {
+    uint64_t path_hash = hash_path(req->path);
+
+    xSemaphoreTake(thumb_lock, portMAX_DELAY);
+    int slot = find_slot(path_hash, req->size, req->mtime);
+    if (slot >= 0) {
+        // Made by an earlier request for the same file
+        slots[slot].last_used = ++use_clock;
+        slots[slot].pins++;
+        deliver(req->id, slot);
+        xSemaphoreGive(thumb_lock);
+        return;
+    }
+    slot = claim_slot();
+    xSemaphoreGive(thumb_lock);
+    if (slot < 0) {
+        ESP_LOGW(TAG, "No thumbnail slot free");
+        xSemaphoreTake(thumb_lock, portMAX_DELAY);
+        deliver(req->id, -1);
+        xSemaphoreGive(thumb_lock);
+        return;
+    }
+
+    // The slot is pinned, so it is safe to fill without the lock
+    thumb_slot_t *s = &slots[slot];
+    esp_err_t ret = ESP_OK;
+    sd_io_begin(SD_IO_BACKGROUND);
+    bool from_card = load_cached(req, path_hash, s);
+    if (!from_card) {
+        char full_path[THUMBNAIL_PATH_LEN + 16];
+        snprintf(full_path, sizeof(full_path), "%s%s", SD_MOUNT_POINT, req->path);
+        uint32_t start = esp_log_timestamp();
+        ret = thumbnail_decode(full_path, thumbnail_decode_format(req->path), THUMBNAIL_SIZE,
+                               s->pixels, &s->width, &s->height, worker_abort_cb);
+        if (ret == ESP_OK) {
+            ESP_LOGD(TAG, "Decoded %s to %ux%u in %" PRIu32 " ms", req->path, s->width, s->height,
+                     esp_log_timestamp() - start);
+        } else {
+            s->width = 0;
+            s->height = 0;
+        }
+        // Remember undecodable images too, but not transient failures
+        if (ret == ESP_OK || ret == ESP_FAIL || ret == ESP_ERR_NOT_SUPPORTED) {
+            store_cached(req, path_hash, s);
+        }
+    }
+    sd_io_end(SD_IO_BACKGROUND);
+
+    xSemaphoreTake(thumb_lock, portMAX_DELAY);
+    bool cancelled = active_cancelled;
+    if (ret != ESP_ERR_INVALID_STATE && ret != ESP_ERR_NO_MEM) {
+        s->valid = true;
+        s->path_hash = path_hash;
+        s->size = req->size;
+        s->mtime = req->mtime;
+        s->last_used = ++use_clock;
+    }
+    if (cancelled) {
+        unpin(slot);
+    } else if (s->valid && s->width > 0) {
+        deliver(req->id, slot);
+    } else {
+        unpin(slot);
+        deliver(req->id, -1);
+    }
+    xSemaphoreGive(thumb_lock);
+}
+
+static void thumbnail_task(void *arg) {
+    (void)arg;
+    thumb_request_t req;
+
+    for (;;) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+        for (;;) {
+            xSemaphoreTake(thumb_lock, portMAX_DELAY);
+            if (pending_count == 0 || !sd_manager_is_mounted()) {
+                pending_count = 0;
+                active_id = 0;
+                xSemaphoreGive(thumb_lock);
+                break;
+            }
+            req = pending[0];
+            memmove(&pending[0], &pending[1], (pending_count - 1) * sizeof(pending[0]));
+            pending_count--;
+            active_id = req.id;
+            active_cancelled = false;
+            xSemaphoreGive(thumb_lock);
+
+            process_request(&req);
+        }
+    }
+}
+
+static bool ensure_worker(void) {
+    if (thumb_task) {
+        return true;
+    }
+
+    if (!thumb_lock) {
+        thumb_lock = xSemaphoreCreateMutex();
+        if (!thumb_lock) {
+            ESP_LOGE(TAG, "Failed to create thumbnail lock");
+            return false;
+        }
+    }
+    if (!pending) {
+        pending = heap_caps_malloc(THUMBNAIL_QUEUE_LEN * sizeof(thumb_request_t), MALLOC_CAP_SPIRAM);
+        if (!pending) {
+            ESP_LOGE(TAG, "Failed to allocate request queue");
+            return false;
+        }
+    }
+
+    // Pinned to CPU1 like the other long-running workers, away from LVGL
+    BaseType_t result = xTaskCreatePinnedToCore(thumbnail_task, "thumbnail", THUMBNAIL_TASK_STACK,
+                                                NULL, THUMBNAIL_TASK_PRIORITY, &thumb_task, 1);
+    if (result != pdPASS) {
+        ESP_LOGE(TAG, "Failed to create thumbnail task");
+        thumb_task = NULL;
+        return false;
+    }
+    return true;
+}
+
+bool thumbnail_is_supported(const char *name) {
+    return thumbnail_decode_format(name) != THUMBNAIL_FORMAT_NONE;
+}
+
+uint32_t thumbnail_request(const char *path, uint32_t size, uint32_t mtime) {
+    if (strlen(path) >= THUMBNAIL_PATH_LEN || !ensure_worker()) {
+        return 0;
+    }
+
+    xSemaphoreTake(thumb_lock, portMAX_DELAY);
+    uint32_t id = ++next_id;
+    if (id == 0) {
+        id = ++next_id; // 0 is reserved for "no request"
+    }
+
+    // Already in memory: no need to involve the worker
+    int slot = find_slot(hash_path(path), size, mtime);
+    if (slot >= 0) {
+        slots[slot].last_used = ++use_clock;
+        slots[slot].pins++;
+        deliver(id, slot);
+        xSemaphoreGive(thumb_lock);
+        return id;
+    }
+
+    if (pending_count == THUMBNAIL_QUEUE_LEN) {
+        // Oldest request first out; its tile is the most likely to be off screen by now
+        memmove(&pending[0], &pending[1], (pending_count - 1) * sizeof(pending[0]));
+        pending_count--;
+    }
+    thumb_request_t *req = &pending[pending_count++];
+    req->id = id;
+    req->size = size;
+    req->mtime = mtime;
+    strcpy(req->path, path);
+    xSemaphoreGive(thumb_lock);
+
+    xTaskNotifyGive(thumb_task);
+    return id;
+}
+
+void thumbnail_cancel(uint32_t request_id) {
+    if (!thumb_lock || request_id == 0) {
+        return;
+    }
+
+    xSemaphoreTake(thumb_lock, portMAX_DELAY);
+    if (active_id == request_id) {
+        active_cancelled = true;
+    }
+    for (uint32_t i = 0; i < pending_count; i++) {
+        if (pending[i].id == request_id) {
+            memmove(&pending[i], &pending[i + 1], (pending_count - i - 1) * sizeof(pending[0]));
+            pending_count--;
+            break;
+        }
+    }
+    xSemaphoreGive(thumb_lock);
+}
+
+void thumbnail_cancel_all(void) {
+    if (!thumb_lock) {
+        return;
+    }
+
+    xSemaphoreTake(thumb_lock, portMAX_DELAY);
+    pending_count = 0;
+    if (active_id != 0) {
+        active_cancelled = true;
+    }
+    while (done_count > 0) {
+        unpin(done[done_head].slot);
+        done_head = (done_head + 1) % THUMBNAIL_DONE_LEN;
+        done_count--;
+    }
+    unpin(polled_slot);
+    polled_slot = -1;
+    xSemaphoreGive(thumb_lock);
+}
+
+bool thumbnail_poll(thumbnail_t *thumb) {
+    if (!thumb_lock) {
+        return false;
+    }
+
+    xSemaphoreTake(thumb_lock, portMAX_DELAY);
+    unpin(polled_slot);
+    polled_slot = -1;
+
+    bool found = done_count > 0;
+    if (found) {
+        thumb_done_t result = done[done_head];
+        done_head = (done_head + 1) % THUMBNAIL_DONE_LEN;
+        done_count--;
+
+        thumb->request_id = result.id;
+        if (result.slot >= 0) {
+            thumb->width = slots[result.slot].width;
+            thumb->height = slots[result.slot].height;
+            thumb->pixels = slots[result.slot].pixels;
+            polled_slot = result.slot;
+        } else {
+            thumb->width = 0;
+            thumb->height = 0;
+            thumb->pixels = NULL;
+        }
+    }
+    xSemaphoreGive(thumb_lock);
+    return found;
+}
+
+static bool prune_entry_cb(const sd_dir_entry_t *entry, void *user_data) {
+    prune_ctx_t *ctx = (prune_ctx_t *)user_data;
+    sd_io_yield(SD_IO_BACKGROUND);
+    if (entry->is_directory || strlen(entry->name) >= sizeof(ctx->blobs[0].name)) {
+        return true;
+    }
+    if (ctx->count == ctx->capacity) {
+        uint32_t capacity = ctx->capacity ? ctx->capacity * 2 : 256;
+        thumb_blob_t *grown = heap_caps_realloc(ctx->blobs, capacity * sizeof(thumb_blob_t), MALLOC_CAP_SPIRAM);
+        if (!grown) {
+            ctx->failed = true;
+            return false;
+        }
+        ctx->blobs = grown;
+        ctx->capacity = capacity;
+    }
+    thumb_blob_t *blob = &ctx->blobs[ctx->count++];
+    blob->mtime = (uint32_t)entry->mtime;
+    blob->size = (uint32_t)entry->size;
+    strcpy(blob->name, entry->name);
+    ctx->total += entry->size;
+    return true;
+}
+
+static int compare_blob_age(const void *a, const void *b) {
+    uint32_t ma = ((const thumb_blob_t *)a)->mtime;
+    uint32_t mb = ((const thumb_blob_t *)b)->mtime;
+    return (ma > mb) - (ma < mb);
+}
+
+void thumbnail_prune_cache(void) {
+    prune_ctx_t ctx = { 0 };
+    sd_io_begin(SD_IO_BACKGROUND);
+    int result = sd_manager_enumerate(THUMBNAIL_CACHE_DIR, true, prune_entry_cb, &ctx);
+    if (result >= 0 && !ctx.failed && ctx.total > THUMBNAIL_CACHE_MAX_BYTES) {
+        // Blobs are written once, so the oldest are the least recently generated
+        qsort(ctx.blobs, ctx.count, sizeof(thumb_blob_t), compare_blob_age);
+        uint64_t total = ctx.total;
+        uint32_t removed = 0;
+        char file_path[THUMBNAIL_PATH_LEN + 64];
+        for (uint32_t i = 0; i < ctx.count && total > THUMBNAIL_CACHE_KEEP_BYTES; i++) {
+            sd_io_yield(SD_IO_BACKGROUND);
+            snprintf(file_path, sizeof(file_path), "%s%s/%s", SD_MOUNT_POINT, THUMBNAIL_CACHE_DIR,
+                     ctx.blobs[i].name);
+            if (remove(file_path) == 0) {
+                sd_space_note_file(ctx.blobs[i].size, 0);
+                total -= ctx.blobs[i].size;
+                removed++;
+            }
+        }
+        if (removed) {
+            listing_cache_invalidate_tree(THUMBNAIL_CACHE_DIR);
+        }
+        ESP_LOGI(TAG, "Pruned %" PRIu32 " cached thumbnails, %" PRIu64 " KB left",
+                 removed, total / 1024);
+    } else if (ctx.failed) {
+        ESP_LOGW(TAG, "Out of memory listing the thumbnail cache");
+    }
+    sd_io_end(SD_IO_BACKGROUND);
+    heap_caps_free(ctx.blobs);
+}
+
+void thumbnail_stop(void) {
+    if (!thumb_lock) {
+        return;
+    }
+
+    thumbnail_cancel_all();
+
+    // Wait for the worker to leave the card; cancellation stops a decode within a few rows
+    uint32_t waited = 0;
+    for (;;) {
+        xSemaphoreTake(thumb_lock, portMAX_DELAY);
+        bool busy = active_id != 0;
+        xSemaphoreGive(thumb_lock);
+        if (!busy) {
+            break;
+        }
+        if (waited >= THUMBNAIL_STOP_TIMEOUT_MS) {
+            ESP_LOGW(TAG, "Thumbnail worker did not stop in time");
+            break;
+        }
+        vTaskDelay(pdMS_TO_TICKS(10));
+        waited += 10;
+    }
+
+    // Another card may come next; keep the buffers, forget what was in them
+    xSemaphoreTake(thumb_lock, portMAX_DELAY);
+    for (int i = 0; i < THUMBNAIL_MEMORY_SLOTS; i++) {
+        if (slots[i].pins == 0) {
+            slots[i].valid = false;
+        }
+    }
+    xSemaphoreGive(thumb_lock);
+}
@@ -0,0 +1,83 @@
+#ifndef THUMBNAIL_H
+#define THUMBNAIL_H
+
+#include "esp_err.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+// Longest side of a thumbnail in pixels
+#define THUMBNAIL_SIZE 96
+
+// On-card cache of generated thumbnails (relative to SD root); hidden, never indexed
+#define THUMBNAIL_CACHE_DIR "/.thumbs"
+
+typedef struct {
+    uint32_t request_id;
+    uint16_t width;             // 0 if the file has no usable thumbnail
+    uint16_t height;
+    const uint16_t *pixels;     // RGB565, valid until the next thumbnail_poll()
+} thumbnail_t;
+
+/**
+ * @brief Check whether thumbnails can be made for a file
+ * @param name File name or path
+ * @return true for jpg/jpeg/png/bmp files
+ */
+bool thumbnail_is_supported(const char *name);
+
+/**
+ * @brief Ask for a file's thumbnail
+ *
+ * Requests are served in the order they are made, from memory, from the
+ * card's thumbnail cache, or by decoding the image on the background worker.
+ * Size and modification time are part of the cache key, so an edited image
+ * gets a fresh thumbnail.
+ *
+ * @param path File path (relative to SD root)
+ * @param size File size in bytes
+ * @param mtime Modification time
+ * @return Request id delivered by thumbnail_poll(), 0 if the worker is unavailable
+ */
+uint32_t thumbnail_request(const char *path, uint32_t size, uint32_t mtime);
+
+/**
+ * @brief Withdraw a request that is no longer needed (e.g. its tile scrolled away)
+ *
+ * A queued request is dropped; one being decoded is abandoned.
+ *
+ * @param request_id Id from thumbnail_request()
+ */
+void thumbnail_cancel(uint32_t request_id);
+
+/**
+ * @brief Withdraw every request and drop undelivered results
+ */
+void thumbnail_cancel_all(void);
+
+/**
+ * @brief Take the next finished thumbnail
+ *
+ * Call from the UI thread (e.g. an lv_timer) until it returns false.
+ *
+ * @param thumb Output; pixels stay valid until the next call
+ * @return true if a thumbnail was returned
+ */
+bool thumbnail_poll(thumbnail_t *thumb);
+
+/**
+ * @brief Trim the on-card thumbnail cache to its size cap
+ *
+ * Removes the oldest blobs until the cache is well under the cap. Blocks on
+ * card I/O; call from a background worker (the file index does, whenever it
+ * rescans the card root).
+ */
+void thumbnail_prune_cache(void);
+
+/**
+ * @brief Stop all thumbnail work and forget in-memory thumbnails
+ *
+ * Call before the card is unmounted. Blocks until the worker is off the card.
+ */
+void thumbnail_stop(void);
+
+#endif // THUMBNAIL_H
@@ -0,0 +1,689 @@
+#include "thumbnail_decode.h"
+#include "esp_log.h"
+#include "miniz.h"
+#include "lvgl.h"
+#include "src/libs/tjpgd/tjpgd.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+
+static const char *TAG = "THUMB_DECODE";
+
+// Images beyond this are not worth the decode time on the device
+#define MAX_SOURCE_DIMENSION 16384
+
+// TJpgDec work area; covers JD_FASTDECODE up to level 2
+#define JPEG_WORK_SIZE (10 * 1024)
+
+// Bytes read from the card per PNG inflate step
+#define PNG_INPUT_SIZE 4096
+
+// Transparent pixels are blended onto the grid tile color
+#define ALPHA_BACKGROUND 0x2a
+
+/*
+ * Every decoder streams source pixels into a box-filter scaler that sums
+ * them into their thumbnail pixel, so nothing larger than a source row (PNG,
+ * BMP) or an MCU (JPEG) exists at full resolution. JPEGs are first reduced up
+ * to 8x by TJpgDec's DCT scaling, and for large PNGs and BMPs only every
+ * step-th row and column is sampled (BMP rows that are not sampled are never
+ * read from the card).
+ */
+typedef struct {
+    uint32_t src_w;
+    uint32_t src_h;
+    uint16_t out_w;
+    uint16_t out_h;
+    uint32_t step;
+    uint16_t *x_map;    // Thumbnail column of each source column, UINT16_MAX if not sampled
+    uint32_t *sum;      // r, g, b per thumbnail pixel
+    uint16_t *count;
+} scaler_t;
+
+#define SCALER_SKIP UINT16_MAX
+
+static void scaler_free(scaler_t *scaler) {
+    free(scaler->x_map);
+    free(scaler->sum);
+    free(scaler->count);
+}
+
+static esp_err_t scaler_init(scaler_t *scaler, uint32_t src_w, uint32_t src_h, uint16_t max_size) {
+    memset(scaler, 0, sizeof(*scaler));
+    if (src_w == 0 || src_h == 0 || src_w > MAX_SOURCE_DIMENSION || src_h > MAX_SOURCE_DIMENSION) {
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+
+    // Fit inside max_size x max_size, never upscaling
+    uint32_t longest = src_w > src_h ? src_w : src_h;
+    uint32_t target = longest < max_size ? longest : max_size;
+    scaler->src_w = src_w;
+    scaler->src_h = src_h;
+    scaler->out_w = (uint16_t)((src_w * target + longest - 1) / longest);
+    scaler->out_h = (uint16_t)((src_h * target + longest - 1) / longest);
+
+    // About two samples per axis per thumbnail pixel are plenty for a box filter
+    uint32_t ratio = longest / target;
+    scaler->step = ratio >= 4 ? ratio / 2 : 1;
+
+    uint32_t out_pixels = (uint32_t)scaler->out_w * scaler->out_h;
+    scaler->x_map = malloc(src_w * sizeof(uint16_t));
+    scaler->sum = calloc(out_pixels * 3, sizeof(uint32_t));
+    scaler->count = calloc(out_pixels, sizeof(uint16_t));
+    if (!scaler->x_map || !scaler->sum || !scaler->count) {
+        scaler_free(scaler);
+        return ESP_ERR_NO_MEM;
+    }
+    for (uint32_t x = 0; x < src_w; x++) {
+        scaler->x_map[x] = (x % scaler->step) ? SCALER_SKIP : (uint16_t)(x * scaler->out_w / src_w);
+    }
+    return ESP_OK;
+}
+
+// Thumbnail row for source row y, -1 if the row is not sampled
+static inline int scaler_row(const scaler_t *scaler, uint32_t y) {
+    if (y >= scaler->src_h || (y % scaler->step)) {
+        return -1;
+    }
+    return (int)(y * scaler->out_h / scaler->src_h);
+}
+
+static inline void scaler_add(scaler_t *scaler, int out_y, uint32_t x, uint8_t r, uint8_t g, uint8_t b) {
+    if (x >= scaler->src_w || scaler->x_map[x] == SCALER_SKIP) {
+        return;
+    }
+    uint32_t i = (uint32_t)out_y * scaler->out_w + scaler->x_map[x];
+    scaler->sum[i * 3] += r;
+    scaler->sum[i * 3 + 1] += g;
+    scaler->sum[i * 3 + 2] += b;
+    scaler->count[i]++;
+}
+
+static void scaler_finish(const scaler_t *scaler, uint16_t *pixels) {
+    uint32_t out_pixels = (uint32_t)scaler->out_w * scaler->out_h;
+    for (uint32_t i = 0; i < out_pixels; i++) {
+        uint32_t n = scaler->count[i];
+        if (n == 0) {
+            // Only possible for images cut short; leave the gap dark
+            pixels[i] = 0;
+            continue;
+        }
+        uint32_t r = scaler->sum[i * 3] / n;
+        uint32_t g = scaler->sum[i * 3 + 1] / n;
+        uint32_t b = scaler->sum[i * 3 + 2] / n;
+        pixels[i] = (uint16_t)(((r & 0xF8) << 8) | ((g & 0xFC) << 3) | (b >> 3));
+    }
+}
+
+static inline uint8_t blend(uint8_t c, uint8_t a) {
+    return (uint8_t)((c * a + ALPHA_BACKGROUND * (255 - a)) / 255);
+}
+
+static inline uint32_t read_le32(const uint8_t *p) {
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static inline uint16_t read_le16(const uint8_t *p) {
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+static inline uint32_t read_be32(const uint8_t *p) {
+    return ((uint32_t)p[0] << 24) | (p[1] << 16) | (p[2] << 8) | p[3];
+}
+
+// ---------------------------------------------------------------------------
+// JPEG (TJpgDec, bundled with LVGL)
+
+typedef struct {
+    FILE *file;
+    scaler_t *scaler;
+    thumbnail_abort_cb_t abort_cb;
+    bool aborted;
+} jpeg_ctx_t;
+
+static size_t jpeg_input(JDEC *jd, uint8_t *buf, size_t len) {
+    jpeg_ctx_t *ctx = jd->device;
+    if (!buf) {
+        return fseek(ctx->file, (long)len, SEEK_CUR) == 0 ? len : 0;
+    }
+    return fread(buf, 1, len, ctx->file);
+}
+
+static int jpeg_output(JDEC *jd, void *bitmap, JRECT *rect) {
+    jpeg_ctx_t *ctx = jd->device;
+    if (ctx->abort_cb && ctx->abort_cb()) {
+        ctx->aborted = true;
+        return 0;
+    }
+
+    uint32_t rect_w = rect->right - rect->left + 1;
+    for (uint32_t y = rect->top; y <= rect->bottom; y++) {
+        int out_y = scaler_row(ctx->scaler, y);
+        if (out_y < 0) {
+            continue;
+        }
+        uint32_t row = (y - rect->top) * rect_w;
+        for (uint32_t x = rect->left; x <= rect->right; x++) {
+            uint32_t i = row + (x - rect->left);
+#if JD_FORMAT == 1
+            uint16_t c = ((const uint16_t *)bitmap)[i];
+            scaler_add(ctx->scaler, out_y, x, (c >> 8) & 0xF8, (c >> 3) & 0xFC, (c << 3) & 0xF8);
+#elif JD_FORMAT == 2
+            uint8_t l = ((const uint8_t *)bitmap)[i];
+            scaler_add(ctx->scaler, out_y, x, l, l, l);
+#else
+            const uint8_t *p = (const uint8_t *)bitmap + i * 3;
+            scaler_add(ctx->scaler, out_y, x, p[0], p[1], p[2]);
+#endif
+        }
+    }
+    return 1;
+}
+
+static esp_err_t decode_jpeg(FILE *file, uint16_t max_size, scaler_t *scaler,
+                             thumbnail_abort_cb_t abort_cb) {
+    void *work = malloc(JPEG_WORK_SIZE);
+    if (!work) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    jpeg_ctx_t ctx = { .file = file, .scaler = scaler, .abort_cb = abort_cb };
+    JDEC jd;
+    JRESULT res = jd_prepare(&jd, jpeg_input, work, JPEG_WORK_SIZE, &ctx);
+    if (res != JDR_OK) {
+        free(work);
+        // Progressive JPEGs are the common case here
+        return res == JDR_FMT3 ? ESP_ERR_NOT_SUPPORTED : ESP_FAIL;
+    }
+
+    // Largest DCT reduction that still leaves at least max_size pixels
+    uint8_t scale = 0;
+#if JD_USE_SCALE
+    uint32_t longest = jd.width > jd.height ? jd.width : jd.height;
+    while (scale < 3 && (longest >> (scale + 1)) >= max_size) {
+        scale++;
+    }
+#endif
+    uint32_t div = 1u << scale;
+    esp_err_t ret = scaler_init(scaler, (jd.width + div - 1) / div, (jd.height + div - 1) / div, max_size);
+    if (ret == ESP_OK) {
+        res = jd_decomp(&jd, jpeg_output, scale);
+        if (ctx.aborted) {
+            ret = ESP_ERR_INVALID_STATE;
+        } else if (res != JDR_OK) {
+            ret = ESP_FAIL;
+        }
+    }
+    free(work);
+    return ret;
+}
+
+// ---------------------------------------------------------------------------
+// PNG (streamed through the miniz inflater in ROM)
+
+#define PNG_CHUNK_IHDR 0x49484452
+#define PNG_CHUNK_PLTE 0x504C5445
+#define PNG_CHUNK_IDAT 0x49444154
+#define PNG_CHUNK_IEND 0x49454E44
+
+typedef struct {
+    uint32_t width;
+    uint32_t height;
+    uint8_t depth;
+    uint8_t color_type;
+    uint8_t channels;
+    uint32_t bpp;           // Filter distance in bytes
+    uint32_t row_bytes;     // Without the filter byte
+    uint8_t *row;           // Filter byte + row_bytes
+    uint8_t *prev;
+    uint32_t row_fill;
+    uint32_t y;
+    uint8_t palette[256][3];
+    scaler_t *scaler;
+} png_state_t;
+
+static esp_err_t png_setup(png_state_t *png, const uint8_t *ihdr) {
+    png->width = read_be32(ihdr);
+    png->height = read_be32(ihdr + 4);
+    png->depth = ihdr[8];
+    png->color_type = ihdr[9];
+    if (ihdr[10] != 0 || ihdr[11] != 0) {
+        return ESP_FAIL;
+    }
+    if (ihdr[12] != 0) {
+        // Adam7 rows do not arrive in order
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+
+    switch (png->color_type) {
+        case 0: png->channels = 1; break;   // Gray
+        case 2: png->channels = 3; break;   // RGB
+        case 3: png->channels = 1; break;   // Palette
+        case 4: png->channels = 2; break;   // Gray + alpha
+        case 6: png->channels = 4; break;   // RGBA
+        default: return ESP_FAIL;
+    }
+    bool packed = png->depth < 8;
+    if ((packed && png->color_type != 0 && png->color_type != 3) ||
+        (png->depth == 16 && png->color_type == 3) ||
+        (png->depth != 1 && png->depth != 2 && png->depth != 4 && png->depth != 8 && png->depth != 16)) {
+        return ESP_FAIL;
+    }
+
+    uint32_t bits_per_pixel = (uint32_t)png->channels * png->depth;
+    png->bpp = bits_per_pixel >= 8 ? bits_per_pixel / 8 : 1;
+    png->row_bytes = (png->width * bits_per_pixel + 7) / 8;
+    if (png->width > MAX_SOURCE_DIMENSION || png->height > MAX_SOURCE_DIMENSION) {
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+
+    png->row = malloc(png->row_bytes + 1);
+    png->prev = calloc(png->row_bytes + 1, 1);
+    return png->row && png->prev ? ESP_OK : ESP_ERR_NO_MEM;
+}
+
+static inline uint8_t paeth(uint8_t a, uint8_t b, uint8_t c) {
+    int p = a + b - c;
+    int pa = abs(p - a);
+    int pb = abs(p - b);
+    int pc = abs(p - c);
+    if (pa <= pb && pa <= pc) {
+        return a;
+    }
+    return pb <= pc ? b : c;
+}
+
+static bool png_unfilter(png_state_t *png) {
+    uint8_t *cur = png->row + 1;
+    const uint8_t *prev = png->prev + 1;
+    uint32_t n = png->row_bytes;
+    uint32_t bpp = png->bpp;
+
+    switch (png->row[0]) {
+        case 0:
+            break;
+        case 1:
+            for (uint32_t i = bpp; i < n; i++) {
+                cur[i] += cur[i - bpp];
+            }
+            break;
+        case 2:
+            for (uint32_t i = 0; i < n; i++) {
+                cur[i] += prev[i];
+            }
+            break;
+        case 3:
+            for (uint32_t i = 0; i < n; i++) {
+                cur[i] += ((i >= bpp ? cur[i - bpp] : 0) + prev[i]) >> 1;
+            }
+            break;
+        case 4:
+            for (uint32_t i = 0; i < n; i++) {
+                cur[i] += paeth(i >= bpp ? cur[i - bpp] : 0, prev[i], i >= bpp ? prev[i - bpp] : 0);
+            }
+            break;
+        default:
+            return false;
+    }
+    return true;
+}
+
+static void png_emit_row(png_state_t *png) {
+    int out_y = scaler_row(png->scaler, png->y);
+    if (out_y < 0) {
+        return;
+    }
+
+    const uint8_t *data = png->row + 1;
+    uint32_t sample_bytes = png->depth == 16 ? 2 : 1;
+    uint32_t pixel_bytes = png->channels * sample_bytes;
+    for (uint32_t x = 0; x < png->width; x++) {
+        if (png->scaler->x_map[x] == SCALER_SKIP) {
+            continue;
+        }
+
+        uint8_t r, g, b;
+        if (png->depth < 8) {
+            uint32_t bit = x * png->depth;
+            uint8_t mask = (uint8_t)((1 << png->depth) - 1);
+            uint8_t v = (data[bit >> 3] >> (8 - png->depth - (bit & 7))) & mask;
+            if (png->color_type == 3) {
+                r = png->palette[v][0];
+                g = png->palette[v][1];
+                b = png->palette[v][2];
+            } else {
+                r = g = b = (uint8_t)(v * 255 / mask);
+            }
+        } else {
+            // 16-bit samples keep their high byte
+            const uint8_t *p = data + x * pixel_bytes;
+            switch (png->color_type) {
+                case 0:
+                    r = g = b = p[0];
+                    break;
+                case 2:
+                    r = p[0];
+                    g = p[sample_bytes];
+                    b = p[2 * sample_bytes];
+                    break;
+                case 3:
+                    r = png->palette[p[0]][0];
+                    g = png->palette[p[0]][1];
+                    b = png->palette[p[0]][2];
+                    break;
+                case 4:
+                    r = g = b = blend(p[0], p[sample_bytes]);
+                    break;
+                default: {
+                    uint8_t a = p[3 * sample_bytes];
+                    r = blend(p[0], a);
+                    g = blend(p[sample_bytes], a);
+                    b = blend(p[2 * sample_bytes], a);
+                    break;
+                }
+            }
+        }
+        scaler_add(png->scaler, out_y, x, r, g, b);
+    }
+}
+
+// Feed inflated bytes into rows; false on a corrupt row
+static bool png_consume(png_state_t *png, const uint8_t *data, size_t len) {
+    while (len > 0 && png->y < png->height) {
+        uint32_t need = png->row_bytes + 1 - png->row_fill;
+        uint32_t take = len < need ? (uint32_t)len : need;
+        memcpy(png->row + png->row_fill, data, take);
+        png->row_fill += take;
+        data += take;
+        len -= take;
+
+        if (png->row_fill == png->row_bytes + 1) {
+            if (!png_unfilter(png)) {
+                return false;
+            }
+            png_emit_row(png);
+            uint8_t *swap = png->prev;
+            png->prev = png->row;
+            png->row = swap;
+            png->row_fill = 0;
+            png->y++;
+        }
+    }
+    return true;
+}
+
+static esp_err_t decode_png(FILE *file, uint16_t max_size, scaler_t *scaler,
+                            thumbnail_abort_cb_t abort_cb) {
+    static const uint8_t signature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+    uint8_t header[8];
+    if (fread(header, 1, 8, file) != 8 || memcmp(header, signature, 8) != 0) {
+        return ESP_FAIL;
+    }
+
+    png_state_t png = { .scaler = scaler };
+    tinfl_decompressor *inflator = malloc(sizeof(tinfl_decompressor));
+    uint8_t *dict = malloc(TINFL_LZ_DICT_SIZE);
+    uint8_t *input = malloc(PNG_INPUT_SIZE);
+    esp_err_t ret = (inflator && dict && input) ? ESP_OK : ESP_ERR_NO_MEM;
+    if (ret == ESP_OK) {
+        tinfl_init(inflator);
+    }
+
+    bool have_header = false;
+    bool inflate_done = false;
+    size_t dict_ofs = 0;
+    while (ret == ESP_OK && !inflate_done) {
+        if (fread(header, 1, 8, file) != 8) {
+            ret = ESP_FAIL;
+            break;
+        }
+        uint32_t length = read_be32(header);
+        uint32_t type = read_be32(header + 4);
+
+        if (!have_header) {
+            uint8_t ihdr[13];
+            if (type != PNG_CHUNK_IHDR || length != 13 || fread(ihdr, 1, 13, file) != 13) {
+                ret = ESP_FAIL;
+                break;
+            }
+            ret = png_setup(&png, ihdr);
+            if (ret == ESP_OK) {
+                ret = scaler_init(scaler, png.width, png.height, max_size);
+            }
+            have_header = true;
+            length = 0;
+        } else if (type == PNG_CHUNK_PLTE && length <= sizeof(png.palette) && length % 3 == 0) {
+            if (fread(png.palette, 1, length, file) != length) {
+                ret = ESP_FAIL;
+                break;
+            }
+            length = 0;
+        } else if (type == PNG_CHUNK_IDAT) {
+            while (length > 0 && ret == ESP_OK && !inflate_done) {
+                size_t got = fread(input, 1, length < PNG_INPUT_SIZE ? length : PNG_INPUT_SIZE, file);
+                if (got == 0) {
+                    ret = ESP_FAIL;
+                    break;
+                }
+                length -= got;
+
+                const uint8_t *next = input;
+                size_t avail = got;
+                for (;;) {
+                    size_t in_bytes = avail;
+                    size_t out_bytes = TINFL_LZ_DICT_SIZE - dict_ofs;
+                    tinfl_status status = tinfl_decompress(inflator, next, &in_bytes, dict, dict + dict_ofs,
+                                                           &out_bytes,
+                                                           TINFL_FLAG_PARSE_ZLIB_HEADER | TINFL_FLAG_HAS_MORE_INPUT);
+                    next += in_bytes;
+                    avail -= in_bytes;
+                    if (!png_consume(&png, dict + dict_ofs, out_bytes)) {
+                        ret = ESP_FAIL;
+                        break;
+                    }
+                    dict_ofs = (dict_ofs + out_bytes) & (TINFL_LZ_DICT_SIZE - 1);
+
+                    if (status < TINFL_STATUS_DONE) {
+                        ret = ESP_FAIL;
+                        break;
+                    }
+                    if (status == TINFL_STATUS_DONE || png.y >= png.height) {
+                        inflate_done = true;
+                        break;
+                    }
+                    if (status == TINFL_STATUS_NEEDS_MORE_INPUT && avail == 0) {
+                        break;
+                    }
+                }
+                if (abort_cb && abort_cb()) {
+                    ret = ESP_ERR_INVALID_STATE;
+                }
+            }
+        } else if (type == PNG_CHUNK_IEND) {
+            break;
+        }
+
+        // Skip whatever is left of the chunk, plus its CRC
+        if (ret == ESP_OK && !inflate_done && fseek(file, (long)length + 4, SEEK_CUR) != 0) {
+            ret = ESP_FAIL;
+        }
+    }
+
+    if (ret == ESP_OK && (!have_header || png.y < png.height)) {
+        ESP_LOGD(TAG, "PNG ended after %u of %u rows", (unsigned)png.y, (unsigned)png.height);
+        ret = ESP_FAIL;
+    }
+    free(png.row);
+    free(png.prev);
+    free(inflator);
+    free(dict);
+    free(input);
+    return ret;
+}
+
+// ---------------------------------------------------------------------------
+// BMP (uncompressed 8/16/24/32-bit)
+
+static esp_err_t decode_bmp(FILE *file, uint16_t max_size, scaler_t *scaler,
+                            thumbnail_abort_cb_t abort_cb) {
+    uint8_t header[66];
+    size_t got = fread(header, 1, sizeof(header), file);
+    if (got < 54 || header[0] != 'B' || header[1] != 'M') {
+        return ESP_FAIL;
+    }
+
+    uint32_t data_offset = read_le32(header + 10);
+    uint32_t dib_size = read_le32(header + 14);
+    int32_t width = (int32_t)read_le32(header + 18);
+    int32_t height = (int32_t)read_le32(header + 22);
+    uint16_t bits = read_le16(header + 28);
+    uint32_t compression = read_le32(header + 30);
+    uint32_t colors_used = read_le32(header + 46);
+    if (dib_size < 40 || width <= 0 || height == 0) {
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+    bool top_down = height < 0;
+    uint32_t w = (uint32_t)width;
+    uint32_t h = top_down ? (uint32_t)-height : (uint32_t)height;
+
+    // Bitfield masks follow a 40-byte header and are part of larger ones
+    bool bitfields = compression == 3;
+    bool rgb565 = false;
+    if (bitfields) {
+        if (got < 66) {
+            return ESP_FAIL;
+        }
+        uint32_t red_mask = read_le32(header + 54);
+        uint32_t green_mask = read_le32(header + 58);
+        if (bits == 16) {
+            rgb565 = green_mask == 0x07E0;
+        } else if (bits != 32 || red_mask != 0x00FF0000) {
+            return ESP_ERR_NOT_SUPPORTED;
+        }
+    } else if (compression != 0) {
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+    if (bits != 8 && bits != 16 && bits != 24 && bits != 32) {
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+
+    uint8_t palette[256][4];
+    if (bits == 8) {
+        uint32_t colors = (colors_used == 0 || colors_used > 256) ? 256 : colors_used;
+        memset(palette, 0, sizeof(palette));
+        if (fseek(file, 14 + (long)dib_size, SEEK_SET) != 0 ||
+            fread(palette, 4, colors, file) != colors) {
+            return ESP_FAIL;
+        }
+    }
+
+    esp_err_t ret = scaler_init(scaler, w, h, max_size);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    uint32_t stride = ((w * bits + 31) / 32) * 4;
+    uint8_t *row = malloc(stride);
+    if (!row) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    for (uint32_t y = 0; y < h && ret == ESP_OK; y++) {
+        int out_y = scaler_row(scaler, y);
+        if (out_y < 0) {
+            continue;
+        }
+        uint32_t file_row = top_down ? y : h - 1 - y;
+        if (fseek(file, (long)(data_offset + (uint64_t)file_row * stride), SEEK_SET) != 0 ||
+            fread(row, 1, stride, file) != stride) {
+            ret = ESP_FAIL;
+            break;
+        }
+
+        for (uint32_t x = 0; x < w; x++) {
+            if (scaler->x_map[x] == SCALER_SKIP) {
+                continue;
+            }
+            const uint8_t *p;
+            switch (bits) {
+                case 8:
+                    p = palette[row[x]];
+                    scaler_add(scaler, out_y, x, p[2], p[1], p[0]);
+                    break;
+                case 16: {
+                    uint16_t c = read_le16(row + x * 2);
+                    if (rgb565) {
+                        scaler_add(scaler, out_y, x, (c >> 8) & 0xF8, (c >> 3) & 0xFC, (c << 3) & 0xF8);
+                    } else {
+                        scaler_add(scaler, out_y, x, (c >> 7) & 0xF8, (c >> 2) & 0xF8, (c << 3) & 0xF8);
+                    }
+                    break;
+                }
+                default:
+                    p = row + x * (bits / 8);
+                    scaler_add(scaler, out_y, x, p[2], p[1], p[0]);
+                    break;
+            }
+        }
+        if (abort_cb && abort_cb()) {
+            ret = ESP_ERR_INVALID_STATE;
+        }
+    }
+    free(row);
+    return ret;
+}
+
+// ---------------------------------------------------------------------------
+
+thumbnail_format_t thumbnail_decode_format(const char *name) {
+    const char *ext = strrchr(name, '.');
+    if (!ext) {
+        return THUMBNAIL_FORMAT_NONE;
+    }
+    ext++;
+    if (strcasecmp(ext, "jpg") == 0 || strcasecmp(ext, "jpeg") == 0) {
+        return THUMBNAIL_FORMAT_JPEG;
+    } else if (strcasecmp(ext, "png") == 0) {
+        return THUMBNAIL_FORMAT_PNG;
+    } else if (strcasecmp(ext, "bmp") == 0) {
+        return THUMBNAIL_FORMAT_BMP;
+    }
+    return THUMBNAIL_FORMAT_NONE;
+}
+
+esp_err_t thumbnail_decode(const char *full_path, thumbnail_format_t format, uint16_t max_size,
+                           uint16_t *pixels, uint16_t *width, uint16_t *height,
+                           thumbnail_abort_cb_t abort_cb) {
+    FILE *file = fopen(full_path, "rb");
+    if (!file) {
+        return ESP_FAIL;
+    }
+
+    scaler_t scaler = {0};
+    esp_err_t ret;
+    switch (format) {
+        case THUMBNAIL_FORMAT_JPEG:
+            ret = decode_jpeg(file, max_size, &scaler, abort_cb);
+            break;
+        case THUMBNAIL_FORMAT_PNG:
+            ret = decode_png(file, max_size, &scaler, abort_cb);
+            break;
+        case THUMBNAIL_FORMAT_BMP:
+            ret = decode_bmp(file, max_size, &scaler, abort_cb);
+            break;
+        default:
+            ret = ESP_ERR_NOT_SUPPORTED;
+            break;
+    }
+    fclose(file);
+
+    if (ret == ESP_OK) {
+        scaler_finish(&scaler, pixels);
+        *width = scaler.out_w;
+        *height = scaler.out_h;
+    } else if (ret != ESP_ERR_INVALID_STATE) {
+        ESP_LOGD(TAG, "No thumbnail for %s: %s", full_path, esp_err_to_name(ret));
+    }
+    scaler_free(&scaler);
+    return ret;
+}
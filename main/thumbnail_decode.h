@@ -0,0 +1,49 @@
+#ifndef THUMBNAIL_DECODE_H
+#define THUMBNAIL_DECODE_H
+
+#include "esp_err.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+typedef enum {
+    THUMBNAIL_FORMAT_NONE,
+    THUMBNAIL_FORMAT_JPEG,
+    THUMBNAIL_FORMAT_PNG,
+    THUMBNAIL_FORMAT_BMP
+} thumbnail_format_t;
+
+/**
+ * @brief Polled while decoding; returning true abandons the decode
+ */
+typedef bool (*thumbnail_abort_cb_t)(void);
+
+/**
+ * @brief Pick the decoder for a file name by its extension
+ * @param name File name or path
+ * @return Image format, THUMBNAIL_FORMAT_NONE if it is not a supported image
+ */
+thumbnail_format_t thumbnail_decode_format(const char *name);
+
+/**
+ * @brief Decode an image file straight into a downscaled RGB565 thumbnail
+ *
+ * The image is reduced while it is decoded (DCT scaling for JPEG, row and
+ * column sampling for PNG and BMP), so memory use is bounded by one source
+ * row, never the full image.
+ *
+ * @param full_path Absolute path of the image (including the mount point)
+ * @param format Image format from thumbnail_decode_format()
+ * @param max_size Longest side of the thumbnail in pixels
+ * @param pixels Output, room for max_size * max_size pixels
+ * @param width Output thumbnail width
+ * @param height Output thumbnail height
+ * @param abort_cb Checked regularly while decoding (can be NULL)
+ * @return ESP_OK on success, ESP_ERR_NOT_SUPPORTED for image variants that are
+ *         not handled, ESP_ERR_INVALID_STATE if aborted, ESP_ERR_NO_MEM on
+ *         allocation failure, ESP_FAIL if the file is unreadable or corrupt
+ */
+esp_err_t thumbnail_decode(const char *full_path, thumbnail_format_t format, uint16_t max_size,
+                           uint16_t *pixels, uint16_t *width, uint16_t *height,
+                           thumbnail_abort_cb_t abort_cb);
+
+#endif // THUMBNAIL_DECODE_H
@@ -0,0 +1,187 @@
+#include "tree_walk.h"
+#include "sd_manager.h"
+#include "esp_log.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+
+static const char *TAG = "TREE_WALK";
+
+/*
+ * Pending directories are frames on a heap stack, their paths packed in an
+ * arena in the same order, so popping a frame also releases its path. A
+ * directory's frame stays on the stack while its subdirectories are walked
+ * and is popped again as LEAVE once they are all done.
+ */
+typedef struct {
+    uint32_t path;          // Arena offset
+    uint32_t path_len;
+    uint32_t depth;
+    bool entered;           // ENTER reported, LEAVE next time it is on top
+} walk_frame_t;
+
+typedef struct {
+    tree_walk_cb_t callback;
+    void *user_data;
+    size_t root_len;
+    walk_frame_t *frames;
+    uint32_t frame_count;
+    uint32_t frame_capacity;
+    char *arena;
+    uint32_t arena_used;
+    uint32_t arena_size;
+    const char *dir;        // Directory being listed
+    uint32_t depth;         // Its depth
+    char child[TREE_WALK_PATH_LEN];
+    tree_walk_stats_t stats;
+    esp_err_t result;
+    bool stopped;
+} walker_t;
+
+static bool grow_array(void **array, uint32_t *capacity, uint32_t needed, size_t elem_size) {
+    if (needed <= *capacity) {
+        return true;
+    }
+    uint32_t new_capacity = *capacity ? *capacity * 2 : 16;
+    while (new_capacity < needed) {
+        new_capacity *= 2;
+    }
+    void *grown = realloc(*array, (size_t)new_capacity * elem_size);
+    if (!grown) {
+        return false;
+    }
+    *array = grown;
+    *capacity = new_capacity;
+    return true;
+}
+
+static tree_walk_action_t report(walker_t *w, tree_walk_event_t event, const char *path,
+                                 uint64_t size, uint32_t depth) {
+    const char *relative = path + (depth ? w->root_len : strlen(path));
+    if (*relative == '/') {
+        relative++;
+    }
+    tree_walk_entry_t entry = {
+        .event = event,
+        .path = path,
+        .relative = relative,
+        .size = size,
+        .depth = depth
+    };
+    tree_walk_action_t action = w->callback(&entry, w->user_data);
+    if (action == TREE_WALK_STOP) {
+        w->stopped = true;
+    }
+    return action;
+}
+
+static bool push_dir(walker_t *w, const char *path, uint32_t len, uint32_t depth) {
+    if (!grow_array((void **)&w->frames, &w->frame_capacity, w->frame_count + 1, sizeof(walk_frame_t)) ||
+        !grow_array((void **)&w->arena, &w->arena_size, w->arena_used + len + 1, 1)) {
+        ESP_LOGE(TAG, "Out of memory with %" PRIu32 " directories pending", w->frame_count);
+        w->result = ESP_ERR_NO_MEM;
+        return false;
+    }
+    w->frames[w->frame_count++] = (walk_frame_t){
+        .path = w->arena_used,
+        .path_len = len,
+        .depth = depth,
+        .entered = false
+    };
+    memcpy(w->arena + w->arena_used, path, len + 1);
+    w->arena_used += len + 1;
+    return true;
+}
+
+static void pop_dir(walker_t *w) {
+    w->frame_count--;
+    w->arena_used = w->frames[w->frame_count].path;
+}
+
+// Files are reported as they are listed; subdirectories wait on the stack
+static bool list_entry_cb(const sd_dir_entry_t *entry, void *user_data) {
+    walker_t *w = (walker_t *)user_data;
+    int len = snprintf(w->child, sizeof(w->child), "%s/%s", strcmp(w->dir, "/") == 0 ? "" : w->dir, entry->name);
+    if (len < 0 || (size_t)len >= sizeof(w->child)) {
+        ESP_LOGW(TAG, "Path too long, skipping %s/%s", w->dir, entry->name);
+        w->stats.errors++;
+        return report(w, TREE_WALK_ERROR, w->dir, 0, w->depth) != TREE_WALK_STOP;
+    }
+
+    if (entry->is_directory) {
+        return push_dir(w, w->child, (uint32_t)len, w->depth + 1);
+    }
+    w->stats.files++;
+    w->stats.bytes += entry->size;
+    return report(w, TREE_WALK_FILE, w->child, entry->size, w->depth + 1) != TREE_WALK_STOP;
+}
+
+esp_err_t tree_walk(const char *root, tree_walk_cb_t callback, void *user_data, tree_walk_stats_t *stats) {
+    size_t root_len = strlen(root);
+    if (root_len >= TREE_WALK_PATH_LEN) {
+        ESP_LOGE(TAG, "Path too long: %s", root);
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    char dir[TREE_WALK_PATH_LEN];
+    walker_t w = {
+        .callback = callback,
+        .user_data = user_data,
+        .root_len = root_len,
+        .dir = dir,
+        .result = ESP_OK
+    };
+    push_dir(&w, root, (uint32_t)root_len, 0);
+
+    while (w.frame_count > 0 && w.result == ESP_OK && !w.stopped) {
+        // Copied out: pushing children may move the arena
+        walk_frame_t *frame = &w.frames[w.frame_count - 1];
+        memcpy(dir, w.arena + frame->path, frame->path_len + 1);
+        w.depth = frame->depth;
+
+        if (frame->entered) {
+            pop_dir(&w);
+            report(&w, TREE_WALK_LEAVE, dir, 0, w.depth);
+            continue;
+        }
+        if (report(&w, TREE_WALK_ENTER, dir, 0, w.depth) != TREE_WALK_CONTINUE) {
+            pop_dir(&w);
+            continue;
+        }
+        frame->entered = true;
+        w.stats.dirs++;
+
+        if (sd_manager_enumerate(dir, true, list_entry_cb, &w) < 0) {
+            // The listing never opened, so nothing was pushed above this frame
+            pop_dir(&w);
+            w.stats.errors++;
+            report(&w, TREE_WALK_ERROR, dir, 0, w.depth);
+        }
+    }
+
+    free(w.frames);
+    free(w.arena);
+    if (stats) {
+        *stats = w.stats;
+    }
+    if (w.result != ESP_OK) {
+        return w.result;
+    }
+    return w.stopped ? ESP_ERR_INVALID_STATE : ESP_OK;
+}
+
+typedef struct {
+    const volatile bool *cancel;
+} measure_ctx_t;
+
+static tree_walk_action_t measure_cb(const tree_walk_entry_t *entry, void *user_data) {
+    (void)entry;
+    measure_ctx_t *ctx = (measure_ctx_t *)user_data;
+    return (ctx->cancel && *ctx->cancel) ? TREE_WALK_STOP : TREE_WALK_CONTINUE;
+}
+
+esp_err_t tree_walk_measure(const char *root, const volatile bool *cancel, tree_walk_stats_t *stats) {
+    measure_ctx_t ctx = { .cancel = cancel };
+    return tree_walk(root, measure_cb, &ctx, stats);
+}
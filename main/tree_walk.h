@@ -0,0 +1,81 @@
+#ifndef TREE_WALK_H
+#define TREE_WALK_H
+
+#include "esp_err.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+// Longest path (relative to SD root) the walker visits
+#define TREE_WALK_PATH_LEN 256
+
+typedef enum {
+    TREE_WALK_ENTER,    // Directory reached, before anything inside it
+    TREE_WALK_FILE,     // File inside the tree
+    TREE_WALK_LEAVE,    // Directory finished, after everything inside it
+    TREE_WALK_ERROR     // Directory could not be read, or a child path was too long
+} tree_walk_event_t;
+
+typedef enum {
+    TREE_WALK_CONTINUE,
+    TREE_WALK_SKIP,     // On ENTER: do not look inside, and no LEAVE follows
+    TREE_WALK_STOP      // End the walk now
+} tree_walk_action_t;
+
+typedef struct {
+    tree_walk_event_t event;
+    const char *path;       // Relative to SD root; for ERROR the directory at fault
+    const char *relative;   // Part of path below the walk root ("" for the root)
+    uint64_t size;          // File size (FILE only)
+    uint32_t depth;         // 0 for the root
+} tree_walk_entry_t;
+
+typedef struct {
+    uint32_t files;
+    uint32_t dirs;          // Including the root
+    uint64_t bytes;         // Sum of file sizes
+    uint32_t errors;        // ERROR events
+} tree_walk_stats_t;
+
+/**
+ * @brief Visit an entry of the tree
+ *
+ * Paths are only valid during the call. Files may be removed or created
+ * from here, including in the directory being listed.
+ *
+ * @param entry Entry being visited
+ * @param user_data User data passed to tree_walk()
+ * @return What the walk does next
+ */
+typedef tree_walk_action_t (*tree_walk_cb_t)(const tree_walk_entry_t *entry, void *user_data);
+
+/**
+ * @brief Walk a directory tree depth first
+ *
+ * Directories are reported before (ENTER) and after (LEAVE) their contents,
+ * so the same walk can create a copy top-down and delete bottom-up. File
+ * metadata comes from the directory listing itself; nothing is stat()ed.
+ * Pending directories wait on a heap stack rather than the call stack, so
+ * depth only costs memory for their paths, and one directory is open at a
+ * time. A directory that cannot be read is reported and skipped; the walk
+ * carries on with the rest.
+ *
+ * @param root Directory to walk (relative to SD root)
+ * @param callback Visitor
+ * @param user_data Passed through to the callback
+ * @param stats Output counts of what was visited (can be NULL)
+ * @return ESP_OK when the walk reached the end (ERROR events included),
+ *         ESP_ERR_INVALID_STATE if the callback stopped it,
+ *         ESP_ERR_NO_MEM if the pending stack could not grow
+ */
+esp_err_t tree_walk(const char *root, tree_walk_cb_t callback, void *user_data, tree_walk_stats_t *stats);
+
+/**
+ * @brief Count the files, directories and bytes in a tree
+ * @param root Directory to measure (relative to SD root)
+ * @param cancel Abandons the count when set (can be NULL)
+ * @param stats Output totals
+ * @return Same as tree_walk()
+ */
+esp_err_t tree_walk_measure(const char *root, const volatile bool *cancel, tree_walk_stats_t *stats);
+
+#endif // TREE_WALK_H